@@ -0,0 +1,77 @@
+## @file
+#  Compare the LzmaCompress throughput with one and two encoder threads on
+#  FV images, and check that the thread count does not change the output.
+#
+#  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+VersionNumber = '0.1'
+import os
+import sys
+import time
+import shutil
+import argparse
+import tempfile
+import subprocess
+
+def RunLzmaCompress(Tool, Args):
+    Result = subprocess.run([Tool] + Args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    if Result.returncode != 0:
+        print('ERROR: {} {} failed:\n{}'.format(Tool, ' '.join(Args), Result.stdout.decode(errors='replace')))
+        sys.exit(1)
+
+def Main():
+    PARSER = argparse.ArgumentParser(
+        description='Compares the LzmaCompress throughput with one and two encoder threads on FV images - Version ' + VersionNumber)
+    PARSER.add_argument('Images', nargs='+',
+                        help='FV images to compress, for example Build/<Platform>/<Target>_<Toolchain>/FV/DXEFV.Fv')
+    PARSER.add_argument('--tool', default='LzmaCompress',
+                        help='LzmaCompress executable to run. [Default: LzmaCompress from PATH]')
+    PARSER.add_argument('--repeat', type=int, default=3,
+                        help='Number of times each image is compressed, the best time is reported. [Default: 3]')
+    ARGS = PARSER.parse_args()
+
+    Tool = shutil.which(ARGS.tool) or ARGS.tool
+    TempDir = tempfile.mkdtemp()
+    try:
+        print('{:<40} {:>10} {:>12} {:>12} {:>8}'.format('Image', 'Size (KB)', '1 thr (MB/s)', '2 thr (MB/s)', 'Speedup'))
+        for Image in ARGS.Images:
+            Size = os.path.getsize(Image)
+            Throughput = {}
+            Outputs = {}
+            for Threads in (1, 2):
+                Output = os.path.join(TempDir, 'output{}'.format(Threads))
+                Best = None
+                for Index in range(ARGS.repeat):
+                    Start = time.perf_counter()
+                    RunLzmaCompress(Tool, ['-e', '-q', '--threads', str(Threads), '-o', Output, Image])
+                    Elapsed = time.perf_counter() - Start
+                    if Best is None or Elapsed < Best:
+                        Best = Elapsed
+                Throughput[Threads] = Size / Best / (1024 * 1024)
+                with open(Output, 'rb') as File:
+                    Outputs[Threads] = File.read()
+
+            if Outputs[1] != Outputs[2]:
+                print('ERROR: {} compresses differently with one and two threads'.format(Image))
+                sys.exit(1)
+
+            #
+            # Check that the output decodes back to the image.
+            #
+            Decoded = os.path.join(TempDir, 'decoded')
+            RunLzmaCompress(Tool, ['-d', '-q', '-o', Decoded, os.path.join(TempDir, 'output2')])
+            with open(Decoded, 'rb') as File, open(Image, 'rb') as Original:
+                if File.read() != Original.read():
+                    print('ERROR: {} does not decompress to the original image'.format(Image))
+                    sys.exit(1)
+
+            print('{:<40} {:>10} {:>12.2f} {:>12.2f} {:>7.2f}x'.format(
+                os.path.basename(Image), Size // 1024, Throughput[1], Throughput[2], Throughput[2] / Throughput[1]))
+    finally:
+        shutil.rmtree(TempDir)
+
+if __name__ == '__main__':
+    Main()
@@ -21,6 +21,7 @@
 #include "./brotli/c/common/version.h"
 #include <brotli/decode.h>
 #include <brotli/encode.h>
+#include "BatchJobs.h"
 
 #if !defined(_WIN32)
 #include <unistd.h>
@@ -68,9 +69,15 @@ static int ms_open(const char* FileName, int Oflag, int Pmode) {
 #define DEFAULT_LGWIN 22
 #define DECODE_HEADER_SIZE 0x10
 #define GAP_MEM_BLOCK 0x1000
-size_t ScratchBufferSize = 0;
 static const size_t kFileBufferSize  = 1 << 19;
 
+/* Options shared by the files of a batch. */
+typedef struct {
+  BROTLI_BOOL Compress;
+  int Quality;
+  int Gap;
+} BatchOptions;
+
 static void Version(void) {
   int Major;
   int Minor;
@@ -93,6 +100,12 @@ static void Usage() {
  printf(
 "  -g NUM, --gap=NUM           scratch memory gap level (1-16)\n");
   printf(
+"  -b FILE, --batch=FILE       process the \"input output\" file pairs listed\n"
+"                              in FILE, one per line, and report the ratio\n"
+"                              and time of each file\n"
+"  -j NUM, --threads=NUM       files processed at the same time in batch mode\n"
+"                              (default: one per processor)\n");
+  printf(
 "  -q NUM, --quality=NUM       compression level (%d-%d)\n",
           BROTLI_MIN_QUALITY, BROTLI_MAX_QUALITY);
   printf(
@@ -290,7 +303,7 @@ void BrotliFreeFunc(void* Opaque, void* Address) {
   free(Address);
 }
 
-int DecompressFile(char *InputFile, uint8_t *InputBuffer, char *OutputFile, uint8_t *OutputBuffer, int Quality, int Gap) {
+int DecompressFile(char *InputFile, uint8_t *InputBuffer, char *OutputFile, uint8_t *OutputBuffer, int Quality, int Gap, size_t *ScratchSize) {
   FILE *InputFileHandle;
   FILE *OutputFileHandle;
   BrotliDecoderState *DecoderState;
@@ -314,7 +327,7 @@ int DecompressFile(char *InputFile, uint8_t *InputBuffer, char *OutputFile, uint
   }
   fseek(InputFileHandle, DECODE_HEADER_SIZE, SEEK_SET);
 
-  DecoderState = BrotliDecoderCreateInstance(BrotliAllocFunc, BrotliFreeFunc, &ScratchBufferSize);
+  DecoderState = BrotliDecoderCreateInstance(BrotliAllocFunc, BrotliFreeFunc, ScratchSize);
   if (!DecoderState) {
     printf("Out of memory\n");
     IsOk = BROTLI_FALSE;
@@ -395,25 +408,139 @@ Finish:
   return IsOk;
 }
 
+/* Compresses a file and fills in the decoder header: the original size and
+   the scratch memory size measured by decompressing the result again. */
+static int CompressFileWithHeader(char *InputFile, char *OutputFile, uint8_t *Buffer, int Quality, int Gap) {
+  char OutputTmpFile[_MAX_PATH];
+  FILE *OutputHandle;
+  uint8_t *InputBuffer;
+  uint8_t *OutputBuffer;
+  size_t ScratchBufferSize;
+  int64_t Size;
+  int Ret;
+
+  InputBuffer = Buffer;
+  OutputBuffer = Buffer + kFileBufferSize;
+  ScratchBufferSize = 0;
+  //
+  // Compress file
+  //
+  Ret = CompressFile(InputFile, InputBuffer, OutputFile, OutputBuffer, Quality, Gap);
+  if (!Ret) {
+    printf ("Failed to compress file [%s]\n", InputFile);
+    return BROTLI_FALSE;
+  }
+  //
+  // Decompress file for get Outputfile size
+  //
+  if (strlen(OutputFile) + strlen(".tmp") >= _MAX_PATH) {
+    printf ("Output file path is too long[%s]\n", OutputFile);
+    return BROTLI_FALSE;
+  }
+  strcpy (OutputTmpFile, OutputFile);
+  strcat (OutputTmpFile, ".tmp");
+  memset(Buffer, 0, kFileBufferSize*2);
+  Ret = DecompressFile(OutputFile, InputBuffer, OutputTmpFile, OutputBuffer, Quality, Gap, &ScratchBufferSize);
+  if (!Ret) {
+    printf ("Failed to decompress file [%s]\n", OutputFile);
+    return BROTLI_FALSE;
+  }
+  remove (OutputTmpFile);
+
+  //
+  // fill decoder header
+  //
+  Size = FileSize(InputFile);
+  OutputHandle = fopen(OutputFile, "rb+"); /* open output_path file and add in head info */
+  if (OutputHandle == NULL) {
+    printf("Failed to open output file [%s]\n", OutputFile);
+    return BROTLI_FALSE;
+  }
+  fwrite(&Size, 1, sizeof(int64_t), OutputHandle);
+  ScratchBufferSize += Gap * GAP_MEM_BLOCK; /* there is a memory gap between IA32 and X64 environment*/
+  ScratchBufferSize += kFileBufferSize * 2;
+  Size = (int64_t) ScratchBufferSize;
+  fwrite(&Size, 1, sizeof(int64_t), OutputHandle);
+  if (fclose(OutputHandle) != 0) {
+    printf("Failed to close output file [%s]\n", OutputFile);
+    return BROTLI_FALSE;
+  }
+  return BROTLI_TRUE;
+}
+
+/* Processes one file of a batch on a worker thread. */
+static int ProcessBatchJob(BATCH_JOB *Job, void *Context) {
+  BatchOptions *Options;
+  uint8_t *Buffer;
+  size_t ScratchBufferSize;
+  int Ret;
+
+  Options = (BatchOptions *)Context;
+  Buffer = (uint8_t*)malloc(kFileBufferSize * 2);
+  if (!Buffer) {
+    printf("Out of memory\n");
+    return 1;
+  }
+  memset(Buffer, 0, kFileBufferSize*2);
+  if (Options->Compress) {
+    Ret = CompressFileWithHeader(Job->InputFile, Job->OutputFile, Buffer, Options->Quality, Options->Gap);
+  } else {
+    ScratchBufferSize = 0;
+    Ret = DecompressFile(Job->InputFile, Buffer, Job->OutputFile, Buffer + kFileBufferSize, Options->Quality, Options->Gap, &ScratchBufferSize);
+    if (!Ret) {
+      printf ("Failed to decompress file [%s]\n", Job->InputFile);
+    }
+  }
+  free(Buffer);
+  return !Ret;
+}
+
+/* Processes all files of a batch list and prints the result of each. */
+static int RunBatch(char *BatchFile, unsigned Threads, BatchOptions *Options) {
+  BATCH_JOB *Jobs;
+  size_t JobCount;
+  size_t Failed;
+  uint64_t Start;
+  int Ret;
+
+  Ret = ReadBatchJobs(BatchFile, &Jobs, &JobCount);
+  if (Ret < 0) {
+    printf("Failed to read batch file [%s]\n", BatchFile);
+    return 1;
+  }
+  if (Ret > 0) {
+    printf("Invalid line %d in batch file [%s]\n", Ret, BatchFile);
+    return 1;
+  }
+  Start = GetBatchTimeStamp();
+  Failed = RunBatchJobs(Jobs, JobCount, Threads, ProcessBatchJob, Options);
+  PrintBatchJobReport(Jobs, JobCount, GetBatchTimeStamp() - Start);
+  FreeBatchJobs(Jobs, JobCount);
+  return Failed == 0 ? 0 : 1;
+}
+
 int main(int argc, char** argv) {
   BROTLI_BOOL CompressBool;
   BROTLI_BOOL DecompressBool;
   char *OutputFile;
   char *InputFile;
-  char OutputTmpFile[_MAX_PATH];
-  FILE *OutputHandle;
+  char *BatchFile;
+  BatchOptions Options;
+  int Threads;
   int Quality;
   int Gap;
   int OutputFileLength;
   int InputFileLength;
   int Ret;
-  size_t InputFileSize;
+  size_t ScratchBufferSize;
   uint8_t *Buffer;
   uint8_t *InputBuffer;
   uint8_t *OutputBuffer;
-  int64_t Size;
 
   InputFile = NULL;
+  BatchFile = NULL;
+  Threads = 0;
+  Buffer = NULL;
   OutputFile = NULL;
   CompressBool = BROTLI_FALSE;
   DecompressBool = BROTLI_FALSE;
@@ -422,7 +549,7 @@ int main(int argc, char** argv) {
   //
   Quality = 9;
   Gap = 1;
-  InputFileSize = 0;
+  ScratchBufferSize = 0;
   Ret = 0;
 
   if (argc < 2) {
@@ -504,6 +631,42 @@ int main(int argc, char** argv) {
       argv++;
       continue;
     }
+    if (strcmp(argv[1], "-b") == 0 || strncmp(argv[1], "--batch", 7) == 0) {
+      if (strcmp(argv[1], "-b") == 0) {
+        BatchFile = argv[2];
+        if (BatchFile == NULL) {
+          printf("Batch file can't be null\n");
+          return 1;
+        }
+        argc--;
+        argv++;
+      } else {
+        BatchFile = (char *)argv[1] + 8;
+      }
+      argc--;
+      argv++;
+      continue;
+    }
+    if (strcmp(argv[1], "-j") == 0 || strncmp(argv[1], "--threads", 9) == 0) {
+      if (strcmp(argv[1], "-j") == 0) {
+        if (argv[2] == NULL) {
+          printf("Thread count can't be null\n");
+          return 1;
+        }
+        Threads = strtol(argv[2], NULL, 10);
+        argc--;
+        argv++;
+      } else {
+        Threads = strtol((char *)argv[1] + 10, NULL, 10);
+      }
+      if (Threads <= 0) {
+        printf("Invalid thread count\n");
+        return 1;
+      }
+      argc--;
+      argv++;
+      continue;
+    }
     if (argc > 1) {
       InputFileLength = strlen(argv[1]);
       if (InputFileLength > _MAX_PATH - 1) {
@@ -520,6 +683,17 @@ int main(int argc, char** argv) {
     }
   }
 
+  if (BatchFile != NULL) {
+    if (InputFile != NULL || OutputFile != NULL) {
+      printf("Can't use -b/--batch with an input or output file\n");
+      return 1;
+    }
+    Options.Compress = CompressBool;
+    Options.Quality = Quality;
+    Options.Gap = Gap;
+    return RunBatch(BatchFile, (unsigned)Threads, &Options);
+  }
+
   Buffer = (uint8_t*)malloc(kFileBufferSize * 2);
   if (!Buffer) {
     printf("Out of memory\n");
@@ -529,51 +703,9 @@ int main(int argc, char** argv) {
   InputBuffer = Buffer;
   OutputBuffer = Buffer + kFileBufferSize;
   if (CompressBool) {
-    //
-    // Compress file
-    //
-    Ret = CompressFile(InputFile, InputBuffer, OutputFile, OutputBuffer, Quality, Gap);
-    if (!Ret) {
-      printf ("Failed to compress file [%s]\n", InputFile);
-      goto Finish;
-    }
-    //
-    // Decompress file for get Outputfile size
-    //
-    strcpy (OutputTmpFile, OutputFile);
-    if (strlen(InputFile) + strlen(".tmp") < _MAX_PATH) {
-      strcat(OutputTmpFile, ".tmp");
-    } else {
-      printf ("Output file path is too long[%s]\n", OutputFile);
-      Ret = BROTLI_FALSE;
-      goto Finish;
-    }
-    memset(Buffer, 0, kFileBufferSize*2);
-    Ret = DecompressFile(OutputFile, InputBuffer, OutputTmpFile, OutputBuffer, Quality, Gap);
-    if (!Ret) {
-      printf ("Failed to decompress file [%s]\n", OutputFile);
-      goto Finish;
-    }
-    remove (OutputTmpFile);
-
-    //
-    // fill decoder header
-    //
-    InputFileSize = FileSize(InputFile);
-    Size = (int64_t)InputFileSize;
-    OutputHandle = fopen(OutputFile, "rb+"); /* open output_path file and add in head info */
-    fwrite(&Size, 1, sizeof(int64_t), OutputHandle);
-    ScratchBufferSize += Gap * GAP_MEM_BLOCK; /* there is a memory gap between IA32 and X64 environment*/
-    ScratchBufferSize += kFileBufferSize * 2;
-    Size = (int64_t) ScratchBufferSize;
-    fwrite(&Size, 1, sizeof(int64_t), OutputHandle);
-    if (fclose(OutputHandle) != 0) {
-      printf("Failed to close output file [%s]\n", OutputFile);
-      Ret = BROTLI_FALSE;
-      goto Finish;
-    }
+    Ret = CompressFileWithHeader(InputFile, OutputFile, Buffer, Quality, Gap);
   } else {
-    Ret = DecompressFile(InputFile, InputBuffer, OutputFile, OutputBuffer, Quality, Gap);
+    Ret = DecompressFile(InputFile, InputBuffer, OutputFile, OutputBuffer, Quality, Gap, &ScratchBufferSize);
     if (!Ret) {
       printf ("Failed to decompress file [%s]\n", InputFile);
       goto Finish;
@@ -0,0 +1,473 @@
+/** @file
+Batch mode support for the compression tools: reads a list of input and
+output file pairs and processes them on a pool of worker threads.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+#include "BatchJobs.h"
+
+#define BATCH_LINE_SIZE    8192
+#define BATCH_MAX_THREADS  64
+
+///
+/// The state shared by the worker threads of RunBatchJobs ()
+///
+typedef struct {
+  BATCH_JOB           *Jobs;
+  size_t              JobCount;
+  size_t              NextJob;
+  BATCH_JOB_FUNCTION  Function;
+  void                *Context;
+#ifdef _WIN32
+  CRITICAL_SECTION    Lock;
+#else
+  pthread_mutex_t     Lock;
+#endif
+} BATCH_QUEUE;
+
+/**
+  Copies the next file name of a batch list line.
+
+  @param Line   Points to the position to parse from, updated to the
+                position after the file name
+
+  @return The allocated file name, or NULL if there is none or it is malformed
+**/
+static
+char *
+ParseBatchFileName (
+  char  **Line
+  )
+{
+  char    *Start;
+  char    *End;
+  char    *Name;
+  size_t  Length;
+
+  Start = *Line;
+  while (isspace ((unsigned char)*Start)) {
+    Start++;
+  }
+  if (*Start == '\0') {
+    return NULL;
+  }
+
+  if (*Start == '"') {
+    Start++;
+    End = strchr (Start, '"');
+    if (End == NULL) {
+      return NULL;
+    }
+    *Line = End + 1;
+  } else {
+    End = Start;
+    while (*End != '\0' && !isspace ((unsigned char)*End)) {
+      End++;
+    }
+    *Line = End;
+  }
+
+  Length = (size_t)(End - Start);
+  if (Length == 0) {
+    return NULL;
+  }
+  Name = (char *)malloc (Length + 1);
+  if (Name != NULL) {
+    memcpy (Name, Start, Length);
+    Name[Length] = '\0';
+  }
+  return Name;
+}
+
+int
+ReadBatchJobs (
+  const char  *ListFileName,
+  BATCH_JOB   **Jobs,
+  size_t      *JobCount
+  )
+{
+  FILE       *ListFile;
+  char       *Line;
+  char       *Cursor;
+  BATCH_JOB  *List;
+  BATCH_JOB  *NewList;
+  size_t     Count;
+  size_t     Capacity;
+  int        LineNumber;
+  int        Result;
+
+  *Jobs     = NULL;
+  *JobCount = 0;
+
+  ListFile = fopen (ListFileName, "r");
+  if (ListFile == NULL) {
+    return -1;
+  }
+  Line = (char *)malloc (BATCH_LINE_SIZE);
+  if (Line == NULL) {
+    fclose (ListFile);
+    return -1;
+  }
+
+  List       = NULL;
+  Count      = 0;
+  Capacity   = 0;
+  LineNumber = 0;
+  Result     = 0;
+  while (fgets (Line, BATCH_LINE_SIZE, ListFile) != NULL) {
+    LineNumber++;
+    if ((strchr (Line, '\n') == NULL) && !feof (ListFile)) {
+      Result = LineNumber;
+      break;
+    }
+
+    Cursor = Line;
+    while (isspace ((unsigned char)*Cursor)) {
+      Cursor++;
+    }
+    if ((*Cursor == '\0') || (*Cursor == '#')) {
+      continue;
+    }
+
+    if (Count == Capacity) {
+      Capacity = (Capacity == 0) ? 64 : Capacity * 2;
+      NewList  = (BATCH_JOB *)realloc (List, Capacity * sizeof (BATCH_JOB));
+      if (NewList == NULL) {
+        Result = -1;
+        break;
+      }
+      List = NewList;
+    }
+
+    memset (&List[Count], 0, sizeof (BATCH_JOB));
+    List[Count].InputFile  = ParseBatchFileName (&Cursor);
+    List[Count].OutputFile = ParseBatchFileName (&Cursor);
+    Count++;
+    while (isspace ((unsigned char)*Cursor)) {
+      Cursor++;
+    }
+    if ((List[Count - 1].InputFile == NULL) || (List[Count - 1].OutputFile == NULL) || (*Cursor != '\0')) {
+      Result = LineNumber;
+      break;
+    }
+  }
+
+  if (ferror (ListFile)) {
+    Result = -1;
+  }
+  free (Line);
+  fclose (ListFile);
+
+  if (Result != 0) {
+    FreeBatchJobs (List, Count);
+    return Result;
+  }
+  *Jobs     = List;
+  *JobCount = Count;
+  return 0;
+}
+
+void
+FreeBatchJobs (
+  BATCH_JOB  *Jobs,
+  size_t     JobCount
+  )
+{
+  size_t  Index;
+
+  if (Jobs == NULL) {
+    return;
+  }
+  for (Index = 0; Index < JobCount; Index++) {
+    free (Jobs[Index].InputFile);
+    free (Jobs[Index].OutputFile);
+  }
+  free (Jobs);
+}
+
+uint64_t
+GetBatchTimeStamp (
+  void
+  )
+{
+#ifdef _WIN32
+  return (uint64_t)GetTickCount64 ();
+#else
+  struct timespec  Now;
+
+  clock_gettime (CLOCK_MONOTONIC, &Now);
+  return (uint64_t)Now.tv_sec * 1000 + (uint64_t)Now.tv_nsec / 1000000;
+#endif
+}
+
+/**
+  Returns the number of processors available to the tool.
+**/
+static
+unsigned
+GetProcessorCount (
+  void
+  )
+{
+#ifdef _WIN32
+  SYSTEM_INFO  SystemInfo;
+
+  GetSystemInfo (&SystemInfo);
+  return (unsigned)SystemInfo.dwNumberOfProcessors;
+#else
+  long  Count;
+
+  Count = sysconf (_SC_NPROCESSORS_ONLN);
+  return (Count > 0) ? (unsigned)Count : 1;
+#endif
+}
+
+/**
+  Returns the size of a file, or 0 if it cannot be determined.
+**/
+static
+uint64_t
+GetBatchFileSize (
+  const char  *FileName
+  )
+{
+  struct stat  Stat;
+
+  if (stat (FileName, &Stat) != 0) {
+    return 0;
+  }
+  return (uint64_t)Stat.st_size;
+}
+
+/**
+  Takes the next job from the queue.
+
+  @return The job, or NULL once all jobs have been handed out
+**/
+static
+BATCH_JOB *
+TakeBatchJob (
+  BATCH_QUEUE  *Queue
+  )
+{
+  BATCH_JOB  *Job;
+
+  Job = NULL;
+#ifdef _WIN32
+  EnterCriticalSection (&Queue->Lock);
+#else
+  pthread_mutex_lock (&Queue->Lock);
+#endif
+  if (Queue->NextJob < Queue->JobCount) {
+    Job = &Queue->Jobs[Queue->NextJob++];
+  }
+#ifdef _WIN32
+  LeaveCriticalSection (&Queue->Lock);
+#else
+  pthread_mutex_unlock (&Queue->Lock);
+#endif
+  return Job;
+}
+
+/**
+  Processes jobs until the queue is empty.
+**/
+static
+void
+ProcessBatchJobs (
+  BATCH_QUEUE  *Queue
+  )
+{
+  BATCH_JOB  *Job;
+  uint64_t   Start;
+
+  while ((Job = TakeBatchJob (Queue)) != NULL) {
+    Start             = GetBatchTimeStamp ();
+    Job->Status       = Queue->Function (Job, Queue->Context);
+    Job->Milliseconds = GetBatchTimeStamp () - Start;
+    Job->InputSize    = GetBatchFileSize (Job->InputFile);
+    if (Job->Status == 0) {
+      Job->OutputSize = GetBatchFileSize (Job->OutputFile);
+    }
+  }
+}
+
+#ifdef _WIN32
+static
+unsigned
+__stdcall
+BatchWorkerThread (
+  void  *Queue
+  )
+{
+  ProcessBatchJobs ((BATCH_QUEUE *)Queue);
+  return 0;
+}
+
+#else
+static
+void *
+BatchWorkerThread (
+  void  *Queue
+  )
+{
+  ProcessBatchJobs ((BATCH_QUEUE *)Queue);
+  return NULL;
+}
+
+#endif
+
+size_t
+RunBatchJobs (
+  BATCH_JOB           *Jobs,
+  size_t              JobCount,
+  unsigned            ThreadCount,
+  BATCH_JOB_FUNCTION  Function,
+  void                *Context
+  )
+{
+  BATCH_QUEUE  Queue;
+  unsigned     Started;
+  unsigned     Index;
+  size_t       JobIndex;
+  size_t       Failed;
+#ifdef _WIN32
+  HANDLE       Threads[BATCH_MAX_THREADS];
+#else
+  pthread_t    Threads[BATCH_MAX_THREADS];
+#endif
+
+  if (ThreadCount == 0) {
+    ThreadCount = GetProcessorCount ();
+  }
+  if (ThreadCount > BATCH_MAX_THREADS) {
+    ThreadCount = BATCH_MAX_THREADS;
+  }
+  if (ThreadCount > JobCount) {
+    ThreadCount = (unsigned)JobCount;
+  }
+
+  Queue.Jobs     = Jobs;
+  Queue.JobCount = JobCount;
+  Queue.NextJob  = 0;
+  Queue.Function = Function;
+  Queue.Context  = Context;
+#ifdef _WIN32
+  InitializeCriticalSection (&Queue.Lock);
+#else
+  pthread_mutex_init (&Queue.Lock, NULL);
+#endif
+
+  //
+  // The calling thread is one of the workers. If a thread cannot be created
+  // the remaining ones simply take more jobs each.
+  //
+  Started = 0;
+  for (Index = 1; Index < ThreadCount; Index++) {
+#ifdef _WIN32
+    Threads[Started] = (HANDLE)_beginthreadex (NULL, 0, BatchWorkerThread, &Queue, 0, NULL);
+    if (Threads[Started] == NULL) {
+      break;
+    }
+
+#else
+    if (pthread_create (&Threads[Started], NULL, BatchWorkerThread, &Queue) != 0) {
+      break;
+    }
+
+#endif
+    Started++;
+  }
+
+  ProcessBatchJobs (&Queue);
+
+  for (Index = 0; Index < Started; Index++) {
+#ifdef _WIN32
+    WaitForSingleObject (Threads[Index], INFINITE);
+    CloseHandle (Threads[Index]);
+#else
+    pthread_join (Threads[Index], NULL);
+#endif
+  }
+
+#ifdef _WIN32
+  DeleteCriticalSection (&Queue.Lock);
+#else
+  pthread_mutex_destroy (&Queue.Lock);
+#endif
+
+  Failed = 0;
+  for (JobIndex = 0; JobIndex < JobCount; JobIndex++) {
+    if (Jobs[JobIndex].Status != 0) {
+      Failed++;
+    }
+  }
+  return Failed;
+}
+
+void
+PrintBatchJobReport (
+  const BATCH_JOB  *Jobs,
+  size_t           JobCount,
+  uint64_t         ElapsedMilliseconds
+  )
+{
+  size_t    Index;
+  size_t    Failed;
+  uint64_t  InputTotal;
+  uint64_t  OutputTotal;
+  uint64_t  JobTotal;
+
+  Failed      = 0;
+  InputTotal  = 0;
+  OutputTotal = 0;
+  JobTotal    = 0;
+  for (Index = 0; Index < JobCount; Index++) {
+    JobTotal += Jobs[Index].Milliseconds;
+    if (Jobs[Index].Status != 0) {
+      Failed++;
+      printf ("  %s: failed (%d)\n", Jobs[Index].InputFile, Jobs[Index].Status);
+      continue;
+    }
+
+    InputTotal  += Jobs[Index].InputSize;
+    OutputTotal += Jobs[Index].OutputSize;
+    printf (
+      "  %s -> %s: %llu -> %llu bytes (%.1f%%), %llu ms\n",
+      Jobs[Index].InputFile,
+      Jobs[Index].OutputFile,
+      (unsigned long long)Jobs[Index].InputSize,
+      (unsigned long long)Jobs[Index].OutputSize,
+      Jobs[Index].InputSize == 0 ? 100.0 : 100.0 * (double)Jobs[Index].OutputSize / (double)Jobs[Index].InputSize,
+      (unsigned long long)Jobs[Index].Milliseconds
+      );
+  }
+
+  printf (
+    "%llu files, %llu failed: %llu -> %llu bytes (%.1f%%), %llu ms elapsed, %llu ms in jobs\n",
+    (unsigned long long)JobCount,
+    (unsigned long long)Failed,
+    (unsigned long long)InputTotal,
+    (unsigned long long)OutputTotal,
+    InputTotal == 0 ? 100.0 : 100.0 * (double)OutputTotal / (double)InputTotal,
+    (unsigned long long)ElapsedMilliseconds,
+    (unsigned long long)JobTotal
+    );
+}
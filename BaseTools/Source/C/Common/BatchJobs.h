@@ -0,0 +1,124 @@
+/** @file
+Batch mode support for the compression tools: reads a list of input and
+output file pairs and processes them on a pool of worker threads.
+
+The interface only uses standard C types so that tools which do not include
+the EDK II base type headers, like BrotliCompress, can use it as well.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _BATCH_JOBS_H
+#define _BATCH_JOBS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+///
+/// One line of a batch list. Status, the sizes and the time are filled in by
+/// RunBatchJobs ().
+///
+typedef struct {
+  char      *InputFile;
+  char      *OutputFile;
+  int       Status;
+  uint64_t  InputSize;
+  uint64_t  OutputSize;
+  uint64_t  Milliseconds;
+} BATCH_JOB;
+
+/**
+  Processes one file of a batch. It is called from the worker threads, so it
+  must only use thread safe code and must not print through EfiUtilityMsgs.
+
+  @param Job       The job to process
+  @param Context   The context passed to RunBatchJobs ()
+
+  @return 0 on success, a tool specific non zero error code otherwise
+**/
+typedef
+int
+(*BATCH_JOB_FUNCTION) (
+  BATCH_JOB  *Job,
+  void       *Context
+  );
+
+/**
+  Reads a batch list file. Each non empty line that does not start with '#'
+  holds an input file name and an output file name separated by white space.
+  File names containing spaces may be enclosed in double quotes.
+
+  @param ListFileName   The batch list file
+  @param Jobs           Returns the array of jobs, free it with FreeBatchJobs ()
+  @param JobCount       Returns the number of jobs
+
+  @return 0 on success, -1 if the file cannot be read, or the number of the
+          first malformed line
+**/
+int
+ReadBatchJobs (
+  const char  *ListFileName,
+  BATCH_JOB   **Jobs,
+  size_t      *JobCount
+  );
+
+/**
+  Frees the jobs returned by ReadBatchJobs ().
+
+  @param Jobs       The array of jobs
+  @param JobCount   The number of jobs
+**/
+void
+FreeBatchJobs (
+  BATCH_JOB  *Jobs,
+  size_t     JobCount
+  );
+
+/**
+  Runs a function for every job on up to ThreadCount threads. Jobs are handed
+  out in list order; the sizes of the input and output files and the time
+  spent are recorded in each job.
+
+  @param Jobs          The array of jobs
+  @param JobCount      The number of jobs
+  @param ThreadCount   The number of worker threads, 0 to use one per processor
+  @param Function      The function that processes a job
+  @param Context       Passed to Function
+
+  @return The number of jobs that failed
+**/
+size_t
+RunBatchJobs (
+  BATCH_JOB           *Jobs,
+  size_t              JobCount,
+  unsigned            ThreadCount,
+  BATCH_JOB_FUNCTION  Function,
+  void                *Context
+  );
+
+/**
+  Prints one line per job with the input and output sizes, the ratio and the
+  time spent, followed by a summary line.
+
+  @param Jobs                 The array of jobs
+  @param JobCount             The number of jobs
+  @param ElapsedMilliseconds  The wall clock time of the whole batch
+**/
+void
+PrintBatchJobReport (
+  const BATCH_JOB  *Jobs,
+  size_t           JobCount,
+  uint64_t         ElapsedMilliseconds
+  );
+
+/**
+  Returns a monotonic time stamp in milliseconds.
+**/
+uint64_t
+GetBatchTimeStamp (
+  void
+  );
+
+#endif
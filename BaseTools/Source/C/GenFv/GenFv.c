@@ -129,6 +129,14 @@ Returns:
                         Its format is xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx\n");
   fprintf (stdout, "  --FvNameGuid Guid     Guid is used to specify Fv Name.\n\
                         Its format is xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx\n");
+  fprintf (stdout, "  --dispatch-order-hint\n\
+                        Add a file that records the order in which the PEIMs\n\
+                        and DXE drivers are expected to be dispatched, computed\n\
+                        from their dependency expressions.\n");
+  fprintf (stdout, "  --ffs-cache Directory\n\
+                        Keep the rebased FFS files in Directory, keyed by their\n\
+                        contents and addresses, and reuse them when the FV is\n\
+                        generated again.\n");
   fprintf (stdout, "  --capflag CapFlag     Capsule Reset Flag can be PersistAcrossReset,\n\
                         or PopulateSystemTable or InitiateReset or not set\n");
   fprintf (stdout, "  --capoemflag CapOEMFlag\n\
@@ -499,6 +507,29 @@ Returns:
       continue;
     }
 
+    if (stricmp (argv[0], "--dispatch-order-hint") == 0) {
+      mFvDataInfo.DispatchOrderHint = TRUE;
+      argc --;
+      argv ++;
+      continue;
+    }
+
+    if (stricmp (argv[0], "--ffs-cache") == 0) {
+      if (argv[1] == NULL) {
+        Error (NULL, 0, 1003, "Invalid option value", "FFS cache directory can't be null");
+        return STATUS_ERROR;
+      }
+      if (strlen (argv[1]) >= MAX_LONG_FILE_PATH) {
+        Error (NULL, 0, 1003, "Invalid option value", "FFS cache directory %s is too long", argv[1]);
+        return STATUS_ERROR;
+      }
+      strcpy (mFvDataInfo.FfsCacheDir, argv[1]);
+      mkdir (mFvDataInfo.FfsCacheDir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+      argc -= 2;
+      argv += 2;
+      continue;
+    }
+
     if ((stricmp (argv[0], "-p") == 0) || (stricmp (argv[0], "--dump") == 0)) {
       DumpCapsule = TRUE;
       argc --;
@@ -21,9 +21,16 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #ifndef __GNUC__
 #include <io.h>
 #endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 #include <assert.h>
+#include <time.h>
 
 #include <Guid/FfsSectionAlignmentPadding.h>
+#include <Guid/DispatchOrderHintFile.h>
 
 #include "WinNtInclude.h"
 #include "GenFvInternalLib.h"
@@ -181,6 +188,9 @@ BOOLEAN                     mIsLargeFfs = FALSE;
 EFI_PHYSICAL_ADDRESS mFvBaseAddress[0x10];
 UINT32               mFvBaseAddressNumber = 0;
 
+STATIC UINT32        mFfsCacheHits = 0;
+STATIC UINT32        mFfsCacheMisses = 0;
+
 EFI_STATUS
 ParseFvInf (
   IN  MEMORY_FILE  *InfFile,
@@ -259,6 +269,19 @@ Returns:
     strcpy (FvInfo->FvExtHeaderFile, Value);
   }
 
+  //
+  // Read the dispatch order hint flag
+  //
+  Status = FindToken (InfFile, OPTIONS_SECTION_STRING, EFI_DISPATCH_ORDER_HINT_STRING, 0, Value);
+  if (Status == EFI_SUCCESS) {
+    if ((strcmp (Value, TRUE_STRING) == 0) || (strcmp (Value, ONE_STRING) == 0)) {
+      FvInfo->DispatchOrderHint = TRUE;
+    } else if ((strcmp (Value, FALSE_STRING) != 0) && (strcmp (Value, ZERO_STRING) != 0)) {
+      Error (NULL, 0, 2000, "Invalid parameter", "%s expected %s | %s", EFI_DISPATCH_ORDER_HINT_STRING, TRUE_STRING, FALSE_STRING);
+      return EFI_ABORTED;
+    }
+  }
+
   //
   // Read the FV file name
   //
@@ -1178,6 +1201,433 @@ Returns:
   return TRUE;
 }
 
+STATIC
+EFI_STATUS
+ReadFfsInputFile (
+  IN  CHAR8   *FileName,
+  OUT UINT8   **FileBuffer,
+  OUT UINTN   *FileSize,
+  OUT BOOLEAN *Mapped
+  )
+/*++
+
+Routine Description:
+
+  This function gets the contents of an input file of the FV. Where the host
+  supports it the file is mapped privately rather than read, so the pages are
+  only copied when they are modified, for instance by the rebase.
+
+Arguments:
+
+  FileName      The name of the file.
+  FileBuffer    The buffer with the contents of the file. It must be released
+                with FreeFfsInputFile().
+  FileSize      The size of the file.
+  Mapped        Whether the file is mapped rather than read.
+
+Returns:
+
+  EFI_SUCCESS              The function completed successfully.
+  EFI_ABORTED              The file could not be opened or read.
+  EFI_OUT_OF_RESOURCES     Insufficient resources exist to read the file.
+
+--*/
+{
+  FILE                  *NewFile;
+  UINTN                 NumBytesRead;
+#ifndef _WIN32
+  int                   Fd;
+  struct stat           Stat;
+  VOID                  *Mapping;
+
+  Fd = open (LongFilePath (FileName), O_RDONLY);
+  if (Fd >= 0) {
+    if ((fstat (Fd, &Stat) == 0) && (Stat.st_size > 0)) {
+      Mapping = mmap (NULL, (size_t) Stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, Fd, 0);
+      if (Mapping != MAP_FAILED) {
+        close (Fd);
+        *FileBuffer = Mapping;
+        *FileSize   = (UINTN) Stat.st_size;
+        *Mapped     = TRUE;
+        return EFI_SUCCESS;
+      }
+    }
+    close (Fd);
+  }
+#endif
+
+  *Mapped = FALSE;
+  NewFile = fopen (LongFilePath (FileName), "rb");
+
+  if (NewFile == NULL) {
+    Error (NULL, 0, 0001, "Error opening file", FileName);
+    return EFI_ABORTED;
+  }
+
+  //
+  // Get the file size
+  //
+  *FileSize = _filelength (fileno (NewFile));
+
+  //
+  // Read the file into a buffer
+  //
+  *FileBuffer = malloc (*FileSize);
+  if (*FileBuffer == NULL) {
+    fclose (NewFile);
+    Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NumBytesRead = fread (*FileBuffer, sizeof (UINT8), *FileSize, NewFile);
+
+  //
+  // Done with the file, from this point on we will just use the buffer read.
+  //
+  fclose (NewFile);
+
+  //
+  // Verify read successful
+  //
+  if (NumBytesRead != sizeof (UINT8) * *FileSize) {
+    free (*FileBuffer);
+    Error (NULL, 0, 0004, "Error reading file", FileName);
+    return EFI_ABORTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+FreeFfsInputFile (
+  IN UINT8   *FileBuffer,
+  IN UINTN   FileSize,
+  IN BOOLEAN Mapped
+  )
+/*++
+
+Routine Description:
+
+  This function releases the contents of an input file of the FV.
+
+Arguments:
+
+  FileBuffer    The buffer returned by ReadFfsInputFile().
+  FileSize      The size returned by ReadFfsInputFile().
+  Mapped        The mapping state returned by ReadFfsInputFile().
+
+Returns:
+
+  None
+
+--*/
+{
+#ifndef _WIN32
+  if (Mapped) {
+    munmap (FileBuffer, FileSize);
+    return;
+  }
+#endif
+  free (FileBuffer);
+}
+
+//
+// Header of an entry of the FFS cache. It is followed by the name of the
+// input file, the FFS file before the rebase, the FFS file after the rebase
+// and the lines the rebase added to the FV map file.
+//
+#define FFS_CACHE_SIGNATURE  0x43534646 // "FFSC"
+
+#define FFS_CACHE_FLAG_ARM        0x01
+#define FFS_CACHE_FLAG_RISCV      0x02
+#define FFS_CACHE_FLAG_LOONGARCH  0x04
+
+typedef struct {
+  UINT32                  Signature;
+  UINT32                  NameSize;
+  UINT32                  FileSize;
+  UINT32                  MapSize;
+  EFI_PHYSICAL_ADDRESS    XipBase;
+  INT8                    ForceRebase;
+  UINT8                   Flags;
+  UINT8                   Reserved[6];
+} FFS_CACHE_ENTRY_HEADER;
+
+STATIC
+UINT64
+FfsCacheHash (
+  IN UINT64       Hash,
+  IN CONST VOID   *Buffer,
+  IN UINTN        Size
+  )
+/*++
+
+Routine Description:
+
+  This function adds a buffer to the 64-bit FNV-1a hash of the FFS cache key.
+
+Arguments:
+
+  Hash          The hash of the previous parts of the key.
+  Buffer        The buffer to add.
+  Size          The size of the buffer.
+
+Returns:
+
+  The hash of the key including the buffer.
+
+--*/
+{
+  CONST UINT8  *Bytes;
+  UINTN        Index;
+
+  Bytes = Buffer;
+  for (Index = 0; Index < Size; Index++) {
+    Hash ^= Bytes[Index];
+    Hash *= 0x100000001B3ULL;
+  }
+
+  return Hash;
+}
+
+STATIC
+BOOLEAN
+ReadFfsCacheEntry (
+  IN     CHAR8                    *EntryName,
+  IN     FFS_CACHE_ENTRY_HEADER   *Key,
+  IN     CHAR8                    *FileName,
+  IN OUT EFI_FFS_FILE_HEADER      *FfsFile,
+  IN     FILE                     *FvMapFile
+  )
+/*++
+
+Routine Description:
+
+  This function replaces an FFS file by its rebased copy found in the FFS
+  cache. The entry is only used when the whole key, including the contents
+  of the FFS file, matches, so a hash collision is never a hit.
+
+Arguments:
+
+  EntryName     The file name of the cache entry.
+  Key           The header the entry must match, except the MapSize and Flags.
+  FileName      The name of the input file.
+  FfsFile       The FFS file to replace.
+  FvMapFile     The FV map file to add the cached lines to.
+
+Returns:
+
+  TRUE          The FFS file was replaced by its rebased copy.
+  FALSE         There is no matching entry in the cache.
+
+--*/
+{
+  FILE                    *EntryFile;
+  UINT8                   *Entry;
+  UINTN                   EntrySize;
+  FFS_CACHE_ENTRY_HEADER  *Header;
+  UINT8                   *Pointer;
+  BOOLEAN                 Hit;
+
+  EntryFile = fopen (LongFilePath (EntryName), "rb");
+  if (EntryFile == NULL) {
+    return FALSE;
+  }
+
+  Hit       = FALSE;
+  EntrySize = _filelength (fileno (EntryFile));
+  Entry     = malloc (EntrySize);
+  if ((Entry != NULL) && (EntrySize > sizeof (FFS_CACHE_ENTRY_HEADER)) &&
+      (fread (Entry, 1, EntrySize, EntryFile) == EntrySize)) {
+    Header  = (FFS_CACHE_ENTRY_HEADER *) Entry;
+    Pointer = Entry + sizeof (FFS_CACHE_ENTRY_HEADER);
+    if ((Header->Signature == Key->Signature) &&
+        (Header->NameSize == Key->NameSize) &&
+        (Header->FileSize == Key->FileSize) &&
+        (Header->XipBase == Key->XipBase) &&
+        (Header->ForceRebase == Key->ForceRebase) &&
+        (EntrySize == sizeof (FFS_CACHE_ENTRY_HEADER) + (UINTN) Header->NameSize + 2 * (UINTN) Header->FileSize + Header->MapSize) &&
+        (memcmp (Pointer, FileName, Header->NameSize) == 0) &&
+        (memcmp (Pointer + Header->NameSize, FfsFile, Header->FileSize) == 0)) {
+      Pointer += Header->NameSize + Header->FileSize;
+      memcpy (FfsFile, Pointer, Header->FileSize);
+      Pointer += Header->FileSize;
+      if (Header->MapSize != 0) {
+        fwrite (Pointer, 1, Header->MapSize, FvMapFile);
+      }
+      mArm       |= (Header->Flags & FFS_CACHE_FLAG_ARM) != 0;
+      mRiscV     |= (Header->Flags & FFS_CACHE_FLAG_RISCV) != 0;
+      mLoongArch |= (Header->Flags & FFS_CACHE_FLAG_LOONGARCH) != 0;
+      Hit = TRUE;
+    }
+  }
+
+  if (Entry != NULL) {
+    free (Entry);
+  }
+  fclose (EntryFile);
+  return Hit;
+}
+
+STATIC
+EFI_STATUS
+CachedFfsRebase (
+  IN OUT  FV_INFO               *FvInfo,
+  IN      CHAR8                 *FileName,
+  IN OUT  EFI_FFS_FILE_HEADER   *FfsFile,
+  IN      UINTN                 FileSize,
+  IN      UINTN                 XipOffset,
+  IN      FILE                  *FvMapFile
+  )
+/*++
+
+Routine Description:
+
+  This function rebases an FFS file as FfsRebase() does, and keeps the result
+  in the FFS cache directory when one is specified. The cache is keyed by the
+  contents of the FFS file and the address it is placed at, so the images of
+  the FFS files that did not change are not parsed and relocated again when an
+  FV is rebuilt.
+
+  FV image files are always rebased, since the rebase also records the base
+  addresses of the child FVs.
+
+Arguments:
+
+  FvInfo            A pointer to FV_INFO structure.
+  FileName          Ffs File PathName
+  FfsFile           A pointer to Ffs file image.
+  FileSize          The size of the Ffs file image.
+  XipOffset         The offset address to use for rebasing the XIP file image.
+  FvMapFile         FvMapFile to record the function address in one Fvimage
+
+Returns:
+
+  EFI_SUCCESS             The image was properly rebased.
+  Others                  The error returned by FfsRebase().
+
+--*/
+{
+  EFI_STATUS              Status;
+  FFS_CACHE_ENTRY_HEADER  Key;
+  UINT64                  Hash;
+  CHAR8                   EntryName[MAX_LONG_FILE_PATH + sizeof ("/0123456789abcdef.ffs")];
+  FILE                    *MapCapture;
+  FILE                    *EntryFile;
+  UINT8                   *OrigFfsFile;
+  UINT8                   *MapBuffer;
+  BOOLEAN                 SavedArm;
+  BOOLEAN                 SavedRiscV;
+  BOOLEAN                 SavedLoongArch;
+
+  if ((FvInfo->FfsCacheDir[0] == '\0') ||
+      ((FvInfo->BaseAddress == 0) && (FvInfo->ForceRebase == -1)) ||
+      (FvInfo->ForceRebase == 0)) {
+    return FfsRebase (FvInfo, FileName, FfsFile, XipOffset, FvMapFile);
+  }
+
+  switch (FfsFile->Type) {
+    case EFI_FV_FILETYPE_SECURITY_CORE:
+    case EFI_FV_FILETYPE_PEI_CORE:
+    case EFI_FV_FILETYPE_PEIM:
+    case EFI_FV_FILETYPE_COMBINED_PEIM_DRIVER:
+    case EFI_FV_FILETYPE_DRIVER:
+    case EFI_FV_FILETYPE_DXE_CORE:
+      break;
+    default:
+      return FfsRebase (FvInfo, FileName, FfsFile, XipOffset, FvMapFile);
+  }
+
+  memset (&Key, 0, sizeof (Key));
+  Key.Signature   = FFS_CACHE_SIGNATURE;
+  Key.NameSize    = (UINT32) strlen (FileName);
+  Key.FileSize    = (UINT32) FileSize;
+  Key.XipBase     = FvInfo->BaseAddress + XipOffset;
+  Key.ForceRebase = FvInfo->ForceRebase;
+
+  Hash = 0xCBF29CE484222325ULL;
+  Hash = FfsCacheHash (Hash, &Key, sizeof (Key));
+  Hash = FfsCacheHash (Hash, FileName, Key.NameSize);
+  Hash = FfsCacheHash (Hash, FfsFile, FileSize);
+  snprintf (EntryName, sizeof (EntryName), "%s/%016llx.ffs", FvInfo->FfsCacheDir, (unsigned long long) Hash);
+
+  if (ReadFfsCacheEntry (EntryName, &Key, FileName, FfsFile, FvMapFile)) {
+    mFfsCacheHits++;
+    return EFI_SUCCESS;
+  }
+
+  mFfsCacheMisses++;
+
+  //
+  // Rebase the file, capturing the FFS file before the rebase and the map
+  // file lines the rebase writes, so the result can be added to the cache.
+  //
+  OrigFfsFile = malloc (FileSize);
+  MapCapture  = tmpfile ();
+  if ((OrigFfsFile == NULL) || (MapCapture == NULL)) {
+    if (OrigFfsFile != NULL) {
+      free (OrigFfsFile);
+    }
+    if (MapCapture != NULL) {
+      fclose (MapCapture);
+    }
+    return FfsRebase (FvInfo, FileName, FfsFile, XipOffset, FvMapFile);
+  }
+  memcpy (OrigFfsFile, FfsFile, FileSize);
+
+  SavedArm       = mArm;
+  SavedRiscV     = mRiscV;
+  SavedLoongArch = mLoongArch;
+  mArm           = FALSE;
+  mRiscV         = FALSE;
+  mLoongArch     = FALSE;
+
+  Status = FfsRebase (FvInfo, FileName, FfsFile, XipOffset, MapCapture);
+
+  Key.Flags  = (UINT8) ((mArm ? FFS_CACHE_FLAG_ARM : 0) |
+                        (mRiscV ? FFS_CACHE_FLAG_RISCV : 0) |
+                        (mLoongArch ? FFS_CACHE_FLAG_LOONGARCH : 0));
+  mArm       |= SavedArm;
+  mRiscV     |= SavedRiscV;
+  mLoongArch |= SavedLoongArch;
+
+  //
+  // Move the captured map file lines to the FV map file.
+  //
+  Key.MapSize = (UINT32) ftell (MapCapture);
+  MapBuffer   = malloc (Key.MapSize + 1);
+  rewind (MapCapture);
+  if ((MapBuffer == NULL) || (fread (MapBuffer, 1, Key.MapSize, MapCapture) != Key.MapSize)) {
+    Error (NULL, 0, 0004, "Error reading file", "the captured map file lines of %s", FileName);
+    Status = EFI_ABORTED;
+  } else if (Key.MapSize != 0) {
+    fwrite (MapBuffer, 1, Key.MapSize, FvMapFile);
+  }
+  fclose (MapCapture);
+
+  if (!EFI_ERROR (Status)) {
+    //
+    // A partially written entry does not match its size, so it is only a miss.
+    //
+    EntryFile = fopen (LongFilePath (EntryName), "wb");
+    if (EntryFile != NULL) {
+      fwrite (&Key, 1, sizeof (Key), EntryFile);
+      fwrite (FileName, 1, Key.NameSize, EntryFile);
+      fwrite (OrigFfsFile, 1, FileSize, EntryFile);
+      fwrite (FfsFile, 1, FileSize, EntryFile);
+      fwrite (MapBuffer, 1, Key.MapSize, EntryFile);
+      fclose (EntryFile);
+    }
+  }
+
+  if (MapBuffer != NULL) {
+    free (MapBuffer);
+  }
+  free (OrigFfsFile);
+  return Status;
+}
+
 EFI_STATUS
 AddFile (
   IN OUT MEMORY_FILE          *FvImage,
@@ -1214,10 +1664,10 @@ Returns:
 
 --*/
 {
-  FILE                  *NewFile;
   UINTN                 FileSize;
+  UINTN                 MappedSize;
+  BOOLEAN               Mapped;
   UINT8                 *FileBuffer;
-  UINTN                 NumBytesRead;
   UINT32                CurrentFileAlignment;
   EFI_STATUS            Status;
   UINTN                 Index1;
@@ -1234,43 +1684,11 @@ Returns:
   //
   // Read the file to add
   //
-  NewFile = fopen (LongFilePath (FvInfo->FvFiles[Index]), "rb");
-
-  if (NewFile == NULL) {
-    Error (NULL, 0, 0001, "Error opening file", FvInfo->FvFiles[Index]);
-    return EFI_ABORTED;
-  }
-
-  //
-  // Get the file size
-  //
-  FileSize = _filelength (fileno (NewFile));
-
-  //
-  // Read the file into a buffer
-  //
-  FileBuffer = malloc (FileSize);
-  if (FileBuffer == NULL) {
-    fclose (NewFile);
-    Error (NULL, 0, 4001, "Resource", "memory cannot be allocated!");
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  NumBytesRead = fread (FileBuffer, sizeof (UINT8), FileSize, NewFile);
-
-  //
-  // Done with the file, from this point on we will just use the buffer read.
-  //
-  fclose (NewFile);
-
-  //
-  // Verify read successful
-  //
-  if (NumBytesRead != sizeof (UINT8) * FileSize) {
-    free  (FileBuffer);
-    Error (NULL, 0, 0004, "Error reading file", FvInfo->FvFiles[Index]);
-    return EFI_ABORTED;
+  Status = ReadFfsInputFile (FvInfo->FvFiles[Index], &FileBuffer, &FileSize, &Mapped);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
+  MappedSize = FileSize;
 
   //
   // For None PI Ffs file, directly add them into FvImage.
@@ -1290,7 +1708,7 @@ Returns:
   //
   Status = VerifyFfsFile ((EFI_FFS_FILE_HEADER *)FileBuffer);
   if (EFI_ERROR (Status)) {
-    free (FileBuffer);
+    FreeFfsInputFile (FileBuffer, MappedSize, Mapped);
     Error (NULL, 0, 3000, "Invalid", "%s is not a valid FFS file.", FvInfo->FvFiles[Index]);
     return EFI_INVALID_PARAMETER;
   }
@@ -1299,7 +1717,7 @@ Returns:
   // Verify space exists to add the file
   //
   if (FileSize > (UINTN) ((UINTN) *VtfFileImage - (UINTN) FvImage->CurrentFilePointer)) {
-    free (FileBuffer);
+    FreeFfsInputFile (FileBuffer, MappedSize, Mapped);
     Error (NULL, 0, 4002, "Resource", "FV space is full, not enough room to add file %s.", FvInfo->FvFiles[Index]);
     return EFI_OUT_OF_RESOURCES;
   }
@@ -1311,7 +1729,7 @@ Returns:
     if (CompareGuid ((EFI_GUID *) FileBuffer, &mFileGuidArray [Index1]) == 0) {
       Error (NULL, 0, 2000, "Invalid parameter", "the %dth file and %uth file have the same file GUID.", (unsigned) Index1 + 1, (unsigned) Index + 1);
       PrintGuid ((EFI_GUID *) FileBuffer);
-      free (FileBuffer);
+      FreeFfsInputFile (FileBuffer, MappedSize, Mapped);
       return EFI_INVALID_PARAMETER;
     }
   }
@@ -1350,14 +1768,14 @@ Returns:
       //
       if (((UINTN) *VtfFileImage + GetFfsHeaderLength((EFI_FFS_FILE_HEADER *)FileBuffer) - (UINTN) FvImage->FileImage) % (1 << CurrentFileAlignment)) {
         Error (NULL, 0, 3000, "Invalid", "VTF file cannot be aligned on a %u-byte boundary.", (unsigned) (1 << CurrentFileAlignment));
-        free (FileBuffer);
+        FreeFfsInputFile (FileBuffer, MappedSize, Mapped);
         return EFI_ABORTED;
       }
       //
       // Rebase the PE or TE image in FileBuffer of FFS file for XIP
       // Rebase for the debug genfvmap tool
       //
-      Status = FfsRebase (FvInfo, FvInfo->FvFiles[Index], (EFI_FFS_FILE_HEADER *) FileBuffer, (UINTN) *VtfFileImage - (UINTN) FvImage->FileImage, FvMapFile);
+      Status = CachedFfsRebase (FvInfo, FvInfo->FvFiles[Index], (EFI_FFS_FILE_HEADER *) FileBuffer, FileSize, (UINTN) *VtfFileImage - (UINTN) FvImage->FileImage, FvMapFile);
       if (EFI_ERROR (Status)) {
         Error (NULL, 0, 3000, "Invalid", "Could not rebase %s.", FvInfo->FvFiles[Index]);
         return Status;
@@ -1370,7 +1788,7 @@ Returns:
       PrintGuidToBuffer ((EFI_GUID *) FileBuffer, FileGuidString, sizeof (FileGuidString), TRUE);
       fprintf (FvReportFile, "0x%08X %s\n", (unsigned)(UINTN) (((UINT8 *)*VtfFileImage) - (UINTN)FvImage->FileImage), FileGuidString);
 
-      free (FileBuffer);
+      FreeFfsInputFile (FileBuffer, MappedSize, Mapped);
       DebugMsg (NULL, 0, 9, "Add VTF FFS file in FV image", NULL);
       return EFI_SUCCESS;
     } else {
@@ -1378,7 +1796,7 @@ Returns:
       // Already found a VTF file.
       //
       Error (NULL, 0, 3000, "Invalid", "multiple VTF files are not permitted within a single FV.");
-      free (FileBuffer);
+      FreeFfsInputFile (FileBuffer, MappedSize, Mapped);
       return EFI_ABORTED;
     }
   }
@@ -1391,7 +1809,7 @@ Returns:
     Status = AddPadFile (FvImage, 1 << CurrentFileAlignment, *VtfFileImage, NULL, FileSize);
     if (EFI_ERROR (Status)) {
       Error (NULL, 0, 4002, "Resource", "FV space is full, could not add pad file for data alignment property.");
-      free (FileBuffer);
+      FreeFfsInputFile (FileBuffer, MappedSize, Mapped);
       return EFI_ABORTED;
     }
   }
@@ -1403,7 +1821,7 @@ Returns:
     // Rebase the PE or TE image in FileBuffer of FFS file for XIP.
     // Rebase Bs and Rt drivers for the debug genfvmap tool.
     //
-    Status = FfsRebase (FvInfo, FvInfo->FvFiles[Index], (EFI_FFS_FILE_HEADER *) FileBuffer, (UINTN) FvImage->CurrentFilePointer - (UINTN) FvImage->FileImage, FvMapFile);
+    Status = CachedFfsRebase (FvInfo, FvInfo->FvFiles[Index], (EFI_FFS_FILE_HEADER *) FileBuffer, FileSize, (UINTN) FvImage->CurrentFilePointer - (UINTN) FvImage->FileImage, FvMapFile);
   if (EFI_ERROR (Status)) {
     Error (NULL, 0, 3000, "Invalid", "Could not rebase %s.", FvInfo->FvFiles[Index]);
     return Status;
@@ -1417,7 +1835,7 @@ Returns:
     FvImage->CurrentFilePointer += FileSize;
   } else {
     Error (NULL, 0, 4002, "Resource", "FV space is full, cannot add file %s.", FvInfo->FvFiles[Index]);
-    free (FileBuffer);
+    FreeFfsInputFile (FileBuffer, MappedSize, Mapped);
     return EFI_ABORTED;
   }
   //
@@ -1431,7 +1849,7 @@ Done:
   //
   // Free allocated memory.
   //
-  free (FileBuffer);
+  FreeFfsInputFile (FileBuffer, MappedSize, Mapped);
 
   return EFI_SUCCESS;
 }
@@ -2652,7 +3070,9 @@ Returns:
   UINTN                           FileSize;
   CHAR8                           *FvReportName;
   FILE                            *FvReportFile;
+  clock_t                         StartTime;
 
+  StartTime      = clock ();
   FvBufferHeader = NULL;
   FvFile         = NULL;
   FvMapName      = NULL;
@@ -2847,6 +3267,17 @@ Returns:
   strcpy (FvReportName, FvFileName);
   strcat (FvReportName, ".txt");
 
+  //
+  // Add the dispatch order hint file computed from the dependency expressions
+  // of the PEIMs and DXE drivers.
+  //
+  if (mFvDataInfo.DispatchOrderHint) {
+    Status = GenerateDispatchOrderHintFile (&mFvDataInfo, FvFileName);
+    if (EFI_ERROR (Status)) {
+      goto Finish;
+    }
+  }
+
   //
   // Calculate the FV size and Update Fv Size based on the actual FFS files.
   // And Update mFvDataInfo data.
@@ -3146,6 +3577,13 @@ WriteFile:
   }
 
 Finish:
+  if (!EFI_ERROR (Status)) {
+    VerboseMsg ("%s generated in %u ms", FvFileName, (unsigned) ((clock () - StartTime) * 1000 / CLOCKS_PER_SEC));
+    if (mFvDataInfo.FfsCacheDir[0] != '\0') {
+      VerboseMsg ("%u files rebased from the FFS cache, %u files added to it", (unsigned) mFfsCacheHits, (unsigned) mFfsCacheMisses);
+    }
+  }
+
   if (FvBufferHeader != NULL) {
     free (FvBufferHeader);
   }
@@ -3447,6 +3885,499 @@ Returns:
   return EFI_SUCCESS;
 }
 
+//
+// A PEIM or DXE driver of the FV, as seen by the dispatch order analysis
+//
+typedef struct {
+  EFI_GUID                FileName;
+  UINT8                   *Depex[2];      // PEI and DXE dependency expressions
+  UINT32                  DepexSize[2];
+  UINT8                   *Image;         // PE32 or TE image
+  UINT32                  ImageSize;
+} DISPATCH_ORDER_FILE;
+
+EFI_GUID  mDispatchOrderHintFileGuid = EDKII_DISPATCH_ORDER_HINT_FILE_GUID;
+
+STATIC
+int
+CompareDispatchOrderGuid (
+  IN CONST VOID  *Guid1,
+  IN CONST VOID  *Guid2
+  )
+/*++
+
+Routine Description:
+
+  qsort() and bsearch() comparison function for an array of GUIDs.
+
+--*/
+{
+  return memcmp (Guid1, Guid2, sizeof (EFI_GUID));
+}
+
+STATIC
+BOOLEAN
+ParseDispatchOrderFile (
+  IN  EFI_FFS_FILE_HEADER  *FfsFile,
+  IN  UINT32               FileSize,
+  OUT DISPATCH_ORDER_FILE  *DispatchFile
+  )
+/*++
+
+Routine Description:
+
+  Finds the dependency expressions and the image of a PEIM or DXE driver in the
+  leaf sections of its FFS file. Encapsulated sections are not looked into.
+
+Arguments:
+
+  FfsFile       The FFS file.
+  FileSize      The size of the FFS file.
+  DispatchFile  Returns the name, dependency expressions and image of the file.
+
+Returns:
+
+  TRUE          The file is a PEIM or a DXE driver.
+  FALSE         The file is not dispatched by the PEI or DXE dispatcher.
+
+--*/
+{
+  UINT32                     Offset;
+  UINT32                     SectionLength;
+  UINT32                     SectionHeaderLength;
+  EFI_COMMON_SECTION_HEADER  *Section;
+  UINT8                      *SectionData;
+
+  memset (DispatchFile, 0, sizeof (DISPATCH_ORDER_FILE));
+
+  if ((FileSize < sizeof (EFI_FFS_FILE_HEADER)) ||
+      (FileSize < GetFfsHeaderLength (FfsFile)) ||
+      (FileSize < GetFfsFileLength (FfsFile))) {
+    return FALSE;
+  }
+
+  if ((FfsFile->Type != EFI_FV_FILETYPE_PEIM) &&
+      (FfsFile->Type != EFI_FV_FILETYPE_DRIVER) &&
+      (FfsFile->Type != EFI_FV_FILETYPE_COMBINED_PEIM_DRIVER)) {
+    return FALSE;
+  }
+
+  memcpy (&DispatchFile->FileName, &FfsFile->Name, sizeof (EFI_GUID));
+
+  FileSize = GetFfsFileLength (FfsFile);
+  Offset   = GetFfsHeaderLength (FfsFile);
+  while (Offset + sizeof (EFI_COMMON_SECTION_HEADER) <= FileSize) {
+    Section             = (EFI_COMMON_SECTION_HEADER *) ((UINT8 *) FfsFile + Offset);
+    SectionLength       = GetSectionFileLength (Section);
+    SectionHeaderLength = GetSectionHeaderLength (Section);
+    if ((SectionLength < SectionHeaderLength) || (SectionLength > FileSize - Offset)) {
+      break;
+    }
+
+    SectionData = (UINT8 *) Section + SectionHeaderLength;
+    switch (Section->Type) {
+    case EFI_SECTION_PEI_DEPEX:
+      DispatchFile->Depex[0]     = SectionData;
+      DispatchFile->DepexSize[0] = SectionLength - SectionHeaderLength;
+      break;
+    case EFI_SECTION_DXE_DEPEX:
+      DispatchFile->Depex[1]     = SectionData;
+      DispatchFile->DepexSize[1] = SectionLength - SectionHeaderLength;
+      break;
+    case EFI_SECTION_PE32:
+    case EFI_SECTION_TE:
+      DispatchFile->Image     = SectionData;
+      DispatchFile->ImageSize = SectionLength - SectionHeaderLength;
+      break;
+    default:
+      break;
+    }
+
+    Offset += (SectionLength + 3) & ~3;
+  }
+
+  return TRUE;
+}
+
+STATIC
+UINTN
+NextDepexGuid (
+  IN     DISPATCH_ORDER_FILE  *DispatchFile,
+  IN OUT UINTN                *Depex,
+  IN OUT UINTN                *Offset,
+  OUT    UINT8                *OpCode
+  )
+/*++
+
+Routine Description:
+
+  Iterates over the opcodes of the dependency expressions of a file that are
+  followed by a GUID.
+
+Arguments:
+
+  DispatchFile  The file.
+  Depex         The dependency expression of the file being walked, start at 0.
+  Offset        The offset of the next opcode in the expression, start at 0.
+  OpCode        Returns the opcode, EFI_DEP_BEFORE, EFI_DEP_AFTER or EFI_DEP_PUSH.
+
+Returns:
+
+  The offset of the GUID in the expression, or 0 when all the expressions have
+  been walked.
+
+--*/
+{
+  UINT8   *Expression;
+  UINTN   GuidOffset;
+
+  for (; *Depex < 2; (*Depex)++, *Offset = 0) {
+    Expression = DispatchFile->Depex[*Depex];
+    while (*Offset < DispatchFile->DepexSize[*Depex] && Expression[*Offset] != EFI_DEP_END) {
+      *OpCode = Expression[*Offset];
+      if (*OpCode > EFI_DEP_PUSH) {
+        *Offset += 1;
+        continue;
+      }
+
+      GuidOffset = *Offset + 1;
+      if (GuidOffset + sizeof (EFI_GUID) > DispatchFile->DepexSize[*Depex]) {
+        break;
+      }
+
+      *Offset = GuidOffset + sizeof (EFI_GUID);
+      return GuidOffset;
+    }
+  }
+
+  return 0;
+}
+
+EFI_STATUS
+GenerateDispatchOrderHintFile (
+  IN OUT FV_INFO  *FvInfo,
+  IN     CHAR8    *FvFileName
+  )
+/*++
+
+Routine Description:
+
+  Computes the order in which the PEIMs and DXE drivers of the FV are expected
+  to be dispatched, and adds a file that records it to the FV.
+
+  The analysis is static: a file that references a GUID its dependency
+  expression pushes in its image, without pushing the GUID itself, is taken as
+  a producer of the GUID and is ordered before the files that push it. BEFORE
+  and AFTER expressions are honored. Cycles are broken in FV order, and files
+  without constraints keep their FV order. The dispatchers still evaluate the
+  dependency expressions, so a wrong order only costs dispatcher passes.
+
+Arguments:
+
+  FvInfo        The FV the hint is computed for. The hint file is appended to
+                its list of files.
+  FvFileName    The name of the FV file, used to name the hint file.
+
+Returns:
+
+  EFI_SUCCESS            The hint file was added, or the FV holds no PEIM or
+                         DXE driver.
+  EFI_ABORTED            An FFS file could not be read or the hint file could
+                         not be written.
+  EFI_OUT_OF_RESOURCES   Memory could not be allocated.
+
+--*/
+{
+  EFI_STATUS                 Status;
+  UINTN                      FileCount;
+  UINTN                      Count;
+  UINTN                      GuidCount;
+  UINTN                      Index;
+  UINTN                      Index2;
+  UINTN                      From;
+  UINTN                      To;
+  UINTN                      Depex;
+  UINTN                      Offset;
+  UINTN                      GuidOffset;
+  UINTN                      BitmapSize;
+  UINT8                      OpCode;
+  CHAR8                      **FileImages;
+  UINT32                     FileSize;
+  DISPATCH_ORDER_FILE        *Files;
+  EFI_GUID                   *FileNames;
+  EFI_GUID                   *Guids;
+  EFI_GUID                   *Guid;
+  UINT8                      *References;
+  UINT8                      *Pushes;
+  UINT8                      *Edges;
+  UINT32                     *InDegree;
+  BOOLEAN                    *Ordered;
+  EFI_GUID                   *Order;
+  UINTN                      OrderCount;
+  UINT8                      *HintFile;
+  UINT32                     HintFileSize;
+  EFI_FFS_FILE_HEADER        *HintFileHeader;
+  EFI_COMMON_SECTION_HEADER  *HintSection;
+  CHAR8                      *HintFileName;
+
+  for (FileCount = 0; FvInfo->FvFiles[FileCount][0] != '\0'; FileCount++) {
+  }
+
+  if (FileCount + 1 >= MAX_NUMBER_OF_FILES_IN_FV) {
+    Error (NULL, 0, 2000, "Invalid parameter", "The dispatch order hint file cannot be added to the %u files of the FV.", (unsigned) FileCount);
+    return EFI_ABORTED;
+  }
+
+  Status       = EFI_SUCCESS;
+  FileImages   = calloc (FileCount + 1, sizeof (CHAR8 *));
+  Files        = calloc (FileCount + 1, sizeof (DISPATCH_ORDER_FILE));
+  FileNames    = calloc (FileCount + 1, sizeof (EFI_GUID));
+  Guids        = NULL;
+  References   = NULL;
+  Pushes       = NULL;
+  Edges        = NULL;
+  InDegree     = NULL;
+  Ordered      = NULL;
+  Order        = NULL;
+  HintFile     = NULL;
+  HintFileName = NULL;
+  if ((FileImages == NULL) || (Files == NULL) || (FileNames == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  //
+  // Read the PEIMs and DXE drivers of the FV
+  //
+  Count = 0;
+  for (Index = 0; Index < FileCount; Index++) {
+    Status = GetFileImage (FvInfo->FvFiles[Index], &FileImages[Index], &FileSize);
+    if (EFI_ERROR (Status)) {
+      Error (NULL, 0, 0001, "Error opening file", FvInfo->FvFiles[Index]);
+      Status = EFI_ABORTED;
+      goto Done;
+    }
+
+    if (ParseDispatchOrderFile ((EFI_FFS_FILE_HEADER *) FileImages[Index], FileSize, &Files[Count])) {
+      memcpy (&FileNames[Count], &Files[Count].FileName, sizeof (EFI_GUID));
+      Count++;
+    }
+  }
+
+  if (Count == 0) {
+    goto Done;
+  }
+
+  //
+  // Collect the distinct GUIDs the dependency expressions push
+  //
+  GuidCount = 0;
+  for (Index = 0; Index < Count; Index++) {
+    Depex  = 0;
+    Offset = 0;
+    while (NextDepexGuid (&Files[Index], &Depex, &Offset, &OpCode) != 0) {
+      GuidCount++;
+    }
+  }
+
+  Guids = calloc (GuidCount + 1, sizeof (EFI_GUID));
+  if (Guids == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  GuidCount = 0;
+  for (Index = 0; Index < Count; Index++) {
+    Depex  = 0;
+    Offset = 0;
+    while ((GuidOffset = NextDepexGuid (&Files[Index], &Depex, &Offset, &OpCode)) != 0) {
+      if (OpCode == EFI_DEP_PUSH) {
+        memcpy (&Guids[GuidCount++], Files[Index].Depex[Depex] + GuidOffset, sizeof (EFI_GUID));
+      }
+    }
+  }
+
+  qsort (Guids, GuidCount, sizeof (EFI_GUID), CompareDispatchOrderGuid);
+  for (Index = 0, Index2 = 0; Index < GuidCount; Index++) {
+    if ((Index2 == 0) || (CompareDispatchOrderGuid (&Guids[Index2 - 1], &Guids[Index]) != 0)) {
+      memcpy (&Guids[Index2++], &Guids[Index], sizeof (EFI_GUID));
+    }
+  }
+
+  GuidCount = Index2;
+
+  //
+  // Record which of these GUIDs each file pushes, and which ones it references
+  // in its image. GUIDs are 32-bit aligned in the image data.
+  //
+  BitmapSize = (GuidCount + 7) / 8;
+  References = calloc (Count, BitmapSize + 1);
+  Pushes     = calloc (Count, BitmapSize + 1);
+  Edges      = calloc (Count, Count);
+  InDegree   = calloc (Count, sizeof (UINT32));
+  Ordered    = calloc (Count, sizeof (BOOLEAN));
+  Order      = calloc (Count, sizeof (EFI_GUID));
+  if ((References == NULL) || (Pushes == NULL) || (Edges == NULL) ||
+      (InDegree == NULL) || (Ordered == NULL) || (Order == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    Depex  = 0;
+    Offset = 0;
+    while ((GuidOffset = NextDepexGuid (&Files[Index], &Depex, &Offset, &OpCode)) != 0) {
+      if (OpCode == EFI_DEP_PUSH) {
+        Guid   = bsearch (Files[Index].Depex[Depex] + GuidOffset, Guids, GuidCount, sizeof (EFI_GUID), CompareDispatchOrderGuid);
+        Index2 = Guid - Guids;
+        Pushes[Index * BitmapSize + Index2 / 8] |= (UINT8) (1 << (Index2 % 8));
+      }
+    }
+
+    for (Offset = 0; Offset + sizeof (EFI_GUID) <= Files[Index].ImageSize; Offset += sizeof (UINT32)) {
+      Guid = bsearch (Files[Index].Image + Offset, Guids, GuidCount, sizeof (EFI_GUID), CompareDispatchOrderGuid);
+      if (Guid != NULL) {
+        Index2 = Guid - Guids;
+        References[Index * BitmapSize + Index2 / 8] |= (UINT8) (1 << (Index2 % 8));
+      }
+    }
+  }
+
+  //
+  // Edges[From * Count + To] is set if From is expected to be dispatched
+  // before To
+  //
+  for (Index = 0; Index < Count; Index++) {
+    Depex  = 0;
+    Offset = 0;
+    while ((GuidOffset = NextDepexGuid (&Files[Index], &Depex, &Offset, &OpCode)) != 0) {
+      if (OpCode == EFI_DEP_PUSH) {
+        Guid   = bsearch (Files[Index].Depex[Depex] + GuidOffset, Guids, GuidCount, sizeof (EFI_GUID), CompareDispatchOrderGuid);
+        Index2 = Guid - Guids;
+        for (From = 0; From < Count; From++) {
+          if ((From != Index) &&
+              ((References[From * BitmapSize + Index2 / 8] & (1 << (Index2 % 8))) != 0) &&
+              ((Pushes[From * BitmapSize + Index2 / 8] & (1 << (Index2 % 8))) == 0) &&
+              (Edges[From * Count + Index] == 0)) {
+            Edges[From * Count + Index] = 1;
+            InDegree[Index]++;
+          }
+        }
+      } else {
+        for (Index2 = 0; Index2 < Count; Index2++) {
+          if (CompareDispatchOrderGuid (&FileNames[Index2], Files[Index].Depex[Depex] + GuidOffset) == 0) {
+            break;
+          }
+        }
+
+        if ((Index2 < Count) && (Index2 != Index)) {
+          From = (OpCode == EFI_DEP_BEFORE) ? Index : Index2;
+          To   = (OpCode == EFI_DEP_BEFORE) ? Index2 : Index;
+          if (Edges[From * Count + To] == 0) {
+            Edges[From * Count + To] = 1;
+            InDegree[To]++;
+          }
+        }
+      }
+    }
+  }
+
+  //
+  // Sort the files topologically, in FV order among the files that are ready,
+  // and break the cycles at the first file in FV order
+  //
+  for (OrderCount = 0; OrderCount < Count; OrderCount++) {
+    for (Index = 0; Index < Count; Index++) {
+      if (!Ordered[Index] && (InDegree[Index] == 0)) {
+        break;
+      }
+    }
+
+    if (Index == Count) {
+      for (Index = 0; Ordered[Index]; Index++) {
+      }
+    }
+
+    Ordered[Index] = TRUE;
+    memcpy (&Order[OrderCount], &Files[Index].FileName, sizeof (EFI_GUID));
+    for (Index2 = 0; Index2 < Count; Index2++) {
+      if ((Edges[Index * Count + Index2] != 0) && (InDegree[Index2] != 0)) {
+        InDegree[Index2]--;
+      }
+    }
+  }
+
+  //
+  // Write the hint file, a FREEFORM file with a RAW section holding the order
+  //
+  HintFileSize = (UINT32) (sizeof (EFI_FFS_FILE_HEADER) + sizeof (EFI_COMMON_SECTION_HEADER) + Count * sizeof (EFI_GUID));
+  HintFile     = calloc (1, HintFileSize);
+  HintFileName = malloc (strlen (FvFileName) + strlen (".hint") + 1);
+  if ((HintFile == NULL) || (HintFileName == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  HintSection          = (EFI_COMMON_SECTION_HEADER *) (HintFile + sizeof (EFI_FFS_FILE_HEADER));
+  HintSection->Type    = EFI_SECTION_RAW;
+  HintSection->Size[0] = (UINT8) ((HintFileSize - sizeof (EFI_FFS_FILE_HEADER)) & 0xff);
+  HintSection->Size[1] = (UINT8) (((HintFileSize - sizeof (EFI_FFS_FILE_HEADER)) & 0xff00) >> 8);
+  HintSection->Size[2] = (UINT8) (((HintFileSize - sizeof (EFI_FFS_FILE_HEADER)) & 0xff0000) >> 16);
+  memcpy (HintSection + 1, Order, Count * sizeof (EFI_GUID));
+
+  HintFileHeader       = (EFI_FFS_FILE_HEADER *) HintFile;
+  memcpy (&HintFileHeader->Name, &mDispatchOrderHintFileGuid, sizeof (EFI_GUID));
+  HintFileHeader->Type    = EFI_FV_FILETYPE_FREEFORM;
+  HintFileHeader->Size[0] = (UINT8) (HintFileSize & 0xff);
+  HintFileHeader->Size[1] = (UINT8) ((HintFileSize & 0xff00) >> 8);
+  HintFileHeader->Size[2] = (UINT8) ((HintFileSize & 0xff0000) >> 16);
+  HintFileHeader->IntegrityCheck.Checksum.Header = CalculateChecksum8 (HintFile, sizeof (EFI_FFS_FILE_HEADER));
+  HintFileHeader->IntegrityCheck.Checksum.File   = FFS_FIXED_CHECKSUM;
+  HintFileHeader->State = EFI_FILE_HEADER_CONSTRUCTION | EFI_FILE_HEADER_VALID | EFI_FILE_DATA_VALID;
+
+  strcpy (HintFileName, FvFileName);
+  strcat (HintFileName, ".hint");
+  if (strlen (HintFileName) > MAX_LONG_FILE_PATH - 1) {
+    Error (NULL, 0, 1003, "Invalid option value", "FvFileName %s is too long!", FvFileName);
+    Status = EFI_ABORTED;
+    goto Done;
+  }
+
+  Status = PutFileImage (HintFileName, (CHAR8 *) HintFile, HintFileSize);
+  if (EFI_ERROR (Status)) {
+    Error (NULL, 0, 0002, "Error writing file", HintFileName);
+    Status = EFI_ABORTED;
+    goto Done;
+  }
+
+  for (FileCount = 0; FvInfo->FvFiles[FileCount][0] != '\0'; FileCount++) {
+  }
+
+  strcpy (FvInfo->FvFiles[FileCount], HintFileName);
+  FvInfo->SizeofFvFiles[FileCount] = 0;
+  VerboseMsg ("the dispatch order hint file %s orders %u files", HintFileName, (unsigned) Count);
+
+Done:
+  if (FileImages != NULL) {
+    for (Index = 0; FileImages[Index] != NULL; Index++) {
+      free (FileImages[Index]);
+    }
+    free (FileImages);
+  }
+  free (Files);
+  free (FileNames);
+  free (Guids);
+  free (References);
+  free (Pushes);
+  free (Edges);
+  free (InDegree);
+  free (Ordered);
+  free (Order);
+  free (HintFile);
+  free (HintFileName);
+  return Status;
+}
+
 EFI_STATUS
 FfsRebaseImageRead (
   IN     VOID    *FileHandle,
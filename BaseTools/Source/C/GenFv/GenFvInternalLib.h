@@ -72,6 +72,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define EFI_OEM_CAPSULE_FLAGS_STRING      "EFI_OEM_CAPSULE_FLAGS"
 #define EFI_CAPSULE_VERSION_STRING        "EFI_CAPSULE_VERSION"
 
+#define EFI_DISPATCH_ORDER_HINT_STRING    "EFI_DISPATCH_ORDER_HINT"
+
 #define EFI_FV_TOTAL_SIZE_STRING    "EFI_FV_TOTAL_SIZE"
 #define EFI_FV_TAKEN_SIZE_STRING    "EFI_FV_TAKEN_SIZE"
 #define EFI_FV_SPACE_SIZE_STRING    "EFI_FV_SPACE_SIZE"
@@ -183,6 +185,14 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define FIT_TYPE_MASK         0x7F
 #define CHECKSUM_BIT_MASK     0x80
 
+//
+// Dependency expression opcodes
+//
+#define EFI_DEP_BEFORE        0x00
+#define EFI_DEP_AFTER         0x01
+#define EFI_DEP_PUSH          0x02
+#define EFI_DEP_END           0x08
+
 //
 // Private data types
 //
@@ -213,6 +223,8 @@ typedef struct {
   UINT32                  SizeofFvFiles[MAX_NUMBER_OF_FILES_IN_FV];
   BOOLEAN                 IsPiFvImage;
   INT8                    ForceRebase;
+  BOOLEAN                 DispatchOrderHint;
+  CHAR8                   FfsCacheDir[MAX_LONG_FILE_PATH];
 } FV_INFO;
 
 typedef struct {
@@ -327,6 +339,12 @@ CalculateFvSize (
   FV_INFO *FvInfoPtr
   );
 
+EFI_STATUS
+GenerateDispatchOrderHintFile (
+  IN OUT FV_INFO  *FvInfo,
+  IN     CHAR8    *FvFileName
+  );
+
 EFI_STATUS
 FfsRebase (
   IN OUT  FV_INFO               *FvInfo,
@@ -0,0 +1,21 @@
+/** @file
+  The file name of the dispatch order hint file GenFv adds to a firmware
+  volume. The file holds a single raw section with the file names of the PEIMs
+  and DXE drivers of the firmware volume, in the order they are expected to be
+  dispatched.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __DISPATCH_ORDER_HINT_FILE_GUID_H__
+#define __DISPATCH_ORDER_HINT_FILE_GUID_H__
+
+#define EDKII_DISPATCH_ORDER_HINT_FILE_GUID \
+  { \
+    0x2cc4d19f, 0x5008, 0x4dc5, {0x8c, 0x95, 0x59, 0x0d, 0x2d, 0x3a, 0x5a, 0x47 } \
+  }
+
+#endif
@@ -44,6 +44,7 @@ static CONVERTER_TYPE mConType = NoConverter;
 
 UINT64 mDictionarySize = 28;
 UINT64 mCompressionMode = 2;
+UINT64 mNumThreads = 1;
 
 #define UTILITY_NAME "LzmaCompress"
 #define UTILITY_MAJOR_VERSION 0
@@ -65,6 +66,9 @@ void PrintHelp(char *buffer)
              "  --debug [0-9]: set debug level\n"
              "  -a: set compression mode 0 = fast, 1 = normal, default: 1 (normal)\n"
              "  d: sets Dictionary size - [0, 27], default: 24 (16MB)\n"
+             "  --threads [1-2]: set the number of encoder threads, default: 1 (2 with Windows)\n"
+             "    The match finder runs in its own thread in normal mode. The\n"
+             "    output is the same with 1 or 2 threads.\n"
              "  --version: display the program version and exit\n"
              "  -h, --help: display this help text\n"
              );
@@ -253,6 +257,13 @@ int main2(int numArgs, const char *args[], char *rs)
 
   LzmaEncProps_Init(&props);
   LzmaEncProps_Normalize(&props);
+#ifndef _WIN32
+  //
+  // The GNU build was single threaded before --threads was added, and stays
+  // so unless the option asks for two threads.
+  //
+  props.numThreads = (int)mNumThreads;
+#endif
 
   FileSeqInStream_CreateVTable(&inStream);
   File_Construct(&inStream.file);
@@ -296,6 +307,18 @@ int main2(int numArgs, const char *args[], char *rs)
       } else {
         return PrintError(rs, kInvalidParamValMessage);
       }
+    } else if (strcmp(args[param], "--threads") == 0) {
+      if (numArgs < (param + 2)) {
+        return PrintUserError(rs);
+      }
+      AsciiStringToUint64(args[param + 1],FALSE,&mNumThreads);
+      if ((mNumThreads == 1) || (mNumThreads == 2)) {
+        props.numThreads = (int)mNumThreads;
+        param++;
+        continue;
+      } else {
+        return PrintError(rs, kInvalidParamValMessage);
+      }
     } else if (strcmp(args[param], "d") == 0) {
       AsciiStringToUint64(args[param + 1],FALSE,&mDictionarySize);
       if (mDictionarySize <= 27) {
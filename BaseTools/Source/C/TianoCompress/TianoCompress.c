@@ -15,6 +15,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "TianoCompress.h"
 #include "EfiUtilityMsgs.h"
 #include "ParseInf.h"
+#include "BatchJobs.h"
 #include <stdio.h>
 #include "assert.h"
 
@@ -61,17 +62,30 @@ static BOOLEAN QuietMode = FALSE;
 STATIC BOOLEAN ENCODE = FALSE;
 STATIC BOOLEAN DECODE = FALSE;
 STATIC BOOLEAN UEFIMODE = FALSE;
-STATIC UINT8  *mSrc, *mDst, *mSrcUpperLimit, *mDstUpperLimit;
-STATIC UINT8  *mLevel, *mText, *mChildCount, *mBuf, mCLen[NC], mPTLen[NPT], *mLen;
-STATIC INT16  mHeap[NC + 1];
-STATIC INT32  mRemainder, mMatchLen, mBitCount, mHeapSize, mN;
-STATIC UINT32 mBufSiz = 0, mOutputPos, mOutputMask, mSubBitBuf, mCrc;
-STATIC UINT32 mCompSize, mOrigSize;
-
-STATIC UINT16 *mFreq, *mSortPtr, mLenCnt[17], mLeft[2 * NC - 1], mRight[2 * NC - 1], mCrcTable[UINT8_MAX + 1],
+STATIC CHAR8   *BatchListName = NULL;
+STATIC UINT64  BatchThreads = 0;
+
+//
+// The compressor state is per thread so that --batch can compress several
+// files at the same time.
+//
+#if defined (_MSC_VER)
+#define THREAD_LOCAL  __declspec (thread)
+#else
+#define THREAD_LOCAL  __thread
+#endif
+
+STATIC THREAD_LOCAL UINT8  *mSrc, *mDst, *mSrcUpperLimit, *mDstUpperLimit;
+STATIC THREAD_LOCAL UINT8  *mLevel, *mText, *mChildCount, *mBuf, mCLen[NC], mPTLen[NPT], *mLen;
+STATIC THREAD_LOCAL INT16  mHeap[NC + 1];
+STATIC THREAD_LOCAL INT32  mRemainder, mMatchLen, mBitCount, mHeapSize, mN;
+STATIC THREAD_LOCAL UINT32 mBufSiz = 0, mOutputPos, mOutputMask, mSubBitBuf, mCrc;
+STATIC THREAD_LOCAL UINT32 mCompSize, mOrigSize;
+
+STATIC THREAD_LOCAL UINT16 *mFreq, *mSortPtr, mLenCnt[17], mLeft[2 * NC - 1], mRight[2 * NC - 1], mCrcTable[UINT8_MAX + 1],
   mCFreq[2 * NC - 1], mCCode[NC], mPFreq[2 * NP - 1], mPTCode[NPT], mTFreq[2 * NT - 1];
 
-STATIC NODE   mPos, mMatchPos, mAvail, *mPosition, *mParent, *mPrev, *mNext = NULL;
+STATIC THREAD_LOCAL NODE   mPos, mMatchPos, mAvail, *mPosition, *mParent, *mPrev, *mNext = NULL;
 
 static  UINT64     DebugLevel;
 static  BOOLEAN    DebugMode;
@@ -1130,7 +1144,7 @@ Returns: (VOID)
 
 --*/
 {
-  STATIC UINT32 CPos;
+  STATIC THREAD_LOCAL UINT32 CPos;
 
   if ((mOutputMask >>= 1) == 0) {
     mOutputMask = 1U << (UINT8_BIT - 1);
@@ -1340,7 +1354,7 @@ Returns: (VOID)
 
 --*/
 {
-  STATIC INT32  Depth = 0;
+  STATIC THREAD_LOCAL INT32  Depth = 0;
 
   if (Index < mN) {
     mLenCnt[(Depth < 16) ? Depth : 16]++;
@@ -1642,6 +1656,207 @@ Returns:
   }
 }
 
+STATIC
+int
+ProcessBatchJob (
+  IN BATCH_JOB  *Job,
+  IN VOID       *Context
+  )
+/*++
+
+Routine Description:
+
+  Compresses or decompresses one file of a batch list. This runs on the
+  batch worker threads, so it reports failures through its return value
+  instead of calling Error().
+
+Arguments:
+
+  Job      - The input and output file names
+  Context  - Not used
+
+Returns:
+
+  0 on success, otherwise the error code that main() reports for the file
+
+--*/
+{
+  FILE          *File;
+  UINT8         *FileBuffer;
+  UINT8         *OutBuffer;
+  SCRATCH_DATA  *Scratch;
+  UINT32        InputLength;
+  UINT32        DstSize;
+  UINT32        CompSize;
+  UINT32        OrigSize;
+  EFI_STATUS    Status;
+  int           Result;
+
+  FileBuffer = NULL;
+  OutBuffer  = NULL;
+  Scratch    = NULL;
+  DstSize    = 0;
+  Result     = 0;
+
+  File = fopen (LongFilePath (Job->InputFile), "rb");
+  if (File == NULL) {
+    return 0001;
+  }
+  fseek (File, 0, SEEK_END);
+  InputLength = (UINT32) ftell (File);
+  fseek (File, 0, SEEK_SET);
+  FileBuffer = (UINT8 *) malloc (InputLength + 1);
+  if (FileBuffer == NULL) {
+    fclose (File);
+    return 4001;
+  }
+  if (InputLength > 0 && fread (FileBuffer, InputLength, 1, File) != 1) {
+    Result = 0004;
+  }
+  fclose (File);
+  if (Result != 0) {
+    goto Done;
+  }
+
+  if (ENCODE) {
+    if (UEFIMODE) {
+      Status = EfiCompress (FileBuffer, InputLength, OutBuffer, &DstSize);
+    } else {
+      Status = TianoCompress (FileBuffer, InputLength, OutBuffer, &DstSize);
+    }
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      OutBuffer = (UINT8 *) malloc (DstSize);
+      if (OutBuffer == NULL) {
+        Result = 4001;
+        goto Done;
+      }
+      if (UEFIMODE) {
+        Status = EfiCompress (FileBuffer, InputLength, OutBuffer, &DstSize);
+      } else {
+        Status = TianoCompress (FileBuffer, InputLength, OutBuffer, &DstSize);
+      }
+    }
+    if (Status != EFI_SUCCESS || OutBuffer == NULL) {
+      Result = 0007;
+      goto Done;
+    }
+  } else if (UEFIMODE) {
+    Status = Extract ((VOID *)FileBuffer, InputLength, (VOID *)&OutBuffer, &DstSize, 1);
+    if (Status != EFI_SUCCESS) {
+      Result = 3000;
+      goto Done;
+    }
+  } else {
+    if (InputLength < 8) {
+      Result = 3000;
+      goto Done;
+    }
+    OrigSize = FileBuffer[4] + (FileBuffer[5] << 8) + (FileBuffer[6] << 16) + (FileBuffer[7] << 24);
+    CompSize = FileBuffer[0] + (FileBuffer[1] << 8) + (FileBuffer[2] << 16) + (FileBuffer[3] << 24);
+    if (InputLength < CompSize + 8 || (CompSize + 8) < 8) {
+      Result = 3000;
+      goto Done;
+    }
+    Scratch   = (SCRATCH_DATA *) malloc (sizeof (SCRATCH_DATA));
+    OutBuffer = (UINT8 *) malloc (OrigSize + 1);
+    if (Scratch == NULL || OutBuffer == NULL) {
+      Result = 4001;
+      goto Done;
+    }
+    if (TDecompress ((VOID *)FileBuffer, (VOID *)OutBuffer, (VOID *)Scratch, 2) != EFI_SUCCESS) {
+      Result = 3000;
+      goto Done;
+    }
+    DstSize = Scratch->mOrigSize;
+  }
+
+  File = fopen (LongFilePath (Job->OutputFile), "wb");
+  if (File == NULL) {
+    Result = 0001;
+    goto Done;
+  }
+  if (DstSize > 0 && fwrite (OutBuffer, (size_t)DstSize, 1, File) != 1) {
+    Result = 0002;
+  }
+  fclose (File);
+
+Done:
+  if (FileBuffer != NULL) {
+    free (FileBuffer);
+  }
+  if (OutBuffer != NULL) {
+    free (OutBuffer);
+  }
+  if (Scratch != NULL) {
+    free (Scratch);
+  }
+  return Result;
+}
+
+STATIC
+EFI_STATUS
+RunBatch (
+  VOID
+  )
+/*++
+
+Routine Description:
+
+  Processes all files of the --batch list on the batch worker threads and
+  prints the size, ratio and time of each one.
+
+Arguments:
+
+  None
+
+Returns:
+
+  EFI_SUCCESS   - All files were processed
+  EFI_ABORTED   - The list could not be read or some files failed
+
+--*/
+{
+  BATCH_JOB  *Jobs;
+  size_t     JobCount;
+  size_t     Index;
+  size_t     Failed;
+  UINT64     Start;
+  int        Result;
+
+  Result = ReadBatchJobs (BatchListName, &Jobs, &JobCount);
+  if (Result < 0) {
+    Error (NULL, 0, 0001, "Error opening batch list file", BatchListName);
+    return EFI_ABORTED;
+  } else if (Result > 0) {
+    Error (BatchListName, Result, 2000, "Invalid parameter", "Each line must hold an input and an output file name");
+    return EFI_ABORTED;
+  }
+
+  //
+  // The EFI compressor and decompressor in the common library keep their
+  // state in globals, so --uefi batches run on a single thread.
+  //
+  if (UEFIMODE) {
+    BatchThreads = 1;
+  }
+
+  VerboseMsg ("Processing %u files of %s", (unsigned) JobCount, BatchListName);
+  Start  = GetBatchTimeStamp ();
+  Failed = RunBatchJobs (Jobs, JobCount, (unsigned) BatchThreads, ProcessBatchJob, NULL);
+  if (!QuietMode) {
+    PrintBatchJobReport (Jobs, JobCount, GetBatchTimeStamp () - Start);
+  }
+
+  for (Index = 0; Index < JobCount; Index++) {
+    if (Jobs[Index].Status != 0) {
+      Error (NULL, 0, Jobs[Index].Status, ENCODE ? "Error compressing file" : "Error decompressing file", Jobs[Index].InputFile);
+    }
+  }
+  FreeBatchJobs (Jobs, JobCount);
+
+  return Failed == 0 ? EFI_SUCCESS : EFI_ABORTED;
+}
+
 VOID
 Version (
   VOID
@@ -1688,7 +1903,8 @@ Returns:
   //
   // Summary usage
   //
-  fprintf (stdout, "Usage: %s -e|-d [options] <input_file>\n\n", UTILITY_NAME);
+  fprintf (stdout, "Usage: %s -e|-d [options] <input_file>\n", UTILITY_NAME);
+  fprintf (stdout, "       %s -e|-d [options] --batch <list_file>\n\n", UTILITY_NAME);
 
   //
   // Copyright declaration
@@ -1703,6 +1919,12 @@ Returns:
             Enable UefiCompress, use TianoCompress when without this option\n");
   fprintf (stdout, "  -o FileName, --output FileName\n\
             File will be created to store the output content.\n");
+  fprintf (stdout, "  --batch ListFile\n\
+            Process all files listed in ListFile, one \"input output\"\n\
+            pair per line, and report the ratio and time of each file.\n");
+  fprintf (stdout, "  --threads Number\n\
+            Number of files processed at the same time in batch mode,\n\
+            one per processor by default.\n");
   fprintf (stdout, "  -v, --verbose\n\
            Turn on verbose output with informational messages.\n");
   fprintf (stdout, "  -q, --quiet\n\
@@ -1864,6 +2086,27 @@ Returns:
       continue;
     }
 
+    if (stricmp (argv[0], "--batch") == 0) {
+      if (argv[1] == NULL || argv[1][0] == '-') {
+        Error (NULL, 0, 1003, "Invalid option value", "Batch list file name is missing for --batch option");
+        goto ERROR;
+      }
+      BatchListName = argv[1];
+      argc -=2;
+      argv +=2;
+      continue;
+    }
+
+    if (stricmp (argv[0], "--threads") == 0) {
+      if (argv[1] == NULL || EFI_ERROR (AsciiStringToUint64 (argv[1], FALSE, &BatchThreads)) || BatchThreads == 0) {
+        Error (NULL, 0, 1003, "Invalid option value", "%s = %s", argv[0], argv[1]);
+        goto ERROR;
+      }
+      argc -=2;
+      argv +=2;
+      continue;
+    }
+
     if (argv[0][0]!='-') {
       InputFileName = argv[0];
       argc--;
@@ -1875,7 +2118,12 @@ Returns:
     goto ERROR;
   }
 
-  if (InputFileName == NULL) {
+  if (BatchListName != NULL) {
+    if (InputFileName != NULL || OutputFileName != NULL) {
+      Error (NULL, 0, 1000, "Invalid option", "--batch cannot be combined with an input file or -o");
+      goto ERROR;
+    }
+  } else if (InputFileName == NULL) {
     Error (NULL, 0, 1001, "Missing options", "No input files specified.");
     goto ERROR;
   }
@@ -1894,6 +2142,17 @@ Returns:
   if (VerboseMode) {
     VerboseMsg("%s tool start.\n", UTILITY_NAME);
    }
+
+  if (BatchListName != NULL) {
+    if (EFI_ERROR (RunBatch ())) {
+      goto ERROR;
+    }
+    if (VerboseMode) {
+      VerboseMsg ("Batch successful\n");
+    }
+    return 0;
+  }
+
   Scratch = (SCRATCH_DATA *)malloc(sizeof(SCRATCH_DATA));
   if (Scratch == NULL) {
     Error (NULL, 0, 4001, "Resource:", "Memory cannot be allocated!");
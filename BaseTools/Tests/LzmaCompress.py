@@ -0,0 +1,81 @@
+## @file
+# Unit tests for LzmaCompress utility
+#
+#  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+#
+#  SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+##
+# Import Modules
+#
+from __future__ import print_function
+import os
+import random
+import sys
+import unittest
+
+import TestTools
+
+class Tests(TestTools.BaseToolsTest):
+
+    def setUp(self):
+        TestTools.BaseToolsTest.setUp(self)
+        self.toolName = 'LzmaCompress'
+
+    def testHelp(self):
+        result = self.RunTool('--help', logFile='help')
+        #self.DisplayFile('help')
+        self.assertTrue(result == 0)
+
+    def compressionTestCycle(self, data, threads):
+        self.WriteTmpFile('input', data)
+        result = self.RunTool(
+            '-e', '-q',
+            '--threads', threads,
+            '-o', self.GetTmpFilePath('output1'),
+            self.GetTmpFilePath('input')
+            )
+        self.assertTrue(result == 0)
+        result = self.RunTool(
+            '-d', '-q',
+            '-o', self.GetTmpFilePath('output2'),
+            self.GetTmpFilePath('output1')
+            )
+        self.assertTrue(result == 0)
+        start = self.ReadTmpFile('input')
+        finish = self.ReadTmpFile('output2')
+        startEqualsFinish = start == finish
+        if not startEqualsFinish:
+            print()
+            print('Original data did not match decompress(compress(data))')
+            self.DisplayBinaryData('original data', start)
+            self.DisplayBinaryData('after compression', self.ReadTmpFile('output1'))
+            self.DisplayBinaryData('after decompression', finish)
+        self.assertTrue(startEqualsFinish)
+        with open(self.GetTmpFilePath('output1'), 'rb') as f:
+            return f.read()
+
+    def testRandomDataCycles(self):
+        for i in range(8):
+            data = self.GetRandomString(1024, 2048)
+            self.compressionTestCycle(data, '1')
+            self.compressionTestCycle(data, '2')
+            self.CleanUpTmpDir()
+
+    def testThreadedOutputMatches(self):
+        #
+        # Repeat random chunks so the match finder runs over many blocks
+        # and finds long matches far apart.
+        #
+        chunks = [self.GetRandomString(256, 4096) for i in range(64)]
+        data = ''.join(random.choice(chunks) for i in range(512))
+        singleThreaded = self.compressionTestCycle(data, '1')
+        multiThreaded = self.compressionTestCycle(data, '2')
+        self.assertTrue(singleThreaded == multiThreaded)
+
+TheTestSuite = TestTools.MakeTheTestSuite(locals())
+
+if __name__ == '__main__':
+    allTests = TheTestSuite()
+    unittest.TextTestRunner().run(allTests)
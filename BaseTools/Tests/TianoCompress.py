@@ -60,6 +60,47 @@ class Tests(TestTools.BaseToolsTest):
             self.compressionTestCycle(data)
             self.CleanUpTmpDir()
 
+    def testBatch(self):
+        count = 6
+        compressList = []
+        decompressList = []
+        for i in range(count):
+            self.WriteTmpFile('input%d' % i, self.GetRandomString(1024, 65536))
+            compressList.append('%s %s' % (
+                self.GetTmpFilePath('input%d' % i),
+                self.GetTmpFilePath('batch%d' % i)))
+            decompressList.append('%s "%s"' % (
+                self.GetTmpFilePath('batch%d' % i),
+                self.GetTmpFilePath('output %d' % i)))
+        self.WriteTmpFile('compress.lst', '\n'.join(compressList) + '\n')
+        self.WriteTmpFile('decompress.lst', '\n'.join(decompressList) + '\n')
+
+        result = self.RunTool(
+            '-e', '--batch', self.GetTmpFilePath('compress.lst'),
+            '--threads', '4',
+            logFile='batch'
+            )
+        self.assertTrue(result == 0)
+        result = self.RunTool(
+            '-d', '--batch', self.GetTmpFilePath('decompress.lst'),
+            logFile='batch'
+            )
+        self.assertTrue(result == 0)
+
+        for i in range(count):
+            result = self.RunTool(
+                '-e',
+                '-o', self.GetTmpFilePath('single%d' % i),
+                self.GetTmpFilePath('input%d' % i)
+                )
+            self.assertTrue(result == 0)
+            batch = self.OpenTmpFile('batch%d' % i, 'rb').read()
+            single = self.OpenTmpFile('single%d' % i, 'rb').read()
+            self.assertTrue(batch == single)
+            self.assertTrue(
+                self.ReadTmpFile('input%d' % i) ==
+                self.ReadTmpFile('output %d' % i))
+
 TheTestSuite = TestTools.MakeTheTestSuite(locals())
 
 if __name__ == '__main__':
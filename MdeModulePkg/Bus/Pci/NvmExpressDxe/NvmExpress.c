@@ -527,6 +527,53 @@ UnregisterNvmeNamespace (
   return EFI_SUCCESS;
 }
 
+/**
+  Adjust the period of the timer processing the asynchronous I/O queues to their depth.
+
+  The timer fires at NVME_HC_ASYNC_TIMER_IDLE when no asynchronous command is outstanding,
+  at NVME_HC_ASYNC_TIMER_MIN when the queues are more than half full or when subtasks wait
+  for a free submission queue entry, and at NVME_HC_ASYNC_TIMER otherwise.
+
+  The caller should be at TPL_NOTIFY so that the state of the queues doesn't change.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+**/
+VOID
+NvmeUpdateAsyncTimer (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  )
+{
+  UINT16  QueueId;
+  UINT16  QueueSize;
+  UINTN   Outstanding;
+  UINT64  TimerPeriod;
+
+  if (!IsListEmpty (&Private->UnsubmittedSubtasks)) {
+    TimerPeriod = NVME_HC_ASYNC_TIMER_MIN;
+  } else if (IsListEmpty (&Private->AsyncPassThruQueue)) {
+    TimerPeriod = NVME_HC_ASYNC_TIMER_IDLE;
+  } else {
+    QueueSize   = MIN (NVME_ASYNC_CSQ_SIZE, Private->Cap.Mqes) + 1;
+    Outstanding = 0;
+    for (QueueId = NVME_ASYNC_QUEUE_BASE; QueueId < NVME_ASYNC_QUEUE_BASE + Private->AsyncQueueCount; QueueId++) {
+      Outstanding += (Private->SqTdbl[QueueId].Sqt + QueueSize - Private->AsyncSqHead[QueueId]) % QueueSize;
+    }
+
+    if (Outstanding * 2 > (UINTN)(QueueSize - 1) * Private->AsyncQueueCount) {
+      TimerPeriod = NVME_HC_ASYNC_TIMER_MIN;
+    } else {
+      TimerPeriod = NVME_HC_ASYNC_TIMER;
+    }
+  }
+
+  if (TimerPeriod != Private->TimerPeriod) {
+    if (!EFI_ERROR (gBS->SetTimer (Private->TimerEvent, TimerPeriodic, TimerPeriod))) {
+      Private->TimerPeriod = TimerPeriod;
+    }
+  }
+}
+
 /**
   Call back function when the timer event is signaled.
 
@@ -556,11 +603,8 @@ ProcessAsyncTaskList (
   BOOLEAN                       HasNewItem;
   EFI_STATUS                    Status;
 
-  Private    = (NVME_CONTROLLER_PRIVATE_DATA *)Context;
-  QueueId    = 2;
-  Cq         = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
-  HasNewItem = FALSE;
-  PciIo      = Private->PciIo;
+  Private = (NVME_CONTROLLER_PRIVATE_DATA *)Context;
+  PciIo   = Private->PciIo;
 
   //
   // Submit asynchronous subtasks to the NVMe Submission Queue
@@ -636,86 +680,99 @@ ProcessAsyncTaskList (
     }
   }
 
-  while (Cq->Pt != Private->Pt[QueueId]) {
-    ASSERT (Cq->Sqid == QueueId);
+  //
+  // Reap the completions of all the asynchronous I/O queues.
+  //
+  for (QueueId = NVME_ASYNC_QUEUE_BASE; QueueId < NVME_ASYNC_QUEUE_BASE + Private->AsyncQueueCount; QueueId++) {
+    Cq         = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
+    HasNewItem = FALSE;
 
-    HasNewItem = TRUE;
+    while (Cq->Pt != Private->Pt[QueueId]) {
+      ASSERT (Cq->Sqid == QueueId);
 
-    //
-    // Find the command with given Command Id.
-    //
-    for (Link = GetFirstNode (&Private->AsyncPassThruQueue);
-         !IsNull (&Private->AsyncPassThruQueue, Link);
-         Link = NextLink)
-    {
-      NextLink     = GetNextNode (&Private->AsyncPassThruQueue, Link);
-      AsyncRequest = NVME_PASS_THRU_ASYNC_REQ_FROM_THIS (Link);
-      if (AsyncRequest->CommandId == Cq->Cid) {
-        //
-        // Copy the Respose Queue entry for this command to the callers
-        // response buffer.
-        //
-        CopyMem (
-          AsyncRequest->Packet->NvmeCompletion,
-          Cq,
-          sizeof (EFI_NVM_EXPRESS_COMPLETION)
-          );
+      HasNewItem = TRUE;
 
-        //
-        // Free the resources allocated before cmd submission
-        //
-        if (AsyncRequest->MapData != NULL) {
-          PciIo->Unmap (PciIo, AsyncRequest->MapData);
+      //
+      // Find the command with given Command Id.
+      //
+      for (Link = GetFirstNode (&Private->AsyncPassThruQueue);
+           !IsNull (&Private->AsyncPassThruQueue, Link);
+           Link = NextLink)
+      {
+        NextLink     = GetNextNode (&Private->AsyncPassThruQueue, Link);
+        AsyncRequest = NVME_PASS_THRU_ASYNC_REQ_FROM_THIS (Link);
+        if ((AsyncRequest->QueueId == QueueId) && (AsyncRequest->CommandId == Cq->Cid)) {
+          //
+          // Copy the Respose Queue entry for this command to the callers
+          // response buffer.
+          //
+          CopyMem (
+            AsyncRequest->Packet->NvmeCompletion,
+            Cq,
+            sizeof (EFI_NVM_EXPRESS_COMPLETION)
+            );
+
+          //
+          // Free the resources allocated before cmd submission
+          //
+          if (AsyncRequest->MapData != NULL) {
+            PciIo->Unmap (PciIo, AsyncRequest->MapData);
+          }
+
+          if (AsyncRequest->MapMeta != NULL) {
+            PciIo->Unmap (PciIo, AsyncRequest->MapMeta);
+          }
+
+          if (AsyncRequest->MapPrpList != NULL) {
+            PciIo->Unmap (PciIo, AsyncRequest->MapPrpList);
+          }
+
+          if (AsyncRequest->PrpListHost != NULL) {
+            PciIo->FreeBuffer (
+                     PciIo,
+                     AsyncRequest->PrpListNo,
+                     AsyncRequest->PrpListHost
+                     );
+          }
+
+          RemoveEntryList (Link);
+          gBS->SignalEvent (AsyncRequest->CallerEvent);
+          FreePool (AsyncRequest);
+
+          //
+          // Update submission queue head.
+          //
+          Private->AsyncSqHead[QueueId] = Cq->Sqhd;
+          break;
         }
+      }
 
-        if (AsyncRequest->MapMeta != NULL) {
-          PciIo->Unmap (PciIo, AsyncRequest->MapMeta);
-        }
+      Private->CqHdbl[QueueId].Cqh++;
+      if (Private->CqHdbl[QueueId].Cqh > MIN (NVME_ASYNC_CCQ_SIZE, Private->Cap.Mqes)) {
+        Private->CqHdbl[QueueId].Cqh = 0;
+        Private->Pt[QueueId]        ^= 1;
+      }
 
-        if (AsyncRequest->MapPrpList != NULL) {
-          PciIo->Unmap (PciIo, AsyncRequest->MapPrpList);
-        }
+      Cq = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
+    }
 
-        if (AsyncRequest->PrpListHost != NULL) {
-          PciIo->FreeBuffer (
+    if (HasNewItem) {
+      Data = ReadUnaligned32 ((UINT32 *)&Private->CqHdbl[QueueId]);
+      PciIo->Mem.Write (
                    PciIo,
-                   AsyncRequest->PrpListNo,
-                   AsyncRequest->PrpListHost
+                   EfiPciIoWidthUint32,
+                   NVME_BAR,
+                   NVME_CQHDBL_OFFSET (QueueId, Private->Cap.Dstrd),
+                   1,
+                   &Data
                    );
-        }
-
-        RemoveEntryList (Link);
-        gBS->SignalEvent (AsyncRequest->CallerEvent);
-        FreePool (AsyncRequest);
-
-        //
-        // Update submission queue head.
-        //
-        Private->AsyncSqHead = Cq->Sqhd;
-        break;
-      }
-    }
-
-    Private->CqHdbl[QueueId].Cqh++;
-    if (Private->CqHdbl[QueueId].Cqh > MIN (NVME_ASYNC_CCQ_SIZE, Private->Cap.Mqes)) {
-      Private->CqHdbl[QueueId].Cqh = 0;
-      Private->Pt[QueueId]        ^= 1;
     }
-
-    Cq = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
   }
 
-  if (HasNewItem) {
-    Data = ReadUnaligned32 ((UINT32 *)&Private->CqHdbl[QueueId]);
-    PciIo->Mem.Write (
-                 PciIo,
-                 EfiPciIoWidthUint32,
-                 NVME_BAR,
-                 NVME_CQHDBL_OFFSET (QueueId, Private->Cap.Dstrd),
-                 1,
-                 &Data
-                 );
-  }
+  //
+  // Poll faster when the queues get deeper, and slower when they are idle.
+  //
+  NvmeUpdateAsyncTimer (Private);
 }
 
 /**
@@ -1016,7 +1073,7 @@ NvmExpressDriverBindingStart (
                       PciIo,
                       AllocateAnyPages,
                       EfiBootServicesData,
-                      6,
+                      NVME_QUEUE_BUFFER_PAGES,
                       (VOID **)&Private->Buffer,
                       0
                       );
@@ -1024,7 +1081,7 @@ NvmExpressDriverBindingStart (
       goto Exit;
     }
 
-    Bytes  = EFI_PAGES_TO_SIZE (6);
+    Bytes  = EFI_PAGES_TO_SIZE (NVME_QUEUE_BUFFER_PAGES);
     Status = PciIo->Map (
                       PciIo,
                       EfiPciIoOperationBusMasterCommonBuffer,
@@ -1034,7 +1091,7 @@ NvmExpressDriverBindingStart (
                       &Private->Mapping
                       );
 
-    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (6))) {
+    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (NVME_QUEUE_BUFFER_PAGES))) {
       goto Exit;
     }
 
@@ -1077,12 +1134,14 @@ NvmExpressDriverBindingStart (
     Status = gBS->SetTimer (
                     Private->TimerEvent,
                     TimerPeriodic,
-                    NVME_HC_ASYNC_TIMER
+                    NVME_HC_ASYNC_TIMER_IDLE
                     );
     if (EFI_ERROR (Status)) {
       goto Exit;
     }
 
+    Private->TimerPeriod = NVME_HC_ASYNC_TIMER_IDLE;
+
     Status = gBS->InstallMultipleProtocolInterfaces (
                     &Controller,
                     &gEfiNvmExpressPassThruProtocolGuid,
@@ -1144,7 +1203,7 @@ Exit:
   }
 
   if ((Private != NULL) && (Private->Buffer != NULL)) {
-    PciIo->FreeBuffer (PciIo, 6, Private->Buffer);
+    PciIo->FreeBuffer (PciIo, NVME_QUEUE_BUFFER_PAGES, Private->Buffer);
   }
 
   if ((Private != NULL) && (Private->ControllerData != NULL)) {
@@ -1266,7 +1325,7 @@ NvmExpressDriverBindingStop (
       }
 
       if (Private->Buffer != NULL) {
-        Private->PciIo->FreeBuffer (Private->PciIo, 6, Private->Buffer);
+        Private->PciIo->FreeBuffer (Private->PciIo, NVME_QUEUE_BUFFER_PAGES, Private->Buffer);
       }
 
       FreePool (Private->ControllerData);
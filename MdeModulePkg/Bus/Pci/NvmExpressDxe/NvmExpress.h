@@ -37,6 +37,7 @@
 #include <Library/UefiLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/ReportStatusCodeLib.h>
@@ -59,8 +60,16 @@ extern EFI_DRIVER_SUPPORTED_EFI_VERSION_PROTOCOL  gNvmExpressDriverSupportedEfiV
 #define NVME_ASQ_SIZE  1                                // Number of admin submission queue entries, which is 0-based
 #define NVME_ACQ_SIZE  1                                // Number of admin completion queue entries, which is 0-based
 
-#define NVME_CSQ_SIZE  1                                // Number of I/O submission queue entries, which is 0-based
-#define NVME_CCQ_SIZE  1                                // Number of I/O completion queue entries, which is 0-based
+//
+// Number of synchronous I/O submission queue entries, which is 0-based.
+// The synchronous I/O submission queue size is 4kB in total.
+//
+#define NVME_CSQ_SIZE  63
+//
+// Number of synchronous I/O completion queue entries, which is 0-based.
+// It matches the submission queue so that a completion entry is free for every command in flight.
+//
+#define NVME_CCQ_SIZE  63
 
 //
 // Number of asynchronous I/O submission queue entries, which is 0-based.
@@ -73,7 +82,27 @@ extern EFI_DRIVER_SUPPORTED_EFI_VERSION_PROTOCOL  gNvmExpressDriverSupportedEfiV
 //
 #define NVME_ASYNC_CCQ_SIZE  255
 
-#define NVME_MAX_QUEUES  3                              // Number of queues supported by the driver
+//
+// Maximum number of asynchronous I/O queue pairs supported by the driver.
+// The asynchronous I/O queues take the queue IDs starting from NVME_ASYNC_QUEUE_BASE.
+//
+#define NVME_MAX_ASYNC_QUEUES  8
+#define NVME_ASYNC_QUEUE_BASE  2
+
+//
+// Number of queues supported by the driver.
+//
+#define NVME_MAX_QUEUES  (NVME_ASYNC_QUEUE_BASE + NVME_MAX_ASYNC_QUEUES)
+
+//
+// Number of 4kB pages of the buffer holding the submission and completion queues.
+//
+#define NVME_QUEUE_BUFFER_PAGES  (2 * NVME_MAX_QUEUES)
+
+//
+// Feature Identifier of the Number of Queues feature.
+//
+#define NVME_FEATURE_NUMBER_OF_QUEUES  0x07
 
 #define NVME_CONTROLLER_ID  0
 
@@ -86,6 +115,15 @@ extern EFI_DRIVER_SUPPORTED_EFI_VERSION_PROTOCOL  gNvmExpressDriverSupportedEfiV
 // Nvme async transfer timer interval, set by experience.
 //
 #define NVME_HC_ASYNC_TIMER  EFI_TIMER_PERIOD_MILLISECONDS (1)
+//
+// Nvme async transfer timer interval when the asynchronous I/O queues are more than half full,
+// or when subtasks wait for a free submission queue entry.
+//
+#define NVME_HC_ASYNC_TIMER_MIN  EFI_TIMER_PERIOD_MICROSECONDS (100)
+//
+// Nvme async transfer timer interval when no asynchronous command is outstanding.
+//
+#define NVME_HC_ASYNC_TIMER_IDLE  EFI_TIMER_PERIOD_MILLISECONDS (10)
 
 //
 // Unique signature for private data structure.
@@ -116,13 +154,13 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   NVME_ADMIN_CONTROLLER_DATA            *ControllerData;
 
   //
-  // 6 x 4kB aligned buffers will be carved out of this buffer.
+  // NVME_QUEUE_BUFFER_PAGES x 4kB aligned buffers will be carved out of this buffer.
   // 1st 4kB boundary is the start of the admin submission queue.
   // 2nd 4kB boundary is the start of the admin completion queue.
   // 3rd 4kB boundary is the start of I/O submission queue #1.
   // 4th 4kB boundary is the start of I/O completion queue #1.
-  // 5th 4kB boundary is the start of I/O submission queue #2.
-  // 6th 4kB boundary is the start of I/O completion queue #2.
+  // The (2n+1)th and (2n+2)th 4kB boundaries are the start of I/O submission queue #n
+  // and I/O completion queue #n, for the asynchronous I/O queues.
   //
   UINT8          *Buffer;
   UINT8          *BufferPciAddr;
@@ -140,7 +178,12 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   //
   NVME_SQTDBL    SqTdbl[NVME_MAX_QUEUES];
   NVME_CQHDBL    CqHdbl[NVME_MAX_QUEUES];
-  UINT16         AsyncSqHead;
+  UINT16         AsyncSqHead[NVME_MAX_QUEUES];
+
+  //
+  // Number of asynchronous I/O queue pairs created on the controller.
+  //
+  UINT16         AsyncQueueCount;
 
   //
   // Flag to indicate internal IO queue creation.
@@ -161,6 +204,7 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   // For Non-blocking operations.
   //
   EFI_EVENT      TimerEvent;
+  UINT64         TimerPeriod;
   LIST_ENTRY     AsyncPassThruQueue;
   LIST_ENTRY     UnsubmittedSubtasks;
 };
@@ -291,6 +335,7 @@ typedef struct {
   LIST_ENTRY                                  Link;
 
   EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET    *Packet;
+  UINT16                                      QueueId;
   UINT16                                      CommandId;
   VOID                                        *MapPrpList;
   UINTN                                       PrpListNo;
@@ -721,6 +766,55 @@ NvmeDumpStatus (
   IN NVME_CQ  *Cq
   );
 
+/**
+  Read or write the blocks of a namespace by splitting the transfer into commands that are
+  in flight together on the synchronous I/O queue.
+
+  The commands are submitted with a single doorbell write per batch and their completions are
+  reaped together. The PRP lists of the commands are carved out of a pool allocated once for
+  the transfer.
+
+  @param[in]  Device             The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param[in]  IsRead             TRUE to read the blocks, FALSE to write them.
+  @param[in]  Buffer             The buffer of the data.
+  @param[in]  Lba                The start block number.
+  @param[in]  Blocks             Total block number to be transferred.
+  @param[in]  MaxTransferBlocks  The maximum block number of a command.
+
+  @retval EFI_SUCCESS            Datum are transferred.
+  @retval EFI_UNSUPPORTED        The transfer cannot be split into concurrent commands. Nothing is
+                                 transferred, the caller should send the commands one at a time.
+  @retval EFI_TIMEOUT            A command timed out and the controller has been reset.
+  @retval Others                 Fail to transfer all the datum.
+
+**/
+EFI_STATUS
+NvmeSyncIoQueueTransfer (
+  IN NVME_DEVICE_PRIVATE_DATA  *Device,
+  IN BOOLEAN                   IsRead,
+  IN VOID                      *Buffer,
+  IN UINT64                    Lba,
+  IN UINTN                     Blocks,
+  IN UINT32                    MaxTransferBlocks
+  );
+
+/**
+  Adjust the period of the timer processing the asynchronous I/O queues to their depth.
+
+  The timer fires at NVME_HC_ASYNC_TIMER_IDLE when no asynchronous command is outstanding,
+  at NVME_HC_ASYNC_TIMER_MIN when the queues are more than half full or when subtasks wait
+  for a free submission queue entry, and at NVME_HC_ASYNC_TIMER otherwise.
+
+  The caller should be at TPL_NOTIFY so that the state of the queues doesn't change.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+**/
+VOID
+NvmeUpdateAsyncTimer (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  );
+
 /**
   Register the shutdown notification through the ResetNotification protocol.
 
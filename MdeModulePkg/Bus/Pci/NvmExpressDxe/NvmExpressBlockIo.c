@@ -195,7 +195,20 @@ NvmeRead (
     MaxTransferBlocks = 1024;
   }
 
-  while (Blocks > 0) {
+  //
+  // Keep several commands in flight when the transfer needs more than one command,
+  // and fall back to sending them one at a time when it cannot be done.
+  //
+  if (Blocks > MaxTransferBlocks) {
+    Status = NvmeSyncIoQueueTransfer (Device, TRUE, Buffer, Lba, Blocks, MaxTransferBlocks);
+    if (Status == EFI_UNSUPPORTED) {
+      Status = EFI_SUCCESS;
+    } else if (!EFI_ERROR (Status)) {
+      Blocks = 0;
+    }
+  }
+
+  while ((Blocks > 0) && !EFI_ERROR (Status)) {
     if (Blocks > MaxTransferBlocks) {
       Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
 
@@ -281,7 +294,20 @@ NvmeWrite (
     MaxTransferBlocks = 1024;
   }
 
-  while (Blocks > 0) {
+  //
+  // Keep several commands in flight when the transfer needs more than one command,
+  // and fall back to sending them one at a time when it cannot be done.
+  //
+  if (Blocks > MaxTransferBlocks) {
+    Status = NvmeSyncIoQueueTransfer (Device, FALSE, Buffer, Lba, Blocks, MaxTransferBlocks);
+    if (Status == EFI_UNSUPPORTED) {
+      Status = EFI_SUCCESS;
+    } else if (!EFI_ERROR (Status)) {
+      Blocks = 0;
+    }
+  }
+
+  while ((Blocks > 0) && !EFI_ERROR (Status)) {
     if (Blocks > MaxTransferBlocks) {
       Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
 
@@ -528,6 +554,10 @@ AsyncReadSectors (
   OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
   InsertTailList (&Private->UnsubmittedSubtasks, &Subtask->Link);
   Request->UnsubmittedSubtaskNum++;
+  //
+  // Wake up the timer from the idle period to submit the subtask.
+  //
+  NvmeUpdateAsyncTimer (Private);
   gBS->RestoreTPL (OldTpl);
 
   return EFI_SUCCESS;
@@ -670,6 +700,10 @@ AsyncWriteSectors (
   OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
   InsertTailList (&Private->UnsubmittedSubtasks, &Subtask->Link);
   Request->UnsubmittedSubtaskNum++;
+  //
+  // Wake up the timer from the idle period to submit the subtask.
+  //
+  NvmeUpdateAsyncTimer (Private);
   gBS->RestoreTPL (OldTpl);
 
   return EFI_SUCCESS;
@@ -558,6 +558,76 @@ NvmeIdentifyNamespace (
   return Status;
 }
 
+/**
+  Request the number of I/O queues from the controller, and set the number of asynchronous
+  I/O queue pairs to create from what the controller allocates.
+
+  One I/O queue pair is for blocking I/O, the others are for non-blocking I/O. At least one
+  asynchronous I/O queue pair is used even if the request fails, as the controller may not
+  support the Number of Queues feature.
+
+  @param  Private          The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @return EFI_SUCCESS      Successfully set the number of queues.
+  @return EFI_DEVICE_ERROR Fail to set the number of queues.
+
+**/
+EFI_STATUS
+NvmeSetNumberOfQueues (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  )
+{
+  EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET  CommandPacket;
+  EFI_NVM_EXPRESS_COMMAND                   Command;
+  EFI_NVM_EXPRESS_COMPLETION                Completion;
+  EFI_STATUS                                Status;
+  UINT16                                    AsyncQueueCount;
+  UINT16                                    Allocated;
+
+  AsyncQueueCount = (UINT16)MIN (PcdGet8 (PcdNvmeAsyncIoQueuePairs), NVME_MAX_ASYNC_QUEUES);
+  AsyncQueueCount = (UINT16)MAX (AsyncQueueCount, 1);
+
+  ZeroMem (&CommandPacket, sizeof (EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET));
+  ZeroMem (&Command, sizeof (EFI_NVM_EXPRESS_COMMAND));
+  ZeroMem (&Completion, sizeof (EFI_NVM_EXPRESS_COMPLETION));
+
+  Command.Cdw0.Opcode = NVME_ADMIN_SET_FEATURES_CMD;
+  Command.Nsid        = 0;
+
+  CommandPacket.NvmeCmd        = &Command;
+  CommandPacket.NvmeCompletion = &Completion;
+  CommandPacket.CommandTimeout = NVME_GENERIC_TIMEOUT;
+  CommandPacket.QueueType      = NVME_ADMIN_QUEUE;
+  //
+  // The numbers of I/O submission and completion queues requested are 0-based.
+  //
+  Command.Cdw10 = NVME_FEATURE_NUMBER_OF_QUEUES;
+  Command.Cdw11 = ((UINT32)AsyncQueueCount << 16) | AsyncQueueCount;
+  Command.Flags = CDW10_VALID | CDW11_VALID;
+
+  Status = Private->Passthru.PassThru (
+                               &Private->Passthru,
+                               NVME_CONTROLLER_ID,
+                               &CommandPacket,
+                               NULL
+                               );
+  if (!EFI_ERROR (Status)) {
+    //
+    // The numbers of I/O submission and completion queues allocated are 0-based.
+    //
+    Allocated       = (UINT16)MIN (Completion.DW0 & 0xFFFF, Completion.DW0 >> 16);
+    AsyncQueueCount = (UINT16)MIN (AsyncQueueCount, Allocated);
+    AsyncQueueCount = (UINT16)MAX (AsyncQueueCount, 1);
+  } else {
+    AsyncQueueCount = 1;
+  }
+
+  Private->AsyncQueueCount = AsyncQueueCount;
+  DEBUG ((DEBUG_INFO, "NvmeSetNumberOfQueues: %d asynchronous I/O queue pairs, Status = %r\n", AsyncQueueCount, Status));
+
+  return Status;
+}
+
 /**
   Create io completion queue.
 
@@ -583,7 +653,7 @@ NvmeCreateIoCompletionQueue (
   Status                 = EFI_SUCCESS;
   Private->CreateIoQueue = TRUE;
 
-  for (Index = 1; Index < NVME_MAX_QUEUES; Index++) {
+  for (Index = 1; Index < NVME_ASYNC_QUEUE_BASE + Private->AsyncQueueCount; Index++) {
     ZeroMem (&CommandPacket, sizeof (EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET));
     ZeroMem (&Command, sizeof (EFI_NVM_EXPRESS_COMMAND));
     ZeroMem (&Completion, sizeof (EFI_NVM_EXPRESS_COMPLETION));
@@ -599,7 +669,11 @@ NvmeCreateIoCompletionQueue (
     CommandPacket.QueueType      = NVME_ADMIN_QUEUE;
 
     if (Index == 1) {
-      QueueSize = NVME_CCQ_SIZE;
+      if (Private->Cap.Mqes > NVME_CCQ_SIZE) {
+        QueueSize = NVME_CCQ_SIZE;
+      } else {
+        QueueSize = Private->Cap.Mqes;
+      }
     } else {
       if (Private->Cap.Mqes > NVME_ASYNC_CCQ_SIZE) {
         QueueSize = NVME_ASYNC_CCQ_SIZE;
@@ -655,7 +729,7 @@ NvmeCreateIoSubmissionQueue (
   Status                 = EFI_SUCCESS;
   Private->CreateIoQueue = TRUE;
 
-  for (Index = 1; Index < NVME_MAX_QUEUES; Index++) {
+  for (Index = 1; Index < NVME_ASYNC_QUEUE_BASE + Private->AsyncQueueCount; Index++) {
     ZeroMem (&CommandPacket, sizeof (EFI_NVM_EXPRESS_PASS_THRU_COMMAND_PACKET));
     ZeroMem (&Command, sizeof (EFI_NVM_EXPRESS_COMMAND));
     ZeroMem (&Completion, sizeof (EFI_NVM_EXPRESS_COMPLETION));
@@ -671,7 +745,11 @@ NvmeCreateIoSubmissionQueue (
     CommandPacket.QueueType      = NVME_ADMIN_QUEUE;
 
     if (Index == 1) {
-      QueueSize = NVME_CSQ_SIZE;
+      if (Private->Cap.Mqes > NVME_CSQ_SIZE) {
+        QueueSize = NVME_CSQ_SIZE;
+      } else {
+        QueueSize = Private->Cap.Mqes;
+      }
     } else {
       if (Private->Cap.Mqes > NVME_ASYNC_CSQ_SIZE) {
         QueueSize = NVME_ASYNC_CSQ_SIZE;
@@ -726,6 +804,7 @@ NvmeControllerInit (
   NVME_ACQ             Acq;
   UINT8                Sn[21];
   UINT8                Mn[41];
+  UINTN                Index;
 
   //
   // Enable this controller.
@@ -771,19 +850,13 @@ NvmeControllerInit (
   //
   ASSERT ((Private->Cap.Mpsmin + 12) <= EFI_PAGE_SHIFT);
 
-  Private->Cid[0]        = 0;
-  Private->Cid[1]        = 0;
-  Private->Cid[2]        = 0;
-  Private->Pt[0]         = 0;
-  Private->Pt[1]         = 0;
-  Private->Pt[2]         = 0;
-  Private->SqTdbl[0].Sqt = 0;
-  Private->SqTdbl[1].Sqt = 0;
-  Private->SqTdbl[2].Sqt = 0;
-  Private->CqHdbl[0].Cqh = 0;
-  Private->CqHdbl[1].Cqh = 0;
-  Private->CqHdbl[2].Cqh = 0;
-  Private->AsyncSqHead   = 0;
+  for (Index = 0; Index < NVME_MAX_QUEUES; Index++) {
+    Private->Cid[Index]         = 0;
+    Private->Pt[Index]          = 0;
+    Private->SqTdbl[Index].Sqt  = 0;
+    Private->CqHdbl[Index].Cqh  = 0;
+    Private->AsyncSqHead[Index] = 0;
+  }
 
   Status = NvmeDisableController (Private);
 
@@ -812,19 +885,13 @@ NvmeControllerInit (
   //
   // Address of I/O submission & completion queue.
   //
-  ZeroMem (Private->Buffer, EFI_PAGES_TO_SIZE (6));
-  Private->SqBuffer[0]        = (NVME_SQ *)(UINTN)(Private->Buffer);
-  Private->SqBufferPciAddr[0] = (NVME_SQ *)(UINTN)(Private->BufferPciAddr);
-  Private->CqBuffer[0]        = (NVME_CQ *)(UINTN)(Private->Buffer + 1 * EFI_PAGE_SIZE);
-  Private->CqBufferPciAddr[0] = (NVME_CQ *)(UINTN)(Private->BufferPciAddr + 1 * EFI_PAGE_SIZE);
-  Private->SqBuffer[1]        = (NVME_SQ *)(UINTN)(Private->Buffer + 2 * EFI_PAGE_SIZE);
-  Private->SqBufferPciAddr[1] = (NVME_SQ *)(UINTN)(Private->BufferPciAddr + 2 * EFI_PAGE_SIZE);
-  Private->CqBuffer[1]        = (NVME_CQ *)(UINTN)(Private->Buffer + 3 * EFI_PAGE_SIZE);
-  Private->CqBufferPciAddr[1] = (NVME_CQ *)(UINTN)(Private->BufferPciAddr + 3 * EFI_PAGE_SIZE);
-  Private->SqBuffer[2]        = (NVME_SQ *)(UINTN)(Private->Buffer + 4 * EFI_PAGE_SIZE);
-  Private->SqBufferPciAddr[2] = (NVME_SQ *)(UINTN)(Private->BufferPciAddr + 4 * EFI_PAGE_SIZE);
-  Private->CqBuffer[2]        = (NVME_CQ *)(UINTN)(Private->Buffer + 5 * EFI_PAGE_SIZE);
-  Private->CqBufferPciAddr[2] = (NVME_CQ *)(UINTN)(Private->BufferPciAddr + 5 * EFI_PAGE_SIZE);
+  ZeroMem (Private->Buffer, EFI_PAGES_TO_SIZE (NVME_QUEUE_BUFFER_PAGES));
+  for (Index = 0; Index < NVME_MAX_QUEUES; Index++) {
+    Private->SqBuffer[Index]        = (NVME_SQ *)(UINTN)(Private->Buffer + (2 * Index) * EFI_PAGE_SIZE);
+    Private->SqBufferPciAddr[Index] = (NVME_SQ *)(UINTN)(Private->BufferPciAddr + (2 * Index) * EFI_PAGE_SIZE);
+    Private->CqBuffer[Index]        = (NVME_CQ *)(UINTN)(Private->Buffer + (2 * Index + 1) * EFI_PAGE_SIZE);
+    Private->CqBufferPciAddr[Index] = (NVME_CQ *)(UINTN)(Private->BufferPciAddr + (2 * Index + 1) * EFI_PAGE_SIZE);
+  }
 
   DEBUG ((DEBUG_INFO, "Private->Buffer = [%016X]\n", (UINT64)(UINTN)Private->Buffer));
   DEBUG ((DEBUG_INFO, "Admin     Submission Queue size (Aqa.Asqs) = [%08X]\n", Aqa.Asqs));
@@ -833,8 +900,10 @@ NvmeControllerInit (
   DEBUG ((DEBUG_INFO, "Admin     Completion Queue (CqBuffer[0]) = [%016X]\n", Private->CqBuffer[0]));
   DEBUG ((DEBUG_INFO, "Sync  I/O Submission Queue (SqBuffer[1]) = [%016X]\n", Private->SqBuffer[1]));
   DEBUG ((DEBUG_INFO, "Sync  I/O Completion Queue (CqBuffer[1]) = [%016X]\n", Private->CqBuffer[1]));
-  DEBUG ((DEBUG_INFO, "Async I/O Submission Queue (SqBuffer[2]) = [%016X]\n", Private->SqBuffer[2]));
-  DEBUG ((DEBUG_INFO, "Async I/O Completion Queue (CqBuffer[2]) = [%016X]\n", Private->CqBuffer[2]));
+  for (Index = NVME_ASYNC_QUEUE_BASE; Index < NVME_MAX_QUEUES; Index++) {
+    DEBUG ((DEBUG_INFO, "Async I/O Submission Queue (SqBuffer[%d]) = [%016X]\n", (UINT32)Index, Private->SqBuffer[Index]));
+    DEBUG ((DEBUG_INFO, "Async I/O Completion Queue (CqBuffer[%d]) = [%016X]\n", (UINT32)Index, Private->CqBuffer[Index]));
+  }
 
   //
   // Program admin queue attributes.
@@ -913,8 +982,14 @@ NvmeControllerInit (
   DEBUG ((DEBUG_INFO, "    NN        : 0x%x\n", Private->ControllerData->Nn));
 
   //
-  // Create two I/O completion queues.
-  // One for blocking I/O, one for non-blocking I/O.
+  // Request the number of I/O queues before creating them.
+  // A failure is not fatal, one asynchronous I/O queue pair is used then.
+  //
+  NvmeSetNumberOfQueues (Private);
+
+  //
+  // Create the I/O completion queues.
+  // One for blocking I/O, the others for non-blocking I/O.
   //
   Status = NvmeCreateIoCompletionQueue (Private);
   if (EFI_ERROR (Status)) {
@@ -922,8 +997,8 @@ NvmeControllerInit (
   }
 
   //
-  // Create two I/O Submission queues.
-  // One for blocking I/O, one for non-blocking I/O.
+  // Create the I/O Submission queues.
+  // One for blocking I/O, the others for non-blocking I/O.
   //
   Status = NvmeCreateIoSubmissionQueue (Private);
 
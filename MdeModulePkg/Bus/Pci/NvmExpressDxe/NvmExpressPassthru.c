@@ -195,6 +195,108 @@ NvmeDumpStatus (
   }
 }
 
+/**
+  Calculate the number of PRP lists for data transfer which is larger than 2 memory pages.
+
+  @param[in]  Pages                  The number of pages to be transfered by the PRP lists.
+  @param[out] LastPrpEntryNo         The number of PRP entries in the last PRP list.
+
+  @retval The number of PRP lists.
+
+**/
+UINTN
+NvmeGetPrpListNo (
+  IN  UINTN  Pages,
+  OUT UINTN  *LastPrpEntryNo
+  )
+{
+  UINTN   PrpEntryNo;
+  UINTN   PrpListNo;
+  UINT64  Remainder;
+
+  //
+  // The number of Prp Entry in a memory page.
+  //
+  PrpEntryNo = EFI_PAGE_SIZE / sizeof (UINT64);
+
+  //
+  // Calculate total PrpList number.
+  //
+  PrpListNo = (UINTN)DivU64x64Remainder ((UINT64)Pages, (UINT64)PrpEntryNo - 1, &Remainder);
+  if (PrpListNo == 0) {
+    PrpListNo = 1;
+  } else if ((Remainder != 0) && (Remainder != 1)) {
+    PrpListNo += 1;
+  } else if (Remainder == 1) {
+    Remainder = PrpEntryNo;
+  } else if (Remainder == 0) {
+    Remainder = PrpEntryNo - 1;
+  }
+
+  *LastPrpEntryNo = (UINTN)Remainder;
+  return PrpListNo;
+}
+
+/**
+  Fill the PRP lists for data transfer which is larger than 2 memory pages.
+
+  @param[in]     PrpListHost         The host base address of PRP lists.
+  @param[in]     PrpListPhyAddr      The physical base address of PRP lists.
+  @param[in]     PhysicalAddr        The physical base address of data buffer.
+  @param[in]     Pages               The number of pages to be transfered.
+
+**/
+VOID
+NvmeFillPrpList (
+  IN VOID                  *PrpListHost,
+  IN EFI_PHYSICAL_ADDRESS  PrpListPhyAddr,
+  IN EFI_PHYSICAL_ADDRESS  PhysicalAddr,
+  IN UINTN                 Pages
+  )
+{
+  UINTN   PrpEntryNo;
+  UINTN   PrpListNo;
+  UINT64  PrpListBase;
+  UINTN   PrpListIndex;
+  UINTN   PrpEntryIndex;
+  UINTN   Remainder;
+
+  PrpEntryNo = EFI_PAGE_SIZE / sizeof (UINT64);
+  PrpListNo  = NvmeGetPrpListNo (Pages, &Remainder);
+
+  //
+  // Fill all PRP lists except of last one.
+  //
+  ZeroMem (PrpListHost, EFI_PAGES_TO_SIZE (PrpListNo));
+  for (PrpListIndex = 0; PrpListIndex < PrpListNo - 1; ++PrpListIndex) {
+    PrpListBase = (UINT64)(UINTN)PrpListHost + PrpListIndex * EFI_PAGE_SIZE;
+
+    for (PrpEntryIndex = 0; PrpEntryIndex < PrpEntryNo; ++PrpEntryIndex) {
+      if (PrpEntryIndex != PrpEntryNo - 1) {
+        //
+        // Fill all PRP entries except of last one.
+        //
+        *((UINT64 *)(UINTN)PrpListBase + PrpEntryIndex) = PhysicalAddr;
+        PhysicalAddr                                   += EFI_PAGE_SIZE;
+      } else {
+        //
+        // Fill last PRP entries with next PRP List pointer.
+        //
+        *((UINT64 *)(UINTN)PrpListBase + PrpEntryIndex) = PrpListPhyAddr + (PrpListIndex + 1) * EFI_PAGE_SIZE;
+      }
+    }
+  }
+
+  //
+  // Fill last PRP list.
+  //
+  PrpListBase = (UINT64)(UINTN)PrpListHost + PrpListIndex * EFI_PAGE_SIZE;
+  for (PrpEntryIndex = 0; PrpEntryIndex < Remainder; ++PrpEntryIndex) {
+    *((UINT64 *)(UINTN)PrpListBase + PrpEntryIndex) = PhysicalAddr;
+    PhysicalAddr                                   += EFI_PAGE_SIZE;
+  }
+}
+
 /**
   Create PRP lists for data transfer which is larger than 2 memory pages.
   Note here we calcuate the number of required PRP lists and allocate them at one time.
@@ -219,33 +321,15 @@ NvmeCreatePrpList (
   OUT VOID                     **Mapping
   )
 {
-  UINTN                 PrpEntryNo;
-  UINT64                PrpListBase;
-  UINTN                 PrpListIndex;
-  UINTN                 PrpEntryIndex;
-  UINT64                Remainder;
+  UINTN                 Remainder;
   EFI_PHYSICAL_ADDRESS  PrpListPhyAddr;
   UINTN                 Bytes;
   EFI_STATUS            Status;
 
-  //
-  // The number of Prp Entry in a memory page.
-  //
-  PrpEntryNo = EFI_PAGE_SIZE / sizeof (UINT64);
-
   //
   // Calculate total PrpList number.
   //
-  *PrpListNo = (UINTN)DivU64x64Remainder ((UINT64)Pages, (UINT64)PrpEntryNo - 1, &Remainder);
-  if (*PrpListNo == 0) {
-    *PrpListNo = 1;
-  } else if ((Remainder != 0) && (Remainder != 1)) {
-    *PrpListNo += 1;
-  } else if (Remainder == 1) {
-    Remainder = PrpEntryNo;
-  } else if (Remainder == 0) {
-    Remainder = PrpEntryNo - 1;
-  }
+  *PrpListNo = NvmeGetPrpListNo (Pages, &Remainder);
 
   Status = PciIo->AllocateBuffer (
                     PciIo,
@@ -275,37 +359,7 @@ NvmeCreatePrpList (
     goto EXIT;
   }
 
-  //
-  // Fill all PRP lists except of last one.
-  //
-  ZeroMem (*PrpListHost, Bytes);
-  for (PrpListIndex = 0; PrpListIndex < *PrpListNo - 1; ++PrpListIndex) {
-    PrpListBase = *(UINT64 *)PrpListHost + PrpListIndex * EFI_PAGE_SIZE;
-
-    for (PrpEntryIndex = 0; PrpEntryIndex < PrpEntryNo; ++PrpEntryIndex) {
-      if (PrpEntryIndex != PrpEntryNo - 1) {
-        //
-        // Fill all PRP entries except of last one.
-        //
-        *((UINT64 *)(UINTN)PrpListBase + PrpEntryIndex) = PhysicalAddr;
-        PhysicalAddr                                   += EFI_PAGE_SIZE;
-      } else {
-        //
-        // Fill last PRP entries with next PRP List pointer.
-        //
-        *((UINT64 *)(UINTN)PrpListBase + PrpEntryIndex) = PrpListPhyAddr + (PrpListIndex + 1) * EFI_PAGE_SIZE;
-      }
-    }
-  }
-
-  //
-  // Fill last PRP list.
-  //
-  PrpListBase = *(UINT64 *)PrpListHost + PrpListIndex * EFI_PAGE_SIZE;
-  for (PrpEntryIndex = 0; PrpEntryIndex < Remainder; ++PrpEntryIndex) {
-    *((UINT64 *)(UINTN)PrpListBase + PrpEntryIndex) = PhysicalAddr;
-    PhysicalAddr                                   += EFI_PAGE_SIZE;
-  }
+  NvmeFillPrpList (*PrpListHost, PrpListPhyAddr, PhysicalAddr, Pages);
 
   return (VOID *)(UINTN)PrpListPhyAddr;
 
@@ -414,6 +468,60 @@ AbortAsyncPassThruTasks (
   return Status;
 }
 
+/**
+  Reset the NVMe controller to abort the outstanding commands after a timeout occurs for
+  a command.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+
+  @retval EFI_TIMEOUT       The controller has been reset and the asynchronous
+                            PassThru requests have been aborted.
+  @return Others            Fail to reset the controller.
+
+**/
+EFI_STATUS
+NvmeResetOnTimeout (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private
+  )
+{
+  EFI_STATUS  Status;
+
+  //
+  // Disable the timer to trigger the process of async transfers temporarily.
+  //
+  Status = gBS->SetTimer (Private->TimerEvent, TimerCancel, 0);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Reset the NVMe controller.
+  //
+  Status = NvmeControllerInit (Private);
+  if (!EFI_ERROR (Status)) {
+    Status = AbortAsyncPassThruTasks (Private);
+    if (!EFI_ERROR (Status)) {
+      //
+      // Re-enable the timer to trigger the process of async transfers.
+      //
+      Status = gBS->SetTimer (Private->TimerEvent, TimerPeriodic, NVME_HC_ASYNC_TIMER_IDLE);
+      if (!EFI_ERROR (Status)) {
+        Private->TimerPeriod = NVME_HC_ASYNC_TIMER_IDLE;
+
+        //
+        // Return EFI_TIMEOUT to indicate a timeout occurs for NVMe PassThru command.
+        //
+        Status = EFI_TIMEOUT;
+      }
+    }
+  } else {
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  return Status;
+}
+
 /**
   Sends an NVM Express Command Packet to an NVM Express controller or namespace. This function supports
   both blocking I/O and non-blocking I/O. The blocking I/O functionality is required, and the non-blocking
@@ -463,6 +571,10 @@ NvmExpressPassThru (
   NVME_CQ                        *Cq;
   UINT16                         QueueId;
   UINT16                         QueueSize;
+  UINT16                         AsyncQueueId;
+  UINT16                         Occupied;
+  UINT16                         MinOccupied;
+  UINT16                         Index;
   UINT32                         Bytes;
   UINT16                         Offset;
   EFI_EVENT                      TimerEvent;
@@ -553,22 +665,36 @@ NvmExpressPassThru (
   Prp         = NULL;
   TimerEvent  = NULL;
   Status      = EFI_SUCCESS;
-  QueueSize   = MIN (NVME_ASYNC_CSQ_SIZE, Private->Cap.Mqes) + 1;
 
   if (Packet->QueueType == NVME_ADMIN_QUEUE) {
-    QueueId = 0;
+    QueueId   = 0;
+    QueueSize = NVME_ASQ_SIZE + 1;
   } else {
     if (Event == NULL) {
-      QueueId = 1;
+      QueueId   = 1;
+      QueueSize = MIN (NVME_CSQ_SIZE, Private->Cap.Mqes) + 1;
     } else {
-      QueueId = 2;
+      QueueSize = MIN (NVME_ASYNC_CSQ_SIZE, Private->Cap.Mqes) + 1;
+
+      //
+      // Take the least occupied asynchronous I/O queue. The search starts from a queue picked
+      // by the namespace, so that the namespaces used in parallel get their own queues.
+      //
+      QueueId     = 0;
+      MinOccupied = (UINT16)(QueueSize - 1);
+      for (Index = 0; Index < Private->AsyncQueueCount; Index++) {
+        AsyncQueueId = (UINT16)(NVME_ASYNC_QUEUE_BASE + (NamespaceId - 1 + Index) % Private->AsyncQueueCount);
+        Occupied     = (UINT16)((Private->SqTdbl[AsyncQueueId].Sqt + QueueSize - Private->AsyncSqHead[AsyncQueueId]) % QueueSize);
+        if (Occupied < MinOccupied) {
+          QueueId     = AsyncQueueId;
+          MinOccupied = Occupied;
+        }
+      }
 
       //
       // Submission queue full check.
       //
-      if ((Private->SqTdbl[QueueId].Sqt + 1) % QueueSize ==
-          Private->AsyncSqHead)
-      {
+      if (QueueId == 0) {
         return EFI_NOT_READY;
       }
     }
@@ -726,12 +852,8 @@ NvmExpressPassThru (
   //
   // Ring the submission queue doorbell.
   //
-  if ((Event != NULL) && (QueueId != 0)) {
-    Private->SqTdbl[QueueId].Sqt =
-      (Private->SqTdbl[QueueId].Sqt + 1) % QueueSize;
-  } else {
-    Private->SqTdbl[QueueId].Sqt ^= 1;
-  }
+  Private->SqTdbl[QueueId].Sqt =
+    (Private->SqTdbl[QueueId].Sqt + 1) % QueueSize;
 
   Data   = ReadUnaligned32 ((UINT32 *)&Private->SqTdbl[QueueId]);
   Status = PciIo->Mem.Write (
@@ -760,6 +882,7 @@ NvmExpressPassThru (
 
     AsyncRequest->Signature   = NVME_PASS_THRU_ASYNC_REQ_SIG;
     AsyncRequest->Packet      = Packet;
+    AsyncRequest->QueueId     = QueueId;
     AsyncRequest->CommandId   = Sq->Cid;
     AsyncRequest->CallerEvent = Event;
     AsyncRequest->MapData     = MapData;
@@ -770,6 +893,7 @@ NvmExpressPassThru (
 
     OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
     InsertTailList (&Private->AsyncPassThruQueue, &AsyncRequest->Link);
+    NvmeUpdateAsyncTimer (Private);
     gBS->RestoreTPL (OldTpl);
 
     return EFI_SUCCESS;
@@ -830,40 +954,16 @@ NvmExpressPassThru (
     //
     DEBUG ((DEBUG_ERROR, "NvmExpressPassThru: Timeout occurs for an NVMe command.\n"));
 
-    //
-    // Disable the timer to trigger the process of async transfers temporarily.
-    //
-    Status = gBS->SetTimer (Private->TimerEvent, TimerCancel, 0);
-    if (EFI_ERROR (Status)) {
-      goto EXIT;
-    }
-
-    //
-    // Reset the NVMe controller.
-    //
-    Status = NvmeControllerInit (Private);
-    if (!EFI_ERROR (Status)) {
-      Status = AbortAsyncPassThruTasks (Private);
-      if (!EFI_ERROR (Status)) {
-        //
-        // Re-enable the timer to trigger the process of async transfers.
-        //
-        Status = gBS->SetTimer (Private->TimerEvent, TimerPeriodic, NVME_HC_ASYNC_TIMER);
-        if (!EFI_ERROR (Status)) {
-          //
-          // Return EFI_TIMEOUT to indicate a timeout occurs for NVMe PassThru command.
-          //
-          Status = EFI_TIMEOUT;
-        }
-      }
-    } else {
-      Status = EFI_DEVICE_ERROR;
-    }
-
+    Status = NvmeResetOnTimeout (Private);
     goto EXIT;
   }
 
-  if ((Private->CqHdbl[QueueId].Cqh ^= 1) == 0) {
+  //
+  // The completion queue of the admin and the synchronous I/O queue has the same size
+  // as the submission queue.
+  //
+  Private->CqHdbl[QueueId].Cqh = (Private->CqHdbl[QueueId].Cqh + 1) % QueueSize;
+  if (Private->CqHdbl[QueueId].Cqh == 0) {
     Private->Pt[QueueId] ^= 1;
   }
 
@@ -923,6 +1023,308 @@ EXIT:
   return Status;
 }
 
+/**
+  Read or write the blocks of a namespace by splitting the transfer into commands that are
+  in flight together on the synchronous I/O queue.
+
+  The commands are submitted with a single doorbell write per batch and their completions are
+  reaped together. The PRP lists of the commands are carved out of a pool allocated once for
+  the transfer.
+
+  @param[in]  Device             The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param[in]  IsRead             TRUE to read the blocks, FALSE to write them.
+  @param[in]  Buffer             The buffer of the data.
+  @param[in]  Lba                The start block number.
+  @param[in]  Blocks             Total block number to be transferred.
+  @param[in]  MaxTransferBlocks  The maximum block number of a command.
+
+  @retval EFI_SUCCESS            Datum are transferred.
+  @retval EFI_UNSUPPORTED        The transfer cannot be split into concurrent commands. Nothing is
+                                 transferred, the caller should send the commands one at a time.
+  @retval EFI_TIMEOUT            A command timed out and the controller has been reset.
+  @retval Others                 Fail to transfer all the datum.
+
+**/
+EFI_STATUS
+NvmeSyncIoQueueTransfer (
+  IN NVME_DEVICE_PRIVATE_DATA  *Device,
+  IN BOOLEAN                   IsRead,
+  IN VOID                      *Buffer,
+  IN UINT64                    Lba,
+  IN UINTN                     Blocks,
+  IN UINT32                    MaxTransferBlocks
+  )
+{
+  NVME_CONTROLLER_PRIVATE_DATA   *Private;
+  EFI_PCI_IO_PROTOCOL            *PciIo;
+  EFI_STATUS                     Status;
+  EFI_STATUS                     PreviousStatus;
+  NVME_SQ                        *Sq;
+  NVME_CQ                        *Cq;
+  UINT16                         QueueId;
+  UINT16                         QueueSize;
+  UINTN                          Depth;
+  UINTN                          Outstanding;
+  UINTN                          Slot;
+  BOOLEAN                        SlotBusy[NVME_CSQ_SIZE];
+  UINT32                         BlockSize;
+  UINTN                          Bytes;
+  UINT32                         TransferBlocks;
+  UINTN                          TransferBytes;
+  UINTN                          Offset;
+  UINTN                          Remainder;
+  EFI_PCI_IO_PROTOCOL_OPERATION  Flag;
+  EFI_PHYSICAL_ADDRESS           PhyAddr;
+  VOID                           *MapData;
+  UINTN                          MapLength;
+  VOID                           *PrpPoolHost;
+  EFI_PHYSICAL_ADDRESS           PrpPoolPhyAddr;
+  VOID                           *MapPrpPool;
+  UINTN                          PrpPoolPages;
+  UINTN                          PrpListNo;
+  EFI_EVENT                      TimerEvent;
+  BOOLEAN                        Submitted;
+  BOOLEAN                        Reaped;
+  UINT32                         Data;
+
+  Private   = Device->Controller;
+  PciIo     = Private->PciIo;
+  BlockSize = Device->Media.BlockSize;
+  QueueId   = 1;
+  QueueSize = MIN (NVME_CSQ_SIZE, Private->Cap.Mqes) + 1;
+
+  //
+  // At most QueueSize - 1 commands can be in the submission queue at the same time.
+  //
+  Depth = MIN (PcdGet8 (PcdNvmeSyncIoQueueDepth), QueueSize - 1);
+  Depth = MIN (Depth, (Blocks + MaxTransferBlocks - 1) / MaxTransferBlocks);
+  if (Depth < 2) {
+    return EFI_UNSUPPORTED;
+  }
+
+  MapData     = NULL;
+  MapPrpPool  = NULL;
+  PrpPoolHost = NULL;
+  TimerEvent  = NULL;
+
+  //
+  // Map the whole buffer once. Fall back to the commands one at a time when the buffer
+  // cannot be mapped at once, e.g. when the bounce buffer is smaller than the transfer.
+  //
+  Bytes     = Blocks * BlockSize;
+  MapLength = Bytes;
+  Flag      = IsRead ? EfiPciIoOperationBusMasterWrite : EfiPciIoOperationBusMasterRead;
+  Status    = PciIo->Map (PciIo, Flag, Buffer, &MapLength, &PhyAddr, &MapData);
+  if (EFI_ERROR (Status) || (MapLength != Bytes)) {
+    Status = EFI_UNSUPPORTED;
+    goto EXIT;
+  }
+
+  //
+  // Allocate the PRP lists of all the commands in flight at one time.
+  // Every command in flight owns PrpListNo pages of the pool, indexed by its slot.
+  //
+  PrpListNo    = NvmeGetPrpListNo (EFI_SIZE_TO_PAGES ((UINTN)MaxTransferBlocks * BlockSize), &Remainder);
+  PrpPoolPages = PrpListNo * Depth;
+  Status       = PciIo->AllocateBuffer (
+                          PciIo,
+                          AllocateAnyPages,
+                          EfiBootServicesData,
+                          PrpPoolPages,
+                          &PrpPoolHost,
+                          0
+                          );
+  if (EFI_ERROR (Status)) {
+    PrpPoolHost = NULL;
+    Status      = EFI_UNSUPPORTED;
+    goto EXIT;
+  }
+
+  MapLength = EFI_PAGES_TO_SIZE (PrpPoolPages);
+  Status    = PciIo->Map (
+                       PciIo,
+                       EfiPciIoOperationBusMasterCommonBuffer,
+                       PrpPoolHost,
+                       &MapLength,
+                       &PrpPoolPhyAddr,
+                       &MapPrpPool
+                       );
+  if (EFI_ERROR (Status) || (MapLength != EFI_PAGES_TO_SIZE (PrpPoolPages))) {
+    Status = EFI_UNSUPPORTED;
+    goto EXIT;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER,
+                  TPL_CALLBACK,
+                  NULL,
+                  NULL,
+                  &TimerEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    goto EXIT;
+  }
+
+  Status = gBS->SetTimer (TimerEvent, TimerRelative, NVME_GENERIC_TIMEOUT);
+  if (EFI_ERROR (Status)) {
+    goto EXIT;
+  }
+
+  ZeroMem (SlotBusy, sizeof (SlotBusy));
+  Outstanding = 0;
+  Status      = EFI_SUCCESS;
+  while ((Outstanding != 0) || ((Blocks != 0) && !EFI_ERROR (Status))) {
+    //
+    // Fill the free slots with the next commands, and ring the doorbell once for all of them.
+    //
+    Submitted = FALSE;
+    while ((Blocks != 0) && (Outstanding < Depth) && !EFI_ERROR (Status)) {
+      for (Slot = 0; SlotBusy[Slot]; Slot++) {
+      }
+
+      TransferBlocks = (UINT32)MIN (Blocks, MaxTransferBlocks);
+      TransferBytes  = (UINTN)TransferBlocks * BlockSize;
+
+      Sq = Private->SqBuffer[QueueId] + Private->SqTdbl[QueueId].Sqt;
+      ZeroMem (Sq, sizeof (NVME_SQ));
+      Sq->Opc    = IsRead ? NVME_IO_READ_OPC : NVME_IO_WRITE_OPC;
+      Sq->Cid    = (UINT16)Slot;
+      Sq->Nsid   = Device->NamespaceId;
+      Sq->Prp[0] = PhyAddr;
+
+      //
+      // If the buffer size spans more than two memory pages, then build a PRP list of
+      // the slot in the second PRP submission queue entry.
+      //
+      Offset = (UINTN)PhyAddr & (EFI_PAGE_SIZE - 1);
+      if ((Offset + TransferBytes) > (EFI_PAGE_SIZE * 2)) {
+        NvmeFillPrpList (
+          (UINT8 *)PrpPoolHost + EFI_PAGES_TO_SIZE (Slot * PrpListNo),
+          PrpPoolPhyAddr + EFI_PAGES_TO_SIZE (Slot * PrpListNo),
+          (PhyAddr + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1),
+          EFI_SIZE_TO_PAGES (Offset + TransferBytes) - 1
+          );
+        Sq->Prp[1] = PrpPoolPhyAddr + EFI_PAGES_TO_SIZE (Slot * PrpListNo);
+      } else if ((Offset + TransferBytes) > EFI_PAGE_SIZE) {
+        Sq->Prp[1] = (PhyAddr + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1);
+      }
+
+      Sq->Payload.Raw.Cdw10 = (UINT32)Lba;
+      Sq->Payload.Raw.Cdw11 = (UINT32)RShiftU64 (Lba, 32);
+      Sq->Payload.Raw.Cdw12 = (TransferBlocks - 1) & 0xFFFF;
+      if (!IsRead) {
+        //
+        // Set Force Unit Access bit (bit 30) to use write-through behaviour
+        //
+        Sq->Payload.Raw.Cdw12 |= BIT30;
+      }
+
+      Private->SqTdbl[QueueId].Sqt = (Private->SqTdbl[QueueId].Sqt + 1) % QueueSize;
+
+      SlotBusy[Slot] = TRUE;
+      Outstanding++;
+      Submitted = TRUE;
+      PhyAddr  += TransferBytes;
+      Lba      += TransferBlocks;
+      Blocks   -= TransferBlocks;
+    }
+
+    if (Submitted) {
+      Data   = ReadUnaligned32 ((UINT32 *)&Private->SqTdbl[QueueId]);
+      Status = PciIo->Mem.Write (
+                            PciIo,
+                            EfiPciIoWidthUint32,
+                            NVME_BAR,
+                            NVME_SQTDBL_OFFSET (QueueId, Private->Cap.Dstrd),
+                            1,
+                            &Data
+                            );
+      if (EFI_ERROR (Status)) {
+        //
+        // The state of the commands in the submission queue is unknown, reset the controller.
+        //
+        PreviousStatus = Status;
+        Status         = NvmeResetOnTimeout (Private);
+        Status         = (Status == EFI_TIMEOUT) ? PreviousStatus : Status;
+        goto EXIT;
+      }
+    }
+
+    //
+    // Reap all the completed commands, and ring the doorbell once for all of them.
+    //
+    Reaped = FALSE;
+    Cq     = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
+    while (Cq->Pt != Private->Pt[QueueId]) {
+      ASSERT ((Cq->Cid < Depth) && SlotBusy[Cq->Cid]);
+      if ((Cq->Sct != 0) || (Cq->Sc != 0)) {
+        Status = EFI_DEVICE_ERROR;
+        //
+        // Dump every completion entry status for debugging.
+        //
+        DEBUG_CODE_BEGIN ();
+        NvmeDumpStatus (Cq);
+        DEBUG_CODE_END ();
+      }
+
+      if ((Cq->Cid < Depth) && SlotBusy[Cq->Cid]) {
+        SlotBusy[Cq->Cid] = FALSE;
+        Outstanding--;
+      }
+
+      Private->CqHdbl[QueueId].Cqh = (Private->CqHdbl[QueueId].Cqh + 1) % QueueSize;
+      if (Private->CqHdbl[QueueId].Cqh == 0) {
+        Private->Pt[QueueId] ^= 1;
+      }
+
+      Cq     = Private->CqBuffer[QueueId] + Private->CqHdbl[QueueId].Cqh;
+      Reaped = TRUE;
+    }
+
+    if (Reaped) {
+      Data           = ReadUnaligned32 ((UINT32 *)&Private->CqHdbl[QueueId]);
+      PreviousStatus = Status;
+      Status         = PciIo->Mem.Write (
+                                  PciIo,
+                                  EfiPciIoWidthUint32,
+                                  NVME_BAR,
+                                  NVME_CQHDBL_OFFSET (QueueId, Private->Cap.Dstrd),
+                                  1,
+                                  &Data
+                                  );
+      Status = EFI_ERROR (PreviousStatus) ? PreviousStatus : Status;
+
+      //
+      // The timeout is counted from the last completion.
+      //
+      gBS->SetTimer (TimerEvent, TimerRelative, NVME_GENERIC_TIMEOUT);
+    } else if (!EFI_ERROR (gBS->CheckEvent (TimerEvent))) {
+      DEBUG ((DEBUG_ERROR, "%a: Timeout occurs for %Lu NVMe commands.\n", __FUNCTION__, (UINT64)Outstanding));
+      Status = NvmeResetOnTimeout (Private);
+      goto EXIT;
+    }
+  }
+
+EXIT:
+  if (MapData != NULL) {
+    PciIo->Unmap (PciIo, MapData);
+  }
+
+  if (MapPrpPool != NULL) {
+    PciIo->Unmap (PciIo, MapPrpPool);
+  }
+
+  if (PrpPoolHost != NULL) {
+    PciIo->FreeBuffer (PciIo, PrpPoolPages, PrpPoolHost);
+  }
+
+  if (TimerEvent != NULL) {
+    gBS->CloseEvent (TimerEvent);
+  }
+
+  return Status;
+}
+
 /**
   Used to retrieve the next namespace ID for this NVM Express controller.
 
@@ -9,9 +9,15 @@
             FV is only processed once.
 
   Step #2 - Dispatch. Remove driver from the mScheduledQueue and load and
-            start it. After mScheduledQueue is drained check the
-            mDiscoveredList to see if any item has a Depex that is ready to
-            be placed on the mScheduledQueue.
+            start it. After mScheduledQueue is drained check the drivers on
+            the mWokenQueue to see if any item has a Depex that is ready to
+            be placed on the mScheduledQueue. A driver is placed on the
+            mWokenQueue when it is discovered, when it is requested by
+            Schedule(), and when a protocol that its Depex pushes is
+            installed or uninstalled, so the Depex of the other drivers are
+            not evaluated again. The result of a Depex only depends on which
+            of the protocols it pushes are present, and a Depex with a NOT can
+            become TRUE when one of them is uninstalled.
 
   Step #3 - Adding to the mScheduledQueue requires that you process Before
             and After dependencies. This is done recursively as the call to add
@@ -45,6 +51,41 @@ LIST_ENTRY  mDiscoveredList = INITIALIZE_LIST_HEAD_VARIABLE (mDiscoveredList);
 //
 LIST_ENTRY  mScheduledQueue = INITIALIZE_LIST_HEAD_VARIABLE (mScheduledQueue);
 
+//
+// Queue of drivers whose Depex has to be evaluated by the next pass of the
+// dispatcher, in the order they were discovered. This queue is a subset of
+// the mDiscoveredList. List of EFI_CORE_DRIVER_ENTRY.
+//
+LIST_ENTRY  mWokenQueue = INITIALIZE_LIST_HEAD_VARIABLE (mWokenQueue);
+
+//
+// Number of drivers added to the mDiscoveredList.
+//
+UINTN  mDiscoveredCount = 0;
+
+//
+// The GUIDs of the PUSH, BEFORE and AFTER opcodes of the Depex of the
+// discovered drivers, hashed by GUID. Each chain is in discovery order.
+//
+#define DEPEX_GUID_HASH_SIZE  256
+
+typedef struct _DEPEX_GUID_LINK DEPEX_GUID_LINK;
+
+struct _DEPEX_GUID_LINK {
+  DEPEX_GUID_LINK          *Next;
+  EFI_GUID                 Guid;
+  UINT8                    OpCode;
+  EFI_CORE_DRIVER_ENTRY    *DriverEntry;
+};
+
+DEPEX_GUID_LINK  *mDepexGuidHash[DEPEX_GUID_HASH_SIZE];
+
+//
+// TRUE if a Depex GUID could not be added to mDepexGuidHash. Every pass of
+// the dispatcher then evaluates the Depex of all the Dependent drivers.
+//
+BOOLEAN  mDepexGuidHashIncomplete = FALSE;
+
 //
 // List of handles who's Fv's have been parsed and added to the mFwDriverList.
 //
@@ -219,6 +260,142 @@ CoreReleaseDispatcherLock (
   CoreReleaseLock (&mDispatcherLock);
 }
 
+/**
+  Return the chain of mDepexGuidHash that holds a GUID.
+
+  @param  Guid                  The GUID.
+
+  @return The index of the chain.
+
+**/
+STATIC
+UINTN
+CoreHashDepexGuid (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  return (ReadUnaligned32 ((CONST UINT32 *)Guid) ^ ReadUnaligned32 ((CONST UINT32 *)Guid + 3)) & (DEPEX_GUID_HASH_SIZE - 1);
+}
+
+/**
+  Place a driver on the mWokenQueue, in discovery order. The caller must hold
+  the dispatcher lock.
+
+  @param  DriverEntry           The driver whose Depex must be evaluated.
+
+**/
+STATIC
+VOID
+CoreWakeDriver (
+  IN  EFI_CORE_DRIVER_ENTRY  *DriverEntry
+  )
+{
+  LIST_ENTRY             *Link;
+  EFI_CORE_DRIVER_ENTRY  *WokenEntry;
+
+  if (DriverEntry->Woken) {
+    return;
+  }
+
+  for (Link = mWokenQueue.BackLink; Link != &mWokenQueue; Link = Link->BackLink) {
+    WokenEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, WakeLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    if (WokenEntry->Sequence < DriverEntry->Sequence) {
+      break;
+    }
+  }
+
+  InsertHeadList (Link, &DriverEntry->WakeLink);
+  DriverEntry->Woken = TRUE;
+}
+
+/**
+  Add the GUIDs of the PUSH, BEFORE and AFTER opcodes of the Depex of a driver
+  to mDepexGuidHash.
+
+  @param  DriverEntry           The driver whose Depex has just been read.
+
+**/
+STATIC
+VOID
+CoreIndexDriverDepex (
+  IN  EFI_CORE_DRIVER_ENTRY  *DriverEntry
+  )
+{
+  UINT8            *Iterator;
+  UINT8            *End;
+  DEPEX_GUID_LINK  *GuidLink;
+  DEPEX_GUID_LINK  **Previous;
+
+  Iterator = DriverEntry->Depex;
+  End      = Iterator + DriverEntry->DepexSize;
+  while ((Iterator < End) && (*Iterator != EFI_DEP_END)) {
+    if ((*Iterator == EFI_DEP_PUSH) || (*Iterator == EFI_DEP_BEFORE) || (*Iterator == EFI_DEP_AFTER)) {
+      if ((UINTN)(End - Iterator) <= sizeof (EFI_GUID)) {
+        //
+        // CoreIsSchedulable() fails this Depex
+        //
+        break;
+      }
+
+      GuidLink = AllocatePool (sizeof (DEPEX_GUID_LINK));
+      if (GuidLink == NULL) {
+        mDepexGuidHashIncomplete = TRUE;
+        return;
+      }
+
+      CopyGuid (&GuidLink->Guid, (EFI_GUID *)(Iterator + 1));
+      GuidLink->OpCode      = *Iterator;
+      GuidLink->DriverEntry = DriverEntry;
+
+      CoreAcquireDispatcherLock ();
+
+      Previous = &mDepexGuidHash[CoreHashDepexGuid (&GuidLink->Guid)];
+      while ((*Previous != NULL) && ((*Previous)->DriverEntry->Sequence <= DriverEntry->Sequence)) {
+        Previous = &(*Previous)->Next;
+      }
+
+      GuidLink->Next = *Previous;
+      *Previous      = GuidLink;
+
+      CoreReleaseDispatcherLock ();
+
+      Iterator += sizeof (EFI_GUID);
+    }
+
+    Iterator++;
+  }
+}
+
+/**
+  Queue the drivers whose dependency expression pushes a protocol for evaluation
+  by the dispatcher, after an interface of the protocol has been installed or
+  uninstalled.
+
+  @param  Protocol              The GUID of the protocol that was installed or
+                                uninstalled
+
+**/
+VOID
+CoreWakeDependentDrivers (
+  IN EFI_GUID  *Protocol
+  )
+{
+  DEPEX_GUID_LINK  *GuidLink;
+
+  CoreAcquireDispatcherLock ();
+
+  for (GuidLink = mDepexGuidHash[CoreHashDepexGuid (Protocol)]; GuidLink != NULL; GuidLink = GuidLink->Next) {
+    if ((GuidLink->OpCode == EFI_DEP_PUSH) &&
+        GuidLink->DriverEntry->Dependent &&
+        CompareGuid (Protocol, &GuidLink->Guid))
+    {
+      CoreWakeDriver (GuidLink->DriverEntry);
+    }
+  }
+
+  CoreReleaseDispatcherLock ();
+}
+
 /**
   Read Depex and pre-process the Depex for Before and After. If Section Extraction
   protocol returns an error via ReadSection defer the reading of the Depex.
@@ -276,6 +453,7 @@ CoreGetDepexSectionAndPreProccess (
     // Driver will be put in Dependent or Unrequested state
     //
     CorePreProcessDepex (DriverEntry);
+    CoreIndexDriverDepex (DriverEntry);
     DriverEntry->DepexProtocolError = FALSE;
   }
 
@@ -321,6 +499,7 @@ CoreSchedule (
       CoreAcquireDispatcherLock ();
       DriverEntry->Unrequested = FALSE;
       DriverEntry->Dependent   = TRUE;
+      CoreWakeDriver (DriverEntry);
       CoreReleaseDispatcherLock ();
 
       DEBUG ((DEBUG_DISPATCH, "Schedule FFS(%g) - EFI_SUCCESS\n", DriverName));
@@ -404,6 +583,7 @@ CoreDispatcher (
   EFI_STATUS             Status;
   EFI_STATUS             ReturnStatus;
   LIST_ENTRY             *Link;
+  LIST_ENTRY             RetryQueue;
   EFI_CORE_DRIVER_ENTRY  *DriverEntry;
   BOOLEAN                ReadyToRun;
   EFI_EVENT              DxeDispatchEvent;
@@ -538,11 +718,28 @@ CoreDispatcher (
     }
 
     //
-    // Search DriverList for items to place on Scheduled Queue
+    // Search the Woken Queue for items to place on Scheduled Queue
     //
     ReadyToRun = FALSE;
-    for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
-      DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    InitializeListHead (&RetryQueue);
+
+    CoreAcquireDispatcherLock ();
+
+    if (mDepexGuidHashIncomplete) {
+      for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
+        DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+        if (DriverEntry->Dependent || DriverEntry->DepexProtocolError) {
+          CoreWakeDriver (DriverEntry);
+        }
+      }
+    }
+
+    while (!IsListEmpty (&mWokenQueue)) {
+      DriverEntry = CR (mWokenQueue.ForwardLink, EFI_CORE_DRIVER_ENTRY, WakeLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+      RemoveEntryList (&DriverEntry->WakeLink);
+      DriverEntry->Woken = FALSE;
+
+      CoreReleaseDispatcherLock ();
 
       if (DriverEntry->DepexProtocolError) {
         //
@@ -563,7 +760,30 @@ CoreDispatcher (
           DEBUG ((DEBUG_DISPATCH, "  RESULT = FALSE\n"));
         }
       }
+
+      CoreAcquireDispatcherLock ();
+
+      //
+      // A driver without Depex waits for all the architectural protocols, and
+      // a Depex that could not be read is read again, so evaluate them again
+      // on the next pass
+      //
+      if (((DriverEntry->Dependent && (DriverEntry->Depex == NULL)) || DriverEntry->DepexProtocolError) &&
+          !DriverEntry->Woken)
+      {
+        InsertTailList (&RetryQueue, &DriverEntry->WakeLink);
+        DriverEntry->Woken = TRUE;
+      }
+    }
+
+    while (!IsListEmpty (&RetryQueue)) {
+      DriverEntry = CR (RetryQueue.ForwardLink, EFI_CORE_DRIVER_ENTRY, WakeLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+      RemoveEntryList (&DriverEntry->WakeLink);
+      DriverEntry->Woken = FALSE;
+      CoreWakeDriver (DriverEntry);
     }
+
+    CoreReleaseDispatcherLock ();
   } while (ReadyToRun);
 
   //
@@ -594,26 +814,23 @@ CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (
   IN  EFI_CORE_DRIVER_ENTRY  *InsertedDriverEntry
   )
 {
-  LIST_ENTRY             *Link;
+  DEPEX_GUID_LINK        *GuidLink;
   EFI_CORE_DRIVER_ENTRY  *DriverEntry;
 
   //
   // Process Before Dependency
   //
-  for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
-    DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
-    if (DriverEntry->Before && DriverEntry->Dependent && (DriverEntry != InsertedDriverEntry)) {
+  for (GuidLink = mDepexGuidHash[CoreHashDepexGuid (&InsertedDriverEntry->FileName)]; GuidLink != NULL; GuidLink = GuidLink->Next) {
+    DriverEntry = GuidLink->DriverEntry;
+    if ((GuidLink->OpCode == EFI_DEP_BEFORE) && DriverEntry->Before && DriverEntry->Dependent && (DriverEntry != InsertedDriverEntry) &&
+        CompareGuid (&InsertedDriverEntry->FileName, &DriverEntry->BeforeAfterGuid))
+    {
+      //
+      // Recursively process BEFORE
+      //
       DEBUG ((DEBUG_DISPATCH, "Evaluate DXE DEPEX for FFS(%g)\n", &DriverEntry->FileName));
-      DEBUG ((DEBUG_DISPATCH, "  BEFORE FFS(%g) = ", &DriverEntry->BeforeAfterGuid));
-      if (CompareGuid (&InsertedDriverEntry->FileName, &DriverEntry->BeforeAfterGuid)) {
-        //
-        // Recursively process BEFORE
-        //
-        DEBUG ((DEBUG_DISPATCH, "TRUE\n  END\n  RESULT = TRUE\n"));
-        CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (DriverEntry);
-      } else {
-        DEBUG ((DEBUG_DISPATCH, "FALSE\n  END\n  RESULT = FALSE\n"));
-      }
+      DEBUG ((DEBUG_DISPATCH, "  BEFORE FFS(%g) = TRUE\n  END\n  RESULT = TRUE\n", &DriverEntry->BeforeAfterGuid));
+      CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (DriverEntry);
     }
   }
 
@@ -631,20 +848,17 @@ CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (
   //
   // Process After Dependency
   //
-  for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
-    DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
-    if (DriverEntry->After && DriverEntry->Dependent && (DriverEntry != InsertedDriverEntry)) {
+  for (GuidLink = mDepexGuidHash[CoreHashDepexGuid (&InsertedDriverEntry->FileName)]; GuidLink != NULL; GuidLink = GuidLink->Next) {
+    DriverEntry = GuidLink->DriverEntry;
+    if ((GuidLink->OpCode == EFI_DEP_AFTER) && DriverEntry->After && DriverEntry->Dependent && (DriverEntry != InsertedDriverEntry) &&
+        CompareGuid (&InsertedDriverEntry->FileName, &DriverEntry->BeforeAfterGuid))
+    {
+      //
+      // Recursively process AFTER
+      //
       DEBUG ((DEBUG_DISPATCH, "Evaluate DXE DEPEX for FFS(%g)\n", &DriverEntry->FileName));
-      DEBUG ((DEBUG_DISPATCH, "  AFTER FFS(%g) = ", &DriverEntry->BeforeAfterGuid));
-      if (CompareGuid (&InsertedDriverEntry->FileName, &DriverEntry->BeforeAfterGuid)) {
-        //
-        // Recursively process AFTER
-        //
-        DEBUG ((DEBUG_DISPATCH, "TRUE\n  END\n  RESULT = TRUE\n"));
-        CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (DriverEntry);
-      } else {
-        DEBUG ((DEBUG_DISPATCH, "FALSE\n  END\n  RESULT = FALSE\n"));
-      }
+      DEBUG ((DEBUG_DISPATCH, "  AFTER FFS(%g) = TRUE\n  END\n  RESULT = TRUE\n", &DriverEntry->BeforeAfterGuid));
+      CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (DriverEntry);
     }
   }
 }
@@ -877,12 +1091,14 @@ CoreAddToDriverList (
   DriverEntry->FvHandle         = FvHandle;
   DriverEntry->Fv               = Fv;
   DriverEntry->FvFileDevicePath = CoreFvToDevicePath (Fv, FvHandle, DriverName);
+  DriverEntry->Sequence         = mDiscoveredCount++;
 
   CoreGetDepexSectionAndPreProccess (DriverEntry);
 
   CoreAcquireDispatcherLock ();
 
   InsertTailList (&mDiscoveredList, &DriverEntry->Link);
+  CoreWakeDriver (DriverEntry);
 
   CoreReleaseDispatcherLock ();
 
@@ -85,6 +85,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DebugAgentLib.h>
 #include <Library/CpuExceptionHandlerLib.h>
 
+#include "Mem/RedBlackTree.h"
+
 //
 // attributes for reserved memory before it is promoted to system memory
 //
@@ -139,6 +141,10 @@ typedef struct {
 
   LIST_ENTRY                       ScheduledLink;   // mScheduledQueue
 
+  LIST_ENTRY                       WakeLink;        // mWokenQueue
+  UINTN                            Sequence;        // Discovery order
+  BOOLEAN                          Woken;
+
   EFI_HANDLE                       FvHandle;
   EFI_GUID                         FileName;
   EFI_DEVICE_PATH_PROTOCOL         *FvFileDevicePath;
@@ -169,6 +175,10 @@ typedef struct {
 typedef struct {
   UINTN                   Signature;
   LIST_ENTRY              Link;
+  ///
+  /// Node of the tree that indexes the map by BaseAddress
+  ///
+  RB_TREE_NODE            Node;
   EFI_PHYSICAL_ADDRESS    BaseAddress;
   UINT64                  EndAddress;
   UINT64                  Capabilities;
@@ -460,6 +470,20 @@ CoreInitializeDispatcher (
   VOID
   );
 
+/**
+  Queue the drivers whose dependency expression pushes a protocol for evaluation
+  by the dispatcher, after an interface of the protocol has been installed or
+  uninstalled.
+
+  @param  Protocol               The GUID of the protocol that was installed or
+                                 uninstalled
+
+**/
+VOID
+CoreWakeDependentDrivers (
+  IN EFI_GUID  *Protocol
+  );
+
 /**
   This is the POSTFIX version of the dependency evaluator.  This code does
   not need to handle Before or After, as it is not valid to call this
@@ -685,6 +709,15 @@ CoreInstallProtocolInterfaceNotify (
   IN BOOLEAN             Notify
   );
 
+/**
+  Reports the protocol database lookup counters on the debug output.
+
+**/
+VOID
+CoreDumpProtocolDatabaseStats (
+  VOID
+  );
+
 /**
   Installs a list of protocol interface into the boot services environment.
   This function calls InstallProtocolInterface() in a loop. If any error
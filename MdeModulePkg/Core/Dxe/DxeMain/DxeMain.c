@@ -569,6 +569,11 @@ DxeMain (
     (EFI_SOFTWARE_DXE_CORE | EFI_SW_DXE_CORE_PC_HANDOFF_TO_NEXT)
     );
 
+  //
+  // Report the protocol database lookup cost of the dispatch phase
+  //
+  CoreDumpProtocolDatabaseStats ();
+
   //
   // Transfer control to the BDS Architectural Protocol
   //
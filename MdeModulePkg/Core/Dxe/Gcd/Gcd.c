@@ -45,12 +45,56 @@ EFI_LOCK    mGcdIoSpaceLock     = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 LIST_ENTRY  mGcdMemorySpaceMap  = INITIALIZE_LIST_HEAD_VARIABLE (mGcdMemorySpaceMap);
 LIST_ENTRY  mGcdIoSpaceMap      = INITIALIZE_LIST_HEAD_VARIABLE (mGcdIoSpaceMap);
 
+/**
+  Compares the base addresses of two GCD map entries.
+
+  @param  Node1                  The tree node of the first entry
+  @param  Node2                  The tree node of the second entry
+
+  @retval <0                     The first entry is below the second one.
+  @retval 0                      The entries have the same base address.
+  @retval >0                     The first entry is above the second one.
+
+**/
+STATIC
+INTN
+CoreCompareGcdMapEntry (
+  IN CONST RB_TREE_NODE  *Node1,
+  IN CONST RB_TREE_NODE  *Node2
+  )
+{
+  EFI_GCD_MAP_ENTRY  *Entry1;
+  EFI_GCD_MAP_ENTRY  *Entry2;
+
+  Entry1 = BASE_CR (Node1, EFI_GCD_MAP_ENTRY, Node);
+  Entry2 = BASE_CR (Node2, EFI_GCD_MAP_ENTRY, Node);
+  if (Entry1->BaseAddress < Entry2->BaseAddress) {
+    return -1;
+  }
+
+  return (Entry1->BaseAddress > Entry2->BaseAddress) ? 1 : 0;
+}
+
+//
+// The entries of mGcdMemorySpaceMap and mGcdIoSpaceMap ordered by base
+// address. The entries of a map never overlap, so finding the entry that
+// contains an address is a single descent of the tree.
+//
+RB_TREE  mGcdMemorySpaceTree = INITIALIZE_RB_TREE (CoreCompareGcdMapEntry, NULL);
+RB_TREE  mGcdIoSpaceTree     = INITIALIZE_RB_TREE (CoreCompareGcdMapEntry, NULL);
+
 EFI_GCD_MAP_ENTRY  mGcdMemorySpaceMapEntryTemplate = {
   EFI_GCD_MAP_SIGNATURE,
   {
     NULL,
     NULL
   },
+  {
+    NULL,
+    NULL,
+    NULL,
+    FALSE
+  },
   0,
   0,
   0,
@@ -67,6 +111,12 @@ EFI_GCD_MAP_ENTRY  mGcdIoSpaceMapEntryTemplate = {
     NULL,
     NULL
   },
+  {
+    NULL,
+    NULL,
+    NULL,
+    FALSE
+  },
   0,
   0,
   0,
@@ -150,6 +200,13 @@ CoreDumpGcdMemorySpaceMap (
   EFI_GCD_MEMORY_SPACE_DESCRIPTOR  *MemorySpaceMap;
   UINTN                            Index;
 
+  //
+  // Do not copy the whole map on each GCD service call if it is not printed
+  //
+  if (!DebugPrintLevelEnabled (DEBUG_GCD)) {
+    return;
+  }
+
   Status = CoreGetMemorySpaceMap (&NumberOfDescriptors, &MemorySpaceMap);
   ASSERT (Status == EFI_SUCCESS && MemorySpaceMap != NULL);
 
@@ -196,6 +253,13 @@ CoreDumpGcdIoSpaceMap (
   EFI_GCD_IO_SPACE_DESCRIPTOR  *IoSpaceMap;
   UINTN                        Index;
 
+  //
+  // Do not copy the whole map on each GCD service call if it is not printed
+  //
+  if (!DebugPrintLevelEnabled (DEBUG_GCD)) {
+    return;
+  }
+
   Status = CoreGetIoSpaceMap (&NumberOfDescriptors, &IoSpaceMap);
   ASSERT (Status == EFI_SUCCESS && IoSpaceMap != NULL);
 
@@ -374,6 +438,62 @@ PageAlignLength (
 // GCD Memory Space Worker Functions
 //
 
+/**
+  Return the tree that indexes a GCD map.
+
+  @param  Map                    The GCD memory space map or the GCD I/O space map
+
+  @return The tree of the map.
+
+**/
+STATIC
+RB_TREE *
+CoreGetGcdMapTree (
+  IN LIST_ENTRY  *Map
+  )
+{
+  if (Map == &mGcdIoSpaceMap) {
+    return &mGcdIoSpaceTree;
+  }
+
+  ASSERT (Map == &mGcdMemorySpaceMap);
+  return &mGcdMemorySpaceTree;
+}
+
+/**
+  Find the entry of a GCD map that contains an address.
+
+  @param  Address                The address to look up
+  @param  Map                    The GCD memory space map or the GCD I/O space map
+
+  @return The entry that contains Address, or NULL if Address is above the map.
+
+**/
+STATIC
+EFI_GCD_MAP_ENTRY *
+CoreFindGcdMapEntry (
+  IN EFI_PHYSICAL_ADDRESS  Address,
+  IN LIST_ENTRY            *Map
+  )
+{
+  RB_TREE_NODE       *Node;
+  EFI_GCD_MAP_ENTRY  *Entry;
+
+  Node = CoreGetGcdMapTree (Map)->Root;
+  while (Node != NULL) {
+    Entry = BASE_CR (Node, EFI_GCD_MAP_ENTRY, Node);
+    if (Address < Entry->BaseAddress) {
+      Node = Node->Left;
+    } else if (Address > Entry->EndAddress) {
+      Node = Node->Right;
+    } else {
+      return Entry;
+    }
+  }
+
+  return NULL;
+}
+
 /**
   Allocate pool for two entries.
 
@@ -423,6 +543,7 @@ CoreAllocateGcdMapEntry (
   @param  Length                 The length of the new range in bytes
   @param  TopEntry               Top pad entry to insert if needed.
   @param  BottomEntry            Bottom pad entry to insert if needed.
+  @param  Map                    The map Entry is on.
 
   @retval EFI_SUCCESS            The new range was inserted into the linked list
 
@@ -434,7 +555,8 @@ CoreInsertGcdMapEntry (
   IN EFI_PHYSICAL_ADDRESS  BaseAddress,
   IN UINT64                Length,
   IN EFI_GCD_MAP_ENTRY     *TopEntry,
-  IN EFI_GCD_MAP_ENTRY     *BottomEntry
+  IN EFI_GCD_MAP_ENTRY     *BottomEntry,
+  IN LIST_ENTRY            *Map
   )
 {
   ASSERT (Length != 0);
@@ -446,6 +568,7 @@ CoreInsertGcdMapEntry (
     Entry->BaseAddress      = BaseAddress;
     BottomEntry->EndAddress = BaseAddress - 1;
     InsertTailList (Link, &BottomEntry->Link);
+    CoreRbTreeInsert (CoreGetGcdMapTree (Map), &BottomEntry->Node);
   }
 
   if ((BaseAddress + Length - 1) < Entry->EndAddress) {
@@ -455,6 +578,7 @@ CoreInsertGcdMapEntry (
     TopEntry->BaseAddress = BaseAddress + Length;
     Entry->EndAddress     = BaseAddress + Length - 1;
     InsertHeadList (Link, &TopEntry->Link);
+    CoreRbTreeInsert (CoreGetGcdMapTree (Map), &TopEntry->Node);
   }
 
   return EFI_SUCCESS;
@@ -533,6 +657,7 @@ CoreMergeGcdMapEntry (
   }
 
   RemoveEntryList (AdjacentLink);
+  CoreRbTreeDelete (CoreGetGcdMapTree (Map), &AdjacentEntry->Node);
   CoreFreePool (AdjacentEntry);
 
   return EFI_SUCCESS;
@@ -604,34 +729,31 @@ CoreSearchGcdMapEntry (
   IN  LIST_ENTRY            *Map
   )
 {
-  LIST_ENTRY         *Link;
-  EFI_GCD_MAP_ENTRY  *Entry;
+  EFI_GCD_MAP_ENTRY  *StartEntry;
+  EFI_GCD_MAP_ENTRY  *EndEntry;
 
   ASSERT (Length != 0);
 
   *StartLink = NULL;
   *EndLink   = NULL;
 
-  Link = Map->ForwardLink;
-  while (Link != Map) {
-    Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
-    if ((BaseAddress >= Entry->BaseAddress) && (BaseAddress <= Entry->EndAddress)) {
-      *StartLink = Link;
-    }
-
-    if (*StartLink != NULL) {
-      if (((BaseAddress + Length - 1) >= Entry->BaseAddress) &&
-          ((BaseAddress + Length - 1) <= Entry->EndAddress))
-      {
-        *EndLink = Link;
-        return EFI_SUCCESS;
-      }
-    }
+  StartEntry = CoreFindGcdMapEntry (BaseAddress, Map);
+  if (StartEntry == NULL) {
+    return EFI_NOT_FOUND;
+  }
 
-    Link = Link->ForwardLink;
+  //
+  // The entries do not overlap, so the last byte of the segment is in a
+  // single entry, which must not be below the first one
+  //
+  EndEntry = CoreFindGcdMapEntry (BaseAddress + Length - 1, Map);
+  if ((EndEntry == NULL) || (EndEntry->BaseAddress < StartEntry->BaseAddress)) {
+    return EFI_NOT_FOUND;
   }
 
-  return EFI_NOT_FOUND;
+  *StartLink = &StartEntry->Link;
+  *EndLink   = &EndEntry->Link;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -934,7 +1056,7 @@ CoreConvertSpace (
   Link = StartLink;
   while (Link != EndLink->ForwardLink) {
     Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
-    CoreInsertGcdMapEntry (Link, Entry, BaseAddress, Length, TopEntry, BottomEntry);
+    CoreInsertGcdMapEntry (Link, Entry, BaseAddress, Length, TopEntry, BottomEntry, Map);
     switch (Operation) {
       //
       // Add operations
@@ -1217,7 +1339,16 @@ CoreAllocateSpace (
     if ((GcdAllocateType == EfiGcdAllocateMaxAddressSearchTopDown) ||
         (GcdAllocateType == EfiGcdAllocateAnySearchTopDown))
     {
-      Link = Map->BackLink;
+      //
+      // The entries above the one that contains MaxAddress cannot be used,
+      // so start the search from that entry
+      //
+      Entry = CoreFindGcdMapEntry (MaxAddress, Map);
+      if (Entry != NULL) {
+        Link = &Entry->Link;
+      } else {
+        Link = Map->BackLink;
+      }
     } else {
       Link = Map->ForwardLink;
     }
@@ -1322,7 +1453,7 @@ CoreAllocateSpace (
   Link = StartLink;
   while (Link != EndLink->ForwardLink) {
     Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
-    CoreInsertGcdMapEntry (Link, Entry, *BaseAddress, Length, TopEntry, BottomEntry);
+    CoreInsertGcdMapEntry (Link, Entry, *BaseAddress, Length, TopEntry, BottomEntry, Map);
     Entry->ImageHandle  = ImageHandle;
     Entry->DeviceHandle = DeviceHandle;
     Link                = Link->ForwardLink;
@@ -2547,6 +2678,7 @@ CoreInitializeGcdServices (
   Entry->EndAddress = LShiftU64 (1, SizeOfMemorySpace) - 1;
 
   InsertHeadList (&mGcdMemorySpaceMap, &Entry->Link);
+  CoreRbTreeInsert (&mGcdMemorySpaceTree, &Entry->Node);
 
   CoreDumpGcdMemorySpaceMap (TRUE);
 
@@ -2559,6 +2691,7 @@ CoreInitializeGcdServices (
   Entry->EndAddress = LShiftU64 (1, SizeOfIoSpace) - 1;
 
   InsertHeadList (&mGcdIoSpaceMap, &Entry->Link);
+  CoreRbTreeInsert (&mGcdIoSpaceTree, &Entry->Node);
 
   CoreDumpGcdIoSpaceMap (TRUE);
 
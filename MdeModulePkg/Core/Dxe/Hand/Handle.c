@@ -20,6 +20,22 @@ LIST_ENTRY  gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleList);
 EFI_LOCK    gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 UINT64      gHandleDatabaseKey    = 0;
 
+//
+// mProtocolHashTable     - Open addressed index of mProtocolDatabase keyed on
+//                          PROTOCOL_ENTRY.Hash. Protocol entries are never
+//                          removed, so the index only grows.
+// mProtocolEntryCount    - Number of entries on mProtocolDatabase
+// gProtocolDatabaseStats - Lookup cost counters for the protocol database
+//
+#define PROTOCOL_HASH_TABLE_MIN_SIZE    64
+#define HANDLE_PROTOCOL_INDEX_MIN_SIZE  8
+
+STATIC PROTOCOL_ENTRY  **mProtocolHashTable   = NULL;
+STATIC UINTN           mProtocolHashTableSize = 0;
+STATIC UINTN           mProtocolEntryCount    = 0;
+
+PROTOCOL_DATABASE_STATS  gProtocolDatabaseStats = { 0, 0, 0, 0 };
+
 /**
   Acquire lock on gProtocolDatabaseLock.
 
@@ -78,6 +94,344 @@ CoreValidateHandle (
   return EFI_INVALID_PARAMETER;
 }
 
+/**
+  Computes the hash of a protocol GUID used by the protocol database indexes.
+
+  @param  Protocol               The ID of the protocol
+
+  @return The hash of Protocol
+
+**/
+STATIC
+UINT32
+CoreHashProtocolGuid (
+  IN EFI_GUID  *Protocol
+  )
+{
+  UINT64  Hash;
+
+  Hash  = ReadUnaligned64 ((UINT64 *)Protocol);
+  Hash ^= ReadUnaligned64 ((UINT64 *)Protocol + 1);
+  Hash  = MultU64x64 (Hash, 0x9E3779B97F4A7C15ULL);
+  return (UINT32)RShiftU64 (Hash, 32);
+}
+
+/**
+  Returns TRUE if a hash table with TableSize slots holding Count entries
+  is too full to accept one more entry.
+
+  @param  Count                  The number of entries in the table
+  @param  TableSize              The number of slots in the table
+
+  @retval TRUE                   The table must be grown before inserting.
+  @retval FALSE                  The table can accept one more entry.
+
+**/
+STATIC
+BOOLEAN
+CoreHashTableIsFull (
+  IN UINTN  Count,
+  IN UINTN  TableSize
+  )
+{
+  return (BOOLEAN)((Count + 1) * 4 > TableSize * 3);
+}
+
+/**
+  Rebuilds mProtocolHashTable from mProtocolDatabase.
+  The gProtocolDatabaseLock must be owned
+
+  If the new table cannot be allocated the index is dropped, and lookups
+  fall back to walking mProtocolDatabase until the next rebuild succeeds.
+
+  @param  TableSize              The number of slots in the new table. Must be
+                                 a power of 2.
+
+**/
+STATIC
+VOID
+CoreRebuildProtocolHashTable (
+  IN UINTN  TableSize
+  )
+{
+  PROTOCOL_ENTRY  **Table;
+  PROTOCOL_ENTRY  *Item;
+  LIST_ENTRY      *Link;
+  UINTN           Index;
+
+  ASSERT ((TableSize & (TableSize - 1)) == 0);
+
+  Table = AllocateZeroPool (TableSize * sizeof (PROTOCOL_ENTRY *));
+  if (Table != NULL) {
+    for (Link = mProtocolDatabase.ForwardLink;
+         Link != &mProtocolDatabase;
+         Link = Link->ForwardLink)
+    {
+      Item = CR (Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+      for (Index = Item->Hash & (TableSize - 1); Table[Index] != NULL; Index = (Index + 1) & (TableSize - 1)) {
+      }
+
+      Table[Index] = Item;
+    }
+  }
+
+  if (mProtocolHashTable != NULL) {
+    CoreFreePool (mProtocolHashTable);
+  }
+
+  mProtocolHashTable     = Table;
+  mProtocolHashTableSize = (Table != NULL) ? TableSize : 0;
+}
+
+/**
+  Adds a new protocol entry to mProtocolHashTable, growing the table as needed.
+  The gProtocolDatabaseLock must be owned, and ProtEntry must already be on
+  mProtocolDatabase.
+
+  @param  ProtEntry              The protocol entry to index
+
+**/
+STATIC
+VOID
+CoreAddProtocolEntryToHashTable (
+  IN PROTOCOL_ENTRY  *ProtEntry
+  )
+{
+  UINTN  Index;
+  UINTN  TableSize;
+
+  if ((mProtocolHashTable == NULL) || CoreHashTableIsFull (mProtocolEntryCount - 1, mProtocolHashTableSize)) {
+    //
+    // The rebuild picks up ProtEntry from mProtocolDatabase
+    //
+    TableSize = MAX (mProtocolHashTableSize, PROTOCOL_HASH_TABLE_MIN_SIZE);
+    while (CoreHashTableIsFull (mProtocolEntryCount - 1, TableSize)) {
+      TableSize *= 2;
+    }
+
+    CoreRebuildProtocolHashTable (TableSize);
+    return;
+  }
+
+  for (Index = ProtEntry->Hash & (mProtocolHashTableSize - 1);
+       mProtocolHashTable[Index] != NULL;
+       Index = (Index + 1) & (mProtocolHashTableSize - 1))
+  {
+  }
+
+  mProtocolHashTable[Index] = ProtEntry;
+}
+
+/**
+  Rebuilds the protocol index of a handle from its Protocols list.
+  The gProtocolDatabaseLock must be owned
+
+  If the new index cannot be allocated the index is dropped, and lookups
+  fall back to walking the Protocols list until the next rebuild succeeds.
+
+  @param  Handle                 The handle to rebuild the index of
+  @param  IndexSize              The number of slots in the new index. Must be
+                                 a power of 2.
+
+**/
+STATIC
+VOID
+CoreRebuildHandleProtocolIndex (
+  IN IHANDLE  *Handle,
+  IN UINTN    IndexSize
+  )
+{
+  PROTOCOL_INTERFACE  **ProtocolIndex;
+  PROTOCOL_INTERFACE  *Prot;
+  LIST_ENTRY          *Link;
+  UINTN               Index;
+
+  ASSERT ((IndexSize & (IndexSize - 1)) == 0);
+
+  ProtocolIndex = AllocateZeroPool (IndexSize * sizeof (PROTOCOL_INTERFACE *));
+  if (ProtocolIndex != NULL) {
+    for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
+      Prot = CR (Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
+      for (Index = Prot->Protocol->Hash & (IndexSize - 1); ProtocolIndex[Index] != NULL; Index = (Index + 1) & (IndexSize - 1)) {
+      }
+
+      ProtocolIndex[Index] = Prot;
+    }
+  }
+
+  if (Handle->ProtocolIndex != NULL) {
+    CoreFreePool (Handle->ProtocolIndex);
+  }
+
+  Handle->ProtocolIndex     = ProtocolIndex;
+  Handle->ProtocolIndexSize = (ProtocolIndex != NULL) ? IndexSize : 0;
+}
+
+/**
+  Adds a protocol interface to the protocol index of its handle.
+  The gProtocolDatabaseLock must be owned, and Prot must already be on
+  the Protocols list of Handle and counted in Handle->ProtocolCount.
+
+  @param  Handle                 The handle the protocol interface is installed on
+  @param  Prot                   The protocol interface to index
+
+**/
+STATIC
+VOID
+CoreAddProtocolInterfaceToHandleIndex (
+  IN IHANDLE             *Handle,
+  IN PROTOCOL_INTERFACE  *Prot
+  )
+{
+  UINTN  Index;
+  UINTN  IndexSize;
+
+  if (!FeaturePcdGet (PcdDxeCoreProtocolHashIndexEnable)) {
+    return;
+  }
+
+  if ((Handle->ProtocolIndex == NULL) || CoreHashTableIsFull (Handle->ProtocolCount - 1, Handle->ProtocolIndexSize)) {
+    IndexSize = MAX (Handle->ProtocolIndexSize, HANDLE_PROTOCOL_INDEX_MIN_SIZE);
+    while (CoreHashTableIsFull (Handle->ProtocolCount - 1, IndexSize)) {
+      IndexSize *= 2;
+    }
+
+    CoreRebuildHandleProtocolIndex (Handle, IndexSize);
+    return;
+  }
+
+  for (Index = Prot->Protocol->Hash & (Handle->ProtocolIndexSize - 1);
+       Handle->ProtocolIndex[Index] != NULL;
+       Index = (Index + 1) & (Handle->ProtocolIndexSize - 1))
+  {
+  }
+
+  Handle->ProtocolIndex[Index] = Prot;
+}
+
+/**
+  Removes a protocol interface from the protocol index of its handle.
+  The gProtocolDatabaseLock must be owned.
+
+  The entries that follow the removed one in its probe sequence are shifted
+  back so that lookups never need tombstones.
+
+  @param  Handle                 The handle the protocol interface is installed on
+  @param  Prot                   The protocol interface to remove from the index
+
+**/
+STATIC
+VOID
+CoreRemoveProtocolInterfaceFromHandleIndex (
+  IN IHANDLE             *Handle,
+  IN PROTOCOL_INTERFACE  *Prot
+  )
+{
+  UINTN  Mask;
+  UINTN  Hole;
+  UINTN  Index;
+  UINTN  Home;
+
+  if (Handle->ProtocolIndex == NULL) {
+    return;
+  }
+
+  Mask = Handle->ProtocolIndexSize - 1;
+  for (Hole = Prot->Protocol->Hash & Mask; Handle->ProtocolIndex[Hole] != Prot; Hole = (Hole + 1) & Mask) {
+    if (Handle->ProtocolIndex[Hole] == NULL) {
+      ASSERT (FALSE);
+      return;
+    }
+  }
+
+  for (Index = (Hole + 1) & Mask; Handle->ProtocolIndex[Index] != NULL; Index = (Index + 1) & Mask) {
+    //
+    // Leave the entry in place if its home slot is cyclically in (Hole, Index]
+    //
+    Home = Handle->ProtocolIndex[Index]->Protocol->Hash & Mask;
+    if ((Hole <= Index) ? ((Hole < Home) && (Home <= Index)) : ((Hole < Home) || (Home <= Index))) {
+      continue;
+    }
+
+    Handle->ProtocolIndex[Hole] = Handle->ProtocolIndex[Index];
+    Hole                        = Index;
+  }
+
+  Handle->ProtocolIndex[Hole] = NULL;
+}
+
+/**
+  Finds the protocol interface for the requested protocol on a handle.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to search the protocol on
+  @param  Protocol               GUID of the protocol
+
+  @return Protocol instance (NULL: Not found)
+
+**/
+STATIC
+PROTOCOL_INTERFACE *
+CoreFindHandleProtocol (
+  IN IHANDLE   *Handle,
+  IN EFI_GUID  *Protocol
+  )
+{
+  PROTOCOL_INTERFACE  *Prot;
+  LIST_ENTRY          *Link;
+  UINT32              Hash;
+  UINTN               Index;
+
+  gProtocolDatabaseStats.HandleLookups++;
+
+  if (Handle->ProtocolIndex != NULL) {
+    Hash = CoreHashProtocolGuid (Protocol);
+    for (Index = Hash & (Handle->ProtocolIndexSize - 1);
+         Handle->ProtocolIndex[Index] != NULL;
+         Index = (Index + 1) & (Handle->ProtocolIndexSize - 1))
+    {
+      gProtocolDatabaseStats.HandleProbes++;
+      Prot = Handle->ProtocolIndex[Index];
+      if ((Prot->Protocol->Hash == Hash) && CompareGuid (&Prot->Protocol->ProtocolID, Protocol)) {
+        return Prot;
+      }
+    }
+
+    return NULL;
+  }
+
+  for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
+    gProtocolDatabaseStats.HandleProbes++;
+    Prot = CR (Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
+    if (CompareGuid (&Prot->Protocol->ProtocolID, Protocol)) {
+      return Prot;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Reports the protocol database lookup counters on the debug output.
+
+**/
+VOID
+CoreDumpProtocolDatabaseStats (
+  VOID
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "ProtocolDatabase: %d protocols, index %d slots, %ld entry lookups / %ld probes, %ld handle lookups / %ld probes\n",
+    mProtocolEntryCount,
+    mProtocolHashTableSize,
+    gProtocolDatabaseStats.EntryLookups,
+    gProtocolDatabaseStats.EntryProbes,
+    gProtocolDatabaseStats.HandleLookups,
+    gProtocolDatabaseStats.HandleProbes
+    ));
+}
+
 /**
   Finds the protocol entry for the requested protocol.
   The gProtocolDatabaseLock must be owned
@@ -97,6 +451,8 @@ CoreFindProtocolEntry (
   LIST_ENTRY      *Link;
   PROTOCOL_ENTRY  *Item;
   PROTOCOL_ENTRY  *ProtEntry;
+  UINT32          Hash;
+  UINTN           Index;
 
   ASSERT_LOCKED (&gProtocolDatabaseLock);
 
@@ -105,18 +461,36 @@ CoreFindProtocolEntry (
   //
 
   ProtEntry = NULL;
-  for (Link = mProtocolDatabase.ForwardLink;
-       Link != &mProtocolDatabase;
-       Link = Link->ForwardLink)
-  {
-    Item = CR (Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
-    if (CompareGuid (&Item->ProtocolID, Protocol)) {
-      //
-      // This is the protocol entry
-      //
+  Hash      = CoreHashProtocolGuid (Protocol);
+  gProtocolDatabaseStats.EntryLookups++;
 
-      ProtEntry = Item;
-      break;
+  if (mProtocolHashTable != NULL) {
+    for (Index = Hash & (mProtocolHashTableSize - 1);
+         mProtocolHashTable[Index] != NULL;
+         Index = (Index + 1) & (mProtocolHashTableSize - 1))
+    {
+      gProtocolDatabaseStats.EntryProbes++;
+      Item = mProtocolHashTable[Index];
+      if ((Item->Hash == Hash) && CompareGuid (&Item->ProtocolID, Protocol)) {
+        ProtEntry = Item;
+        break;
+      }
+    }
+  } else {
+    for (Link = mProtocolDatabase.ForwardLink;
+         Link != &mProtocolDatabase;
+         Link = Link->ForwardLink)
+    {
+      gProtocolDatabaseStats.EntryProbes++;
+      Item = CR (Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+      if (CompareGuid (&Item->ProtocolID, Protocol)) {
+        //
+        // This is the protocol entry
+        //
+
+        ProtEntry = Item;
+        break;
+      }
     }
   }
 
@@ -133,6 +507,7 @@ CoreFindProtocolEntry (
       //
       ProtEntry->Signature = PROTOCOL_ENTRY_SIGNATURE;
       CopyGuid ((VOID *)&ProtEntry->ProtocolID, Protocol);
+      ProtEntry->Hash = Hash;
       InitializeListHead (&ProtEntry->Protocols);
       InitializeListHead (&ProtEntry->Notify);
 
@@ -140,6 +515,10 @@ CoreFindProtocolEntry (
       // Add it to protocol database
       //
       InsertTailList (&mProtocolDatabase, &ProtEntry->AllEntries);
+      mProtocolEntryCount++;
+      if (FeaturePcdGet (PcdDxeCoreProtocolHashIndexEnable)) {
+        CoreAddProtocolEntryToHashTable (ProtEntry);
+      }
     }
   }
 
@@ -166,32 +545,16 @@ CoreFindProtocolInterface (
   )
 {
   PROTOCOL_INTERFACE  *Prot;
-  PROTOCOL_ENTRY      *ProtEntry;
-  LIST_ENTRY          *Link;
 
   ASSERT_LOCKED (&gProtocolDatabaseLock);
-  Prot = NULL;
 
   //
-  // Lookup the protocol entry for this protocol ID
+  // Lookup the protocol interface for this protocol ID on the handle,
+  // and check that it is the requested interface
   //
-
-  ProtEntry = CoreFindProtocolEntry (Protocol, FALSE);
-  if (ProtEntry != NULL) {
-    //
-    // Look at each protocol interface for any matches
-    //
-    for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
-      //
-      // If this protocol interface matches, remove it
-      //
-      Prot = CR (Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
-      if ((Prot->Interface == Interface) && (Prot->Protocol == ProtEntry)) {
-        break;
-      }
-
-      Prot = NULL;
-    }
+  Prot = CoreFindHandleProtocol (Handle, Protocol);
+  if ((Prot != NULL) && (Prot->Interface != Interface)) {
+    Prot = NULL;
   }
 
   return Prot;
@@ -441,6 +804,8 @@ CoreInstallProtocolInterfaceNotify (
   // protocol list for this handle
   //
   InsertHeadList (&Handle->Protocols, &Prot->Link);
+  Handle->ProtocolCount++;
+  CoreAddProtocolInterfaceToHandleIndex (Handle, Prot);
 
   //
   // Add this protocol interface to the tail of the
@@ -448,6 +813,11 @@ CoreInstallProtocolInterfaceNotify (
   //
   InsertTailList (&ProtEntry->Protocols, &Prot->ByProtocol);
 
+  //
+  // Let the dispatcher evaluate the drivers that depend on this protocol
+  //
+  CoreWakeDependentDrivers (&ProtEntry->ProtocolID);
+
   //
   // Notify the notification list for this protocol
   //
@@ -755,7 +1125,9 @@ CoreUninstallProtocolInterface (
     //
     // Remove the protocol interface from the handle
     //
+    CoreRemoveProtocolInterfaceFromHandleIndex (Handle, Prot);
     RemoveEntryList (&Prot->Link);
+    Handle->ProtocolCount--;
 
     //
     // Free the memory
@@ -763,6 +1135,12 @@ CoreUninstallProtocolInterface (
     Prot->Signature = 0;
     CoreFreePool (Prot);
     Status = EFI_SUCCESS;
+
+    //
+    // Let the dispatcher evaluate the drivers that depend on this protocol
+    // again, a Depex with a NOT may be satisfied now
+    //
+    CoreWakeDependentDrivers (Protocol);
   }
 
   //
@@ -771,6 +1149,10 @@ CoreUninstallProtocolInterface (
   if (IsListEmpty (&Handle->Protocols)) {
     Handle->Signature = 0;
     RemoveEntryList (&Handle->AllHandles);
+    if (Handle->ProtocolIndex != NULL) {
+      CoreFreePool (Handle->ProtocolIndex);
+    }
+
     CoreFreePool (Handle);
   }
 
@@ -874,31 +1256,17 @@ CoreGetProtocolInterface (
   IN  EFI_GUID    *Protocol
   )
 {
-  EFI_STATUS          Status;
-  PROTOCOL_ENTRY      *ProtEntry;
-  PROTOCOL_INTERFACE  *Prot;
-  IHANDLE             *Handle;
-  LIST_ENTRY          *Link;
+  EFI_STATUS  Status;
 
   Status = CoreValidateHandle (UserHandle);
   if (EFI_ERROR (Status)) {
     return NULL;
   }
 
-  Handle = (IHANDLE *)UserHandle;
-
   //
-  // Look at each protocol interface for a match
+  // Look up the protocol interface on the handle
   //
-  for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
-    Prot      = CR (Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
-    ProtEntry = Prot->Protocol;
-    if (CompareGuid (&ProtEntry->ProtocolID, Protocol)) {
-      return Prot;
-    }
-  }
-
-  return NULL;
+  return CoreFindHandleProtocol ((IHANDLE *)UserHandle, Protocol);
 }
 
 /**
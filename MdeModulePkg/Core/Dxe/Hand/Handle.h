@@ -11,18 +11,26 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #define EFI_HANDLE_SIGNATURE  SIGNATURE_32('h','n','d','l')
 
+typedef struct _PROTOCOL_INTERFACE PROTOCOL_INTERFACE;
+
 ///
 /// IHANDLE - contains a list of protocol handles
 ///
 typedef struct {
-  UINTN         Signature;
+  UINTN                 Signature;
   /// All handles list of IHANDLE
-  LIST_ENTRY    AllHandles;
+  LIST_ENTRY            AllHandles;
   /// List of PROTOCOL_INTERFACE's for this handle
-  LIST_ENTRY    Protocols;
-  UINTN         LocateRequest;
+  LIST_ENTRY            Protocols;
+  UINTN                 LocateRequest;
   /// The Handle Database Key value when this handle was last created or modified
-  UINT64        Key;
+  UINT64                Key;
+  /// Number of PROTOCOL_INTERFACE's on Protocols
+  UINTN                 ProtocolCount;
+  /// Number of slots in ProtocolIndex (a power of 2, 0 if there is no index)
+  UINTN                 ProtocolIndexSize;
+  /// Open addressed index of Protocols keyed on PROTOCOL_ENTRY.Hash
+  PROTOCOL_INTERFACE    **ProtocolIndex;
 } IHANDLE;
 
 #define ASSERT_IS_HANDLE(a)  ASSERT((a)->Signature == EFI_HANDLE_SIGNATURE)
@@ -40,6 +48,8 @@ typedef struct {
   LIST_ENTRY    AllEntries;
   /// ID of the protocol
   EFI_GUID      ProtocolID;
+  /// Hash of ProtocolID used by the protocol database indexes
+  UINT32        Hash;
   /// All protocol interfaces
   LIST_ENTRY    Protocols;
   /// Registerd notification handlers
@@ -52,7 +62,7 @@ typedef struct {
 /// PROTOCOL_INTERFACE - each protocol installed on a handle is tracked
 /// with a protocol interface structure
 ///
-typedef struct {
+struct _PROTOCOL_INTERFACE {
   UINTN             Signature;
   /// Link on IHANDLE.Protocols
   LIST_ENTRY        Link;
@@ -67,7 +77,7 @@ typedef struct {
   /// OPEN_PROTOCOL_DATA list
   LIST_ENTRY        OpenList;
   UINTN             OpenListCount;
-} PROTOCOL_INTERFACE;
+};
 
 #define OPEN_PROTOCOL_DATA_SIGNATURE  SIGNATURE_32('p','o','d','l')
 
@@ -98,6 +108,22 @@ typedef struct {
   LIST_ENTRY        *Position;
 } PROTOCOL_NOTIFY;
 
+///
+/// PROTOCOL_DATABASE_STATS - lookup cost counters for the protocol database
+///
+typedef struct {
+  /// Number of protocol entry lookups by GUID
+  UINT64    EntryLookups;
+  /// Number of protocol entries compared by those lookups
+  UINT64    EntryProbes;
+  /// Number of protocol interface lookups on a handle
+  UINT64    HandleLookups;
+  /// Number of protocol interfaces compared by those lookups
+  UINT64    HandleProbes;
+} PROTOCOL_DATABASE_STATS;
+
+extern PROTOCOL_DATABASE_STATS  gProtocolDatabaseStats;
+
 /**
   Finds the protocol entry for the requested protocol.
   The gProtocolDatabaseLock must be owned
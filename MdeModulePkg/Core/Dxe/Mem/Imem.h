@@ -9,6 +9,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #ifndef _IMEM_H_
 #define _IMEM_H_
 
+#include "RedBlackTree.h"
+
 //
 // +---------------------------------------------------+
 // | 0..(EfiMaxMemoryType - 1)    - Normal memory type |
@@ -32,7 +34,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define MEMORY_MAP_SIGNATURE  SIGNATURE_32('m','m','a','p')
 typedef struct {
   UINTN              Signature;
+  /// Link on gMemoryMap, which is kept sorted by Start
   LIST_ENTRY         Link;
+  /// Node in mMemoryMapTree, which is keyed on Start
+  RB_TREE_NODE       Node;
+  /// Size of the largest EfiConventionalMemory entry in the subtree of Node
+  UINT64             MaxFreeBytes;
   BOOLEAN            FromPages;
 
   EFI_MEMORY_TYPE    Type;
@@ -119,6 +119,157 @@ CoreReleaseMemoryLock (
   CoreReleaseLock (&gMemoryLock);
 }
 
+/**
+  Internal function.  Compares the start addresses of two descriptor entries.
+
+  @param  Node1                  The tree node of the first entry
+  @param  Node2                  The tree node of the second entry
+
+  @retval <0                     The first entry starts below the second one.
+  @retval 0                      The entries start at the same address.
+  @retval >0                     The first entry starts above the second one.
+
+**/
+STATIC
+INTN
+CoreCompareMemoryMapEntry (
+  IN CONST RB_TREE_NODE  *Node1,
+  IN CONST RB_TREE_NODE  *Node2
+  )
+{
+  MEMORY_MAP  *Entry1;
+  MEMORY_MAP  *Entry2;
+
+  Entry1 = CR (Node1, MEMORY_MAP, Node, MEMORY_MAP_SIGNATURE);
+  Entry2 = CR (Node2, MEMORY_MAP, Node, MEMORY_MAP_SIGNATURE);
+  if (Entry1->Start < Entry2->Start) {
+    return -1;
+  }
+
+  return (Entry1->Start > Entry2->Start) ? 1 : 0;
+}
+
+/**
+  Internal function.  Recomputes the size of the largest free descriptor
+  entry in the subtree of an entry.
+
+  @param  Node                   The tree node of the entry
+
+**/
+STATIC
+VOID
+CoreAugmentMemoryMapEntry (
+  IN RB_TREE_NODE  *Node
+  )
+{
+  MEMORY_MAP  *Entry;
+  MEMORY_MAP  *Child;
+
+  Entry               = CR (Node, MEMORY_MAP, Node, MEMORY_MAP_SIGNATURE);
+  Entry->MaxFreeBytes = 0;
+  if (Entry->Type == EfiConventionalMemory) {
+    Entry->MaxFreeBytes = Entry->End - Entry->Start + 1;
+  }
+
+  if (Node->Left != NULL) {
+    Child               = CR (Node->Left, MEMORY_MAP, Node, MEMORY_MAP_SIGNATURE);
+    Entry->MaxFreeBytes = MAX (Entry->MaxFreeBytes, Child->MaxFreeBytes);
+  }
+
+  if (Node->Right != NULL) {
+    Child               = CR (Node->Right, MEMORY_MAP, Node, MEMORY_MAP_SIGNATURE);
+    Entry->MaxFreeBytes = MAX (Entry->MaxFreeBytes, Child->MaxFreeBytes);
+  }
+}
+
+///
+/// mMemoryMapTree - the entries of gMemoryMap ordered by start address, with
+/// the size of the largest free entry of each subtree
+///
+RB_TREE  mMemoryMapTree = INITIALIZE_RB_TREE (CoreCompareMemoryMapEntry, CoreAugmentMemoryMapEntry);
+
+/**
+  Internal function.  Adds a descriptor entry to the memory map, keeping
+  gMemoryMap sorted by start address.
+
+  @param  Entry                  The entry to add
+
+**/
+VOID
+InsertMemoryMapEntry (
+  IN OUT MEMORY_MAP  *Entry
+  )
+{
+  RB_TREE_NODE  *Node;
+  MEMORY_MAP    *Prev;
+
+  CoreRbTreeInsert (&mMemoryMapTree, &Entry->Node);
+
+  Node = CoreRbTreePrev (&Entry->Node);
+  if (Node == NULL) {
+    InsertHeadList (&gMemoryMap, &Entry->Link);
+  } else {
+    Prev = CR (Node, MEMORY_MAP, Node, MEMORY_MAP_SIGNATURE);
+    InsertHeadList (&Prev->Link, &Entry->Link);
+  }
+}
+
+/**
+  Internal function.  Finds the descriptor entry with the highest start
+  address that is not above an address.
+
+  @param  Address                The address to look up
+
+  @return The entry, or NULL if all the entries start above Address
+
+**/
+MEMORY_MAP *
+CoreFindMemoryMapEntryBelow (
+  IN UINT64  Address
+  )
+{
+  RB_TREE_NODE  *Node;
+  MEMORY_MAP    *Entry;
+  MEMORY_MAP    *Found;
+
+  Found = NULL;
+  Node  = mMemoryMapTree.Root;
+  while (Node != NULL) {
+    Entry = CR (Node, MEMORY_MAP, Node, MEMORY_MAP_SIGNATURE);
+    if (Entry->Start <= Address) {
+      Found = Entry;
+      Node  = Node->Right;
+    } else {
+      Node = Node->Left;
+    }
+  }
+
+  return Found;
+}
+
+/**
+  Internal function.  Finds the descriptor entry that covers a page.
+
+  @param  Address                The address of the page
+
+  @return The entry, or NULL if the page is not in the memory map
+
+**/
+MEMORY_MAP *
+CoreFindMemoryMapEntry (
+  IN UINT64  Address
+  )
+{
+  MEMORY_MAP  *Entry;
+
+  Entry = CoreFindMemoryMapEntryBelow (Address);
+  if ((Entry != NULL) && (Entry->End > Address)) {
+    return Entry;
+  }
+
+  return NULL;
+}
+
 /**
   Internal function.  Removes a descriptor entry.
 
@@ -130,6 +281,7 @@ RemoveMemoryMapEntry (
   IN OUT MEMORY_MAP  *Entry
   )
 {
+  CoreRbTreeDelete (&mMemoryMapTree, &Entry->Node);
   RemoveEntryList (&Entry->Link);
   Entry->Link.ForwardLink = NULL;
 
@@ -161,7 +313,6 @@ CoreAddRange (
   IN UINT64                Attribute
   )
 {
-  LIST_ENTRY  *Link;
   MEMORY_MAP  *Entry;
 
   ASSERT ((Start & EFI_PAGE_MASK) == 0);
@@ -210,23 +361,24 @@ CoreAddRange (
   // and the same Attribute
   //
 
-  Link = gMemoryMap.ForwardLink;
-  while (Link != &gMemoryMap) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    Link  = Link->ForwardLink;
-
-    if (Entry->Type != Type) {
-      continue;
-    }
-
-    if (Entry->Attribute != Attribute) {
-      continue;
-    }
-
-    if (Entry->End + 1 == Start) {
+  // The map does not overlap the range, so the only candidates are the
+  // entries ending right below Start and starting right above End
+  //
+  if (Start != 0) {
+    Entry = CoreFindMemoryMapEntryBelow (Start - 1);
+    if ((Entry != NULL) && (Entry->End + 1 == Start) &&
+        (Entry->Type == Type) && (Entry->Attribute == Attribute))
+    {
       Start = Entry->Start;
       RemoveMemoryMapEntry (Entry);
-    } else if (Entry->Start == End + 1) {
+    }
+  }
+
+  if (End != MAX_UINT64) {
+    Entry = CoreFindMemoryMapEntryBelow (End + 1);
+    if ((Entry != NULL) && (Entry->Start == End + 1) &&
+        (Entry->Type == Type) && (Entry->Attribute == Attribute))
+    {
       End = Entry->End;
       RemoveMemoryMapEntry (Entry);
     }
@@ -243,7 +395,7 @@ CoreAddRange (
   mMapStack[mMapDepth].End          = End;
   mMapStack[mMapDepth].VirtualStart = 0;
   mMapStack[mMapDepth].Attribute    = Attribute;
-  InsertTailList (&gMemoryMap, &mMapStack[mMapDepth].Link);
+  InsertMemoryMapEntry (&mMapStack[mMapDepth]);
 
   mMapDepth += 1;
   ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -316,8 +468,6 @@ CoreFreeMemoryMapStack (
   )
 {
   MEMORY_MAP  *Entry;
-  MEMORY_MAP  *Entry2;
-  LIST_ENTRY  *Link2;
 
   ASSERT_LOCKED (&gMemoryLock);
 
@@ -348,25 +498,17 @@ CoreFreeMemoryMapStack (
 
     if (mMapStack[mMapDepth].Link.ForwardLink != NULL) {
       //
-      // Move this entry to general memory
+      // Move this entry to general memory, in the place of the stack entry
+      // in both gMemoryMap and mMemoryMapTree
       //
-      RemoveEntryList (&mMapStack[mMapDepth].Link);
-      mMapStack[mMapDepth].Link.ForwardLink = NULL;
-
       CopyMem (Entry, &mMapStack[mMapDepth], sizeof (MEMORY_MAP));
       Entry->FromPages = TRUE;
 
-      //
-      // Find insertion location
-      //
-      for (Link2 = gMemoryMap.ForwardLink; Link2 != &gMemoryMap; Link2 = Link2->ForwardLink) {
-        Entry2 = CR (Link2, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-        if (Entry2->FromPages && (Entry2->Start > Entry->Start)) {
-          break;
-        }
-      }
+      InsertTailList (&mMapStack[mMapDepth].Link, &Entry->Link);
+      RemoveEntryList (&mMapStack[mMapDepth].Link);
+      mMapStack[mMapDepth].Link.ForwardLink = NULL;
 
-      InsertTailList (Link2, &Entry->Link);
+      CoreRbTreeReplace (&mMemoryMapTree, &mMapStack[mMapDepth].Node, &Entry->Node);
     } else {
       //
       // This item of mMapStack[mMapDepth] has already been dequeued from gMemoryMap list,
@@ -740,7 +882,6 @@ CoreConvertPagesEx (
   UINT64           RangeEnd;
   UINT64           Attribute;
   EFI_MEMORY_TYPE  MemType;
-  LIST_ENTRY       *Link;
   MEMORY_MAP       *Entry;
 
   Entry         = NULL;
@@ -765,15 +906,8 @@ CoreConvertPagesEx (
     //
     // Find the entry that the covers the range
     //
-    for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-      Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-      if ((Entry->Start <= Start) && (Entry->End > Start)) {
-        break;
-      }
-    }
-
-    if (Link == &gMemoryMap) {
+    Entry = CoreFindMemoryMapEntry (Start);
+    if (Entry == NULL) {
       DEBUG ((DEBUG_ERROR | DEBUG_PAGE, "ConvertPages: failed to find range %lx - %lx\n", Start, End));
       return EFI_NOT_FOUND;
     }
@@ -859,11 +993,13 @@ CoreConvertPagesEx (
       // Clip start
       //
       Entry->Start = RangeEnd + 1;
+      CoreRbTreeUpdate (&mMemoryMapTree, &Entry->Node);
     } else if (Entry->End == RangeEnd) {
       //
       // Clip end
       //
       Entry->End = Start - 1;
+      CoreRbTreeUpdate (&mMemoryMapTree, &Entry->Node);
     } else {
       //
       // Pull it out of the center, clip current
@@ -885,9 +1021,10 @@ CoreConvertPagesEx (
 
       Entry->End = Start - 1;
       ASSERT (Entry->Start < Entry->End);
+      CoreRbTreeUpdate (&mMemoryMapTree, &Entry->Node);
 
       Entry = &mMapStack[mMapDepth];
-      InsertTailList (&gMemoryMap, &Entry->Link);
+      InsertMemoryMapEntry (Entry);
 
       mMapDepth += 1;
       ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -1009,6 +1146,159 @@ CoreUpdateMemoryAttributes (
   CoreReleaseMemoryLock ();
 }
 
+/**
+  Internal function. Checks whether a free descriptor entry can hold a
+  range of the requested size between two addresses.
+
+  @param  Entry                  The free descriptor entry
+  @param  MaxAddress             The address that the range must be below
+  @param  MinAddress             The address that the range must be above
+  @param  NumberOfBytes          Number of bytes needed
+  @param  Alignment              Bits to align with
+  @param  NeedGuard              Flag to indicate Guard page is needed or not
+
+  @return The last address of the highest range that fits in Entry, or 0 if
+          the range does not fit.
+
+**/
+STATIC
+UINT64
+CoreFindFreePagesInEntry (
+  IN MEMORY_MAP  *Entry,
+  IN UINT64      MaxAddress,
+  IN UINT64      MinAddress,
+  IN UINT64      NumberOfBytes,
+  IN UINTN       Alignment,
+  IN BOOLEAN     NeedGuard
+  )
+{
+  UINT64  DescStart;
+  UINT64  DescEnd;
+  UINT64  DescNumberOfBytes;
+
+  DescStart = Entry->Start;
+  DescEnd   = Entry->End;
+
+  //
+  // If desc is past max allowed address or below min allowed address, skip it
+  //
+  if ((DescStart >= MaxAddress) || (DescEnd < MinAddress)) {
+    return 0;
+  }
+
+  //
+  // If desc ends past max allowed address, clip the end
+  //
+  if (DescEnd >= MaxAddress) {
+    DescEnd = MaxAddress;
+  }
+
+  DescEnd = ((DescEnd + 1) & (~((UINT64)Alignment - 1))) - 1;
+
+  // Skip if DescEnd is less than DescStart after alignment clipping
+  if (DescEnd < DescStart) {
+    return 0;
+  }
+
+  //
+  // Compute the number of bytes we can used from this
+  // descriptor, and see it's enough to satisfy the request
+  //
+  DescNumberOfBytes = DescEnd - DescStart + 1;
+
+  if (DescNumberOfBytes < NumberOfBytes) {
+    return 0;
+  }
+
+  //
+  // If the start of the allocated range is below the min address allowed, skip it
+  //
+  if ((DescEnd - NumberOfBytes + 1) < MinAddress) {
+    return 0;
+  }
+
+  if (NeedGuard) {
+    DescEnd = AdjustMemoryS (
+                DescEnd + 1 - DescNumberOfBytes,
+                DescNumberOfBytes,
+                NumberOfBytes
+                );
+  }
+
+  return DescEnd;
+}
+
+/**
+  Internal function. Searches a subtree of mMemoryMapTree, from the highest
+  address down, for the first free descriptor entry that can hold a range of
+  the requested size between two addresses.
+
+  Subtrees that do not hold a free entry large enough for the range, or that
+  are entirely outside of the addresses, are skipped.
+
+  @param  Node                   The root of the subtree, or NULL
+  @param  MaxAddress             The address that the range must be below
+  @param  MinAddress             The address that the range must be above
+  @param  NumberOfBytes          Number of bytes needed
+  @param  Alignment              Bits to align with
+  @param  NeedGuard              Flag to indicate Guard page is needed or not
+
+  @return The last address of the highest range found, or 0 if the range was
+          not found.
+
+**/
+STATIC
+UINT64
+CoreFindFreePagesInTree (
+  IN RB_TREE_NODE  *Node,
+  IN UINT64        MaxAddress,
+  IN UINT64        MinAddress,
+  IN UINT64        NumberOfBytes,
+  IN UINTN         Alignment,
+  IN BOOLEAN       NeedGuard
+  )
+{
+  MEMORY_MAP  *Entry;
+  UINT64      Target;
+
+  if (Node == NULL) {
+    return 0;
+  }
+
+  Entry = CR (Node, MEMORY_MAP, Node, MEMORY_MAP_SIGNATURE);
+  if (Entry->MaxFreeBytes < NumberOfBytes) {
+    return 0;
+  }
+
+  //
+  // The entries of the right subtree start above this one, so they can only
+  // be used if this one starts below the max address
+  //
+  if (Entry->Start < MaxAddress) {
+    Target = CoreFindFreePagesInTree (Node->Right, MaxAddress, MinAddress, NumberOfBytes, Alignment, NeedGuard);
+    if (Target != 0) {
+      return Target;
+    }
+  }
+
+  if (Entry->Type == EfiConventionalMemory) {
+    Target = CoreFindFreePagesInEntry (Entry, MaxAddress, MinAddress, NumberOfBytes, Alignment, NeedGuard);
+    if (Target != 0) {
+      return Target;
+    }
+  }
+
+  //
+  // The entries of the left subtree end below this one, so they can only be
+  // used if this one starts above the min address
+  //
+  if (Entry->Start > MinAddress) {
+    return CoreFindFreePagesInTree (Node->Left, MaxAddress, MinAddress, NumberOfBytes, Alignment, NeedGuard);
+  }
+
+  return 0;
+}
+
 /**
   Internal function. Finds a consecutive free page range below
   the requested address.
@@ -1034,13 +1324,8 @@ CoreFindFreePagesI (
   IN BOOLEAN          NeedGuard
   )
 {
-  UINT64      NumberOfBytes;
-  UINT64      Target;
-  UINT64      DescStart;
-  UINT64      DescEnd;
-  UINT64      DescNumberOfBytes;
-  LIST_ENTRY  *Link;
-  MEMORY_MAP  *Entry;
+  UINT64  NumberOfBytes;
+  UINT64  Target;
 
   if ((MaxAddress < EFI_PAGE_MASK) || (NumberOfPages == 0)) {
     return 0;
@@ -1068,75 +1353,19 @@ CoreFindFreePagesI (
   }
 
   NumberOfBytes = LShiftU64 (NumberOfPages, EFI_PAGE_SHIFT);
-  Target        = 0;
-
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-    //
-    // If it's not a free entry, don't bother with it
-    //
-    if (Entry->Type != EfiConventionalMemory) {
-      continue;
-    }
-
-    DescStart = Entry->Start;
-    DescEnd   = Entry->End;
-
-    //
-    // If desc is past max allowed address or below min allowed address, skip it
-    //
-    if ((DescStart >= MaxAddress) || (DescEnd < MinAddress)) {
-      continue;
-    }
-
-    //
-    // If desc ends past max allowed address, clip the end
-    //
-    if (DescEnd >= MaxAddress) {
-      DescEnd = MaxAddress;
-    }
-
-    DescEnd = ((DescEnd + 1) & (~((UINT64)Alignment - 1))) - 1;
 
-    // Skip if DescEnd is less than DescStart after alignment clipping
-    if (DescEnd < DescStart) {
-      continue;
-    }
-
-    //
-    // Compute the number of bytes we can used from this
-    // descriptor, and see it's enough to satisfy the request
-    //
-    DescNumberOfBytes = DescEnd - DescStart + 1;
-
-    if (DescNumberOfBytes >= NumberOfBytes) {
-      //
-      // If the start of the allocated range is below the min address allowed, skip it
-      //
-      if ((DescEnd - NumberOfBytes + 1) < MinAddress) {
-        continue;
-      }
-
-      //
-      // If this is the best match so far remember it
-      //
-      if (DescEnd > Target) {
-        if (NeedGuard) {
-          DescEnd = AdjustMemoryS (
-                      DescEnd + 1 - DescNumberOfBytes,
-                      DescNumberOfBytes,
-                      NumberOfBytes
-                      );
-          if (DescEnd == 0) {
-            continue;
-          }
-        }
-
-        Target = DescEnd;
-      }
-    }
-  }
+  //
+  // The entries do not overlap, so the first suitable entry found from the
+  // highest address down holds the highest suitable range
+  //
+  Target = CoreFindFreePagesInTree (
+             mMemoryMapTree.Root,
+             MaxAddress,
+             MinAddress,
+             NumberOfBytes,
+             Alignment,
+             NeedGuard
+             );
 
   //
   // If this is a grow down, adjust target to be the allocation base
@@ -1528,7 +1757,6 @@ CoreInternalFreePages (
   )
 {
   EFI_STATUS  Status;
-  LIST_ENTRY  *Link;
   MEMORY_MAP  *Entry;
   UINTN       Alignment;
   BOOLEAN     IsGuarded;
@@ -1542,15 +1770,8 @@ CoreInternalFreePages (
   // Find the entry that the covers the range
   //
   IsGuarded = FALSE;
-  Entry     = NULL;
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    if ((Entry->Start <= Memory) && (Entry->End > Memory)) {
-      break;
-    }
-  }
-
-  if (Link == &gMemoryMap) {
+  Entry     = CoreFindMemoryMapEntry (Memory);
+  if (Entry == NULL) {
     Status = EFI_NOT_FOUND;
     goto Done;
   }
@@ -59,6 +59,64 @@ STATIC CONST UINT16  mPoolSizeTable[] = {
 
 #define MAX_POOL_SIZE  (MAX_ADDRESS - POOL_OVERHEAD)
 
+//
+// Small pool requests are served from slabs: one allocation granule of a
+// given memory type carved into chunks of a single size class. The slab
+// header lives at the start of the granule, so the slab owning a chunk is
+// found by masking the chunk address with the granularity.
+//
+#define POOLSLAB_HEAD_SIGNATURE  SIGNATURE_32('p','h','d','2')
+#define POOLSLAB_FREE_SIGNATURE  SIGNATURE_32('p','f','r','2')
+typedef struct {
+  UINT32    Signature;
+  UINT32    Reserved;
+  VOID      *Next;
+} POOL_SLAB_FREE;
+
+#define POOL_SLAB_SIGNATURE  SIGNATURE_32('p','s','l','b')
+typedef struct {
+  UINT32            Signature;
+  UINT32            Class;
+  UINTN             InUse;
+  POOL_SLAB_FREE    *FreeChunk;
+  LIST_ENTRY        Link;
+} POOL_SLAB;
+
+#define POOL_SLAB_DATA_OFFSET  ALIGN_VALUE (sizeof (POOL_SLAB), 16)
+
+//
+// Chunk sizes, pool head and tail included. Every size is a multiple of 16
+// so the data of each chunk keeps the alignment of regular pool entries.
+//
+STATIC CONST UINT16  mPoolSlabSizeTable[] = {
+  64, 128, 256, 512
+};
+
+#define MAX_POOL_SLAB_CLASS  (ARRAY_SIZE (mPoolSlabSizeTable))
+#define MAX_POOL_SLAB_SIZE   (mPoolSlabSizeTable[MAX_POOL_SLAB_CLASS - 1])
+
+//
+// Each slab class has one magazine per TPL at which pool services may be
+// called: TPL_APPLICATION, TPL_CALLBACK and TPL_NOTIFY. Code running at one
+// of these TPLs can only be interrupted by code running at a higher TPL,
+// which uses a different magazine, so chunks can be pushed to and popped
+// from the magazine of the current TPL without taking mPoolMemoryLock.
+// Magazines are refilled from the slabs under the lock; chunks freed into a
+// full magazine go back to their slab, also under the lock.
+//
+#define POOL_MAGAZINE_TPL_COUNT  3
+#define POOL_MAGAZINE_DEPTH      8
+
+typedef struct {
+  UINTN         Count;
+  POOL_HEAD     *Chunk[POOL_MAGAZINE_DEPTH];
+} POOL_MAGAZINE;
+
+typedef struct {
+  LIST_ENTRY       SlabList[MAX_POOL_SLAB_CLASS];
+  POOL_MAGAZINE    Magazine[POOL_MAGAZINE_TPL_COUNT][MAX_POOL_SLAB_CLASS];
+} POOL_SLAB_CACHE;
+
 //
 // Globals
 //
@@ -82,6 +140,18 @@ POOL  mPoolHead[EfiMaxMemoryType];
 //
 LIST_ENTRY  mPoolHeadList = INITIALIZE_LIST_HEAD_VARIABLE (mPoolHeadList);
 
+//
+// Slabs and per-TPL magazines for each memory type below EfiMaxMemoryType.
+//
+STATIC POOL_SLAB_CACHE  mPoolSlabCache[EfiMaxMemoryType];
+
+STATIC
+VOID *
+CoreAllocatePoolFromMagazine (
+  IN EFI_MEMORY_TYPE  PoolType,
+  IN UINTN            Size
+  );
+
 /**
   Get pool size table index from the specified size.
 
@@ -107,6 +177,81 @@ GetPoolIndexFromSize (
   return MAX_POOL_LIST;
 }
 
+/**
+  Get slab class index from the specified size.
+
+  @param  Size          The size of the chunk, pool head and tail included.
+
+  @return               The index of slab size table.
+
+**/
+STATIC
+UINTN
+GetPoolSlabClassFromSize (
+  UINTN  Size
+  )
+{
+  UINTN  Class;
+
+  for (Class = 0; Class < MAX_POOL_SLAB_CLASS; Class++) {
+    if (mPoolSlabSizeTable[Class] >= Size) {
+      return Class;
+    }
+  }
+
+  return MAX_POOL_SLAB_CLASS;
+}
+
+/**
+  Get the magazine index for the current TPL.
+
+  @return The magazine index, or POOL_MAGAZINE_TPL_COUNT if the current TPL
+          has no magazine.
+
+**/
+STATIC
+UINTN
+GetPoolMagazineIndex (
+  VOID
+  )
+{
+  switch (gEfiCurrentTpl) {
+    case TPL_APPLICATION:
+      return 0;
+    case TPL_CALLBACK:
+      return 1;
+    case TPL_NOTIFY:
+      return 2;
+    default:
+      return POOL_MAGAZINE_TPL_COUNT;
+  }
+}
+
+/**
+  Get the granularity of the pages backing pool of the specified type.
+
+  @param  PoolType      The type of pool.
+
+  @return               The page allocation granularity.
+
+**/
+STATIC
+UINTN
+GetPoolGranularity (
+  IN EFI_MEMORY_TYPE  PoolType
+  )
+{
+  if ((PoolType == EfiACPIReclaimMemory) ||
+      (PoolType == EfiACPIMemoryNVS) ||
+      (PoolType == EfiRuntimeServicesCode) ||
+      (PoolType == EfiRuntimeServicesData))
+  {
+    return RUNTIME_PAGE_ALLOCATION_GRANULARITY;
+  }
+
+  return DEFAULT_PAGE_ALLOCATION_GRANULARITY;
+}
+
 /**
   Called to initialize the pool.
 
@@ -126,6 +271,10 @@ CoreInitializePool (
     for (Index = 0; Index < MAX_POOL_LIST; Index++) {
       InitializeListHead (&mPoolHead[Type].FreeList[Index]);
     }
+
+    for (Index = 0; Index < MAX_POOL_SLAB_CLASS; Index++) {
+      InitializeListHead (&mPoolSlabCache[Type].SlabList[Index]);
+    }
   }
 }
 
@@ -234,6 +383,16 @@ CoreInternalAllocatePool (
 
   NeedGuard = IsPoolTypeToGuard (PoolType) && !mOnGuarding;
 
+  //
+  // Small unguarded requests are served lock-free when possible
+  //
+  if (!NeedGuard) {
+    *Buffer = CoreAllocatePoolFromMagazine (PoolType, Size);
+    if (*Buffer != NULL) {
+      return EFI_SUCCESS;
+    }
+  }
+
   //
   // Acquire the memory lock and make the allocation
   //
@@ -336,6 +495,171 @@ CoreAllocatePoolPagesI (
   return Buffer;
 }
 
+/**
+  Internal function.  Takes a free chunk of the specified class out of the
+  slabs of a pool, carving a new slab from fresh pages if needed.
+  Caller must have the pool memory lock held.
+
+  @param  Pool                   The pool to allocate the chunk from
+  @param  Class                  The slab class of the chunk
+  @param  Granularity            The size of a slab
+
+  @return The allocated chunk, or NULL
+
+**/
+STATIC
+POOL_HEAD *
+CoreAllocatePoolSlabChunk (
+  IN POOL   *Pool,
+  IN UINTN  Class,
+  IN UINTN  Granularity
+  )
+{
+  LIST_ENTRY      *SlabList;
+  POOL_SLAB       *Slab;
+  POOL_SLAB_FREE  *Free;
+  UINTN           ChunkSize;
+  UINTN           Count;
+
+  ASSERT_LOCKED (&mPoolMemoryLock);
+  ASSERT ((UINT32)Pool->MemoryType < EfiMaxMemoryType);
+  ASSERT (Class < MAX_POOL_SLAB_CLASS);
+
+  SlabList  = &mPoolSlabCache[Pool->MemoryType].SlabList[Class];
+  ChunkSize = mPoolSlabSizeTable[Class];
+
+  if (IsListEmpty (SlabList)) {
+    Slab = CoreAllocatePoolPagesI (
+             Pool->MemoryType,
+             EFI_SIZE_TO_PAGES (Granularity),
+             Granularity,
+             FALSE
+             );
+    if (Slab == NULL) {
+      return NULL;
+    }
+
+    Slab->Signature = POOL_SLAB_SIGNATURE;
+    Slab->Class     = (UINT32)Class;
+    Slab->InUse     = 0;
+    Slab->FreeChunk = NULL;
+
+    //
+    // Chain the chunks so that they are handed out in address order
+    //
+    Count = (Granularity - POOL_SLAB_DATA_OFFSET) / ChunkSize;
+    while (Count > 0) {
+      Count--;
+      Free            = (POOL_SLAB_FREE *)((UINT8 *)Slab + POOL_SLAB_DATA_OFFSET + Count * ChunkSize);
+      Free->Signature = POOLSLAB_FREE_SIGNATURE;
+      Free->Next      = Slab->FreeChunk;
+      Slab->FreeChunk = Free;
+    }
+
+    InsertHeadList (SlabList, &Slab->Link);
+  }
+
+  Slab = CR (SlabList->ForwardLink, POOL_SLAB, Link, POOL_SLAB_SIGNATURE);
+  Free = Slab->FreeChunk;
+  ASSERT (Free != NULL);
+  ASSERT (Free->Signature == POOLSLAB_FREE_SIGNATURE);
+
+  Slab->FreeChunk = Free->Next;
+  Slab->InUse++;
+  if (Slab->FreeChunk == NULL) {
+    //
+    // Full slabs are not tracked; they go back on the list on the next free
+    //
+    RemoveEntryList (&Slab->Link);
+  }
+
+  Pool->Used += ChunkSize;
+  return (POOL_HEAD *)Free;
+}
+
+/**
+  Internal function.  Serves a small pool allocation from the magazine of the
+  current TPL without taking the pool memory lock. An empty magazine is
+  refilled from the slabs under the lock.
+
+  @param  PoolType               Type of pool to allocate
+  @param  Size                   The amount of pool to allocate
+
+  @return The allocated pool, or NULL if the request cannot be served from
+          a magazine.
+
+**/
+STATIC
+VOID *
+CoreAllocatePoolFromMagazine (
+  IN EFI_MEMORY_TYPE  PoolType,
+  IN UINTN            Size
+  )
+{
+  POOL_MAGAZINE  *Magazine;
+  POOL           *Pool;
+  POOL_HEAD      *Head;
+  POOL_TAIL      *Tail;
+  UINTN          TplIndex;
+  UINTN          Class;
+
+  if (!FeaturePcdGet (PcdDxeCorePoolSlabEnable) ||
+      ((UINT32)PoolType >= EfiMaxMemoryType) ||
+      IsHeapGuardEnabled (GUARD_HEAP_TYPE_FREED))
+  {
+    return NULL;
+  }
+
+  TplIndex = GetPoolMagazineIndex ();
+  if (TplIndex >= POOL_MAGAZINE_TPL_COUNT) {
+    return NULL;
+  }
+
+  Size = ALIGN_VARIABLE (Size) + POOL_OVERHEAD;
+  if (Size > MAX_POOL_SLAB_SIZE) {
+    return NULL;
+  }
+
+  Class    = GetPoolSlabClassFromSize (Size);
+  Magazine = &mPoolSlabCache[PoolType].Magazine[TplIndex][Class];
+
+  if (Magazine->Count == 0) {
+    if (EFI_ERROR (CoreAcquireLockOrFail (&mPoolMemoryLock))) {
+      return NULL;
+    }
+
+    Pool = LookupPoolHead (PoolType);
+    while ((Pool != NULL) && (Magazine->Count < POOL_MAGAZINE_DEPTH / 2)) {
+      Head = CoreAllocatePoolSlabChunk (Pool, Class, GetPoolGranularity (PoolType));
+      if (Head == NULL) {
+        break;
+      }
+
+      Magazine->Chunk[Magazine->Count++] = Head;
+    }
+
+    CoreReleaseLock (&mPoolMemoryLock);
+
+    if (Magazine->Count == 0) {
+      return NULL;
+    }
+  }
+
+  Head = Magazine->Chunk[--Magazine->Count];
+  ASSERT (Head->Signature == POOLSLAB_FREE_SIGNATURE);
+
+  Head->Signature = POOLSLAB_HEAD_SIGNATURE;
+  Head->Size      = Size;
+  Head->Type      = PoolType;
+  Tail            = HEAD_TO_TAIL (Head);
+  Tail->Signature = POOL_TAIL_SIGNATURE;
+  Tail->Size      = Size;
+
+  DEBUG_CLEAR_MEMORY (Head->Data, Size - POOL_OVERHEAD);
+
+  return Head->Data;
+}
+
 /**
   Internal function to allocate pool of a particular type.
   Caller must have the memory lock held
@@ -367,18 +691,11 @@ CoreAllocatePoolI (
   UINTN      Granularity;
   BOOLEAN    HasPoolTail;
   BOOLEAN    PageAsPool;
+  BOOLEAN    FromSlab;
 
   ASSERT_LOCKED (&mPoolMemoryLock);
 
-  if ((PoolType == EfiACPIReclaimMemory) ||
-      (PoolType == EfiACPIMemoryNVS) ||
-      (PoolType == EfiRuntimeServicesCode) ||
-      (PoolType == EfiRuntimeServicesData))
-  {
-    Granularity = RUNTIME_PAGE_ALLOCATION_GRANULARITY;
-  } else {
-    Granularity = DEFAULT_PAGE_ALLOCATION_GRANULARITY;
-  }
+  Granularity = GetPoolGranularity (PoolType);
 
   //
   // Adjust the size by the pool header & tail overhead
@@ -402,7 +719,20 @@ CoreAllocatePoolI (
     return NULL;
   }
 
-  Head = NULL;
+  Head     = NULL;
+  FromSlab = FALSE;
+
+  //
+  // Small unguarded allocations of the standard memory types come from slabs
+  //
+  if (FeaturePcdGet (PcdDxeCorePoolSlabEnable) &&
+      ((UINT32)PoolType < EfiMaxMemoryType) &&
+      (Size <= MAX_POOL_SLAB_SIZE) && !NeedGuard && !PageAsPool)
+  {
+    Head     = CoreAllocatePoolSlabChunk (Pool, GetPoolSlabClassFromSize (Size), Granularity);
+    FromSlab = TRUE;
+    goto Done;
+  }
 
   //
   // If allocation is over max size, just allocate pages for the request
@@ -498,17 +828,24 @@ Done:
 
   if (Head != NULL) {
     //
-    // Account the allocation
+    // Account the allocation. Slab chunks are accounted by the slab.
     //
-    Pool->Used += Size;
+    if (!FromSlab) {
+      Pool->Used += Size;
+    }
 
     //
     // If we have a pool buffer, fill in the header & tail info
     //
-    Head->Signature = (PageAsPool) ? POOLPAGE_HEAD_SIGNATURE : POOL_HEAD_SIGNATURE;
-    Head->Size      = Size;
-    Head->Type      = (EFI_MEMORY_TYPE)PoolType;
-    Buffer          = Head->Data;
+    if (FromSlab) {
+      Head->Signature = POOLSLAB_HEAD_SIGNATURE;
+    } else {
+      Head->Signature = (PageAsPool) ? POOLPAGE_HEAD_SIGNATURE : POOL_HEAD_SIGNATURE;
+    }
+
+    Head->Size = Size;
+    Head->Type = (EFI_MEMORY_TYPE)PoolType;
+    Buffer     = Head->Data;
 
     if (HasPoolTail) {
       Tail            = HEAD_TO_TAIL (Head);
@@ -537,6 +874,70 @@ Done:
   return Buffer;
 }
 
+/**
+  Internal function.  Returns a slab chunk to the magazine of the current TPL
+  without taking the pool memory lock.
+
+  @param  Buffer                 The allocated pool entry to free
+  @param  PoolType               Pointer to pool type
+
+  @retval TRUE                   The chunk was placed in a magazine.
+  @retval FALSE                  Buffer is not a slab chunk or the magazine is
+                                 full; it must be freed by CoreFreePoolI().
+
+**/
+STATIC
+BOOLEAN
+CoreFreePoolToMagazine (
+  IN VOID              *Buffer,
+  OUT EFI_MEMORY_TYPE  *PoolType OPTIONAL
+  )
+{
+  POOL_HEAD      *Head;
+  POOL_TAIL      *Tail;
+  POOL_SLAB      *Slab;
+  POOL_MAGAZINE  *Magazine;
+  UINTN          TplIndex;
+
+  Head = BASE_CR (Buffer, POOL_HEAD, Data);
+  if ((Head->Signature != POOLSLAB_HEAD_SIGNATURE) ||
+      ((UINT32)Head->Type >= EfiMaxMemoryType) ||
+      (Head->Size > MAX_POOL_SLAB_SIZE))
+  {
+    return FALSE;
+  }
+
+  Tail = HEAD_TO_TAIL (Head);
+  if ((Tail->Signature != POOL_TAIL_SIGNATURE) || (Tail->Size != Head->Size)) {
+    return FALSE;
+  }
+
+  TplIndex = GetPoolMagazineIndex ();
+  if (TplIndex >= POOL_MAGAZINE_TPL_COUNT) {
+    return FALSE;
+  }
+
+  Slab = (POOL_SLAB *)((UINTN)Head & ~(GetPoolGranularity (Head->Type) - 1));
+  if (Slab->Signature != POOL_SLAB_SIGNATURE) {
+    return FALSE;
+  }
+
+  Magazine = &mPoolSlabCache[Head->Type].Magazine[TplIndex][Slab->Class];
+  if (Magazine->Count >= POOL_MAGAZINE_DEPTH) {
+    return FALSE;
+  }
+
+  if (PoolType != NULL) {
+    *PoolType = Head->Type;
+  }
+
+  DEBUG_CLEAR_MEMORY (Head, Head->Size);
+  Head->Signature = POOLSLAB_FREE_SIGNATURE;
+
+  Magazine->Chunk[Magazine->Count++] = Head;
+  return TRUE;
+}
+
 /**
   Frees pool.
 
@@ -560,6 +961,12 @@ CoreInternalFreePool (
     return EFI_INVALID_PARAMETER;
   }
 
+  if (FeaturePcdGet (PcdDxeCorePoolSlabEnable) &&
+      CoreFreePoolToMagazine (Buffer, PoolType))
+  {
+    return EFI_SUCCESS;
+  }
+
   CoreAcquireLock (&mPoolMemoryLock);
   Status = CoreFreePoolI (Buffer, PoolType);
   CoreReleaseLock (&mPoolMemoryLock);
@@ -665,6 +1072,71 @@ CoreFreePoolPagesWithGuard (
   }
 }
 
+/**
+  Internal function.  Returns a chunk to its slab, and frees the slab pages
+  once all of its chunks are free and another slab of the same class has
+  free chunks.
+  Caller must have the pool memory lock held.
+
+  @param  Pool                   The pool owning the chunk
+  @param  Head                   The chunk to free
+
+  @retval EFI_INVALID_PARAMETER  Head is not part of a slab.
+  @retval EFI_SUCCESS            The chunk was returned to its slab.
+
+**/
+STATIC
+EFI_STATUS
+CoreFreePoolSlabChunk (
+  IN POOL       *Pool,
+  IN POOL_HEAD  *Head
+  )
+{
+  POOL_SLAB       *Slab;
+  POOL_SLAB_FREE  *Free;
+  LIST_ENTRY      *SlabList;
+  UINTN           Granularity;
+
+  ASSERT_LOCKED (&mPoolMemoryLock);
+
+  Granularity = GetPoolGranularity (Pool->MemoryType);
+  Slab        = (POOL_SLAB *)((UINTN)Head & ~(Granularity - 1));
+  if ((Slab->Signature != POOL_SLAB_SIGNATURE) || (Slab->InUse == 0)) {
+    ASSERT (Slab->Signature == POOL_SLAB_SIGNATURE);
+    ASSERT (Slab->InUse != 0);
+    return EFI_INVALID_PARAMETER;
+  }
+
+  SlabList = &mPoolSlabCache[Pool->MemoryType].SlabList[Slab->Class];
+
+  Free            = (POOL_SLAB_FREE *)Head;
+  Free->Signature = POOLSLAB_FREE_SIGNATURE;
+  Free->Next      = Slab->FreeChunk;
+  if (Slab->FreeChunk == NULL) {
+    InsertHeadList (SlabList, &Slab->Link);
+  }
+
+  Slab->FreeChunk = Free;
+  Slab->InUse--;
+  Pool->Used -= mPoolSlabSizeTable[Slab->Class];
+
+  //
+  // Keep the last slab of a class around to avoid thrashing pages on
+  // alternating allocate/free sequences
+  //
+  if ((Slab->InUse == 0) && (SlabList->ForwardLink != SlabList->BackLink)) {
+    RemoveEntryList (&Slab->Link);
+    Slab->Signature = 0;
+    CoreFreePoolPagesI (
+      Pool->MemoryType,
+      (EFI_PHYSICAL_ADDRESS)(UINTN)Slab,
+      EFI_SIZE_TO_PAGES (Granularity)
+      );
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Internal function to free a pool entry.
   Caller must have the memory lock held
@@ -705,11 +1177,13 @@ CoreFreePoolI (
   ASSERT (Head != NULL);
 
   if ((Head->Signature != POOL_HEAD_SIGNATURE) &&
-      (Head->Signature != POOLPAGE_HEAD_SIGNATURE))
+      (Head->Signature != POOLPAGE_HEAD_SIGNATURE) &&
+      (Head->Signature != POOLSLAB_HEAD_SIGNATURE))
   {
     ASSERT (
       Head->Signature == POOL_HEAD_SIGNATURE ||
-      Head->Signature == POOLPAGE_HEAD_SIGNATURE
+      Head->Signature == POOLPAGE_HEAD_SIGNATURE ||
+      Head->Signature == POOLSLAB_HEAD_SIGNATURE
       );
     return EFI_INVALID_PARAMETER;
   }
@@ -750,18 +1224,20 @@ CoreFreePoolI (
     return EFI_INVALID_PARAMETER;
   }
 
+  if (Head->Signature == POOLSLAB_HEAD_SIGNATURE) {
+    if (PoolType != NULL) {
+      *PoolType = Head->Type;
+    }
+
+    DEBUG ((DEBUG_POOL, "FreePool: %p (len %lx) slab\n", Head->Data, (UINT64)(Head->Size - POOL_OVERHEAD)));
+    DEBUG_CLEAR_MEMORY (Head, Size);
+    return CoreFreePoolSlabChunk (Pool, Head);
+  }
+
   Pool->Used -= Size;
   DEBUG ((DEBUG_POOL, "FreePool: %p (len %lx) %,ld\n", Head->Data, (UINT64)(Head->Size - POOL_OVERHEAD), (UINT64)Pool->Used));
 
-  if ((Head->Type == EfiACPIReclaimMemory) ||
-      (Head->Type == EfiACPIMemoryNVS) ||
-      (Head->Type == EfiRuntimeServicesCode) ||
-      (Head->Type == EfiRuntimeServicesData))
-  {
-    Granularity = RUNTIME_PAGE_ALLOCATION_GRANULARITY;
-  } else {
-    Granularity = DEFAULT_PAGE_ALLOCATION_GRANULARITY;
-  }
+  Granularity = GetPoolGranularity (Head->Type);
 
   if (PoolType != NULL) {
     *PoolType = Head->Type;
@@ -0,0 +1,530 @@
+/** @file
+  Intrusive red-black tree used by the DXE Core memory and GCD maps.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeMain.h"
+#include "RedBlackTree.h"
+
+/**
+  Recomputes the per subtree data of a single element.
+
+  @param  Tree                   The tree Node is on
+  @param  Node                   The node of the element, or NULL
+
+**/
+STATIC
+VOID
+RbTreeAugment (
+  IN RB_TREE       *Tree,
+  IN RB_TREE_NODE  *Node
+  )
+{
+  if ((Tree->Augment != NULL) && (Node != NULL)) {
+    Tree->Augment (Node);
+  }
+}
+
+/**
+  Links a node in the place of another one in the parent of the latter.
+
+  @param  Tree                   The tree
+  @param  OldNode                The node whose parent link is taken over
+  @param  NewNode                The node to link, or NULL
+
+**/
+STATIC
+VOID
+RbTreeReplaceChild (
+  IN OUT RB_TREE       *Tree,
+  IN     RB_TREE_NODE  *OldNode,
+  IN OUT RB_TREE_NODE  *NewNode
+  )
+{
+  RB_TREE_NODE  *Parent;
+
+  Parent = OldNode->Parent;
+  if (Parent == NULL) {
+    Tree->Root = NewNode;
+  } else if (Parent->Left == OldNode) {
+    Parent->Left = NewNode;
+  } else {
+    Parent->Right = NewNode;
+  }
+
+  if (NewNode != NULL) {
+    NewNode->Parent = Parent;
+  }
+}
+
+/**
+  Rotates a subtree to the left. The right child of Node takes its place.
+
+  @param  Tree                   The tree
+  @param  Node                   The root of the subtree to rotate
+
+**/
+STATIC
+VOID
+RbTreeRotateLeft (
+  IN OUT RB_TREE       *Tree,
+  IN OUT RB_TREE_NODE  *Node
+  )
+{
+  RB_TREE_NODE  *Pivot;
+
+  Pivot = Node->Right;
+  RbTreeReplaceChild (Tree, Node, Pivot);
+
+  Node->Right = Pivot->Left;
+  if (Node->Right != NULL) {
+    Node->Right->Parent = Node;
+  }
+
+  Pivot->Left  = Node;
+  Node->Parent = Pivot;
+
+  //
+  // The subtree holds the same elements, so only the two rotated nodes
+  // need their aggregated data recomputed
+  //
+  RbTreeAugment (Tree, Node);
+  RbTreeAugment (Tree, Pivot);
+}
+
+/**
+  Rotates a subtree to the right. The left child of Node takes its place.
+
+  @param  Tree                   The tree
+  @param  Node                   The root of the subtree to rotate
+
+**/
+STATIC
+VOID
+RbTreeRotateRight (
+  IN OUT RB_TREE       *Tree,
+  IN OUT RB_TREE_NODE  *Node
+  )
+{
+  RB_TREE_NODE  *Pivot;
+
+  Pivot = Node->Left;
+  RbTreeReplaceChild (Tree, Node, Pivot);
+
+  Node->Left = Pivot->Right;
+  if (Node->Left != NULL) {
+    Node->Left->Parent = Node;
+  }
+
+  Pivot->Right = Node;
+  Node->Parent = Pivot;
+
+  RbTreeAugment (Tree, Node);
+  RbTreeAugment (Tree, Pivot);
+}
+
+/**
+  Returns TRUE if a node is a red node.
+
+  @param  Node                   The node, or NULL for a leaf
+
+  @retval TRUE                   The node is red.
+  @retval FALSE                  The node is black or a leaf.
+
+**/
+STATIC
+BOOLEAN
+RbTreeIsRed (
+  IN CONST RB_TREE_NODE  *Node
+  )
+{
+  return (BOOLEAN)((Node != NULL) && Node->Red);
+}
+
+/**
+  Recomputes the per subtree data from an element up to the root, after the
+  element changed without changing its position in the tree.
+
+  @param  Tree                   The tree Node is on
+  @param  Node                   The node of the element that changed
+
+**/
+VOID
+CoreRbTreeUpdate (
+  IN RB_TREE       *Tree,
+  IN RB_TREE_NODE  *Node
+  )
+{
+  if (Tree->Augment == NULL) {
+    return;
+  }
+
+  for ( ; Node != NULL; Node = Node->Parent) {
+    Tree->Augment (Node);
+  }
+}
+
+/**
+  Inserts an element into a tree. Elements with equal keys are kept in
+  insertion order.
+
+  @param  Tree                   The tree to insert into
+  @param  Node                   The node of the element to insert
+
+**/
+VOID
+CoreRbTreeInsert (
+  IN OUT RB_TREE       *Tree,
+  IN OUT RB_TREE_NODE  *Node
+  )
+{
+  RB_TREE_NODE  *Parent;
+  RB_TREE_NODE  **Link;
+  RB_TREE_NODE  *GrandParent;
+  RB_TREE_NODE  *Uncle;
+
+  Parent = NULL;
+  Link   = &Tree->Root;
+  while (*Link != NULL) {
+    Parent = *Link;
+    if (Tree->Compare (Node, Parent) < 0) {
+      Link = &Parent->Left;
+    } else {
+      Link = &Parent->Right;
+    }
+  }
+
+  Node->Parent = Parent;
+  Node->Left   = NULL;
+  Node->Right  = NULL;
+  Node->Red    = TRUE;
+  *Link        = Node;
+
+  CoreRbTreeUpdate (Tree, Node);
+
+  //
+  // Restore the red-black properties
+  //
+  while (RbTreeIsRed (Node->Parent)) {
+    Parent      = Node->Parent;
+    GrandParent = Parent->Parent;
+    if (Parent == GrandParent->Left) {
+      Uncle = GrandParent->Right;
+      if (RbTreeIsRed (Uncle)) {
+        Parent->Red      = FALSE;
+        Uncle->Red       = FALSE;
+        GrandParent->Red = TRUE;
+        Node             = GrandParent;
+        continue;
+      }
+
+      if (Node == Parent->Right) {
+        RbTreeRotateLeft (Tree, Parent);
+        Node   = Parent;
+        Parent = Node->Parent;
+      }
+
+      Parent->Red      = FALSE;
+      GrandParent->Red = TRUE;
+      RbTreeRotateRight (Tree, GrandParent);
+    } else {
+      Uncle = GrandParent->Left;
+      if (RbTreeIsRed (Uncle)) {
+        Parent->Red      = FALSE;
+        Uncle->Red       = FALSE;
+        GrandParent->Red = TRUE;
+        Node             = GrandParent;
+        continue;
+      }
+
+      if (Node == Parent->Left) {
+        RbTreeRotateRight (Tree, Parent);
+        Node   = Parent;
+        Parent = Node->Parent;
+      }
+
+      Parent->Red      = FALSE;
+      GrandParent->Red = TRUE;
+      RbTreeRotateLeft (Tree, GrandParent);
+    }
+  }
+
+  Tree->Root->Red = FALSE;
+}
+
+/**
+  Removes an element from a tree.
+
+  @param  Tree                   The tree to remove from
+  @param  Node                   The node of the element to remove
+
+**/
+VOID
+CoreRbTreeDelete (
+  IN OUT RB_TREE       *Tree,
+  IN OUT RB_TREE_NODE  *Node
+  )
+{
+  RB_TREE_NODE  *Child;
+  RB_TREE_NODE  *Parent;
+  RB_TREE_NODE  *Successor;
+  RB_TREE_NODE  *Sibling;
+  BOOLEAN       RemovedRed;
+
+  if ((Node->Left != NULL) && (Node->Right != NULL)) {
+    //
+    // Move the in-order successor, which has no left child, into the place
+    // of Node, and remove it from its own place instead
+    //
+    for (Successor = Node->Right; Successor->Left != NULL; Successor = Successor->Left) {
+    }
+
+    RemovedRed = Successor->Red;
+    Child      = Successor->Right;
+    if (Successor->Parent == Node) {
+      Parent = Successor;
+    } else {
+      Parent       = Successor->Parent;
+      Parent->Left = Child;
+      if (Child != NULL) {
+        Child->Parent = Parent;
+      }
+
+      Successor->Right         = Node->Right;
+      Successor->Right->Parent = Successor;
+    }
+
+    RbTreeReplaceChild (Tree, Node, Successor);
+    Successor->Left         = Node->Left;
+    Successor->Left->Parent = Successor;
+    Successor->Red          = Node->Red;
+  } else {
+    RemovedRed = Node->Red;
+    Child      = (Node->Left != NULL) ? Node->Left : Node->Right;
+    Parent     = Node->Parent;
+    RbTreeReplaceChild (Tree, Node, Child);
+  }
+
+  CoreRbTreeUpdate (Tree, Parent);
+
+  Node->Parent = NULL;
+  Node->Left   = NULL;
+  Node->Right  = NULL;
+
+  if (RemovedRed) {
+    return;
+  }
+
+  //
+  // A black node was removed above Child, restore the red-black properties
+  //
+  while ((Child != Tree->Root) && !RbTreeIsRed (Child)) {
+    if (Child == Parent->Left) {
+      Sibling = Parent->Right;
+      if (RbTreeIsRed (Sibling)) {
+        Sibling->Red = FALSE;
+        Parent->Red  = TRUE;
+        RbTreeRotateLeft (Tree, Parent);
+        Sibling = Parent->Right;
+      }
+
+      if (!RbTreeIsRed (Sibling->Left) && !RbTreeIsRed (Sibling->Right)) {
+        Sibling->Red = TRUE;
+        Child        = Parent;
+        Parent       = Child->Parent;
+        continue;
+      }
+
+      if (!RbTreeIsRed (Sibling->Right)) {
+        Sibling->Left->Red = FALSE;
+        Sibling->Red       = TRUE;
+        RbTreeRotateRight (Tree, Sibling);
+        Sibling = Parent->Right;
+      }
+
+      Sibling->Red        = Parent->Red;
+      Parent->Red         = FALSE;
+      Sibling->Right->Red = FALSE;
+      RbTreeRotateLeft (Tree, Parent);
+      Child = Tree->Root;
+    } else {
+      Sibling = Parent->Left;
+      if (RbTreeIsRed (Sibling)) {
+        Sibling->Red = FALSE;
+        Parent->Red  = TRUE;
+        RbTreeRotateRight (Tree, Parent);
+        Sibling = Parent->Left;
+      }
+
+      if (!RbTreeIsRed (Sibling->Left) && !RbTreeIsRed (Sibling->Right)) {
+        Sibling->Red = TRUE;
+        Child        = Parent;
+        Parent       = Child->Parent;
+        continue;
+      }
+
+      if (!RbTreeIsRed (Sibling->Left)) {
+        Sibling->Right->Red = FALSE;
+        Sibling->Red        = TRUE;
+        RbTreeRotateLeft (Tree, Sibling);
+        Sibling = Parent->Left;
+      }
+
+      Sibling->Red       = Parent->Red;
+      Parent->Red        = FALSE;
+      Sibling->Left->Red = FALSE;
+      RbTreeRotateRight (Tree, Parent);
+      Child = Tree->Root;
+    }
+  }
+
+  if (Child != NULL) {
+    Child->Red = FALSE;
+  }
+}
+
+/**
+  Puts an element in the place of another one with the same key, for
+  instance when an element is moved to a different buffer.
+
+  @param  Tree                   The tree OldNode is on
+  @param  OldNode                The node of the element to replace
+  @param  NewNode                The node of the replacing element
+
+**/
+VOID
+CoreRbTreeReplace (
+  IN OUT RB_TREE       *Tree,
+  IN OUT RB_TREE_NODE  *OldNode,
+  IN OUT RB_TREE_NODE  *NewNode
+  )
+{
+  RbTreeReplaceChild (Tree, OldNode, NewNode);
+  NewNode->Left  = OldNode->Left;
+  NewNode->Right = OldNode->Right;
+  NewNode->Red   = OldNode->Red;
+  if (NewNode->Left != NULL) {
+    NewNode->Left->Parent = NewNode;
+  }
+
+  if (NewNode->Right != NULL) {
+    NewNode->Right->Parent = NewNode;
+  }
+
+  OldNode->Parent = NULL;
+  OldNode->Left   = NULL;
+  OldNode->Right  = NULL;
+
+  CoreRbTreeUpdate (Tree, NewNode);
+}
+
+/**
+  Returns the first element of a tree.
+
+  @param  Tree                   The tree
+
+  @return The node of the first element, or NULL if the tree is empty
+
+**/
+RB_TREE_NODE *
+CoreRbTreeFirst (
+  IN CONST RB_TREE  *Tree
+  )
+{
+  RB_TREE_NODE  *Node;
+
+  Node = Tree->Root;
+  if (Node != NULL) {
+    while (Node->Left != NULL) {
+      Node = Node->Left;
+    }
+  }
+
+  return Node;
+}
+
+/**
+  Returns the last element of a tree.
+
+  @param  Tree                   The tree
+
+  @return The node of the last element, or NULL if the tree is empty
+
+**/
+RB_TREE_NODE *
+CoreRbTreeLast (
+  IN CONST RB_TREE  *Tree
+  )
+{
+  RB_TREE_NODE  *Node;
+
+  Node = Tree->Root;
+  if (Node != NULL) {
+    while (Node->Right != NULL) {
+      Node = Node->Right;
+    }
+  }
+
+  return Node;
+}
+
+/**
+  Returns the element that follows another one in a tree.
+
+  @param  Node                   The node of the element
+
+  @return The node of the next element, or NULL if Node is the last one
+
+**/
+RB_TREE_NODE *
+CoreRbTreeNext (
+  IN CONST RB_TREE_NODE  *Node
+  )
+{
+  RB_TREE_NODE  *Next;
+
+  if (Node->Right != NULL) {
+    for (Next = Node->Right; Next->Left != NULL; Next = Next->Left) {
+    }
+
+    return Next;
+  }
+
+  for (Next = Node->Parent; (Next != NULL) && (Node == Next->Right); Next = Next->Parent) {
+    Node = Next;
+  }
+
+  return Next;
+}
+
+/**
+  Returns the element that precedes another one in a tree.
+
+  @param  Node                   The node of the element
+
+  @return The node of the previous element, or NULL if Node is the first one
+
+**/
+RB_TREE_NODE *
+CoreRbTreePrev (
+  IN CONST RB_TREE_NODE  *Node
+  )
+{
+  RB_TREE_NODE  *Prev;
+
+  if (Node->Left != NULL) {
+    for (Prev = Node->Left; Prev->Right != NULL; Prev = Prev->Right) {
+    }
+
+    return Prev;
+  }
+
+  for (Prev = Node->Parent; (Prev != NULL) && (Node == Prev->Left); Prev = Prev->Parent) {
+    Node = Prev;
+  }
+
+  return Prev;
+}
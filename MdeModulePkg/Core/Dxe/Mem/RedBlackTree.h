@@ -0,0 +1,181 @@
+/** @file
+  Intrusive red-black tree used by the DXE Core memory and GCD maps.
+
+  The tree nodes are embedded in the map descriptors, so inserting and
+  removing descriptors never allocates memory. This allows the tree to be
+  maintained while the memory map lock is held and the page allocator
+  cannot be re-entered.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _RED_BLACK_TREE_H_
+#define _RED_BLACK_TREE_H_
+
+typedef struct _RB_TREE_NODE RB_TREE_NODE;
+
+///
+/// RB_TREE_NODE - embedded in each element of a tree
+///
+struct _RB_TREE_NODE {
+  RB_TREE_NODE    *Parent;
+  RB_TREE_NODE    *Left;
+  RB_TREE_NODE    *Right;
+  BOOLEAN         Red;
+};
+
+/**
+  Compares the keys of two tree elements.
+
+  @param  Node1                  The node of the first element
+  @param  Node2                  The node of the second element
+
+  @retval <0                     The first element sorts before the second one.
+  @retval 0                      The elements have the same key.
+  @retval >0                     The first element sorts after the second one.
+
+**/
+typedef
+INTN
+(*RB_TREE_COMPARE)(
+  IN CONST RB_TREE_NODE  *Node1,
+  IN CONST RB_TREE_NODE  *Node2
+  );
+
+/**
+  Recomputes the data a tree element aggregates over its subtree from the
+  element itself and from its two children.
+
+  @param  Node                   The node of the element to update
+
+**/
+typedef
+VOID
+(*RB_TREE_AUGMENT)(
+  IN RB_TREE_NODE  *Node
+  );
+
+///
+/// RB_TREE - the root of a tree, with the callbacks that order the elements
+/// and maintain the per subtree data (Augment may be NULL)
+///
+typedef struct {
+  RB_TREE_NODE       *Root;
+  RB_TREE_COMPARE    Compare;
+  RB_TREE_AUGMENT    Augment;
+} RB_TREE;
+
+#define INITIALIZE_RB_TREE(Compare, Augment)  { NULL, (Compare), (Augment) }
+
+/**
+  Inserts an element into a tree. Elements with equal keys are kept in
+  insertion order.
+
+  @param  Tree                   The tree to insert into
+  @param  Node                   The node of the element to insert
+
+**/
+VOID
+CoreRbTreeInsert (
+  IN OUT RB_TREE       *Tree,
+  IN OUT RB_TREE_NODE  *Node
+  );
+
+/**
+  Removes an element from a tree.
+
+  @param  Tree                   The tree to remove from
+  @param  Node                   The node of the element to remove
+
+**/
+VOID
+CoreRbTreeDelete (
+  IN OUT RB_TREE       *Tree,
+  IN OUT RB_TREE_NODE  *Node
+  );
+
+/**
+  Puts an element in the place of another one with the same key, for
+  instance when an element is moved to a different buffer.
+
+  @param  Tree                   The tree OldNode is on
+  @param  OldNode                The node of the element to replace
+  @param  NewNode                The node of the replacing element
+
+**/
+VOID
+CoreRbTreeReplace (
+  IN OUT RB_TREE       *Tree,
+  IN OUT RB_TREE_NODE  *OldNode,
+  IN OUT RB_TREE_NODE  *NewNode
+  );
+
+/**
+  Recomputes the per subtree data from an element up to the root, after the
+  element changed without changing its position in the tree.
+
+  @param  Tree                   The tree Node is on
+  @param  Node                   The node of the element that changed
+
+**/
+VOID
+CoreRbTreeUpdate (
+  IN RB_TREE       *Tree,
+  IN RB_TREE_NODE  *Node
+  );
+
+/**
+  Returns the first element of a tree.
+
+  @param  Tree                   The tree
+
+  @return The node of the first element, or NULL if the tree is empty
+
+**/
+RB_TREE_NODE *
+CoreRbTreeFirst (
+  IN CONST RB_TREE  *Tree
+  );
+
+/**
+  Returns the last element of a tree.
+
+  @param  Tree                   The tree
+
+  @return The node of the last element, or NULL if the tree is empty
+
+**/
+RB_TREE_NODE *
+CoreRbTreeLast (
+  IN CONST RB_TREE  *Tree
+  );
+
+/**
+  Returns the element that follows another one in a tree.
+
+  @param  Node                   The node of the element
+
+  @return The node of the next element, or NULL if Node is the last one
+
+**/
+RB_TREE_NODE *
+CoreRbTreeNext (
+  IN CONST RB_TREE_NODE  *Node
+  );
+
+/**
+  Returns the element that precedes another one in a tree.
+
+  @param  Node                   The node of the element
+
+  @return The node of the previous element, or NULL if Node is the first one
+
+**/
+RB_TREE_NODE *
+CoreRbTreePrev (
+  IN CONST RB_TREE_NODE  *Node
+  );
+
+#endif
@@ -0,0 +1,585 @@
+/** @file
+  Host based unit test and micro-benchmark of the DXE Core GCD memory space
+  map.
+
+  The GCD services are built against stubs of the memory map, HOB and CPU
+  architectural protocol services. A storm of SetMemorySpaceAttributes()
+  requests on random page ranges, as issued by drivers that protect image
+  sections and page tables, is replayed against the map and checked against
+  a per page copy of the attributes. Top down allocations are checked
+  against the expected addresses.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "DxeMain.h"
+#include "Mem/Imem.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "DXE Core GCD Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define GCD_TEST_ADDRESS_BITS       48
+#define GCD_TEST_MEMORY_BASE        0x100000000ULL
+#define GCD_TEST_MEMORY_PAGES       0x10000
+#define GCD_TEST_MMIO_BASE          0x800000000ULL
+#define GCD_TEST_MMIO_WINDOW_SIZE   SIZE_1MB
+#define GCD_TEST_MMIO_WINDOW_COUNT  32
+#define GCD_TEST_MMIO_ALLOC_SIZE    SIZE_256KB
+#define GCD_TEST_STORM_REQUESTS     100000
+#define GCD_TEST_CHECK_INTERVAL     1024
+
+#define GCD_TEST_CAPABILITIES  (EFI_MEMORY_UC | EFI_MEMORY_WB | EFI_MEMORY_RP | EFI_MEMORY_RO | EFI_MEMORY_XP)
+
+UINT64  mGcdTestAttributes[GCD_TEST_MEMORY_PAGES];
+UINTN   mGcdTestCpuRequests;
+
+extern LIST_ENTRY         mGcdMemorySpaceMap;
+extern RB_TREE            mGcdMemorySpaceTree;
+extern EFI_GCD_MAP_ENTRY  mGcdMemorySpaceMapEntryTemplate;
+
+///
+/// === STUBS OF THE DXE CORE SERVICES USED BY THE GCD SERVICES =================
+///
+
+EFI_HANDLE                   gDxeCoreImageHandle = (EFI_HANDLE)(UINTN)0xD0CE;
+BOOLEAN                      mOnGuarding         = FALSE;
+VOID                         *gHobList           = NULL;
+EFI_MEMORY_TYPE_INFORMATION  gMemoryTypeInformation[EfiMaxMemoryType + 1];
+EFI_CPU_ARCH_PROTOCOL        mGcdTestCpu;
+EFI_CPU_ARCH_PROTOCOL        *gCpu = &mGcdTestCpu;
+
+VOID
+CoreAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockReleased);
+  Lock->Lock = EfiLockAcquired;
+}
+
+VOID
+CoreReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock = EfiLockReleased;
+}
+
+EFI_STATUS
+EFIAPI
+CoreFreePool (
+  IN VOID  *Buffer
+  )
+{
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
+
+VOID
+CoreInitializePool (
+  VOID
+  )
+{
+}
+
+VOID
+CoreAddMemoryDescriptor (
+  IN EFI_MEMORY_TYPE       Type,
+  IN EFI_PHYSICAL_ADDRESS  Start,
+  IN UINT64                NumberOfPages,
+  IN UINT64                Attribute
+  )
+{
+}
+
+VOID
+CoreUpdateMemoryAttributes (
+  IN EFI_PHYSICAL_ADDRESS  Start,
+  IN UINT64                NumberOfPages,
+  IN UINT64                NewAttributes
+  )
+{
+}
+
+VOID *
+EFIAPI
+GetFirstHob (
+  IN UINT16  Type
+  )
+{
+  return NULL;
+}
+
+VOID *
+EFIAPI
+GetNextHob (
+  IN UINT16      Type,
+  IN CONST VOID  *HobStart
+  )
+{
+  return NULL;
+}
+
+VOID *
+EFIAPI
+GetFirstGuidHob (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  return NULL;
+}
+
+EFI_STATUS
+EFIAPI
+GcdTestSetMemoryAttributes (
+  IN EFI_CPU_ARCH_PROTOCOL  *This,
+  IN EFI_PHYSICAL_ADDRESS   BaseAddress,
+  IN UINT64                 Length,
+  IN UINT64                 Attributes
+  )
+{
+  mGcdTestCpuRequests++;
+  return EFI_SUCCESS;
+}
+
+///
+/// === TEST CASES ==============================================================
+///
+
+/**
+  Return a pseudo random number.
+
+  @param[in, out]  Seed  The generator state.
+
+  @return The next pseudo random number.
+**/
+STATIC
+UINT32
+GcdTestRandom (
+  IN OUT UINT32  *Seed
+  )
+{
+  *Seed = *Seed * 1103515245 + 12345;
+  return (*Seed >> 16) & 0x7FFF;
+}
+
+/**
+  Check the red-black tree properties of a subtree of the GCD memory space
+  tree.
+
+  @param[in]  Node        The root of the subtree.
+  @param[out] BlackDepth  The number of black nodes on each path of the subtree.
+
+  @retval  TRUE   The subtree is valid.
+  @retval  FALSE  The subtree is invalid.
+**/
+STATIC
+BOOLEAN
+GcdTestCheckSubtree (
+  IN  RB_TREE_NODE  *Node,
+  OUT UINTN         *BlackDepth
+  )
+{
+  UINTN  LeftDepth;
+  UINTN  RightDepth;
+
+  if (Node == NULL) {
+    *BlackDepth = 1;
+    return TRUE;
+  }
+
+  if (!GcdTestCheckSubtree (Node->Left, &LeftDepth) ||
+      !GcdTestCheckSubtree (Node->Right, &RightDepth) ||
+      (LeftDepth != RightDepth))
+  {
+    return FALSE;
+  }
+
+  if ((Node->Left != NULL) && ((Node->Left->Parent != Node) || (Node->Red && Node->Left->Red))) {
+    return FALSE;
+  }
+
+  if ((Node->Right != NULL) && ((Node->Right->Parent != Node) || (Node->Red && Node->Right->Red))) {
+    return FALSE;
+  }
+
+  *BlackDepth = LeftDepth + (Node->Red ? 0 : 1);
+  return TRUE;
+}
+
+/**
+  Check that the GCD memory space map covers the address space without holes,
+  that adjacent entries cannot be merged, that the tree holds the entries of
+  the list in the same order, and that the attributes of the test memory match
+  the per page copy.
+
+  @param[out] EntryCount  The number of entries of the map.
+
+  @retval  UNIT_TEST_PASSED             The map is valid.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The map is invalid.
+**/
+STATIC
+UNIT_TEST_STATUS
+GcdTestCheckMemorySpaceMap (
+  OUT UINTN  *EntryCount
+  )
+{
+  LIST_ENTRY         *Link;
+  RB_TREE_NODE       *Node;
+  EFI_GCD_MAP_ENTRY  *Entry;
+  EFI_GCD_MAP_ENTRY  *Previous;
+  UINT64             Address;
+  UINTN              Page;
+  UINTN              BlackDepth;
+
+  UT_ASSERT_TRUE (GcdTestCheckSubtree (mGcdMemorySpaceTree.Root, &BlackDepth));
+
+  *EntryCount = 0;
+  Previous    = NULL;
+  Address     = 0;
+  Node        = CoreRbTreeFirst (&mGcdMemorySpaceTree);
+  for (Link = mGcdMemorySpaceMap.ForwardLink; Link != &mGcdMemorySpaceMap; Link = Link->ForwardLink) {
+    Entry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
+    UT_ASSERT_EQUAL (Entry->BaseAddress, Address);
+    UT_ASSERT_TRUE (Entry->EndAddress >= Entry->BaseAddress);
+    UT_ASSERT_TRUE (Node == &Entry->Node);
+    if (Previous != NULL) {
+      UT_ASSERT_FALSE (
+        (Previous->Capabilities == Entry->Capabilities) &&
+        (Previous->Attributes == Entry->Attributes) &&
+        (Previous->GcdMemoryType == Entry->GcdMemoryType) &&
+        (Previous->ImageHandle == Entry->ImageHandle) &&
+        (Previous->DeviceHandle == Entry->DeviceHandle)
+        );
+    }
+
+    for (Address = MAX (Entry->BaseAddress, GCD_TEST_MEMORY_BASE);
+         Address <= Entry->EndAddress && Address < GCD_TEST_MEMORY_BASE + EFI_PAGES_TO_SIZE (GCD_TEST_MEMORY_PAGES);
+         Address += EFI_PAGE_SIZE)
+    {
+      Page = (UINTN)EFI_SIZE_TO_PAGES (Address - GCD_TEST_MEMORY_BASE);
+      UT_ASSERT_EQUAL (Entry->Attributes, mGcdTestAttributes[Page]);
+    }
+
+    (*EntryCount)++;
+    Previous = Entry;
+    Address  = Entry->EndAddress + 1;
+    Node     = CoreRbTreeNext (Node);
+  }
+
+  UT_ASSERT_TRUE (Node == NULL);
+  UT_ASSERT_EQUAL (Address, LShiftU64 (1, GCD_TEST_ADDRESS_BITS));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Set up a GCD memory space map with the test memory and the MMIO windows,
+  the way the DXE Core builds it from the resource descriptor HOBs.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The map was built.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The map could not be built.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+GcdTestSetupMemorySpaceMap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_GCD_MAP_ENTRY  *Entry;
+  EFI_STATUS         Status;
+  UINTN              Index;
+
+  if (IsListEmpty (&mGcdMemorySpaceMap)) {
+    Entry = AllocateCopyPool (sizeof (EFI_GCD_MAP_ENTRY), &mGcdMemorySpaceMapEntryTemplate);
+    UT_ASSERT_NOT_NULL (Entry);
+    Entry->EndAddress = LShiftU64 (1, GCD_TEST_ADDRESS_BITS) - 1;
+    InsertHeadList (&mGcdMemorySpaceMap, &Entry->Link);
+    CoreRbTreeInsert (&mGcdMemorySpaceTree, &Entry->Node);
+
+    Status = CoreAddMemorySpace (
+               EfiGcdMemoryTypeSystemMemory,
+               GCD_TEST_MEMORY_BASE,
+               EFI_PAGES_TO_SIZE (GCD_TEST_MEMORY_PAGES),
+               GCD_TEST_CAPABILITIES
+               );
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+
+    //
+    // Leave a page between the windows so that they stay separate entries
+    //
+    for (Index = 0; Index < GCD_TEST_MMIO_WINDOW_COUNT; Index++) {
+      Status = CoreAddMemorySpace (
+                 EfiGcdMemoryTypeMemoryMappedIo,
+                 GCD_TEST_MMIO_BASE + Index * (GCD_TEST_MMIO_WINDOW_SIZE + EFI_PAGE_SIZE),
+                 GCD_TEST_MMIO_WINDOW_SIZE,
+                 EFI_MEMORY_UC
+                 );
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Replay a storm of SetMemorySpaceAttributes() requests on random page ranges
+  of the test memory, and report the number of requests served per second.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+GcdReplayAttributeStorm (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_GCD_MEMORY_SPACE_DESCRIPTOR  Descriptor;
+  EFI_STATUS                       Status;
+  UINT64                           Attributes;
+  UINTN                            Index;
+  UINTN                            Page;
+  UINTN                            Pages;
+  UINTN                            Entries;
+  UINTN                            MaxEntries;
+  UINT32                           Seed;
+  clock_t                          Start;
+  double                           Seconds;
+
+  Status = CoreSetMemorySpaceAttributes (GCD_TEST_MEMORY_BASE, EFI_PAGES_TO_SIZE (GCD_TEST_MEMORY_PAGES), EFI_MEMORY_WB);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  for (Page = 0; Page < GCD_TEST_MEMORY_PAGES; Page++) {
+    mGcdTestAttributes[Page] = EFI_MEMORY_WB;
+  }
+
+  Seed                = 0x6CD;
+  MaxEntries          = 0;
+  mGcdTestCpuRequests = 0;
+  Start               = clock ();
+  for (Index = 0; Index < GCD_TEST_STORM_REQUESTS; Index++) {
+    Page       = GcdTestRandom (&Seed) % GCD_TEST_MEMORY_PAGES;
+    Pages      = MIN (1 + GcdTestRandom (&Seed) % 16, GCD_TEST_MEMORY_PAGES - Page);
+    Attributes = EFI_MEMORY_WB;
+    switch (GcdTestRandom (&Seed) % 4) {
+      case 0:
+        Attributes |= EFI_MEMORY_RO;
+        break;
+      case 1:
+        Attributes |= EFI_MEMORY_XP;
+        break;
+      case 2:
+        Attributes |= EFI_MEMORY_RO | EFI_MEMORY_XP;
+        break;
+    }
+
+    Status = CoreSetMemorySpaceAttributes (
+               GCD_TEST_MEMORY_BASE + EFI_PAGES_TO_SIZE (Page),
+               EFI_PAGES_TO_SIZE (Pages),
+               Attributes
+               );
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    for ( ; Pages > 0; Pages--, Page++) {
+      mGcdTestAttributes[Page] = Attributes;
+    }
+
+    //
+    // Read back a random page, as drivers do before updating the attributes
+    //
+    Page   = GcdTestRandom (&Seed) % GCD_TEST_MEMORY_PAGES;
+    Status = CoreGetMemorySpaceDescriptor (GCD_TEST_MEMORY_BASE + EFI_PAGES_TO_SIZE (Page), &Descriptor);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL (Descriptor.Attributes, mGcdTestAttributes[Page]);
+
+    if ((Index % GCD_TEST_CHECK_INTERVAL) == 0) {
+      UT_ASSERT_EQUAL (GcdTestCheckMemorySpaceMap (&Entries), UNIT_TEST_PASSED);
+      MaxEntries = MAX (MaxEntries, Entries);
+    }
+  }
+
+  Seconds = (double)(clock () - Start) / CLOCKS_PER_SEC;
+  if (Seconds <= 0) {
+    Seconds = 1.0 / CLOCKS_PER_SEC;
+  }
+
+  UT_ASSERT_EQUAL (mGcdTestCpuRequests, GCD_TEST_STORM_REQUESTS);
+  UT_LOG_INFO (
+    "SetMemorySpaceAttributes requests: %d, up to %d GCD map entries, %d requests/second\n",
+    GCD_TEST_STORM_REQUESTS,
+    (INT32)MaxEntries,
+    (INT32)(GCD_TEST_STORM_REQUESTS / Seconds)
+    );
+
+  return GcdTestCheckMemorySpaceMap (&Entries);
+}
+
+/**
+  Allocate the MMIO windows top down below an address, check that each
+  allocation is placed at the top of the highest window with room left, then
+  free the allocations and check that the map is merged back.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+GcdAllocateTopDown (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_PHYSICAL_ADDRESS  WindowTop[GCD_TEST_MMIO_WINDOW_COUNT];
+  EFI_PHYSICAL_ADDRESS  Allocated[GCD_TEST_MMIO_WINDOW_COUNT * (GCD_TEST_MMIO_WINDOW_SIZE / GCD_TEST_MMIO_ALLOC_SIZE)];
+  EFI_PHYSICAL_ADDRESS  MaxAddress;
+  EFI_PHYSICAL_ADDRESS  BaseAddress;
+  EFI_PHYSICAL_ADDRESS  Expected;
+  EFI_STATUS            Status;
+  UINTN                 Window;
+  UINTN                 Count;
+  UINTN                 Index;
+  UINTN                 EntriesBefore;
+  UINTN                 EntriesAfter;
+
+  UT_ASSERT_EQUAL (GcdTestCheckMemorySpaceMap (&EntriesBefore), UNIT_TEST_PASSED);
+
+  //
+  // Only the lower half of the windows is below MaxAddress
+  //
+  for (Window = 0; Window < GCD_TEST_MMIO_WINDOW_COUNT; Window++) {
+    WindowTop[Window] = GCD_TEST_MMIO_BASE + Window * (GCD_TEST_MMIO_WINDOW_SIZE + EFI_PAGE_SIZE) + GCD_TEST_MMIO_WINDOW_SIZE;
+  }
+
+  MaxAddress = WindowTop[GCD_TEST_MMIO_WINDOW_COUNT / 2 - 1] - 1;
+
+  for (Count = 0; ; Count++) {
+    Expected = 0;
+    for (Window = GCD_TEST_MMIO_WINDOW_COUNT / 2; Window > 0; Window--) {
+      if (WindowTop[Window - 1] - GCD_TEST_MMIO_ALLOC_SIZE >= GCD_TEST_MMIO_BASE + (Window - 1) * (GCD_TEST_MMIO_WINDOW_SIZE + EFI_PAGE_SIZE)) {
+        Expected = WindowTop[Window - 1] - GCD_TEST_MMIO_ALLOC_SIZE;
+        break;
+      }
+    }
+
+    BaseAddress = MaxAddress;
+    Status      = CoreAllocateMemorySpace (
+                    EfiGcdAllocateMaxAddressSearchTopDown,
+                    EfiGcdMemoryTypeMemoryMappedIo,
+                    EFI_PAGE_SHIFT,
+                    GCD_TEST_MMIO_ALLOC_SIZE,
+                    &BaseAddress,
+                    gDxeCoreImageHandle,
+                    NULL
+                    );
+    if (Expected == 0) {
+      UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_FOUND);
+      break;
+    }
+
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL (BaseAddress, Expected);
+    WindowTop[Window - 1] = BaseAddress;
+    Allocated[Count]      = BaseAddress;
+  }
+
+  UT_ASSERT_EQUAL (Count, (GCD_TEST_MMIO_WINDOW_COUNT / 2) * (GCD_TEST_MMIO_WINDOW_SIZE / GCD_TEST_MMIO_ALLOC_SIZE));
+
+  for (Index = 0; Index < Count; Index++) {
+    Status = CoreFreeMemorySpace (Allocated[Index], GCD_TEST_MMIO_ALLOC_SIZE);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+
+  UT_ASSERT_EQUAL (GcdTestCheckMemorySpaceMap (&EntriesAfter), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (EntriesAfter, EntriesBefore);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the GCD
+  services and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      GcdTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  mGcdTestCpu.SetMemoryAttributes = GcdTestSetMemoryAttributes;
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&GcdTests, Framework, "DXE Core GCD Tests", "DxeCore.Gcd", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DXE Core GCD Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (GcdTests, "Replay a SetMemorySpaceAttributes storm", "AttributeStorm", GcdReplayAttributeStorm, GcdTestSetupMemorySpaceMap, NULL, NULL);
+  AddTestCase (GcdTests, "Allocate memory space top down", "AllocateTopDown", GcdAllocateTopDown, GcdTestSetupMemorySpaceMap, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define GcdUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+GcdUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
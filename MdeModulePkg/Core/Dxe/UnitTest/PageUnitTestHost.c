@@ -0,0 +1,757 @@
+/** @file
+  Host based unit test of the DXE Core page allocator memory map.
+
+  The page allocator is built against stubs of the heap guard, GCD, event and
+  memory protection services, and manages a buffer of host memory. Allocation
+  traces are replayed against it, and after each request the memory map list,
+  the memory map tree and the address picked by the allocator are checked
+  against a linear walk of the memory map.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "DxeMain.h"
+#include "Mem/Imem.h"
+#include "Mem/HeapGuard.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "DXE Core Page Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define PAGE_TEST_ARENA_PAGES      0x4000
+#define PAGE_TEST_SLOT_COUNT       2048
+#define PAGE_TEST_RANDOM_REQUESTS  40000
+#define PAGE_TEST_CHECK_INTERVAL   256
+
+typedef enum {
+  PAGE_TRACE_ALLOCATE,
+  PAGE_TRACE_ALLOCATE_MAX,
+  PAGE_TRACE_FREE
+} PAGE_TRACE_OPERATION;
+
+///
+/// One request of an allocation trace. Allocations save their result in a
+/// slot, and frees release the pages saved in a slot.
+///
+typedef struct {
+  PAGE_TRACE_OPERATION    Operation;
+  EFI_MEMORY_TYPE         MemoryType;
+  UINTN                   NumberOfPages;
+  UINTN                   Slot;
+} PAGE_TRACE_ENTRY;
+
+typedef struct {
+  EFI_PHYSICAL_ADDRESS    Memory;
+  UINTN                   NumberOfPages;
+} PAGE_TEST_SLOT;
+
+//
+// Page requests in the order they were made by the drivers dispatched early
+// in a DXE boot: mostly small boot services data buffers, with images, ACPI
+// tables and runtime buffers in between, and buffers freed out of order.
+// PAGE_TRACE_ALLOCATE_MAX requests are limited to the lower half of the
+// managed memory.
+//
+STATIC CONST PAGE_TRACE_ENTRY  mPageTrace[] = {
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    1,     0  },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     0  },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    1,     1  },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     1  },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    1,     2  },
+  { PAGE_TRACE_ALLOCATE_MAX, EfiBootServicesCode,    32,    3  },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     2  },
+  { PAGE_TRACE_ALLOCATE_MAX, EfiBootServicesData,    2,     4  },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    1,     5  },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    64,    6  },
+  { PAGE_TRACE_ALLOCATE_MAX, EfiBootServicesData,    4,     7  },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    32,    8  },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    4,     9  },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    2,     10 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    32,    11 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    16,    12 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesCode,    8,     13 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     10 },
+  { PAGE_TRACE_ALLOCATE,     EfiLoaderData,          1,     14 },
+  { PAGE_TRACE_ALLOCATE,     EfiACPIReclaimMemory,   4,     15 },
+  { PAGE_TRACE_ALLOCATE_MAX, EfiBootServicesData,    16,    16 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     7  },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    1,     17 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     14 },
+  { PAGE_TRACE_ALLOCATE,     EfiRuntimeServicesData, 3,     18 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    16,    19 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    2,     20 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     6  },
+  { PAGE_TRACE_ALLOCATE_MAX, EfiACPIMemoryNVS,       16,    21 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    1,     22 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    8,     23 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    2,     24 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     13 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesCode,    32,    25 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     9  },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    32,    26 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     25 },
+  { PAGE_TRACE_ALLOCATE_MAX, EfiBootServicesData,    0x100, 27 },
+  { PAGE_TRACE_ALLOCATE,     EfiRuntimeServicesCode, 64,    28 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    1,     29 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    2,     30 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     29 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     3  },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    4,     31 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     16 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesCode,    3,     32 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    1,     33 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    16,    34 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     21 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    0x100, 35 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     30 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    1,     36 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     35 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    3,     37 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    2,     38 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    2,     39 },
+  { PAGE_TRACE_ALLOCATE,     EfiRuntimeServicesCode, 2,     40 },
+  { PAGE_TRACE_ALLOCATE,     EfiRuntimeServicesCode, 2,     41 },
+  { PAGE_TRACE_ALLOCATE,     EfiRuntimeServicesCode, 1,     42 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    32,    43 },
+  { PAGE_TRACE_ALLOCATE,     EfiReservedMemoryType,  4,     44 },
+  { PAGE_TRACE_ALLOCATE,     EfiBootServicesData,    2,     45 },
+  { PAGE_TRACE_FREE,         EfiConventionalMemory,  0,     28 },
+  { PAGE_TRACE_ALLOCATE,     EfiACPIMemoryNVS,       1,     46 },
+};
+
+EFI_PHYSICAL_ADDRESS  mPageTestArena;
+PAGE_TEST_SLOT        mPageTestSlot[PAGE_TEST_SLOT_COUNT];
+UINT16                mPageTestOwner[PAGE_TEST_ARENA_PAGES];
+
+extern RB_TREE  mMemoryMapTree;
+
+///
+/// === STUBS OF THE DXE CORE SERVICES USED BY THE PAGE ALLOCATOR ===============
+///
+
+EFI_TPL                                       gEfiCurrentTpl      = TPL_APPLICATION;
+EFI_HANDLE                                    gDxeCoreImageHandle = NULL;
+BOOLEAN                                       mOnGuarding         = FALSE;
+LIST_ENTRY                                    mGcdMemorySpaceMap  = INITIALIZE_LIST_HEAD_VARIABLE (mGcdMemorySpaceMap);
+EFI_LOAD_FIXED_ADDRESS_CONFIGURATION_TABLE    gLoadModuleAtFixAddressConfigurationTable;
+
+VOID
+CoreAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockReleased);
+  Lock->OwnerTpl = gEfiCurrentTpl;
+  gEfiCurrentTpl = Lock->Tpl;
+  Lock->Lock     = EfiLockAcquired;
+}
+
+VOID
+CoreReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock     = EfiLockReleased;
+  gEfiCurrentTpl = Lock->OwnerTpl;
+}
+
+VOID
+CoreAcquireGcdMemoryLock (
+  VOID
+  )
+{
+}
+
+VOID
+CoreReleaseGcdMemoryLock (
+  VOID
+  )
+{
+}
+
+EFI_STATUS
+EFIAPI
+CoreGetMemorySpaceDescriptor (
+  IN  EFI_PHYSICAL_ADDRESS             BaseAddress,
+  OUT EFI_GCD_MEMORY_SPACE_DESCRIPTOR  *Descriptor
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+VOID
+CoreNotifySignalList (
+  IN EFI_GUID  *EventGroup
+  )
+{
+}
+
+BOOLEAN
+IsHeapGuardEnabled (
+  UINT8  GuardType
+  )
+{
+  return FALSE;
+}
+
+BOOLEAN
+IsPageTypeToGuard (
+  IN EFI_MEMORY_TYPE    MemoryType,
+  IN EFI_ALLOCATE_TYPE  AllocateType
+  )
+{
+  return FALSE;
+}
+
+BOOLEAN
+EFIAPI
+IsMemoryGuarded (
+  IN EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  return FALSE;
+}
+
+UINT64
+AdjustMemoryS (
+  IN UINT64  Start,
+  IN UINT64  Size,
+  IN UINT64  SizeRequested
+  )
+{
+  return Start + Size - 1;
+}
+
+VOID
+SetGuardForMemory (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NumberOfPages
+  )
+{
+}
+
+EFI_STATUS
+CoreConvertPagesWithGuard (
+  IN UINT64           Start,
+  IN UINTN            NumberOfPages,
+  IN EFI_MEMORY_TYPE  NewType
+  )
+{
+  return CoreConvertPages (Start, NumberOfPages, NewType);
+}
+
+VOID
+EFIAPI
+GuardFreedPagesChecked (
+  IN  EFI_PHYSICAL_ADDRESS  BaseAddress,
+  IN  UINTN                 Pages
+  )
+{
+}
+
+BOOLEAN
+PromoteGuardedFreePages (
+  OUT EFI_PHYSICAL_ADDRESS  *StartAddress,
+  OUT EFI_PHYSICAL_ADDRESS  *EndAddress
+  )
+{
+  return FALSE;
+}
+
+VOID
+EFIAPI
+DumpGuardedMemoryBitmap (
+  VOID
+  )
+{
+}
+
+VOID
+MergeMemoryMap (
+  IN OUT EFI_MEMORY_DESCRIPTOR  *MemoryMap,
+  IN OUT UINTN                  *MemoryMapSize,
+  IN UINTN                      DescriptorSize
+  )
+{
+}
+
+EFI_STATUS
+EFIAPI
+ApplyMemoryProtectionPolicy (
+  IN  EFI_MEMORY_TYPE       OldType,
+  IN  EFI_MEMORY_TYPE       NewType,
+  IN  EFI_PHYSICAL_ADDRESS  Memory,
+  IN  UINT64                Length
+  )
+{
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+CoreUpdateProfile (
+  IN EFI_PHYSICAL_ADDRESS   CallerAddress,
+  IN MEMORY_PROFILE_ACTION  Action,
+  IN EFI_MEMORY_TYPE        MemoryType,
+  IN UINTN                  Size,
+  IN VOID                   *Buffer,
+  IN CHAR8                  *ActionString OPTIONAL
+  )
+{
+  return EFI_SUCCESS;
+}
+
+VOID
+InstallMemoryAttributesTableOnMemoryAllocation (
+  IN EFI_MEMORY_TYPE  MemoryType
+  )
+{
+}
+
+///
+/// === TEST CASES ==============================================================
+///
+
+/**
+  Return a pseudo random number.
+
+  @param[in, out]  Seed  The generator state.
+
+  @return The next pseudo random number.
+**/
+STATIC
+UINT32
+PageTestRandom (
+  IN OUT UINT32  *Seed
+  )
+{
+  *Seed = *Seed * 1103515245 + 12345;
+  return (*Seed >> 16) & 0x7FFF;
+}
+
+/**
+  Find the address the page allocator must return for a request, by walking
+  the memory map list from the lowest address up and keeping the highest
+  free range that fits, as the page allocator did before the memory map tree.
+
+  @param[in]  MaxAddress     The address that the range must be below.
+  @param[in]  NumberOfPages  Number of pages needed.
+
+  @return The base address of the range, or 0 if the range was not found.
+**/
+STATIC
+UINT64
+PageTestFindFreePages (
+  IN UINT64  MaxAddress,
+  IN UINTN   NumberOfPages
+  )
+{
+  LIST_ENTRY  *Link;
+  MEMORY_MAP  *Entry;
+  UINT64      NumberOfBytes;
+  UINT64      DescEnd;
+  UINT64      Target;
+
+  NumberOfBytes = EFI_PAGES_TO_SIZE (NumberOfPages);
+  Target        = 0;
+  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
+    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+    if ((Entry->Type != EfiConventionalMemory) || (Entry->Start >= MaxAddress)) {
+      continue;
+    }
+
+    DescEnd = MIN (Entry->End, MaxAddress);
+    if ((DescEnd - Entry->Start + 1 >= NumberOfBytes) && (DescEnd > Target)) {
+      Target = DescEnd;
+    }
+  }
+
+  if (Target == 0) {
+    return 0;
+  }
+
+  return Target - NumberOfBytes + 1;
+}
+
+/**
+  Check the red-black tree and free size properties of a subtree of the
+  memory map tree.
+
+  @param[in]  Node        The root of the subtree.
+  @param[out] BlackDepth  The number of black nodes on each path of the subtree.
+
+  @retval  TRUE   The subtree is valid.
+  @retval  FALSE  The subtree is invalid.
+**/
+STATIC
+BOOLEAN
+PageTestCheckSubtree (
+  IN  RB_TREE_NODE  *Node,
+  OUT UINTN         *BlackDepth
+  )
+{
+  MEMORY_MAP  *Entry;
+  MEMORY_MAP  *Child;
+  UINT64      MaxFreeBytes;
+  UINTN       LeftDepth;
+  UINTN       RightDepth;
+
+  if (Node == NULL) {
+    *BlackDepth = 1;
+    return TRUE;
+  }
+
+  Entry        = CR (Node, MEMORY_MAP, Node, MEMORY_MAP_SIGNATURE);
+  MaxFreeBytes = (Entry->Type == EfiConventionalMemory) ? Entry->End - Entry->Start + 1 : 0;
+
+  if (!PageTestCheckSubtree (Node->Left, &LeftDepth) ||
+      !PageTestCheckSubtree (Node->Right, &RightDepth) ||
+      (LeftDepth != RightDepth))
+  {
+    return FALSE;
+  }
+
+  if (Node->Left != NULL) {
+    Child = CR (Node->Left, MEMORY_MAP, Node, MEMORY_MAP_SIGNATURE);
+    if ((Node->Left->Parent != Node) || (Node->Red && Node->Left->Red) || (Child->End >= Entry->Start)) {
+      return FALSE;
+    }
+
+    MaxFreeBytes = MAX (MaxFreeBytes, Child->MaxFreeBytes);
+  }
+
+  if (Node->Right != NULL) {
+    Child = CR (Node->Right, MEMORY_MAP, Node, MEMORY_MAP_SIGNATURE);
+    if ((Node->Right->Parent != Node) || (Node->Red && Node->Right->Red) || (Child->Start <= Entry->End)) {
+      return FALSE;
+    }
+
+    MaxFreeBytes = MAX (MaxFreeBytes, Child->MaxFreeBytes);
+  }
+
+  *BlackDepth = LeftDepth + (Node->Red ? 0 : 1);
+  return (BOOLEAN)(Entry->MaxFreeBytes == MaxFreeBytes);
+}
+
+/**
+  Check that the memory map list is sorted, covers the managed memory without
+  holes, holds the same entries as the memory map tree, and that the tree is
+  a valid red-black tree.
+
+  @retval  UNIT_TEST_PASSED             The memory map is valid.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The memory map is invalid.
+**/
+STATIC
+UNIT_TEST_STATUS
+PageTestCheckMemoryMap (
+  VOID
+  )
+{
+  LIST_ENTRY    *Link;
+  RB_TREE_NODE  *Node;
+  MEMORY_MAP    *Entry;
+  UINT64        Address;
+  UINTN         BlackDepth;
+
+  UT_ASSERT_TRUE (mMemoryMapTree.Root != NULL);
+  UT_ASSERT_FALSE (mMemoryMapTree.Root->Red);
+  UT_ASSERT_TRUE (PageTestCheckSubtree (mMemoryMapTree.Root, &BlackDepth));
+
+  Address = mPageTestArena;
+  Node    = CoreRbTreeFirst (&mMemoryMapTree);
+  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
+    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+    UT_ASSERT_EQUAL (Entry->Start, Address);
+    UT_ASSERT_TRUE (Entry->End > Entry->Start);
+    UT_ASSERT_TRUE (Node == &Entry->Node);
+    Address = Entry->End + 1;
+    Node    = CoreRbTreeNext (Node);
+  }
+
+  UT_ASSERT_TRUE (Node == NULL);
+  UT_ASSERT_EQUAL (Address, mPageTestArena + EFI_PAGES_TO_SIZE (PAGE_TEST_ARENA_PAGES));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Perform one request of an allocation trace, and check the address picked
+  by the page allocator and that the pages are not used by another slot.
+
+  @param[in]  Trace  The request.
+
+  @retval  UNIT_TEST_PASSED             The request behaved as expected.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The request failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+PageTestReplay (
+  IN CONST PAGE_TRACE_ENTRY  *Trace
+  )
+{
+  PAGE_TEST_SLOT        *Slot;
+  EFI_PHYSICAL_ADDRESS  Memory;
+  EFI_PHYSICAL_ADDRESS  Expected;
+  EFI_STATUS            Status;
+  UINTN                 Index;
+  UINTN                 Page;
+
+  Slot = &mPageTestSlot[Trace->Slot];
+  if (Trace->Operation == PAGE_TRACE_FREE) {
+    UT_ASSERT_NOT_EQUAL (Slot->NumberOfPages, 0);
+    Status = CoreFreePages (Slot->Memory, Slot->NumberOfPages);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+
+    Page = (UINTN)EFI_SIZE_TO_PAGES (Slot->Memory - mPageTestArena);
+    for (Index = 0; Index < Slot->NumberOfPages; Index++) {
+      mPageTestOwner[Page + Index] = 0;
+    }
+
+    Slot->NumberOfPages = 0;
+    return UNIT_TEST_PASSED;
+  }
+
+  UT_ASSERT_EQUAL (Slot->NumberOfPages, 0);
+  if (Trace->Operation == PAGE_TRACE_ALLOCATE_MAX) {
+    Memory   = mPageTestArena + EFI_PAGES_TO_SIZE (PAGE_TEST_ARENA_PAGES / 2) - 1;
+    Expected = PageTestFindFreePages (Memory, Trace->NumberOfPages);
+    Status   = CoreAllocatePages (AllocateMaxAddress, Trace->MemoryType, Trace->NumberOfPages, &Memory);
+  } else {
+    Memory   = MAX_ALLOC_ADDRESS;
+    Expected = PageTestFindFreePages (Memory, Trace->NumberOfPages);
+    Status   = CoreAllocatePages (AllocateAnyPages, Trace->MemoryType, Trace->NumberOfPages, &Memory);
+  }
+
+  if (EFI_ERROR (Status)) {
+    //
+    // The request may only fail when no free range is large enough
+    //
+    UT_ASSERT_STATUS_EQUAL (Status, EFI_OUT_OF_RESOURCES);
+    UT_ASSERT_EQUAL (Expected, 0);
+    return UNIT_TEST_PASSED;
+  }
+
+  UT_ASSERT_EQUAL (Memory, Expected);
+
+  Page = (UINTN)EFI_SIZE_TO_PAGES (Memory - mPageTestArena);
+  UT_ASSERT_TRUE (Page + Trace->NumberOfPages <= PAGE_TEST_ARENA_PAGES);
+  for (Index = 0; Index < Trace->NumberOfPages; Index++) {
+    UT_ASSERT_EQUAL (mPageTestOwner[Page + Index], 0);
+    mPageTestOwner[Page + Index] = (UINT16)(Trace->Slot + 1);
+  }
+
+  Slot->Memory        = Memory;
+  Slot->NumberOfPages = Trace->NumberOfPages;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free the pages held by all the slots.
+
+  @retval  UNIT_TEST_PASSED             The pages were freed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A free failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+PageTestFreeAll (
+  VOID
+  )
+{
+  PAGE_TRACE_ENTRY  Trace;
+  UINTN             Index;
+
+  for (Index = 0; Index < PAGE_TEST_SLOT_COUNT; Index++) {
+    if (mPageTestSlot[Index].NumberOfPages != 0) {
+      Trace.Operation = PAGE_TRACE_FREE;
+      Trace.Slot      = Index;
+      UT_ASSERT_EQUAL (PageTestReplay (&Trace), UNIT_TEST_PASSED);
+    }
+  }
+
+  return PageTestCheckMemoryMap ();
+}
+
+/**
+  Replay the recorded allocation trace, checking the memory map after each
+  request.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PageReplayTrace (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (mPageTrace); Index++) {
+    UT_ASSERT_EQUAL (PageTestReplay (&mPageTrace[Index]), UNIT_TEST_PASSED);
+    UT_ASSERT_EQUAL (PageTestCheckMemoryMap (), UNIT_TEST_PASSED);
+  }
+
+  return PageTestFreeAll ();
+}
+
+/**
+  Replay a long random trace of small allocations of alternating types,
+  which fragments the memory map into thousands of entries, and report the
+  number of requests served per second.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PageReplayFragmentedTrace (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST EFI_MEMORY_TYPE  Types[] = { EfiBootServicesData, EfiBootServicesCode, EfiLoaderData, EfiACPIReclaimMemory };
+  PAGE_TRACE_ENTRY              Trace;
+  LIST_ENTRY                    *Link;
+  UINTN                         Index;
+  UINTN                         Entries;
+  UINTN                         MaxEntries;
+  UINT32                        Seed;
+  clock_t                       Start;
+  double                        Seconds;
+
+  Seed       = 0x9A9E;
+  MaxEntries = 0;
+  Start      = clock ();
+  for (Index = 0; Index < PAGE_TEST_RANDOM_REQUESTS; Index++) {
+    Trace.Slot = PageTestRandom (&Seed) % PAGE_TEST_SLOT_COUNT;
+    if (mPageTestSlot[Trace.Slot].NumberOfPages != 0) {
+      Trace.Operation = PAGE_TRACE_FREE;
+    } else {
+      Trace.Operation     = ((PageTestRandom (&Seed) % 8) == 0) ? PAGE_TRACE_ALLOCATE_MAX : PAGE_TRACE_ALLOCATE;
+      Trace.MemoryType    = Types[PageTestRandom (&Seed) % ARRAY_SIZE (Types)];
+      Trace.NumberOfPages = ((PageTestRandom (&Seed) % 16) == 0) ? 1 + PageTestRandom (&Seed) % 64 : 1;
+    }
+
+    UT_ASSERT_EQUAL (PageTestReplay (&Trace), UNIT_TEST_PASSED);
+
+    if ((Index % PAGE_TEST_CHECK_INTERVAL) == 0) {
+      UT_ASSERT_EQUAL (PageTestCheckMemoryMap (), UNIT_TEST_PASSED);
+      Entries = 0;
+      for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
+        Entries++;
+      }
+
+      MaxEntries = MAX (MaxEntries, Entries);
+    }
+  }
+
+  Seconds = (double)(clock () - Start) / CLOCKS_PER_SEC;
+  if (Seconds <= 0) {
+    Seconds = 1.0 / CLOCKS_PER_SEC;
+  }
+
+  UT_LOG_INFO (
+    "Page requests: %d, up to %d memory map entries, %d requests/second\n",
+    PAGE_TEST_RANDOM_REQUESTS,
+    (INT32)MaxEntries,
+    (INT32)(PAGE_TEST_RANDOM_REQUESTS / Seconds)
+    );
+
+  return PageTestFreeAll ();
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the page
+  allocator and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      PageTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // Hand a buffer of host memory to the page allocator
+  //
+  mPageTestArena = (EFI_PHYSICAL_ADDRESS)(UINTN)AllocateAlignedPages (PAGE_TEST_ARENA_PAGES, SIZE_64KB);
+  if (mPageTestArena == 0) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CoreAddMemoryDescriptor (EfiConventionalMemory, mPageTestArena, PAGE_TEST_ARENA_PAGES, 0);
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&PageTests, Framework, "DXE Core Page Tests", "DxeCore.Page", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DXE Core Page Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (PageTests, "Replay a recorded allocation trace", "ReplayTrace", PageReplayTrace, NULL, NULL, NULL);
+  AddTestCase (PageTests, "Replay a fragmenting allocation trace", "ReplayFragmentedTrace", PageReplayFragmentedTrace, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define PageUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+PageUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -0,0 +1,499 @@
+/** @file
+  Host based unit test and micro-benchmark of the DXE Core pool allocator.
+
+  The pool code is built against stubs of the page allocator, heap guard and
+  memory profile services, so the test exercises the pool free lists, slabs
+  and per-TPL magazines in isolation.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "DxeMain.h"
+#include "Mem/Imem.h"
+#include "Mem/HeapGuard.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "DXE Core Pool Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define POOL_TEST_BUFFER_COUNT     1024
+#define POOL_TEST_ROUND_COUNT      16
+#define POOL_BENCHMARK_ITERATIONS  200000
+#define POOL_BENCHMARK_BATCH       64
+
+///
+/// === STUBS OF THE DXE CORE SERVICES USED BY THE POOL =========================
+///
+
+EFI_TPL     gEfiCurrentTpl = TPL_APPLICATION;
+EFI_LOCK    gMemoryLock    = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
+BOOLEAN     mOnGuarding    = FALSE;
+LIST_ENTRY  gMemoryMap     = INITIALIZE_LIST_HEAD_VARIABLE (gMemoryMap);
+
+UINTN  mPoolTestPagesAllocated;
+
+EFI_STATUS
+CoreAcquireLockOrFail (
+  IN EFI_LOCK  *Lock
+  )
+{
+  if (Lock->Lock == EfiLockAcquired) {
+    return EFI_ACCESS_DENIED;
+  }
+
+  Lock->OwnerTpl = gEfiCurrentTpl;
+  gEfiCurrentTpl = Lock->Tpl;
+  Lock->Lock     = EfiLockAcquired;
+  return EFI_SUCCESS;
+}
+
+VOID
+CoreAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockReleased);
+  CoreAcquireLockOrFail (Lock);
+}
+
+VOID
+CoreReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  ASSERT (Lock->Lock == EfiLockAcquired);
+  Lock->Lock     = EfiLockReleased;
+  gEfiCurrentTpl = Lock->OwnerTpl;
+}
+
+VOID
+CoreAcquireMemoryLock (
+  VOID
+  )
+{
+  CoreAcquireLock (&gMemoryLock);
+}
+
+VOID
+CoreReleaseMemoryLock (
+  VOID
+  )
+{
+  CoreReleaseLock (&gMemoryLock);
+}
+
+VOID *
+CoreAllocatePoolPages (
+  IN EFI_MEMORY_TYPE  PoolType,
+  IN UINTN            NumberOfPages,
+  IN UINTN            Alignment,
+  IN BOOLEAN          NeedGuard
+  )
+{
+  mPoolTestPagesAllocated += NumberOfPages;
+  return AllocateAlignedPages (NumberOfPages, Alignment);
+}
+
+VOID
+CoreFreePoolPages (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NumberOfPages
+  )
+{
+  mPoolTestPagesAllocated -= NumberOfPages;
+  FreeAlignedPages ((VOID *)(UINTN)Memory, NumberOfPages);
+}
+
+BOOLEAN
+IsPoolTypeToGuard (
+  IN EFI_MEMORY_TYPE  MemoryType
+  )
+{
+  return FALSE;
+}
+
+BOOLEAN
+IsHeapGuardEnabled (
+  UINT8  GuardType
+  )
+{
+  return FALSE;
+}
+
+BOOLEAN
+EFIAPI
+IsMemoryGuarded (
+  IN EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  return FALSE;
+}
+
+VOID
+SetGuardForMemory (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NumberOfPages
+  )
+{
+}
+
+VOID
+UnsetGuardForMemory (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NumberOfPages
+  )
+{
+}
+
+VOID
+AdjustMemoryF (
+  IN OUT EFI_PHYSICAL_ADDRESS  *Memory,
+  IN OUT UINTN                 *NumberOfPages
+  )
+{
+}
+
+VOID *
+AdjustPoolHeadA (
+  IN EFI_PHYSICAL_ADDRESS  Memory,
+  IN UINTN                 NoPages,
+  IN UINTN                 Size
+  )
+{
+  return (VOID *)(UINTN)Memory;
+}
+
+VOID *
+AdjustPoolHeadF (
+  IN EFI_PHYSICAL_ADDRESS  Memory
+  )
+{
+  return (VOID *)(UINTN)Memory;
+}
+
+VOID
+EFIAPI
+GuardFreedPagesChecked (
+  IN  EFI_PHYSICAL_ADDRESS  BaseAddress,
+  IN  UINTN                 Pages
+  )
+{
+}
+
+EFI_STATUS
+EFIAPI
+ApplyMemoryProtectionPolicy (
+  IN  EFI_MEMORY_TYPE       OldType,
+  IN  EFI_MEMORY_TYPE       NewType,
+  IN  EFI_PHYSICAL_ADDRESS  Memory,
+  IN  UINT64                Length
+  )
+{
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+CoreUpdateProfile (
+  IN EFI_PHYSICAL_ADDRESS   CallerAddress,
+  IN MEMORY_PROFILE_ACTION  Action,
+  IN EFI_MEMORY_TYPE        MemoryType,
+  IN UINTN                  Size,
+  IN VOID                   *Buffer,
+  IN CHAR8                  *ActionString OPTIONAL
+  )
+{
+  return EFI_SUCCESS;
+}
+
+VOID
+InstallMemoryAttributesTableOnMemoryAllocation (
+  IN EFI_MEMORY_TYPE  MemoryType
+  )
+{
+}
+
+///
+/// === TEST CASES ==============================================================
+///
+
+/**
+  Return a pseudo random number.
+
+  @param[in, out]  Seed  The generator state.
+
+  @return The next pseudo random number.
+**/
+STATIC
+UINT32
+PoolTestRandom (
+  IN OUT UINT32  *Seed
+  )
+{
+  *Seed = *Seed * 1103515245 + 12345;
+  return (*Seed >> 16) & 0x7FFF;
+}
+
+/**
+  Allocate buffers of random sizes at all the TPLs serving pool requests,
+  fill each of them with a pattern, free them in random order and check that
+  no buffer was overwritten.
+
+  @param[in]       Seed   The seed of the random sizes and free order.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+STATIC
+UNIT_TEST_STATUS
+PoolAllocateFreeRound (
+  IN UINT32  Seed
+  )
+{
+  STATIC CONST EFI_TPL  Tpl[] = { TPL_APPLICATION, TPL_CALLBACK, TPL_NOTIFY };
+  STATIC UINT8          *Buffer[POOL_TEST_BUFFER_COUNT];
+  STATIC UINTN          Size[POOL_TEST_BUFFER_COUNT];
+  EFI_MEMORY_TYPE       Type;
+  EFI_STATUS            Status;
+  UINTN                 Index;
+  UINTN                 Offset;
+  UINTN                 Swap;
+
+  for (Index = 0; Index < POOL_TEST_BUFFER_COUNT; Index++) {
+    //
+    // Mostly small requests, with some that exceed the slab classes
+    //
+    if ((Index % 8) == 0) {
+      Size[Index] = 1 + PoolTestRandom (&Seed) % 6000;
+    } else {
+      Size[Index] = 1 + PoolTestRandom (&Seed) % 480;
+    }
+
+    gEfiCurrentTpl = Tpl[Index % ARRAY_SIZE (Tpl)];
+    Status         = CoreAllocatePool (EfiBootServicesData, Size[Index], (VOID **)&Buffer[Index]);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL ((UINTN)Buffer[Index] & (sizeof (UINT64) - 1), 0);
+    SetMem (Buffer[Index], Size[Index], (UINT8)Index);
+  }
+
+  //
+  // Shuffle the free order
+  //
+  for (Index = POOL_TEST_BUFFER_COUNT - 1; Index > 0; Index--) {
+    Offset = PoolTestRandom (&Seed) % (Index + 1);
+    Swap   = (UINTN)Buffer[Index];
+
+    Buffer[Index]  = Buffer[Offset];
+    Buffer[Offset] = (UINT8 *)Swap;
+    Swap           = Size[Index];
+    Size[Index]    = Size[Offset];
+    Size[Offset]   = Swap;
+  }
+
+  for (Index = 0; Index < POOL_TEST_BUFFER_COUNT; Index++) {
+    for (Offset = 1; Offset < Size[Index]; Offset++) {
+      UT_ASSERT_EQUAL (Buffer[Index][Offset], Buffer[Index][0]);
+    }
+
+    gEfiCurrentTpl = Tpl[Index % ARRAY_SIZE (Tpl)];
+    Status         = CoreInternalFreePool (Buffer[Index], &Type);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL (Type, EfiBootServicesData);
+  }
+
+  gEfiCurrentTpl = TPL_APPLICATION;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Run the same allocation pattern repeatedly and check that the pages held
+  by the pool do not grow from one round to the next.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PoolAllocateFreeRandomSizes (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+  UINTN             PagesAllocated;
+  UINTN             Round;
+
+  Status = PoolAllocateFreeRound (0x5EED);
+  UT_ASSERT_EQUAL (Status, UNIT_TEST_PASSED);
+  PagesAllocated = mPoolTestPagesAllocated;
+
+  //
+  // Chunks cached in magazines and partially used pages make the exact
+  // count vary between rounds, but a leak would make it grow with each one.
+  //
+  for (Round = 0; Round < POOL_TEST_ROUND_COUNT; Round++) {
+    Status = PoolAllocateFreeRound (0x5EED + (UINT32)Round);
+    UT_ASSERT_EQUAL (Status, UNIT_TEST_PASSED);
+    UT_ASSERT_TRUE (mPoolTestPagesAllocated <= 2 * PagesAllocated);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Measure the number of allocate/free pairs per second for small pool
+  requests. Build the test with PcdDxeCorePoolSlabEnable set to FALSE to get
+  the figures of the pool free list allocator.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PoolAllocateFreeBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST UINTN  BenchmarkSize[] = { 16, 48, 100, 200, 400 };
+  VOID                *Buffer[POOL_BENCHMARK_BATCH];
+  EFI_STATUS          Status;
+  UINTN               SizeIndex;
+  UINTN               Iteration;
+  UINTN               Index;
+  clock_t             Start;
+  double              Seconds;
+
+  for (SizeIndex = 0; SizeIndex < ARRAY_SIZE (BenchmarkSize); SizeIndex++) {
+    Start = clock ();
+    for (Iteration = 0; Iteration < POOL_BENCHMARK_ITERATIONS / POOL_BENCHMARK_BATCH; Iteration++) {
+      for (Index = 0; Index < POOL_BENCHMARK_BATCH; Index++) {
+        Status = CoreAllocatePool (EfiBootServicesData, BenchmarkSize[SizeIndex], &Buffer[Index]);
+        UT_ASSERT_NOT_EFI_ERROR (Status);
+      }
+
+      for (Index = 0; Index < POOL_BENCHMARK_BATCH; Index++) {
+        Status = CoreFreePool (Buffer[Index]);
+        UT_ASSERT_NOT_EFI_ERROR (Status);
+      }
+    }
+
+    Seconds = (double)(clock () - Start) / CLOCKS_PER_SEC;
+    if (Seconds <= 0) {
+      Seconds = 1.0 / CLOCKS_PER_SEC;
+    }
+
+    UT_LOG_INFO (
+      "Pool slab %a: %4d bytes: %10d allocations/second\n",
+      FeaturePcdGet (PcdDxeCorePoolSlabEnable) ? "on " : "off",
+      (INT32)BenchmarkSize[SizeIndex],
+      (INT32)(POOL_BENCHMARK_ITERATIONS / Seconds)
+      );
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Reset the TPL before each test.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED  The pool is ready.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PoolTestSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  gEfiCurrentTpl = TPL_APPLICATION;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the pool
+  allocator and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      PoolTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  CoreInitializePool ();
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&PoolTests, Framework, "DXE Core Pool Tests", "DxeCore.Pool", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DXE Core Pool Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (PoolTests, "Allocate and free random sizes", "RandomSizes", PoolAllocateFreeRandomSizes, PoolTestSetup, NULL, NULL);
+  AddTestCase (PoolTests, "Small allocation throughput", "Benchmark", PoolAllocateFreeBenchmark, PoolTestSetup, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define PoolUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+PoolUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -9,10 +9,66 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "PeiMain.h"
 
+/**
+  Read the array of file names held in the raw section of a file of an FV, such
+  as the Apriori file.
+
+  @param FvPpi            The FV PPI of the FV.
+  @param FvHandle         The FV.
+  @param FileName         The name of the file.
+  @param Count            Returns the number of file names in the array.
+
+  @return The array of file names, or NULL if the FV holds no such file.
+
+**/
+STATIC
+EFI_GUID *
+FindFileNameArray (
+  IN  EFI_PEI_FIRMWARE_VOLUME_PPI  *FvPpi,
+  IN  EFI_PEI_FV_HANDLE            FvHandle,
+  IN  CONST EFI_GUID               *FileName,
+  OUT UINTN                        *Count
+  )
+{
+  EFI_STATUS           Status;
+  EFI_PEI_FILE_HANDLE  FileHandle;
+  EFI_GUID             *FileNames;
+  EFI_FV_FILE_INFO     FileInfo;
+
+  *Count     = 0;
+  FileHandle = NULL;
+  Status     = FvPpi->FindFileByName (FvPpi, FileName, &FvHandle, &FileHandle);
+  if (EFI_ERROR (Status) || (FileHandle == NULL)) {
+    return NULL;
+  }
+
+  Status = FvPpi->FindSectionByType (FvPpi, EFI_SECTION_RAW, FileHandle, (VOID **)&FileNames);
+  if (EFI_ERROR (Status)) {
+    return NULL;
+  }
+
+  //
+  // Calculate the number of file names in the file
+  //
+  Status = FvPpi->GetFileInfo (FvPpi, FileHandle, &FileInfo);
+  ASSERT_EFI_ERROR (Status);
+  *Count = FileInfo.BufferSize;
+  if (IS_SECTION2 (FileInfo.Buffer)) {
+    *Count -= sizeof (EFI_COMMON_SECTION_HEADER2);
+  } else {
+    *Count -= sizeof (EFI_COMMON_SECTION_HEADER);
+  }
+
+  *Count /= sizeof (EFI_GUID);
+  return FileNames;
+}
+
 /**
 
   Discover all PEIMs and optional Apriori file in one FV. There is at most one
-  Apriori file in one FV.
+  Apriori file in one FV. The PEIMs in the Apriori file come first, followed by
+  the PEIMs in the order of the optional dispatch order hint file, and then by
+  the other PEIMs in FV order.
 
 
   @param Private          Pointer to the private data passed in from caller
@@ -27,8 +83,9 @@ DiscoverPeimsAndOrderWithApriori (
 {
   EFI_STATUS                   Status;
   EFI_PEI_FILE_HANDLE          FileHandle;
-  EFI_PEI_FILE_HANDLE          AprioriFileHandle;
   EFI_GUID                     *Apriori;
+  EFI_GUID                     *Hint;
+  UINTN                        HintCount;
   UINTN                        Index;
   UINTN                        Index2;
   UINTN                        PeimIndex;
@@ -44,7 +101,6 @@ DiscoverPeimsAndOrderWithApriori (
   //
   // Walk the FV and find all the PEIMs and the Apriori file.
   //
-  AprioriFileHandle             = NULL;
   Private->CurrentFvFileHandles = NULL;
   Guid                          = NULL;
 
@@ -124,79 +180,74 @@ DiscoverPeimsAndOrderWithApriori (
   ASSERT (CoreFileHandle->FvFileHandles != NULL);
 
   //
-  // Get Apriori File handle
+  // Get the Apriori file and the dispatch order hint file
   //
-  Private->AprioriCount = 0;
-  Status                = FvPpi->FindFileByName (FvPpi, &gPeiAprioriFileNameGuid, &CoreFileHandle->FvHandle, &AprioriFileHandle);
-  if (!EFI_ERROR (Status) && (AprioriFileHandle != NULL)) {
-    //
-    // Read the Apriori file
-    //
-    Status = FvPpi->FindSectionByType (FvPpi, EFI_SECTION_RAW, AprioriFileHandle, (VOID **)&Apriori);
-    if (!EFI_ERROR (Status)) {
+  Apriori = FindFileNameArray (FvPpi, CoreFileHandle->FvHandle, &gPeiAprioriFileNameGuid, &Private->AprioriCount);
+  Hint    = FindFileNameArray (FvPpi, CoreFileHandle->FvHandle, &gEdkiiDispatchOrderHintFileGuid, &HintCount);
+
+  if ((Apriori != NULL) || (Hint != NULL)) {
+    for (Index = 0; Index < PeimCount; Index++) {
       //
-      // Calculate the number of PEIMs in the Apriori file
+      // Make an array of file name GUIDs that matches the FileHandle array so we can convert
+      // quickly from file name to file handle
       //
-      Status = FvPpi->GetFileInfo (FvPpi, AprioriFileHandle, &FileInfo);
+      Status = FvPpi->GetFileInfo (FvPpi, TempFileHandles[Index], &FileInfo);
       ASSERT_EFI_ERROR (Status);
-      Private->AprioriCount = FileInfo.BufferSize;
-      if (IS_SECTION2 (FileInfo.Buffer)) {
-        Private->AprioriCount -= sizeof (EFI_COMMON_SECTION_HEADER2);
-      } else {
-        Private->AprioriCount -= sizeof (EFI_COMMON_SECTION_HEADER);
-      }
-
-      Private->AprioriCount /= sizeof (EFI_GUID);
+      CopyMem (&TempFileGuid[Index], &FileInfo.FileName, sizeof (EFI_GUID));
+    }
+  }
 
-      for (Index = 0; Index < PeimCount; Index++) {
-        //
-        // Make an array of file name GUIDs that matches the FileHandle array so we can convert
-        // quickly from file name to file handle
-        //
-        Status = FvPpi->GetFileInfo (FvPpi, TempFileHandles[Index], &FileInfo);
-        ASSERT_EFI_ERROR (Status);
-        CopyMem (&TempFileGuid[Index], &FileInfo.FileName, sizeof (EFI_GUID));
-      }
+  //
+  // Walk through TempFileGuid array to find out who is invalid PEIM GUID in Apriori file.
+  // Add available PEIMs in Apriori file into FvFileHandles array.
+  //
+  Index = 0;
+  for (Index2 = 0; Index2 < Private->AprioriCount; Index2++) {
+    Guid = ScanGuid (TempFileGuid, PeimCount * sizeof (EFI_GUID), &Apriori[Index2]);
+    if (Guid != NULL) {
+      PeimIndex                              = ((UINTN)Guid - (UINTN)&TempFileGuid[0])/sizeof (EFI_GUID);
+      CoreFileHandle->FvFileHandles[Index++] = TempFileHandles[PeimIndex];
 
       //
-      // Walk through TempFileGuid array to find out who is invalid PEIM GUID in Apriori file.
-      // Add available PEIMs in Apriori file into FvFileHandles array.
+      // Since we have copied the file handle we can remove it from this list.
       //
-      Index = 0;
-      for (Index2 = 0; Index2 < Private->AprioriCount; Index2++) {
-        Guid = ScanGuid (TempFileGuid, PeimCount * sizeof (EFI_GUID), &Apriori[Index2]);
-        if (Guid != NULL) {
-          PeimIndex                              = ((UINTN)Guid - (UINTN)&TempFileGuid[0])/sizeof (EFI_GUID);
-          CoreFileHandle->FvFileHandles[Index++] = TempFileHandles[PeimIndex];
-
-          //
-          // Since we have copied the file handle we can remove it from this list.
-          //
-          TempFileHandles[PeimIndex] = NULL;
-        }
-      }
+      TempFileHandles[PeimIndex] = NULL;
+    }
+  }
 
-      //
-      // Update valid AprioriCount
-      //
-      Private->AprioriCount = Index;
+  //
+  // Update valid AprioriCount
+  //
+  Private->AprioriCount = Index;
 
-      //
-      // Add in any PEIMs not in the Apriori file
-      //
-      for (Index2 = 0; Index2 < PeimCount; Index2++) {
-        if (TempFileHandles[Index2] != NULL) {
-          CoreFileHandle->FvFileHandles[Index++] = TempFileHandles[Index2];
-          TempFileHandles[Index2]                = NULL;
-        }
+  //
+  // Add the PEIMs in the dispatch order hint file that are not in the Apriori
+  // file. Their DEPEX are still evaluated, the hint only saves the passes of
+  // the dispatcher that would be needed to dispatch them in FV order.
+  //
+  for (Index2 = 0; Index2 < HintCount; Index2++) {
+    Guid = ScanGuid (TempFileGuid, PeimCount * sizeof (EFI_GUID), &Hint[Index2]);
+    if (Guid != NULL) {
+      PeimIndex = ((UINTN)Guid - (UINTN)&TempFileGuid[0])/sizeof (EFI_GUID);
+      if (TempFileHandles[PeimIndex] != NULL) {
+        CoreFileHandle->FvFileHandles[Index++] = TempFileHandles[PeimIndex];
+        TempFileHandles[PeimIndex]             = NULL;
       }
+    }
+  }
 
-      ASSERT (Index == PeimCount);
+  //
+  // Add in any PEIMs not in the Apriori file or in the dispatch order hint file
+  //
+  for (Index2 = 0; Index2 < PeimCount; Index2++) {
+    if (TempFileHandles[Index2] != NULL) {
+      CoreFileHandle->FvFileHandles[Index++] = TempFileHandles[Index2];
+      TempFileHandles[Index2]                = NULL;
     }
-  } else {
-    CopyMem (CoreFileHandle->FvFileHandles, TempFileHandles, sizeof (EFI_PEI_FILE_HANDLE) * PeimCount);
   }
 
+  ASSERT (Index == PeimCount);
+
   //
   // The current FV File Handles have been cached. So that we don't have to scan the FV again.
   // Instead, we can retrieve the file handles within this FV from cached records.
@@ -250,6 +250,9 @@ FileHandleToVolume (
   If SearchType is EFI_FV_FILETYPE_ALL, the first FFS file will return without check its file type.
   If SearchType is PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE,
   the first PEIM, or COMBINED PEIM or FV file type FFS file will return.
+  If SearchType is PEI_CORE_INTERNAL_FFS_FILE_INDEX_TYPE, the first valid FFS
+  file, including a pad file, will return.
+  The search reads the FFS headers of the FV one after another.
 
   @param FvHandle        Pointer to the FV header of the volume to search
   @param FileName        File name
@@ -262,8 +265,9 @@ FileHandleToVolume (
   @retval EFI_SUCCESS    Success to search given file
 
 **/
+STATIC
 EFI_STATUS
-FindFileEx (
+FindFileByWalkingHeaders (
   IN  CONST EFI_PEI_FV_HANDLE    FvHandle,
   IN  CONST EFI_GUID             *FileName    OPTIONAL,
   IN        EFI_FV_FILETYPE      SearchType,
@@ -403,6 +407,9 @@ FindFileEx (
             *FileHeader = FfsFileHeader;
             return EFI_SUCCESS;
           }
+        } else if (SearchType == PEI_CORE_INTERNAL_FFS_FILE_INDEX_TYPE) {
+          *FileHeader = FfsFileHeader;
+          return EFI_SUCCESS;
         } else if (SearchType == PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE) {
           if ((FfsFileHeader->Type == EFI_FV_FILETYPE_PEIM) ||
               (FfsFileHeader->Type == EFI_FV_FILETYPE_COMBINED_PEIM_DRIVER) ||
@@ -455,6 +462,293 @@ FindFileEx (
   return EFI_NOT_FOUND;
 }
 
+/**
+  Returns the slot of the name hash table of a file index a file name hashes to.
+
+  @param FileIndex       The file index
+  @param FileName        The file name
+
+  @return The slot the search for the file name starts from.
+
+**/
+STATIC
+UINTN
+FileIndexNameSlot (
+  IN CONST PEI_CORE_FV_FILE_INDEX  *FileIndex,
+  IN CONST EFI_GUID                *FileName
+  )
+{
+  return (UINTN)(FileName->Data1 ^ ReadUnaligned32 ((CONST UINT32 *)&FileName->Data4[4])) & (FileIndex->NameHashSize - 1);
+}
+
+/**
+  Gets the file index of an FV, and builds it the first time it is requested.
+
+  The index is only built once the permanent memory is installed, so that it
+  survives the temporary RAM, and only for the FVs the PEI Core keeps track of.
+
+  @param FvHandle        Pointer to the FV header of the volume
+
+  @retval NULL           The FV has no file index.
+  @return The file index of the FV.
+
+**/
+STATIC
+PEI_CORE_FV_FILE_INDEX *
+GetFvFileIndex (
+  IN CONST EFI_PEI_FV_HANDLE  FvHandle
+  )
+{
+  PEI_CORE_INSTANCE             *PrivateData;
+  PEI_CORE_FV_HANDLE            *CoreFvHandle;
+  PEI_CORE_FV_FILE_INDEX        *FileIndex;
+  PEI_CORE_FV_FILE_INDEX_ENTRY  *Files;
+  EFI_FFS_FILE_HEADER           *FfsFileHeader;
+  UINTN                         FileCount;
+  UINTN                         NameHashSize;
+  UINTN                         IndexSize;
+  UINTN                         Index;
+  UINTN                         Slot;
+
+  PrivateData = PEI_CORE_INSTANCE_FROM_PS_THIS (GetPeiServicesTablePointer ());
+  if (!PrivateData->PeiMemoryInstalled) {
+    return NULL;
+  }
+
+  CoreFvHandle = FvHandleToCoreHandle ((EFI_PEI_FV_HANDLE)FvHandle);
+  if (CoreFvHandle == NULL) {
+    return NULL;
+  }
+
+  if (CoreFvHandle->FileIndex != NULL) {
+    return CoreFvHandle->FileIndex;
+  }
+
+  //
+  // Count the valid files of the FV first. Memory allocated in PEI is never
+  // freed, so the index, its entries and its name hash table are allocated
+  // once, as one buffer. The walk stops where the FindFileByWalkingHeaders()
+  // searches would stop, so the searches served by the index find the same
+  // files.
+  //
+  FileCount     = 0;
+  FfsFileHeader = NULL;
+  while (!EFI_ERROR (FindFileByWalkingHeaders (FvHandle, NULL, PEI_CORE_INTERNAL_FFS_FILE_INDEX_TYPE, (EFI_PEI_FILE_HANDLE *)&FfsFileHeader, NULL))) {
+    FileCount++;
+  }
+
+  //
+  // Size the name hash table to keep it at most half full.
+  //
+  NameHashSize = 2;
+  while (NameHashSize < 2 * FileCount) {
+    NameHashSize *= 2;
+  }
+
+  IndexSize = sizeof (PEI_CORE_FV_FILE_INDEX) +
+              FileCount * sizeof (PEI_CORE_FV_FILE_INDEX_ENTRY) +
+              NameHashSize * sizeof (UINT32);
+  if (IndexSize <= FV_FILE_INDEX_MAX_POOL_SIZE) {
+    FileIndex = AllocateZeroPool (IndexSize);
+  } else {
+    FileIndex = AllocatePages (EFI_SIZE_TO_PAGES (IndexSize));
+    if (FileIndex != NULL) {
+      ZeroMem (FileIndex, IndexSize);
+    }
+  }
+
+  if (FileIndex == NULL) {
+    return NULL;
+  }
+
+  Files                   = (PEI_CORE_FV_FILE_INDEX_ENTRY *)(FileIndex + 1);
+  FileIndex->Files        = Files;
+  FileIndex->NameHash     = (UINT32 *)(Files + FileCount);
+  FileIndex->NameHashSize = NameHashSize;
+
+  //
+  // Record the files in FV order.
+  //
+  FfsFileHeader = NULL;
+  while ((FileIndex->FileCount < FileCount) &&
+         !EFI_ERROR (FindFileByWalkingHeaders (FvHandle, NULL, PEI_CORE_INTERNAL_FFS_FILE_INDEX_TYPE, (EFI_PEI_FILE_HANDLE *)&FfsFileHeader, NULL)))
+  {
+    CopyGuid (&Files[FileIndex->FileCount].Name, &FfsFileHeader->Name);
+    Files[FileIndex->FileCount].Offset = (UINT32)((UINTN)FfsFileHeader - (UINTN)FvHandle);
+    Files[FileIndex->FileCount].Type   = FfsFileHeader->Type;
+    FileIndex->FileCount++;
+  }
+
+  for (Index = 0; Index < FileIndex->FileCount; Index++) {
+    Slot = FileIndexNameSlot (FileIndex, &Files[Index].Name);
+    while (FileIndex->NameHash[Slot] != 0) {
+      Slot = (Slot + 1) & (FileIndex->NameHashSize - 1);
+    }
+
+    FileIndex->NameHash[Slot] = (UINT32)(Index + 1);
+  }
+
+  DEBUG ((DEBUG_VERBOSE, "Indexed %d files of FV at 0x%p\n", FileIndex->FileCount, FvHandle));
+
+  CoreFvHandle->FileIndex = FileIndex;
+  return FileIndex;
+}
+
+/**
+  Given the input file pointer, search for the first matching file in the
+  file index of an FV, as FindFileByWalkingHeaders() does in the FV itself.
+
+  @param FvHandle        Pointer to the FV header of the volume to search
+  @param FileIndex       The file index of the FV
+  @param FileName        File name
+  @param SearchType      Filter to find only files of this type.
+                         Type EFI_FV_FILETYPE_ALL causes no filtering to be done.
+  @param FileHandle      This parameter must point to a valid FFS volume.
+
+  @return EFI_NOT_FOUND  No files matching the search criteria were found
+  @retval EFI_SUCCESS    Success to search given file
+
+**/
+STATIC
+EFI_STATUS
+FindFileInIndex (
+  IN  CONST EFI_PEI_FV_HANDLE       FvHandle,
+  IN OUT    PEI_CORE_FV_FILE_INDEX  *FileIndex,
+  IN  CONST EFI_GUID                *FileName    OPTIONAL,
+  IN        EFI_FV_FILETYPE         SearchType,
+  IN OUT    EFI_PEI_FILE_HANDLE     *FileHandle
+  )
+{
+  EFI_FFS_FILE_HEADER           **FileHeader;
+  PEI_CORE_FV_FILE_INDEX_ENTRY  *Entry;
+  UINTN                         Slot;
+  UINTN                         Start;
+  UINTN                         Index;
+  UINTN                         Low;
+  UINTN                         High;
+  UINTN                         Middle;
+  UINT32                        Offset;
+
+  FileHeader = (EFI_FFS_FILE_HEADER **)FileHandle;
+
+  if (FileName != NULL) {
+    for (Slot = FileIndexNameSlot (FileIndex, FileName);
+         FileIndex->NameHash[Slot] != 0;
+         Slot = (Slot + 1) & (FileIndex->NameHashSize - 1))
+    {
+      Index = FileIndex->NameHash[Slot] - 1;
+      Entry = &FileIndex->Files[Index];
+      if (CompareGuid (&Entry->Name, FileName)) {
+        FileIndex->HeaderReadsSaved += Index + 1;
+        *FileHeader                  = (EFI_FFS_FILE_HEADER *)((UINT8 *)FvHandle + Entry->Offset);
+        return EFI_SUCCESS;
+      }
+    }
+
+    FileIndex->HeaderReadsSaved += FileIndex->FileCount;
+    *FileHeader                  = NULL;
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Resume the search after the file FileHeader points to.
+  //
+  Start = 0;
+  if (*FileHeader != NULL) {
+    Offset = (UINT32)((UINTN)*FileHeader - (UINTN)FvHandle);
+    Low    = 0;
+    High   = FileIndex->FileCount;
+    while (Low < High) {
+      Middle = Low + (High - Low) / 2;
+      if (FileIndex->Files[Middle].Offset < Offset) {
+        Low = Middle + 1;
+      } else {
+        High = Middle;
+      }
+    }
+
+    if ((Low == FileIndex->FileCount) || (FileIndex->Files[Low].Offset != Offset)) {
+      //
+      // The file is not a valid file of the FV, walk from it as before.
+      //
+      return FindFileByWalkingHeaders (FvHandle, NULL, SearchType, FileHandle, NULL);
+    }
+
+    Start = Low + 1;
+  }
+
+  for (Index = Start; Index < FileIndex->FileCount; Index++) {
+    Entry = &FileIndex->Files[Index];
+    if (SearchType == PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE) {
+      if ((Entry->Type == EFI_FV_FILETYPE_PEIM) ||
+          (Entry->Type == EFI_FV_FILETYPE_COMBINED_PEIM_DRIVER) ||
+          (Entry->Type == EFI_FV_FILETYPE_FIRMWARE_VOLUME_IMAGE))
+      {
+        break;
+      }
+    } else if (((SearchType == Entry->Type) || (SearchType == EFI_FV_FILETYPE_ALL)) &&
+               (Entry->Type != EFI_FV_FILETYPE_FFS_PAD))
+    {
+      break;
+    }
+  }
+
+  if (Index == FileIndex->FileCount) {
+    FileIndex->HeaderReadsSaved += Index - Start;
+    *FileHeader                  = NULL;
+    return EFI_NOT_FOUND;
+  }
+
+  FileIndex->HeaderReadsSaved += Index - Start + 1;
+  *FileHeader                  = (EFI_FFS_FILE_HEADER *)((UINT8 *)FvHandle + FileIndex->Files[Index].Offset);
+  return EFI_SUCCESS;
+}
+
+/**
+  Given the input file pointer, search for the first matching file in the
+  FFS volume as defined by SearchType. The search starts from FileHeader inside
+  the Firmware Volume defined by FwVolHeader.
+  If SearchType is EFI_FV_FILETYPE_ALL, the first FFS file will return without check its file type.
+  If SearchType is PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE,
+  the first PEIM, or COMBINED PEIM or FV file type FFS file will return.
+  The search is served by the file index of the FV when it has one.
+
+  @param FvHandle        Pointer to the FV header of the volume to search
+  @param FileName        File name
+  @param SearchType      Filter to find only files of this type.
+                         Type EFI_FV_FILETYPE_ALL causes no filtering to be done.
+  @param FileHandle      This parameter must point to a valid FFS volume.
+  @param AprioriFile     Pointer to AprioriFile image in this FV if has
+
+  @return EFI_NOT_FOUND  No files matching the search criteria were found
+  @retval EFI_SUCCESS    Success to search given file
+
+**/
+EFI_STATUS
+FindFileEx (
+  IN  CONST EFI_PEI_FV_HANDLE    FvHandle,
+  IN  CONST EFI_GUID             *FileName    OPTIONAL,
+  IN        EFI_FV_FILETYPE      SearchType,
+  IN OUT    EFI_PEI_FILE_HANDLE  *FileHandle,
+  IN OUT    EFI_PEI_FILE_HANDLE  *AprioriFile  OPTIONAL
+  )
+{
+  PEI_CORE_FV_FILE_INDEX  *FileIndex;
+
+  //
+  // The index does not record the a priori file, so the searches looking for
+  // it still walk the FFS headers.
+  //
+  if (AprioriFile == NULL) {
+    FileIndex = GetFvFileIndex (FvHandle);
+    if (FileIndex != NULL) {
+      return FindFileInIndex (FvHandle, FileIndex, FileName, SearchType, FileHandle);
+    }
+  }
+
+  return FindFileByWalkingHeaders (FvHandle, FileName, SearchType, FileHandle, AprioriFile);
+}
+
 /**
   Initialize PeiCore FV List.
 
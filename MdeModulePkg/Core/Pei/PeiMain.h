@@ -44,6 +44,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/FirmwareFileSystem2.h>
 #include <Guid/FirmwareFileSystem3.h>
 #include <Guid/AprioriFileName.h>
+#include <Guid/DispatchOrderHintFile.h>
 #include <Guid/MigratedFvInfo.h>
 
 ///
@@ -52,6 +53,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 ///
 #define PEI_CORE_INTERNAL_FFS_FILE_DISPATCH_TYPE  0xff
 
+///
+/// It is an FFS type extension used for PeiFindFileEx. It indicates current
+/// FFS searching is for all valid files, including the pad files, and is
+/// used to build the file index of an FV.
+///
+#define PEI_CORE_INTERNAL_FFS_FILE_INDEX_TYPE  0xfe
+
 ///
 /// Pei Core private data structures
 ///
@@ -131,6 +139,45 @@ typedef struct {
 //
 #define FV_GROWTH_STEP  8
 
+//
+// File indexes larger than this are allocated as pages rather than from the
+// HOB list
+//
+#define FV_FILE_INDEX_MAX_POOL_SIZE  EFI_PAGE_SIZE
+
+///
+/// A valid file of an FV, as recorded by the file index of the FV
+///
+typedef struct {
+  EFI_GUID           Name;
+  UINT32             Offset;
+  EFI_FV_FILETYPE    Type;
+} PEI_CORE_FV_FILE_INDEX_ENTRY;
+
+///
+/// Index of the valid files of an FV. It is built by walking the FFS headers
+/// of the FV once, the first time a file of the FV is searched for after the
+/// permanent memory is installed, and then serves the searches by name and by
+/// type without reading the FFS headers again.
+///
+typedef struct {
+  UINTN                           FileCount;
+  //
+  // Pointer to the buffer with the FileCount number of Entries, in FV order.
+  //
+  PEI_CORE_FV_FILE_INDEX_ENTRY    *Files;
+  //
+  // Open addressing hash table of the file names. Each slot holds the index
+  // of an entry of Files plus one, or zero if the slot is empty.
+  //
+  UINT32                          *NameHash;
+  UINTN                           NameHashSize;
+  //
+  // Number of FFS headers the searches served by the index did not read.
+  //
+  UINT64                          HeaderReadsSaved;
+} PEI_CORE_FV_FILE_INDEX;
+
 typedef struct {
   EFI_FIRMWARE_VOLUME_HEADER     *FvHeader;
   EFI_PEI_FIRMWARE_VOLUME_PPI    *FvPpi;
@@ -146,6 +193,10 @@ typedef struct {
   EFI_PEI_FILE_HANDLE            *FvFileHandles;
   BOOLEAN                        ScanFv;
   UINT32                         AuthenticationStatus;
+  //
+  // File index of the FV, NULL until it is built.
+  //
+  PEI_CORE_FV_FILE_INDEX         *FileIndex;
 } PEI_CORE_FV_HANDLE;
 
 typedef struct {
@@ -178,6 +178,7 @@ PeiCore (
   EFI_HOB_HANDOFF_INFO_TABLE      *HandoffInformationTable;
   EFI_PEI_TEMPORARY_RAM_DONE_PPI  *TemporaryRamDonePpi;
   UINTN                           Index;
+  UINT64                          HeaderReadsSaved;
 
   //
   // Retrieve context passed into PEI Core
@@ -522,6 +523,20 @@ PeiCore (
     CpuDeadLoop ();
   }
 
+  DEBUG_CODE_BEGIN ();
+  //
+  // Report how many FFS header reads the file indexes of the FVs saved.
+  //
+  HeaderReadsSaved = 0;
+  for (Index = 0; Index < PrivateData.FvCount; Index++) {
+    if (PrivateData.Fv[Index].FileIndex != NULL) {
+      HeaderReadsSaved += PrivateData.Fv[Index].FileIndex->HeaderReadsSaved;
+    }
+  }
+
+  DEBUG ((DEBUG_INFO, "FV file indexes saved %ld FFS header reads\n", HeaderReadsSaved));
+  DEBUG_CODE_END ();
+
   //
   // Enter DxeIpl to load Dxe core.
   //
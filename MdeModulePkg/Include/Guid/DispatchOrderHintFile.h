@@ -0,0 +1,25 @@
+/** @file
+  The file name of the dispatch order hint file that GenFv can add to a
+  firmware volume.
+
+  The file is of type EFI_FV_FILETYPE_FREEFORM and contains a single section
+  of type EFI_SECTION_RAW, holding the file names of the PEIMs and DXE drivers
+  of the firmware volume in the order that static analysis of their dependency
+  expressions expects them to be dispatched. Unlike the a priori file the
+  dependency expressions are still evaluated, the order only decides which
+  modules are tried first.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __EDKII_DISPATCH_ORDER_HINT_FILE_GUID_H__
+#define __EDKII_DISPATCH_ORDER_HINT_FILE_GUID_H__
+
+#define EDKII_DISPATCH_ORDER_HINT_FILE_GUID \
+  { 0x2cc4d19f, 0x5008, 0x4dc5, { 0x8c, 0x95, 0x59, 0x0d, 0x2d, 0x3a, 0x5a, 0x47 } }
+
+extern EFI_GUID  gEdkiiDispatchOrderHintFileGuid;
+
+#endif // #ifndef __EDKII_DISPATCH_ORDER_HINT_FILE_GUID_H__
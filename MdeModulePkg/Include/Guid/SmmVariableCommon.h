@@ -138,6 +138,15 @@ typedef struct {
   VARIABLE_STORE_HEADER    *RuntimeHobCache;
   VARIABLE_STORE_HEADER    *RuntimeNvCache;
   VARIABLE_STORE_HEADER    *RuntimeVolatileCache;
+  ///
+  /// Incremented each time the variables of a store are moved by a reclaim.
+  ///
+  UINT32                   *RewriteCount;
+  ///
+  /// Incremented before and after each update of the runtime caches, so it
+  /// is odd while an update is in progress.
+  ///
+  UINT32                   *SequenceCount;
 } SMM_VARIABLE_COMMUNICATE_RUNTIME_VARIABLE_CACHE_CONTEXT;
 
 typedef struct {
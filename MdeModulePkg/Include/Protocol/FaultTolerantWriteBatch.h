@@ -0,0 +1,93 @@
+/** @file
+  Fault Tolerant Write Batch protocol writes a set of ranges of a firmware
+  volume in a fault tolerant manner.
+
+  A write of the Fault Tolerant Write protocol always goes through a full
+  update of the spare block, even when a caller issues many small writes to
+  the same block. This protocol takes all the writes at once, merges the
+  writes that fall in the same group of blocks, and updates each group with a
+  single spare block update and a single write record. All the records of a
+  batch share one write header, so the batch is recovered like the writes
+  allocated by the Allocate() service of the Fault Tolerant Write protocol.
+
+  The SMM instance of the protocol has the same interface.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __FAULT_TOLERANT_WRITE_BATCH_H__
+#define __FAULT_TOLERANT_WRITE_BATCH_H__
+
+#define EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL_GUID \
+  { \
+    0xa4ae45fd, 0x7783, 0x4907, { 0x8d, 0x3b, 0x4d, 0xa6, 0xe9, 0xf7, 0x39, 0x29 } \
+  }
+
+#define EDKII_SMM_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL_GUID \
+  { \
+    0x8d94c106, 0xc4f5, 0x46ca, { 0x8d, 0x42, 0x8c, 0xc0, 0xed, 0xa1, 0x90, 0x9c } \
+  }
+
+typedef struct _EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL;
+
+///
+/// One write of a batch. As for the Write() service of the Fault Tolerant
+/// Write protocol, Offset may be larger than the size of the block at Lba.
+///
+typedef struct {
+  EFI_LBA    Lba;
+  UINTN      Offset;
+  UINTN      Length;
+  VOID       *Buffer;
+} EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY;
+
+/**
+  Writes a set of ranges of a firmware volume in a fault tolerant manner.
+
+  The writes are applied in the order of the array, so when two writes
+  overlap, the data of the later one is kept. The writes that fall in the
+  same group of blocks, no larger than the spare area, are committed together
+  with one spare block update and one write record.
+
+  Each group is committed in a recoverable manner, ensuring at all times that
+  either the original or the modified contents of its blocks are available.
+  The groups are not committed atomically with respect to each other.
+
+  @param  This                 The calling context.
+  @param  CallerId             The GUID recorded in the write header of the batch.
+  @param  FvBlockHandle        The handle of FVB protocol that provides services
+                               for reading, writing, and erasing the target blocks.
+  @param  NumberOfWrites       The number of entries in Writes.
+  @param  Writes               The writes to do.
+
+  @retval EFI_SUCCESS          All the writes completed successfully.
+  @retval EFI_INVALID_PARAMETER CallerId or Writes is NULL, or a Buffer is NULL.
+  @retval EFI_BAD_BUFFER_SIZE  A write does not fit within the spare area.
+  @retval EFI_BUFFER_TOO_SMALL The work space cannot record all the groups.
+  @retval EFI_UNSUPPORTED      The target blocks are the boot block.
+  @retval EFI_ACCESS_DENIED    A previous write has not been completed.
+  @retval EFI_NOT_FOUND        The FVB protocol cannot be found by handle.
+  @retval EFI_OUT_OF_RESOURCES Not enough memory.
+  @retval EFI_ABORTED          The function could not complete successfully.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_FAULT_TOLERANT_WRITE_BATCH_WRITE)(
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL  *This,
+  IN EFI_GUID                                   *CallerId,
+  IN EFI_HANDLE                                 FvBlockHandle,
+  IN UINTN                                      NumberOfWrites,
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY     *Writes
+  );
+
+struct _EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL {
+  EDKII_FAULT_TOLERANT_WRITE_BATCH_WRITE    WriteBatch;
+};
+
+extern EFI_GUID  gEdkiiFaultTolerantWriteBatchProtocolGuid;
+extern EFI_GUID  gEdkiiSmmFaultTolerantWriteBatchProtocolGuid;
+
+#endif
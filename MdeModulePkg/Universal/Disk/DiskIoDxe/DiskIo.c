@@ -186,6 +186,20 @@ DiskIoDriverBindingStart (
     goto ErrorExit;
   }
 
+  //
+  // The block cache is optional, run without it when there is not enough memory.
+  // Only the raw disk has a cache: the partition driver reads and writes through the
+  // Disk I/O of the disk, so a cache per partition would hold the data twice and would
+  // miss the writes done through the disk or the other partitions.
+  //
+  Status = DiskIoCacheInitialize (
+             Instance,
+             Instance->BlockIo->Media->LogicalPartition ? 0 : PcdGet32 (PcdDiskIoCacheLineNum)
+             );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "DiskIo: Failed to allocate the block cache - %r\n", Status));
+  }
+
   //
   // Install protocol interfaces for the Disk IO device.
   //
@@ -217,6 +231,7 @@ ErrorExit:
     }
 
     if (Instance != NULL) {
+      DiskIoCacheFree (Instance);
       FreePool (Instance);
     }
 
@@ -329,6 +344,7 @@ DiskIoDriverBindingStop (
       Instance->SharedWorkingBuffer,
       EFI_SIZE_TO_PAGES (PcdGet32 (PcdDiskIoDataBufferBlockNum) * Instance->BlockIo->Media->BlockSize)
       );
+    DiskIoCacheFree (Instance);
 
     Status = gBS->CloseProtocol (
                     ControllerHandle,
@@ -865,6 +881,20 @@ DiskIo2ReadWriteDisk (
     while (!DiskIo2RemoveCompletedTask (Instance)) {
     }
 
+    if (!Write) {
+      //
+      // Serve the blocking reads from the block cache.
+      //
+      OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+      Status = DiskIoCacheRead (Instance, MediaId, Offset, BufferSize, Buffer);
+      gBS->RestoreTPL (OldTpl);
+      if (Status != EFI_UNSUPPORTED) {
+        return Status;
+      }
+
+      Status = EFI_SUCCESS;
+    }
+
     SubtasksPtr = &Subtasks;
   } else {
     DiskIo2RemoveCompletedTask (Instance);
@@ -977,6 +1007,18 @@ DiskIo2ReadWriteDisk (
     }
   }
 
+  if (Write) {
+    //
+    // Keep the block cache in sync with the disk.
+    // The data of the non-blocking writes reaches the disk later, drop the cached blocks.
+    //
+    if (Blocking && !EFI_ERROR (Status)) {
+      DiskIoCacheWrite (Instance, Offset, BufferSize, Buffer);
+    } else {
+      DiskIoCacheInvalidate (Instance, Offset, BufferSize);
+    }
+  }
+
   gBS->RaiseTPL (TPL_NOTIFY);
 
   //
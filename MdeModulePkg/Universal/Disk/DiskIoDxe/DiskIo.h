@@ -24,6 +24,36 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
+//
+// Size of a line of the block cache, and number of lines read ahead when the reads are sequential.
+// The requests longer than DISK_IO_CACHE_BYPASS_LINES lines don't go through the cache.
+//
+#define DISK_IO_CACHE_LINE_SIZE         SIZE_64KB
+#define DISK_IO_CACHE_READ_AHEAD_LINES  4
+#define DISK_IO_CACHE_BYPASS_LINES      4
+
+typedef struct {
+  LIST_ENTRY    Link;                           /// < link in the LRU list, most recently used first
+  EFI_LBA       Lba;                            /// < first block of the line
+  UINTN         Blocks;                         /// < number of cached blocks, 0 indicates a free line
+  UINT8         *Data;
+} DISK_IO_CACHE_LINE;
+
+typedef struct {
+  UINTN                 LineNum;                /// < 0 indicates the cache is disabled
+  UINTN                 LineBlocks;
+  UINT32                BlockSize;
+  UINT32                MediaId;
+  DISK_IO_CACHE_LINE    *Lines;
+  UINT8                 *Data;
+  UINTN                 DataPages;
+  LIST_ENTRY            LruList;
+  EFI_LBA               NextLba;                /// < first block after the last line read, to detect sequential reads
+  UINT64                Hits;
+  UINT64                Misses;
+  UINT64                ReadAheads;
+} DISK_IO_CACHE;
+
 #define DISK_IO_PRIVATE_DATA_SIGNATURE  SIGNATURE_32 ('d', 's', 'k', 'I')
 typedef struct {
   UINT32                    Signature;
@@ -37,6 +67,8 @@ typedef struct {
 
   EFI_LOCK                  TaskQueueLock;
   LIST_ENTRY                TaskQueue;
+
+  DISK_IO_CACHE             Cache;
 } DISK_IO_PRIVATE_DATA;
 #define DISK_IO_PRIVATE_DATA_FROM_DISK_IO(a)   CR (a, DISK_IO_PRIVATE_DATA, DiskIo,  DISK_IO_PRIVATE_DATA_SIGNATURE)
 #define DISK_IO_PRIVATE_DATA_FROM_DISK_IO2(a)  CR (a, DISK_IO_PRIVATE_DATA, DiskIo2, DISK_IO_PRIVATE_DATA_SIGNATURE)
@@ -464,4 +496,88 @@ DiskIoComponentNameGetControllerName (
   OUT CHAR16                       **ControllerName
   );
 
+//
+// Block cache
+//
+
+/**
+  Initialize the block cache of the Disk IO device instance.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param LineNum      Number of cache lines. 0 disables the cache.
+
+  @retval EFI_SUCCESS           The cache is initialized, or disabled.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory for the cache.
+**/
+EFI_STATUS
+DiskIoCacheInitialize (
+  IN DISK_IO_PRIVATE_DATA  *Instance,
+  IN UINTN                 LineNum
+  );
+
+/**
+  Free the block cache of the Disk IO device instance.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoCacheFree (
+  IN DISK_IO_PRIVATE_DATA  *Instance
+  );
+
+/**
+  Drop the cached blocks overlapping a byte range of the disk.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Offset       The starting byte offset of the range.
+  @param Length       The length in bytes of the range. MAX_UINT64 drops all the cached blocks.
+**/
+VOID
+DiskIoCacheInvalidate (
+  IN DISK_IO_PRIVATE_DATA  *Instance,
+  IN UINT64                Offset,
+  IN UINT64                Length
+  );
+
+/**
+  Read bytes from the disk through the block cache.
+
+  The missing lines are read from the disk and kept in the cache. When the line read
+  follows the line read last, the next lines are read ahead.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param MediaId      ID of the medium to be read.
+  @param Offset       The starting byte offset on the disk to read from.
+  @param BufferSize   The size in bytes of Buffer.
+  @param Buffer       A pointer to the destination buffer for the data.
+
+  @retval EFI_SUCCESS           The data was read from the cache and the disk.
+  @retval EFI_UNSUPPORTED       The request doesn't go through the cache. Nothing is read.
+  @retval others                The status of the failed read of the disk.
+**/
+EFI_STATUS
+DiskIoCacheRead (
+  IN  DISK_IO_PRIVATE_DATA  *Instance,
+  IN  UINT32                MediaId,
+  IN  UINT64                Offset,
+  IN  UINTN                 BufferSize,
+  OUT UINT8                 *Buffer
+  );
+
+/**
+  Update the cached blocks overlapping the bytes written to the disk.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Offset       The starting byte offset on the disk written to.
+  @param BufferSize   The size in bytes of Buffer.
+  @param Buffer       A pointer to the data written.
+**/
+VOID
+DiskIoCacheWrite (
+  IN DISK_IO_PRIVATE_DATA  *Instance,
+  IN UINT64                Offset,
+  IN UINTN                 BufferSize,
+  IN UINT8                 *Buffer
+  );
+
 #endif
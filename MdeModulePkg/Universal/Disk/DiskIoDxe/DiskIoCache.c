@@ -0,0 +1,404 @@
+/** @file
+  Block cache of the DiskIo driver.
+
+  The blocks of the disk are kept in lines of DISK_IO_CACHE_LINE_SIZE bytes, aligned on
+  the line size and replaced in least recently used order. The blocking reads are served
+  from the cache. The writes go to the disk and then update the cached blocks, so the
+  cache never holds data different from the disk.
+
+  Only the Disk I/O instance of the raw disk (not of a logical partition) has a cache;
+  the partitions are accessed through the Disk I/O of the disk. Writes that go straight
+  to Block I/O (or Block I/O 2) bypass the cache and are not seen by it; the cache is
+  only dropped when the media ID changes or the media is removed.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DiskIo.h"
+
+/**
+  Initialize the block cache of the Disk IO device instance.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param LineNum      Number of cache lines. 0 disables the cache.
+
+  @retval EFI_SUCCESS           The cache is initialized, or disabled.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory for the cache.
+**/
+EFI_STATUS
+DiskIoCacheInitialize (
+  IN DISK_IO_PRIVATE_DATA  *Instance,
+  IN UINTN                 LineNum
+  )
+{
+  DISK_IO_CACHE       *Cache;
+  EFI_BLOCK_IO_MEDIA  *Media;
+  UINTN               Index;
+
+  Cache = &Instance->Cache;
+  Media = Instance->BlockIo->Media;
+  ZeroMem (Cache, sizeof (DISK_IO_CACHE));
+  InitializeListHead (&Cache->LruList);
+
+  if ((LineNum == 0) || (Media->BlockSize == 0)) {
+    return EFI_SUCCESS;
+  }
+
+  Cache->BlockSize  = Media->BlockSize;
+  Cache->LineBlocks = MAX (DISK_IO_CACHE_LINE_SIZE / Media->BlockSize, 1);
+  Cache->DataPages  = EFI_SIZE_TO_PAGES (LineNum * Cache->LineBlocks * Media->BlockSize);
+  Cache->Lines      = AllocateZeroPool (LineNum * sizeof (DISK_IO_CACHE_LINE));
+  Cache->Data       = AllocateAlignedPages (Cache->DataPages, Media->IoAlign);
+  if ((Cache->Lines == NULL) || (Cache->Data == NULL)) {
+    DiskIoCacheFree (Instance);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < LineNum; Index++) {
+    Cache->Lines[Index].Data = Cache->Data + Index * Cache->LineBlocks * Media->BlockSize;
+    InsertTailList (&Cache->LruList, &Cache->Lines[Index].Link);
+  }
+
+  Cache->LineNum = LineNum;
+  Cache->MediaId = Media->MediaId;
+  Cache->NextLba = MAX_UINT64;
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the block cache of the Disk IO device instance.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoCacheFree (
+  IN DISK_IO_PRIVATE_DATA  *Instance
+  )
+{
+  DISK_IO_CACHE  *Cache;
+
+  Cache = &Instance->Cache;
+  if (Cache->LineNum != 0) {
+    DEBUG ((
+      DEBUG_INFO,
+      "DiskIo: Cache hits = %ld, misses = %ld, read-aheads = %ld\n",
+      Cache->Hits,
+      Cache->Misses,
+      Cache->ReadAheads
+      ));
+  }
+
+  if (Cache->Data != NULL) {
+    FreeAlignedPages (Cache->Data, Cache->DataPages);
+  }
+
+  if (Cache->Lines != NULL) {
+    FreePool (Cache->Lines);
+  }
+
+  ZeroMem (Cache, sizeof (DISK_IO_CACHE));
+  InitializeListHead (&Cache->LruList);
+}
+
+/**
+  Drop the cached blocks overlapping a byte range of the disk.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Offset       The starting byte offset of the range.
+  @param Length       The length in bytes of the range. MAX_UINT64 drops all the cached blocks.
+**/
+VOID
+DiskIoCacheInvalidate (
+  IN DISK_IO_PRIVATE_DATA  *Instance,
+  IN UINT64                Offset,
+  IN UINT64                Length
+  )
+{
+  DISK_IO_CACHE       *Cache;
+  DISK_IO_CACHE_LINE  *Line;
+  LIST_ENTRY          *Link;
+  LIST_ENTRY          *NextLink;
+  UINT64              LineStart;
+  UINT64              LineEnd;
+
+  Cache = &Instance->Cache;
+  if (Length == MAX_UINT64) {
+    Cache->NextLba = MAX_UINT64;
+  }
+
+  for (Link = GetFirstNode (&Cache->LruList); !IsNull (&Cache->LruList, Link); Link = NextLink) {
+    NextLink = GetNextNode (&Cache->LruList, Link);
+    Line     = BASE_CR (Link, DISK_IO_CACHE_LINE, Link);
+    if (Line->Blocks == 0) {
+      //
+      // The free lines are at the end of the LRU list.
+      //
+      break;
+    }
+
+    LineStart = MultU64x32 (Line->Lba, Cache->BlockSize);
+    LineEnd   = LineStart + MultU64x32 (Line->Blocks, Cache->BlockSize);
+    if ((Length == MAX_UINT64) || ((LineStart < Offset + Length) && (Offset < LineEnd))) {
+      Line->Blocks = 0;
+      RemoveEntryList (Link);
+      InsertTailList (&Cache->LruList, Link);
+    }
+  }
+}
+
+/**
+  Drop all the cached blocks when the media has changed.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+
+  @retval TRUE        The cache can be used for the current media.
+  @retval FALSE       There is no media, or the block size of the media differs from the cache.
+**/
+BOOLEAN
+DiskIoCacheCheckMedia (
+  IN DISK_IO_PRIVATE_DATA  *Instance
+  )
+{
+  DISK_IO_CACHE       *Cache;
+  EFI_BLOCK_IO_MEDIA  *Media;
+
+  Cache = &Instance->Cache;
+  Media = Instance->BlockIo->Media;
+  if (!Media->MediaPresent || (Media->MediaId != Cache->MediaId) || (Media->BlockSize != Cache->BlockSize)) {
+    DiskIoCacheInvalidate (Instance, 0, MAX_UINT64);
+    Cache->MediaId = Media->MediaId;
+  }
+
+  return (BOOLEAN)(Media->MediaPresent && (Media->BlockSize == Cache->BlockSize));
+}
+
+/**
+  Find the cache line starting at a block.
+
+  @param Cache        Pointer to the DISK_IO_CACHE.
+  @param LineLba      The first block of the line.
+
+  @return The cache line, or NULL when the line isn't cached.
+**/
+DISK_IO_CACHE_LINE *
+DiskIoCacheLookup (
+  IN DISK_IO_CACHE  *Cache,
+  IN EFI_LBA        LineLba
+  )
+{
+  DISK_IO_CACHE_LINE  *Line;
+  LIST_ENTRY          *Link;
+
+  for (Link = GetFirstNode (&Cache->LruList); !IsNull (&Cache->LruList, Link); Link = GetNextNode (&Cache->LruList, Link)) {
+    Line = BASE_CR (Link, DISK_IO_CACHE_LINE, Link);
+    if (Line->Blocks == 0) {
+      break;
+    }
+
+    if (Line->Lba == LineLba) {
+      return Line;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Read a line from the disk into the least recently used cache line.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param MediaId      ID of the medium to be read.
+  @param LineLba      The first block of the line.
+  @param Line         Return the cache line holding the blocks.
+
+  @retval EFI_SUCCESS The line is read.
+  @retval others      The status of the failed read of the disk.
+**/
+EFI_STATUS
+DiskIoCacheFill (
+  IN  DISK_IO_PRIVATE_DATA  *Instance,
+  IN  UINT32                MediaId,
+  IN  EFI_LBA               LineLba,
+  OUT DISK_IO_CACHE_LINE    **Line
+  )
+{
+  EFI_STATUS             Status;
+  DISK_IO_CACHE          *Cache;
+  EFI_BLOCK_IO_PROTOCOL  *BlockIo;
+  UINTN                  Blocks;
+
+  Cache   = &Instance->Cache;
+  BlockIo = Instance->BlockIo;
+  Blocks  = (UINTN)MIN (Cache->LineBlocks, BlockIo->Media->LastBlock + 1 - LineLba);
+
+  *Line           = BASE_CR (GetPreviousNode (&Cache->LruList, &Cache->LruList), DISK_IO_CACHE_LINE, Link);
+  (*Line)->Blocks = 0;
+  Status          = BlockIo->ReadBlocks (BlockIo, MediaId, LineLba, Blocks * Cache->BlockSize, (*Line)->Data);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  (*Line)->Lba    = LineLba;
+  (*Line)->Blocks = Blocks;
+  RemoveEntryList (&(*Line)->Link);
+  InsertHeadList (&Cache->LruList, &(*Line)->Link);
+  return EFI_SUCCESS;
+}
+
+/**
+  Read bytes from the disk through the block cache.
+
+  The missing lines are read from the disk and kept in the cache. When the first line
+  missing follows the line read last, the next lines are read ahead.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param MediaId      ID of the medium to be read.
+  @param Offset       The starting byte offset on the disk to read from.
+  @param BufferSize   The size in bytes of Buffer.
+  @param Buffer       A pointer to the destination buffer for the data.
+
+  @retval EFI_SUCCESS           The data was read from the cache and the disk.
+  @retval EFI_UNSUPPORTED       The request doesn't go through the cache. Nothing is read.
+  @retval others                The status of the failed read of the disk.
+**/
+EFI_STATUS
+DiskIoCacheRead (
+  IN  DISK_IO_PRIVATE_DATA  *Instance,
+  IN  UINT32                MediaId,
+  IN  UINT64                Offset,
+  IN  UINTN                 BufferSize,
+  OUT UINT8                 *Buffer
+  )
+{
+  EFI_STATUS          Status;
+  DISK_IO_CACHE       *Cache;
+  EFI_BLOCK_IO_MEDIA  *Media;
+  DISK_IO_CACHE_LINE  *Line;
+  DISK_IO_CACHE_LINE  *AheadLine;
+  EFI_LBA             Lba;
+  EFI_LBA             LineLba;
+  EFI_LBA             AheadLba;
+  UINT32              Remainder;
+  UINTN               OffsetInLine;
+  UINTN               Length;
+  UINTN               Index;
+  BOOLEAN             ReadAhead;
+
+  Cache = &Instance->Cache;
+  Media = Instance->BlockIo->Media;
+  if ((Cache->LineNum == 0) || !DiskIoCacheCheckMedia (Instance)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Leave the errors to the reads of the disk, and the long reads to the disk directly.
+  //
+  if ((MediaId != Media->MediaId) || (BufferSize == 0) ||
+      (BufferSize > DISK_IO_CACHE_BYPASS_LINES * Cache->LineBlocks * Cache->BlockSize) ||
+      (Offset + BufferSize < Offset) ||
+      (Offset + BufferSize > MultU64x32 (Media->LastBlock + 1, Cache->BlockSize)))
+  {
+    return EFI_UNSUPPORTED;
+  }
+
+  ReadAhead = TRUE;
+  while (BufferSize > 0) {
+    Lba     = DivU64x32Remainder (Offset, Cache->BlockSize, &Remainder);
+    LineLba = Lba - ModU64x32 (Lba, (UINT32)Cache->LineBlocks);
+    Line    = DiskIoCacheLookup (Cache, LineLba);
+    if (Line != NULL) {
+      Cache->Hits++;
+    } else {
+      Cache->Misses++;
+      Status = DiskIoCacheFill (Instance, MediaId, LineLba, &Line);
+      if (EFI_ERROR (Status)) {
+        DiskIoCacheInvalidate (Instance, 0, MAX_UINT64);
+        return Status;
+      }
+
+      //
+      // Read the next lines ahead when the reads are sequential. The lines missing
+      // after the first one belong to a long read, not necessarily to a sequence.
+      // Half of the cache at most is used by the lines read ahead.
+      //
+      AheadLba = LineLba + Cache->LineBlocks;
+      if (ReadAhead && (LineLba == Cache->NextLba)) {
+        for (Index = 0; Index < MIN (DISK_IO_CACHE_READ_AHEAD_LINES, Cache->LineNum / 2); Index++) {
+          if (AheadLba > Media->LastBlock) {
+            break;
+          }
+
+          if (DiskIoCacheLookup (Cache, AheadLba) == NULL) {
+            if (EFI_ERROR (DiskIoCacheFill (Instance, MediaId, AheadLba, &AheadLine))) {
+              break;
+            }
+
+            Cache->ReadAheads++;
+          }
+
+          AheadLba += Cache->LineBlocks;
+        }
+      }
+
+      Cache->NextLba = AheadLba;
+      ReadAhead      = FALSE;
+    }
+
+    RemoveEntryList (&Line->Link);
+    InsertHeadList (&Cache->LruList, &Line->Link);
+
+    OffsetInLine = (UINTN)(Lba - LineLba) * Cache->BlockSize + Remainder;
+    Length       = MIN (BufferSize, Line->Blocks * Cache->BlockSize - OffsetInLine);
+    CopyMem (Buffer, Line->Data + OffsetInLine, Length);
+    Buffer     += Length;
+    BufferSize -= Length;
+    Offset     += Length;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Update the cached blocks overlapping the bytes written to the disk.
+
+  @param Instance     Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Offset       The starting byte offset on the disk written to.
+  @param BufferSize   The size in bytes of Buffer.
+  @param Buffer       A pointer to the data written.
+**/
+VOID
+DiskIoCacheWrite (
+  IN DISK_IO_PRIVATE_DATA  *Instance,
+  IN UINT64                Offset,
+  IN UINTN                 BufferSize,
+  IN UINT8                 *Buffer
+  )
+{
+  DISK_IO_CACHE       *Cache;
+  DISK_IO_CACHE_LINE  *Line;
+  LIST_ENTRY          *Link;
+  UINT64              LineStart;
+  UINT64              Start;
+  UINT64              End;
+
+  Cache = &Instance->Cache;
+  if ((Cache->LineNum == 0) || !DiskIoCacheCheckMedia (Instance)) {
+    return;
+  }
+
+  for (Link = GetFirstNode (&Cache->LruList); !IsNull (&Cache->LruList, Link); Link = GetNextNode (&Cache->LruList, Link)) {
+    Line = BASE_CR (Link, DISK_IO_CACHE_LINE, Link);
+    if (Line->Blocks == 0) {
+      break;
+    }
+
+    LineStart = MultU64x32 (Line->Lba, Cache->BlockSize);
+    Start     = MAX (Offset, LineStart);
+    End       = MIN (Offset + BufferSize, LineStart + MultU64x32 (Line->Blocks, Cache->BlockSize));
+    if (Start < End) {
+      CopyMem (Line->Data + (UINTN)(Start - LineStart), Buffer + (UINTN)(Start - Offset), (UINTN)(End - Start));
+    }
+  }
+}
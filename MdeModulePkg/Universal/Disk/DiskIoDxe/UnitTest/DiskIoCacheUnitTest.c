@@ -0,0 +1,527 @@
+/** @file
+  Host based unit tests of the block cache of the DiskIo driver.
+
+  The cache reads a RAM disk through a fake Block IO protocol counting the
+  reads of the disk. The tests check that the data read through the cache is
+  the data of the disk after reads, writes and media changes, and compare the
+  number of reads of the disk with and without the cache for the same reads.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "DiskIo.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "DiskIo Cache Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define CACHE_TEST_BLOCK_SIZE  512
+#define CACHE_TEST_DISK_SIZE   SIZE_8MB
+#define CACHE_TEST_LINE_NUM    16
+
+EFI_BLOCK_IO_MEDIA     mCacheTestMedia;
+EFI_BLOCK_IO_PROTOCOL  mCacheTestBlockIo;
+DISK_IO_PRIVATE_DATA   mCacheTestInstance;
+UINT8                  *mCacheTestDisk;
+UINT8                  *mCacheTestBuffer;
+UINTN                  mCacheTestDiskReads;
+UINT64                 mCacheTestSeed;
+
+/**
+  Return a pseudo random number.
+
+  @return The next number of the sequence.
+**/
+UINT32
+CacheTestRandom (
+  VOID
+  )
+{
+  mCacheTestSeed = mCacheTestSeed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (UINT32)RShiftU64 (mCacheTestSeed, 33);
+}
+
+/**
+  Read blocks of the RAM disk.
+
+  @param This         Indicates a pointer to the calling context.
+  @param MediaId      Id of the media, changes every time the media is replaced.
+  @param Lba          The starting Logical Block Address to read from.
+  @param BufferSize   Size of Buffer, must be a multiple of device block size.
+  @param Buffer       A pointer to the destination buffer for the data.
+
+  @retval EFI_SUCCESS           The data was read correctly from the device.
+  @retval EFI_MEDIA_CHANGED     The MediaId does not match the current device.
+  @retval EFI_INVALID_PARAMETER The read request is beyond the end of the disk.
+**/
+EFI_STATUS
+EFIAPI
+CacheTestReadBlocks (
+  IN  EFI_BLOCK_IO_PROTOCOL  *This,
+  IN  UINT32                 MediaId,
+  IN  EFI_LBA                Lba,
+  IN  UINTN                  BufferSize,
+  OUT VOID                   *Buffer
+  )
+{
+  if (MediaId != mCacheTestMedia.MediaId) {
+    return EFI_MEDIA_CHANGED;
+  }
+
+  if ((BufferSize % CACHE_TEST_BLOCK_SIZE != 0) || (Lba * CACHE_TEST_BLOCK_SIZE + BufferSize > CACHE_TEST_DISK_SIZE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  mCacheTestDiskReads++;
+  CopyMem (Buffer, mCacheTestDisk + Lba * CACHE_TEST_BLOCK_SIZE, BufferSize);
+  return EFI_SUCCESS;
+}
+
+/**
+  Read bytes of the disk as DiskIo does: through the cache, or from the disk
+  when the cache doesn't take the request.
+
+  @param Offset       The starting byte offset on the disk to read from.
+  @param BufferSize   The size in bytes of the read.
+
+  @retval EFI_SUCCESS The bytes are read into mCacheTestBuffer.
+  @retval others      The read failed.
+**/
+EFI_STATUS
+CacheTestRead (
+  IN UINT64  Offset,
+  IN UINTN   BufferSize
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = DiskIoCacheRead (&mCacheTestInstance, mCacheTestMedia.MediaId, Offset, BufferSize, mCacheTestBuffer);
+  if (Status == EFI_UNSUPPORTED) {
+    mCacheTestDiskReads++;
+    CopyMem (mCacheTestBuffer, mCacheTestDisk + Offset, BufferSize);
+    Status = EFI_SUCCESS;
+  }
+
+  return Status;
+}
+
+/**
+  Write bytes of the disk as DiskIo does: to the disk, then to the cache.
+
+  @param Offset       The starting byte offset on the disk to write to.
+  @param BufferSize   The size in bytes of the write.
+  @param Value        The value of the bytes written.
+**/
+VOID
+CacheTestWrite (
+  IN UINT64  Offset,
+  IN UINTN   BufferSize,
+  IN UINT8   Value
+  )
+{
+  SetMem (mCacheTestBuffer, BufferSize, Value);
+  CopyMem (mCacheTestDisk + Offset, mCacheTestBuffer, BufferSize);
+  DiskIoCacheWrite (&mCacheTestInstance, Offset, BufferSize, mCacheTestBuffer);
+}
+
+/**
+  Create the RAM disk and the cache.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED                The Unit test setup is completed.
+  @retval  UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  The cache could not be created.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CacheTestSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  mCacheTestDisk   = AllocatePool (CACHE_TEST_DISK_SIZE);
+  mCacheTestBuffer = AllocatePool (DISK_IO_CACHE_BYPASS_LINES * DISK_IO_CACHE_LINE_SIZE * 2);
+  if ((mCacheTestDisk == NULL) || (mCacheTestBuffer == NULL)) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  mCacheTestSeed = 1;
+  for (Index = 0; Index < CACHE_TEST_DISK_SIZE; Index++) {
+    mCacheTestDisk[Index] = (UINT8)CacheTestRandom ();
+  }
+
+  ZeroMem (&mCacheTestMedia, sizeof (mCacheTestMedia));
+  mCacheTestMedia.MediaId      = 1;
+  mCacheTestMedia.MediaPresent = TRUE;
+  mCacheTestMedia.BlockSize    = CACHE_TEST_BLOCK_SIZE;
+  mCacheTestMedia.IoAlign      = 0;
+  mCacheTestMedia.LastBlock    = CACHE_TEST_DISK_SIZE / CACHE_TEST_BLOCK_SIZE - 1;
+
+  ZeroMem (&mCacheTestBlockIo, sizeof (mCacheTestBlockIo));
+  mCacheTestBlockIo.Media      = &mCacheTestMedia;
+  mCacheTestBlockIo.ReadBlocks = CacheTestReadBlocks;
+
+  ZeroMem (&mCacheTestInstance, sizeof (mCacheTestInstance));
+  mCacheTestInstance.Signature = DISK_IO_PRIVATE_DATA_SIGNATURE;
+  mCacheTestInstance.BlockIo   = &mCacheTestBlockIo;
+  if (EFI_ERROR (DiskIoCacheInitialize (&mCacheTestInstance, CACHE_TEST_LINE_NUM))) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  mCacheTestDiskReads = 0;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free the RAM disk and the cache.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+**/
+VOID
+EFIAPI
+CacheTestCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  DiskIoCacheFree (&mCacheTestInstance);
+  if (mCacheTestDisk != NULL) {
+    FreePool (mCacheTestDisk);
+    mCacheTestDisk = NULL;
+  }
+
+  if (mCacheTestBuffer != NULL) {
+    FreePool (mCacheTestBuffer);
+    mCacheTestBuffer = NULL;
+  }
+}
+
+/**
+  Random reads through the cache return the data of the disk.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CacheTestRandomRead (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINT64      Offset;
+  UINTN       Size;
+
+  for (Index = 0; Index < 5000; Index++) {
+    Size   = CacheTestRandom () % (DISK_IO_CACHE_BYPASS_LINES * DISK_IO_CACHE_LINE_SIZE) + 1;
+    Offset = CacheTestRandom () % (CACHE_TEST_DISK_SIZE - Size + 1);
+    if (Index % 2 == 0) {
+      //
+      // Read from the first megabyte half of the time, so that some reads hit.
+      //
+      Size   = MIN (Size, SIZE_4KB);
+      Offset = Offset % (SIZE_1MB - Size);
+    }
+
+    Status = DiskIoCacheRead (&mCacheTestInstance, mCacheTestMedia.MediaId, Offset, Size, mCacheTestBuffer);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_MEM_EQUAL (mCacheTestBuffer, mCacheTestDisk + Offset, Size);
+  }
+
+  UT_ASSERT_NOT_EQUAL (mCacheTestInstance.Cache.Hits, 0);
+  UT_ASSERT_NOT_EQUAL (mCacheTestInstance.Cache.Misses, 0);
+
+  //
+  // The cache doesn't take the reads beyond the end of the disk, nor the long reads.
+  //
+  Status = DiskIoCacheRead (&mCacheTestInstance, mCacheTestMedia.MediaId, CACHE_TEST_DISK_SIZE - 1, 2, mCacheTestBuffer);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_UNSUPPORTED);
+  Status = DiskIoCacheRead (&mCacheTestInstance, mCacheTestMedia.MediaId, 0, DISK_IO_CACHE_BYPASS_LINES * DISK_IO_CACHE_LINE_SIZE + 1, mCacheTestBuffer);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_UNSUPPORTED);
+  Status = DiskIoCacheRead (&mCacheTestInstance, mCacheTestMedia.MediaId, 0, 0, mCacheTestBuffer);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_UNSUPPORTED);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Reading the same blocks again doesn't read the disk, and the sequential
+  reads read the next lines ahead.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CacheTestHitAndReadAhead (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  DISK_IO_CACHE  *Cache;
+  UINT64         Offset;
+
+  Cache = &mCacheTestInstance.Cache;
+
+  UT_ASSERT_NOT_EFI_ERROR (CacheTestRead (SIZE_4MB + 100, 1000));
+  UT_ASSERT_EQUAL (mCacheTestDiskReads, 1);
+  UT_ASSERT_NOT_EFI_ERROR (CacheTestRead (SIZE_4MB, CACHE_TEST_BLOCK_SIZE));
+  UT_ASSERT_NOT_EFI_ERROR (CacheTestRead (SIZE_4MB + DISK_IO_CACHE_LINE_SIZE - 10, 10));
+  UT_ASSERT_EQUAL (mCacheTestDiskReads, 1);
+  UT_ASSERT_EQUAL (Cache->Hits, 2);
+  UT_ASSERT_EQUAL (Cache->Misses, 1);
+  UT_ASSERT_MEM_EQUAL (mCacheTestBuffer, mCacheTestDisk + SIZE_4MB + DISK_IO_CACHE_LINE_SIZE - 10, 10);
+
+  //
+  // The second line read in sequence starts the read-ahead.
+  //
+  for (Offset = SIZE_4MB; Offset < SIZE_4MB + SIZE_1MB; Offset += SIZE_4KB) {
+    UT_ASSERT_NOT_EFI_ERROR (CacheTestRead (Offset, SIZE_4KB));
+    UT_ASSERT_MEM_EQUAL (mCacheTestBuffer, mCacheTestDisk + Offset, SIZE_4KB);
+  }
+
+  UT_ASSERT_EQUAL (mCacheTestDiskReads, SIZE_1MB / DISK_IO_CACHE_LINE_SIZE);
+  UT_ASSERT_TRUE (Cache->ReadAheads >= SIZE_1MB / DISK_IO_CACHE_LINE_SIZE / 2);
+  UT_ASSERT_TRUE (Cache->Misses < SIZE_1MB / DISK_IO_CACHE_LINE_SIZE / 2);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The cache follows the writes, the invalidations and the media changes.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CacheTestCoherency (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINT64      Offset;
+  UINTN       Size;
+
+  //
+  // Mix random reads and writes around the end of the disk.
+  //
+  for (Index = 0; Index < 5000; Index++) {
+    Size   = CacheTestRandom () % (2 * DISK_IO_CACHE_LINE_SIZE) + 1;
+    Offset = CACHE_TEST_DISK_SIZE - SIZE_1MB + CacheTestRandom () % (SIZE_1MB - Size + 1);
+    if (CacheTestRandom () % 4 == 0) {
+      CacheTestWrite (Offset, Size, (UINT8)Index);
+    } else {
+      UT_ASSERT_NOT_EFI_ERROR (CacheTestRead (Offset, Size));
+      UT_ASSERT_MEM_EQUAL (mCacheTestBuffer, mCacheTestDisk + Offset, Size);
+    }
+  }
+
+  //
+  // The blocks changed behind the cache are read again once invalidated.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (CacheTestRead (SIZE_1MB, SIZE_4KB));
+  SetMem (mCacheTestDisk + SIZE_1MB + 1000, 10, 0x5A);
+  DiskIoCacheInvalidate (&mCacheTestInstance, SIZE_1MB + 1000, 10);
+  UT_ASSERT_NOT_EFI_ERROR (CacheTestRead (SIZE_1MB, SIZE_4KB));
+  UT_ASSERT_MEM_EQUAL (mCacheTestBuffer, mCacheTestDisk + SIZE_1MB, SIZE_4KB);
+
+  //
+  // A new media drops the whole cache. The reads with the old media ID fail.
+  //
+  SetMem (mCacheTestDisk + SIZE_1MB, SIZE_4KB, 0xA5);
+  mCacheTestMedia.MediaId++;
+  Status = DiskIoCacheRead (&mCacheTestInstance, mCacheTestMedia.MediaId - 1, SIZE_1MB, SIZE_4KB, mCacheTestBuffer);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_UNSUPPORTED);
+  UT_ASSERT_NOT_EFI_ERROR (CacheTestRead (SIZE_1MB, SIZE_4KB));
+  UT_ASSERT_MEM_EQUAL (mCacheTestBuffer, mCacheTestDisk + SIZE_1MB, SIZE_4KB);
+
+  //
+  // Nothing goes through the cache without media.
+  //
+  mCacheTestMedia.MediaPresent = FALSE;
+  Status                       = DiskIoCacheRead (&mCacheTestInstance, mCacheTestMedia.MediaId, SIZE_1MB, SIZE_4KB, mCacheTestBuffer);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_UNSUPPORTED);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Compare the reads of the disk with and without the cache for the reads of a
+  file system: the metadata at the start of the disk is read again and again,
+  between the sequential reads of the files.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CacheTestBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN   File;
+  UINTN   Index;
+  UINT64  Offset;
+  UINTN   Reads;
+
+  Reads = 0;
+  for (File = 0; File < 32; File++) {
+    for (Index = 0; Index < 32; Index++) {
+      Offset = (CacheTestRandom () % (SIZE_128KB / CACHE_TEST_BLOCK_SIZE)) * CACHE_TEST_BLOCK_SIZE;
+      UT_ASSERT_NOT_EFI_ERROR (CacheTestRead (Offset, CACHE_TEST_BLOCK_SIZE));
+      Reads++;
+    }
+
+    for (Offset = SIZE_1MB + File * SIZE_128KB; Offset < SIZE_1MB + (File + 1) * SIZE_128KB; Offset += SIZE_4KB) {
+      UT_ASSERT_NOT_EFI_ERROR (CacheTestRead (Offset, SIZE_4KB));
+      Reads++;
+    }
+  }
+
+  UT_LOG_INFO (
+    "%d reads: %d reads of the disk without the cache, %d with the cache (hits = %ld, misses = %ld, read-aheads = %ld)\n",
+    Reads,
+    Reads,
+    mCacheTestDiskReads,
+    mCacheTestInstance.Cache.Hits,
+    mCacheTestInstance.Cache.Misses,
+    mCacheTestInstance.Cache.ReadAheads
+    );
+  UT_ASSERT_TRUE (mCacheTestDiskReads * 10 < Reads);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the block
+  cache and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      CacheTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&CacheTests, Framework, "DiskIo Cache Tests", "DiskIo.Cache", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DiskIo Cache Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (CacheTests, "Random reads return the data of the disk", "RandomRead", CacheTestRandomRead, CacheTestSetup, CacheTestCleanup, NULL);
+  AddTestCase (CacheTests, "Repeated reads hit and sequential reads read ahead", "HitAndReadAhead", CacheTestHitAndReadAhead, CacheTestSetup, CacheTestCleanup, NULL);
+  AddTestCase (CacheTests, "The cache follows writes and media changes", "Coherency", CacheTestCoherency, CacheTestSetup, CacheTestCleanup, NULL);
+  AddTestCase (CacheTests, "Reads of the disk with and without the cache", "Benchmark", CacheTestBenchmark, CacheTestSetup, CacheTestCleanup, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define DiskIoCacheUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+DiskIoCacheUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -119,6 +119,7 @@ FtwAllocate (
     }
 
     FtwHeader = FtwDevice->FtwLastWriteHeader;
+    Offset    = (UINT8 *)FtwHeader - (UINT8 *)FtwDevice->FtwWorkSpace;
   }
 
   //
@@ -638,6 +639,523 @@ FtwWrite (
   return EFI_SUCCESS;
 }
 
+/**
+  Reads the whole spare area into a buffer.
+
+  @param FtwDevice       The private data of FTW driver.
+  @param Buffer          The buffer of SpareAreaLength bytes.
+
+  @retval EFI_SUCCESS    The spare area has been read.
+  @retval others         The spare area could not be read.
+
+**/
+EFI_STATUS
+FtwReadSpareArea (
+  IN  EFI_FTW_DEVICE  *FtwDevice,
+  OUT UINT8           *Buffer
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINTN       Length;
+
+  for (Index = 0; Index < FtwDevice->NumberOfSpareBlock; Index += 1) {
+    Length = FtwDevice->SpareBlockSize;
+    Status = FtwDevice->FtwBackupFvb->Read (
+                                        FtwDevice->FtwBackupFvb,
+                                        FtwDevice->FtwSpareLba + Index,
+                                        0,
+                                        &Length,
+                                        Buffer
+                                        );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Buffer += Length;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Erases the spare area and writes a buffer at its start.
+
+  @param FtwDevice       The private data of FTW driver.
+  @param Buffer          The data to write.
+  @param Size            The size of Buffer, no larger than SpareAreaLength.
+
+  @retval EFI_SUCCESS    The spare area has been written.
+  @retval others         The spare area could not be erased or written.
+
+**/
+EFI_STATUS
+FtwWriteSpareArea (
+  IN EFI_FTW_DEVICE  *FtwDevice,
+  IN UINT8           *Buffer,
+  IN UINTN           Size
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINTN       Length;
+
+  Status = FtwEraseSpareBlock (FtwDevice);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Index = 0; Size > 0; Index += 1) {
+    Length = MIN (Size, FtwDevice->SpareBlockSize);
+    Status = FtwDevice->FtwBackupFvb->Write (
+                                        FtwDevice->FtwBackupFvb,
+                                        FtwDevice->FtwSpareLba + Index,
+                                        0,
+                                        &Length,
+                                        Buffer
+                                        );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Buffer += Length;
+    Size   -= Length;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Splits the writes of a batch into groups of at most GroupBlocks blocks.
+
+  The writes are taken in the order of their start. A write that does not
+  fit in the group of the previous ones starts a new group at its first block.
+
+  @param Writes          The writes of the batch.
+  @param NumberOfWrites  The number of writes, not 0.
+  @param BlockSize       The size of the blocks of the target FVB.
+  @param GroupBlocks     The maximum number of blocks of a group.
+  @param Order           A buffer of NumberOfWrites UINTNs used for sorting.
+  @param Groups          A buffer of NumberOfWrites groups, returns the groups.
+  @param NumberOfGroups  Returns the number of groups.
+
+  @retval EFI_SUCCESS          The groups have been returned.
+  @retval EFI_BAD_BUFFER_SIZE  A write does not fit within GroupBlocks blocks.
+
+**/
+EFI_STATUS
+FtwGetBatchGroups (
+  IN  EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY  *Writes,
+  IN  UINTN                                   NumberOfWrites,
+  IN  UINTN                                   BlockSize,
+  IN  UINTN                                   GroupBlocks,
+  OUT UINTN                                   *Order,
+  OUT FTW_BATCH_GROUP                         *Groups,
+  OUT UINTN                                   *NumberOfGroups
+  )
+{
+  UINTN                                   Index;
+  UINTN                                   Position;
+  UINTN                                   Count;
+  EFI_LBA                                 StartLba;
+  UINTN                                   StartOffset;
+  UINTN                                   End;
+  EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY  *Write;
+  FTW_BATCH_GROUP                         *Group;
+
+  //
+  // Sort the writes by their first block, then by their offset in that block.
+  //
+  for (Index = 0; Index < NumberOfWrites; Index++) {
+    Write = &Writes[Index];
+    if (Write->Length > GroupBlocks * BlockSize) {
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
+    StartLba    = Write->Lba + Write->Offset / BlockSize;
+    StartOffset = Write->Offset % BlockSize;
+    if (FTW_BLOCKS (StartOffset + Write->Length, BlockSize) > GroupBlocks) {
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
+    for (Position = Index; Position > 0; Position--) {
+      Write = &Writes[Order[Position - 1]];
+      if ((Write->Lba + Write->Offset / BlockSize < StartLba) ||
+          ((Write->Lba + Write->Offset / BlockSize == StartLba) && (Write->Offset % BlockSize <= StartOffset)))
+      {
+        break;
+      }
+
+      Order[Position] = Order[Position - 1];
+    }
+
+    Order[Position] = Index;
+  }
+
+  Count = 0;
+  Group = NULL;
+  for (Index = 0; Index < NumberOfWrites; Index++) {
+    Write       = &Writes[Order[Index]];
+    StartLba    = Write->Lba + Write->Offset / BlockSize;
+    StartOffset = Write->Offset % BlockSize;
+    if (Write->Length == 0) {
+      continue;
+    }
+
+    if ((Group == NULL) ||
+        (FTW_BLOCKS ((UINTN)(StartLba - Group->Lba) * BlockSize + StartOffset + Write->Length, BlockSize) > GroupBlocks))
+    {
+      Group         = &Groups[Count++];
+      Group->Lba    = StartLba;
+      Group->Offset = StartOffset;
+      Group->Length = Write->Length;
+      continue;
+    }
+
+    End           = (UINTN)(StartLba - Group->Lba) * BlockSize + StartOffset + Write->Length;
+    Group->Length = MAX (Group->Length, End - Group->Offset);
+  }
+
+  *NumberOfGroups = Count;
+  return EFI_SUCCESS;
+}
+
+/**
+  Copies into the image of a group the data of all the writes of a batch
+  that overlap the blocks of the group, in the order of the batch.
+
+  @param Writes          The writes of the batch.
+  @param NumberOfWrites  The number of writes.
+  @param BlockSize       The size of the blocks of the target FVB.
+  @param Lba             The first block of the group.
+  @param NumberOfBlocks  The number of blocks of the group.
+  @param Image           The content of the blocks of the group.
+
+**/
+VOID
+FtwApplyBatchWrites (
+  IN     EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY  *Writes,
+  IN     UINTN                                   NumberOfWrites,
+  IN     UINTN                                   BlockSize,
+  IN     EFI_LBA                                 Lba,
+  IN     UINTN                                   NumberOfBlocks,
+  IN OUT UINT8                                   *Image
+  )
+{
+  UINTN                                   Index;
+  EFI_LBA                                 StartLba;
+  UINTN                                   StartOffset;
+  UINTN                                   Skip;
+  UINTN                                   Destination;
+  EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY  *Write;
+
+  for (Index = 0; Index < NumberOfWrites; Index++) {
+    Write = &Writes[Index];
+    if (Write->Length == 0) {
+      continue;
+    }
+
+    StartLba    = Write->Lba + Write->Offset / BlockSize;
+    StartOffset = Write->Offset % BlockSize;
+    if ((StartLba >= Lba + NumberOfBlocks) ||
+        (StartLba + FTW_BLOCKS (StartOffset + Write->Length, BlockSize) <= Lba))
+    {
+      continue;
+    }
+
+    if (StartLba < Lba) {
+      Skip        = (UINTN)(Lba - StartLba) * BlockSize - StartOffset;
+      Destination = 0;
+    } else {
+      Skip        = 0;
+      Destination = (UINTN)(StartLba - Lba) * BlockSize + StartOffset;
+    }
+
+    CopyMem (
+      Image + Destination,
+      (UINT8 *)Write->Buffer + Skip,
+      MIN (Write->Length - Skip, NumberOfBlocks * BlockSize - Destination)
+      );
+  }
+}
+
+/**
+  Writes a set of ranges of a firmware volume in a fault tolerant manner.
+
+  The writes that fall in the same group of blocks are merged and committed
+  with one spare block update and one write record, and the content of the
+  spare block is saved and restored once for the whole batch.
+
+  @param This            The pointer to this protocol instance.
+  @param CallerId        The GUID recorded in the write header of the batch.
+  @param FvBlockHandle   The handle of FVB protocol that provides services for
+                         reading, writing, and erasing the target blocks.
+  @param NumberOfWrites  The number of entries in Writes.
+  @param Writes          The writes to do, applied in order.
+
+  @retval EFI_SUCCESS           All the writes completed successfully.
+  @retval EFI_INVALID_PARAMETER CallerId or Writes is NULL, or a Buffer is NULL.
+  @retval EFI_BAD_BUFFER_SIZE   A write does not fit within the spare area.
+  @retval EFI_BUFFER_TOO_SMALL  The work space cannot record all the groups.
+  @retval EFI_UNSUPPORTED       The target blocks are the boot block.
+  @retval EFI_ACCESS_DENIED     A previous write has not been completed.
+  @retval EFI_NOT_FOUND         Cannot find FVB protocol by handle.
+  @retval EFI_OUT_OF_RESOURCES  Cannot allocate enough memory resource.
+  @retval EFI_ABORTED           The function could not complete successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+FtwWriteBatch (
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL  *This,
+  IN EFI_GUID                                   *CallerId,
+  IN EFI_HANDLE                                 FvBlockHandle,
+  IN UINTN                                      NumberOfWrites,
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY     *Writes
+  )
+{
+  EFI_STATUS                          Status;
+  EFI_FTW_DEVICE                      *FtwDevice;
+  EFI_FAULT_TOLERANT_WRITE_RECORD     *Record;
+  EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *Fvb;
+  EFI_PHYSICAL_ADDRESS                FvbPhysicalAddress;
+  UINTN                               BlockSize;
+  UINTN                               NumberOfBlocks;
+  UINTN                               NumberOfWriteBlocks;
+  UINTN                               *Order;
+  FTW_BATCH_GROUP                     *Groups;
+  UINTN                               NumberOfGroups;
+  UINTN                               GroupIndex;
+  UINTN                               Index;
+  UINT8                               *MyBuffer;
+  UINT8                               *SpareBuffer;
+  UINT8                               *Ptr;
+  UINTN                               MyLength;
+  UINTN                               MyOffset;
+  BOOLEAN                             SpareModified;
+
+  FtwDevice = FTW_CONTEXT_FROM_BATCH_THIS (This);
+
+  if ((CallerId == NULL) || ((Writes == NULL) && (NumberOfWrites != 0))) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (Index = 0; Index < NumberOfWrites; Index++) {
+    if ((Writes[Index].Buffer == NULL) && (Writes[Index].Length != 0)) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  if (NumberOfWrites == 0) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Get the FVB protocol by handle
+  //
+  Status = FtwGetFvbByHandle (FvBlockHandle, &Fvb);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = Fvb->GetPhysicalAddress (Fvb, &FvbPhysicalAddress);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Ftw: WriteBatch(), Get FVB physical address - %r\n", Status));
+    return EFI_ABORTED;
+  }
+
+  Status = Fvb->GetBlockSize (Fvb, 0, &BlockSize, &NumberOfBlocks);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Ftw: WriteBatch(), Get block size - %r\n", Status));
+    return EFI_ABORTED;
+  }
+
+  //
+  // The boot block is swapped as a whole with the spare block, so its
+  // updates cannot be merged. Use the Write() service for them.
+  //
+  if (IsBootBlock (FtwDevice, Fvb)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (FtwDevice->SpareAreaLength < BlockSize) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  SpareModified = FALSE;
+  Order         = AllocatePool (NumberOfWrites * sizeof (UINTN));
+  Groups        = AllocatePool (NumberOfWrites * sizeof (FTW_BATCH_GROUP));
+  MyBuffer      = AllocatePool (FtwDevice->SpareAreaLength);
+  SpareBuffer   = AllocatePool (FtwDevice->SpareAreaLength);
+  if ((Order == NULL) || (Groups == NULL) || (MyBuffer == NULL) || (SpareBuffer == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  Status = FtwGetBatchGroups (
+             Writes,
+             NumberOfWrites,
+             BlockSize,
+             FtwDevice->SpareAreaLength / BlockSize,
+             Order,
+             Groups,
+             &NumberOfGroups
+             );
+  if (EFI_ERROR (Status) || (NumberOfGroups == 0)) {
+    goto Done;
+  }
+
+  //
+  // Allocate one write header with a record per group. The private data of
+  // the records is empty, a group is recovered from the spare block alone.
+  //
+  Status = FtwAllocate (&FtwDevice->FtwInstance, CallerId, 0, NumberOfGroups);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  //
+  // Try to keep the content of spare block, it is restored once all the
+  // groups have been written.
+  //
+  Status = FtwReadSpareArea (FtwDevice, SpareBuffer);
+  if (EFI_ERROR (Status)) {
+    Status = EFI_ABORTED;
+    goto Abort;
+  }
+
+  for (GroupIndex = 0; GroupIndex < NumberOfGroups; GroupIndex++) {
+    Status = WorkSpaceRefresh (FtwDevice);
+    if (EFI_ERROR (Status)) {
+      Status = EFI_ABORTED;
+      goto Abort;
+    }
+
+    Record              = FtwDevice->FtwLastWriteRecord;
+    NumberOfWriteBlocks = FTW_BLOCKS (Groups[GroupIndex].Offset + Groups[GroupIndex].Length, BlockSize);
+
+    //
+    // Write the record to the work space.
+    //
+    Record->Lba            = Groups[GroupIndex].Lba;
+    Record->Offset         = Groups[GroupIndex].Offset;
+    Record->Length         = Groups[GroupIndex].Length;
+    Record->RelativeOffset = (INT64)(FvbPhysicalAddress + (UINTN)Record->Lba * BlockSize) - (INT64)FtwDevice->SpareAreaAddress;
+
+    MyOffset = (UINT8 *)Record - FtwDevice->FtwWorkSpace;
+    Status   = WriteWorkSpaceData (
+                 FtwDevice->FtwFvBlock,
+                 FtwDevice->WorkBlockSize,
+                 FtwDevice->FtwWorkSpaceLba,
+                 FtwDevice->FtwWorkSpaceBase + MyOffset,
+                 FTW_RECORD_SIZE (0),
+                 (UINT8 *)Record
+                 );
+    if (EFI_ERROR (Status)) {
+      Status = EFI_ABORTED;
+      goto Abort;
+    }
+
+    //
+    // Read the original data of the target blocks, then merge all the
+    // writes of the batch that overlap them.
+    //
+    Ptr = MyBuffer;
+    for (Index = 0; Index < NumberOfWriteBlocks; Index += 1) {
+      MyLength = BlockSize;
+      Status   = Fvb->Read (Fvb, Record->Lba + Index, 0, &MyLength, Ptr);
+      if (EFI_ERROR (Status)) {
+        Status = EFI_ABORTED;
+        goto Abort;
+      }
+
+      Ptr += MyLength;
+    }
+
+    FtwApplyBatchWrites (Writes, NumberOfWrites, BlockSize, Record->Lba, NumberOfWriteBlocks, MyBuffer);
+
+    SpareModified = TRUE;
+    Status        = FtwWriteSpareArea (FtwDevice, MyBuffer, NumberOfWriteBlocks * BlockSize);
+    if (EFI_ERROR (Status)) {
+      Status = EFI_ABORTED;
+      goto Abort;
+    }
+
+    //
+    // Set the SpareComplete in the FTW record,
+    //
+    Status = FtwUpdateFvState (
+               FtwDevice->FtwFvBlock,
+               FtwDevice->WorkBlockSize,
+               FtwDevice->FtwWorkSpaceLba,
+               FtwDevice->FtwWorkSpaceBase + MyOffset,
+               SPARE_COMPLETED
+               );
+    if (EFI_ERROR (Status)) {
+      Status = EFI_ABORTED;
+      goto Abort;
+    }
+
+    Record->SpareComplete = FTW_VALID_STATE;
+
+    //
+    // From now on the group is recovered from the spare block if the write
+    // is interrupted, so the batch must not be aborted.
+    //
+    Status = FtwWriteRecord (&FtwDevice->FtwInstance, Fvb, BlockSize);
+    if (EFI_ERROR (Status)) {
+      Status = EFI_ABORTED;
+      goto Done;
+    }
+  }
+
+  //
+  // Restore spare backup buffer into spare block, if no failure happened.
+  //
+  Status = FtwWriteSpareArea (FtwDevice, SpareBuffer, FtwDevice->SpareAreaLength);
+  if (EFI_ERROR (Status)) {
+    Status = EFI_ABORTED;
+    goto Done;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Ftw: WriteBatch() success, %Lu writes in %Lu records\n",
+    (UINT64)NumberOfWrites,
+    (UINT64)NumberOfGroups
+    ));
+  goto Done;
+
+Abort:
+  //
+  // The record of the current group is not complete on the spare block,
+  // abort the rest of the batch.
+  //
+  FtwAbort (&FtwDevice->FtwInstance);
+  if (SpareModified) {
+    FtwWriteSpareArea (FtwDevice, SpareBuffer, FtwDevice->SpareAreaLength);
+  }
+
+Done:
+  if (Order != NULL) {
+    FreePool (Order);
+  }
+
+  if (Groups != NULL) {
+    FreePool (Groups);
+  }
+
+  if (MyBuffer != NULL) {
+    FreePool (MyBuffer);
+  }
+
+  if (SpareBuffer != NULL) {
+    FreePool (SpareBuffer);
+  }
+
+  return Status;
+}
+
 /**
   Restarts a previously interrupted write. The caller must provide the
   block protocol needed to complete the interrupted write.
@@ -16,6 +16,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/SystemNvDataGuid.h>
 #include <Guid/ZeroGuid.h>
 #include <Protocol/FaultTolerantWrite.h>
+#include <Protocol/FaultTolerantWriteBatch.h>
 #include <Protocol/FirmwareVolumeBlock.h>
 #include <Protocol/SwapAddressRange.h>
 
@@ -56,6 +57,7 @@ typedef struct {
   UINTN                                      Signature;
   EFI_HANDLE                                 Handle;
   EFI_FAULT_TOLERANT_WRITE_PROTOCOL          FtwInstance;
+  EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL  FtwBatchInstance;
   EFI_PHYSICAL_ADDRESS                       WorkSpaceAddress;        // Base address of working space range in flash.
   EFI_PHYSICAL_ADDRESS                       SpareAreaAddress;        // Base address of spare range in flash.
   UINTN                                      WorkSpaceLength;         // Size of working space range in flash.
@@ -84,7 +86,17 @@ typedef struct {
   //
 } EFI_FTW_DEVICE;
 
-#define FTW_CONTEXT_FROM_THIS(a)  CR (a, EFI_FTW_DEVICE, FtwInstance, FTW_DEVICE_SIGNATURE)
+#define FTW_CONTEXT_FROM_THIS(a)        CR (a, EFI_FTW_DEVICE, FtwInstance, FTW_DEVICE_SIGNATURE)
+#define FTW_CONTEXT_FROM_BATCH_THIS(a)  CR (a, EFI_FTW_DEVICE, FtwBatchInstance, FTW_DEVICE_SIGNATURE)
+
+///
+/// A group of blocks of a batch, committed with one write record.
+///
+typedef struct {
+  EFI_LBA    Lba;      // The first block of the group
+  UINTN      Offset;   // The offset of the first written byte from the start of Lba
+  UINTN      Length;   // The length from the first to the last written byte
+} FTW_BATCH_GROUP;
 
 //
 // Driver entry point
@@ -273,6 +285,92 @@ FtwGetLastWrite (
   OUT BOOLEAN                           *Complete
   );
 
+/**
+  Writes a set of ranges of a firmware volume in a fault tolerant manner.
+
+  The writes that fall in the same group of blocks are merged and committed
+  with one spare block update and one write record, and the content of the
+  spare block is saved and restored once for the whole batch.
+
+  @param This            Calling context.
+  @param CallerId        The GUID recorded in the write header of the batch.
+  @param FvBlockHandle   The handle of FVB protocol that provides services for
+                         reading, writing, and erasing the target blocks.
+  @param NumberOfWrites  The number of entries in Writes.
+  @param Writes          The writes to do, applied in order.
+
+  @retval EFI_SUCCESS           All the writes completed successfully.
+  @retval EFI_INVALID_PARAMETER CallerId or Writes is NULL, or a Buffer is NULL.
+  @retval EFI_BAD_BUFFER_SIZE   A write does not fit within the spare area.
+  @retval EFI_BUFFER_TOO_SMALL  The work space cannot record all the groups.
+  @retval EFI_UNSUPPORTED       The target blocks are the boot block.
+  @retval EFI_ACCESS_DENIED     A previous write has not been completed.
+  @retval EFI_NOT_FOUND         Cannot find FVB protocol by handle.
+  @retval EFI_OUT_OF_RESOURCES  Cannot allocate enough memory resource.
+  @retval EFI_ABORTED           The function could not complete successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+FtwWriteBatch (
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL  *This,
+  IN EFI_GUID                                   *CallerId,
+  IN EFI_HANDLE                                 FvBlockHandle,
+  IN UINTN                                      NumberOfWrites,
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY     *Writes
+  );
+
+/**
+  Splits the writes of a batch into groups of at most GroupBlocks blocks.
+
+  The writes are taken in the order of their start. A write that does not
+  fit in the group of the previous ones starts a new group at its first block.
+
+  @param Writes          The writes of the batch.
+  @param NumberOfWrites  The number of writes, not 0.
+  @param BlockSize       The size of the blocks of the target FVB.
+  @param GroupBlocks     The maximum number of blocks of a group.
+  @param Order           A buffer of NumberOfWrites UINTNs used for sorting.
+  @param Groups          A buffer of NumberOfWrites groups, returns the groups.
+  @param NumberOfGroups  Returns the number of groups.
+
+  @retval EFI_SUCCESS          The groups have been returned.
+  @retval EFI_BAD_BUFFER_SIZE  A write does not fit within GroupBlocks blocks.
+
+**/
+EFI_STATUS
+FtwGetBatchGroups (
+  IN  EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY  *Writes,
+  IN  UINTN                                   NumberOfWrites,
+  IN  UINTN                                   BlockSize,
+  IN  UINTN                                   GroupBlocks,
+  OUT UINTN                                   *Order,
+  OUT FTW_BATCH_GROUP                         *Groups,
+  OUT UINTN                                   *NumberOfGroups
+  );
+
+/**
+  Copies into the image of a group the data of all the writes of a batch
+  that overlap the blocks of the group, in the order of the batch.
+
+  @param Writes          The writes of the batch.
+  @param NumberOfWrites  The number of writes.
+  @param BlockSize       The size of the blocks of the target FVB.
+  @param Lba             The first block of the group.
+  @param NumberOfBlocks  The number of blocks of the group.
+  @param Image           The content of the blocks of the group.
+
+**/
+VOID
+FtwApplyBatchWrites (
+  IN     EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY  *Writes,
+  IN     UINTN                                   NumberOfWrites,
+  IN     UINTN                                   BlockSize,
+  IN     EFI_LBA                                 Lba,
+  IN     UINTN                                   NumberOfBlocks,
+  IN OUT UINT8                                   *Image
+  );
+
 /**
   Erase spare block.
 
@@ -192,6 +192,14 @@ FvbNotificationEvent (
                   );
   ASSERT_EFI_ERROR (Status);
 
+  Status = gBS->InstallProtocolInterface (
+                  &FtwDevice->Handle,
+                  &gEdkiiFaultTolerantWriteBatchProtocolGuid,
+                  EFI_NATIVE_INTERFACE,
+                  &FtwDevice->FtwBatchInstance
+                  );
+  ASSERT_EFI_ERROR (Status);
+
   Status = gBS->CloseEvent (Event);
   ASSERT_EFI_ERROR (Status);
 
@@ -266,6 +266,93 @@ GetFvbByAddressAndAttribute (
   return EFI_ABORTED;
 }
 
+/**
+  Handles the FTW_FUNCTION_WRITE_BATCH function of the SMI handler.
+
+  Caution: This function requires additional review when modified.
+  The sizes of the writes are copied into SMRAM and checked against the
+  communication buffer before FtwWriteBatch () is called.
+
+  @param[in] SmmFtwWriteBatchHeader  The payload of the communication buffer.
+  @param[in] CommBufferPayloadSize   The size of the payload.
+
+  @return The status of FtwWriteBatch (), or EFI_ACCESS_DENIED if the payload
+          is invalid.
+
+**/
+EFI_STATUS
+SmmFtwWriteBatch (
+  IN SMM_FTW_WRITE_BATCH_HEADER  *SmmFtwWriteBatchHeader,
+  IN UINTN                       CommBufferPayloadSize
+  )
+{
+  EFI_STATUS                              Status;
+  SMM_FTW_WRITE_BATCH_ENTRY               *SmmFtwWriteBatchEntry;
+  EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY  *Writes;
+  EFI_HANDLE                              SmmFvbHandle;
+  UINTN                                   NumberOfWrites;
+  UINTN                                   InfoSize;
+  UINTN                                   Length;
+  UINTN                                   Index;
+
+  NumberOfWrites = SmmFtwWriteBatchHeader->NumberOfWrites;
+  InfoSize       = OFFSET_OF (SMM_FTW_WRITE_BATCH_HEADER, Data);
+  if (NumberOfWrites > (CommBufferPayloadSize - InfoSize) / sizeof (SMM_FTW_WRITE_BATCH_ENTRY)) {
+    DEBUG ((DEBUG_ERROR, "WriteBatch: Data size exceed communication buffer size limit!\n"));
+    return EFI_ACCESS_DENIED;
+  }
+
+  if (NumberOfWrites == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Writes = AllocatePool (NumberOfWrites * sizeof (EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY));
+  if (Writes == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  SmmFtwWriteBatchEntry = (SMM_FTW_WRITE_BATCH_ENTRY *)SmmFtwWriteBatchHeader->Data;
+  InfoSize             += NumberOfWrites * sizeof (SMM_FTW_WRITE_BATCH_ENTRY);
+  for (Index = 0; Index < NumberOfWrites; Index++) {
+    Length = SmmFtwWriteBatchEntry[Index].Length;
+    if (Length > CommBufferPayloadSize - InfoSize) {
+      DEBUG ((DEBUG_ERROR, "WriteBatch: Data size exceed communication buffer size limit!\n"));
+      FreePool (Writes);
+      return EFI_ACCESS_DENIED;
+    }
+
+    Writes[Index].Lba    = SmmFtwWriteBatchEntry[Index].Lba;
+    Writes[Index].Offset = SmmFtwWriteBatchEntry[Index].Offset;
+    Writes[Index].Length = Length;
+    Writes[Index].Buffer = (UINT8 *)SmmFtwWriteBatchHeader + InfoSize;
+    InfoSize            += Length;
+  }
+
+  Status = GetFvbByAddressAndAttribute (
+             SmmFtwWriteBatchHeader->FvbBaseAddress,
+             SmmFtwWriteBatchHeader->FvbAttributes,
+             &SmmFvbHandle
+             );
+  if (!EFI_ERROR (Status)) {
+    //
+    // The SpeculationBarrier() call here is to ensure the previous
+    // range/content checks for the CommBuffer have been completed before
+    // calling into FtwWriteBatch().
+    //
+    SpeculationBarrier ();
+    Status = FtwWriteBatch (
+               &mFtwDevice->FtwBatchInstance,
+               &SmmFtwWriteBatchHeader->CallerId,
+               SmmFvbHandle,
+               NumberOfWrites,
+               Writes
+               );
+  }
+
+  FreePool (Writes);
+  return Status;
+}
+
 /**
   Communication service SMI Handler entry.
 
@@ -461,6 +548,18 @@ SmmFaultTolerantWriteHandler (
       Status = FtwAbort (&mFtwDevice->FtwInstance);
       break;
 
+    case FTW_FUNCTION_WRITE_BATCH:
+      if (CommBufferPayloadSize < OFFSET_OF (SMM_FTW_WRITE_BATCH_HEADER, Data)) {
+        DEBUG ((DEBUG_ERROR, "WriteBatch: SMM communication buffer size invalid!\n"));
+        return EFI_SUCCESS;
+      }
+
+      Status = SmmFtwWriteBatch (
+                 (SMM_FTW_WRITE_BATCH_HEADER *)SmmFtwFunctionHeader->Data,
+                 CommBufferPayloadSize
+                 );
+      break;
+
     case FTW_FUNCTION_GET_LAST_WRITE:
       if (CommBufferPayloadSize < OFFSET_OF (SMM_FTW_GET_LAST_WRITE_HEADER, Data)) {
         DEBUG ((DEBUG_ERROR, "GetLastWrite: SMM communication buffer size invalid!\n"));
@@ -564,6 +663,14 @@ FvbNotificationEvent (
                     );
   ASSERT_EFI_ERROR (Status);
 
+  Status = gMmst->MmInstallProtocolInterface (
+                    &mFtwDevice->Handle,
+                    &gEdkiiSmmFaultTolerantWriteBatchProtocolGuid,
+                    EFI_NATIVE_INTERFACE,
+                    &mFtwDevice->FtwBatchInstance
+                    );
+  ASSERT_EFI_ERROR (Status);
+
   ///
   /// Register SMM FTW SMI handler
   ///
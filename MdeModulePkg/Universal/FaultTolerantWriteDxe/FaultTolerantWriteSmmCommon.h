@@ -19,6 +19,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define FTW_FUNCTION_RESTART             4
 #define FTW_FUNCTION_ABORT               5
 #define FTW_FUNCTION_GET_LAST_WRITE      6
+#define FTW_FUNCTION_WRITE_BATCH         7
 
 typedef struct {
   UINTN         Function;
@@ -71,6 +72,24 @@ typedef struct {
   UINT8       Data[1];
 } SMM_FTW_GET_LAST_WRITE_HEADER;
 
+typedef struct {
+  EFI_LBA    Lba;
+  UINTN      Offset;
+  UINTN      Length;
+} SMM_FTW_WRITE_BATCH_ENTRY;
+
+///
+/// Data holds NumberOfWrites SMM_FTW_WRITE_BATCH_ENTRY, followed by the data
+/// of all the writes in the same order.
+///
+typedef struct {
+  EFI_GUID                CallerId;
+  EFI_PHYSICAL_ADDRESS    FvbBaseAddress;
+  EFI_FVB_ATTRIBUTES_2    FvbAttributes;
+  UINTN                   NumberOfWrites;
+  UINT8                   Data[1];
+} SMM_FTW_WRITE_BATCH_HEADER;
+
 /**
   Shared entry point of the module.
 
@@ -23,6 +23,10 @@ EFI_FAULT_TOLERANT_WRITE_PROTOCOL  mFaultTolerantWriteDriver = {
   FtwGetLastWrite
 };
 
+EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL  mFaultTolerantWriteBatchDriver = {
+  FtwWriteBatch
+};
+
 /**
   Initialize the communicate buffer using DataSize and Function number.
 
@@ -472,6 +476,97 @@ FtwGetLastWrite (
   return Status;
 }
 
+/**
+  Writes a set of ranges of a firmware volume in a fault tolerant manner.
+
+  @param[in]  This             The calling context.
+  @param[in]  CallerId         The GUID recorded in the write header of the batch.
+  @param[in]  FvBlockHandle    The handle of FVB protocol that provides services.
+  @param[in]  NumberOfWrites   The number of entries in Writes.
+  @param[in]  Writes           The writes to do, applied in order.
+
+  @retval EFI_SUCCESS          All the writes completed successfully.
+  @retval EFI_INVALID_PARAMETER CallerId or Writes is NULL, or a Buffer is NULL.
+  @retval EFI_BAD_BUFFER_SIZE  The writes do not fit in a communication buffer.
+  @retval EFI_ABORTED          The function could not complete successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+FtwWriteBatch (
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL  *This,
+  IN EFI_GUID                                   *CallerId,
+  IN EFI_HANDLE                                 FvBlockHandle,
+  IN UINTN                                      NumberOfWrites,
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY     *Writes
+  )
+{
+  EFI_STATUS                  Status;
+  UINTN                       PayloadSize;
+  UINTN                       Index;
+  UINT8                       *Data;
+  EFI_MM_COMMUNICATE_HEADER   *SmmCommunicateHeader;
+  SMM_FTW_WRITE_BATCH_HEADER  *SmmFtwWriteBatchHeader;
+  SMM_FTW_WRITE_BATCH_ENTRY   *SmmFtwWriteBatchEntry;
+
+  if ((CallerId == NULL) || ((Writes == NULL) && (NumberOfWrites != 0))) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Initialize the communicate buffer. It holds the size of all the writes,
+  // followed by their data.
+  //
+  if (NumberOfWrites > (MAX_UINTN - OFFSET_OF (SMM_FTW_WRITE_BATCH_HEADER, Data)) / sizeof (SMM_FTW_WRITE_BATCH_ENTRY)) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  PayloadSize = OFFSET_OF (SMM_FTW_WRITE_BATCH_HEADER, Data) + NumberOfWrites * sizeof (SMM_FTW_WRITE_BATCH_ENTRY);
+  for (Index = 0; Index < NumberOfWrites; Index++) {
+    if ((Writes[Index].Buffer == NULL) && (Writes[Index].Length != 0)) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    if (Writes[Index].Length > MAX_UINTN - PayloadSize) {
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
+    PayloadSize += Writes[Index].Length;
+  }
+
+  InitCommunicateBuffer ((VOID **)&SmmCommunicateHeader, (VOID **)&SmmFtwWriteBatchHeader, PayloadSize, FTW_FUNCTION_WRITE_BATCH);
+
+  //
+  // FvBlockHandle can not be used in SMM environment. Here we get the FVB protocol first, then get FVB base address
+  // and its attribute. Send these information to SMM handler, the SMM handler will find the proper FVB to write data.
+  //
+  Status = ConvertFvbHandle (FvBlockHandle, &SmmFtwWriteBatchHeader->FvbBaseAddress, &SmmFtwWriteBatchHeader->FvbAttributes);
+  if (EFI_ERROR (Status)) {
+    FreePool (SmmCommunicateHeader);
+    return EFI_ABORTED;
+  }
+
+  CopyGuid (&SmmFtwWriteBatchHeader->CallerId, CallerId);
+  SmmFtwWriteBatchHeader->NumberOfWrites = NumberOfWrites;
+
+  SmmFtwWriteBatchEntry = (SMM_FTW_WRITE_BATCH_ENTRY *)SmmFtwWriteBatchHeader->Data;
+  Data                  = (UINT8 *)&SmmFtwWriteBatchEntry[NumberOfWrites];
+  for (Index = 0; Index < NumberOfWrites; Index++) {
+    SmmFtwWriteBatchEntry[Index].Lba    = Writes[Index].Lba;
+    SmmFtwWriteBatchEntry[Index].Offset = Writes[Index].Offset;
+    SmmFtwWriteBatchEntry[Index].Length = Writes[Index].Length;
+    CopyMem (Data, Writes[Index].Buffer, Writes[Index].Length);
+    Data += Writes[Index].Length;
+  }
+
+  //
+  // Send data to SMM.
+  //
+  Status = SendCommunicateBuffer (SmmCommunicateHeader, PayloadSize);
+  FreePool (SmmCommunicateHeader);
+  return Status;
+}
+
 /**
   SMM Fault Tolerant Write Protocol notification event handler.
 
@@ -513,6 +608,14 @@ SmmFtwReady (
                   );
   ASSERT_EFI_ERROR (Status);
 
+  Status = gBS->InstallProtocolInterface (
+                  &mHandle,
+                  &gEdkiiFaultTolerantWriteBatchProtocolGuid,
+                  EFI_NATIVE_INTERFACE,
+                  &mFaultTolerantWriteBatchDriver
+                  );
+  ASSERT_EFI_ERROR (Status);
+
   Status = gBS->CloseEvent (Event);
   ASSERT_EFI_ERROR (Status);
 }
@@ -14,6 +14,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <PiDxe.h>
 
 #include <Protocol/MmCommunication2.h>
+#include <Protocol/FaultTolerantWriteBatch.h>
 
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiDriverEntryPoint.h>
@@ -188,4 +189,29 @@ FtwGetLastWrite (
   OUT BOOLEAN                           *Complete
   );
 
+/**
+  Writes a set of ranges of a firmware volume in a fault tolerant manner.
+
+  @param[in]  This             The calling context.
+  @param[in]  CallerId         The GUID recorded in the write header of the batch.
+  @param[in]  FvBlockHandle    The handle of FVB protocol that provides services.
+  @param[in]  NumberOfWrites   The number of entries in Writes.
+  @param[in]  Writes           The writes to do, applied in order.
+
+  @retval EFI_SUCCESS          All the writes completed successfully.
+  @retval EFI_INVALID_PARAMETER CallerId or Writes is NULL, or a Buffer is NULL.
+  @retval EFI_BAD_BUFFER_SIZE  The writes do not fit in a communication buffer.
+  @retval EFI_ABORTED          The function could not complete successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+FtwWriteBatch (
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_PROTOCOL  *This,
+  IN EFI_GUID                                   *CallerId,
+  IN EFI_HANDLE                                 FvBlockHandle,
+  IN UINTN                                      NumberOfWrites,
+  IN EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY     *Writes
+  );
+
 #endif
@@ -1352,15 +1352,18 @@ InitFtwProtocol (
   }
 
   //
-  // If the FtwDevice->FtwLastWriteRecord is 1st record of write header &&
-  // (! SpareComplete) THEN call Abort().
+  // If the FtwDevice->FtwLastWriteRecord is (! SpareComplete) &&
+  // (1st record of write header || partly written) THEN call Abort().
+  // A partly written record, such as the record of an interrupted group of
+  // WriteBatch(), cannot be restarted nor written again by Write().
   //
   if ((FtwDevice->FtwLastWriteHeader->HeaderAllocated == FTW_VALID_STATE) &&
       (FtwDevice->FtwLastWriteRecord->SpareComplete != FTW_VALID_STATE) &&
-      IsFirstRecordOfWrites (FtwDevice->FtwLastWriteHeader, FtwDevice->FtwLastWriteRecord)
+      (IsFirstRecordOfWrites (FtwDevice->FtwLastWriteHeader, FtwDevice->FtwLastWriteRecord) ||
+       !IsErasedFlashBuffer ((UINT8 *)FtwDevice->FtwLastWriteRecord, FTW_RECORD_SIZE (FtwDevice->FtwLastWriteHeader->PrivateDataSize)))
       )
   {
-    DEBUG ((DEBUG_ERROR, "Ftw: Init.. find first record not SpareCompleted, abort()\n"));
+    DEBUG ((DEBUG_ERROR, "Ftw: Init.. find first or partly written record not SpareCompleted, abort()\n"));
     FtwAbort (&FtwDevice->FtwInstance);
   }
 
@@ -1430,5 +1433,7 @@ InitFtwProtocol (
   FtwDevice->FtwInstance.Abort           = FtwAbort;
   FtwDevice->FtwInstance.GetLastWrite    = FtwGetLastWrite;
 
+  FtwDevice->FtwBatchInstance.WriteBatch = FtwWriteBatch;
+
   return EFI_SUCCESS;
 }
@@ -0,0 +1,1373 @@
+/** @file
+  Host based unit tests of the batch writes of the Fault Tolerant Write driver.
+
+  The SMM flavor of the driver runs on a simulated flash device, reached
+  through a fake MM System Table and a fake Firmware Volume Block protocol
+  that programs bits the way flash does and counts the blocks erased. The
+  writes of every batch are also applied in order to a reference copy of the
+  flash, and the target blocks of the flash must match it after the batch.
+
+  A flash operation can be made to fail, or to never happen because the
+  power is lost before it. The driver is then restarted from the content of
+  the flash, and the target blocks must hold the batch up to a whole group:
+  a group is committed atomically, a batch is not.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <PiMm.h>
+#include <Library/MmServicesTableLib.h>
+#include <Library/BaseLib.h>
+#include "FaultTolerantWrite.h"
+#include "FaultTolerantWriteSmmCommon.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "Fault Tolerant Write Batch Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+//
+// The layout of the simulated flash: the work space is the second half of
+// block 3, the spare area is blocks 4 to 7, and the batches write blocks 8
+// and above.
+//
+#define FTW_TEST_BLOCK_SIZE     SIZE_4KB
+#define FTW_TEST_BLOCK_COUNT    32
+#define FTW_TEST_FLASH_SIZE     (FTW_TEST_BLOCK_SIZE * FTW_TEST_BLOCK_COUNT)
+#define FTW_TEST_WORK_LBA       3
+#define FTW_TEST_SPARE_LBA      4
+#define FTW_TEST_SPARE_BLOCKS   4
+#define FTW_TEST_TARGET_LBA     8
+#define FTW_TEST_TARGET_BLOCKS  (FTW_TEST_BLOCK_COUNT - FTW_TEST_TARGET_LBA)
+#define FTW_TEST_TARGET         (FTW_TEST_TARGET_LBA * FTW_TEST_BLOCK_SIZE)
+#define FTW_TEST_TARGET_SIZE    (FTW_TEST_TARGET_BLOCKS * FTW_TEST_BLOCK_SIZE)
+#define FTW_TEST_ATTRIBUTES     (EFI_FVB2_READ_STATUS | EFI_FVB2_WRITE_STATUS | EFI_FVB2_ERASE_POLARITY)
+
+#define FTW_TEST_MAX_WRITES     64
+#define FTW_TEST_MAX_LENGTH     600
+#define FTW_TEST_BATCHES        60
+#define FTW_TEST_DATA_SIZE      (FTW_TEST_SPARE_BLOCKS * FTW_TEST_BLOCK_SIZE)
+#define FTW_TEST_COMM_SIZE      SIZE_8KB
+
+///
+/// The counters of the simulated flash.
+///
+typedef struct {
+  UINT64    BlocksErased;
+  UINT64    BytesWritten;
+  UINT64    Operations;
+} FTW_TEST_FLASH_STATS;
+
+UINT8                                   *mFtwTestFlash;
+UINT8                                   mFtwTestModel[FTW_TEST_FLASH_SIZE];
+UINT8                                   mFtwTestSnapshot[FTW_TEST_FLASH_SIZE];
+UINT8                                   mFtwTestOriginal[FTW_TEST_FLASH_SIZE];
+UINT8                                   mFtwTestData[FTW_TEST_MAX_WRITES][FTW_TEST_DATA_SIZE];
+UINT8                                   mFtwTestComm[FTW_TEST_COMM_SIZE];
+EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY  mFtwTestWrites[FTW_TEST_MAX_WRITES];
+FTW_TEST_FLASH_STATS                    mFtwTestStats;
+UINT64                                  mFtwTestFailAt;
+BOOLEAN                                 mFtwTestPowerLoss;
+BOOLEAN                                 mFtwTestPowerLost;
+jmp_buf                                 mFtwTestPowerLossJump;
+UINT64                                  mFtwTestSeed;
+EFI_FTW_DEVICE                          *mFtwTestDevice;
+EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL      mFtwTestFvb;
+EFI_HANDLE                              mFtwTestFvbHandle = (EFI_HANDLE)&mFtwTestFvb;
+EFI_MM_SYSTEM_TABLE                     mFtwTestMmst;
+EFI_MM_SYSTEM_TABLE                     *gMmst = &mFtwTestMmst;
+
+EFI_GUID  mFtwTestCallerId = {
+  0x6d3f1a52, 0x0c8e, 0x4b27, { 0x9a, 0x64, 0xe1, 0x5b, 0x7f, 0x30, 0xc2, 0x9d }
+};
+
+extern EFI_FTW_DEVICE  *mFtwDevice;
+
+/**
+  Handles the FTW_FUNCTION_WRITE_BATCH function of the SMI handler.
+
+  @param[in] SmmFtwWriteBatchHeader  The payload of the communication buffer.
+  @param[in] CommBufferPayloadSize   The size of the payload.
+
+  @return The status of FtwWriteBatch (), or EFI_ACCESS_DENIED if the payload
+          is invalid.
+**/
+EFI_STATUS
+SmmFtwWriteBatch (
+  IN SMM_FTW_WRITE_BATCH_HEADER  *SmmFtwWriteBatchHeader,
+  IN UINTN                       CommBufferPayloadSize
+  );
+
+/**
+  Return a pseudo random number.
+
+  @return The next number of the sequence.
+**/
+UINT32
+FtwTestRandom (
+  VOID
+  )
+{
+  mFtwTestSeed = mFtwTestSeed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (UINT32)RShiftU64 (mFtwTestSeed, 33);
+}
+
+/**
+  Counts a flash operation, and fails it if it is the one selected by
+  mFtwTestFailAt. If mFtwTestPowerLoss is set, the power is lost before the
+  operation happens and the control returns to FtwTestWriteBatch ().
+
+  @retval TRUE   The operation fails.
+  @retval FALSE  The operation happens.
+**/
+BOOLEAN
+FtwTestFlashFails (
+  VOID
+  )
+{
+  mFtwTestStats.Operations++;
+  if (mFtwTestStats.Operations != mFtwTestFailAt) {
+    return FALSE;
+  }
+
+  if (mFtwTestPowerLoss) {
+    mFtwTestPowerLost = TRUE;
+    longjmp (mFtwTestPowerLossJump, 1);
+  }
+
+  return TRUE;
+}
+
+/**
+  Returns the attributes of the simulated flash device.
+**/
+EFI_STATUS
+EFIAPI
+FtwTestFvbGetAttributes (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  OUT EFI_FVB_ATTRIBUTES_2                     *Attributes
+  )
+{
+  *Attributes = FTW_TEST_ATTRIBUTES;
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns the address of the simulated flash device.
+**/
+EFI_STATUS
+EFIAPI
+FtwTestFvbGetPhysicalAddress (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  OUT EFI_PHYSICAL_ADDRESS                     *Address
+  )
+{
+  *Address = (EFI_PHYSICAL_ADDRESS)(UINTN)mFtwTestFlash;
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns the block size of the simulated flash device.
+**/
+EFI_STATUS
+EFIAPI
+FtwTestFvbGetBlockSize (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  IN EFI_LBA                                   Lba,
+  OUT UINTN                                    *BlockSize,
+  OUT UINTN                                    *NumberOfBlocks
+  )
+{
+  if (Lba >= FTW_TEST_BLOCK_COUNT) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *BlockSize      = FTW_TEST_BLOCK_SIZE;
+  *NumberOfBlocks = FTW_TEST_BLOCK_COUNT - (UINTN)Lba;
+  return EFI_SUCCESS;
+}
+
+/**
+  Reads the simulated flash device.
+**/
+EFI_STATUS
+EFIAPI
+FtwTestFvbRead (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  IN EFI_LBA                                   Lba,
+  IN UINTN                                     Offset,
+  IN OUT UINTN                                 *NumBytes,
+  IN OUT UINT8                                 *Buffer
+  )
+{
+  if ((Lba >= FTW_TEST_BLOCK_COUNT) || (Offset + *NumBytes > (FTW_TEST_BLOCK_COUNT - (UINTN)Lba) * FTW_TEST_BLOCK_SIZE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  CopyMem (Buffer, mFtwTestFlash + (UINTN)Lba * FTW_TEST_BLOCK_SIZE + Offset, *NumBytes);
+  return EFI_SUCCESS;
+}
+
+/**
+  Programs the simulated flash device: the bits can only be cleared.
+**/
+EFI_STATUS
+EFIAPI
+FtwTestFvbWrite (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  IN EFI_LBA                                   Lba,
+  IN UINTN                                     Offset,
+  IN OUT UINTN                                 *NumBytes,
+  IN UINT8                                     *Buffer
+  )
+{
+  UINT8  *Flash;
+  UINTN  Index;
+
+  if ((Lba >= FTW_TEST_BLOCK_COUNT) || (Offset + *NumBytes > (FTW_TEST_BLOCK_COUNT - (UINTN)Lba) * FTW_TEST_BLOCK_SIZE)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (FtwTestFlashFails ()) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Flash = mFtwTestFlash + (UINTN)Lba * FTW_TEST_BLOCK_SIZE + Offset;
+  for (Index = 0; Index < *NumBytes; Index++) {
+    Flash[Index] &= Buffer[Index];
+  }
+
+  mFtwTestStats.BytesWritten += *NumBytes;
+  return EFI_SUCCESS;
+}
+
+/**
+  Erases ranges of blocks of the simulated flash device.
+**/
+EFI_STATUS
+EFIAPI
+FtwTestFvbEraseBlocks (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  ...
+  )
+{
+  VA_LIST  Args;
+  EFI_LBA  Lba;
+  UINTN    NumberOfBlocks;
+
+  if (FtwTestFlashFails ()) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  VA_START (Args, This);
+  for ( ; ;) {
+    Lba = VA_ARG (Args, EFI_LBA);
+    if (Lba == EFI_LBA_LIST_TERMINATOR) {
+      break;
+    }
+
+    NumberOfBlocks = VA_ARG (Args, UINTN);
+    if (Lba + NumberOfBlocks > FTW_TEST_BLOCK_COUNT) {
+      VA_END (Args);
+      return EFI_INVALID_PARAMETER;
+    }
+
+    SetMem (mFtwTestFlash + (UINTN)Lba * FTW_TEST_BLOCK_SIZE, NumberOfBlocks * FTW_TEST_BLOCK_SIZE, 0xFF);
+    mFtwTestStats.BlocksErased += NumberOfBlocks;
+  }
+
+  VA_END (Args);
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns the handle of the simulated flash device, the only one with the
+  SMM FVB protocol.
+**/
+EFI_STATUS
+EFIAPI
+FtwTestMmLocateHandle (
+  IN     EFI_LOCATE_SEARCH_TYPE  SearchType,
+  IN     EFI_GUID                *Protocol,
+  IN     VOID                    *SearchKey,
+  IN OUT UINTN                   *BufferSize,
+  OUT    EFI_HANDLE              *Buffer
+  )
+{
+  if (!CompareGuid (Protocol, &gEfiSmmFirmwareVolumeBlockProtocolGuid)) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (*BufferSize < sizeof (EFI_HANDLE)) {
+    *BufferSize = sizeof (EFI_HANDLE);
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *BufferSize = sizeof (EFI_HANDLE);
+  Buffer[0]   = mFtwTestFvbHandle;
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns the SMM FVB protocol of the simulated flash device.
+**/
+EFI_STATUS
+EFIAPI
+FtwTestMmHandleProtocol (
+  IN  EFI_HANDLE  UserHandle,
+  IN  EFI_GUID    *Protocol,
+  OUT VOID        **Interface
+  )
+{
+  if ((UserHandle != mFtwTestFvbHandle) || !CompareGuid (Protocol, &gEfiSmmFirmwareVolumeBlockProtocolGuid)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  *Interface = &mFtwTestFvb;
+  return EFI_SUCCESS;
+}
+
+/**
+  There is no other protocol: the simulated flash has no boot block to swap.
+**/
+EFI_STATUS
+EFIAPI
+FtwTestMmLocateProtocol (
+  IN  EFI_GUID  *Protocol,
+  IN  VOID      *Registration  OPTIONAL,
+  OUT VOID      **Interface
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Get the base address and size for the fault tolerant write (FTW) spare
+  area used for UEFI variable storage.
+
+  @param[out] BaseAddress    The FTW spare base address.
+  @param[out] Length         The FTW spare length.
+
+  @retval     EFI_SUCCESS    The FTW spare information was returned.
+**/
+EFI_STATUS
+EFIAPI
+GetVariableFlashFtwSpareInfo (
+  OUT EFI_PHYSICAL_ADDRESS  *BaseAddress,
+  OUT UINT64                *Length
+  )
+{
+  *BaseAddress = (EFI_PHYSICAL_ADDRESS)(UINTN)(mFtwTestFlash + FTW_TEST_SPARE_LBA * FTW_TEST_BLOCK_SIZE);
+  *Length      = FTW_TEST_SPARE_BLOCKS * FTW_TEST_BLOCK_SIZE;
+  return EFI_SUCCESS;
+}
+
+/**
+  Get the base address and size for the fault tolerant write (FTW) working
+  area used for UEFI variable storage.
+
+  @param[out] BaseAddress    The FTW working area base address.
+  @param[out] Length         The FTW working area length.
+
+  @retval     EFI_SUCCESS    The FTW working area information was returned.
+**/
+EFI_STATUS
+EFIAPI
+GetVariableFlashFtwWorkingInfo (
+  OUT EFI_PHYSICAL_ADDRESS  *BaseAddress,
+  OUT UINT64                *Length
+  )
+{
+  *BaseAddress = (EFI_PHYSICAL_ADDRESS)(UINTN)(mFtwTestFlash + FTW_TEST_WORK_LBA * FTW_TEST_BLOCK_SIZE + FTW_TEST_BLOCK_SIZE / 2);
+  *Length      = FTW_TEST_BLOCK_SIZE / 2;
+  return EFI_SUCCESS;
+}
+
+/**
+  Internal implementation of CRC32. Depending on the execution context
+  (traditional SMM or DXE vs standalone MM), this function is implemented
+  via a call to the CalculateCrc32 () boot service, or via a library
+  call.
+
+  @param[in] Buffer       The data to checksum.
+  @param[in] Length       The size of data buffer.
+
+  @return The CRC32 value.
+**/
+UINT32
+FtwCalculateCrc32 (
+  IN  VOID   *Buffer,
+  IN  UINTN  Length
+  )
+{
+  return CalculateCrc32 (Buffer, Length);
+}
+
+/**
+  The buffers of the tests are not in SMRAM.
+
+  @param Buffer The buffer start address to be checked.
+  @param Length The buffer length to be checked.
+
+  @retval TRUE  This buffer is valid.
+**/
+BOOLEAN
+FtwSmmIsBufferOutsideSmmValid (
+  IN EFI_PHYSICAL_ADDRESS  Buffer,
+  IN UINT64                Length
+  )
+{
+  return TRUE;
+}
+
+/**
+  Notify the system that the SMM FTW driver is ready.
+**/
+VOID
+FtwNotifySmmReady (
+  VOID
+  )
+{
+}
+
+/**
+  Starts the driver on the content of the simulated flash, as after a reset.
+  The pending write of an interrupted batch is recovered here.
+
+  @retval EFI_SUCCESS  The driver has been started.
+  @retval others       The driver could not be started.
+**/
+EFI_STATUS
+FtwTestBoot (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  if (mFtwTestDevice != NULL) {
+    FreePool (mFtwTestDevice);
+    mFtwTestDevice = NULL;
+  }
+
+  mFtwTestFvb.GetAttributes      = FtwTestFvbGetAttributes;
+  mFtwTestFvb.GetPhysicalAddress = FtwTestFvbGetPhysicalAddress;
+  mFtwTestFvb.GetBlockSize       = FtwTestFvbGetBlockSize;
+  mFtwTestFvb.Read               = FtwTestFvbRead;
+  mFtwTestFvb.Write              = FtwTestFvbWrite;
+  mFtwTestFvb.EraseBlocks        = FtwTestFvbEraseBlocks;
+
+  mFtwTestMmst.MmLocateHandle   = FtwTestMmLocateHandle;
+  mFtwTestMmst.MmHandleProtocol = FtwTestMmHandleProtocol;
+  mFtwTestMmst.MmLocateProtocol = FtwTestMmLocateProtocol;
+
+  Status = InitFtwDevice (&mFtwTestDevice);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = InitFtwProtocol (mFtwTestDevice);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  mFtwDevice = mFtwTestDevice;
+  return EFI_SUCCESS;
+}
+
+/**
+  Erases the simulated flash, fills the target blocks with random data and
+  starts the driver.
+
+  @param[in] Seed  The seed of the random data.
+
+  @retval EFI_SUCCESS  The driver has been started.
+  @retval others       The driver could not be started.
+**/
+EFI_STATUS
+FtwTestFormat (
+  IN UINT64  Seed
+  )
+{
+  UINTN  Index;
+
+  mFtwTestSeed   = Seed;
+  mFtwTestFailAt = 0;
+  ZeroMem (&mFtwTestStats, sizeof (mFtwTestStats));
+  SetMem (mFtwTestFlash, FTW_TEST_FLASH_SIZE, 0xFF);
+  for (Index = FTW_TEST_TARGET; Index < FTW_TEST_FLASH_SIZE; Index++) {
+    mFtwTestFlash[Index] = (UINT8)FtwTestRandom ();
+  }
+
+  CopyMem (mFtwTestModel, mFtwTestFlash, FTW_TEST_FLASH_SIZE);
+  return FtwTestBoot ();
+}
+
+/**
+  Sets a write of a batch to random data.
+
+  @param[in] Index   The index of the write in mFtwTestWrites.
+  @param[in] Lba     The block of the write.
+  @param[in] Offset  The offset of the write from the start of Lba.
+  @param[in] Length  The length of the write.
+**/
+VOID
+FtwTestSetWrite (
+  IN UINTN    Index,
+  IN EFI_LBA  Lba,
+  IN UINTN    Offset,
+  IN UINTN    Length
+  )
+{
+  UINTN  Byte;
+
+  mFtwTestWrites[Index].Lba    = Lba;
+  mFtwTestWrites[Index].Offset = Offset;
+  mFtwTestWrites[Index].Length = Length;
+  mFtwTestWrites[Index].Buffer = mFtwTestData[Index];
+  for (Byte = 0; Byte < Length; Byte++) {
+    mFtwTestData[Index][Byte] = (UINT8)FtwTestRandom ();
+  }
+}
+
+/**
+  Sets the writes of a batch to random ranges of the target blocks. Some are
+  given with an offset larger than the block size.
+
+  @param[in] NumberOfWrites  The number of writes.
+**/
+VOID
+FtwTestRandomWrites (
+  IN UINTN  NumberOfWrites
+  )
+{
+  UINTN  Index;
+  UINTN  Length;
+  UINTN  Start;
+  UINTN  Blocks;
+
+  for (Index = 0; Index < NumberOfWrites; Index++) {
+    Length = 1 + FtwTestRandom () % FTW_TEST_MAX_LENGTH;
+    Start  = FTW_TEST_TARGET + FtwTestRandom () % (FTW_TEST_TARGET_SIZE - Length);
+    Blocks = MIN (FtwTestRandom () % 3, Start / FTW_TEST_BLOCK_SIZE - FTW_TEST_TARGET_LBA);
+    FtwTestSetWrite (Index, Start / FTW_TEST_BLOCK_SIZE - Blocks, Start % FTW_TEST_BLOCK_SIZE + Blocks * FTW_TEST_BLOCK_SIZE, Length);
+  }
+}
+
+/**
+  Applies the writes of a batch, in order, to a copy of the flash.
+
+  @param[in]      NumberOfWrites  The number of writes in mFtwTestWrites.
+  @param[in, out] Flash           The copy of the flash.
+**/
+VOID
+FtwTestApplyWrites (
+  IN     UINTN  NumberOfWrites,
+  IN OUT UINT8  *Flash
+  )
+{
+  UINTN                                   Index;
+  EDKII_FAULT_TOLERANT_WRITE_BATCH_ENTRY  *Write;
+
+  for (Index = 0; Index < NumberOfWrites; Index++) {
+    Write = &mFtwTestWrites[Index];
+    CopyMem (Flash + (UINTN)Write->Lba * FTW_TEST_BLOCK_SIZE + Write->Offset, Write->Buffer, Write->Length);
+  }
+}
+
+/**
+  Writes a batch through the protocol. If the power is lost during the batch,
+  the driver is restarted from the content of the flash.
+
+  @param[in] NumberOfWrites  The number of writes in mFtwTestWrites.
+
+  @return The status of WriteBatch (), or EFI_ABORTED if the power was lost.
+**/
+EFI_STATUS
+FtwTestWriteBatch (
+  IN UINTN  NumberOfWrites
+  )
+{
+  mFtwTestPowerLost = FALSE;
+  if (setjmp (mFtwTestPowerLossJump) != 0) {
+    mFtwTestFailAt = 0;
+    FtwTestBoot ();
+    return EFI_ABORTED;
+  }
+
+  return mFtwTestDevice->FtwBatchInstance.WriteBatch (
+                                            &mFtwTestDevice->FtwBatchInstance,
+                                            &mFtwTestCallerId,
+                                            mFtwTestFvbHandle,
+                                            NumberOfWrites,
+                                            mFtwTestWrites
+                                            );
+}
+
+/**
+  Writes a range through the Write () service, without Allocate () as most
+  drivers do. If the power is lost during the write, the driver is restarted
+  from the content of the flash.
+
+  @param[in] Index  The index of the write in mFtwTestWrites.
+
+  @return The status of Write (), or EFI_ABORTED if the power was lost.
+**/
+EFI_STATUS
+FtwTestWrite (
+  IN UINTN  Index
+  )
+{
+  mFtwTestPowerLost = FALSE;
+  if (setjmp (mFtwTestPowerLossJump) != 0) {
+    mFtwTestFailAt = 0;
+    FtwTestBoot ();
+    return EFI_ABORTED;
+  }
+
+  return mFtwTestDevice->FtwInstance.Write (
+                                       &mFtwTestDevice->FtwInstance,
+                                       mFtwTestWrites[Index].Lba,
+                                       mFtwTestWrites[Index].Offset,
+                                       mFtwTestWrites[Index].Length,
+                                       NULL,
+                                       mFtwTestFvbHandle,
+                                       mFtwTestWrites[Index].Buffer
+                                       );
+}
+
+/**
+  Checks that the target blocks hold a whole number of groups of a batch:
+  the first groups have the content of the reference model, and the others
+  their content before the batch.
+
+  @param[in] NumberOfWrites  The number of writes in mFtwTestWrites.
+  @param[in] Original        The content of the flash before the batch.
+
+  @return The number of groups committed, or MAX_UINTN if the target blocks
+          do not match.
+**/
+UINTN
+FtwTestCommittedGroups (
+  IN UINTN  NumberOfWrites,
+  IN UINT8  *Original
+  )
+{
+  EFI_STATUS       Status;
+  UINTN            Order[FTW_TEST_MAX_WRITES];
+  FTW_BATCH_GROUP  Groups[FTW_TEST_MAX_WRITES];
+  UINTN            NumberOfGroups;
+  UINTN            Committed;
+  UINTN            Start;
+  UINTN            Size;
+
+  Status = FtwGetBatchGroups (
+             mFtwTestWrites,
+             NumberOfWrites,
+             FTW_TEST_BLOCK_SIZE,
+             FTW_TEST_SPARE_BLOCKS,
+             Order,
+             Groups,
+             &NumberOfGroups
+             );
+  if (EFI_ERROR (Status)) {
+    return MAX_UINTN;
+  }
+
+  CopyMem (mFtwTestSnapshot, Original, FTW_TEST_FLASH_SIZE);
+  for (Committed = 0; ; Committed++) {
+    if (CompareMem (mFtwTestSnapshot + FTW_TEST_TARGET, mFtwTestFlash + FTW_TEST_TARGET, FTW_TEST_TARGET_SIZE) == 0) {
+      return Committed;
+    }
+
+    if (Committed == NumberOfGroups) {
+      return MAX_UINTN;
+    }
+
+    Start = (UINTN)Groups[Committed].Lba * FTW_TEST_BLOCK_SIZE;
+    Size  = FTW_BLOCKS (Groups[Committed].Offset + Groups[Committed].Length, FTW_TEST_BLOCK_SIZE) * FTW_TEST_BLOCK_SIZE;
+    CopyMem (mFtwTestSnapshot + Start, mFtwTestModel + Start, Size);
+  }
+}
+
+/**
+  Checks the groups of writes given with a block and an offset, at the
+  boundaries of the spare area.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FtwTestBatchGroups (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS       Status;
+  UINTN            Order[FTW_TEST_MAX_WRITES];
+  FTW_BATCH_GROUP  Groups[FTW_TEST_MAX_WRITES];
+  UINTN            NumberOfGroups;
+
+  mFtwTestSeed = 1;
+
+  //
+  // A write ending on the last byte of the spare area joins the group, a
+  // write ending one byte later starts a new group at its first block, even
+  // if it starts in the last block of the previous group. Empty writes are
+  // left out, and writes are ordered by their first byte whatever the block
+  // they are given with.
+  //
+  FtwTestSetWrite (0, 9, 10, 20);
+  FtwTestSetWrite (1, 8, 100, 50);
+  FtwTestSetWrite (2, 8, 4 * FTW_TEST_BLOCK_SIZE - 6, 6);
+  FtwTestSetWrite (3, 11, FTW_TEST_BLOCK_SIZE - 5, 6);
+  FtwTestSetWrite (4, 12, 0, 0);
+  FtwTestSetWrite (5, 14, 3 * FTW_TEST_BLOCK_SIZE, FTW_TEST_BLOCK_SIZE);
+  FtwTestSetWrite (6, 13, 10, 1);
+
+  Status = FtwGetBatchGroups (mFtwTestWrites, 7, FTW_TEST_BLOCK_SIZE, FTW_TEST_SPARE_BLOCKS, Order, Groups, &NumberOfGroups);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (NumberOfGroups, 3);
+  UT_ASSERT_EQUAL (Groups[0].Lba, 8);
+  UT_ASSERT_EQUAL (Groups[0].Offset, 100);
+  UT_ASSERT_EQUAL (Groups[0].Length, 4 * FTW_TEST_BLOCK_SIZE - 100);
+  UT_ASSERT_EQUAL (Groups[1].Lba, 11);
+  UT_ASSERT_EQUAL (Groups[1].Offset, FTW_TEST_BLOCK_SIZE - 5);
+  UT_ASSERT_EQUAL (Groups[1].Length, FTW_TEST_BLOCK_SIZE + 16);
+  UT_ASSERT_EQUAL (Groups[2].Lba, 17);
+  UT_ASSERT_EQUAL (Groups[2].Offset, 0);
+  UT_ASSERT_EQUAL (Groups[2].Length, FTW_TEST_BLOCK_SIZE);
+
+  //
+  // A write as large as the spare area is a group if it starts on a block.
+  //
+  FtwTestSetWrite (0, 8, 0, 4 * FTW_TEST_BLOCK_SIZE);
+  Status = FtwGetBatchGroups (mFtwTestWrites, 1, FTW_TEST_BLOCK_SIZE, FTW_TEST_SPARE_BLOCKS, Order, Groups, &NumberOfGroups);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (NumberOfGroups, 1);
+  UT_ASSERT_EQUAL (Groups[0].Length, 4 * FTW_TEST_BLOCK_SIZE);
+
+  //
+  // A write that spans more blocks than the spare area is rejected.
+  //
+  mFtwTestWrites[0].Offset = 1;
+  Status                   = FtwGetBatchGroups (mFtwTestWrites, 1, FTW_TEST_BLOCK_SIZE, FTW_TEST_SPARE_BLOCKS, Order, Groups, &NumberOfGroups);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_BAD_BUFFER_SIZE);
+
+  mFtwTestWrites[0].Offset = 0;
+  mFtwTestWrites[0].Length = 4 * FTW_TEST_BLOCK_SIZE + 1;
+  Status                   = FtwGetBatchGroups (mFtwTestWrites, 1, FTW_TEST_BLOCK_SIZE, FTW_TEST_SPARE_BLOCKS, Order, Groups, &NumberOfGroups);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_BAD_BUFFER_SIZE);
+
+  //
+  // Only empty writes, no group.
+  //
+  FtwTestSetWrite (0, 8, 0, 0);
+  Status = FtwGetBatchGroups (mFtwTestWrites, 1, FTW_TEST_BLOCK_SIZE, FTW_TEST_SPARE_BLOCKS, Order, Groups, &NumberOfGroups);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (NumberOfGroups, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks the image of a group built from random overlapping writes against
+  the writes applied in order to a copy of the flash, for groups at random
+  places.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FtwTestApplyBatchWrites (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN    Round;
+  UINTN    NumberOfWrites;
+  EFI_LBA  Lba;
+  UINTN    NumberOfBlocks;
+  UINT8    *Image;
+
+  mFtwTestSeed = 2;
+  Image        = AllocatePool (FTW_TEST_SPARE_BLOCKS * FTW_TEST_BLOCK_SIZE);
+  UT_ASSERT_NOT_NULL (Image);
+
+  for (Round = 0; Round < 200; Round++) {
+    SetMem (mFtwTestModel, FTW_TEST_FLASH_SIZE, (UINT8)Round);
+    NumberOfWrites = 1 + FtwTestRandom () % FTW_TEST_MAX_WRITES;
+    FtwTestRandomWrites (NumberOfWrites);
+    FtwTestApplyWrites (NumberOfWrites, mFtwTestModel);
+
+    NumberOfBlocks = 1 + FtwTestRandom () % FTW_TEST_SPARE_BLOCKS;
+    Lba            = FTW_TEST_TARGET_LBA + FtwTestRandom () % (FTW_TEST_TARGET_BLOCKS - NumberOfBlocks + 1);
+    SetMem (Image, NumberOfBlocks * FTW_TEST_BLOCK_SIZE, (UINT8)Round);
+    FtwApplyBatchWrites (mFtwTestWrites, NumberOfWrites, FTW_TEST_BLOCK_SIZE, Lba, NumberOfBlocks, Image);
+    UT_ASSERT_MEM_EQUAL (Image, mFtwTestModel + (UINTN)Lba * FTW_TEST_BLOCK_SIZE, NumberOfBlocks * FTW_TEST_BLOCK_SIZE);
+  }
+
+  FreePool (Image);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Writes batches whose writes overlap across groups, in both orders, and
+  checks that the later write wins in all the groups.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FtwTestOverlapAcrossGroups (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS       Status;
+  UINTN            Order[FTW_TEST_MAX_WRITES];
+  FTW_BATCH_GROUP  Groups[FTW_TEST_MAX_WRITES];
+  UINTN            NumberOfGroups;
+  UINTN            Round;
+  EFI_GUID         CallerId;
+  EFI_LBA          Lba;
+  UINTN            Offset;
+  UINTN            Length;
+  UINTN            PrivateDataSize;
+  BOOLEAN          Complete;
+
+  UT_ASSERT_NOT_EFI_ERROR (FtwTestFormat (3));
+
+  for (Round = 0; Round < 2; Round++) {
+    //
+    // The write filling the group of blocks 8 to 11 is the first one, then
+    // the last one, so the other writes of block 11 win, then lose against
+    // it. The writes ending in block 12 start the next group.
+    //
+    if (Round == 0) {
+      FtwTestSetWrite (0, 8, 20, 4 * FTW_TEST_BLOCK_SIZE - 30);
+    } else {
+      FtwTestSetWrite (0, 11, FTW_TEST_BLOCK_SIZE - 100, 150);
+    }
+
+    FtwTestSetWrite (1, 11, FTW_TEST_BLOCK_SIZE - 40, 80);
+    FtwTestSetWrite (2, 10, 2 * FTW_TEST_BLOCK_SIZE - 30, 10);
+    if (Round == 1) {
+      FtwTestSetWrite (3, 8, 20, 4 * FTW_TEST_BLOCK_SIZE - 30);
+    }
+
+    Status = FtwGetBatchGroups (mFtwTestWrites, 3 + Round, FTW_TEST_BLOCK_SIZE, FTW_TEST_SPARE_BLOCKS, Order, Groups, &NumberOfGroups);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL (NumberOfGroups, 2);
+
+    FtwTestApplyWrites (3 + Round, mFtwTestModel);
+    Status = FtwTestWriteBatch (3 + Round);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_MEM_EQUAL (mFtwTestFlash + FTW_TEST_TARGET, mFtwTestModel + FTW_TEST_TARGET, FTW_TEST_TARGET_SIZE);
+
+    PrivateDataSize = 0;
+    Status = mFtwTestDevice->FtwInstance.GetLastWrite (
+                                           &mFtwTestDevice->FtwInstance,
+                                           &CallerId,
+                                           &Lba,
+                                           &Offset,
+                                           &Length,
+                                           &PrivateDataSize,
+                                           NULL,
+                                           &Complete
+                                           );
+    UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_FOUND);
+    UT_ASSERT_TRUE (Complete);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Writes random batches, checks them against the reference model, and
+  compares the blocks erased with the same writes done one at a time with
+  Write ().
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FtwTestRandomBatches (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS            Status;
+  UINTN                 Round;
+  UINTN                 Index;
+  UINTN                 NumberOfWrites;
+  FTW_TEST_FLASH_STATS  Batch;
+  FTW_TEST_FLASH_STATS  Single;
+
+  ZeroMem (&Batch, sizeof (Batch));
+  ZeroMem (&Single, sizeof (Single));
+
+  //
+  // The same batches are written one write at a time, then as batches.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (FtwTestFormat (4));
+  for (Round = 0; Round < FTW_TEST_BATCHES; Round++) {
+    NumberOfWrites = 1 + FtwTestRandom () % FTW_TEST_MAX_WRITES;
+    FtwTestRandomWrites (NumberOfWrites);
+    FtwTestApplyWrites (NumberOfWrites, mFtwTestModel);
+    for (Index = 0; Index < NumberOfWrites; Index++) {
+      Status = mFtwTestDevice->FtwInstance.Allocate (&mFtwTestDevice->FtwInstance, &mFtwTestCallerId, 0, 1);
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+      Status = mFtwTestDevice->FtwInstance.Write (
+                                             &mFtwTestDevice->FtwInstance,
+                                             mFtwTestWrites[Index].Lba,
+                                             mFtwTestWrites[Index].Offset,
+                                             mFtwTestWrites[Index].Length,
+                                             NULL,
+                                             mFtwTestFvbHandle,
+                                             mFtwTestWrites[Index].Buffer
+                                             );
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+    }
+
+    UT_ASSERT_MEM_EQUAL (mFtwTestFlash + FTW_TEST_TARGET, mFtwTestModel + FTW_TEST_TARGET, FTW_TEST_TARGET_SIZE);
+  }
+
+  CopyMem (&Single, &mFtwTestStats, sizeof (Single));
+
+  UT_ASSERT_NOT_EFI_ERROR (FtwTestFormat (4));
+  for (Round = 0; Round < FTW_TEST_BATCHES; Round++) {
+    NumberOfWrites = 1 + FtwTestRandom () % FTW_TEST_MAX_WRITES;
+    FtwTestRandomWrites (NumberOfWrites);
+    FtwTestApplyWrites (NumberOfWrites, mFtwTestModel);
+    Status = FtwTestWriteBatch (NumberOfWrites);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_MEM_EQUAL (mFtwTestFlash + FTW_TEST_TARGET, mFtwTestModel + FTW_TEST_TARGET, FTW_TEST_TARGET_SIZE);
+  }
+
+  CopyMem (&Batch, &mFtwTestStats, sizeof (Batch));
+
+  UT_LOG_INFO (
+    "Write(): %ld blocks erased, %ld KB written; WriteBatch(): %ld blocks erased, %ld KB written\n",
+    Single.BlocksErased,
+    Single.BytesWritten / SIZE_1KB,
+    Batch.BlocksErased,
+    Batch.BytesWritten / SIZE_1KB
+    );
+
+  UT_ASSERT_TRUE (Batch.BlocksErased < Single.BlocksErased);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Fills the work space until the header of a batch does not fit, and checks
+  that the batch reclaims the work space and writes its header at the start
+  of the reclaimed work space, where the driver finds it after a reset.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FtwTestAllocateAfterReclaim (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN                            Offset;
+  UINTN                            Batches;
+  EFI_FAULT_TOLERANT_WRITE_HEADER  *Header;
+
+  UT_ASSERT_NOT_EFI_ERROR (FtwTestFormat (5));
+
+  //
+  // Three writes, one per group.
+  //
+  FtwTestSetWrite (0, 8, 1, 10);
+  FtwTestSetWrite (1, 16, 2, 10);
+  FtwTestSetWrite (2, 24, 3, 10);
+
+  for (Batches = 0; ; Batches++) {
+    UT_ASSERT_NOT_EFI_ERROR (WorkSpaceRefresh (mFtwTestDevice));
+    Offset = (UINT8 *)mFtwTestDevice->FtwLastWriteHeader - mFtwTestDevice->FtwWorkSpace;
+    if (Offset + FTW_WRITE_TOTAL_SIZE (3, 0) > mFtwTestDevice->FtwWorkSpaceSize) {
+      break;
+    }
+
+    FtwTestApplyWrites (1, mFtwTestModel);
+    UT_ASSERT_NOT_EFI_ERROR (FtwTestWriteBatch (1));
+  }
+
+  UT_ASSERT_TRUE (Batches > 0);
+
+  FtwTestApplyWrites (3, mFtwTestModel);
+  UT_ASSERT_NOT_EFI_ERROR (FtwTestWriteBatch (3));
+  UT_ASSERT_MEM_EQUAL (mFtwTestFlash + FTW_TEST_TARGET, mFtwTestModel + FTW_TEST_TARGET, FTW_TEST_TARGET_SIZE);
+
+  //
+  // The header is the first one of the work space on the flash.
+  //
+  Header = (EFI_FAULT_TOLERANT_WRITE_HEADER *)(mFtwTestFlash + FTW_TEST_WORK_LBA * FTW_TEST_BLOCK_SIZE + FTW_TEST_BLOCK_SIZE / 2 +
+                                               sizeof (EFI_FAULT_TOLERANT_WORKING_BLOCK_HEADER));
+  UT_ASSERT_TRUE (CompareGuid (&Header->CallerId, &mFtwTestCallerId));
+  UT_ASSERT_EQUAL (Header->NumberOfWrites, 3);
+  UT_ASSERT_EQUAL (Header->HeaderAllocated, FTW_VALID_STATE);
+  UT_ASSERT_EQUAL (Header->WritesAllocated, FTW_VALID_STATE);
+  UT_ASSERT_EQUAL (Header->Complete, FTW_VALID_STATE);
+
+  //
+  // After a reset, the next batch goes after it.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (FtwTestBoot ());
+  Offset = (UINT8 *)mFtwTestDevice->FtwLastWriteHeader - mFtwTestDevice->FtwWorkSpace;
+  UT_ASSERT_EQUAL (Offset, sizeof (EFI_FAULT_TOLERANT_WORKING_BLOCK_HEADER) + FTW_WRITE_TOTAL_SIZE (3, 0));
+
+  FtwTestApplyWrites (3, mFtwTestModel);
+  UT_ASSERT_NOT_EFI_ERROR (FtwTestWriteBatch (3));
+  UT_ASSERT_MEM_EQUAL (mFtwTestFlash + FTW_TEST_TARGET, mFtwTestModel + FTW_TEST_TARGET, FTW_TEST_TARGET_SIZE);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Interrupts a batch at every flash operation, by a failure of the operation
+  or by a power loss, recovers as a caller of the protocol would or by a
+  reset, and checks that the target blocks hold whole groups, then that the
+  batch can be written again.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FtwTestInterruptedBatch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT64      Operations;
+  UINT64      FailAt;
+  UINTN       PowerLoss;
+  UINTN       NumberOfWrites;
+  UINTN       Committed;
+  UINTN       Partial;
+  UINTN       Other;
+  EFI_GUID    CallerId;
+  EFI_LBA     Lba;
+  UINTN       Offset;
+  UINTN       Length;
+  UINTN       PrivateDataSize;
+  BOOLEAN     Complete;
+
+  //
+  // Three groups, with writes overlapping across them.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (FtwTestFormat (6));
+  FtwTestSetWrite (0, 8, 20, 4 * FTW_TEST_BLOCK_SIZE - 30);
+  FtwTestSetWrite (1, 11, FTW_TEST_BLOCK_SIZE - 40, 80);
+  FtwTestSetWrite (2, 10, 2 * FTW_TEST_BLOCK_SIZE - 30, 10);
+  FtwTestSetWrite (3, 20, 5, 300);
+  FtwTestSetWrite (4, 12, 3, 10);
+  NumberOfWrites = 5;
+
+  CopyMem (mFtwTestOriginal, mFtwTestFlash, FTW_TEST_FLASH_SIZE);
+  FtwTestApplyWrites (NumberOfWrites, mFtwTestModel);
+
+  //
+  // Count the flash operations of the batch.
+  //
+  Operations = mFtwTestStats.Operations;
+  UT_ASSERT_NOT_EFI_ERROR (FtwTestWriteBatch (NumberOfWrites));
+  UT_ASSERT_EQUAL (FtwTestCommittedGroups (NumberOfWrites, mFtwTestOriginal), 3);
+  Operations = mFtwTestStats.Operations - Operations;
+
+  Partial = 0;
+  for (PowerLoss = 0; PowerLoss < 2; PowerLoss++) {
+    for (FailAt = 1; FailAt <= Operations; FailAt++) {
+      CopyMem (mFtwTestFlash, mFtwTestOriginal, FTW_TEST_FLASH_SIZE);
+      UT_ASSERT_NOT_EFI_ERROR (FtwTestBoot ());
+      mFtwTestPowerLoss = (BOOLEAN)(PowerLoss != 0);
+      mFtwTestFailAt    = mFtwTestStats.Operations + FailAt;
+
+      Status = FtwTestWriteBatch (NumberOfWrites);
+      UT_ASSERT_TRUE (EFI_ERROR (Status));
+      UT_ASSERT_EQUAL (mFtwTestPowerLost, mFtwTestPowerLoss);
+      mFtwTestFailAt = 0;
+
+      Committed = MAX_UINTN;
+      if (mFtwTestPowerLoss) {
+        Committed = FtwTestCommittedGroups (NumberOfWrites, mFtwTestOriginal);
+        UT_ASSERT_TRUE (Committed != MAX_UINTN);
+
+        //
+        // The reset has recovered the batch, so a Write () out of its blocks,
+        // as done by the other drivers, is fault tolerant too. The power is
+        // lost at a different operation of the Write () in each round: its
+        // range holds the old or the new data, and the other blocks are
+        // unchanged.
+        //
+        FtwTestSetWrite (NumberOfWrites, FTW_TEST_BLOCK_COUNT - 4, 5, 20);
+        Other          = (FTW_TEST_BLOCK_COUNT - 4) * FTW_TEST_BLOCK_SIZE + 5;
+        mFtwTestFailAt = mFtwTestStats.Operations + FailAt % 20 + 1;
+        Status         = FtwTestWrite (NumberOfWrites);
+        mFtwTestFailAt = 0;
+        if (!EFI_ERROR (Status) || (CompareMem (mFtwTestFlash + Other, mFtwTestData[NumberOfWrites], 20) == 0)) {
+          UT_ASSERT_MEM_EQUAL (mFtwTestFlash + Other, mFtwTestData[NumberOfWrites], 20);
+          CopyMem (mFtwTestModel + Other, mFtwTestData[NumberOfWrites], 20);
+          CopyMem (mFtwTestOriginal + Other, mFtwTestData[NumberOfWrites], 20);
+        }
+      }
+
+      //
+      // As a caller of the protocol, complete the group backed up in the
+      // spare area, if any, then abort the rest of the batch.
+      //
+      PrivateDataSize = 0;
+      Status          = mFtwTestDevice->FtwInstance.GetLastWrite (
+                                                      &mFtwTestDevice->FtwInstance,
+                                                      &CallerId,
+                                                      &Lba,
+                                                      &Offset,
+                                                      &Length,
+                                                      &PrivateDataSize,
+                                                      NULL,
+                                                      &Complete
+                                                      );
+      if (!EFI_ERROR (Status)) {
+        if (!Complete) {
+          mFtwTestDevice->FtwInstance.Restart (&mFtwTestDevice->FtwInstance, mFtwTestFvbHandle);
+        }
+
+        mFtwTestDevice->FtwInstance.Abort (&mFtwTestDevice->FtwInstance);
+      }
+
+      //
+      // The target blocks hold whole groups.
+      //
+      if (Committed == MAX_UINTN) {
+        Committed = FtwTestCommittedGroups (NumberOfWrites, mFtwTestOriginal);
+        UT_ASSERT_TRUE (Committed != MAX_UINTN);
+      }
+
+      UT_ASSERT_EQUAL (FtwTestCommittedGroups (NumberOfWrites, mFtwTestOriginal), Committed);
+      if ((Committed != 0) && (Committed != 3)) {
+        Partial++;
+      }
+
+      //
+      // The batch can be written again, after a reset too.
+      //
+      UT_ASSERT_NOT_EFI_ERROR (FtwTestWriteBatch (NumberOfWrites));
+      UT_ASSERT_MEM_EQUAL (mFtwTestFlash + FTW_TEST_TARGET, mFtwTestModel + FTW_TEST_TARGET, FTW_TEST_TARGET_SIZE);
+      UT_ASSERT_NOT_EFI_ERROR (FtwTestBoot ());
+      UT_ASSERT_NOT_EFI_ERROR (FtwTestWriteBatch (NumberOfWrites));
+      UT_ASSERT_MEM_EQUAL (mFtwTestFlash + FTW_TEST_TARGET, mFtwTestModel + FTW_TEST_TARGET, FTW_TEST_TARGET_SIZE);
+    }
+  }
+
+  UT_LOG_INFO (
+    "%ld flash operations per batch, %ld interruptions left some of the groups written\n",
+    Operations,
+    (UINT64)Partial
+    );
+
+  UT_ASSERT_TRUE (Partial > 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Writes a batch through the SMI handler function, and checks that the
+  payloads that do not hold their writes are rejected.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FtwTestSmmWriteBatch (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS                  Status;
+  SMM_FTW_WRITE_BATCH_HEADER  *Header;
+  SMM_FTW_WRITE_BATCH_ENTRY   *Entries;
+  UINT8                       *Data;
+  UINTN                       NumberOfWrites;
+  UINTN                       PayloadSize;
+  UINTN                       Index;
+
+  UT_ASSERT_NOT_EFI_ERROR (FtwTestFormat (7));
+
+  NumberOfWrites = 4;
+  FtwTestSetWrite (0, 8, 20, 100);
+  FtwTestSetWrite (1, 9, FTW_TEST_BLOCK_SIZE + 7, 200);
+  FtwTestSetWrite (2, 8, 50, 100);
+  FtwTestSetWrite (3, 30, 0, FTW_TEST_BLOCK_SIZE / 8);
+
+  Header = (SMM_FTW_WRITE_BATCH_HEADER *)mFtwTestComm;
+  CopyGuid (&Header->CallerId, &mFtwTestCallerId);
+  Header->FvbBaseAddress = (EFI_PHYSICAL_ADDRESS)(UINTN)mFtwTestFlash;
+  Header->FvbAttributes  = FTW_TEST_ATTRIBUTES;
+  Header->NumberOfWrites = NumberOfWrites;
+  Entries                = (SMM_FTW_WRITE_BATCH_ENTRY *)Header->Data;
+  Data                   = (UINT8 *)&Entries[NumberOfWrites];
+  for (Index = 0; Index < NumberOfWrites; Index++) {
+    Entries[Index].Lba    = mFtwTestWrites[Index].Lba;
+    Entries[Index].Offset = mFtwTestWrites[Index].Offset;
+    Entries[Index].Length = mFtwTestWrites[Index].Length;
+    CopyMem (Data, mFtwTestWrites[Index].Buffer, mFtwTestWrites[Index].Length);
+    Data += mFtwTestWrites[Index].Length;
+  }
+
+  PayloadSize = Data - mFtwTestComm;
+  UT_ASSERT_TRUE (PayloadSize <= FTW_TEST_COMM_SIZE);
+
+  //
+  // The data of the last write does not fit in the payload.
+  //
+  Status = SmmFtwWriteBatch (Header, PayloadSize - 1);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_ACCESS_DENIED);
+
+  //
+  // The entries do not fit in the payload.
+  //
+  Header->NumberOfWrites = MAX_UINTN / sizeof (SMM_FTW_WRITE_BATCH_ENTRY) + 2;
+  Status                 = SmmFtwWriteBatch (Header, PayloadSize);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_ACCESS_DENIED);
+
+  Header->NumberOfWrites = (PayloadSize - OFFSET_OF (SMM_FTW_WRITE_BATCH_HEADER, Data)) / sizeof (SMM_FTW_WRITE_BATCH_ENTRY) + 1;
+  Status                 = SmmFtwWriteBatch (Header, PayloadSize);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_ACCESS_DENIED);
+
+  //
+  // The FVB is not found.
+  //
+  Header->NumberOfWrites = NumberOfWrites;
+  Header->FvbAttributes  = 0;
+  Status                 = SmmFtwWriteBatch (Header, PayloadSize);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_ABORTED);
+  UT_ASSERT_MEM_EQUAL (mFtwTestFlash + FTW_TEST_TARGET, mFtwTestModel + FTW_TEST_TARGET, FTW_TEST_TARGET_SIZE);
+
+  Header->FvbAttributes = FTW_TEST_ATTRIBUTES;
+  Status                = SmmFtwWriteBatch (Header, PayloadSize);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  FtwTestApplyWrites (NumberOfWrites, mFtwTestModel);
+  UT_ASSERT_MEM_EQUAL (mFtwTestFlash + FTW_TEST_TARGET, mFtwTestModel + FTW_TEST_TARGET, FTW_TEST_TARGET_SIZE);
+
+  //
+  // An empty batch.
+  //
+  Header->NumberOfWrites = 0;
+  Status                 = SmmFtwWriteBatch (Header, OFFSET_OF (SMM_FTW_WRITE_BATCH_HEADER, Data));
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  fault tolerant batch writes and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      BatchTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  //
+  // The driver requires the spare area to be aligned on its block size.
+  //
+  mFtwTestFlash = AllocateAlignedPages (EFI_SIZE_TO_PAGES (FTW_TEST_FLASH_SIZE), FTW_TEST_BLOCK_SIZE);
+  if (mFtwTestFlash == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&BatchTests, Framework, "Fault Tolerant Write Batch Tests", "Ftw.WriteBatch", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for Fault Tolerant Write Batch Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (BatchTests, "Writes are grouped at the spare area boundaries", "Groups", FtwTestBatchGroups, NULL, NULL, NULL);
+  AddTestCase (BatchTests, "The image of a group has the writes in order", "Apply", FtwTestApplyBatchWrites, NULL, NULL, NULL);
+  AddTestCase (BatchTests, "Writes overlapping across groups", "Overlap", FtwTestOverlapAcrossGroups, NULL, NULL, NULL);
+  AddTestCase (BatchTests, "Random batches match the reference model", "Random", FtwTestRandomBatches, NULL, NULL, NULL);
+  AddTestCase (BatchTests, "The header goes after the reclaim", "Reclaim", FtwTestAllocateAfterReclaim, NULL, NULL, NULL);
+  AddTestCase (BatchTests, "Interrupted batches are recovered by groups", "Interrupt", FtwTestInterruptedBatch, NULL, NULL, NULL);
+  AddTestCase (BatchTests, "SMI handler batch payloads", "Smm", FtwTestSmmWriteBatch, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  if (mFtwTestFlash != NULL) {
+    FreeAlignedPages (mFtwTestFlash, EFI_SIZE_TO_PAGES (FTW_TEST_FLASH_SIZE));
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define FaultTolerantWriteBatchUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+FaultTolerantWriteBatchUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
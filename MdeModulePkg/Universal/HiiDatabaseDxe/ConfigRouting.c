@@ -9,6 +9,11 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "HiiDatabase.h"
 extern HII_DATABASE_PRIVATE_DATA  mPrivate;
 
+LIST_ENTRY                   mConfigRoutingCache = INITIALIZE_LIST_HEAD_VARIABLE (mConfigRoutingCache);
+UINTN                        mConfigRoutingCacheCount;
+HII_CONFIG_CACHE_STATISTICS  mConfigRoutingCacheStatistics;
+EFI_LOCK                     mConfigRoutingCacheLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
+
 /**
   Calculate the number of Unicode characters of the incoming Configuration string,
   not including NULL terminator.
@@ -1371,6 +1376,60 @@ GetSupportedLanguages (
   return SupportedLanguages;
 }
 
+/**
+  Get the language that the strings of a package list are retrieved in: the
+  best match of the PlatformLang variable among the languages that the package
+  list supports.
+
+  @param[in]  HiiHandle  A handle that was previously registered in the HII Database.
+
+  @retval NULL   The package list has no string package, or out of resources.
+  @retval Other  The best language, allocated from pool. The caller frees it.
+
+**/
+CHAR8 *
+GetStringLanguage (
+  IN EFI_HII_HANDLE  HiiHandle
+  )
+{
+  CHAR8  *SupportedLanguages;
+  CHAR8  *PlatformLanguage;
+  CHAR8  *BestLanguage;
+
+  //
+  // Get the languages that the package specified by HiiHandle supports
+  //
+  SupportedLanguages = GetSupportedLanguages (HiiHandle);
+  if (SupportedLanguages == NULL) {
+    return NULL;
+  }
+
+  //
+  // Get the current platform language setting
+  //
+  PlatformLanguage = NULL;
+  GetEfiGlobalVariable2 (L"PlatformLang", (VOID **)&PlatformLanguage, NULL);
+
+  //
+  // Get the best matching language from SupportedLanguages
+  //
+  BestLanguage = GetBestLanguage (
+                   SupportedLanguages,
+                   FALSE,                                             // RFC 4646 mode
+                   "",                                                // Highest priority
+                   PlatformLanguage != NULL ? PlatformLanguage : "",  // Next highest priority
+                   SupportedLanguages,                                // Lowest priority
+                   NULL
+                   );
+
+  FreePool (SupportedLanguages);
+  if (PlatformLanguage != NULL) {
+    FreePool (PlatformLanguage);
+  }
+
+  return BestLanguage;
+}
+
 /**
   Retrieves a string from a string package.
 
@@ -1395,47 +1454,17 @@ InternalGetString (
   UINTN       StringSize;
   CHAR16      TempString;
   EFI_STRING  String;
-  CHAR8       *SupportedLanguages;
-  CHAR8       *PlatformLanguage;
   CHAR8       *BestLanguage;
-  CHAR8       *Language;
 
   ASSERT (HiiHandle != NULL);
   ASSERT (StringId != 0);
 
-  //
-  // Initialize all allocated buffers to NULL
-  //
-  SupportedLanguages = NULL;
-  PlatformLanguage   = NULL;
-  BestLanguage       = NULL;
-  String             = NULL;
-  Language           = "";
-
-  //
-  // Get the languages that the package specified by HiiHandle supports
-  //
-  SupportedLanguages = GetSupportedLanguages (HiiHandle);
-  if (SupportedLanguages == NULL) {
-    goto Error;
-  }
+  String = NULL;
 
   //
-  // Get the current platform language setting
+  // Get the best matching language for the current platform language setting
   //
-  GetEfiGlobalVariable2 (L"PlatformLang", (VOID **)&PlatformLanguage, NULL);
-
-  //
-  // Get the best matching language from SupportedLanguages
-  //
-  BestLanguage = GetBestLanguage (
-                   SupportedLanguages,
-                   FALSE,                                             // RFC 4646 mode
-                   Language,                                          // Highest priority
-                   PlatformLanguage != NULL ? PlatformLanguage : "",  // Next highest priority
-                   SupportedLanguages,                                // Lowest priority
-                   NULL
-                   );
+  BestLanguage = GetStringLanguage (HiiHandle);
   if (BestLanguage == NULL) {
     goto Error;
   }
@@ -1495,14 +1524,6 @@ Error:
   //
   // Free allocated buffers
   //
-  if (SupportedLanguages != NULL) {
-    FreePool (SupportedLanguages);
-  }
-
-  if (PlatformLanguage != NULL) {
-    FreePool (PlatformLanguage);
-  }
-
   if (BestLanguage != NULL) {
     FreePool (BestLanguage);
   }
@@ -4138,6 +4159,332 @@ GenerateAltConfigResp (
   return EFI_SUCCESS;
 }
 
+/**
+  Build the key of the IFR string cache for a request. The values of the
+  <BlockConfig> elements of a <ConfigResp> are removed from the key, as only
+  the offsets and widths of the elements are used to build the strings.
+
+  This is a internal function.
+
+  @param  Request                A null-terminated Unicode string in
+                                 <ConfigRequest> or <ConfigResp> format.
+
+  @return The key, or NULL if the system is out of resources.
+
+**/
+EFI_STRING
+GetConfigRoutingCacheKey (
+  IN EFI_STRING  Request
+  )
+{
+  EFI_STRING  Key;
+  EFI_STRING  Source;
+  EFI_STRING  Destination;
+  EFI_STRING  Value;
+
+  Key = AllocateCopyPool (StrSize (Request), Request);
+  if ((Key == NULL) || (StrStr (Key, L"&OFFSET=") == NULL)) {
+    return Key;
+  }
+
+  Source      = Key;
+  Destination = Key;
+  while (*Source != L'\0') {
+    if (StrnCmp (Source, L"&VALUE=", StrLen (L"&VALUE=")) == 0) {
+      //
+      // Only drop the values which GetBlockElement () accepts, so that an
+      // empty value is still reported.
+      //
+      Value = Source + StrLen (L"&VALUE=");
+      while (*Value != L'\0' && *Value != L'&') {
+        Value++;
+      }
+
+      if (Value != Source + StrLen (L"&VALUE=")) {
+        Source = Value;
+        continue;
+      }
+    }
+
+    *Destination++ = *Source++;
+  }
+
+  *Destination = L'\0';
+  return Key;
+}
+
+/**
+  Free an entry of the IFR string cache.
+
+  This is a internal function.
+
+  @param  CacheEntry             The entry, which is not in the cache anymore.
+
+**/
+VOID
+FreeConfigRoutingCacheEntry (
+  IN HII_CONFIG_CACHE_ENTRY  *CacheEntry
+  )
+{
+  if (CacheEntry->DevicePath != NULL) {
+    FreePool (CacheEntry->DevicePath);
+  }
+
+  if (CacheEntry->Request != NULL) {
+    FreePool (CacheEntry->Request);
+  }
+
+  if (CacheEntry->FullRequest != NULL) {
+    FreePool (CacheEntry->FullRequest);
+  }
+
+  if (CacheEntry->AltCfgResp != NULL) {
+    FreePool (CacheEntry->AltCfgResp);
+  }
+
+  if (CacheEntry->Language != NULL) {
+    FreePool (CacheEntry->Language);
+  }
+
+  FreePool (CacheEntry);
+}
+
+/**
+  Look up the strings built from the IFR of a package list for a request. The
+  entry found is moved to the head of the cache, which is kept in least
+  recently used order.
+
+  This is a internal function.
+
+  @param  Handle                 The HII handle of the package list.
+  @param  DevicePath             Device Path which Hii Config Access Protocol is registered.
+  @param  Key                    The key of the request, NULL if there is no request.
+  @param  Language               The language of the strings taken from the string
+                                 packages, NULL if the package list has none.
+  @param  FullRequest            Returns a copy of the request built from the IFR, or
+                                 NULL if the request was not built.
+  @param  AltCfgResp             Returns a copy of the default value string, or NULL.
+
+  @retval TRUE                   The strings are found in the cache.
+  @retval FALSE                  The strings are not in the cache, or cannot be copied.
+
+**/
+BOOLEAN
+GetConfigRoutingCacheEntry (
+  IN  EFI_HII_HANDLE            Handle,
+  IN  EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN  EFI_STRING                Key          OPTIONAL,
+  IN  CHAR8                     *Language    OPTIONAL,
+  OUT EFI_STRING                *FullRequest,
+  OUT EFI_STRING                *AltCfgResp
+  )
+{
+  LIST_ENTRY              *Link;
+  HII_CONFIG_CACHE_ENTRY  *CacheEntry;
+  UINTN                   DevicePathSize;
+  BOOLEAN                 Found;
+
+  *FullRequest   = NULL;
+  *AltCfgResp    = NULL;
+  Found          = FALSE;
+  DevicePathSize = GetDevicePathSize (DevicePath);
+
+  EfiAcquireLock (&mConfigRoutingCacheLock);
+  for (Link = mConfigRoutingCache.ForwardLink; Link != &mConfigRoutingCache; Link = Link->ForwardLink) {
+    CacheEntry = CR (Link, HII_CONFIG_CACHE_ENTRY, Entry, HII_CONFIG_CACHE_ENTRY_SIGNATURE);
+    if ((CacheEntry->Handle != Handle) ||
+        (GetDevicePathSize (CacheEntry->DevicePath) != DevicePathSize) ||
+        (CompareMem (CacheEntry->DevicePath, DevicePath, DevicePathSize) != 0))
+    {
+      continue;
+    }
+
+    if ((Key == NULL) || (CacheEntry->Request == NULL)) {
+      if (Key != CacheEntry->Request) {
+        continue;
+      }
+    } else if (StrCmp (Key, CacheEntry->Request) != 0) {
+      continue;
+    }
+
+    if ((Language == NULL) || (CacheEntry->Language == NULL)) {
+      if (Language != CacheEntry->Language) {
+        continue;
+      }
+    } else if (AsciiStrCmp (Language, CacheEntry->Language) != 0) {
+      continue;
+    }
+
+    Found = TRUE;
+    if (CacheEntry->FullRequest != NULL) {
+      *FullRequest = AllocateCopyPool (StrSize (CacheEntry->FullRequest), CacheEntry->FullRequest);
+      Found        = (BOOLEAN)(*FullRequest != NULL);
+    }
+
+    if (Found && (CacheEntry->AltCfgResp != NULL)) {
+      *AltCfgResp = AllocateCopyPool (StrSize (CacheEntry->AltCfgResp), CacheEntry->AltCfgResp);
+      Found       = (BOOLEAN)(*AltCfgResp != NULL);
+    }
+
+    RemoveEntryList (&CacheEntry->Entry);
+    InsertHeadList (&mConfigRoutingCache, &CacheEntry->Entry);
+    break;
+  }
+
+  if (Found) {
+    mConfigRoutingCacheStatistics.Hits++;
+  } else {
+    mConfigRoutingCacheStatistics.Misses++;
+    if (*FullRequest != NULL) {
+      FreePool (*FullRequest);
+      *FullRequest = NULL;
+    }
+  }
+
+  EfiReleaseLock (&mConfigRoutingCacheLock);
+  return Found;
+}
+
+/**
+  Return the time elapsed since a value of the performance counter.
+
+  This is a internal function.
+
+  @param  StartTicks             The value of the performance counter at the start.
+
+  @return The elapsed time in nanoseconds.
+
+**/
+UINT64
+GetConfigRoutingElapsedTime (
+  IN UINT64  StartTicks
+  )
+{
+  UINT64  Ticks;
+  UINT64  StartValue;
+  UINT64  EndValue;
+
+  Ticks = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&StartValue, &EndValue);
+  if (EndValue < StartValue) {
+    Ticks = StartTicks - Ticks;
+  } else {
+    Ticks = Ticks - StartTicks;
+  }
+
+  return GetTimeInNanoSecond (Ticks);
+}
+
+/**
+  Add the strings built from the IFR of a package list for a request to the
+  cache, evicting the least recently used entries when the cache is full.
+
+  This is a internal function.
+
+  @param  Handle                 The HII handle of the package list.
+  @param  DevicePath             Device Path which Hii Config Access Protocol is registered.
+  @param  Key                    The key of the request, NULL if there is no request.
+  @param  Language               The language of the strings taken from the string
+                                 packages, NULL if the package list has none.
+  @param  FullRequest            The request built from the IFR, or NULL if it
+                                 was not built.
+  @param  AltCfgResp             The default value string, or NULL.
+  @param  StartTicks             The value of the performance counter when the
+                                 IFR parsing started.
+
+**/
+VOID
+AddConfigRoutingCacheEntry (
+  IN EFI_HII_HANDLE            Handle,
+  IN EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN EFI_STRING                Key          OPTIONAL,
+  IN CHAR8                     *Language    OPTIONAL,
+  IN EFI_STRING                FullRequest  OPTIONAL,
+  IN EFI_STRING                AltCfgResp   OPTIONAL,
+  IN UINT64                    StartTicks
+  )
+{
+  HII_CONFIG_CACHE_ENTRY  *CacheEntry;
+
+  mConfigRoutingCacheStatistics.MissTime += GetConfigRoutingElapsedTime (StartTicks);
+
+  CacheEntry = AllocateZeroPool (sizeof (HII_CONFIG_CACHE_ENTRY));
+  if (CacheEntry == NULL) {
+    return;
+  }
+
+  CacheEntry->Signature  = HII_CONFIG_CACHE_ENTRY_SIGNATURE;
+  CacheEntry->Handle     = Handle;
+  CacheEntry->DevicePath = DuplicateDevicePath (DevicePath);
+  if (Key != NULL) {
+    CacheEntry->Request = AllocateCopyPool (StrSize (Key), Key);
+  }
+
+  if (Language != NULL) {
+    CacheEntry->Language = AllocateCopyPool (AsciiStrSize (Language), Language);
+  }
+
+  if (FullRequest != NULL) {
+    CacheEntry->FullRequest = AllocateCopyPool (StrSize (FullRequest), FullRequest);
+  }
+
+  if (AltCfgResp != NULL) {
+    CacheEntry->AltCfgResp = AllocateCopyPool (StrSize (AltCfgResp), AltCfgResp);
+  }
+
+  if ((CacheEntry->DevicePath == NULL) ||
+      ((Key != NULL) && (CacheEntry->Request == NULL)) ||
+      ((Language != NULL) && (CacheEntry->Language == NULL)) ||
+      ((FullRequest != NULL) && (CacheEntry->FullRequest == NULL)) ||
+      ((AltCfgResp != NULL) && (CacheEntry->AltCfgResp == NULL)))
+  {
+    FreeConfigRoutingCacheEntry (CacheEntry);
+    return;
+  }
+
+  EfiAcquireLock (&mConfigRoutingCacheLock);
+  InsertHeadList (&mConfigRoutingCache, &CacheEntry->Entry);
+  mConfigRoutingCacheCount++;
+  while (mConfigRoutingCacheCount > PcdGet32 (PcdHiiConfigRoutingCacheEntries)) {
+    CacheEntry = CR (mConfigRoutingCache.BackLink, HII_CONFIG_CACHE_ENTRY, Entry, HII_CONFIG_CACHE_ENTRY_SIGNATURE);
+    RemoveEntryList (&CacheEntry->Entry);
+    mConfigRoutingCacheCount--;
+    FreeConfigRoutingCacheEntry (CacheEntry);
+  }
+
+  EfiReleaseLock (&mConfigRoutingCacheLock);
+}
+
+/**
+  Drop the strings built from the IFR of a package list. It is called whenever
+  the packages of the package list change.
+
+  @param  Handle                 The HII handle of the package list.
+
+**/
+VOID
+InvalidateConfigRoutingCache (
+  IN EFI_HII_HANDLE  Handle
+  )
+{
+  LIST_ENTRY              *Link;
+  HII_CONFIG_CACHE_ENTRY  *CacheEntry;
+
+  EfiAcquireLock (&mConfigRoutingCacheLock);
+  Link = mConfigRoutingCache.ForwardLink;
+  while (Link != &mConfigRoutingCache) {
+    CacheEntry = CR (Link, HII_CONFIG_CACHE_ENTRY, Entry, HII_CONFIG_CACHE_ENTRY_SIGNATURE);
+    Link       = Link->ForwardLink;
+    if (CacheEntry->Handle == Handle) {
+      RemoveEntryList (&CacheEntry->Entry);
+      mConfigRoutingCacheCount--;
+      FreeConfigRoutingCacheEntry (CacheEntry);
+    }
+  }
+
+  EfiReleaseLock (&mConfigRoutingCacheLock);
+}
+
 /**
   This function gets the full request string and full default value string by
   parsing IFR data in HII form packages.
@@ -4204,6 +4551,11 @@ GetFullStringFromHiiFormPackages (
   EFI_STRING           ConfigHdr;
   EFI_STRING           StringPtr;
   EFI_STRING           Progress;
+  BOOLEAN              Cacheable;
+  EFI_STRING           CacheKey;
+  CHAR8                *CacheLanguage;
+  EFI_STRING           CachedRequest;
+  UINT64               StartTicks;
 
   if ((DataBaseRecord == NULL) || (DevicePath == NULL) || (Request == NULL) || (AltCfgResp == NULL)) {
     return EFI_INVALID_PARAMETER;
@@ -4220,6 +4572,42 @@ GetFullStringFromHiiFormPackages (
   HiiFormPackage    = NULL;
   PackageSize       = 0;
   Progress          = *Request;
+  CacheKey          = NULL;
+  CacheLanguage     = NULL;
+  StartTicks        = 0;
+
+  //
+  // The strings depend on the IFR of the package list and on the request, but
+  // also on the platform language: string defaults and the names of name/value
+  // varstores are taken from the string packages in the best language for
+  // PlatformLang. All three are part of the key the cache is looked up with.
+  //
+  Cacheable = FALSE;
+  if (PcdGet32 (PcdHiiConfigRoutingCacheEntries) != 0) {
+    if (*Request != NULL) {
+      CacheKey = GetConfigRoutingCacheKey (*Request);
+    }
+
+    Cacheable     = (BOOLEAN)((*Request == NULL) || (CacheKey != NULL));
+    CacheLanguage = GetStringLanguage (DataBaseRecord->Handle);
+  }
+
+  if (Cacheable) {
+    if (GetConfigRoutingCacheEntry (DataBaseRecord->Handle, DevicePath, CacheKey, CacheLanguage, &CachedRequest, &DefaultAltCfgResp)) {
+      if (CachedRequest != NULL) {
+        if (*Request != NULL) {
+          FreePool (*Request);
+        }
+
+        *Request = CachedRequest;
+      }
+
+      Status = EFI_SUCCESS;
+      goto MergeDefault;
+    }
+
+    StartTicks = GetPerformanceCounter ();
+  }
 
   Status = GetFormPackageData (DataBaseRecord, &HiiFormPackage, &PackageSize);
   if (EFI_ERROR (Status)) {
@@ -4336,6 +4724,10 @@ GetFullStringFromHiiFormPackages (
   // No requested varstore in IFR data and directly return
   //
   if ((VarStorageData->Type == 0) && (VarStorageData->Name == NULL)) {
+    if (Cacheable) {
+      AddConfigRoutingCacheEntry (DataBaseRecord->Handle, DevicePath, CacheKey, CacheLanguage, NULL, NULL, StartTicks);
+    }
+
     Status = EFI_SUCCESS;
     goto Done;
   }
@@ -4350,6 +4742,10 @@ GetFullStringFromHiiFormPackages (
 
   if (RequestBlockArray == NULL) {
     if (!GenerateConfigRequest (ConfigHdr, VarStorageData, &Status, Request)) {
+      if (Cacheable && !EFI_ERROR (Status)) {
+        AddConfigRoutingCacheEntry (DataBaseRecord->Handle, DevicePath, CacheKey, CacheLanguage, NULL, NULL, StartTicks);
+      }
+
       goto Done;
     }
   }
@@ -4364,6 +4760,19 @@ GetFullStringFromHiiFormPackages (
     goto Done;
   }
 
+  if (Cacheable) {
+    AddConfigRoutingCacheEntry (
+      DataBaseRecord->Handle,
+      DevicePath,
+      CacheKey,
+      CacheLanguage,
+      (RequestBlockArray == NULL) ? *Request : NULL,
+      DefaultAltCfgResp,
+      StartTicks
+      );
+  }
+
+MergeDefault:
   //
   // 5. Merge string into the input AltCfgResp if the input *AltCfgResp is not NULL.
   //
@@ -4450,6 +4859,14 @@ Done:
     FreePool (HiiFormPackage);
   }
 
+  if (CacheKey != NULL) {
+    FreePool (CacheKey);
+  }
+
+  if (CacheLanguage != NULL) {
+    FreePool (CacheLanguage);
+  }
+
   if (PointerProgress != NULL) {
     if (*Request == NULL) {
       *PointerProgress = NULL;
@@ -5400,6 +5817,15 @@ HiiConfigRoutingExportConfig (
 
   FreePool (ConfigAccessHandles);
 
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: IFR string cache %ld hits, %ld misses, %ld us parsing IFR\n",
+    __func__,
+    mConfigRoutingCacheStatistics.Hits,
+    mConfigRoutingCacheStatistics.Misses,
+    DivU64x32 (mConfigRoutingCacheStatistics.MissTime, 1000)
+    ));
+
   return EFI_SUCCESS;
 }
 
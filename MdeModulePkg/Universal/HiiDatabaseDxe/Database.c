@@ -186,6 +186,22 @@ InvokeRegisteredFunction (
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // The strings built from the IFR of the package list may change with its packages.
+  //
+  if (NotifyType != EFI_HII_DATABASE_NOTIFY_EXPORT_PACK) {
+    InvalidateConfigRoutingCache (Handle);
+  }
+
+  //
+  // The glyphs of a character may come from another font package now.
+  //
+  if ((NotifyType != EFI_HII_DATABASE_NOTIFY_EXPORT_PACK) &&
+      ((PackageType == EFI_HII_PACKAGE_FONTS) || (PackageType == EFI_HII_PACKAGE_SIMPLE_FONTS)))
+  {
+    InvalidateGlyphCache ();
+  }
+
   Buffer  = NULL;
   Package = NULL;
 
@@ -1536,6 +1552,7 @@ AdjustStringPackage (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      InvalidateStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock                  = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Skip2BlockSize;
@@ -1676,6 +1693,7 @@ RemoveStringPackages (
 
     RemoveEntryList (&Package->StringEntry);
     PackageList->PackageListHdr.PackageLength -= Package->StringPkgHdr->Header.Length;
+    InvalidateStringIndex (Package);
     FreePool (Package->StringBlock);
     FreePool (Package->StringPkgHdr);
     //
@@ -3748,6 +3766,8 @@ HiiRemovePackageList (
       //
       RemoveEntryList (&Node->DatabaseEntry);
 
+      InvalidateConfigRoutingCache (Handle);
+
       HiiHandle = (HII_HANDLE *)Handle;
       RemoveEntryList (&HiiHandle->Handle);
       Private->HiiHandleCount--;
@@ -31,6 +31,13 @@ EFI_GRAPHICS_OUTPUT_BLT_PIXEL  mHiiEfiColors[16] = {
   { 0xff, 0xff, 0xff, 0x00 },  // WHITE
 };
 
+//
+// The glyphs looked up by GetGlyphBuffer(), hashed by character.
+//
+LIST_ENTRY  mGlyphCache[HII_GLYPH_CACHE_BUCKETS];
+UINTN       mGlyphCacheCount;
+BOOLEAN     mGlyphCacheInitialized;
+
 /**
   Insert a character cell information to the list specified by GlyphInfoList.
 
@@ -128,33 +135,30 @@ GetCell (
 }
 
 /**
-  Convert the glyph for a single character into a bitmap.
+  Search the simple font packages of the database for the glyph of a character.
 
   This is a internal function.
 
   @param  Private                 HII database driver private data.
   @param  Char                    Character to retrieve.
-  @param  StringInfo              Points to the string font and color information
-                                  or NULL  if the string should use the default
-                                  system font and color.
   @param  GlyphBuffer             Buffer to store the retrieved bitmap data.
   @param  Cell                    Points to EFI_HII_GLYPH_INFO structure.
-  @param  Attributes              If not NULL, output the glyph attributes if any.
+  @param  Attributes              Output the glyph attributes.
+  @param  GlyphBufferLen          Output the length of GlyphBuffer.
 
   @retval EFI_SUCCESS             Glyph bitmap outputted.
   @retval EFI_OUT_OF_RESOURCES    Unable to allocate the output buffer GlyphBuffer.
   @retval EFI_NOT_FOUND           The glyph was unknown can not be found.
-  @retval EFI_INVALID_PARAMETER   Any input parameter is invalid.
 
 **/
 EFI_STATUS
-GetGlyphBuffer (
+GetSimpleFontGlyph (
   IN  HII_DATABASE_PRIVATE_DATA  *Private,
   IN  CHAR16                     Char,
-  IN  EFI_FONT_INFO              *StringInfo,
   OUT UINT8                      **GlyphBuffer,
   OUT EFI_HII_GLYPH_INFO         *Cell,
-  OUT UINT8                      *Attributes OPTIONAL
+  OUT UINT8                      *Attributes,
+  OUT UINTN                      *GlyphBufferLen
   )
 {
   HII_DATABASE_RECORD               *Node;
@@ -164,11 +168,232 @@ GetGlyphBuffer (
   UINT16                            Index;
   EFI_NARROW_GLYPH                  Narrow;
   EFI_WIDE_GLYPH                    Wide;
-  HII_GLOBAL_FONT_INFO              *GlobalFont;
   UINTN                             HeaderSize;
   EFI_NARROW_GLYPH                  *NarrowPtr;
   EFI_WIDE_GLYPH                    *WidePtr;
 
+  HeaderSize = sizeof (EFI_HII_SIMPLE_FONT_PACKAGE_HDR);
+
+  for (Link = Private->DatabaseList.ForwardLink; Link != &Private->DatabaseList; Link = Link->ForwardLink) {
+    Node = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
+    for (Link1 = Node->PackageList->SimpleFontPkgHdr.ForwardLink;
+         Link1 != &Node->PackageList->SimpleFontPkgHdr;
+         Link1 = Link1->ForwardLink
+         )
+    {
+      SimpleFont = CR (Link1, HII_SIMPLE_FONT_PACKAGE_INSTANCE, SimpleFontEntry, HII_S_FONT_PACKAGE_SIGNATURE);
+      //
+      // Search the narrow glyph array
+      //
+      NarrowPtr = (EFI_NARROW_GLYPH *)((UINT8 *)(SimpleFont->SimpleFontPkgHdr) + HeaderSize);
+      for (Index = 0; Index < SimpleFont->SimpleFontPkgHdr->NumberOfNarrowGlyphs; Index++) {
+        CopyMem (&Narrow, NarrowPtr + Index, sizeof (EFI_NARROW_GLYPH));
+        if (Narrow.UnicodeWeight == Char) {
+          *GlyphBuffer = (UINT8 *)AllocateZeroPool (EFI_GLYPH_HEIGHT);
+          if (*GlyphBuffer == NULL) {
+            return EFI_OUT_OF_RESOURCES;
+          }
+
+          Cell->Width    = EFI_GLYPH_WIDTH;
+          Cell->Height   = EFI_GLYPH_HEIGHT;
+          Cell->AdvanceX = Cell->Width;
+          CopyMem (*GlyphBuffer, Narrow.GlyphCol1, Cell->Height);
+          *Attributes     = (UINT8)(Narrow.Attributes | NARROW_GLYPH);
+          *GlyphBufferLen = EFI_GLYPH_HEIGHT;
+          return EFI_SUCCESS;
+        }
+      }
+
+      //
+      // Search the wide glyph array
+      //
+      WidePtr = (EFI_WIDE_GLYPH *)(NarrowPtr + SimpleFont->SimpleFontPkgHdr->NumberOfNarrowGlyphs);
+      for (Index = 0; Index < SimpleFont->SimpleFontPkgHdr->NumberOfWideGlyphs; Index++) {
+        CopyMem (&Wide, WidePtr + Index, sizeof (EFI_WIDE_GLYPH));
+        if (Wide.UnicodeWeight == Char) {
+          *GlyphBuffer = (UINT8 *)AllocateZeroPool (EFI_GLYPH_HEIGHT * 2);
+          if (*GlyphBuffer == NULL) {
+            return EFI_OUT_OF_RESOURCES;
+          }
+
+          Cell->Width    = EFI_GLYPH_WIDTH * 2;
+          Cell->Height   = EFI_GLYPH_HEIGHT;
+          Cell->AdvanceX = Cell->Width;
+          CopyMem (*GlyphBuffer, Wide.GlyphCol1, EFI_GLYPH_HEIGHT);
+          CopyMem (*GlyphBuffer + EFI_GLYPH_HEIGHT, Wide.GlyphCol2, EFI_GLYPH_HEIGHT);
+          *Attributes     = (UINT8)(Wide.Attributes | EFI_GLYPH_WIDE);
+          *GlyphBufferLen = EFI_GLYPH_HEIGHT * 2;
+          return EFI_SUCCESS;
+        }
+      }
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Return the list of the glyph cache which a character is hashed to.
+
+  This is a internal function.
+
+  @param  Char                    The character.
+
+  @return The head of the list.
+
+**/
+LIST_ENTRY *
+GetGlyphCacheBucket (
+  IN CHAR16  Char
+  )
+{
+  UINTN  Index;
+
+  if (!mGlyphCacheInitialized) {
+    for (Index = 0; Index < HII_GLYPH_CACHE_BUCKETS; Index++) {
+      InitializeListHead (&mGlyphCache[Index]);
+    }
+
+    mGlyphCacheInitialized = TRUE;
+  }
+
+  return &mGlyphCache[Char % HII_GLYPH_CACHE_BUCKETS];
+}
+
+/**
+  Add the result of a glyph lookup to the glyph cache. When the cache is full,
+  it is emptied first.
+
+  This is a internal function.
+
+  @param  FontPackage             The font package searched, NULL for the simple
+                                  font packages.
+  @param  Char                    The character.
+  @param  Status                  EFI_SUCCESS if the glyph is found, EFI_NOT_FOUND
+                                  otherwise.
+  @param  GlyphBuffer             The bitmap data of the glyph, or NULL.
+  @param  BufferLen               The length of GlyphBuffer.
+  @param  Cell                    The cell information of the glyph. It is not
+                                  used when Status is EFI_NOT_FOUND.
+  @param  Attributes              The attributes of the glyph.
+
+**/
+VOID
+AddGlyphCacheEntry (
+  IN HII_FONT_PACKAGE_INSTANCE   *FontPackage OPTIONAL,
+  IN CHAR16                      Char,
+  IN EFI_STATUS                  Status,
+  IN UINT8                       *GlyphBuffer OPTIONAL,
+  IN UINTN                       BufferLen,
+  IN CONST EFI_HII_GLYPH_INFO    *Cell,
+  IN UINT8                       Attributes
+  )
+{
+  HII_GLYPH_CACHE_ENTRY  *CacheEntry;
+
+  if (GlyphBuffer == NULL) {
+    BufferLen = 0;
+  }
+
+  if (mGlyphCacheCount >= HII_GLYPH_CACHE_MAX_ENTRIES) {
+    InvalidateGlyphCache ();
+  }
+
+  CacheEntry = AllocatePool (sizeof (HII_GLYPH_CACHE_ENTRY) + BufferLen);
+  if (CacheEntry == NULL) {
+    return;
+  }
+
+  CacheEntry->Signature   = HII_GLYPH_CACHE_ENTRY_SIGNATURE;
+  CacheEntry->FontPackage = FontPackage;
+  CacheEntry->Char        = Char;
+  CacheEntry->Status      = Status;
+  CacheEntry->Attributes  = Attributes;
+  CacheEntry->BufferLen   = BufferLen;
+  CacheEntry->GlyphBuffer = (UINT8 *)(CacheEntry + 1);
+  if (Status == EFI_SUCCESS) {
+    CopyMem (&CacheEntry->Cell, Cell, sizeof (EFI_HII_GLYPH_INFO));
+  } else {
+    ZeroMem (&CacheEntry->Cell, sizeof (EFI_HII_GLYPH_INFO));
+  }
+
+  CopyMem (CacheEntry->GlyphBuffer, GlyphBuffer, BufferLen);
+
+  InsertHeadList (GetGlyphCacheBucket (Char), &CacheEntry->Entry);
+  mGlyphCacheCount++;
+}
+
+/**
+  Drop all the glyphs cached by GetGlyphBuffer(). It is called whenever a font
+  or simple font package is added to or removed from the database.
+
+**/
+VOID
+InvalidateGlyphCache (
+  VOID
+  )
+{
+  UINTN                  Index;
+  HII_GLYPH_CACHE_ENTRY  *CacheEntry;
+
+  if (!mGlyphCacheInitialized) {
+    return;
+  }
+
+  for (Index = 0; Index < HII_GLYPH_CACHE_BUCKETS; Index++) {
+    while (!IsListEmpty (&mGlyphCache[Index])) {
+      CacheEntry = CR (mGlyphCache[Index].ForwardLink, HII_GLYPH_CACHE_ENTRY, Entry, HII_GLYPH_CACHE_ENTRY_SIGNATURE);
+      RemoveEntryList (&CacheEntry->Entry);
+      FreePool (CacheEntry);
+    }
+  }
+
+  mGlyphCacheCount = 0;
+}
+
+/**
+  Convert the glyph for a single character into a bitmap.
+
+  The glyphs found, and the characters without glyph, are kept in a cache, as
+  finding a glyph in the font packages walks all the glyphs before it.
+
+  This is a internal function.
+
+  @param  Private                 HII database driver private data.
+  @param  Char                    Character to retrieve.
+  @param  StringInfo              Points to the string font and color information
+                                  or NULL  if the string should use the default
+                                  system font and color.
+  @param  GlyphBuffer             Buffer to store the retrieved bitmap data.
+  @param  Cell                    Points to EFI_HII_GLYPH_INFO structure.
+  @param  Attributes              If not NULL, output the glyph attributes if any.
+
+  @retval EFI_SUCCESS             Glyph bitmap outputted.
+  @retval EFI_OUT_OF_RESOURCES    Unable to allocate the output buffer GlyphBuffer.
+  @retval EFI_NOT_FOUND           The glyph was unknown can not be found.
+  @retval EFI_INVALID_PARAMETER   Any input parameter is invalid.
+
+**/
+EFI_STATUS
+GetGlyphBuffer (
+  IN  HII_DATABASE_PRIVATE_DATA  *Private,
+  IN  CHAR16                     Char,
+  IN  EFI_FONT_INFO              *StringInfo,
+  OUT UINT8                      **GlyphBuffer,
+  OUT EFI_HII_GLYPH_INFO         *Cell,
+  OUT UINT8                      *Attributes OPTIONAL
+  )
+{
+  EFI_STATUS                 Status;
+  HII_GLOBAL_FONT_INFO       *GlobalFont;
+  HII_FONT_PACKAGE_INSTANCE  *FontPackage;
+  LIST_ENTRY                 *Bucket;
+  LIST_ENTRY                 *Link;
+  HII_GLYPH_CACHE_ENTRY      *CacheEntry;
+  UINT8                      *Buffer;
+  UINTN                      BufferLen;
+  UINT8                      GlyphAttributes;
+
   if ((GlyphBuffer == NULL) || (Cell == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
@@ -185,80 +410,62 @@ GetGlyphBuffer (
   // If NULL, try to find the character in simplified font packages since
   // default system font is the fixed font (narrow or wide glyph).
   //
+  FontPackage = NULL;
   if (StringInfo != NULL) {
     if (!IsFontInfoExisted (Private, StringInfo, NULL, NULL, &GlobalFont)) {
       return EFI_INVALID_PARAMETER;
     }
 
+    FontPackage = GlobalFont->FontPackage;
+  }
+
+  Bucket = GetGlyphCacheBucket (Char);
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    CacheEntry = CR (Link, HII_GLYPH_CACHE_ENTRY, Entry, HII_GLYPH_CACHE_ENTRY_SIGNATURE);
+    if ((CacheEntry->Char != Char) || (CacheEntry->FontPackage != FontPackage)) {
+      continue;
+    }
+
+    if (CacheEntry->BufferLen > 0) {
+      *GlyphBuffer = AllocateCopyPool (CacheEntry->BufferLen, CacheEntry->GlyphBuffer);
+      if (*GlyphBuffer == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+    }
+
+    CopyMem (Cell, &CacheEntry->Cell, sizeof (EFI_HII_GLYPH_INFO));
     if (Attributes != NULL) {
-      *Attributes = PROPORTIONAL_GLYPH;
+      *Attributes = CacheEntry->Attributes;
     }
 
-    return FindGlyphBlock (GlobalFont->FontPackage, Char, GlyphBuffer, Cell, NULL);
-  } else {
-    HeaderSize = sizeof (EFI_HII_SIMPLE_FONT_PACKAGE_HDR);
-
-    for (Link = Private->DatabaseList.ForwardLink; Link != &Private->DatabaseList; Link = Link->ForwardLink) {
-      Node = CR (Link, HII_DATABASE_RECORD, DatabaseEntry, HII_DATABASE_RECORD_SIGNATURE);
-      for (Link1 = Node->PackageList->SimpleFontPkgHdr.ForwardLink;
-           Link1 != &Node->PackageList->SimpleFontPkgHdr;
-           Link1 = Link1->ForwardLink
-           )
-      {
-        SimpleFont = CR (Link1, HII_SIMPLE_FONT_PACKAGE_INSTANCE, SimpleFontEntry, HII_S_FONT_PACKAGE_SIGNATURE);
-        //
-        // Search the narrow glyph array
-        //
-        NarrowPtr = (EFI_NARROW_GLYPH *)((UINT8 *)(SimpleFont->SimpleFontPkgHdr) + HeaderSize);
-        for (Index = 0; Index < SimpleFont->SimpleFontPkgHdr->NumberOfNarrowGlyphs; Index++) {
-          CopyMem (&Narrow, NarrowPtr + Index, sizeof (EFI_NARROW_GLYPH));
-          if (Narrow.UnicodeWeight == Char) {
-            *GlyphBuffer = (UINT8 *)AllocateZeroPool (EFI_GLYPH_HEIGHT);
-            if (*GlyphBuffer == NULL) {
-              return EFI_OUT_OF_RESOURCES;
-            }
+    return CacheEntry->Status;
+  }
 
-            Cell->Width    = EFI_GLYPH_WIDTH;
-            Cell->Height   = EFI_GLYPH_HEIGHT;
-            Cell->AdvanceX = Cell->Width;
-            CopyMem (*GlyphBuffer, Narrow.GlyphCol1, Cell->Height);
-            if (Attributes != NULL) {
-              *Attributes = (UINT8)(Narrow.Attributes | NARROW_GLYPH);
-            }
+  Buffer          = NULL;
+  BufferLen       = 0;
+  GlyphAttributes = 0;
+  if (FontPackage != NULL) {
+    GlyphAttributes = PROPORTIONAL_GLYPH;
+    Status          = FindGlyphBlock (FontPackage, Char, &Buffer, Cell, &BufferLen);
+  } else {
+    Status = GetSimpleFontGlyph (Private, Char, &Buffer, Cell, &GlyphAttributes, &BufferLen);
+  }
 
-            return EFI_SUCCESS;
-          }
-        }
+  if ((Status != EFI_SUCCESS) && (Status != EFI_NOT_FOUND)) {
+    return Status;
+  }
 
-        //
-        // Search the wide glyph array
-        //
-        WidePtr = (EFI_WIDE_GLYPH *)(NarrowPtr + SimpleFont->SimpleFontPkgHdr->NumberOfNarrowGlyphs);
-        for (Index = 0; Index < SimpleFont->SimpleFontPkgHdr->NumberOfWideGlyphs; Index++) {
-          CopyMem (&Wide, WidePtr + Index, sizeof (EFI_WIDE_GLYPH));
-          if (Wide.UnicodeWeight == Char) {
-            *GlyphBuffer = (UINT8 *)AllocateZeroPool (EFI_GLYPH_HEIGHT * 2);
-            if (*GlyphBuffer == NULL) {
-              return EFI_OUT_OF_RESOURCES;
-            }
+  AddGlyphCacheEntry (FontPackage, Char, Status, Buffer, BufferLen, Cell, GlyphAttributes);
 
-            Cell->Width    = EFI_GLYPH_WIDTH * 2;
-            Cell->Height   = EFI_GLYPH_HEIGHT;
-            Cell->AdvanceX = Cell->Width;
-            CopyMem (*GlyphBuffer, Wide.GlyphCol1, EFI_GLYPH_HEIGHT);
-            CopyMem (*GlyphBuffer + EFI_GLYPH_HEIGHT, Wide.GlyphCol2, EFI_GLYPH_HEIGHT);
-            if (Attributes != NULL) {
-              *Attributes = (UINT8)(Wide.Attributes | EFI_GLYPH_WIDE);
-            }
+  if (Buffer != NULL) {
+    *GlyphBuffer = Buffer;
+  }
 
-            return EFI_SUCCESS;
-          }
-        }
-      }
-    }
+  if (Attributes != NULL) {
+    *Attributes = GlyphAttributes;
   }
 
-  return EFI_NOT_FOUND;
+  return Status;
 }
 
 /**
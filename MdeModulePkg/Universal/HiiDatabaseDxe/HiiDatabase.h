@@ -40,6 +40,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/PcdLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/PrintLib.h>
+#include <Library/TimerLib.h>
 
 #define MAX_STRING_LENGTH      1024
 #define MAX_FONT_NAME_LEN      256
@@ -112,6 +113,30 @@ typedef struct {
   EFI_IFR_TYPE_VALUE    Value;
 } IFR_DEFAULT_DATA;
 
+//
+// Strings built from the IFR of a package list by GetFullStringFromHiiFormPackages (),
+// kept until the packages of the package list change. They are looked up by handle,
+// device path, request and the language that the string packages were read in.
+//
+#define HII_CONFIG_CACHE_ENTRY_SIGNATURE  SIGNATURE_32 ('H', 'c', 'c', 'e')
+
+typedef struct {
+  UINTN                       Signature;
+  LIST_ENTRY                  Entry;
+  EFI_HII_HANDLE              Handle;
+  EFI_DEVICE_PATH_PROTOCOL    *DevicePath;
+  EFI_STRING                  Request;       // input request without values, NULL if none
+  EFI_STRING                  FullRequest;   // request built from the IFR, NULL if not built
+  EFI_STRING                  AltCfgResp;    // default value string, NULL if none
+  CHAR8                       *Language;     // language of the strings taken from string packages
+} HII_CONFIG_CACHE_ENTRY;
+
+typedef struct {
+  UINT64    Hits;
+  UINT64    Misses;
+  UINT64    MissTime;                        // nanoseconds spent parsing the IFR on misses
+} HII_CONFIG_CACHE_STATISTICS;
+
 //
 // Storage types
 //
@@ -150,6 +175,16 @@ typedef struct {
 // String Package definitions
 //
 #define HII_STRING_PACKAGE_SIGNATURE  SIGNATURE_32 ('h','i','s','p')
+
+//
+// Location of the text of a string in the string blocks. TextOffset is 0 for the
+// string IDs which are not indexed, such as the IDs of the skip blocks.
+//
+typedef struct {
+  UINT32    BlockOffset;                               // offset of the string block from StringBlock
+  UINT32    TextOffset;                                // offset of the string text from the string block
+} HII_STRING_INDEX_ENTRY;
+
 typedef struct _HII_STRING_PACKAGE_INSTANCE {
   UINTN                         Signature;
   EFI_HII_STRING_PACKAGE_HDR    *StringPkgHdr;
@@ -158,6 +193,8 @@ typedef struct _HII_STRING_PACKAGE_INSTANCE {
   LIST_ENTRY                    FontInfoList;          // local font info list
   UINT8                         FontId;
   EFI_STRING_ID                 MaxStringId;           // record StringId
+  HII_STRING_INDEX_ENTRY        *StringIndex;          // built on first lookup, indexed by StringId
+  UINTN                         StringIndexCount;
 } HII_STRING_PACKAGE_INSTANCE;
 
 //
@@ -220,6 +257,25 @@ typedef struct _HII_GLOBAL_FONT_INFO {
   EFI_FONT_INFO                *FontInfo;
 } HII_GLOBAL_FONT_INFO;
 
+//
+// Glyph cache definitions
+//
+#define HII_GLYPH_CACHE_ENTRY_SIGNATURE  SIGNATURE_32 ('h','g','c','e')
+#define HII_GLYPH_CACHE_BUCKETS          64
+#define HII_GLYPH_CACHE_MAX_ENTRIES      1024
+
+typedef struct _HII_GLYPH_CACHE_ENTRY {
+  UINTN                        Signature;
+  LIST_ENTRY                   Entry;
+  HII_FONT_PACKAGE_INSTANCE    *FontPackage; // NULL for the simple font packages
+  CHAR16                       Char;
+  EFI_STATUS                   Status;       // EFI_NOT_FOUND if there is no glyph
+  EFI_HII_GLYPH_INFO           Cell;
+  UINT8                        Attributes;
+  UINTN                        BufferLen;
+  UINT8                        *GlyphBuffer; // follows the entry
+} HII_GLYPH_CACHE_ENTRY;
+
 //
 // Image Package definitions
 //
@@ -503,6 +559,8 @@ GetSystemFont (
   within this string package and backup its information. If LastStringId is
   specified, the string id of last string block will also be output.
   If StringId = 0, output the string id of last string block (EFI_HII_SIBT_STRING).
+  A string block of a valid StringId is looked up in the string index of the
+  package when StartStringId is NULL, the index being built on first use.
 
   @param  Private                 Hii database private structure.
   @param  StringPackage           Hii string package instance.
@@ -535,6 +593,85 @@ FindStringBlock (
   OUT EFI_STRING_ID                *StartStringId OPTIONAL
   );
 
+/**
+  Parse all string blocks to get a string specified by StringId.
+
+  This is a internal function.
+
+  @param  Private                Hii database private structure.
+  @param  StringPackage          Hii string package instance.
+  @param  StringId               The string's id, which is unique within
+                                 PackageList.
+  @param  String                 Points to retrieved null-terminated string.
+  @param  StringSize             On entry, points to the size of the buffer pointed
+                                 to by String, in bytes. On return, points to the
+                                 length of the string, in bytes.
+  @param  StringFontInfo         If not NULL, allocate a buffer to record the
+                                 output font info. It's caller's responsibility to
+                                 free this buffer.
+
+  @retval EFI_SUCCESS            The string text and font is retrieved
+                                 successfully.
+  @retval EFI_NOT_FOUND          The specified text or font info can not be found
+                                 out.
+  @retval EFI_BUFFER_TOO_SMALL   The buffer specified by StringSize is too small to
+                                 hold the string.
+
+**/
+EFI_STATUS
+GetStringWorker (
+  IN HII_DATABASE_PRIVATE_DATA     *Private,
+  IN  HII_STRING_PACKAGE_INSTANCE  *StringPackage,
+  IN  EFI_STRING_ID                StringId,
+  OUT EFI_STRING                   String,
+  IN  OUT UINTN                    *StringSize  OPTIONAL,
+  OUT EFI_FONT_INFO                **StringFontInfo OPTIONAL
+  );
+
+/**
+  Parse all string blocks to set a String specified by StringId.
+
+  This is a internal function.
+
+  @param  Private                HII database driver private structure.
+  @param  StringPackage          HII string package instance.
+  @param  StringId               The string's id, which is unique within
+                                 PackageList.
+  @param  String                 Points to the new null-terminated string.
+  @param  StringFontInfo         Points to the input font info.
+
+  @retval EFI_SUCCESS            The string was updated successfully.
+  @retval EFI_NOT_FOUND          The string specified by StringId is not in the
+                                 database.
+  @retval EFI_INVALID_PARAMETER  The String or Language was NULL.
+  @retval EFI_INVALID_PARAMETER  The specified StringFontInfo does not exist in
+                                 current database.
+  @retval EFI_OUT_OF_RESOURCES   The system is out of resources to accomplish the
+                                 task.
+
+**/
+EFI_STATUS
+SetStringWorker (
+  IN  HII_DATABASE_PRIVATE_DATA       *Private,
+  IN OUT HII_STRING_PACKAGE_INSTANCE  *StringPackage,
+  IN  EFI_STRING_ID                   StringId,
+  IN  EFI_STRING                      String,
+  IN  EFI_FONT_INFO                   *StringFontInfo OPTIONAL
+  );
+
+/**
+  Free the string index of a string package. It must be called whenever the
+  string blocks of the package are changed; the index is rebuilt on the next
+  lookup of a string.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+InvalidateStringIndex (
+  IN  HII_STRING_PACKAGE_INSTANCE  *StringPackage
+  );
+
 /**
   Parse all glyph blocks to find a glyph block specified by CharValue.
   If CharValue = (CHAR16) (-1), collect all default character cell information
@@ -565,6 +702,16 @@ FindGlyphBlock (
   OUT UINTN                      *GlyphBufferLen OPTIONAL
   );
 
+/**
+  Drop all the glyphs cached by GetGlyphBuffer(). It is called whenever a font
+  or simple font package is added to or removed from the database.
+
+**/
+VOID
+InvalidateGlyphCache (
+  VOID
+  );
+
 /**
   This function exports Form packages to a buffer.
   This is a internal function.
@@ -1898,6 +2045,18 @@ HiiConfigRoutingExportConfig (
   OUT EFI_STRING                             *Results
   );
 
+/**
+  Drop the strings built from the IFR of a package list. It is called whenever
+  the packages of the package list change.
+
+  @param  Handle                 The HII handle of the package list.
+
+**/
+VOID
+InvalidateConfigRoutingCache (
+  IN EFI_HII_HANDLE  Handle
+  );
+
 /**
   This function processes the results of processing forms and routes it to the
   appropriate handlers or storage.
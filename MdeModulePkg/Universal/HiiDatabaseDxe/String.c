@@ -225,12 +225,264 @@ GetStringFontInfo (
   return EFI_NOT_FOUND;
 }
 
+/**
+  Free the string index of a string package. It must be called whenever the
+  string blocks of the package are changed; the index is rebuilt on the next
+  lookup of a string.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+InvalidateStringIndex (
+  IN  HII_STRING_PACKAGE_INSTANCE  *StringPackage
+  )
+{
+  if (StringPackage->StringIndex != NULL) {
+    FreePool (StringPackage->StringIndex);
+    StringPackage->StringIndex      = NULL;
+    StringPackage->StringIndexCount = 0;
+  }
+}
+
+/**
+  Record the location of the text of a string in the string index.
+
+  This is a internal function.
+
+  @param  Index                   The string index.
+  @param  Count                   The number of entries of Index.
+  @param  StringId                The string's id.
+  @param  BlockOffset             Offset of the string block from the first block.
+  @param  TextOffset              Offset of the string text from the string block.
+
+**/
+STATIC
+VOID
+SetStringIndexEntry (
+  IN OUT HII_STRING_INDEX_ENTRY  *Index,
+  IN     UINTN                   Count,
+  IN     UINTN                   StringId,
+  IN     UINTN                   BlockOffset,
+  IN     UINTN                   TextOffset
+  )
+{
+  if (StringId < Count) {
+    Index[StringId].BlockOffset = (UINT32)BlockOffset;
+    Index[StringId].TextOffset  = (UINT32)TextOffset;
+  }
+}
+
+/**
+  Parse all string blocks once to record where the text of each string ID of
+  the string package is. The IDs of EFI_HII_SIBT_DUPLICATE blocks are recorded
+  with the location of the string they duplicate. The IDs of skip blocks are
+  left out, so their lookup goes through FindStringBlock parsing the blocks,
+  which also outputs the skip block for the callers inserting a string there.
+
+  This is a internal function.
+
+  @param  StringPackage           Hii string package instance.
+
+  @retval EFI_SUCCESS             The string index is built.
+  @retval EFI_UNSUPPORTED         The string blocks contain an unknown block type.
+  @retval EFI_OUT_OF_RESOURCES    The system is out of resources to accomplish the
+                                  task.
+
+**/
+STATIC
+EFI_STATUS
+BuildStringIndex (
+  IN  HII_STRING_PACKAGE_INSTANCE  *StringPackage
+  )
+{
+  HII_STRING_INDEX_ENTRY   *Index;
+  UINTN                    Count;
+  UINT8                    *BlockHdr;
+  UINTN                    BlockSize;
+  UINTN                    CurrentStringId;
+  UINTN                    TextOffset;
+  UINTN                    StringSize;
+  UINTN                    Loop;
+  UINTN                    Id;
+  UINTN                    Target;
+  UINTN                    Depth;
+  UINT16                   StringCount;
+  UINT16                   SkipCount;
+  UINT8                    Length8;
+  UINT32                   Length32;
+  EFI_STRING_ID            DuplicateId;
+  EFI_HII_SIBT_EXT2_BLOCK  Ext2;
+
+  ASSERT (StringPackage->StringIndex == NULL);
+
+  Count = (UINTN)StringPackage->MaxStringId + 1;
+  Index = AllocateZeroPool (Count * sizeof (HII_STRING_INDEX_ENTRY));
+  if (Index == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CurrentStringId = 1;
+  StringSize      = 0;
+  BlockHdr        = StringPackage->StringBlock;
+  while (*BlockHdr != EFI_HII_SIBT_END) {
+    switch (*BlockHdr) {
+      case EFI_HII_SIBT_STRING_SCSU:
+      case EFI_HII_SIBT_STRING_SCSU_FONT:
+        if (*BlockHdr == EFI_HII_SIBT_STRING_SCSU) {
+          TextOffset = sizeof (EFI_HII_STRING_BLOCK);
+        } else {
+          TextOffset = sizeof (EFI_HII_SIBT_STRING_SCSU_FONT_BLOCK) - sizeof (UINT8);
+        }
+
+        SetStringIndexEntry (Index, Count, CurrentStringId, BlockHdr - StringPackage->StringBlock, TextOffset);
+        BlockSize = TextOffset + AsciiStrSize ((CHAR8 *)(BlockHdr + TextOffset));
+        CurrentStringId++;
+        break;
+
+      case EFI_HII_SIBT_STRINGS_SCSU:
+      case EFI_HII_SIBT_STRINGS_SCSU_FONT:
+        if (*BlockHdr == EFI_HII_SIBT_STRINGS_SCSU) {
+          CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+          TextOffset = sizeof (EFI_HII_SIBT_STRINGS_SCSU_BLOCK) - sizeof (UINT8);
+        } else {
+          CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+          TextOffset = sizeof (EFI_HII_SIBT_STRINGS_SCSU_FONT_BLOCK) - sizeof (UINT8);
+        }
+
+        for (Loop = 0; Loop < StringCount; Loop++) {
+          SetStringIndexEntry (Index, Count, CurrentStringId, BlockHdr - StringPackage->StringBlock, TextOffset);
+          TextOffset += AsciiStrSize ((CHAR8 *)(BlockHdr + TextOffset));
+          CurrentStringId++;
+        }
+
+        BlockSize = TextOffset;
+        break;
+
+      case EFI_HII_SIBT_STRING_UCS2:
+      case EFI_HII_SIBT_STRING_UCS2_FONT:
+        if (*BlockHdr == EFI_HII_SIBT_STRING_UCS2) {
+          TextOffset = sizeof (EFI_HII_STRING_BLOCK);
+        } else {
+          TextOffset = sizeof (EFI_HII_SIBT_STRING_UCS2_FONT_BLOCK) - sizeof (CHAR16);
+        }
+
+        SetStringIndexEntry (Index, Count, CurrentStringId, BlockHdr - StringPackage->StringBlock, TextOffset);
+        GetUnicodeStringTextOrSize (NULL, BlockHdr + TextOffset, &StringSize);
+        BlockSize = TextOffset + StringSize;
+        CurrentStringId++;
+        break;
+
+      case EFI_HII_SIBT_STRINGS_UCS2:
+      case EFI_HII_SIBT_STRINGS_UCS2_FONT:
+        if (*BlockHdr == EFI_HII_SIBT_STRINGS_UCS2) {
+          CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+          TextOffset = sizeof (EFI_HII_SIBT_STRINGS_UCS2_BLOCK) - sizeof (CHAR16);
+        } else {
+          CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+          TextOffset = sizeof (EFI_HII_SIBT_STRINGS_UCS2_FONT_BLOCK) - sizeof (CHAR16);
+        }
+
+        for (Loop = 0; Loop < StringCount; Loop++) {
+          SetStringIndexEntry (Index, Count, CurrentStringId, BlockHdr - StringPackage->StringBlock, TextOffset);
+          GetUnicodeStringTextOrSize (NULL, BlockHdr + TextOffset, &StringSize);
+          TextOffset += StringSize;
+          CurrentStringId++;
+        }
+
+        BlockSize = TextOffset;
+        break;
+
+      case EFI_HII_SIBT_DUPLICATE:
+        //
+        // Record the duplicated StringId for now, with a TextOffset of MAX_UINT32.
+        //
+        CopyMem (&DuplicateId, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (EFI_STRING_ID));
+        SetStringIndexEntry (Index, Count, CurrentStringId, DuplicateId, MAX_UINT32);
+        BlockSize = sizeof (EFI_HII_SIBT_DUPLICATE_BLOCK);
+        CurrentStringId++;
+        break;
+
+      case EFI_HII_SIBT_SKIP1:
+        SkipCount        = (UINT16)(*(UINT8 *)((UINTN)BlockHdr + sizeof (EFI_HII_STRING_BLOCK)));
+        CurrentStringId += SkipCount;
+        BlockSize        = sizeof (EFI_HII_SIBT_SKIP1_BLOCK);
+        break;
+
+      case EFI_HII_SIBT_SKIP2:
+        CopyMem (&SkipCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+        CurrentStringId += SkipCount;
+        BlockSize        = sizeof (EFI_HII_SIBT_SKIP2_BLOCK);
+        break;
+
+      case EFI_HII_SIBT_EXT1:
+        CopyMem (&Length8, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT8));
+        BlockSize = Length8;
+        break;
+
+      case EFI_HII_SIBT_EXT2:
+        CopyMem (&Ext2, BlockHdr, sizeof (EFI_HII_SIBT_EXT2_BLOCK));
+        BlockSize = Ext2.Length;
+        break;
+
+      case EFI_HII_SIBT_EXT4:
+        CopyMem (&Length32, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT32));
+        BlockSize = Length32;
+        break;
+
+      default:
+        BlockSize = 0;
+        break;
+    }
+
+    if (BlockSize == 0) {
+      FreePool (Index);
+      return EFI_UNSUPPORTED;
+    }
+
+    BlockHdr += BlockSize;
+  }
+
+  //
+  // Resolve the duplicate string blocks, which may refer to a string defined
+  // after them or to another duplicate string block. The IDs duplicating a
+  // string which is not indexed are left out as well.
+  //
+  for (Id = 1; Id < Count; Id++) {
+    if (Index[Id].TextOffset != MAX_UINT32) {
+      continue;
+    }
+
+    Target = Index[Id].BlockOffset;
+    for (Depth = 0; Depth < Count; Depth++) {
+      if ((Target >= Count) || (Index[Target].TextOffset != MAX_UINT32)) {
+        break;
+      }
+
+      Target = Index[Target].BlockOffset;
+    }
+
+    if ((Target < Count) && (Index[Target].TextOffset != MAX_UINT32)) {
+      Index[Id].BlockOffset = Index[Target].BlockOffset;
+      Index[Id].TextOffset  = Index[Target].TextOffset;
+    } else {
+      Index[Id].TextOffset = 0;
+    }
+  }
+
+  StringPackage->StringIndex      = Index;
+  StringPackage->StringIndexCount = Count;
+  return EFI_SUCCESS;
+}
+
 /**
   Parse all string blocks to find a String block specified by StringId.
   If StringId = (EFI_STRING_ID) (-1), find out all EFI_HII_SIBT_FONT blocks
   within this string package and backup its information. If LastStringId is
   specified, the string id of last string block will also be output.
   If StringId = 0, output the string id of last string block (EFI_HII_SIBT_STRING).
+  A string block of a valid StringId is looked up in the string index of the
+  package when StartStringId is NULL, the index being built on first use.
 
   @param  Private                 Hii database private structure.
   @param  StringPackage           Hii string package instance.
@@ -295,6 +547,21 @@ FindStringBlock (
     if (StringId > StringPackage->MaxStringId) {
       return EFI_NOT_FOUND;
     }
+
+    if (StartStringId == NULL) {
+      if (StringPackage->StringIndex == NULL) {
+        BuildStringIndex (StringPackage);
+      }
+
+      if ((StringId < StringPackage->StringIndexCount) &&
+          (StringPackage->StringIndex[StringId].TextOffset != 0))
+      {
+        *StringBlockAddr  = StringPackage->StringBlock + StringPackage->StringIndex[StringId].BlockOffset;
+        *BlockType        = **StringBlockAddr;
+        *StringTextOffset = StringPackage->StringIndex[StringId].TextOffset;
+        return EFI_SUCCESS;
+      }
+    }
   } else {
     ASSERT (Private != NULL && Private->Signature == HII_DATABASE_PRIVATE_DATA_SIGNATURE);
     if ((StringId == 0) && (LastStringId != NULL)) {
@@ -912,6 +1179,11 @@ SetStringWorker (
   StringSize    = 0;
   ASSERT (Private != NULL && StringPackage != NULL && String != NULL);
   ASSERT (Private->Signature == HII_DATABASE_PRIVATE_DATA_SIGNATURE);
+  //
+  // The string blocks are about to change.
+  //
+  InvalidateStringIndex (StringPackage);
+
   //
   // Find the specified string block
   //
@@ -1254,6 +1526,11 @@ HiiNewString (
       goto Done;
     }
 
+    //
+    // A string block is appended to every string package.
+    //
+    InvalidateStringIndex (StringPackage);
+
     //
     // Make sure that new StringId is same in all String Packages for the different language.
     //
@@ -1803,6 +2080,10 @@ HiiSetString (
 
         PackageListNode->PackageListHdr.PackageLength += StringPackage->StringPkgHdr->Header.Length - OldPackageLen;
         //
+        // The default value strings built from the IFR may refer to this string.
+        //
+        InvalidateConfigRoutingCache (PackageList);
+        //
         // Check whether need to get the contents of HiiDataBase.
         // Only after ReadyToBoot to do the export.
         //
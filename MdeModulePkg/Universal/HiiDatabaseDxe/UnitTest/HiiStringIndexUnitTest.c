@@ -0,0 +1,533 @@
+/** @file
+  Host based unit tests of the string index of the HII string packages.
+
+  A string package holding every kind of string block is built in memory. The
+  tests check that FindStringBlock () finds the same string block for each
+  string ID through the string index as by parsing the string blocks, and that
+  the index follows the changes made by SetStringWorker ().
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "HiiDatabase.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "HII String Index Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define INDEX_TEST_BLOCK_SIZE     SIZE_1KB
+#define INDEX_TEST_MAX_STRING_ID  21
+
+EFI_LOCK  mHiiDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
+BOOLEAN   gExportAfterReadyToBoot;
+
+HII_DATABASE_PRIVATE_DATA    mIndexTestPrivate;
+HII_STRING_PACKAGE_INSTANCE  mIndexTestPackage;
+UINT8                        mIndexTestBlocks[INDEX_TEST_BLOCK_SIZE];
+UINTN                        mIndexTestBlockSize;
+
+//
+// The string functions reach the rest of the HII database only for the fonts,
+// the notifications and the export of the database, which are stubbed out.
+//
+
+VOID
+EfiAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+}
+
+VOID
+EfiReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+}
+
+BOOLEAN
+IsHiiHandleValid (
+  EFI_HII_HANDLE  Handle
+  )
+{
+  return FALSE;
+}
+
+BOOLEAN
+IsFontInfoExisted (
+  IN  HII_DATABASE_PRIVATE_DATA  *Private,
+  IN  EFI_FONT_INFO              *FontInfo,
+  IN  EFI_FONT_INFO_MASK         *FontInfoMask    OPTIONAL,
+  IN  EFI_FONT_HANDLE            FontHandle       OPTIONAL,
+  OUT HII_GLOBAL_FONT_INFO       **GlobalFontInfo OPTIONAL
+  )
+{
+  return FALSE;
+}
+
+EFI_STATUS
+InvokeRegisteredFunction (
+  IN HII_DATABASE_PRIVATE_DATA     *Private,
+  IN EFI_HII_DATABASE_NOTIFY_TYPE  NotifyType,
+  IN VOID                          *PackageInstance,
+  IN UINT8                         PackageType,
+  IN EFI_HII_HANDLE                Handle
+  )
+{
+  return EFI_SUCCESS;
+}
+
+VOID
+InvalidateConfigRoutingCache (
+  IN EFI_HII_HANDLE  Handle
+  )
+{
+}
+
+EFI_STATUS
+HiiGetDatabaseInfo (
+  IN CONST EFI_HII_DATABASE_PROTOCOL  *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Appends bytes to the string blocks under construction.
+
+  @param[in] Data    The bytes to append.
+  @param[in] Size    The number of bytes.
+**/
+VOID
+IndexTestAppend (
+  IN CONST VOID  *Data,
+  IN UINTN       Size
+  )
+{
+  ASSERT (mIndexTestBlockSize + Size <= INDEX_TEST_BLOCK_SIZE);
+  CopyMem (mIndexTestBlocks + mIndexTestBlockSize, Data, Size);
+  mIndexTestBlockSize += Size;
+}
+
+/**
+  Appends a byte to the string blocks under construction.
+
+  @param[in] Value   The byte to append.
+**/
+VOID
+IndexTestAppend8 (
+  IN UINT8  Value
+  )
+{
+  IndexTestAppend (&Value, sizeof (Value));
+}
+
+/**
+  Appends a 16-bit value to the string blocks under construction.
+
+  @param[in] Value   The value to append.
+**/
+VOID
+IndexTestAppend16 (
+  IN UINT16  Value
+  )
+{
+  IndexTestAppend (&Value, sizeof (Value));
+}
+
+/**
+  Builds a string package with the following string IDs:
+
+    1       EFI_HII_SIBT_STRING_UCS2
+    2       EFI_HII_SIBT_STRING_SCSU
+    3-4     EFI_HII_SIBT_SKIP1
+    5-7     EFI_HII_SIBT_STRINGS_UCS2
+            EFI_HII_SIBT_EXT2 (EFI_HII_SIBT_FONT)
+    8       EFI_HII_SIBT_STRING_UCS2_FONT
+    9       EFI_HII_SIBT_DUPLICATE of 6
+    10      EFI_HII_SIBT_DUPLICATE of 12, defined after it
+    11      EFI_HII_SIBT_DUPLICATE of 3, which is skipped
+    12-13   EFI_HII_SIBT_STRINGS_SCSU_FONT
+    14-16   EFI_HII_SIBT_SKIP2
+    17      EFI_HII_SIBT_STRING_SCSU_FONT
+    18-19   EFI_HII_SIBT_STRINGS_SCSU
+    20-21   EFI_HII_SIBT_STRINGS_UCS2_FONT
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The string package is ready.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IndexTestSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_HII_STRING_PACKAGE_HDR  *Header;
+  EFI_HII_FONT_STYLE          FontStyle;
+  EFI_STATUS                  Status;
+
+  mIndexTestBlockSize = 0;
+
+  IndexTestAppend8 (EFI_HII_SIBT_STRING_UCS2);
+  IndexTestAppend (L"English", sizeof (L"English"));
+
+  IndexTestAppend8 (EFI_HII_SIBT_STRING_SCSU);
+  IndexTestAppend ("Two", sizeof ("Two"));
+
+  IndexTestAppend8 (EFI_HII_SIBT_SKIP1);
+  IndexTestAppend8 (2);
+
+  IndexTestAppend8 (EFI_HII_SIBT_STRINGS_UCS2);
+  IndexTestAppend16 (3);
+  IndexTestAppend (L"Five", sizeof (L"Five"));
+  IndexTestAppend (L"Six", sizeof (L"Six"));
+  IndexTestAppend (L"Seven", sizeof (L"Seven"));
+
+  IndexTestAppend8 (EFI_HII_SIBT_EXT2);
+  IndexTestAppend8 (EFI_HII_SIBT_FONT);
+  IndexTestAppend16 ((UINT16)(sizeof (EFI_HII_SIBT_FONT_BLOCK) - sizeof (CHAR16) + sizeof (L"Font")));
+  IndexTestAppend8 (1);
+  IndexTestAppend16 (19);
+  FontStyle = EFI_HII_FONT_STYLE_NORMAL;
+  IndexTestAppend (&FontStyle, sizeof (FontStyle));
+  IndexTestAppend (L"Font", sizeof (L"Font"));
+
+  IndexTestAppend8 (EFI_HII_SIBT_STRING_UCS2_FONT);
+  IndexTestAppend8 (1);
+  IndexTestAppend (L"Eight", sizeof (L"Eight"));
+
+  IndexTestAppend8 (EFI_HII_SIBT_DUPLICATE);
+  IndexTestAppend16 (6);
+  IndexTestAppend8 (EFI_HII_SIBT_DUPLICATE);
+  IndexTestAppend16 (12);
+  IndexTestAppend8 (EFI_HII_SIBT_DUPLICATE);
+  IndexTestAppend16 (3);
+
+  IndexTestAppend8 (EFI_HII_SIBT_STRINGS_SCSU_FONT);
+  IndexTestAppend8 (1);
+  IndexTestAppend16 (2);
+  IndexTestAppend ("Twelve", sizeof ("Twelve"));
+  IndexTestAppend ("Thirteen", sizeof ("Thirteen"));
+
+  IndexTestAppend8 (EFI_HII_SIBT_SKIP2);
+  IndexTestAppend16 (3);
+
+  IndexTestAppend8 (EFI_HII_SIBT_STRING_SCSU_FONT);
+  IndexTestAppend8 (1);
+  IndexTestAppend ("Seventeen", sizeof ("Seventeen"));
+
+  IndexTestAppend8 (EFI_HII_SIBT_STRINGS_SCSU);
+  IndexTestAppend16 (2);
+  IndexTestAppend ("Eighteen", sizeof ("Eighteen"));
+  IndexTestAppend ("Nineteen", sizeof ("Nineteen"));
+
+  IndexTestAppend8 (EFI_HII_SIBT_STRINGS_UCS2_FONT);
+  IndexTestAppend8 (1);
+  IndexTestAppend16 (2);
+  IndexTestAppend (L"Twenty", sizeof (L"Twenty"));
+  IndexTestAppend (L"TwentyOne", sizeof (L"TwentyOne"));
+
+  IndexTestAppend8 (EFI_HII_SIBT_END);
+
+  ZeroMem (&mIndexTestPrivate, sizeof (mIndexTestPrivate));
+  mIndexTestPrivate.Signature = HII_DATABASE_PRIVATE_DATA_SIGNATURE;
+
+  Header = AllocateZeroPool (sizeof (EFI_HII_STRING_PACKAGE_HDR));
+  UT_ASSERT_NOT_NULL (Header);
+  Header->Header.Type   = EFI_HII_PACKAGE_STRINGS;
+  Header->HdrSize       = sizeof (EFI_HII_STRING_PACKAGE_HDR);
+  Header->Header.Length = (UINT32)(Header->HdrSize + mIndexTestBlockSize);
+
+  ZeroMem (&mIndexTestPackage, sizeof (mIndexTestPackage));
+  mIndexTestPackage.Signature    = HII_STRING_PACKAGE_SIGNATURE;
+  mIndexTestPackage.StringPkgHdr = Header;
+  mIndexTestPackage.StringBlock  = AllocateCopyPool (mIndexTestBlockSize, mIndexTestBlocks);
+  UT_ASSERT_NOT_NULL (mIndexTestPackage.StringBlock);
+  InitializeListHead (&mIndexTestPackage.FontInfoList);
+
+  Status = FindStringBlock (
+             &mIndexTestPrivate,
+             &mIndexTestPackage,
+             (EFI_STRING_ID)(-1),
+             NULL,
+             NULL,
+             NULL,
+             &mIndexTestPackage.MaxStringId,
+             NULL
+             );
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (mIndexTestPackage.MaxStringId, INDEX_TEST_MAX_STRING_ID);
+  UT_ASSERT_TRUE (mIndexTestPackage.StringIndex == NULL);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Frees the string package.
+
+  @param[in] Context  Unused.
+**/
+VOID
+EFIAPI
+IndexTestCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  InvalidateStringIndex (&mIndexTestPackage);
+  FreePool (mIndexTestPackage.StringBlock);
+  FreePool (mIndexTestPackage.StringPkgHdr);
+}
+
+/**
+  Checks that every string ID of the package is found at the same place through
+  the string index as by parsing the string blocks.
+
+  @retval UNIT_TEST_PASSED  The string index agrees with the string blocks.
+**/
+UNIT_TEST_STATUS
+IndexTestCompare (
+  VOID
+  )
+{
+  EFI_STRING_ID  StringId;
+  EFI_STRING_ID  StartStringId;
+  EFI_STATUS     ParsedStatus;
+  UINT8          ParsedBlockType;
+  UINT8          *ParsedBlockAddr;
+  UINTN          ParsedTextOffset;
+  EFI_STATUS     IndexedStatus;
+  UINT8          IndexedBlockType;
+  UINT8          *IndexedBlockAddr;
+  UINTN          IndexedTextOffset;
+
+  for (StringId = 1; StringId <= mIndexTestPackage.MaxStringId + 1; StringId++) {
+    //
+    // A non-NULL StartStringId makes FindStringBlock () parse the string blocks.
+    //
+    ParsedStatus = FindStringBlock (
+                     &mIndexTestPrivate,
+                     &mIndexTestPackage,
+                     StringId,
+                     &ParsedBlockType,
+                     &ParsedBlockAddr,
+                     &ParsedTextOffset,
+                     NULL,
+                     &StartStringId
+                     );
+    IndexedStatus = FindStringBlock (
+                      &mIndexTestPrivate,
+                      &mIndexTestPackage,
+                      StringId,
+                      &IndexedBlockType,
+                      &IndexedBlockAddr,
+                      &IndexedTextOffset,
+                      NULL,
+                      NULL
+                      );
+    UT_ASSERT_STATUS_EQUAL (IndexedStatus, ParsedStatus);
+    if (!EFI_ERROR (ParsedStatus)) {
+      UT_ASSERT_EQUAL (IndexedBlockType, ParsedBlockType);
+      UT_ASSERT_EQUAL ((UINTN)IndexedBlockAddr, (UINTN)ParsedBlockAddr);
+      UT_ASSERT_EQUAL (IndexedTextOffset, ParsedTextOffset);
+    }
+  }
+
+  UT_ASSERT_NOT_NULL (mIndexTestPackage.StringIndex);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks the text of a string of the package.
+
+  @param[in] StringId  The string's id.
+  @param[in] Expected  The expected text, or NULL if the string must not be found.
+
+  @retval UNIT_TEST_PASSED  The string has the expected text.
+**/
+UNIT_TEST_STATUS
+IndexTestCheckString (
+  IN EFI_STRING_ID  StringId,
+  IN CHAR16         *Expected OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      String[64];
+  UINTN       StringSize;
+
+  StringSize = sizeof (String);
+  Status     = GetStringWorker (&mIndexTestPrivate, &mIndexTestPackage, StringId, String, &StringSize, NULL);
+  if (Expected == NULL) {
+    UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_FOUND);
+  } else {
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_MEM_EQUAL (String, Expected, StrSize (Expected));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The string index finds every string block the parser finds, including the
+  strings of the duplicate string blocks.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IndexTestLookup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  TestStatus;
+
+  TestStatus = IndexTestCompare ();
+  if (TestStatus != UNIT_TEST_PASSED) {
+    return TestStatus;
+  }
+
+  TestStatus = IndexTestCheckString (6, L"Six");
+  TestStatus = (TestStatus == UNIT_TEST_PASSED) ? IndexTestCheckString (9, L"Six") : TestStatus;
+  TestStatus = (TestStatus == UNIT_TEST_PASSED) ? IndexTestCheckString (10, L"Twelve") : TestStatus;
+  TestStatus = (TestStatus == UNIT_TEST_PASSED) ? IndexTestCheckString (11, NULL) : TestStatus;
+  TestStatus = (TestStatus == UNIT_TEST_PASSED) ? IndexTestCheckString (15, NULL) : TestStatus;
+  TestStatus = (TestStatus == UNIT_TEST_PASSED) ? IndexTestCheckString (21, L"TwentyOne") : TestStatus;
+  return TestStatus;
+}
+
+/**
+  Setting a string drops the string index, which is rebuilt from the updated
+  string blocks on the next lookup.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IndexTestSetString (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS        Status;
+  UNIT_TEST_STATUS  TestStatus;
+
+  TestStatus = IndexTestCheckString (7, L"Seven");
+  if (TestStatus != UNIT_TEST_PASSED) {
+    return TestStatus;
+  }
+
+  UT_ASSERT_NOT_NULL (mIndexTestPackage.StringIndex);
+
+  //
+  // Grow a string in the middle of a EFI_HII_SIBT_STRINGS_UCS2 block.
+  //
+  Status = SetStringWorker (&mIndexTestPrivate, &mIndexTestPackage, 5, L"A longer fifth string", NULL);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_TRUE (mIndexTestPackage.StringIndex == NULL);
+
+  TestStatus = IndexTestCheckString (5, L"A longer fifth string");
+  TestStatus = (TestStatus == UNIT_TEST_PASSED) ? IndexTestCheckString (7, L"Seven") : TestStatus;
+  TestStatus = (TestStatus == UNIT_TEST_PASSED) ? IndexTestCheckString (19, L"Nineteen") : TestStatus;
+  TestStatus = (TestStatus == UNIT_TEST_PASSED) ? IndexTestCompare () : TestStatus;
+  if (TestStatus != UNIT_TEST_PASSED) {
+    return TestStatus;
+  }
+
+  //
+  // Set a string in the middle of a EFI_HII_SIBT_SKIP2 block, which splits it.
+  //
+  Status = SetStringWorker (&mIndexTestPrivate, &mIndexTestPackage, 15, L"Fifteen", NULL);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_TRUE (mIndexTestPackage.StringIndex == NULL);
+
+  TestStatus = IndexTestCheckString (15, L"Fifteen");
+  TestStatus = (TestStatus == UNIT_TEST_PASSED) ? IndexTestCheckString (14, NULL) : TestStatus;
+  TestStatus = (TestStatus == UNIT_TEST_PASSED) ? IndexTestCheckString (16, NULL) : TestStatus;
+  TestStatus = (TestStatus == UNIT_TEST_PASSED) ? IndexTestCheckString (17, L"Seventeen") : TestStatus;
+  TestStatus = (TestStatus == UNIT_TEST_PASSED) ? IndexTestCompare () : TestStatus;
+  return TestStatus;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the string
+  index and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      IndexTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&IndexTests, Framework, "HII String Index Tests", "HiiDatabase.StringIndex", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for HII String Index Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (IndexTests, "The index agrees with the string block parser", "Lookup", IndexTestLookup, IndexTestSetup, IndexTestCleanup, NULL);
+  AddTestCase (IndexTests, "Setting a string rebuilds the index", "SetString", IndexTestSetString, IndexTestSetup, IndexTestCleanup, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define HiiStringIndexUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+HiiStringIndexUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
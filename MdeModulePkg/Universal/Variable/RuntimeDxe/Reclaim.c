@@ -7,7 +7,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 **/
 
-#include "Variable.h"
+#include "VariableParsing.h"
 
 /**
   Gets LBA of block and offset by given address.
@@ -85,6 +85,154 @@ GetLbaAndOffsetByAddress (
   return EFI_ABORTED;
 }
 
+/**
+  Gets the range of a variable store that differs from a new image of it,
+  extended to whole flash blocks.
+
+  @param[in]  Current       The current content of the variable store.
+  @param[in]  New           The new content of the variable store.
+  @param[in]  Size          The size of the variable store.
+  @param[in]  BlockOffset   The offset of the variable store in its first flash block.
+  @param[in]  BlockSize     The size of a flash block, or 0 to not extend the range.
+  @param[out] Start         Returns the offset of the start of the range.
+  @param[out] End           Returns the offset of the end of the range, equal to
+                            Start if the contents are the same.
+
+**/
+VOID
+GetVariableSpaceChangedRange (
+  IN  CONST UINT8  *Current,
+  IN  CONST UINT8  *New,
+  IN  UINTN        Size,
+  IN  UINTN        BlockOffset,
+  IN  UINTN        BlockSize,
+  OUT UINTN        *Start,
+  OUT UINTN        *End
+  )
+{
+  UINTN  First;
+  UINTN  Last;
+
+  First = 0;
+  while ((First < Size) && (Current[First] == New[First])) {
+    First++;
+  }
+
+  if (First == Size) {
+    *Start = 0;
+    *End   = 0;
+    return;
+  }
+
+  Last = Size;
+  while (Current[Last - 1] == New[Last - 1]) {
+    Last--;
+  }
+
+  if (BlockSize != 0) {
+    First = (First + BlockOffset) / BlockSize * BlockSize;
+    First = (First > BlockOffset) ? First - BlockOffset : 0;
+    Last  = (Last + BlockOffset + BlockSize - 1) / BlockSize * BlockSize - BlockOffset;
+    Last  = MIN (Last, Size);
+  }
+
+  *Start = First;
+  *End   = Last;
+}
+
+/**
+  Finds the first variable moved by an incremental reclaim.
+
+  The variables of the store are left in place up to the first flash block
+  whose garbage, the deleted variables and the ones being updated, takes at
+  least GarbageThreshold percent of the block. The reclaim compacts the
+  variables from that block on. A variable being updated that is before that
+  block is left in place only if it is already in deleted transition, so that
+  the store stays consistent until it is marked deleted; otherwise the
+  reclaim starts at that variable.
+
+  @param[in] VariableStoreHeader          The variable store.
+  @param[in] BlockOffset                  The offset of the variable store in its first flash block.
+  @param[in] BlockSize                    The size of a flash block.
+  @param[in] GarbageThreshold             The garbage ratio, in percent, of a block to compact.
+  @param[in] UpdatingVariable             The variable being updated, or NULL.
+  @param[in] UpdatingInDeletedTransition  The variable in deleted transition being updated, or NULL.
+  @param[in] AuthFormat                   TRUE indicates authenticated variables are used.
+                                          FALSE indicates authenticated variables are not used.
+
+  @return The first variable to compact, the first variable of the store if no
+          block has enough garbage to compact the store incrementally.
+
+**/
+VARIABLE_HEADER *
+GetReclaimStartVariable (
+  IN VARIABLE_STORE_HEADER  *VariableStoreHeader,
+  IN UINTN                  BlockOffset,
+  IN UINTN                  BlockSize,
+  IN UINT8                  GarbageThreshold,
+  IN VARIABLE_HEADER        *UpdatingVariable  OPTIONAL,
+  IN VARIABLE_HEADER        *UpdatingInDeletedTransition  OPTIONAL,
+  IN BOOLEAN                AuthFormat
+  )
+{
+  VARIABLE_HEADER  *Variable;
+  VARIABLE_HEADER  *NextVariable;
+  VARIABLE_HEADER  *BlockVariable;
+  VARIABLE_HEADER  *Updating;
+  UINTN            Block;
+  UINTN            VariableBlock;
+  UINTN            Garbage;
+
+  if ((GarbageThreshold == 0) || (BlockSize == 0)) {
+    return GetStartPointer (VariableStoreHeader);
+  }
+
+  Variable      = GetStartPointer (VariableStoreHeader);
+  BlockVariable = Variable;
+  Block         = (BlockOffset + (UINTN)Variable - (UINTN)VariableStoreHeader) / BlockSize;
+  Updating      = NULL;
+  Garbage       = 0;
+  while (IsValidVariableHeader (Variable, GetEndPointer (VariableStoreHeader))) {
+    NextVariable  = GetNextVariablePtr (Variable, AuthFormat);
+    VariableBlock = (BlockOffset + (UINTN)Variable - (UINTN)VariableStoreHeader) / BlockSize;
+    if (VariableBlock != Block) {
+      if (Garbage * 100 >= (UINTN)GarbageThreshold * BlockSize) {
+        return BlockVariable;
+      }
+
+      if (Updating != NULL) {
+        return Updating;
+      }
+
+      Block         = VariableBlock;
+      BlockVariable = Variable;
+      Garbage       = 0;
+    }
+
+    if ((Variable == UpdatingVariable) || (Variable == UpdatingInDeletedTransition)) {
+      if ((Updating == NULL) && (Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED))) {
+        Updating = Variable;
+      }
+
+      Garbage += (UINTN)NextVariable - (UINTN)Variable;
+    } else if ((Variable->State != VAR_ADDED) && (Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED))) {
+      Garbage += (UINTN)NextVariable - (UINTN)Variable;
+    }
+
+    Variable = NextVariable;
+  }
+
+  if (Garbage * 100 >= (UINTN)GarbageThreshold * BlockSize) {
+    return BlockVariable;
+  }
+
+  if (Updating != NULL) {
+    return Updating;
+  }
+
+  return GetStartPointer (VariableStoreHeader);
+}
+
 /**
   Writes a buffer to variable storage space, in the working block.
 
@@ -92,6 +240,10 @@ GetLbaAndOffsetByAddress (
   volume block device. The destination is specified by parameter
   VariableBase. Fault Tolerant Write protocol is used for writing.
 
+  Only the flash blocks whose content changes are written, by a single FTW
+  record, so a reclaim that leaves the start of the store in place does not
+  rewrite it.
+
   @param  VariableBase   Base address of variable to write
   @param  VariableBuffer Point to the variable data buffer.
 
@@ -106,12 +258,17 @@ FtwVariableSpace (
   IN VARIABLE_STORE_HEADER  *VariableBuffer
   )
 {
-  EFI_STATUS                         Status;
-  EFI_HANDLE                         FvbHandle;
-  EFI_LBA                            VarLba;
-  UINTN                              VarOffset;
-  UINTN                              FtwBufferSize;
-  EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *FtwProtocol;
+  EFI_STATUS                          Status;
+  EFI_HANDLE                          FvbHandle;
+  EFI_LBA                             VarLba;
+  UINTN                               VarOffset;
+  UINTN                               FtwBufferSize;
+  UINTN                               BlockSize;
+  UINTN                               NumberOfBlocks;
+  UINTN                               WriteStart;
+  UINTN                               WriteEnd;
+  EFI_FAULT_TOLERANT_WRITE_PROTOCOL   *FtwProtocol;
+  EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *Fvb;
 
   //
   // Locate fault tolerant write protocol.
@@ -124,7 +281,7 @@ FtwVariableSpace (
   //
   // Locate Fvb handle by address.
   //
-  Status = GetFvbInfoByAddress (VariableBase, &FvbHandle, NULL);
+  Status = GetFvbInfoByAddress (VariableBase, &FvbHandle, &Fvb);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -140,17 +297,45 @@ FtwVariableSpace (
   FtwBufferSize = ((VARIABLE_STORE_HEADER *)((UINTN)VariableBase))->Size;
   ASSERT (FtwBufferSize == VariableBuffer->Size);
 
+  //
+  // Only write the flash blocks that change.
+  //
+  Status = Fvb->GetBlockSize (Fvb, VarLba, &BlockSize, &NumberOfBlocks);
+  if (EFI_ERROR (Status)) {
+    BlockSize = 0;
+  }
+
+  GetVariableSpaceChangedRange (
+    (UINT8 *)(UINTN)VariableBase,
+    (UINT8 *)VariableBuffer,
+    FtwBufferSize,
+    VarOffset,
+    BlockSize,
+    &WriteStart,
+    &WriteEnd
+    );
+  if (WriteStart == WriteEnd) {
+    return EFI_SUCCESS;
+  }
+
+  if (WriteStart != 0) {
+    Status = GetLbaAndOffsetByAddress (VariableBase + WriteStart, &VarLba, &VarOffset);
+    if (EFI_ERROR (Status)) {
+      return EFI_ABORTED;
+    }
+  }
+
   //
   // FTW write record.
   //
   Status = FtwProtocol->Write (
                           FtwProtocol,
-                          VarLba,                // LBA
-                          VarOffset,             // Offset
-                          FtwBufferSize,         // NumBytes
-                          NULL,                  // PrivateData NULL
-                          FvbHandle,             // Fvb Handle
-                          (VOID *)VariableBuffer // write buffer
+                          VarLba,                                  // LBA
+                          VarOffset,                               // Offset
+                          WriteEnd - WriteStart,                   // NumBytes
+                          NULL,                                    // PrivateData NULL
+                          FvbHandle,                               // Fvb Handle
+                          (UINT8 *)VariableBuffer + WriteStart     // write buffer
                           );
 
   return Status;
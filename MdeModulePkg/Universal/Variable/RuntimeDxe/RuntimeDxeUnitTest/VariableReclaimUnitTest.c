@@ -0,0 +1,696 @@
+/** @file
+  Host based unit test and simulation of the non-volatile variable store
+  reclaim.
+
+  The variable store lives in a simulated flash device, written through fake
+  Firmware Volume Block and Fault Tolerant Write protocols that count the
+  blocks erased and the bytes programmed and model the time spent. A workload
+  of SetVariable () calls, mostly updates of a few hot variables and some
+  updates of many cold ones, is run with full and with incremental reclaims,
+  and the flash bytes written and the worst case SetVariable () latency of both
+  are reported.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "VariableParsing.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "Variable Reclaim Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define SIM_BLOCK_SIZE    SIZE_4KB
+#define SIM_BLOCK_COUNT   16
+#define SIM_FV_SIZE       (SIM_BLOCK_SIZE * SIM_BLOCK_COUNT)
+#define SIM_HEADER_SIZE   (sizeof (EFI_FIRMWARE_VOLUME_HEADER) + sizeof (EFI_FV_BLOCK_MAP_ENTRY))
+#define SIM_STORE_SIZE    (SIM_FV_SIZE - SIM_HEADER_SIZE)
+
+//
+// Modelled flash timings, in microseconds.
+//
+#define SIM_BLOCK_ERASE_US      25000
+#define SIM_BYTE_PROGRAM_US     2
+#define SIM_HOT_VARIABLES       4
+#define SIM_COLD_VARIABLES      120
+#define SIM_VARIABLES           (SIM_HOT_VARIABLES + SIM_COLD_VARIABLES)
+#define SIM_SET_VARIABLE_CALLS  20000
+#define SIM_NAME_LENGTH         16
+
+///
+/// The counters of the simulated flash.
+///
+typedef struct {
+  UINT64    BytesWritten;
+  UINT64    BlocksErased;
+  UINT64    Reclaims;
+  UINT64    TotalUs;
+  UINT64    WorstSetVariableUs;
+  UINT64    CurrentUs;
+} SIM_FLASH_STATS;
+
+UINT8                               *mSimFlash;
+VARIABLE_STORE_HEADER               *mSimStore;
+UINTN                               mSimLastOffset;
+SIM_FLASH_STATS                     mSimStats;
+UINT32                              mSimGeneration[SIM_VARIABLES];
+UINT8                               mSimBuffer[SIM_STORE_SIZE];
+EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  mSimFvb;
+EFI_FAULT_TOLERANT_WRITE_PROTOCOL   mSimFtw;
+
+EFI_GUID  mSimGuid = {
+  0x2a6c8e31, 0x74b0, 0x4d5f, { 0x93, 0x1e, 0x6b, 0xc2, 0x08, 0x5d, 0xf4, 0x17 }
+};
+
+/**
+  Return TRUE if ExitBootServices () has been called.
+
+  @retval TRUE If ExitBootServices () has been called.
+**/
+BOOLEAN
+AtRuntime (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+/**
+  Accounts for flash blocks erased and bytes programmed.
+
+  @param[in] Blocks   The number of blocks erased.
+  @param[in] Bytes    The number of bytes programmed.
+**/
+VOID
+SimAccount (
+  IN UINTN  Blocks,
+  IN UINTN  Bytes
+  )
+{
+  mSimStats.BlocksErased += Blocks;
+  mSimStats.BytesWritten += Bytes;
+  mSimStats.CurrentUs    += Blocks * SIM_BLOCK_ERASE_US + Bytes * SIM_BYTE_PROGRAM_US;
+}
+
+/**
+  Returns the address of the simulated flash device.
+**/
+EFI_STATUS
+EFIAPI
+SimFvbGetPhysicalAddress (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  OUT EFI_PHYSICAL_ADDRESS                     *Address
+  )
+{
+  *Address = (EFI_PHYSICAL_ADDRESS)(UINTN)mSimFlash;
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns the block size of the simulated flash device.
+**/
+EFI_STATUS
+EFIAPI
+SimFvbGetBlockSize (
+  IN CONST EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  *This,
+  IN EFI_LBA                                   Lba,
+  OUT UINTN                                    *BlockSize,
+  OUT UINTN                                    *NumberOfBlocks
+  )
+{
+  *BlockSize      = SIM_BLOCK_SIZE;
+  *NumberOfBlocks = SIM_BLOCK_COUNT - (UINTN)Lba;
+  return EFI_SUCCESS;
+}
+
+/**
+  Writes the simulated flash device through FTW: every block of the range is
+  erased and programmed twice, in the spare block and in place.
+**/
+EFI_STATUS
+EFIAPI
+SimFtwWrite (
+  IN EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *This,
+  IN EFI_LBA                            Lba,
+  IN UINTN                              Offset,
+  IN UINTN                              Length,
+  IN VOID                               *PrivateData,
+  IN EFI_HANDLE                         FvBlockHandle,
+  IN VOID                               *Buffer
+  )
+{
+  UINTN  Start;
+  UINTN  Blocks;
+
+  Start = (UINTN)Lba * SIM_BLOCK_SIZE + Offset;
+  if (Start + Length > SIM_FV_SIZE) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  Blocks = (Start + Length + SIM_BLOCK_SIZE - 1) / SIM_BLOCK_SIZE - Start / SIM_BLOCK_SIZE;
+  SimAccount (2 * Blocks, 2 * Blocks * SIM_BLOCK_SIZE);
+  CopyMem (mSimFlash + Start, Buffer, Length);
+  return EFI_SUCCESS;
+}
+
+/**
+  Retrieve the FVB protocol interface by address.
+**/
+EFI_STATUS
+GetFvbInfoByAddress (
+  IN  EFI_PHYSICAL_ADDRESS                Address,
+  OUT EFI_HANDLE                          *FvbHandle OPTIONAL,
+  OUT EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL  **FvbProtocol OPTIONAL
+  )
+{
+  if ((Address < (UINTN)mSimFlash) || (Address >= (UINTN)mSimFlash + SIM_FV_SIZE)) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (FvbHandle != NULL) {
+    *FvbHandle = (EFI_HANDLE)&mSimFvb;
+  }
+
+  if (FvbProtocol != NULL) {
+    *FvbProtocol = &mSimFvb;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Retrieve the FTW protocol interface.
+**/
+EFI_STATUS
+GetFtwProtocol (
+  OUT VOID  **FtwProtocol
+  )
+{
+  *FtwProtocol = &mSimFtw;
+  return EFI_SUCCESS;
+}
+
+/**
+  Formats the simulated flash device with an empty variable store.
+**/
+VOID
+SimFormat (
+  VOID
+  )
+{
+  EFI_FIRMWARE_VOLUME_HEADER  *FvHeader;
+
+  if (mSimFlash == NULL) {
+    mSimFlash = AllocatePool (SIM_FV_SIZE);
+  }
+
+  SetMem (mSimFlash, SIM_FV_SIZE, 0xFF);
+  FvHeader = (EFI_FIRMWARE_VOLUME_HEADER *)mSimFlash;
+  ZeroMem (FvHeader, SIM_HEADER_SIZE);
+  FvHeader->FvLength              = SIM_FV_SIZE;
+  FvHeader->HeaderLength          = (UINT16)SIM_HEADER_SIZE;
+  FvHeader->BlockMap[0].NumBlocks = SIM_BLOCK_COUNT;
+  FvHeader->BlockMap[0].Length    = SIM_BLOCK_SIZE;
+
+  mSimStore = (VARIABLE_STORE_HEADER *)(mSimFlash + SIM_HEADER_SIZE);
+  ZeroMem (mSimStore, sizeof (VARIABLE_STORE_HEADER));
+  CopyGuid (&mSimStore->Signature, &gEfiVariableGuid);
+  mSimStore->Size   = SIM_STORE_SIZE;
+  mSimStore->Format = VARIABLE_STORE_FORMATTED;
+  mSimStore->State  = VARIABLE_STORE_HEALTHY;
+
+  mSimLastOffset = (UINTN)GetStartPointer (mSimStore) - (UINTN)mSimStore;
+  ZeroMem (&mSimStats, sizeof (mSimStats));
+  ZeroMem (mSimGeneration, sizeof (mSimGeneration));
+
+  mSimFvb.GetPhysicalAddress = SimFvbGetPhysicalAddress;
+  mSimFvb.GetBlockSize       = SimFvbGetBlockSize;
+  mSimFtw.Write              = SimFtwWrite;
+}
+
+/**
+  Formats the name of a simulated variable.
+**/
+VOID
+SimName (
+  IN  UINTN   Number,
+  OUT CHAR16  *Name
+  )
+{
+  StrCpyS (Name, SIM_NAME_LENGTH, L"SimVar000");
+  Name[6] = (CHAR16)(L'0' + Number / 100);
+  Name[7] = (CHAR16)(L'0' + Number / 10 % 10);
+  Name[8] = (CHAR16)(L'0' + Number % 10);
+}
+
+/**
+  Returns the data size of a simulated variable.
+**/
+UINTN
+SimDataSize (
+  IN UINTN  Number
+  )
+{
+  return (Number < SIM_HOT_VARIABLES) ? 64 + 32 * Number : 120 + (Number * 37) % 200;
+}
+
+/**
+  Builds a simulated variable in a buffer.
+
+  @param[in]  Number    The number of the variable.
+  @param[out] Variable  The buffer.
+
+  @return The size of the variable, up to the next header.
+**/
+UINTN
+SimBuildVariable (
+  IN  UINTN            Number,
+  OUT VARIABLE_HEADER  *Variable
+  )
+{
+  CHAR16  Name[SIM_NAME_LENGTH];
+  UINT8   *Data;
+  UINTN   DataSize;
+
+  SimName (Number, Name);
+  DataSize = SimDataSize (Number);
+  ZeroMem (Variable, sizeof (VARIABLE_HEADER));
+  Variable->StartId    = VARIABLE_DATA;
+  Variable->State      = VAR_ADDED;
+  Variable->Attributes = EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS;
+  SetNameSizeOfVariable (Variable, StrSize (Name), FALSE);
+  SetDataSizeOfVariable (Variable, DataSize, FALSE);
+  CopyGuid (GetVendorGuidPtr (Variable, FALSE), &mSimGuid);
+  CopyMem (GetVariableNamePtr (Variable, FALSE), Name, StrSize (Name));
+  Data = GetVariableDataPtr (Variable, FALSE);
+  SetMem (Data, DataSize, (UINT8)mSimGeneration[Number]);
+  CopyMem (Data, &mSimGeneration[Number], sizeof (UINT32));
+  return (UINTN)GetNextVariablePtr (Variable, FALSE) - (UINTN)Variable;
+}
+
+/**
+  Reclaims the simulated variable store the way Reclaim () does, and writes
+  the new variable.
+
+  @param[in] Updating          The variable being updated, or NULL.
+  @param[in] NewVariable       The new variable.
+  @param[in] NewVariableSize   The size of the new variable.
+  @param[in] GarbageThreshold  The garbage threshold of incremental reclaims,
+                               0 for full reclaims.
+
+  @retval EFI_SUCCESS           The variable was written.
+  @retval EFI_OUT_OF_RESOURCES  The store is full.
+**/
+EFI_STATUS
+SimReclaim (
+  IN VARIABLE_HEADER  *Updating,
+  IN VARIABLE_HEADER  *NewVariable,
+  IN UINTN            NewVariableSize,
+  IN UINT8            GarbageThreshold
+  )
+{
+  VARIABLE_HEADER  *ReclaimStart;
+  VARIABLE_HEADER  *Variable;
+  VARIABLE_HEADER  *NextVariable;
+  UINT8            *CurrPtr;
+  UINTN            Size;
+  EFI_STATUS       Status;
+
+  mSimStats.Reclaims++;
+  ReclaimStart = GetReclaimStartVariable (
+                   mSimStore,
+                   SIM_HEADER_SIZE % SIM_BLOCK_SIZE,
+                   SIM_BLOCK_SIZE,
+                   GarbageThreshold,
+                   Updating,
+                   NULL,
+                   FALSE
+                   );
+
+Compact:
+  SetMem (mSimBuffer, SIM_STORE_SIZE, 0xFF);
+  CopyMem (mSimBuffer, mSimStore, sizeof (VARIABLE_STORE_HEADER));
+  CurrPtr = (UINT8 *)GetStartPointer ((VARIABLE_STORE_HEADER *)mSimBuffer);
+  Size    = (UINTN)ReclaimStart - (UINTN)GetStartPointer (mSimStore);
+  CopyMem (CurrPtr, GetStartPointer (mSimStore), Size);
+  CurrPtr += Size;
+
+  for ( Variable = ReclaimStart
+        ; IsValidVariableHeader (Variable, GetEndPointer (mSimStore))
+        ; Variable = NextVariable
+        )
+  {
+    NextVariable = GetNextVariablePtr (Variable, FALSE);
+    if ((Variable != Updating) && (Variable->State == VAR_ADDED)) {
+      Size = (UINTN)NextVariable - (UINTN)Variable;
+      CopyMem (CurrPtr, Variable, Size);
+      CurrPtr += Size;
+    }
+  }
+
+  if ((UINTN)CurrPtr - (UINTN)mSimBuffer + NewVariableSize > SIM_STORE_SIZE) {
+    if (ReclaimStart != GetStartPointer (mSimStore)) {
+      ReclaimStart = GetStartPointer (mSimStore);
+      goto Compact;
+    }
+
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CopyMem (CurrPtr, NewVariable, NewVariableSize);
+  CurrPtr += NewVariableSize;
+
+  Status = FtwVariableSpace ((EFI_PHYSICAL_ADDRESS)(UINTN)mSimStore, (VARIABLE_STORE_HEADER *)mSimBuffer);
+  if (!EFI_ERROR (Status)) {
+    if ((Updating != NULL) && (Updating < ReclaimStart)) {
+      Updating->State &= VAR_DELETED;
+      SimAccount (0, 1);
+    }
+
+    mSimLastOffset = (UINTN)CurrPtr - (UINTN)mSimBuffer;
+  }
+
+  return Status;
+}
+
+/**
+  Updates a simulated variable the way SetVariable () does: the new variable
+  is appended and the old one, first marked in deleted transition, deleted, or
+  the store is reclaimed if it is full.
+
+  @param[in] Number            The number of the variable.
+  @param[in] GarbageThreshold  The garbage threshold of incremental reclaims,
+                               0 for full reclaims.
+
+  @retval EFI_SUCCESS           The variable was written.
+  @retval EFI_OUT_OF_RESOURCES  The store is full.
+**/
+EFI_STATUS
+SimSetVariable (
+  IN UINTN  Number,
+  IN UINT8  GarbageThreshold
+  )
+{
+  UINT64                  Variable[128];
+  CHAR16                  Name[SIM_NAME_LENGTH];
+  VARIABLE_POINTER_TRACK  PtrTrack;
+  UINTN                   Size;
+  EFI_STATUS              Status;
+
+  SimName (Number, Name);
+  ZeroMem (&PtrTrack, sizeof (PtrTrack));
+  PtrTrack.StartPtr = GetStartPointer (mSimStore);
+  PtrTrack.EndPtr   = GetEndPointer (mSimStore);
+  FindVariableEx (Name, &mSimGuid, TRUE, &PtrTrack, FALSE);
+
+  mSimGeneration[Number]++;
+  Size = SimBuildVariable (Number, (VARIABLE_HEADER *)Variable);
+
+  mSimStats.CurrentUs = 0;
+  if (PtrTrack.CurrPtr != NULL) {
+    PtrTrack.CurrPtr->State &= VAR_IN_DELETED_TRANSITION;
+    SimAccount (0, 1);
+  }
+
+  if (mSimLastOffset + Size <= SIM_STORE_SIZE) {
+    CopyMem ((UINT8 *)mSimStore + mSimLastOffset, Variable, Size);
+    mSimLastOffset += Size;
+    SimAccount (0, Size);
+    if (PtrTrack.CurrPtr != NULL) {
+      PtrTrack.CurrPtr->State &= VAR_DELETED;
+      SimAccount (0, 1);
+    }
+
+    Status = EFI_SUCCESS;
+  } else {
+    Status = SimReclaim (PtrTrack.CurrPtr, (VARIABLE_HEADER *)Variable, Size, GarbageThreshold);
+  }
+
+  mSimStats.TotalUs           += mSimStats.CurrentUs;
+  mSimStats.WorstSetVariableUs = MAX (mSimStats.WorstSetVariableUs, mSimStats.CurrentUs);
+  return Status;
+}
+
+/**
+  Checks that every simulated variable has its last value.
+
+  @retval  UNIT_TEST_PASSED             The values are right.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A value is wrong.
+**/
+UNIT_TEST_STATUS
+SimCheckVariables (
+  VOID
+  )
+{
+  UINT64                  Expected[128];
+  CHAR16                  Name[SIM_NAME_LENGTH];
+  VARIABLE_POINTER_TRACK  PtrTrack;
+  UINTN                   Number;
+
+  for (Number = 0; Number < SIM_VARIABLES; Number++) {
+    SimName (Number, Name);
+    ZeroMem (&PtrTrack, sizeof (PtrTrack));
+    PtrTrack.StartPtr = GetStartPointer (mSimStore);
+    PtrTrack.EndPtr   = GetEndPointer (mSimStore);
+    UT_ASSERT_NOT_EFI_ERROR (FindVariableEx (Name, &mSimGuid, TRUE, &PtrTrack, FALSE));
+    SimBuildVariable (Number, (VARIABLE_HEADER *)Expected);
+    UT_ASSERT_EQUAL (DataSizeOfVariable (PtrTrack.CurrPtr, FALSE), SimDataSize (Number));
+    UT_ASSERT_MEM_EQUAL (
+      GetVariableDataPtr (PtrTrack.CurrPtr, FALSE),
+      GetVariableDataPtr ((VARIABLE_HEADER *)Expected, FALSE),
+      SimDataSize (Number)
+      );
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Runs the SetVariable () workload on a freshly formatted store.
+
+  @param[in]  GarbageThreshold  The garbage threshold of incremental reclaims,
+                                0 for full reclaims.
+  @param[out] Stats             Returns the flash counters.
+
+  @retval  UNIT_TEST_PASSED             The variables kept their values.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The workload failed.
+**/
+UNIT_TEST_STATUS
+SimRunWorkload (
+  IN  UINT8            GarbageThreshold,
+  OUT SIM_FLASH_STATS  *Stats
+  )
+{
+  UINTN   Call;
+  UINTN   Number;
+  UINT32  Random;
+
+  SimFormat ();
+  for (Number = 0; Number < SIM_VARIABLES; Number++) {
+    UT_ASSERT_NOT_EFI_ERROR (SimSetVariable (Number, GarbageThreshold));
+  }
+
+  ZeroMem (&mSimStats, sizeof (mSimStats));
+  Random = 1;
+  for (Call = 0; Call < SIM_SET_VARIABLE_CALLS; Call++) {
+    Random = Random * 1103515245 + 12345;
+    if (((Random >> 16) % 100) != 0) {
+      Number = (Random >> 8) % SIM_HOT_VARIABLES;
+    } else {
+      Number = SIM_HOT_VARIABLES + (Random >> 8) % SIM_COLD_VARIABLES;
+    }
+
+    UT_ASSERT_NOT_EFI_ERROR (SimSetVariable (Number, GarbageThreshold));
+    if ((Call % 256) == 0) {
+      UT_ASSERT_EQUAL (SimCheckVariables (), UNIT_TEST_PASSED);
+    }
+  }
+
+  UT_ASSERT_EQUAL (SimCheckVariables (), UNIT_TEST_PASSED);
+  CopyMem (Stats, &mSimStats, sizeof (*Stats));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks the range of the store written for a change.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SimChangedRange (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Start;
+  UINTN  End;
+
+  SetMem (mSimBuffer, SIM_STORE_SIZE, 0xFF);
+  SimFormat ();
+  CopyMem (mSimBuffer, mSimStore, SIM_STORE_SIZE);
+
+  GetVariableSpaceChangedRange ((UINT8 *)mSimStore, mSimBuffer, SIM_STORE_SIZE, SIM_HEADER_SIZE, SIM_BLOCK_SIZE, &Start, &End);
+  UT_ASSERT_EQUAL (Start, End);
+
+  //
+  // A change in the first block starts at the store, in another block at its
+  // block boundary.
+  //
+  mSimBuffer[0x100] = 0;
+  GetVariableSpaceChangedRange ((UINT8 *)mSimStore, mSimBuffer, SIM_STORE_SIZE, SIM_HEADER_SIZE, SIM_BLOCK_SIZE, &Start, &End);
+  UT_ASSERT_EQUAL (Start, 0);
+  UT_ASSERT_EQUAL (End, SIM_BLOCK_SIZE - SIM_HEADER_SIZE);
+
+  mSimBuffer[0x100]             = 0xFF;
+  mSimBuffer[3 * SIM_BLOCK_SIZE] = 0;
+  GetVariableSpaceChangedRange ((UINT8 *)mSimStore, mSimBuffer, SIM_STORE_SIZE, SIM_HEADER_SIZE, SIM_BLOCK_SIZE, &Start, &End);
+  UT_ASSERT_EQUAL (Start, 3 * SIM_BLOCK_SIZE - SIM_HEADER_SIZE);
+  UT_ASSERT_EQUAL (End, 4 * SIM_BLOCK_SIZE - SIM_HEADER_SIZE);
+
+  //
+  // A change in the last block ends at the end of the store.
+  //
+  mSimBuffer[SIM_STORE_SIZE - 1] = 0;
+  GetVariableSpaceChangedRange ((UINT8 *)mSimStore, mSimBuffer, SIM_STORE_SIZE, SIM_HEADER_SIZE, SIM_BLOCK_SIZE, &Start, &End);
+  UT_ASSERT_EQUAL (Start, 3 * SIM_BLOCK_SIZE - SIM_HEADER_SIZE);
+  UT_ASSERT_EQUAL (End, SIM_STORE_SIZE);
+
+  //
+  // Without a block size, the range is the changed bytes.
+  //
+  GetVariableSpaceChangedRange ((UINT8 *)mSimStore, mSimBuffer, SIM_STORE_SIZE, SIM_HEADER_SIZE, 0, &Start, &End);
+  UT_ASSERT_EQUAL (Start, 3 * SIM_BLOCK_SIZE);
+  UT_ASSERT_EQUAL (End, SIM_STORE_SIZE);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Runs the workload with full and incremental reclaims, checks that the
+  variables keep their values, and reports the flash bytes written and the
+  worst case SetVariable () latency.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SimReclaimWorkload (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  SIM_FLASH_STATS  Full;
+  SIM_FLASH_STATS  Incremental;
+
+  UT_ASSERT_EQUAL (SimRunWorkload (0, &Full), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (SimRunWorkload (50, &Incremental), UNIT_TEST_PASSED);
+
+  UT_LOG_INFO (
+    "Full reclaim: %ld reclaims, %ld KB written, %ld blocks erased, worst SetVariable %ld ms, total %ld ms\n",
+    Full.Reclaims,
+    Full.BytesWritten / SIZE_1KB,
+    Full.BlocksErased,
+    Full.WorstSetVariableUs / 1000,
+    Full.TotalUs / 1000
+    );
+  UT_LOG_INFO (
+    "Incremental reclaim: %ld reclaims, %ld KB written, %ld blocks erased, worst SetVariable %ld ms, total %ld ms\n",
+    Incremental.Reclaims,
+    Incremental.BytesWritten / SIZE_1KB,
+    Incremental.BlocksErased,
+    Incremental.WorstSetVariableUs / 1000,
+    Incremental.TotalUs / 1000
+    );
+  UT_LOG_INFO (
+    "Rewriting the whole store on each reclaim would erase %ld blocks\n",
+    Full.Reclaims * 2 * SIM_BLOCK_COUNT
+    );
+
+  UT_ASSERT_TRUE (Incremental.BytesWritten < Full.BytesWritten);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  variable reclaim and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ReclaimTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&ReclaimTests, Framework, "Variable Reclaim Tests", "Variable.Reclaim", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for Variable Reclaim Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ReclaimTests, "Only the changed blocks are written", "ChangedRange", SimChangedRange, NULL, NULL, NULL);
+  AddTestCase (ReclaimTests, "Full and incremental reclaim workload", "Workload", SimReclaimWorkload, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define VariableReclaimUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+VariableReclaimUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -0,0 +1,276 @@
+/** @file
+  Host based unit tests of the synchronization of the runtime variable caches.
+
+  The volatile, non-volatile and HOB variable stores are plain buffers, each
+  with a runtime cache of the same size. The tests check that only the ranges
+  given to SynchronizeRuntimeVariableCacheRanges () are copied, that each
+  update of the caches moves the sequence count by two, and that the updates
+  stay pending while the runtime cache read lock is taken.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "VariableParsing.h"
+#include "VariableRuntimeCache.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "Variable Runtime Cache Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define CACHE_TEST_STORE_SIZE  SIZE_4KB
+
+VARIABLE_MODULE_GLOBAL  mCacheTestGlobal;
+VARIABLE_MODULE_GLOBAL  *mVariableModuleGlobal = &mCacheTestGlobal;
+VARIABLE_STORE_HEADER   *mNvVariableCache;
+
+UINT8    mCacheTestVolatileStore[CACHE_TEST_STORE_SIZE];
+UINT8    mCacheTestNvStore[CACHE_TEST_STORE_SIZE];
+UINT8    mCacheTestVolatileCache[CACHE_TEST_STORE_SIZE];
+UINT8    mCacheTestNvCache[CACHE_TEST_STORE_SIZE];
+BOOLEAN  mCacheTestPendingUpdate;
+BOOLEAN  mCacheTestReadLock;
+BOOLEAN  mCacheTestHobFlushComplete;
+UINT32   mCacheTestRewriteCount;
+UINT32   mCacheTestSequenceCount;
+
+/**
+  Fills the variable stores with a pattern and their runtime caches with another
+  one, and connects the runtime cache context to them.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The stores and caches are ready.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CacheTestSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *CacheContext;
+
+  SetMem (mCacheTestVolatileStore, CACHE_TEST_STORE_SIZE, 0x11);
+  SetMem (mCacheTestNvStore, CACHE_TEST_STORE_SIZE, 0x22);
+  SetMem (mCacheTestVolatileCache, CACHE_TEST_STORE_SIZE, 0xFF);
+  SetMem (mCacheTestNvCache, CACHE_TEST_STORE_SIZE, 0xFF);
+
+  ZeroMem (&mCacheTestGlobal, sizeof (mCacheTestGlobal));
+  mCacheTestGlobal.VariableGlobal.VolatileVariableBase = (EFI_PHYSICAL_ADDRESS)(UINTN)mCacheTestVolatileStore;
+  mNvVariableCache                                     = (VARIABLE_STORE_HEADER *)mCacheTestNvStore;
+
+  mCacheTestPendingUpdate    = FALSE;
+  mCacheTestReadLock         = FALSE;
+  mCacheTestHobFlushComplete = FALSE;
+  mCacheTestRewriteCount     = 0;
+  mCacheTestSequenceCount    = 0;
+
+  CacheContext                                     = &mCacheTestGlobal.VariableGlobal.VariableRuntimeCacheContext;
+  CacheContext->PendingUpdate                      = &mCacheTestPendingUpdate;
+  CacheContext->ReadLock                           = &mCacheTestReadLock;
+  CacheContext->HobFlushComplete                   = &mCacheTestHobFlushComplete;
+  CacheContext->RewriteCount                       = &mCacheTestRewriteCount;
+  CacheContext->SequenceCount                      = &mCacheTestSequenceCount;
+  CacheContext->VariableRuntimeVolatileCache.Store = (VARIABLE_STORE_HEADER *)mCacheTestVolatileCache;
+  CacheContext->VariableRuntimeNvCache.Store       = (VARIABLE_STORE_HEADER *)mCacheTestNvCache;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Counts the bytes of a runtime cache that differ from its variable store.
+
+  @param[in] Cache    The runtime cache.
+  @param[in] Store    The variable store.
+
+  @return The number of bytes that differ.
+**/
+UINTN
+CacheTestDifferences (
+  IN UINT8  *Cache,
+  IN UINT8  *Store
+  )
+{
+  UINTN  Index;
+  UINTN  Count;
+
+  Count = 0;
+  for (Index = 0; Index < CACHE_TEST_STORE_SIZE; Index++) {
+    if (Cache[Index] != Store[Index]) {
+      Count++;
+    }
+  }
+
+  return Count;
+}
+
+/**
+  Only the given ranges of a store are copied to its runtime cache, in a single
+  update of the caches.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CacheTestRanges (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *CacheContext;
+  VARIABLE_STORE_RANGE            Ranges[2];
+
+  CacheContext = &mCacheTestGlobal.VariableGlobal.VariableRuntimeCacheContext;
+
+  Ranges[0].Offset = 0x10;
+  Ranges[0].Length = 1;
+  Ranges[1].Offset = 0x800;
+  Ranges[1].Length = 0x40;
+  UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCacheRanges (&CacheContext->VariableRuntimeNvCache, 2, Ranges));
+
+  UT_ASSERT_EQUAL (mCacheTestSequenceCount, 2);
+  UT_ASSERT_EQUAL (CacheTestDifferences (mCacheTestNvCache, mCacheTestNvStore), CACHE_TEST_STORE_SIZE - 0x41);
+  UT_ASSERT_EQUAL (mCacheTestNvCache[0x10], 0x22);
+  UT_ASSERT_EQUAL (mCacheTestNvCache[0x11], 0xFF);
+  UT_ASSERT_EQUAL (mCacheTestNvCache[0x83F], 0x22);
+  UT_ASSERT_EQUAL (mCacheTestNvCache[0x840], 0xFF);
+  UT_ASSERT_EQUAL (CacheTestDifferences (mCacheTestVolatileCache, mCacheTestVolatileStore), CACHE_TEST_STORE_SIZE);
+
+  UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCache (&CacheContext->VariableRuntimeVolatileCache, 0, CACHE_TEST_STORE_SIZE));
+  UT_ASSERT_EQUAL (mCacheTestSequenceCount, 4);
+  UT_ASSERT_EQUAL (CacheTestDifferences (mCacheTestVolatileCache, mCacheTestVolatileStore), 0);
+  UT_ASSERT_FALSE (mCacheTestPendingUpdate);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The updates stay pending, and the caches unchanged, while the read lock is
+  taken. They are copied by the next flush once it is released.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CacheTestReadLock (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *CacheContext;
+  VARIABLE_STORE_RANGE            Ranges[2];
+
+  CacheContext       = &mCacheTestGlobal.VariableGlobal.VariableRuntimeCacheContext;
+  mCacheTestReadLock = TRUE;
+
+  Ranges[0].Offset = 0x100;
+  Ranges[0].Length = 0x10;
+  Ranges[1].Offset = 0x200;
+  Ranges[1].Length = 0x20;
+  UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCacheRanges (&CacheContext->VariableRuntimeNvCache, 2, Ranges));
+  UT_ASSERT_NOT_EFI_ERROR (SynchronizeRuntimeVariableCache (&CacheContext->VariableRuntimeVolatileCache, 0x300, 4));
+  UT_ASSERT_NOT_EFI_ERROR (FlushPendingRuntimeVariableCacheUpdates ());
+
+  UT_ASSERT_TRUE (mCacheTestPendingUpdate);
+  UT_ASSERT_EQUAL (mCacheTestSequenceCount, 0);
+  UT_ASSERT_EQUAL (CacheContext->VariableRuntimeNvCache.PendingUpdateOffset, 0x100);
+  UT_ASSERT_EQUAL (CacheContext->VariableRuntimeNvCache.PendingUpdateLength, 0x120);
+  UT_ASSERT_EQUAL (CacheTestDifferences (mCacheTestNvCache, mCacheTestNvStore), CACHE_TEST_STORE_SIZE);
+
+  mCacheTestReadLock = FALSE;
+  UT_ASSERT_NOT_EFI_ERROR (FlushPendingRuntimeVariableCacheUpdates ());
+
+  UT_ASSERT_FALSE (mCacheTestPendingUpdate);
+  UT_ASSERT_EQUAL (mCacheTestSequenceCount, 2);
+  UT_ASSERT_EQUAL (CacheTestDifferences (mCacheTestNvCache, mCacheTestNvStore), CACHE_TEST_STORE_SIZE - 0x120);
+  UT_ASSERT_EQUAL (CacheTestDifferences (mCacheTestVolatileCache, mCacheTestVolatileStore), CACHE_TEST_STORE_SIZE - 4);
+  UT_ASSERT_EQUAL (CacheContext->VariableRuntimeNvCache.PendingUpdateLength, 0);
+
+  //
+  // Nothing is left to copy.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (FlushPendingRuntimeVariableCacheUpdates ());
+  UT_ASSERT_EQUAL (mCacheTestSequenceCount, 2);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the runtime
+  variable cache and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      CacheTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&CacheTests, Framework, "Variable Runtime Cache Tests", "Variable.RuntimeCache", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for Variable Runtime Cache Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (CacheTests, "Only the given ranges are copied", "Ranges", CacheTestRanges, CacheTestSetup, NULL, NULL);
+  AddTestCase (CacheTests, "Updates stay pending under the read lock", "ReadLock", CacheTestReadLock, CacheTestSetup, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define VariableRuntimeCacheUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+VariableRuntimeCacheUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
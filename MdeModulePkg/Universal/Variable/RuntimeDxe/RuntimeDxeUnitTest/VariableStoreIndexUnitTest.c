@@ -0,0 +1,770 @@
+/** @file
+  Host based unit test and micro-benchmark of the variable store hash index.
+
+  Two copies of a variable store holding thousands of variables, some of them
+  in deleted transition or deleted, are searched with FindVariableEx (). Only
+  the first copy is indexed, so the second one is walked, and the results of
+  both lookups must be the same, also after variables are appended, change
+  state and after the store is reclaimed. The rates of GetVariable () style
+  lookups and of a GetNextVariableName () enumeration are reported for both
+  copies.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka.h>
+
+#include "VariableParsing.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "Variable Store Index Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define VAR_TEST_STORE_SIZE       SIZE_1MB
+#define VAR_TEST_VARIABLES        4000
+#define VAR_TEST_APPENDS          500
+#define VAR_TEST_GUIDS            4
+#define VAR_TEST_NAME_LENGTH      32
+#define VAR_TEST_INDEXED_LOOKUPS  1000000
+#define VAR_TEST_WALKED_LOOKUPS   20000
+
+#define VAR_TEST_IN_DELETED  (VAR_IN_DELETED_TRANSITION & VAR_ADDED)
+#define VAR_TEST_DELETED     (VAR_DELETED & VAR_IN_DELETED_TRANSITION & VAR_ADDED)
+
+VARIABLE_STORE_HEADER  *mVarTestIndexedStore;
+VARIABLE_STORE_HEADER  *mVarTestWalkedStore;
+UINTN                  mVarTestLastOffset;
+UINTN                  mVarTestNextName;
+BOOLEAN                mVarTestAtRuntime;
+
+EFI_GUID  mVarTestGuid[VAR_TEST_GUIDS] = {
+  { 0x5e2f6d3a, 0x1c4b, 0x4f0e, { 0x9a, 0x61, 0x2b, 0x7d, 0x30, 0xc8, 0x14, 0x55 }
+  },
+  { 0x8b0f41e7, 0x66d2, 0x4a39, { 0xb5, 0x0c, 0x7e, 0x19, 0xa4, 0x3f, 0x62, 0xd1 }
+  },
+  { 0x0c93a5b2, 0xe7f4, 0x4d18, { 0x83, 0x2a, 0x51, 0xf6, 0x0b, 0x9e, 0xc7, 0x3d }
+  },
+  { 0xd4176c08, 0x3ba9, 0x45e2, { 0xae, 0x47, 0x98, 0x25, 0x6f, 0x01, 0xbc, 0x7a }
+  }
+};
+
+/**
+  Return TRUE if ExitBootServices () has been called.
+
+  @retval TRUE If ExitBootServices () has been called.
+**/
+BOOLEAN
+AtRuntime (
+  VOID
+  )
+{
+  return mVarTestAtRuntime;
+}
+
+/**
+  Formats the name of a test variable.
+
+  @param[in]  Number  The number of the variable.
+  @param[out] Name    Returns the name, VAR_TEST_NAME_LENGTH characters at most.
+**/
+VOID
+VarTestName (
+  IN  UINTN   Number,
+  OUT CHAR16  *Name
+  )
+{
+  CHAR16  Digits[12];
+  UINTN   Count;
+
+  StrCpyS (Name, VAR_TEST_NAME_LENGTH, L"TestVariable");
+  Count = 0;
+  do {
+    Digits[Count++] = (CHAR16)(L'0' + Number % 10);
+    Number         /= 10;
+  } while (Number != 0);
+
+  Name += StrLen (Name);
+  while (Count > 0) {
+    *Name++ = Digits[--Count];
+  }
+
+  *Name = L'\0';
+}
+
+/**
+  Appends a variable to both copies of the store.
+
+  @param[in] Name         The variable name.
+  @param[in] Guid         The variable GUID.
+  @param[in] Attributes   The variable attributes.
+  @param[in] State        The variable state.
+  @param[in] DataSize     The size of the variable data.
+
+  @return The offset of the variable in the store.
+**/
+UINTN
+VarTestAppend (
+  IN CHAR16    *Name,
+  IN EFI_GUID  *Guid,
+  IN UINT32    Attributes,
+  IN UINT8     State,
+  IN UINTN     DataSize
+  )
+{
+  VARIABLE_HEADER  *Variable;
+  UINTN            Offset;
+  UINTN            Size;
+
+  Offset   = mVarTestLastOffset;
+  Variable = (VARIABLE_HEADER *)((UINTN)mVarTestIndexedStore + Offset);
+  ZeroMem (Variable, sizeof (VARIABLE_HEADER));
+  Variable->StartId    = VARIABLE_DATA;
+  Variable->State      = State;
+  Variable->Attributes = Attributes;
+  SetNameSizeOfVariable (Variable, StrSize (Name), FALSE);
+  SetDataSizeOfVariable (Variable, DataSize, FALSE);
+  CopyGuid (GetVendorGuidPtr (Variable, FALSE), Guid);
+  CopyMem (GetVariableNamePtr (Variable, FALSE), Name, StrSize (Name));
+  SetMem (GetVariableDataPtr (Variable, FALSE), DataSize, (UINT8)Offset);
+
+  Size = (UINTN)GetNextVariablePtr (Variable, FALSE) - (UINTN)Variable;
+  CopyMem ((UINT8 *)mVarTestWalkedStore + Offset, Variable, Size);
+  mVarTestLastOffset += Size;
+  return Offset;
+}
+
+/**
+  Changes the state of a variable in both copies of the store.
+
+  @param[in] Offset   The offset of the variable in the store.
+  @param[in] State    The new state.
+**/
+VOID
+VarTestSetState (
+  IN UINTN  Offset,
+  IN UINT8  State
+  )
+{
+  ((VARIABLE_HEADER *)((UINTN)mVarTestIndexedStore + Offset))->State = State;
+  ((VARIABLE_HEADER *)((UINTN)mVarTestWalkedStore + Offset))->State  = State;
+}
+
+/**
+  Appends the variables of one test name, with the history of updates that
+  the number of the name selects.
+
+  @param[in] Number   The number of the variable name.
+**/
+VOID
+VarTestAppendName (
+  IN UINTN  Number
+  )
+{
+  CHAR16    Name[VAR_TEST_NAME_LENGTH];
+  EFI_GUID  *Guid;
+  UINT32    Attributes;
+  UINTN     DataSize;
+  UINTN     Offset;
+
+  VarTestName (Number, Name);
+  Guid       = &mVarTestGuid[Number % VAR_TEST_GUIDS];
+  Attributes = EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS;
+  if ((Number % 3) != 0) {
+    Attributes |= EFI_VARIABLE_RUNTIME_ACCESS;
+  }
+
+  DataSize = 1 + Number % 61;
+
+  if ((Number % 11) == 0) {
+    //
+    // Updated before: an older deleted copy.
+    //
+    VarTestAppend (Name, Guid, Attributes, VAR_TEST_DELETED, DataSize + 3);
+  }
+
+  if ((Number % 17) == 0) {
+    //
+    // Deleted.
+    //
+    VarTestAppend (Name, Guid, Attributes, VAR_TEST_DELETED, DataSize);
+  } else if ((Number % 13) == 0) {
+    //
+    // Interrupted update: only the copy in deleted transition is left.
+    //
+    VarTestAppend (Name, Guid, Attributes, VAR_TEST_IN_DELETED, DataSize);
+  } else if ((Number % 7) == 0) {
+    //
+    // Update in progress: the old copy is in deleted transition.
+    //
+    Offset = VarTestAppend (Name, Guid, Attributes, VAR_ADDED, DataSize);
+    VarTestSetState (Offset, VAR_TEST_IN_DELETED);
+    VarTestAppend (Name, Guid, Attributes, VAR_ADDED, DataSize + 1);
+  } else {
+    VarTestAppend (Name, Guid, Attributes, VAR_ADDED, DataSize);
+  }
+}
+
+/**
+  Finds a variable in one copy of the store.
+
+  @param[in]  Store           The copy of the store.
+  @param[in]  Name            The variable name.
+  @param[in]  Guid            The variable GUID.
+  @param[in]  IgnoreRtCheck   Ignore the runtime access attribute at runtime.
+  @param[out] PtrTrack        Returns the variable found.
+
+  @return The status of FindVariableEx ().
+**/
+EFI_STATUS
+VarTestFind (
+  IN  VARIABLE_STORE_HEADER   *Store,
+  IN  CHAR16                  *Name,
+  IN  EFI_GUID                *Guid,
+  IN  BOOLEAN                 IgnoreRtCheck,
+  OUT VARIABLE_POINTER_TRACK  *PtrTrack
+  )
+{
+  ZeroMem (PtrTrack, sizeof (*PtrTrack));
+  PtrTrack->StartPtr = GetStartPointer (Store);
+  PtrTrack->EndPtr   = GetEndPointer (Store);
+  return FindVariableEx (Name, Guid, IgnoreRtCheck, PtrTrack, FALSE);
+}
+
+/**
+  Returns the offset of a variable header in a store, or 0 for NULL.
+**/
+UINTN
+VarTestOffset (
+  IN VARIABLE_STORE_HEADER  *Store,
+  IN VARIABLE_HEADER        *Variable
+  )
+{
+  return (Variable == NULL) ? 0 : (UINTN)Variable - (UINTN)Store;
+}
+
+/**
+  Looks up all the test names, and names that were never added, with the
+  matching and a wrong GUID, at boot time and at runtime, in both copies of
+  the store and checks that the results are the same.
+
+  @param[in] NameCount  The number of test names appended to the store.
+
+  @retval  UNIT_TEST_PASSED             The results are the same.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The results are different.
+**/
+UNIT_TEST_STATUS
+VarTestCompareAll (
+  IN UINTN  NameCount
+  )
+{
+  CHAR16                  Name[VAR_TEST_NAME_LENGTH];
+  VARIABLE_POINTER_TRACK  Indexed;
+  VARIABLE_POINTER_TRACK  Walked;
+  EFI_STATUS              IndexedStatus;
+  EFI_STATUS              WalkedStatus;
+  UINTN                   Number;
+  UINTN                   Pass;
+  UINTN                   Found;
+
+  Found = 0;
+  for (Pass = 0; Pass < 8; Pass++) {
+    mVarTestAtRuntime = (BOOLEAN)((Pass & 1) != 0);
+    for (Number = 0; Number < NameCount + 16; Number++) {
+      VarTestName (Number, Name);
+      IndexedStatus = VarTestFind (
+                        mVarTestIndexedStore,
+                        Name,
+                        &mVarTestGuid[(Number + (Pass >> 2)) % VAR_TEST_GUIDS],
+                        (BOOLEAN)((Pass & 2) != 0),
+                        &Indexed
+                        );
+      WalkedStatus = VarTestFind (
+                       mVarTestWalkedStore,
+                       Name,
+                       &mVarTestGuid[(Number + (Pass >> 2)) % VAR_TEST_GUIDS],
+                       (BOOLEAN)((Pass & 2) != 0),
+                       &Walked
+                       );
+      UT_ASSERT_STATUS_EQUAL (IndexedStatus, WalkedStatus);
+      UT_ASSERT_EQUAL (VarTestOffset (mVarTestIndexedStore, Indexed.CurrPtr), VarTestOffset (mVarTestWalkedStore, Walked.CurrPtr));
+      UT_ASSERT_EQUAL (
+        VarTestOffset (mVarTestIndexedStore, Indexed.InDeletedTransitionPtr),
+        VarTestOffset (mVarTestWalkedStore, Walked.InDeletedTransitionPtr)
+        );
+      if (!EFI_ERROR (IndexedStatus)) {
+        Found++;
+      }
+    }
+  }
+
+  mVarTestAtRuntime = FALSE;
+  UT_ASSERT_TRUE (Found > NameCount);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Creates both copies of the store with VAR_TEST_VARIABLES test names, and
+  indexes the first copy.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The stores were created.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The stores could not be created.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+VarTestSetupStores (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VARIABLE_STORE_HEADER  *Store;
+  UINTN                  Index;
+
+  if (mVarTestIndexedStore == NULL) {
+    mVarTestIndexedStore = AllocatePool (VAR_TEST_STORE_SIZE);
+    mVarTestWalkedStore  = AllocatePool (VAR_TEST_STORE_SIZE);
+    UT_ASSERT_NOT_NULL (mVarTestIndexedStore);
+    UT_ASSERT_NOT_NULL (mVarTestWalkedStore);
+  }
+
+  for (Index = 0; Index < 2; Index++) {
+    Store = (Index == 0) ? mVarTestIndexedStore : mVarTestWalkedStore;
+    SetMem (Store, VAR_TEST_STORE_SIZE, 0xFF);
+    ZeroMem (Store, sizeof (VARIABLE_STORE_HEADER));
+    Store->Size   = VAR_TEST_STORE_SIZE;
+    Store->Format = VARIABLE_STORE_FORMATTED;
+    Store->State  = VARIABLE_STORE_HEALTHY;
+  }
+
+  mVarTestLastOffset = (UINTN)GetStartPointer (mVarTestIndexedStore) - (UINTN)mVarTestIndexedStore;
+  for (mVarTestNextName = 0; mVarTestNextName < VAR_TEST_VARIABLES; mVarTestNextName++) {
+    VarTestAppendName (mVarTestNextName);
+  }
+
+  VariableStoreIndexUnregister (mVarTestIndexedStore);
+  UT_ASSERT_NOT_EFI_ERROR (VariableStoreIndexRegister (mVarTestIndexedStore));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks that lookups in the indexed store return the same variables as
+  lookups in the walked store.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+VarTestLookupMatchesWalk (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  return VarTestCompareAll (mVarTestNextName);
+}
+
+/**
+  Appends variables and updates existing ones after the index was built,
+  one state transition at a time, and checks that lookups still match the
+  walk.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+VarTestAppendAndUpdate (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR16                  Name[VAR_TEST_NAME_LENGTH];
+  VARIABLE_POINTER_TRACK  Indexed;
+  VARIABLE_POINTER_TRACK  Walked;
+  UINTN                   Index;
+  UINTN                   Number;
+  UINTN                   OldOffset;
+  UINTN                   NewOffset;
+
+  UT_ASSERT_EQUAL (VarTestCompareAll (mVarTestNextName), UNIT_TEST_PASSED);
+
+  for (Index = 0; Index < VAR_TEST_APPENDS; Index++, mVarTestNextName++) {
+    VarTestAppendName (mVarTestNextName);
+
+    //
+    // Update an existing variable the way UpdateVariable () does.
+    //
+    Number = (Index * 7919) % mVarTestNextName;
+    VarTestName (Number, Name);
+    if (EFI_ERROR (VarTestFind (mVarTestWalkedStore, Name, &mVarTestGuid[Number % VAR_TEST_GUIDS], TRUE, &Walked))) {
+      continue;
+    }
+
+    OldOffset = VarTestOffset (mVarTestWalkedStore, Walked.CurrPtr);
+    VarTestSetState (OldOffset, Walked.CurrPtr->State & VAR_IN_DELETED_TRANSITION);
+    NewOffset = VarTestAppend (Name, &mVarTestGuid[Number % VAR_TEST_GUIDS], Walked.CurrPtr->Attributes, VAR_HEADER_VALID_ONLY, 8);
+    UT_ASSERT_STATUS_EQUAL (
+      VarTestFind (mVarTestIndexedStore, Name, &mVarTestGuid[Number % VAR_TEST_GUIDS], TRUE, &Indexed),
+      EFI_SUCCESS
+      );
+    UT_ASSERT_EQUAL (VarTestOffset (mVarTestIndexedStore, Indexed.CurrPtr), OldOffset);
+
+    VarTestSetState (NewOffset, VAR_ADDED);
+    UT_ASSERT_STATUS_EQUAL (
+      VarTestFind (mVarTestIndexedStore, Name, &mVarTestGuid[Number % VAR_TEST_GUIDS], TRUE, &Indexed),
+      EFI_SUCCESS
+      );
+    UT_ASSERT_EQUAL (VarTestOffset (mVarTestIndexedStore, Indexed.CurrPtr), NewOffset);
+    UT_ASSERT_EQUAL (VarTestOffset (mVarTestIndexedStore, Indexed.InDeletedTransitionPtr), OldOffset);
+
+    VarTestSetState (OldOffset, VAR_TEST_DELETED);
+  }
+
+  return VarTestCompareAll (mVarTestNextName);
+}
+
+/**
+  Compacts both copies of the store the way Reclaim () does, invalidates
+  the index and checks that lookups still match the walk.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+VarTestReclaim (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8            *Buffer;
+  UINT8            *CurrPtr;
+  VARIABLE_HEADER  *Variable;
+  UINTN            Size;
+
+  UT_ASSERT_EQUAL (VarTestCompareAll (mVarTestNextName), UNIT_TEST_PASSED);
+
+  Buffer = AllocatePool (VAR_TEST_STORE_SIZE);
+  UT_ASSERT_NOT_NULL (Buffer);
+  SetMem (Buffer, VAR_TEST_STORE_SIZE, 0xFF);
+  CopyMem (Buffer, mVarTestIndexedStore, sizeof (VARIABLE_STORE_HEADER));
+  CurrPtr = (UINT8 *)GetStartPointer ((VARIABLE_STORE_HEADER *)Buffer);
+  for ( Variable = GetStartPointer (mVarTestIndexedStore)
+        ; IsValidVariableHeader (Variable, GetEndPointer (mVarTestIndexedStore))
+        ; Variable = GetNextVariablePtr (Variable, FALSE)
+        )
+  {
+    if ((Variable->State == VAR_ADDED) || (Variable->State == VAR_TEST_IN_DELETED)) {
+      Size = (UINTN)GetNextVariablePtr (Variable, FALSE) - (UINTN)Variable;
+      CopyMem (CurrPtr, Variable, Size);
+      CurrPtr += Size;
+    }
+  }
+
+  CopyMem (mVarTestIndexedStore, Buffer, VAR_TEST_STORE_SIZE);
+  CopyMem (mVarTestWalkedStore, Buffer, VAR_TEST_STORE_SIZE);
+  mVarTestLastOffset = (UINTN)CurrPtr - (UINTN)Buffer;
+  FreePool (Buffer);
+
+  VariableStoreIndexInvalidate (mVarTestIndexedStore);
+  UT_ASSERT_EQUAL (VarTestCompareAll (mVarTestNextName), UNIT_TEST_PASSED);
+
+  //
+  // Variables appended after the reclaim are indexed as well.
+  //
+  for ( ; mVarTestNextName < VAR_TEST_VARIABLES + 2 * VAR_TEST_APPENDS; mVarTestNextName++) {
+    VarTestAppendName (mVarTestNextName);
+  }
+
+  return VarTestCompareAll (mVarTestNextName);
+}
+
+/**
+  Checks that a variable whose name or data would go past the end of the
+  store, like a variable of a runtime cache that SMM is writing, is not
+  returned and that its name is not compared.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+VarTestPastStoreEnd (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR16                  Name[VAR_TEST_NAME_LENGTH];
+  VARIABLE_POINTER_TRACK  Indexed;
+  VARIABLE_POINTER_TRACK  Walked;
+  VARIABLE_HEADER         *Variable[2];
+  UINTN                   Offset;
+  UINTN                   Pass;
+  UINTN                   Index;
+
+  StrCpyS (Name, VAR_TEST_NAME_LENGTH, L"PastStoreEnd");
+  Offset = VarTestAppend (
+             Name,
+             &mVarTestGuid[0],
+             EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+             VAR_ADDED,
+             8
+             );
+  Variable[0] = (VARIABLE_HEADER *)((UINTN)mVarTestIndexedStore + Offset);
+  Variable[1] = (VARIABLE_HEADER *)((UINTN)mVarTestWalkedStore + Offset);
+
+  //
+  // Pass 0 makes the name go past the end of the store, pass 1 the data.
+  //
+  for (Pass = 0; Pass < 2; Pass++) {
+    for (Index = 0; Index < 2; Index++) {
+      if (Pass == 0) {
+        SetNameSizeOfVariable (Variable[Index], VAR_TEST_STORE_SIZE, FALSE);
+      } else {
+        SetDataSizeOfVariable (Variable[Index], VAR_TEST_STORE_SIZE, FALSE);
+      }
+    }
+
+    VariableStoreIndexInvalidate (mVarTestIndexedStore);
+    UT_ASSERT_STATUS_EQUAL (VarTestFind (mVarTestIndexedStore, Name, &mVarTestGuid[0], TRUE, &Indexed), EFI_NOT_FOUND);
+    UT_ASSERT_STATUS_EQUAL (VarTestFind (mVarTestWalkedStore, Name, &mVarTestGuid[0], TRUE, &Walked), EFI_NOT_FOUND);
+
+    for (Index = 0; Index < 2; Index++) {
+      SetNameSizeOfVariable (Variable[Index], StrSize (Name), FALSE);
+      SetDataSizeOfVariable (Variable[Index], 8, FALSE);
+    }
+  }
+
+  VariableStoreIndexInvalidate (mVarTestIndexedStore);
+  UT_ASSERT_STATUS_EQUAL (VarTestFind (mVarTestIndexedStore, Name, &mVarTestGuid[0], TRUE, &Indexed), EFI_SUCCESS);
+  UT_ASSERT_STATUS_EQUAL (VarTestFind (mVarTestWalkedStore, Name, &mVarTestGuid[0], TRUE, &Walked), EFI_SUCCESS);
+  UT_ASSERT_EQUAL (VarTestOffset (mVarTestIndexedStore, Indexed.CurrPtr), Offset);
+  UT_ASSERT_EQUAL (VarTestOffset (mVarTestWalkedStore, Walked.CurrPtr), Offset);
+
+  return VarTestCompareAll (mVarTestNextName);
+}
+
+/**
+  Times GetVariable () style lookups of random test names in one copy of
+  the store.
+
+  @param[in]  Store     The copy of the store.
+  @param[in]  Lookups   The number of lookups.
+
+  @return The number of lookups per second.
+**/
+UINT64
+VarTestTimeLookups (
+  IN VARIABLE_STORE_HEADER  *Store,
+  IN UINTN                  Lookups
+  )
+{
+  CHAR16                  Name[VAR_TEST_NAME_LENGTH];
+  VARIABLE_POINTER_TRACK  PtrTrack;
+  UINTN                   Index;
+  UINTN                   Number;
+  clock_t                 Start;
+  double                  Seconds;
+
+  Start = clock ();
+  for (Index = 0; Index < Lookups; Index++) {
+    Number = (Index * 2654435761u) % mVarTestNextName;
+    VarTestName (Number, Name);
+    VarTestFind (Store, Name, &mVarTestGuid[Number % VAR_TEST_GUIDS], FALSE, &PtrTrack);
+  }
+
+  Seconds = (double)(clock () - Start) / CLOCKS_PER_SEC;
+  if (Seconds <= 0) {
+    Seconds = 1.0 / CLOCKS_PER_SEC;
+  }
+
+  return (UINT64)(Lookups / Seconds);
+}
+
+/**
+  Enumerates one copy of the store the way GetNextVariableName () does.
+
+  @param[in]  Store     The copy of the store.
+  @param[out] Offsets   Returns the offsets of the variables enumerated.
+  @param[out] Count     Returns the number of variables enumerated.
+
+  @return The number of variables enumerated per second.
+**/
+UINT64
+VarTestTimeEnumeration (
+  IN  VARIABLE_STORE_HEADER  *Store,
+  OUT UINTN                  *Offsets,
+  OUT UINTN                  *Count
+  )
+{
+  VARIABLE_STORE_HEADER  *StoreList[VariableStoreTypeMax];
+  VARIABLE_HEADER        *Variable;
+  CHAR16                 *Name;
+  EFI_GUID               *Guid;
+  clock_t                Start;
+  double                 Seconds;
+
+  ZeroMem (StoreList, sizeof (StoreList));
+  StoreList[VariableStoreTypeNv] = Store;
+
+  *Count = 0;
+  Name   = L"";
+  Guid   = &mVarTestGuid[0];
+  Start  = clock ();
+  while (!EFI_ERROR (VariableServiceGetNextVariableInternal (Name, Guid, StoreList, &Variable, FALSE))) {
+    Offsets[(*Count)++] = VarTestOffset (Store, Variable);
+    Name                = GetVariableNamePtr (Variable, FALSE);
+    Guid                = GetVendorGuidPtr (Variable, FALSE);
+  }
+
+  Seconds = (double)(clock () - Start) / CLOCKS_PER_SEC;
+  if (Seconds <= 0) {
+    Seconds = 1.0 / CLOCKS_PER_SEC;
+  }
+
+  return (UINT64)(*Count / Seconds);
+}
+
+/**
+  Reports the rates of lookups and of an enumeration in the indexed and the
+  walked store, and checks that both enumerations return the same variables
+  in the same order.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+VarTestBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN   *IndexedOffsets;
+  UINTN   *WalkedOffsets;
+  UINTN   IndexedCount;
+  UINTN   WalkedCount;
+  UINT64  IndexedLookupRate;
+  UINT64  WalkedLookupRate;
+  UINT64  IndexedEnumerationRate;
+  UINT64  WalkedEnumerationRate;
+
+  IndexedOffsets = AllocatePool (2 * VAR_TEST_VARIABLES * sizeof (UINTN));
+  WalkedOffsets  = AllocatePool (2 * VAR_TEST_VARIABLES * sizeof (UINTN));
+  UT_ASSERT_NOT_NULL (IndexedOffsets);
+  UT_ASSERT_NOT_NULL (WalkedOffsets);
+
+  IndexedLookupRate      = VarTestTimeLookups (mVarTestIndexedStore, VAR_TEST_INDEXED_LOOKUPS);
+  WalkedLookupRate       = VarTestTimeLookups (mVarTestWalkedStore, VAR_TEST_WALKED_LOOKUPS);
+  IndexedEnumerationRate = VarTestTimeEnumeration (mVarTestIndexedStore, IndexedOffsets, &IndexedCount);
+  WalkedEnumerationRate  = VarTestTimeEnumeration (mVarTestWalkedStore, WalkedOffsets, &WalkedCount);
+
+  UT_LOG_INFO (
+    "%d variables: %ld indexed lookups/second, %ld walked lookups/second\n",
+    (INT32)mVarTestNextName,
+    IndexedLookupRate,
+    WalkedLookupRate
+    );
+  UT_LOG_INFO (
+    "%d variables enumerated: %ld/second indexed, %ld/second walked\n",
+    (INT32)IndexedCount,
+    IndexedEnumerationRate,
+    WalkedEnumerationRate
+    );
+
+  UT_ASSERT_EQUAL (IndexedCount, WalkedCount);
+  UT_ASSERT_MEM_EQUAL (IndexedOffsets, WalkedOffsets, IndexedCount * sizeof (UINTN));
+
+  FreePool (IndexedOffsets);
+  FreePool (WalkedOffsets);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  variable store index and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      IndexTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&IndexTests, Framework, "Variable Store Index Tests", "Variable.StoreIndex", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for Variable Store Index Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (IndexTests, "Indexed lookups match the walk", "LookupMatchesWalk", VarTestLookupMatchesWalk, VarTestSetupStores, NULL, NULL);
+  AddTestCase (IndexTests, "Appended and updated variables are found", "AppendAndUpdate", VarTestAppendAndUpdate, VarTestSetupStores, NULL, NULL);
+  AddTestCase (IndexTests, "Lookups match the walk after a reclaim", "Reclaim", VarTestReclaim, VarTestSetupStores, NULL, NULL);
+  AddTestCase (IndexTests, "Variables past the end of the store are not read", "PastStoreEnd", VarTestPastStoreEnd, VarTestSetupStores, NULL, NULL);
+  AddTestCase (IndexTests, "Lookup and enumeration rates", "Benchmark", VarTestBenchmark, VarTestSetupStores, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define VariableStoreIndexUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+VariableStoreIndexUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -341,8 +341,8 @@ RecordVarErrorFlag (
       *VarErrFlag = TempFlag;
       Status      =  SynchronizeRuntimeVariableCache (
                        &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache,
-                       0,
-                       mNvVariableCache->Size
+                       (UINTN)VarErrFlag - (UINTN)mNvVariableCache,
+                       sizeof (TempFlag)
                        );
       ASSERT_EFI_ERROR (Status);
     }
@@ -501,6 +501,13 @@ InitializeVariableQuota (
 
   Variable store garbage collection and reclaim operation.
 
+  If PcdVariableReclaimGarbageThreshold is not 0, the reclaim of the
+  non-volatile variable store is incremental: the variables before the first
+  flash block with enough garbage are left in place, and only the blocks that
+  change are written. The variables being updated that are left in place are
+  marked deleted once the new variable is written. A full reclaim is done if
+  that does not free enough space for the new variable.
+
   @param[in]      VariableBase            Base address of variable store.
   @param[out]     LastVariableOffset      Offset of last variable.
   @param[in]      IsVolatile              The variable store is volatile or not;
@@ -544,6 +551,10 @@ Reclaim (
   UINTN                  HwErrVariableTotalSize;
   VARIABLE_HEADER        *UpdatingVariable;
   VARIABLE_HEADER        *UpdatingInDeletedTransition;
+  VARIABLE_HEADER        *ReclaimStart;
+  VARIABLE_HEADER        *KeptVariable[2];
+  UINTN                  Index;
+  UINT8                  State;
   BOOLEAN                AuthFormat;
 
   AuthFormat                  = mVariableModuleGlobal->VariableGlobal.AuthFormat;
@@ -556,10 +567,6 @@ Reclaim (
 
   VariableStoreHeader = (VARIABLE_STORE_HEADER *)((UINTN)VariableBase);
 
-  CommonVariableTotalSize     = 0;
-  CommonUserVariableTotalSize = 0;
-  HwErrVariableTotalSize      = 0;
-
   if (IsVolatile || mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
     //
     // Start Pointers for the variable.
@@ -606,6 +613,23 @@ Reclaim (
     ValidBuffer       = (UINT8 *)mNvVariableCache;
   }
 
+  //
+  // The variables before ReclaimStart are kept in place.
+  //
+  ReclaimStart = GetStartPointer (VariableStoreHeader);
+  if (!IsVolatile && !mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
+    ReclaimStart = GetReclaimStartVariable (
+                     VariableStoreHeader,
+                     mNvFvHeaderCache->HeaderLength % mNvFvHeaderCache->BlockMap[0].Length,
+                     mNvFvHeaderCache->BlockMap[0].Length,
+                     PcdGet8 (PcdVariableReclaimGarbageThreshold),
+                     UpdatingVariable,
+                     UpdatingInDeletedTransition,
+                     AuthFormat
+                     );
+  }
+
+Compact:
   SetMem (ValidBuffer, MaximumBufferSize, 0xff);
 
   //
@@ -614,10 +638,37 @@ Reclaim (
   CopyMem (ValidBuffer, VariableStoreHeader, sizeof (VARIABLE_STORE_HEADER));
   CurrPtr = (UINT8 *)GetStartPointer ((VARIABLE_STORE_HEADER *)ValidBuffer);
 
+  //
+  // Copy the variables kept in place.
+  //
+  CommonVariableTotalSize     = 0;
+  CommonUserVariableTotalSize = 0;
+  HwErrVariableTotalSize      = 0;
+  Variable                    = GetStartPointer (VariableStoreHeader);
+  CopyMem (CurrPtr, Variable, (UINTN)ReclaimStart - (UINTN)Variable);
+  CurrPtr += (UINTN)ReclaimStart - (UINTN)Variable;
+  while (Variable < ReclaimStart) {
+    //
+    // The deleted variables kept in place still take space.
+    //
+    NextVariable = GetNextVariablePtr (Variable, AuthFormat);
+    VariableSize = (UINTN)NextVariable - (UINTN)Variable;
+    if ((Variable->Attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD) == EFI_VARIABLE_HARDWARE_ERROR_RECORD) {
+      HwErrVariableTotalSize += VariableSize;
+    } else {
+      CommonVariableTotalSize += VariableSize;
+      if (IsUserVariable (Variable)) {
+        CommonUserVariableTotalSize += VariableSize;
+      }
+    }
+
+    Variable = NextVariable;
+  }
+
   //
   // Reinstall all ADDED variables as long as they are not identical to Updating Variable.
   //
-  Variable = GetStartPointer (VariableStoreHeader);
+  Variable = ReclaimStart;
   while (IsValidVariableHeader (Variable, GetEndPointer (VariableStoreHeader))) {
     NextVariable = GetNextVariablePtr (Variable, AuthFormat);
     if ((Variable != UpdatingVariable) && (Variable->State == VAR_ADDED)) {
@@ -640,7 +691,7 @@ Reclaim (
   //
   // Reinstall all in delete transition variables.
   //
-  Variable = GetStartPointer (VariableStoreHeader);
+  Variable = ReclaimStart;
   while (IsValidVariableHeader (Variable, GetEndPointer (VariableStoreHeader))) {
     NextVariable = GetNextVariablePtr (Variable, AuthFormat);
     if ((Variable != UpdatingVariable) && (Variable != UpdatingInDeletedTransition) && (Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED))) {
@@ -655,7 +706,7 @@ Reclaim (
       while (IsValidVariableHeader (AddedVariable, GetEndPointer ((VARIABLE_STORE_HEADER *)ValidBuffer))) {
         NextAddedVariable = GetNextVariablePtr (AddedVariable, AuthFormat);
         NameSize          = NameSizeOfVariable (AddedVariable, AuthFormat);
-        if (CompareGuid (
+        if ((AddedVariable->State == VAR_ADDED) && CompareGuid (
               GetVendorGuidPtr (AddedVariable, AuthFormat),
               GetVendorGuidPtr (Variable, AuthFormat)
               ) && (NameSize == NameSizeOfVariable (Variable, AuthFormat)))
@@ -698,6 +749,14 @@ Reclaim (
   //
   if (NewVariable != NULL) {
     if (((UINTN)CurrPtr - (UINTN)ValidBuffer) + NewVariableSize > VariableStoreHeader->Size) {
+      if (ReclaimStart != GetStartPointer (VariableStoreHeader)) {
+        //
+        // The incremental reclaim does not free enough space, do a full one.
+        //
+        ReclaimStart = GetStartPointer (VariableStoreHeader);
+        goto Compact;
+      }
+
       //
       // No enough space to store the new variable.
       //
@@ -719,6 +778,11 @@ Reclaim (
           (CommonVariableTotalSize > mVariableModuleGlobal->CommonVariableSpace) ||
           (CommonUserVariableTotalSize > mVariableModuleGlobal->CommonMaxUserVariableSpace))
       {
+        if (ReclaimStart != GetStartPointer (VariableStoreHeader)) {
+          ReclaimStart = GetStartPointer (VariableStoreHeader);
+          goto Compact;
+        }
+
         //
         // No enough space to store the new variable by NV or NV+HR attribute.
         //
@@ -763,6 +827,27 @@ Reclaim (
                (VARIABLE_STORE_HEADER *)ValidBuffer
                );
     if (!EFI_ERROR (Status)) {
+      //
+      // The variables being updated that were kept in place are in deleted
+      // transition, now that the new variable is written they can be deleted.
+      //
+      KeptVariable[0] = UpdatingVariable;
+      KeptVariable[1] = UpdatingInDeletedTransition;
+      for (Index = 0; Index < ARRAY_SIZE (KeptVariable); Index++) {
+        if ((KeptVariable[Index] != NULL) && (KeptVariable[Index] < ReclaimStart)) {
+          State = KeptVariable[Index]->State & VAR_DELETED;
+          UpdateVariableStore (
+            &mVariableModuleGlobal->VariableGlobal,
+            FALSE,
+            FALSE,
+            mVariableModuleGlobal->FvbInstance,
+            (UINTN)&KeptVariable[Index]->State,
+            sizeof (UINT8),
+            &State
+            );
+        }
+      }
+
       *LastVariableOffset                                = (UINTN)CurrPtr - (UINTN)ValidBuffer;
       mVariableModuleGlobal->HwErrVariableTotalSize      = HwErrVariableTotalSize;
       mVariableModuleGlobal->CommonVariableTotalSize     = CommonVariableTotalSize;
@@ -792,6 +877,19 @@ Reclaim (
   }
 
 Done:
+  //
+  // The variables have been moved, the indexes of the store and of its
+  // runtime cache must be rebuilt.
+  //
+  VariableStoreIndexInvalidate (VariableStoreHeader);
+  if (!IsVolatile) {
+    VariableStoreIndexInvalidate (mNvVariableCache);
+  }
+
+  if (mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.RewriteCount != NULL) {
+    *(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.RewriteCount) += 1;
+  }
+
   DoneStatus = EFI_SUCCESS;
   if (IsVolatile || mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
     DoneStatus = SynchronizeRuntimeVariableCache (
@@ -1656,6 +1754,65 @@ AutoUpdateLangVariable (
   }
 }
 
+/**
+  Synchronizes the runtime cache of a variable store with an update of a variable.
+
+  An update only appends variables to the store and changes the state of the
+  variable that was updated, so only these parts of the store are copied. When
+  the store is reclaimed during the update, the reclaim synchronizes the whole
+  runtime cache and the copies done here are harmless.
+
+  @param[in] VariableRuntimeCache   The runtime cache of the variable store.
+  @param[in] VariableStoreHeader    The variable store, the NV variable cache for
+                                    the non-volatile store.
+  @param[in] Variable               The variable that was updated, in VariableStoreHeader.
+  @param[in] StartOffset            The end of the variables of the store before the update.
+  @param[in] EndOffset              The end of the variables of the store after the update.
+
+  @return The status of SynchronizeRuntimeVariableCacheRanges ().
+
+**/
+EFI_STATUS
+SynchronizeUpdatedVariable (
+  IN VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN VARIABLE_STORE_HEADER   *VariableStoreHeader,
+  IN VARIABLE_POINTER_TRACK  *Variable,
+  IN UINTN                   StartOffset,
+  IN UINTN                   EndOffset
+  )
+{
+  VARIABLE_STORE_RANGE  Ranges[3];
+  VARIABLE_HEADER       *UpdatedVariable[2];
+  UINTN                 RangeCount;
+  UINTN                 Index;
+
+  if (VariableRuntimeCache->Store == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  RangeCount         = 0;
+  UpdatedVariable[0] = Variable->CurrPtr;
+  UpdatedVariable[1] = Variable->InDeletedTransitionPtr;
+  for (Index = 0; Index < ARRAY_SIZE (UpdatedVariable); Index++) {
+    if ((UpdatedVariable[Index] != NULL) &&
+        (UpdatedVariable[Index] >= GetStartPointer (VariableStoreHeader)) &&
+        (UpdatedVariable[Index] < GetEndPointer (VariableStoreHeader)))
+    {
+      Ranges[RangeCount].Offset = (UINTN)&UpdatedVariable[Index]->State - (UINTN)VariableStoreHeader;
+      Ranges[RangeCount].Length = sizeof (UpdatedVariable[Index]->State);
+      RangeCount++;
+    }
+  }
+
+  if (EndOffset > StartOffset) {
+    Ranges[RangeCount].Offset = StartOffset;
+    Ranges[RangeCount].Length = EndOffset - StartOffset;
+    RangeCount++;
+  }
+
+  return SynchronizeRuntimeVariableCacheRanges (VariableRuntimeCache, RangeCount, Ranges);
+}
+
 /**
   Update the variable region with Variable information. If EFI_VARIABLE_AUTHENTICATED_WRITE_ACCESS is set,
   index of associated public key is needed.
@@ -1710,6 +1867,8 @@ UpdateVariable (
   BOOLEAN                             IsCommonUserVariable;
   AUTHENTICATED_VARIABLE_HEADER       *AuthVariable;
   BOOLEAN                             AuthFormat;
+  UINTN                               NonVolatileLastVariableOffset;
+  UINTN                               VolatileLastVariableOffset;
 
   if ((mVariableModuleGlobal->FvbInstance == NULL) && !mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
     //
@@ -1733,6 +1892,13 @@ UpdateVariable (
 
   AuthFormat = mVariableModuleGlobal->VariableGlobal.AuthFormat;
 
+  //
+  // The new variables are appended after these offsets, the runtime cache
+  // only needs the part of the store that follows them.
+  //
+  NonVolatileLastVariableOffset = mVariableModuleGlobal->NonVolatileLastVariableOffset;
+  VolatileLastVariableOffset    = mVariableModuleGlobal->VolatileLastVariableOffset;
+
   //
   // Check if CacheVariable points to the variable in variable HOB.
   // If yes, let CacheVariable points to the variable in NV variable cache.
@@ -2389,18 +2555,27 @@ Done:
   if (!EFI_ERROR (Status)) {
     if (((Variable->CurrPtr != NULL) && !Variable->Volatile) || ((Attributes & EFI_VARIABLE_NON_VOLATILE) != 0)) {
       VolatileCacheInstance = &(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache);
+      VariableStoreHeader   = mNvVariableCache;
+      Status                = SynchronizeUpdatedVariable (
+                                VolatileCacheInstance,
+                                VariableStoreHeader,
+                                CacheVariable,
+                                NonVolatileLastVariableOffset,
+                                mVariableModuleGlobal->NonVolatileLastVariableOffset
+                                );
     } else {
       VolatileCacheInstance = &(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeVolatileCache);
+      VariableStoreHeader   = (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+      Status                = SynchronizeUpdatedVariable (
+                                VolatileCacheInstance,
+                                VariableStoreHeader,
+                                CacheVariable,
+                                VolatileLastVariableOffset,
+                                mVariableModuleGlobal->VolatileLastVariableOffset
+                                );
     }
 
-    if (VolatileCacheInstance->Store != NULL) {
-      Status =  SynchronizeRuntimeVariableCache (
-                  VolatileCacheInstance,
-                  0,
-                  VolatileCacheInstance->Store->Size
-                  );
-      ASSERT_EFI_ERROR (Status);
-    }
+    ASSERT_EFI_ERROR (Status);
   }
 
   return Status;
@@ -3809,6 +3984,16 @@ VariableCommonInitialize (
   VolatileVariableStore->Reserved  = 0;
   VolatileVariableStore->Reserved1 = 0;
 
+  //
+  // Index the variable stores searched by FindVariable (). The stores are
+  // still walked if they cannot be indexed.
+  //
+  VariableStoreIndexRegister (VolatileVariableStore);
+  VariableStoreIndexRegister (mNvVariableCache);
+  if (mVariableModuleGlobal->VariableGlobal.HobVariableBase != 0) {
+    VariableStoreIndexRegister ((VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase);
+  }
+
   return EFI_SUCCESS;
 }
 
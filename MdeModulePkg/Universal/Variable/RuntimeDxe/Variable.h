@@ -71,6 +71,8 @@ typedef struct {
   BOOLEAN                   *ReadLock;
   BOOLEAN                   *PendingUpdate;
   BOOLEAN                   *HobFlushComplete;
+  UINT32                    *RewriteCount;
+  UINT32                    *SequenceCount;
   VARIABLE_RUNTIME_CACHE    VariableRuntimeHobCache;
   VARIABLE_RUNTIME_CACHE    VariableRuntimeNvCache;
   VARIABLE_RUNTIME_CACHE    VariableRuntimeVolatileCache;
@@ -157,6 +159,58 @@ FtwVariableSpace (
   IN VARIABLE_STORE_HEADER  *VariableBuffer
   );
 
+/**
+  Gets the range of a variable store that differs from a new image of it,
+  extended to whole flash blocks.
+
+  @param[in]  Current       The current content of the variable store.
+  @param[in]  New           The new content of the variable store.
+  @param[in]  Size          The size of the variable store.
+  @param[in]  BlockOffset   The offset of the variable store in its first flash block.
+  @param[in]  BlockSize     The size of a flash block, or 0 to not extend the range.
+  @param[out] Start         Returns the offset of the start of the range.
+  @param[out] End           Returns the offset of the end of the range, equal to
+                            Start if the contents are the same.
+
+**/
+VOID
+GetVariableSpaceChangedRange (
+  IN  CONST UINT8  *Current,
+  IN  CONST UINT8  *New,
+  IN  UINTN        Size,
+  IN  UINTN        BlockOffset,
+  IN  UINTN        BlockSize,
+  OUT UINTN        *Start,
+  OUT UINTN        *End
+  );
+
+/**
+  Finds the first variable moved by an incremental reclaim.
+
+  @param[in] VariableStoreHeader          The variable store.
+  @param[in] BlockOffset                  The offset of the variable store in its first flash block.
+  @param[in] BlockSize                    The size of a flash block.
+  @param[in] GarbageThreshold             The garbage ratio, in percent, of a block to compact.
+  @param[in] UpdatingVariable             The variable being updated, or NULL.
+  @param[in] UpdatingInDeletedTransition  The variable in deleted transition being updated, or NULL.
+  @param[in] AuthFormat                   TRUE indicates authenticated variables are used.
+                                          FALSE indicates authenticated variables are not used.
+
+  @return The first variable to compact, the first variable of the store if no
+          block has enough garbage to compact the store incrementally.
+
+**/
+VARIABLE_HEADER *
+GetReclaimStartVariable (
+  IN VARIABLE_STORE_HEADER  *VariableStoreHeader,
+  IN UINTN                  BlockOffset,
+  IN UINTN                  BlockSize,
+  IN UINT8                  GarbageThreshold,
+  IN VARIABLE_HEADER        *UpdatingVariable  OPTIONAL,
+  IN VARIABLE_HEADER        *UpdatingInDeletedTransition  OPTIONAL,
+  IN BOOLEAN                AuthFormat
+  );
+
 /**
   Finds variable in storage blocks of volatile and non-volatile storage areas.
 
@@ -37,6 +37,58 @@ IsValidVariableHeader (
   return TRUE;
 }
 
+/**
+
+  This code checks that the header, name and data of a variable end before the end of its
+  variable store.
+
+  The runtime caches may be read while SMM updates them, so the sizes are read once and
+  returned, for the caller to use them instead of reading them again.
+
+  @param[in]  Variable           Pointer to the Variable Header.
+  @param[in]  VariableStoreEnd   Pointer to the Variable Store End.
+  @param[in]  AuthFormat         TRUE indicates authenticated variables are used.
+                                 FALSE indicates authenticated variables are not used.
+  @param[out] NameSize           Size of the name of the variable.
+  @param[out] DataSize           Size of the data of the variable.
+
+  @retval TRUE              The variable is within the variable store.
+  @retval FALSE             The variable goes past the end of the variable store.
+
+**/
+BOOLEAN
+IsVariableInStore (
+  IN  VARIABLE_HEADER  *Variable,
+  IN  VARIABLE_HEADER  *VariableStoreEnd,
+  IN  BOOLEAN          AuthFormat,
+  OUT UINTN            *NameSize,
+  OUT UINTN            *DataSize
+  )
+{
+  UINTN  End;
+  UINTN  NamePtr;
+  UINTN  DataPtr;
+
+  End = (UINTN)VariableStoreEnd;
+  if (((UINTN)Variable > End) || (GetVariableHeaderSize (AuthFormat) > End - (UINTN)Variable)) {
+    return FALSE;
+  }
+
+  *NameSize = NameSizeOfVariable (Variable, AuthFormat);
+  *DataSize = DataSizeOfVariable (Variable, AuthFormat);
+  NamePtr   = (UINTN)GetVariableNamePtr (Variable, AuthFormat);
+  if (*NameSize > End - NamePtr) {
+    return FALSE;
+  }
+
+  DataPtr = NamePtr + *NameSize + GET_PAD_SIZE (*NameSize);
+  if ((DataPtr > End) || (*DataSize > End - DataPtr)) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 /**
 
   This code gets the current status of Variable Store.
@@ -467,9 +519,51 @@ FindVariableEx (
   IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
   IN     BOOLEAN                 AuthFormat
   )
+{
+  EFI_STATUS  Status;
+
+  //
+  // Look the variable up in the hash index of the store, if it has one.
+  //
+  if (FeaturePcdGet (PcdVariableStoreHashIndexEnable) && (VariableName[0] != 0)) {
+    PtrTrack->InDeletedTransitionPtr = NULL;
+    Status                           = VariableStoreIndexFind (VariableName, VendorGuid, IgnoreRtCheck, PtrTrack, AuthFormat);
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
+  }
+
+  return FindVariableByWalk (VariableName, VendorGuid, IgnoreRtCheck, PtrTrack, AuthFormat);
+}
+
+/**
+  Find the variable in the specified variable store by walking all the
+  variables of the store, without using the hash index of the store.
+
+  @param[in]       VariableName        Name of the variable to be found
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+  @param[in]       AuthFormat          TRUE indicates authenticated variables are used.
+                                       FALSE indicates authenticated variables are not used.
+
+  @retval          EFI_SUCCESS         Variable found successfully
+  @retval          EFI_NOT_FOUND       Variable not found
+**/
+EFI_STATUS
+FindVariableByWalk (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
+  IN     BOOLEAN                 AuthFormat
+  )
 {
   VARIABLE_HEADER  *InDeletedVariable;
   VOID             *Point;
+  UINTN            NameSize;
+  UINTN            DataSize;
 
   PtrTrack->InDeletedTransitionPtr = NULL;
 
@@ -483,6 +577,13 @@ FindVariableEx (
         ; PtrTrack->CurrPtr = GetNextVariablePtr (PtrTrack->CurrPtr, AuthFormat)
         )
   {
+    //
+    // A variable of a runtime cache that SMM is writing may have any size.
+    //
+    if (!IsVariableInStore (PtrTrack->CurrPtr, PtrTrack->EndPtr, AuthFormat, &NameSize, &DataSize)) {
+      break;
+    }
+
     if ((PtrTrack->CurrPtr->State == VAR_ADDED) ||
         (PtrTrack->CurrPtr->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED))
         )
@@ -499,8 +600,8 @@ FindVariableEx (
           if (CompareGuid (VendorGuid, GetVendorGuidPtr (PtrTrack->CurrPtr, AuthFormat))) {
             Point = (VOID *)GetVariableNamePtr (PtrTrack->CurrPtr, AuthFormat);
 
-            ASSERT (NameSizeOfVariable (PtrTrack->CurrPtr, AuthFormat) != 0);
-            if (CompareMem (VariableName, Point, NameSizeOfVariable (PtrTrack->CurrPtr, AuthFormat)) == 0) {
+            ASSERT (NameSize != 0);
+            if (CompareMem (VariableName, Point, NameSize) == 0) {
               if (PtrTrack->CurrPtr->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
                 InDeletedVariable = PtrTrack->CurrPtr;
               } else {
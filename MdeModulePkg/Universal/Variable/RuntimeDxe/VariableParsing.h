@@ -12,6 +12,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <Guid/ImageAuthentication.h>
 #include "Variable.h"
+#include "VariableStoreIndex.h"
 
 /**
 
@@ -30,6 +31,34 @@ IsValidVariableHeader (
   IN  VARIABLE_HEADER  *VariableStoreEnd
   );
 
+/**
+
+  This code checks that the header, name and data of a variable end before the end of its
+  variable store.
+
+  The runtime caches may be read while SMM updates them, so the sizes are read once and
+  returned, for the caller to use them instead of reading them again.
+
+  @param[in]  Variable           Pointer to the Variable Header.
+  @param[in]  VariableStoreEnd   Pointer to the Variable Store End.
+  @param[in]  AuthFormat         TRUE indicates authenticated variables are used.
+                                 FALSE indicates authenticated variables are not used.
+  @param[out] NameSize           Size of the name of the variable.
+  @param[out] DataSize           Size of the data of the variable.
+
+  @retval TRUE              The variable is within the variable store.
+  @retval FALSE             The variable goes past the end of the variable store.
+
+**/
+BOOLEAN
+IsVariableInStore (
+  IN  VARIABLE_HEADER  *Variable,
+  IN  VARIABLE_HEADER  *VariableStoreEnd,
+  IN  BOOLEAN          AuthFormat,
+  OUT UINTN            *NameSize,
+  OUT UINTN            *DataSize
+  );
+
 /**
 
   This code gets the current status of Variable Store.
@@ -280,6 +309,30 @@ FindVariableEx (
   IN     BOOLEAN                 AuthFormat
   );
 
+/**
+  Find the variable in the specified variable store by walking all the
+  variables of the store, without using the hash index of the store.
+
+  @param[in]       VariableName        Name of the variable to be found
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+  @param[in]       AuthFormat          TRUE indicates authenticated variables are used.
+                                       FALSE indicates authenticated variables are not used.
+
+  @retval          EFI_SUCCESS         Variable found successfully
+  @retval          EFI_NOT_FOUND       Variable not found
+**/
+EFI_STATUS
+FindVariableByWalk (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
+  IN     BOOLEAN                 AuthFormat
+  );
+
 /**
   This code finds the next available variable.
 
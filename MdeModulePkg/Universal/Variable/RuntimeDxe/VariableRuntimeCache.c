@@ -18,9 +18,138 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 extern VARIABLE_MODULE_GLOBAL  *mVariableModuleGlobal;
 extern VARIABLE_STORE_HEADER   *mNvVariableCache;
 
+/**
+  Returns the variable store a runtime variable cache is a copy of.
+
+  @param[in] VariableRuntimeCache Variable runtime cache structure of the runtime cache.
+
+  @return The variable store, or NULL if the store does not exist.
+
+**/
+STATIC
+VARIABLE_STORE_HEADER *
+GetRuntimeVariableCacheSource (
+  IN  VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *VariableRuntimeCacheContext;
+
+  VariableRuntimeCacheContext = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+
+  if (VariableRuntimeCache == &VariableRuntimeCacheContext->VariableRuntimeHobCache) {
+    return (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase;
+  } else if (VariableRuntimeCache == &VariableRuntimeCacheContext->VariableRuntimeNvCache) {
+    return mNvVariableCache;
+  }
+
+  return (VARIABLE_STORE_HEADER *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+}
+
+/**
+  Starts an update of the runtime variable caches.
+
+  The sequence count becomes odd until EndRuntimeVariableCacheUpdate () is called, so that the readers of the
+  runtime caches, which may run on other processors, retry the reads that overlap the update.
+
+**/
+STATIC
+VOID
+BeginRuntimeVariableCacheUpdate (
+  VOID
+  )
+{
+  volatile UINT32  *SequenceCount;
+
+  SequenceCount  = mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.SequenceCount;
+  *SequenceCount = *SequenceCount + 1;
+  MemoryFence ();
+}
+
+/**
+  Ends an update of the runtime variable caches started by BeginRuntimeVariableCacheUpdate ().
+
+**/
+STATIC
+VOID
+EndRuntimeVariableCacheUpdate (
+  VOID
+  )
+{
+  volatile UINT32  *SequenceCount;
+
+  MemoryFence ();
+  SequenceCount  = mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.SequenceCount;
+  *SequenceCount = *SequenceCount + 1;
+}
+
+/**
+  Copies a range of a variable store to its runtime cache.
+
+  @param[in] VariableRuntimeCache Variable runtime cache structure for the runtime cache being updated.
+  @param[in] Offset               Offset in bytes of the range.
+  @param[in] Length               Length of data in bytes of the range.
+
+**/
+STATIC
+VOID
+CopyToRuntimeVariableCache (
+  IN  VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN  UINTN                   Offset,
+  IN  UINTN                   Length
+  )
+{
+  VARIABLE_STORE_HEADER  *VariableStore;
+
+  VariableStore = GetRuntimeVariableCacheSource (VariableRuntimeCache);
+  if ((VariableRuntimeCache->Store == NULL) || (VariableStore == NULL) || (Length == 0)) {
+    return;
+  }
+
+  CopyMem (
+    (UINT8 *)(UINTN)VariableRuntimeCache->Store + Offset,
+    (UINT8 *)(UINTN)VariableStore + Offset,
+    Length
+    );
+}
+
+/**
+  Copies the pending updates of all the runtime variable caches. The caller must have started an update of the
+  runtime caches.
+
+**/
+STATIC
+VOID
+CopyPendingRuntimeVariableCacheUpdates (
+  VOID
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *VariableRuntimeCacheContext;
+  VARIABLE_RUNTIME_CACHE          *VariableRuntimeCache[3];
+  UINTN                           Index;
+
+  VariableRuntimeCacheContext = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+  VariableRuntimeCache[0]     = &VariableRuntimeCacheContext->VariableRuntimeHobCache;
+  VariableRuntimeCache[1]     = &VariableRuntimeCacheContext->VariableRuntimeNvCache;
+  VariableRuntimeCache[2]     = &VariableRuntimeCacheContext->VariableRuntimeVolatileCache;
+
+  for (Index = 0; Index < ARRAY_SIZE (VariableRuntimeCache); Index++) {
+    CopyToRuntimeVariableCache (
+      VariableRuntimeCache[Index],
+      VariableRuntimeCache[Index]->PendingUpdateOffset,
+      VariableRuntimeCache[Index]->PendingUpdateLength
+      );
+    VariableRuntimeCache[Index]->PendingUpdateLength = 0;
+    VariableRuntimeCache[Index]->PendingUpdateOffset = 0;
+  }
+
+  *(VariableRuntimeCacheContext->PendingUpdate) = FALSE;
+}
+
 /**
   Copies any pending updates to runtime variable caches.
 
+  Nothing is copied while the ReadLock is taken, the updates stay pending.
+
   @retval EFI_UNSUPPORTED         The volatile store to be updated is not initialized properly.
   @retval EFI_SUCCESS             The volatile store was updated successfully.
 
@@ -36,58 +165,17 @@ FlushPendingRuntimeVariableCacheUpdates (
 
   if ((VariableRuntimeCacheContext->VariableRuntimeNvCache.Store == NULL) ||
       (VariableRuntimeCacheContext->VariableRuntimeVolatileCache.Store == NULL) ||
-      (VariableRuntimeCacheContext->PendingUpdate == NULL))
+      (VariableRuntimeCacheContext->PendingUpdate == NULL) ||
+      (VariableRuntimeCacheContext->ReadLock == NULL) ||
+      (VariableRuntimeCacheContext->SequenceCount == NULL))
   {
     return EFI_UNSUPPORTED;
   }
 
-  if (*(VariableRuntimeCacheContext->PendingUpdate)) {
-    if ((VariableRuntimeCacheContext->VariableRuntimeHobCache.Store != NULL) &&
-        (mVariableModuleGlobal->VariableGlobal.HobVariableBase > 0))
-    {
-      CopyMem (
-        (VOID *)(
-                 ((UINT8 *)(UINTN)VariableRuntimeCacheContext->VariableRuntimeHobCache.Store) +
-                 VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset
-                 ),
-        (VOID *)(
-                 ((UINT8 *)(UINTN)mVariableModuleGlobal->VariableGlobal.HobVariableBase) +
-                 VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset
-                 ),
-        VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateLength
-        );
-      VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateLength = 0;
-      VariableRuntimeCacheContext->VariableRuntimeHobCache.PendingUpdateOffset = 0;
-    }
-
-    CopyMem (
-      (VOID *)(
-               ((UINT8 *)(UINTN)VariableRuntimeCacheContext->VariableRuntimeNvCache.Store) +
-               VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset
-               ),
-      (VOID *)(
-               ((UINT8 *)(UINTN)mNvVariableCache) +
-               VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset
-               ),
-      VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateLength
-      );
-    VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateLength = 0;
-    VariableRuntimeCacheContext->VariableRuntimeNvCache.PendingUpdateOffset = 0;
-
-    CopyMem (
-      (VOID *)(
-               ((UINT8 *)(UINTN)VariableRuntimeCacheContext->VariableRuntimeVolatileCache.Store) +
-               VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset
-               ),
-      (VOID *)(
-               ((UINT8 *)(UINTN)mVariableModuleGlobal->VariableGlobal.VolatileVariableBase) +
-               VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset
-               ),
-      VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength
-      );
-    VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateLength = 0;
-    VariableRuntimeCacheContext->VariableRuntimeVolatileCache.PendingUpdateOffset = 0;
-    *(VariableRuntimeCacheContext->PendingUpdate)                                 = FALSE;
+  if (*(VariableRuntimeCacheContext->PendingUpdate) && !*(VariableRuntimeCacheContext->ReadLock)) {
+    BeginRuntimeVariableCacheUpdate ();
+    CopyPendingRuntimeVariableCacheUpdates ();
+    EndRuntimeVariableCacheUpdate ();
   }
 
   return EFI_SUCCESS;
@@ -117,6 +205,44 @@ SynchronizeRuntimeVariableCache (
   IN  UINTN                   Length
   )
 {
+  VARIABLE_STORE_RANGE  Range;
+
+  Range.Offset = Offset;
+  Range.Length = Length;
+
+  return SynchronizeRuntimeVariableCacheRanges (VariableRuntimeCache, 1, &Range);
+}
+
+/**
+  Synchronizes the runtime variable caches with all pending updates outside runtime, and with several ranges of
+  a variable store.
+
+  The ranges are copied in a single update of the runtime caches, so a reader of the runtime caches sees either
+  none or all of them. If the ReadLock is taken, the ranges are merged into the pending update of the given
+  variable store instead.
+
+  @param[in] VariableRuntimeCache Variable runtime cache structure for the runtime cache being synchronized.
+  @param[in] RangeCount           The number of ranges.
+  @param[in] Ranges               The ranges of the variable store that were updated.
+
+  @retval EFI_SUCCESS             The ranges were added as a pending update successfully. If the variable runtime
+                                  cache ReadLock was available, the runtime cache was updated successfully.
+  @retval EFI_INVALID_PARAMETER   VariableRuntimeCache is NULL.
+  @retval EFI_UNSUPPORTED         The volatile store to be updated is not initialized properly.
+
+**/
+EFI_STATUS
+SynchronizeRuntimeVariableCacheRanges (
+  IN  VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN  UINTN                   RangeCount,
+  IN  VARIABLE_STORE_RANGE    *Ranges
+  )
+{
+  VARIABLE_RUNTIME_CACHE_CONTEXT  *VariableRuntimeCacheContext;
+  UINTN                           Index;
+  UINTN                           Offset;
+  UINTN                           Length;
+
   if (VariableRuntimeCache == NULL) {
     return EFI_INVALID_PARAMETER;
   } else if (VariableRuntimeCache->Store == NULL) {
@@ -125,34 +251,61 @@ SynchronizeRuntimeVariableCache (
     return EFI_SUCCESS;
   }
 
-  if ((mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate == NULL) ||
-      (mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.ReadLock == NULL))
+  VariableRuntimeCacheContext = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
+
+  if ((VariableRuntimeCacheContext->PendingUpdate == NULL) ||
+      (VariableRuntimeCacheContext->ReadLock == NULL) ||
+      (VariableRuntimeCacheContext->SequenceCount == NULL) ||
+      (VariableRuntimeCacheContext->VariableRuntimeNvCache.Store == NULL) ||
+      (VariableRuntimeCacheContext->VariableRuntimeVolatileCache.Store == NULL))
   {
     return EFI_UNSUPPORTED;
   }
 
-  if (*(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate) &&
-      (VariableRuntimeCache->PendingUpdateLength > 0))
-  {
-    VariableRuntimeCache->PendingUpdateLength =
-      (UINT32)(
-               MAX (
-                 (UINTN)(VariableRuntimeCache->PendingUpdateOffset + VariableRuntimeCache->PendingUpdateLength),
-                 Offset + Length
-                 ) - MIN ((UINTN)VariableRuntimeCache->PendingUpdateOffset, Offset)
-               );
-    VariableRuntimeCache->PendingUpdateOffset =
-      (UINT32)MIN ((UINTN)VariableRuntimeCache->PendingUpdateOffset, Offset);
-  } else {
-    VariableRuntimeCache->PendingUpdateLength = (UINT32)Length;
-    VariableRuntimeCache->PendingUpdateOffset = (UINT32)Offset;
+  if (*(VariableRuntimeCacheContext->ReadLock)) {
+    for (Index = 0; Index < RangeCount; Index++) {
+      Offset = Ranges[Index].Offset;
+      Length = Ranges[Index].Length;
+      if (Length == 0) {
+        continue;
+      }
+
+      if (*(VariableRuntimeCacheContext->PendingUpdate) &&
+          (VariableRuntimeCache->PendingUpdateLength > 0))
+      {
+        VariableRuntimeCache->PendingUpdateLength =
+          (UINT32)(
+                   MAX (
+                     (UINTN)(VariableRuntimeCache->PendingUpdateOffset + VariableRuntimeCache->PendingUpdateLength),
+                     Offset + Length
+                     ) - MIN ((UINTN)VariableRuntimeCache->PendingUpdateOffset, Offset)
+                   );
+        VariableRuntimeCache->PendingUpdateOffset =
+          (UINT32)MIN ((UINTN)VariableRuntimeCache->PendingUpdateOffset, Offset);
+      } else {
+        VariableRuntimeCache->PendingUpdateLength = (UINT32)Length;
+        VariableRuntimeCache->PendingUpdateOffset = (UINT32)Offset;
+      }
+
+      *(VariableRuntimeCacheContext->PendingUpdate) = TRUE;
+    }
+
+    return EFI_SUCCESS;
   }
 
-  *(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.PendingUpdate) = TRUE;
+  //
+  // Only the given ranges, and the updates that were left pending, are copied.
+  //
+  BeginRuntimeVariableCacheUpdate ();
+  if (*(VariableRuntimeCacheContext->PendingUpdate)) {
+    CopyPendingRuntimeVariableCacheUpdates ();
+  }
 
-  if (*(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.ReadLock) == FALSE) {
-    return FlushPendingRuntimeVariableCacheUpdates ();
+  for (Index = 0; Index < RangeCount; Index++) {
+    CopyToRuntimeVariableCache (VariableRuntimeCache, Ranges[Index].Offset, Ranges[Index].Length);
   }
 
+  EndRuntimeVariableCacheUpdate ();
+
   return EFI_SUCCESS;
 }
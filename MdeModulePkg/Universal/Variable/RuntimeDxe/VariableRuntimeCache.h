@@ -12,9 +12,19 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "Variable.h"
 
+///
+/// A range of a variable store, in bytes from the start of the store.
+///
+typedef struct {
+  UINTN    Offset;
+  UINTN    Length;
+} VARIABLE_STORE_RANGE;
+
 /**
   Copies any pending updates to runtime variable caches.
 
+  Nothing is copied while the ReadLock is taken, the updates stay pending.
+
   @retval EFI_UNSUPPORTED         The volatile store to be updated is not initialized properly.
   @retval EFI_SUCCESS             The volatile store was updated successfully.
 
@@ -48,4 +58,29 @@ SynchronizeRuntimeVariableCache (
   IN  UINTN                   Length
   );
 
+/**
+  Synchronizes the runtime variable caches with all pending updates outside runtime, and with several ranges of
+  a variable store.
+
+  The ranges are copied in a single update of the runtime caches, so a reader of the runtime caches sees either
+  none or all of them. If the ReadLock is taken, the ranges are merged into the pending update of the given
+  variable store instead.
+
+  @param[in] VariableRuntimeCache Variable runtime cache structure for the runtime cache being synchronized.
+  @param[in] RangeCount           The number of ranges.
+  @param[in] Ranges               The ranges of the variable store that were updated.
+
+  @retval EFI_SUCCESS             The ranges were added as a pending update successfully. If the variable runtime
+                                  cache ReadLock was available, the runtime cache was updated successfully.
+  @retval EFI_INVALID_PARAMETER   VariableRuntimeCache is NULL.
+  @retval EFI_UNSUPPORTED         The volatile store to be updated is not initialized properly.
+
+**/
+EFI_STATUS
+SynchronizeRuntimeVariableCacheRanges (
+  IN  VARIABLE_RUNTIME_CACHE  *VariableRuntimeCache,
+  IN  UINTN                   RangeCount,
+  IN  VARIABLE_STORE_RANGE    *Ranges
+  );
+
 #endif
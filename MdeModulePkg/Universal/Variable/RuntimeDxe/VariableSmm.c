@@ -840,7 +840,9 @@ SmmVariableHandler (
           (RuntimeVariableCacheContext->RuntimeNvCache == NULL) ||
           (RuntimeVariableCacheContext->PendingUpdate == NULL) ||
           (RuntimeVariableCacheContext->ReadLock == NULL) ||
-          (RuntimeVariableCacheContext->HobFlushComplete == NULL))
+          (RuntimeVariableCacheContext->HobFlushComplete == NULL) ||
+          (RuntimeVariableCacheContext->RewriteCount == NULL) ||
+          (RuntimeVariableCacheContext->SequenceCount == NULL))
       {
         DEBUG ((DEBUG_ERROR, "InitRuntimeVariableCacheContext: Required runtime cache buffer is NULL!\n"));
         Status = EFI_ACCESS_DENIED;
@@ -924,6 +926,26 @@ SmmVariableHandler (
         goto EXIT;
       }
 
+      if (!VariableSmmIsBufferOutsideSmmValid (
+             (UINTN)RuntimeVariableCacheContext->RewriteCount,
+             sizeof (*(RuntimeVariableCacheContext->RewriteCount))
+             ))
+      {
+        DEBUG ((DEBUG_ERROR, "InitRuntimeVariableCacheContext: Runtime cache rewrite count buffer in SMRAM or overflow!\n"));
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+
+      if (!VariableSmmIsBufferOutsideSmmValid (
+             (UINTN)RuntimeVariableCacheContext->SequenceCount,
+             sizeof (*(RuntimeVariableCacheContext->SequenceCount))
+             ))
+      {
+        DEBUG ((DEBUG_ERROR, "InitRuntimeVariableCacheContext: Runtime cache sequence count buffer in SMRAM or overflow!\n"));
+        Status = EFI_ACCESS_DENIED;
+        goto EXIT;
+      }
+
       VariableCacheContext                                     = &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext;
       VariableCacheContext->VariableRuntimeHobCache.Store      = RuntimeVariableCacheContext->RuntimeHobCache;
       VariableCacheContext->VariableRuntimeVolatileCache.Store = RuntimeVariableCacheContext->RuntimeVolatileCache;
@@ -931,6 +953,8 @@ SmmVariableHandler (
       VariableCacheContext->PendingUpdate                      = RuntimeVariableCacheContext->PendingUpdate;
       VariableCacheContext->ReadLock                           = RuntimeVariableCacheContext->ReadLock;
       VariableCacheContext->HobFlushComplete                   = RuntimeVariableCacheContext->HobFlushComplete;
+      VariableCacheContext->RewriteCount                       = RuntimeVariableCacheContext->RewriteCount;
+      VariableCacheContext->SequenceCount                      = RuntimeVariableCacheContext->SequenceCount;
 
       // Set up the intial pending request since the RT cache needs to be in sync with SMM cache
       VariableCacheContext->VariableRuntimeHobCache.PendingUpdateOffset = 0;
@@ -956,6 +980,8 @@ SmmVariableHandler (
       *(VariableCacheContext->PendingUpdate)    = TRUE;
       *(VariableCacheContext->ReadLock)         = FALSE;
       *(VariableCacheContext->HobFlushComplete) = FALSE;
+      *(VariableCacheContext->RewriteCount)     = 0;
+      *(VariableCacheContext->SequenceCount)    = 0;
 
       Status = EFI_SUCCESS;
       break;
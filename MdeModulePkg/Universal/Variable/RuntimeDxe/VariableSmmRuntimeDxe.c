@@ -36,6 +36,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiLib.h>
 #include <Library/BaseLib.h>
 #include <Library/MmUnblockMemoryLib.h>
+#include <Library/SynchronizationLib.h>
 
 #include <Guid/EventGroup.h>
 #include <Guid/SmmVariableCommon.h>
@@ -62,6 +63,11 @@ BOOLEAN                         mVariableRuntimeCachePendingUpdate;
 BOOLEAN                         mVariableRuntimeCacheReadLock;
 BOOLEAN                         mVariableAuthFormat;
 BOOLEAN                         mHobFlushComplete;
+UINT32                          mVariableRuntimeCacheRewriteCount;
+UINT32                          mVariableRuntimeCacheIndexedRewriteCount;
+UINT32                          mVariableRuntimeCacheSequenceCount;
+SPIN_LOCK                       mVariableRuntimeCacheIndexLock;
+SPIN_LOCK                       mVariableBufferLock;
 EFI_LOCK                        mVariableServicesLock;
 EDKII_VARIABLE_LOCK_PROTOCOL    mVariableLock;
 EDKII_VAR_CHECK_PROTOCOL        mVarCheck;
@@ -537,6 +543,35 @@ Done:
   return Status;
 }
 
+/**
+  Acquires the lock of mVariableBuffer.
+
+  GetVariable () may run on several processors at the same time at OS runtime, when mVariableServicesLock
+  does nothing. Its paths that send a request to SMM hold this lock while they use mVariableBuffer.
+
+**/
+VOID
+AcquireVariableBufferLock (
+  VOID
+  )
+{
+  while (!AcquireSpinLockOrFail (&mVariableBufferLock)) {
+    CpuPause ();
+  }
+}
+
+/**
+  Releases the lock of mVariableBuffer.
+
+**/
+VOID
+ReleaseVariableBufferLock (
+  VOID
+  )
+{
+  ReleaseSpinLock (&mVariableBufferLock);
+}
+
 /**
   Signals SMM to synchronize any pending variable updates with the runtime cache(s).
 
@@ -546,6 +581,8 @@ SyncRuntimeCache (
   VOID
   )
 {
+  AcquireVariableBufferLock ();
+
   //
   // Init the communicate buffer. The buffer data size is:
   // SMM_COMMUNICATE_HEADER_SIZE + SMM_VARIABLE_COMMUNICATE_HEADER_SIZE.
@@ -556,6 +593,8 @@ SyncRuntimeCache (
   // Send data to SMM.
   //
   SendCommunicateBuffer (0);
+
+  ReleaseVariableBufferLock ();
 }
 
 /**
@@ -564,145 +603,116 @@ SyncRuntimeCache (
   If the variable HOB was finished being flushed since the last check for a runtime cache update, this function
   will prevent the HOB cache from being used for future runtime cache hits.
 
+  The pending updates cannot be retrieved while GetNextVariableName () holds the runtime cache read lock, they
+  are retrieved by GetNextVariableName () when it releases the lock.
+
 **/
 VOID
 CheckForRuntimeCacheSync (
   VOID
   )
 {
-  if (mVariableRuntimeCachePendingUpdate) {
+  if (mVariableRuntimeCachePendingUpdate && !mVariableRuntimeCacheReadLock) {
     SyncRuntimeCache ();
   }
 
-  ASSERT (!mVariableRuntimeCachePendingUpdate);
-
   //
   // The HOB variable data may have finished being flushed in the runtime cache sync update
   //
   if (mHobFlushComplete && (mVariableRuntimeHobCacheBuffer != NULL)) {
-    if (!EfiAtRuntime ()) {
-      FreePages (mVariableRuntimeHobCacheBuffer, EFI_SIZE_TO_PAGES (mVariableRuntimeHobCacheBufferSize));
+    while (!AcquireSpinLockOrFail (&mVariableRuntimeCacheIndexLock)) {
+      CpuPause ();
     }
 
-    mVariableRuntimeHobCacheBuffer = NULL;
+    if (mVariableRuntimeHobCacheBuffer != NULL) {
+      VariableStoreIndexUnregister (mVariableRuntimeHobCacheBuffer);
+      if (!EfiAtRuntime ()) {
+        FreePages (mVariableRuntimeHobCacheBuffer, EFI_SIZE_TO_PAGES (mVariableRuntimeHobCacheBufferSize));
+      }
+
+      mVariableRuntimeHobCacheBuffer = NULL;
+    }
+
+    ReleaseSpinLock (&mVariableRuntimeCacheIndexLock);
   }
 }
 
 /**
-  Finds the given variable in a runtime cache variable store.
+  Starts a read of the runtime variable caches.
 
-  Caution: This function may receive untrusted input.
-  The data size is external input, so this function will validate it carefully to avoid buffer overflow.
+  SMM updates the runtime caches while the variable services may run on other processors. A read of the
+  caches is done between RuntimeCacheReadBegin () and RuntimeCacheReadRetry (), and is done again when
+  RuntimeCacheReadRetry () returns TRUE, as the caches were updated meanwhile.
 
-  @param[in]      VariableName       Name of Variable to be found.
-  @param[in]      VendorGuid         Variable vendor GUID.
-  @param[out]     Attributes         Attribute value of the variable found.
-  @param[in, out] DataSize           Size of Data found. If size is less than the
-                                     data, this value contains the required size.
-  @param[out]     Data               Data pointer.
+  Only the processor that holds mVariableRuntimeCacheIndexLock uses the hash indexes of the runtime caches. If
+  the stores were reclaimed, their indexes are rebuilt, unless an update of the caches is still pending.
 
-  @retval EFI_SUCCESS                Found the specified variable.
-  @retval EFI_INVALID_PARAMETER      Invalid parameter.
-  @retval EFI_NOT_FOUND              The specified variable could not be found.
+  @param[in] IndexOwned       TRUE if the caller holds mVariableRuntimeCacheIndexLock.
+
+  @return The sequence count of the runtime caches, to pass to RuntimeCacheReadRetry ().
 
 **/
-EFI_STATUS
-FindVariableInRuntimeCache (
-  IN      CHAR16    *VariableName,
-  IN      EFI_GUID  *VendorGuid,
-  OUT     UINT32    *Attributes OPTIONAL,
-  IN OUT  UINTN     *DataSize,
-  OUT     VOID      *Data OPTIONAL
+UINT32
+RuntimeCacheReadBegin (
+  IN BOOLEAN  IndexOwned
   )
 {
-  EFI_STATUS              Status;
-  UINTN                   TempDataSize;
-  VARIABLE_POINTER_TRACK  RtPtrTrack;
-  VARIABLE_STORE_TYPE     StoreType;
-  VARIABLE_STORE_HEADER   *VariableStoreList[VariableStoreTypeMax];
-
-  Status = EFI_NOT_FOUND;
-
-  if ((VariableName == NULL) || (VendorGuid == NULL) || (DataSize == NULL)) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  ZeroMem (&RtPtrTrack, sizeof (RtPtrTrack));
+  UINT32  SequenceCount;
+  UINT32  RewriteCount;
 
   //
-  // The UEFI specification restricts Runtime Services callers from invoking the same or certain other Runtime Service
-  // functions prior to completion and return from a previous Runtime Service call. These restrictions prevent
-  // a GetVariable () or GetNextVariable () call from being issued until a prior call has returned. The runtime
-  // cache read lock should always be free when entering this function.
+  // The sequence count is odd while SMM copies an update to the caches.
   //
-  ASSERT (!mVariableRuntimeCacheReadLock);
-
-  mVariableRuntimeCacheReadLock = TRUE;
-  CheckForRuntimeCacheSync ();
-
-  if (!mVariableRuntimeCachePendingUpdate) {
-    //
-    // 0: Volatile, 1: HOB, 2: Non-Volatile.
-    // The index and attributes mapping must be kept in this order as FindVariable
-    // makes use of this mapping to implement search algorithm.
-    //
-    VariableStoreList[VariableStoreTypeVolatile] = mVariableRuntimeVolatileCacheBuffer;
-    VariableStoreList[VariableStoreTypeHob]      = mVariableRuntimeHobCacheBuffer;
-    VariableStoreList[VariableStoreTypeNv]       = mVariableRuntimeNvCacheBuffer;
+  SequenceCount = *(volatile UINT32 *)&mVariableRuntimeCacheSequenceCount;
+  while ((SequenceCount & BIT0) != 0) {
+    CpuPause ();
+    SequenceCount = *(volatile UINT32 *)&mVariableRuntimeCacheSequenceCount;
+  }
 
-    for (StoreType = (VARIABLE_STORE_TYPE)0; StoreType < VariableStoreTypeMax; StoreType++) {
-      if (VariableStoreList[StoreType] == NULL) {
-        continue;
-      }
+  MemoryFence ();
 
-      RtPtrTrack.StartPtr = GetStartPointer (VariableStoreList[StoreType]);
-      RtPtrTrack.EndPtr   = GetEndPointer (VariableStoreList[StoreType]);
-      RtPtrTrack.Volatile = (BOOLEAN)(StoreType == VariableStoreTypeVolatile);
-
-      Status = FindVariableEx (VariableName, VendorGuid, FALSE, &RtPtrTrack, mVariableAuthFormat);
-      if (!EFI_ERROR (Status)) {
-        break;
+  if (IndexOwned) {
+    RewriteCount = *(volatile UINT32 *)&mVariableRuntimeCacheRewriteCount;
+    if (RewriteCount != mVariableRuntimeCacheIndexedRewriteCount) {
+      VariableStoreIndexInvalidate (NULL);
+      if (!*(volatile BOOLEAN *)&mVariableRuntimeCachePendingUpdate) {
+        mVariableRuntimeCacheIndexedRewriteCount = RewriteCount;
       }
     }
+  }
 
-    if (!EFI_ERROR (Status)) {
-      //
-      // Get data size
-      //
-      TempDataSize = DataSizeOfVariable (RtPtrTrack.CurrPtr, mVariableAuthFormat);
-      ASSERT (TempDataSize != 0);
+  return SequenceCount;
+}
 
-      if (*DataSize >= TempDataSize) {
-        if (Data == NULL) {
-          Status = EFI_INVALID_PARAMETER;
-          goto Done;
-        }
+/**
+  Checks whether the runtime variable caches were updated during a read started by RuntimeCacheReadBegin ().
 
-        CopyMem (Data, GetVariableDataPtr (RtPtrTrack.CurrPtr, mVariableAuthFormat), TempDataSize);
-        *DataSize = TempDataSize;
+  The hash indexes of the runtime caches may have recorded variables that were being written, so they are
+  invalidated when the read must be done again.
 
-        UpdateVariableInfo (VariableName, VendorGuid, RtPtrTrack.Volatile, TRUE, FALSE, FALSE, TRUE, &mVariableInfo);
+  @param[in] SequenceCount    The value returned by RuntimeCacheReadBegin ().
+  @param[in] IndexOwned       TRUE if the caller holds mVariableRuntimeCacheIndexLock.
 
-        Status = EFI_SUCCESS;
-        goto Done;
-      } else {
-        *DataSize = TempDataSize;
-        Status    = EFI_BUFFER_TOO_SMALL;
-        goto Done;
-      }
-    }
-  }
+  @retval TRUE                The caches were updated, the read must be done again.
+  @retval FALSE               The data read from the caches is consistent.
 
-Done:
-  if ((Status == EFI_SUCCESS) || (Status == EFI_BUFFER_TOO_SMALL)) {
-    if ((Attributes != NULL) && (RtPtrTrack.CurrPtr != NULL)) {
-      *Attributes = RtPtrTrack.CurrPtr->Attributes;
-    }
+**/
+BOOLEAN
+RuntimeCacheReadRetry (
+  IN UINT32   SequenceCount,
+  IN BOOLEAN  IndexOwned
+  )
+{
+  MemoryFence ();
+  if (*(volatile UINT32 *)&mVariableRuntimeCacheSequenceCount == SequenceCount) {
+    return FALSE;
   }
 
-  mVariableRuntimeCacheReadLock = FALSE;
+  if (IndexOwned) {
+    VariableStoreIndexInvalidate (NULL);
+  }
 
-  return Status;
+  return TRUE;
 }
 
 /**
@@ -766,6 +776,8 @@ FindVariableInSmm (
 
   PayloadSize = OFFSET_OF (SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE, Name) + VariableNameSize + TempDataSize;
 
+  AcquireVariableBufferLock ();
+
   Status = InitCommunicateBuffer ((VOID **)&SmmVariableHeader, PayloadSize, SMM_VARIABLE_FUNCTION_GET_VARIABLE);
   if (EFI_ERROR (Status)) {
     goto Done;
@@ -815,6 +827,151 @@ FindVariableInSmm (
   }
 
 Done:
+  ReleaseVariableBufferLock ();
+  return Status;
+}
+
+/**
+  Finds the given variable in a runtime cache variable store.
+
+  Caution: This function may receive untrusted input.
+  The data size is external input, so this function will validate it carefully to avoid buffer overflow.
+
+  @param[in]      VariableName       Name of Variable to be found.
+  @param[in]      VendorGuid         Variable vendor GUID.
+  @param[out]     Attributes         Attribute value of the variable found.
+  @param[in, out] DataSize           Size of Data found. If size is less than the
+                                     data, this value contains the required size.
+  @param[out]     Data               Data pointer.
+
+  @retval EFI_SUCCESS                Found the specified variable.
+  @retval EFI_INVALID_PARAMETER      Invalid parameter.
+  @retval EFI_NOT_FOUND              The specified variable could not be found.
+
+**/
+EFI_STATUS
+FindVariableInRuntimeCache (
+  IN      CHAR16    *VariableName,
+  IN      EFI_GUID  *VendorGuid,
+  OUT     UINT32    *Attributes OPTIONAL,
+  IN OUT  UINTN     *DataSize,
+  OUT     VOID      *Data OPTIONAL
+  )
+{
+  EFI_STATUS              Status;
+  UINTN                   TempDataSize;
+  UINTN                   NameSize;
+  UINT32                  TempAttributes;
+  VARIABLE_POINTER_TRACK  RtPtrTrack;
+  VARIABLE_STORE_TYPE     StoreType;
+  VARIABLE_STORE_HEADER   *VariableStoreList[VariableStoreTypeMax];
+  UINT32                  SequenceCount;
+  BOOLEAN                 IndexOwned;
+  BOOLEAN                 PendingUpdate;
+
+  if ((VariableName == NULL) || (VendorGuid == NULL) || (DataSize == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  CheckForRuntimeCacheSync ();
+
+  //
+  // This function may run on several processors at the same time at OS runtime. It does not take the runtime
+  // cache read lock and does not trigger a SMI: the variable is read again when SMM updated the caches during
+  // the read. Only one processor at a time uses the hash indexes of the caches, the others walk the caches.
+  //
+  IndexOwned = AcquireSpinLockOrFail (&mVariableRuntimeCacheIndexLock);
+
+  do {
+    SequenceCount  = RuntimeCacheReadBegin (IndexOwned);
+    PendingUpdate  = *(volatile BOOLEAN *)&mVariableRuntimeCachePendingUpdate;
+    Status         = EFI_NOT_FOUND;
+    TempDataSize   = 0;
+    TempAttributes = 0;
+    ZeroMem (&RtPtrTrack, sizeof (RtPtrTrack));
+    if (PendingUpdate) {
+      break;
+    }
+
+    //
+    // 0: Volatile, 1: HOB, 2: Non-Volatile.
+    // The index and attributes mapping must be kept in this order as FindVariable
+    // makes use of this mapping to implement search algorithm.
+    //
+    VariableStoreList[VariableStoreTypeVolatile] = mVariableRuntimeVolatileCacheBuffer;
+    VariableStoreList[VariableStoreTypeHob]      = mVariableRuntimeHobCacheBuffer;
+    VariableStoreList[VariableStoreTypeNv]       = mVariableRuntimeNvCacheBuffer;
+
+    for (StoreType = (VARIABLE_STORE_TYPE)0; StoreType < VariableStoreTypeMax; StoreType++) {
+      if (VariableStoreList[StoreType] == NULL) {
+        continue;
+      }
+
+      RtPtrTrack.StartPtr = GetStartPointer (VariableStoreList[StoreType]);
+      RtPtrTrack.EndPtr   = GetEndPointer (VariableStoreList[StoreType]);
+      RtPtrTrack.Volatile = (BOOLEAN)(StoreType == VariableStoreTypeVolatile);
+
+      if (IndexOwned) {
+        Status = FindVariableEx (VariableName, VendorGuid, FALSE, &RtPtrTrack, mVariableAuthFormat);
+      } else {
+        Status = FindVariableByWalk (VariableName, VendorGuid, FALSE, &RtPtrTrack, mVariableAuthFormat);
+      }
+
+      if (!EFI_ERROR (Status)) {
+        break;
+      }
+    }
+
+    if (!EFI_ERROR (Status)) {
+      //
+      // Get data size. A variable that was being written may not fit in the cache, it is read again. The
+      // sizes are read once, as SMM may write them again before the read is retried.
+      //
+      TempAttributes = RtPtrTrack.CurrPtr->Attributes;
+      if (!IsVariableInStore (RtPtrTrack.CurrPtr, RtPtrTrack.EndPtr, mVariableAuthFormat, &NameSize, &TempDataSize)) {
+        Status       = EFI_NOT_FOUND;
+        TempDataSize = 0;
+      } else if (*DataSize >= TempDataSize) {
+        if (Data == NULL) {
+          Status = EFI_INVALID_PARAMETER;
+        } else {
+          CopyMem (
+            Data,
+            (UINT8 *)GetVariableNamePtr (RtPtrTrack.CurrPtr, mVariableAuthFormat) + NameSize + GET_PAD_SIZE (NameSize),
+            TempDataSize
+            );
+          Status = EFI_SUCCESS;
+        }
+      } else {
+        Status = EFI_BUFFER_TOO_SMALL;
+      }
+    }
+  } while (RuntimeCacheReadRetry (SequenceCount, IndexOwned));
+
+  if (IndexOwned) {
+    ReleaseSpinLock (&mVariableRuntimeCacheIndexLock);
+  }
+
+  if (PendingUpdate) {
+    //
+    // An update could not be copied to the caches because GetNextVariableName () holds the runtime cache read
+    // lock on another processor.
+    //
+    return FindVariableInSmm (VariableName, VendorGuid, Attributes, DataSize, Data);
+  }
+
+  if ((Status == EFI_SUCCESS) || (Status == EFI_BUFFER_TOO_SMALL)) {
+    ASSERT (TempDataSize != 0);
+    *DataSize = TempDataSize;
+    if (Attributes != NULL) {
+      *Attributes = TempAttributes;
+    }
+  }
+
+  if (Status == EFI_SUCCESS) {
+    UpdateVariableInfo (VariableName, VendorGuid, RtPtrTrack.Volatile, TRUE, FALSE, FALSE, TRUE, &mVariableInfo);
+  }
+
   return Status;
 }
 
@@ -893,21 +1050,34 @@ GetNextVariableNameInRuntimeCache (
   UINTN                  VarNameSize;
   VARIABLE_HEADER        *VariablePtr;
   VARIABLE_STORE_HEADER  *VariableStoreHeader[VariableStoreTypeMax];
+  UINT32                 SequenceCount;
 
   Status = EFI_NOT_FOUND;
 
   //
   // The UEFI specification restricts Runtime Services callers from invoking the same or certain other Runtime Service
   // functions prior to completion and return from a previous Runtime Service call. These restrictions prevent
-  // a GetVariable () or GetNextVariable () call from being issued until a prior call has returned. The runtime
-  // cache read lock should always be free when entering this function.
+  // a GetNextVariable () call from being issued until a prior call has returned. The runtime cache read lock
+  // should always be free when entering this function.
   //
   ASSERT (!mVariableRuntimeCacheReadLock);
 
   CheckForRuntimeCacheSync ();
 
+  //
+  // The name of the variable is returned in the buffer of its input, so the walk cannot be done again once the
+  // name is copied. The read lock makes SMM keep the updates pending instead of copying them to the caches, and
+  // taking the index lock, with an interlocked operation, makes the read lock visible to SMM before the caches
+  // are read.
+  //
   mVariableRuntimeCacheReadLock = TRUE;
-  if (!mVariableRuntimeCachePendingUpdate) {
+  while (!AcquireSpinLockOrFail (&mVariableRuntimeCacheIndexLock)) {
+    CpuPause ();
+  }
+
+  do {
+    SequenceCount = RuntimeCacheReadBegin (TRUE);
+
     //
     // 0: Volatile, 1: HOB, 2: Non-Volatile.
     // The index and attributes mapping must be kept in this order as FindVariable
@@ -924,23 +1094,30 @@ GetNextVariableNameInRuntimeCache (
                 &VariablePtr,
                 mVariableAuthFormat
                 );
-    if (!EFI_ERROR (Status)) {
-      VarNameSize = NameSizeOfVariable (VariablePtr, mVariableAuthFormat);
-      ASSERT (VarNameSize != 0);
-      if (VarNameSize <= *VariableNameSize) {
-        CopyMem (VariableName, GetVariableNamePtr (VariablePtr, mVariableAuthFormat), VarNameSize);
-        CopyMem (VendorGuid, GetVendorGuidPtr (VariablePtr, mVariableAuthFormat), sizeof (EFI_GUID));
-        Status = EFI_SUCCESS;
-      } else {
-        Status = EFI_BUFFER_TOO_SMALL;
-      }
-
-      *VariableNameSize = VarNameSize;
+  } while (RuntimeCacheReadRetry (SequenceCount, TRUE));
+
+  if (!EFI_ERROR (Status)) {
+    VarNameSize = NameSizeOfVariable (VariablePtr, mVariableAuthFormat);
+    ASSERT (VarNameSize != 0);
+    if (VarNameSize <= *VariableNameSize) {
+      CopyMem (VariableName, GetVariableNamePtr (VariablePtr, mVariableAuthFormat), VarNameSize);
+      CopyMem (VendorGuid, GetVendorGuidPtr (VariablePtr, mVariableAuthFormat), sizeof (EFI_GUID));
+      Status = EFI_SUCCESS;
+    } else {
+      Status = EFI_BUFFER_TOO_SMALL;
     }
+
+    *VariableNameSize = VarNameSize;
   }
 
+  ReleaseSpinLock (&mVariableRuntimeCacheIndexLock);
   mVariableRuntimeCacheReadLock = FALSE;
 
+  //
+  // Retrieve the updates SMM kept pending while the read lock was taken.
+  //
+  CheckForRuntimeCacheSync ();
+
   return Status;
 }
 
@@ -1361,6 +1538,7 @@ VariableAddressChangeEvent (
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **)&mVariableRuntimeHobCacheBuffer);
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **)&mVariableRuntimeNvCacheBuffer);
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **)&mVariableRuntimeVolatileCacheBuffer);
+  VariableStoreIndexConvertPointers (EfiConvertPointer);
 }
 
 /**
@@ -1570,6 +1748,8 @@ SendRuntimeVariableCacheContextToSmm (
   SmmRuntimeVarCacheContext->PendingUpdate        = &mVariableRuntimeCachePendingUpdate;
   SmmRuntimeVarCacheContext->ReadLock             = &mVariableRuntimeCacheReadLock;
   SmmRuntimeVarCacheContext->HobFlushComplete     = &mHobFlushComplete;
+  SmmRuntimeVarCacheContext->RewriteCount         = &mVariableRuntimeCacheRewriteCount;
+  SmmRuntimeVarCacheContext->SequenceCount        = &mVariableRuntimeCacheSequenceCount;
 
   //
   // Request to unblock this region to be accessible from inside MM environment
@@ -1599,6 +1779,22 @@ SendRuntimeVariableCacheContextToSmm (
     goto Done;
   }
 
+  Status = MmUnblockMemoryRequest (
+             (EFI_PHYSICAL_ADDRESS)ALIGN_VALUE ((UINTN)SmmRuntimeVarCacheContext->RewriteCount - EFI_PAGE_SIZE + 1, EFI_PAGE_SIZE),
+             EFI_SIZE_TO_PAGES (sizeof (mVariableRuntimeCacheRewriteCount))
+             );
+  if ((Status != EFI_UNSUPPORTED) && EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  Status = MmUnblockMemoryRequest (
+             (EFI_PHYSICAL_ADDRESS)ALIGN_VALUE ((UINTN)SmmRuntimeVarCacheContext->SequenceCount - EFI_PAGE_SIZE + 1, EFI_PAGE_SIZE),
+             EFI_SIZE_TO_PAGES (sizeof (mVariableRuntimeCacheSequenceCount))
+             );
+  if ((Status != EFI_UNSUPPORTED) && EFI_ERROR (Status)) {
+    goto Done;
+  }
+
   //
   // Send data to SMM.
   //
@@ -1678,6 +1874,14 @@ SmmVariableReady (
             Status = SendRuntimeVariableCacheContextToSmm ();
             if (!EFI_ERROR (Status)) {
               SyncRuntimeCache ();
+              //
+              // Index the runtime cache stores, they are still walked if they cannot be indexed.
+              //
+              VariableStoreIndexRegister (mVariableRuntimeVolatileCacheBuffer);
+              VariableStoreIndexRegister (mVariableRuntimeNvCacheBuffer);
+              if (mVariableRuntimeHobCacheBuffer != NULL) {
+                VariableStoreIndexRegister (mVariableRuntimeHobCacheBuffer);
+              }
             }
           }
         }
@@ -1802,6 +2006,8 @@ VariableSmmRuntimeInitialize (
   EFI_EVENT  LegacyBootEvent;
 
   EfiInitializeLock (&mVariableServicesLock, TPL_NOTIFY);
+  InitializeSpinLock (&mVariableRuntimeCacheIndexLock);
+  InitializeSpinLock (&mVariableBufferLock);
 
   //
   // Smm variable service is ready
@@ -0,0 +1,517 @@
+/** @file
+  Hash index of the variables in a variable store, used by FindVariableEx ()
+  to find a variable by name and GUID without walking the whole store.
+
+  Each indexed store has a table of buckets, selected by a hash of the name
+  and GUID of the variables, and an array of entries chained from the
+  buckets. An entry records the offset of one variable header in the store.
+  Entries are added in store order as the store grows; the state of the
+  variables is checked on each lookup, so that a lookup returns the same
+  variable as the walk done by FindVariableEx ().
+
+  All the memory is allocated when the store is registered, so the index can
+  be maintained at OS runtime and in SMM.
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "VariableParsing.h"
+
+#define VARIABLE_STORE_INDEX_END  MAX_UINT32
+
+typedef struct {
+  UINT32    Offset;
+  UINT32    Hash;
+  UINT32    Next;
+} VARIABLE_STORE_INDEX_ENTRY;
+
+typedef struct {
+  VARIABLE_STORE_HEADER         *Store;
+  UINT32                        *Buckets;
+  VARIABLE_STORE_INDEX_ENTRY    *Entries;
+  UINT32                        BucketMask;
+  UINT32                        MaxEntries;
+  UINT32                        EntryCount;
+  //
+  // Offset of the first variable header that is not indexed yet.
+  //
+  UINT32                        IndexedEnd;
+  BOOLEAN                       AuthFormat;
+  BOOLEAN                       Built;
+  //
+  // Set when the store holds a variable the index cannot represent, like a
+  // variable name that is not NULL terminated. Lookups in the store walk it
+  // until the index is invalidated.
+  //
+  BOOLEAN                       Unusable;
+} VARIABLE_STORE_INDEX;
+
+VARIABLE_STORE_INDEX  mVariableStoreIndex[VARIABLE_STORE_INDEX_MAX];
+
+/**
+  Computes the hash of the name and GUID of a variable (32 bit FNV-1a).
+
+  @param[in] Name           The variable name.
+  @param[in] NameLength     The number of characters of the name.
+  @param[in] Guid           The variable GUID.
+
+  @return The hash.
+
+**/
+STATIC
+UINT32
+VariableStoreIndexHash (
+  IN CONST CHAR16    *Name,
+  IN UINTN           NameLength,
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  UINT32       Hash;
+  UINTN        Index;
+  CONST UINT8  *Bytes;
+
+  Hash = 0x811C9DC5;
+  for (Index = 0; Index < NameLength; Index++) {
+    Hash = (Hash ^ (UINT8)Name[Index]) * 0x01000193;
+    Hash = (Hash ^ (UINT8)(Name[Index] >> 8)) * 0x01000193;
+  }
+
+  Bytes = (CONST UINT8 *)Guid;
+  for (Index = 0; Index < sizeof (EFI_GUID); Index++) {
+    Hash = (Hash ^ Bytes[Index]) * 0x01000193;
+  }
+
+  return Hash;
+}
+
+/**
+  Returns the index of a variable store.
+
+  @param[in] StartPtr       The first variable header of the store.
+  @param[in] EndPtr         The end of the store.
+
+  @return The index, or NULL if the store is not indexed.
+
+**/
+STATIC
+VARIABLE_STORE_INDEX *
+VariableStoreIndexLookup (
+  IN VARIABLE_HEADER  *StartPtr,
+  IN VARIABLE_HEADER  *EndPtr
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < VARIABLE_STORE_INDEX_MAX; Index++) {
+    if ((mVariableStoreIndex[Index].Store != NULL) &&
+        (GetStartPointer (mVariableStoreIndex[Index].Store) == StartPtr) &&
+        (GetEndPointer (mVariableStoreIndex[Index].Store) == EndPtr))
+    {
+      return &mVariableStoreIndex[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Adds the variables appended to a store since the last lookup to its index,
+  building the index first if it was invalidated.
+
+  @param[in, out] StoreIndex    The index of the store.
+  @param[in]      AuthFormat    TRUE indicates authenticated variables are used.
+                                FALSE indicates authenticated variables are not used.
+
+  @retval TRUE                  The index covers all the variables of the store.
+  @retval FALSE                 The index cannot be used, the store must be walked.
+
+**/
+STATIC
+BOOLEAN
+VariableStoreIndexUpdate (
+  IN OUT VARIABLE_STORE_INDEX  *StoreIndex,
+  IN     BOOLEAN               AuthFormat
+  )
+{
+  VARIABLE_HEADER             *Variable;
+  VARIABLE_HEADER             *EndPtr;
+  VARIABLE_STORE_INDEX_ENTRY  *Entry;
+  CHAR16                      *Name;
+  UINTN                       NameSize;
+  UINTN                       DataSize;
+  UINTN                       NameLength;
+  UINT32                      Bucket;
+
+  if (!StoreIndex->Built || (StoreIndex->AuthFormat != AuthFormat)) {
+    SetMem (StoreIndex->Buckets, (StoreIndex->BucketMask + 1) * sizeof (UINT32), 0xFF);
+    StoreIndex->EntryCount = 0;
+    StoreIndex->IndexedEnd = (UINT32)((UINTN)GetStartPointer (StoreIndex->Store) - (UINTN)StoreIndex->Store);
+    StoreIndex->AuthFormat = AuthFormat;
+    StoreIndex->Unusable   = FALSE;
+    StoreIndex->Built      = TRUE;
+  }
+
+  if (StoreIndex->Unusable) {
+    return FALSE;
+  }
+
+  EndPtr = GetEndPointer (StoreIndex->Store);
+  for ( Variable = (VARIABLE_HEADER *)((UINTN)StoreIndex->Store + StoreIndex->IndexedEnd)
+        ; IsValidVariableHeader (Variable, EndPtr)
+        ; Variable = GetNextVariablePtr (Variable, AuthFormat)
+        )
+  {
+    //
+    // The walk in FindVariableEx () compares NameSize bytes of the name, so
+    // only names that end with their first NULL character can be hashed.
+    //
+    Name = GetVariableNamePtr (Variable, AuthFormat);
+    if (!IsVariableInStore (Variable, EndPtr, AuthFormat, &NameSize, &DataSize) ||
+        (NameSize == 0) || ((NameSize & 1) != 0) ||
+        (StoreIndex->EntryCount == StoreIndex->MaxEntries))
+    {
+      StoreIndex->Unusable = TRUE;
+      return FALSE;
+    }
+
+    for (NameLength = 0; NameLength < NameSize / sizeof (CHAR16) - 1; NameLength++) {
+      if (Name[NameLength] == 0) {
+        break;
+      }
+    }
+
+    if (Name[NameLength] != 0) {
+      StoreIndex->Unusable = TRUE;
+      return FALSE;
+    }
+
+    Entry         = &StoreIndex->Entries[StoreIndex->EntryCount];
+    Entry->Offset = (UINT32)((UINTN)Variable - (UINTN)StoreIndex->Store);
+    Entry->Hash   = VariableStoreIndexHash (Name, NameLength, GetVendorGuidPtr (Variable, AuthFormat));
+    Bucket        = Entry->Hash & StoreIndex->BucketMask;
+    Entry->Next   = StoreIndex->Buckets[Bucket];
+
+    StoreIndex->Buckets[Bucket] = StoreIndex->EntryCount;
+    StoreIndex->EntryCount++;
+    StoreIndex->IndexedEnd = (UINT32)((UINTN)GetNextVariablePtr (Variable, AuthFormat) - (UINTN)StoreIndex->Store);
+  }
+
+  return TRUE;
+}
+
+/**
+  Checks whether a variable is a match for FindVariableEx ().
+
+  @param[in] Variable           The variable header.
+  @param[in] EndPtr             The end of the variable store.
+  @param[in] VariableName       Name of the variable to be found.
+  @param[in] VendorGuid         Vendor GUID to be found.
+  @param[in] IgnoreRtCheck      Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                check at runtime when searching variable.
+  @param[in] AuthFormat         TRUE indicates authenticated variables are used.
+                                FALSE indicates authenticated variables are not used.
+
+  @retval TRUE                  The variable is an added or in deleted transition
+                                variable with the name and GUID.
+  @retval FALSE                 The variable does not match.
+
+**/
+STATIC
+BOOLEAN
+VariableStoreIndexMatch (
+  IN VARIABLE_HEADER  *Variable,
+  IN VARIABLE_HEADER  *EndPtr,
+  IN CHAR16           *VariableName,
+  IN EFI_GUID         *VendorGuid,
+  IN BOOLEAN          IgnoreRtCheck,
+  IN BOOLEAN          AuthFormat
+  )
+{
+  UINTN  NameSize;
+  UINTN  DataSize;
+
+  if ((Variable->State != VAR_ADDED) &&
+      (Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED)))
+  {
+    return FALSE;
+  }
+
+  if (!IgnoreRtCheck && AtRuntime () && ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) {
+    return FALSE;
+  }
+
+  if (!CompareGuid (VendorGuid, GetVendorGuidPtr (Variable, AuthFormat))) {
+    return FALSE;
+  }
+
+  //
+  // A variable of a runtime cache that SMM is writing may have any size.
+  //
+  if (!IsVariableInStore (Variable, EndPtr, AuthFormat, &NameSize, &DataSize)) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)(CompareMem (
+                     VariableName,
+                     GetVariableNamePtr (Variable, AuthFormat),
+                     NameSize
+                     ) == 0);
+}
+
+/**
+  Allocates the index of a variable store. The index is built on the first
+  lookup in the store.
+
+  This function must be called before the end of boot services, as the index
+  memory is allocated from runtime pool. Nothing is done if the store is
+  already indexed or if PcdVariableStoreHashIndexEnable is FALSE.
+
+  @param[in] VariableStore        The variable store to index.
+
+  @retval EFI_SUCCESS             The store is indexed.
+  @retval EFI_UNSUPPORTED         The hash index is disabled.
+  @retval EFI_OUT_OF_RESOURCES    There is no free index or not enough memory.
+
+**/
+EFI_STATUS
+VariableStoreIndexRegister (
+  IN VARIABLE_STORE_HEADER  *VariableStore
+  )
+{
+  VARIABLE_STORE_INDEX  *StoreIndex;
+  UINTN                 Index;
+  UINTN                 StoreSize;
+  UINTN                 MaxEntries;
+  UINTN                 BucketCount;
+
+  if (!FeaturePcdGet (PcdVariableStoreHashIndexEnable)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  StoreIndex = NULL;
+  for (Index = 0; Index < VARIABLE_STORE_INDEX_MAX; Index++) {
+    if (mVariableStoreIndex[Index].Store == VariableStore) {
+      return EFI_SUCCESS;
+    }
+
+    if ((StoreIndex == NULL) && (mVariableStoreIndex[Index].Store == NULL)) {
+      StoreIndex = &mVariableStoreIndex[Index];
+    }
+  }
+
+  if (StoreIndex == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Every variable takes at least a header and a one character name, so
+  // the index of a full store never runs out of entries.
+  //
+  if ((UINTN)GetEndPointer (VariableStore) <= (UINTN)GetStartPointer (VariableStore)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  StoreSize   = (UINTN)GetEndPointer (VariableStore) - (UINTN)GetStartPointer (VariableStore);
+  MaxEntries  = StoreSize / HEADER_ALIGN (sizeof (VARIABLE_HEADER) + sizeof (CHAR16)) + 1;
+  BucketCount = MAX (GetPowerOfTwo32 ((UINT32)MaxEntries), 16);
+
+  StoreIndex->Buckets = AllocateRuntimePool (BucketCount * sizeof (UINT32));
+  StoreIndex->Entries = AllocateRuntimePool (MaxEntries * sizeof (VARIABLE_STORE_INDEX_ENTRY));
+  if ((StoreIndex->Buckets == NULL) || (StoreIndex->Entries == NULL)) {
+    if (StoreIndex->Buckets != NULL) {
+      FreePool (StoreIndex->Buckets);
+    }
+
+    if (StoreIndex->Entries != NULL) {
+      FreePool (StoreIndex->Entries);
+    }
+
+    ZeroMem (StoreIndex, sizeof (*StoreIndex));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  StoreIndex->BucketMask = (UINT32)(BucketCount - 1);
+  StoreIndex->MaxEntries = (UINT32)MaxEntries;
+  StoreIndex->Built      = FALSE;
+  StoreIndex->Store      = VariableStore;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stops indexing a variable store, for instance before its buffer is freed.
+
+  @param[in] VariableStore        The variable store.
+
+**/
+VOID
+VariableStoreIndexUnregister (
+  IN VARIABLE_STORE_HEADER  *VariableStore
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < VARIABLE_STORE_INDEX_MAX; Index++) {
+    if (mVariableStoreIndex[Index].Store == VariableStore) {
+      //
+      // The runtime pool cannot be freed at OS runtime.
+      //
+      if (!AtRuntime ()) {
+        FreePool (mVariableStoreIndex[Index].Buckets);
+        FreePool (mVariableStoreIndex[Index].Entries);
+      }
+
+      ZeroMem (&mVariableStoreIndex[Index], sizeof (mVariableStoreIndex[Index]));
+      return;
+    }
+  }
+}
+
+/**
+  Discards the content of the index of a variable store, so that it is
+  rebuilt on the next lookup. It must be called when the variables of the
+  store have been moved, as by a reclaim.
+
+  @param[in] VariableStore        The variable store, or NULL to invalidate
+                                  the indexes of all the stores.
+
+**/
+VOID
+VariableStoreIndexInvalidate (
+  IN VARIABLE_STORE_HEADER  *VariableStore  OPTIONAL
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < VARIABLE_STORE_INDEX_MAX; Index++) {
+    if ((VariableStore == NULL) || (mVariableStoreIndex[Index].Store == VariableStore)) {
+      mVariableStoreIndex[Index].Built = FALSE;
+    }
+  }
+}
+
+/**
+  Finds a variable in an indexed variable store. The result is the same as
+  the one of the walk done by FindVariableEx ().
+
+  @param[in]       VariableName        Name of the variable to be found, not empty.
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+  @param[in]       AuthFormat          TRUE indicates authenticated variables are used.
+                                       FALSE indicates authenticated variables are not used.
+
+  @retval          EFI_SUCCESS         Variable found successfully.
+  @retval          EFI_NOT_FOUND       Variable not found.
+  @retval          EFI_UNSUPPORTED     The store is not indexed, or its index cannot
+                                       be used. The store must be walked instead.
+**/
+EFI_STATUS
+VariableStoreIndexFind (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
+  IN     BOOLEAN                 AuthFormat
+  )
+{
+  VARIABLE_STORE_INDEX  *StoreIndex;
+  VARIABLE_HEADER       *Variable;
+  VARIABLE_HEADER       *AddedVariable;
+  VARIABLE_HEADER       *InDeletedVariable;
+  UINT32                Hash;
+  UINT32                Entry;
+
+  StoreIndex = VariableStoreIndexLookup (PtrTrack->StartPtr, PtrTrack->EndPtr);
+  if ((StoreIndex == NULL) || !VariableStoreIndexUpdate (StoreIndex, AuthFormat)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Hash = VariableStoreIndexHash (VariableName, StrLen (VariableName), VendorGuid);
+
+  //
+  // The walk returns the first added variable, or the last variable in
+  // deleted transition if there is none. When both exist, the last variable
+  // in deleted transition before the added one is returned with it.
+  //
+  AddedVariable = NULL;
+  for (Entry = StoreIndex->Buckets[Hash & StoreIndex->BucketMask];
+       Entry != VARIABLE_STORE_INDEX_END;
+       Entry = StoreIndex->Entries[Entry].Next)
+  {
+    if (StoreIndex->Entries[Entry].Hash != Hash) {
+      continue;
+    }
+
+    Variable = (VARIABLE_HEADER *)((UINTN)StoreIndex->Store + StoreIndex->Entries[Entry].Offset);
+    if (!IsValidVariableHeader (Variable, PtrTrack->EndPtr)) {
+      //
+      // The store was rewritten without invalidating the index.
+      //
+      ASSERT (FALSE);
+      StoreIndex->Built = FALSE;
+      return EFI_UNSUPPORTED;
+    }
+
+    if ((Variable->State == VAR_ADDED) &&
+        ((AddedVariable == NULL) || (Variable < AddedVariable)) &&
+        VariableStoreIndexMatch (Variable, PtrTrack->EndPtr, VariableName, VendorGuid, IgnoreRtCheck, AuthFormat))
+    {
+      AddedVariable = Variable;
+    }
+  }
+
+  InDeletedVariable = NULL;
+  for (Entry = StoreIndex->Buckets[Hash & StoreIndex->BucketMask];
+       Entry != VARIABLE_STORE_INDEX_END;
+       Entry = StoreIndex->Entries[Entry].Next)
+  {
+    if (StoreIndex->Entries[Entry].Hash != Hash) {
+      continue;
+    }
+
+    Variable = (VARIABLE_HEADER *)((UINTN)StoreIndex->Store + StoreIndex->Entries[Entry].Offset);
+    if ((Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) &&
+        ((AddedVariable == NULL) || (Variable < AddedVariable)) &&
+        ((InDeletedVariable == NULL) || (Variable > InDeletedVariable)) &&
+        VariableStoreIndexMatch (Variable, PtrTrack->EndPtr, VariableName, VendorGuid, IgnoreRtCheck, AuthFormat))
+    {
+      InDeletedVariable = Variable;
+    }
+  }
+
+  if (AddedVariable != NULL) {
+    PtrTrack->CurrPtr                = AddedVariable;
+    PtrTrack->InDeletedTransitionPtr = InDeletedVariable;
+    return EFI_SUCCESS;
+  }
+
+  PtrTrack->CurrPtr                = InDeletedVariable;
+  PtrTrack->InDeletedTransitionPtr = NULL;
+  return (InDeletedVariable == NULL) ? EFI_NOT_FOUND : EFI_SUCCESS;
+}
+
+/**
+  Converts the pointers of the variable store indexes to virtual addresses.
+
+  @param[in] ConvertPointer       The function converting a pointer, like
+                                  EfiConvertPointer ().
+
+**/
+VOID
+VariableStoreIndexConvertPointers (
+  IN EFI_CONVERT_POINTER  ConvertPointer
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < VARIABLE_STORE_INDEX_MAX; Index++) {
+    if (mVariableStoreIndex[Index].Store != NULL) {
+      ConvertPointer (0x0, (VOID **)&mVariableStoreIndex[Index].Store);
+      ConvertPointer (0x0, (VOID **)&mVariableStoreIndex[Index].Buckets);
+      ConvertPointer (0x0, (VOID **)&mVariableStoreIndex[Index].Entries);
+    }
+  }
+}
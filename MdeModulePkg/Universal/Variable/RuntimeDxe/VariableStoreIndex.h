@@ -0,0 +1,110 @@
+/** @file
+  Hash index of the variables in a variable store, used to find a variable by
+  name and GUID without walking the whole store.
+
+  The index only records the offsets of the variable headers. The states of
+  the variables are read from the store on each lookup, so state transitions
+  never need to update the index, and variables appended to the store are
+  indexed on the next lookup. A store that is rewritten from its start, as by
+  a reclaim, must be invalidated with VariableStoreIndexInvalidate ().
+
+Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _VARIABLE_STORE_INDEX_H_
+#define _VARIABLE_STORE_INDEX_H_
+
+#include "Variable.h"
+
+///
+/// The maximum number of variable stores that can be indexed at the same
+/// time: the HOB, volatile and non-volatile stores, and their runtime caches.
+///
+#define VARIABLE_STORE_INDEX_MAX  6
+
+/**
+  Allocates the index of a variable store. The index is built on the first
+  lookup in the store.
+
+  This function must be called before the end of boot services, as the index
+  memory is allocated from runtime pool. Nothing is done if the store is
+  already indexed or if PcdVariableStoreHashIndexEnable is FALSE.
+
+  @param[in] VariableStore        The variable store to index.
+
+  @retval EFI_SUCCESS             The store is indexed.
+  @retval EFI_UNSUPPORTED         The hash index is disabled.
+  @retval EFI_OUT_OF_RESOURCES    There is no free index or not enough memory.
+
+**/
+EFI_STATUS
+VariableStoreIndexRegister (
+  IN VARIABLE_STORE_HEADER  *VariableStore
+  );
+
+/**
+  Stops indexing a variable store, for instance before its buffer is freed.
+
+  @param[in] VariableStore        The variable store.
+
+**/
+VOID
+VariableStoreIndexUnregister (
+  IN VARIABLE_STORE_HEADER  *VariableStore
+  );
+
+/**
+  Discards the content of the index of a variable store, so that it is
+  rebuilt on the next lookup. It must be called when the variables of the
+  store have been moved, as by a reclaim.
+
+  @param[in] VariableStore        The variable store, or NULL to invalidate
+                                  the indexes of all the stores.
+
+**/
+VOID
+VariableStoreIndexInvalidate (
+  IN VARIABLE_STORE_HEADER  *VariableStore  OPTIONAL
+  );
+
+/**
+  Finds a variable in an indexed variable store. The result is the same as
+  the one of the walk done by FindVariableEx ().
+
+  @param[in]       VariableName        Name of the variable to be found, not empty.
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+  @param[in]       AuthFormat          TRUE indicates authenticated variables are used.
+                                       FALSE indicates authenticated variables are not used.
+
+  @retval          EFI_SUCCESS         Variable found successfully.
+  @retval          EFI_NOT_FOUND       Variable not found.
+  @retval          EFI_UNSUPPORTED     The store is not indexed, or its index cannot
+                                       be used. The store must be walked instead.
+**/
+EFI_STATUS
+VariableStoreIndexFind (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
+  IN     BOOLEAN                 AuthFormat
+  );
+
+/**
+  Converts the pointers of the variable store indexes to virtual addresses.
+
+  @param[in] ConvertPointer       The function converting a pointer, like
+                                  EfiConvertPointer ().
+
+**/
+VOID
+VariableStoreIndexConvertPointers (
+  IN EFI_CONVERT_POINTER  ConvertPointer
+  );
+
+#endif
@@ -100,7 +100,7 @@ typedef struct {
   volatile UINT16    *Idx;
 
   volatile UINT16    *Ring;      // QueueSize elements
-  volatile UINT16    *UsedEvent; // unused as per negotiation
+  volatile UINT16    *UsedEvent; // VIRTIO_F_RING_EVENT_IDX only
 } VRING_AVAIL;
 
 //
@@ -119,7 +119,7 @@ typedef struct {
   volatile UINT16             *Flags;
   volatile UINT16             *Idx;
   volatile VRING_USED_ELEM    *UsedElem;   // QueueSize elements
-  volatile UINT16             *AvailEvent; // unused as per negotiation
+  volatile UINT16             *AvailEvent; // VIRTIO_F_RING_EVENT_IDX only
 } VRING_USED;
 
 //
@@ -127,7 +127,7 @@ typedef struct {
 //
 #define VRING_DESC_F_NEXT      BIT0 // more descriptors in this request
 #define VRING_DESC_F_WRITE     BIT1 // buffer to be written *by the host*
-#define VRING_DESC_F_INDIRECT  BIT2 // unused
+#define VRING_DESC_F_INDIRECT  BIT2 // buffer is an indirect descriptor table
 
 #pragma pack(1)
 typedef struct {
@@ -132,10 +132,10 @@ VirtioPrepare (
   This function implements the following section from virtio-0.9.5:
   - 2.4.1.1 Placing Buffers into the Descriptor Table
 
-  Free space is taken as granted, since the individual drivers support only
-  synchronous requests and host side status is processed in lock-step with
-  request submission. It is the calling driver's responsibility to verify the
-  ring size in advance.
+  Free space is taken as granted, since the individual drivers either support
+  only synchronous requests and process host side status in lock-step with
+  request submission, or track the descriptors of the requests in flight. It
+  is the calling driver's responsibility to verify the ring size in advance.
 
   The caller is responsible for initializing *Indices with VirtioPrepare()
   first.
@@ -151,8 +151,12 @@ VirtioPrepare (
   @param[in] Flags                  A bitmask of VRING_DESC_F_* flags. The
                                     caller computes this mask dependent on
                                     further buffers to append and transfer
-                                    direction. VRING_DESC_F_INDIRECT is
-                                    unsupported. The VRING_DESC.Next field is
+                                    direction. With VRING_DESC_F_INDIRECT,
+                                    the buffer is an indirect descriptor
+                                    table, which can be filled in by calling
+                                    this function on a VRING whose Desc and
+                                    QueueSize fields describe the table. The
+                                    VRING_DESC.Next field is
                                     always set, but the host only interprets
                                     it dependent on VRING_DESC_F_NEXT.
 
@@ -210,6 +214,38 @@ VirtioFlush (
   OUT    UINT32                  *UsedLen    OPTIONAL
   );
 
+/**
+
+  Decide whether the host has to be notified about descriptor chains that the
+  guest has just made available on a virtio ring.
+
+  The caller is expected to have updated the available index of the ring
+  before calling this function. The function issues a full memory barrier
+  between that store and its own loads from the used ring.
+
+  @param[in] Ring         The virtio ring with the newly available descriptor
+                          chains.
+
+  @param[in] EventIdx     TRUE if VIRTIO_F_RING_EVENT_IDX has been negotiated
+                          with the device, FALSE otherwise.
+
+  @param[in] OldAvailIdx  The available index of the ring before the caller
+                          updated it.
+
+  @retval TRUE   The host has to be notified.
+
+  @retval FALSE  The host is going to pick up the new descriptor chains without
+                 a notification.
+
+**/
+BOOLEAN
+EFIAPI
+VirtioRingNotifyNeeded (
+  IN VRING    *Ring,
+  IN BOOLEAN  EventIdx,
+  IN UINT16   OldAvailIdx
+  );
+
 /**
 
   Report the feature bits to the VirtIo 1.0 device that the VirtIo 1.0 driver
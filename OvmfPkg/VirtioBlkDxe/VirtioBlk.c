@@ -1,14 +1,16 @@
 /** @file
 
-  This driver produces Block I/O Protocol instances for virtio-blk devices.
+  This driver produces Block I/O and Block I/O 2 Protocol instances for
+  virtio-blk devices.
 
   The implementation is basic:
 
   - No attach/detach (ie. removable media).
 
-  - Although the non-blocking interfaces of EFI_BLOCK_IO2_PROTOCOL could be a
-    good match for multiple in-flight virtio-blk requests, we stick to
-    synchronous requests and EFI_BLOCK_IO_PROTOCOL for now.
+  - The requests are split in segments that are in flight at the same time,
+    using indirect descriptors if the host supports them. The non-blocking
+    requests of EFI_BLOCK_IO2_PROTOCOL are completed by polling the used ring
+    from a timer event.
 
   Copyright (C) 2012, Red Hat, Inc.
   Copyright (c) 2012 - 2018, Intel Corporation. All rights reserved.<BR>
@@ -176,285 +178,543 @@ VerifyReadWriteRequest (
 
 /**
 
-  Format a read / write / flush request as three consecutive virtio
-  descriptors, push them to the host, and poll for the response.
+  Submit the next segment of a request to the host.
 
-  This is the main workhorse function. Two use cases are supported, read/write
-  and flush. The function may only be called after the request parameters have
-  been verified by
-  - specific checks in ReadBlocks() / WriteBlocks() / FlushBlocks(), and
-  - VerifyReadWriteRequest() (for read/write only).
-
-  Parameters handled commonly:
-
-    @param[in] Dev             The virtio-blk device the request is targeted
-                               at.
-
-  Flush request:
-
-    @param[in] Lba             Must be zero.
-
-    @param[in] BufferSize      Must be zero.
-
-    @param[in out] Buffer      Ignored by the function.
-
-    @param[in] RequestIsWrite  Must be TRUE.
+  The segment is formatted as three descriptors -- request header, data
+  buffer, host status -- or two for flush. With VIRTIO_F_RING_INDIRECT_DESC,
+  the descriptors are placed in the indirect table of the request slot, and
+  the request takes a single descriptor of the ring. The segment is only made
+  available to the host by VirtioBlkProcessRequests().
 
-  Read/Write request:
+  The caller is responsible for running at TPL_NOTIFY, and for ensuring there
+  is a free request slot.
 
-    @param[in] Lba             Logical Block Address: number of logical blocks
-                               to skip from the beginning of the device.
+  @param[in,out] Dev   The virtio-blk device the request is targeted at.
 
-    @param[in] BufferSize      Size of buffer to transfer, in bytes. The caller
-                               is responsible to ensure this parameter is
-                               positive.
+  @param[in,out] Task  The request to submit the next segment of.
 
-    @param[in out] Buffer      The guest side area to read data from the device
-                               into, or write data to the device from.
+  @retval EFI_SUCCESS       The segment is placed in the ring.
 
-    @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to
-                               device.
-
-  Return values are common to both use cases, and are appropriate to be
-  forwarded by the EFI_BLOCK_IO_PROTOCOL functions (ReadBlocks(),
-  WriteBlocks(), FlushBlocks()).
-
-
-  @retval EFI_SUCCESS          Transfer complete.
-
-  @retval EFI_DEVICE_ERROR     Failed to notify host side via VirtIo write, or
-                               unable to parse host response, or host response
-                               is not VIRTIO_BLK_S_OK or failed to map Buffer
-                               for a bus master operation.
+  @retval EFI_DEVICE_ERROR  Failed to map the data buffer for a bus master
+                            operation.
 
 **/
 STATIC
 EFI_STATUS
 EFIAPI
-SynchronousRequest (
-  IN              VBLK_DEV  *Dev,
-  IN              EFI_LBA   Lba,
-  IN              UINTN     BufferSize,
-  IN OUT volatile VOID      *Buffer,
-  IN              BOOLEAN   RequestIsWrite
+VirtioBlkSubmitSegment (
+  IN OUT VBLK_DEV   *Dev,
+  IN OUT VBLK_TASK  *Task
   )
 {
-  UINT32                   BlockSize;
-  volatile VIRTIO_BLK_REQ  Request;
-  volatile UINT8           *HostStatus;
-  VOID                     *HostStatusBuffer;
-  DESC_INDICES             Indices;
-  VOID                     *RequestMapping;
-  VOID                     *StatusMapping;
-  VOID                     *BufferMapping;
-  EFI_PHYSICAL_ADDRESS     BufferDeviceAddress;
-  EFI_PHYSICAL_ADDRESS     HostStatusDeviceAddress;
-  EFI_PHYSICAL_ADDRESS     RequestDeviceAddress;
-  EFI_STATUS               Status;
-  EFI_STATUS               UnmapStatus;
-
-  BlockSize = Dev->BlockIoMedia.BlockSize;
-
-  //
-  // Set BufferMapping and BufferDeviceAddress to suppress incorrect
-  // compiler/analyzer warnings.
-  //
+  EFI_STATUS                Status;
+  UINT16                    SlotIdx;
+  volatile VBLK_SHARED_REQ  *SharedReq;
+  EFI_PHYSICAL_ADDRESS      SharedReqAddress;
+  EFI_PHYSICAL_ADDRESS      BufferDeviceAddress;
+  VOID                      *BufferMapping;
+  UINTN                     Length;
+  VRING                     IndirectTable;
+  VRING                     *Ring;
+  DESC_INDICES              Indices;
+  UINT16                    DescCount;
+
+  ASSERT (Dev->SlotsInUse < Dev->SlotCount);
+
+  Length              = MIN (Task->Remaining, Dev->SegmentSize);
   BufferMapping       = NULL;
   BufferDeviceAddress = 0;
+  if (Length > 0) {
+    Status = VirtioMapAllBytesInSharedBuffer (
+               Dev->VirtIo,
+               (Task->Type == VIRTIO_BLK_T_OUT ?
+                VirtioOperationBusMasterRead :
+                VirtioOperationBusMasterWrite),
+               Task->Buffer,
+               Length,
+               &BufferDeviceAddress,
+               &BufferMapping
+               );
+    if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
+  }
 
-  //
-  // ensured by VirtioBlkInit()
-  //
-  ASSERT (BlockSize > 0);
-  ASSERT (BlockSize % 512 == 0);
+  SlotIdx                           = Dev->FreeSlots[Dev->SlotsInUse++];
+  Dev->Slots[SlotIdx].Task          = Task;
+  Dev->Slots[SlotIdx].BufferMapping = BufferMapping;
 
   //
-  // ensured by contract above, plus VerifyReadWriteRequest()
+  // Prepare virtio-blk request header. IO Priority is homogeneously 0. Preset
+  // a host status for ourselves that we do not accept as success.
   //
-  ASSERT (BufferSize % BlockSize == 0);
+  SharedReq                 = &Dev->SharedReq[SlotIdx];
+  SharedReq->Request.Type   = Task->Type;
+  SharedReq->Request.IoPrio = 0;
+  SharedReq->Request.Sector = MultU64x32 (Task->Lba, Dev->BlockIoMedia.BlockSize / 512);
+  SharedReq->HostStatus     = VIRTIO_BLK_S_IOERR;
+  SharedReqAddress          = Dev->SharedReqAddress + SlotIdx * sizeof (VBLK_SHARED_REQ);
 
   //
-  // Prepare virtio-blk request header, setting zero size for flush.
-  // IO Priority is homogeneously 0.
+  // Without indirect descriptors, slot #N owns the descriptors #3N to #3N+2
+  // of the ring.
   //
-  Request.Type = RequestIsWrite ?
-                 (BufferSize == 0 ? VIRTIO_BLK_T_FLUSH : VIRTIO_BLK_T_OUT) :
-                 VIRTIO_BLK_T_IN;
-  Request.IoPrio = 0;
-  Request.Sector = MultU64x32 (Lba, BlockSize / 512);
+  if (Dev->Indirect) {
+    IndirectTable.Desc      = SharedReq->IndirectDesc;
+    IndirectTable.QueueSize = (UINT16)ARRAY_SIZE (SharedReq->IndirectDesc);
+    Ring                    = &IndirectTable;
+    Indices.NextDescIdx     = 0;
+  } else {
+    Ring                = &Dev->Ring;
+    Indices.NextDescIdx = (UINT16)(3 * SlotIdx);
+  }
 
-  //
-  // Host status is bi-directional (we preset with a value and expect the
-  // device to update it). Allocate a host status buffer which can be mapped
-  // to access equally by both processor and the device.
-  //
-  Status = Dev->VirtIo->AllocateSharedPages (
-                          Dev->VirtIo,
-                          EFI_SIZE_TO_PAGES (sizeof *HostStatus),
-                          &HostStatusBuffer
-                          );
-  if (EFI_ERROR (Status)) {
-    return EFI_DEVICE_ERROR;
+  Indices.HeadDescIdx = Indices.NextDescIdx;
+
+  VirtioAppendDesc (
+    Ring,
+    SharedReqAddress + OFFSET_OF (VBLK_SHARED_REQ, Request),
+    sizeof (VIRTIO_BLK_REQ),
+    VRING_DESC_F_NEXT,
+    &Indices
+    );
+
+  if (Length > 0) {
+    //
+    // Ensured by VirtioBlkInit(): the segment size is below 2^32 bytes. The
+    // VRING_DESC_F_WRITE flag is interpreted from the host's point of view.
+    //
+    VirtioAppendDesc (
+      Ring,
+      BufferDeviceAddress,
+      (UINT32)Length,
+      VRING_DESC_F_NEXT | (Task->Type == VIRTIO_BLK_T_OUT ? 0 : VRING_DESC_F_WRITE),
+      &Indices
+      );
   }
 
-  HostStatus = HostStatusBuffer;
+  VirtioAppendDesc (
+    Ring,
+    SharedReqAddress + OFFSET_OF (VBLK_SHARED_REQ, HostStatus),
+    sizeof (UINT8),
+    VRING_DESC_F_WRITE,
+    &Indices
+    );
 
-  //
-  // Map virtio-blk request header (must be done after request header is
-  // populated)
-  //
-  Status = VirtioMapAllBytesInSharedBuffer (
-             Dev->VirtIo,
-             VirtioOperationBusMasterRead,
-             (VOID *)&Request,
-             sizeof Request,
-             &RequestDeviceAddress,
-             &RequestMapping
-             );
-  if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto FreeHostStatusBuffer;
+  if (Dev->Indirect) {
+    DescCount           = Indices.NextDescIdx;
+    Indices.HeadDescIdx = SlotIdx;
+    Indices.NextDescIdx = SlotIdx;
+    VirtioAppendDesc (
+      &Dev->Ring,
+      SharedReqAddress + OFFSET_OF (VBLK_SHARED_REQ, IndirectDesc),
+      (UINT32)(DescCount * sizeof (VRING_DESC)),
+      VRING_DESC_F_INDIRECT,
+      &Indices
+      );
   }
 
   //
-  // Map data buffer
+  // virtio-0.9.5, 2.4.1.2 Updating the Available Ring
   //
-  if (BufferSize > 0) {
-    Status = VirtioMapAllBytesInSharedBuffer (
-               Dev->VirtIo,
-               (RequestIsWrite ?
-                VirtioOperationBusMasterRead :
-                VirtioOperationBusMasterWrite),
-               (VOID *)Buffer,
-               BufferSize,
-               &BufferDeviceAddress,
-               &BufferMapping
-               );
-    if (EFI_ERROR (Status)) {
-      Status = EFI_DEVICE_ERROR;
-      goto UnmapRequestBuffer;
+  Dev->Ring.Avail.Ring[Dev->AvailIdx++ % Dev->Ring.QueueSize] = Indices.HeadDescIdx;
+
+  Task->Lba       += Length / Dev->BlockIoMedia.BlockSize;
+  Task->Buffer    += Length;
+  Task->Remaining -= Length;
+  Task->Submitted  = (BOOLEAN)(Task->Remaining == 0);
+  Task->Pending++;
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Release the request slot of a segment the host has processed, and account
+  for the result in the request.
+
+  The caller is responsible for running at TPL_NOTIFY.
+
+  @param[in,out] Dev      The virtio-blk device.
+
+  @param[in]     SlotIdx  The request slot of the segment.
+
+**/
+STATIC
+VOID
+EFIAPI
+VirtioBlkCompleteSegment (
+  IN OUT VBLK_DEV  *Dev,
+  IN     UINT16    SlotIdx
+  )
+{
+  VBLK_SLOT   *Slot;
+  VBLK_TASK   *Task;
+  EFI_STATUS  UnmapStatus;
+
+  ASSERT (SlotIdx < Dev->SlotCount);
+  Slot = &Dev->Slots[SlotIdx];
+  Task = Slot->Task;
+  ASSERT (Task != NULL);
+  ASSERT (Task->Pending > 0);
+
+  if (Slot->BufferMapping != NULL) {
+    UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Slot->BufferMapping);
+    if (EFI_ERROR (UnmapStatus) && (Task->Type == VIRTIO_BLK_T_IN)) {
+      //
+      // Data from the bus master may not reach the caller; fail the request.
+      //
+      Task->Status = EFI_DEVICE_ERROR;
     }
   }
 
-  //
-  // preset a host status for ourselves that we do not accept as success
-  //
-  *HostStatus = VIRTIO_BLK_S_IOERR;
+  if (Dev->SharedReq[SlotIdx].HostStatus != VIRTIO_BLK_S_OK) {
+    Task->Status = EFI_DEVICE_ERROR;
+  }
 
   //
-  // Map the Status Buffer with VirtioOperationBusMasterCommonBuffer so that
-  // both processor and device can access it.
+  // Submit no more segments of a failed request.
   //
-  Status = VirtioMapAllBytesInSharedBuffer (
-             Dev->VirtIo,
-             VirtioOperationBusMasterCommonBuffer,
-             HostStatusBuffer,
-             sizeof *HostStatus,
-             &HostStatusDeviceAddress,
-             &StatusMapping
-             );
-  if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto UnmapDataBuffer;
+  if (EFI_ERROR (Task->Status)) {
+    Task->Submitted = TRUE;
   }
 
-  VirtioPrepare (&Dev->Ring, &Indices);
+  Task->Pending--;
+  Slot->Task                         = NULL;
+  Slot->BufferMapping                = NULL;
+  Dev->FreeSlots[--Dev->SlotsInUse] = SlotIdx;
+}
 
-  //
-  // ensured by VirtioBlkInit() -- this predicate, in combination with the
-  // lock-step progress, ensures we don't have to track free descriptors.
-  //
-  ASSERT (Dev->Ring.QueueSize >= 3);
+/**
+
+  Make progress with the requests of a virtio-blk device.
+
+  The segments the host has processed are completed, the segments of the
+  queued requests are submitted as long as there are free request slots, a
+  flush request being submitted only once the requests queued before it are
+  complete, and
+  the requests that are complete are reported: the event of the non-blocking
+  requests is signaled, the blocking requests are marked done. The polling
+  timer is canceled when no request is left.
+
+  The caller is responsible for running at TPL_NOTIFY.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+**/
+STATIC
+VOID
+EFIAPI
+VirtioBlkProcessRequests (
+  IN OUT VBLK_DEV  *Dev
+  )
+{
+  EFI_STATUS  Status;
+  UINT16      UsedIdx;
+  UINT32      DescIdx;
+  LIST_ENTRY  *Link;
+  LIST_ENTRY  *NextLink;
+  VBLK_TASK   *Task;
+  BOOLEAN     Busy;
 
   //
-  // virtio-blk header in first desc
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
   //
-  VirtioAppendDesc (
-    &Dev->Ring,
-    RequestDeviceAddress,
-    sizeof Request,
-    VRING_DESC_F_NEXT,
-    &Indices
-    );
+  MemoryFence ();
+  UsedIdx = *Dev->Ring.Used.Idx;
+  MemoryFence ();
+
+  while (Dev->LastUsed != UsedIdx) {
+    DescIdx = Dev->Ring.Used.UsedElem[Dev->LastUsed++ % Dev->Ring.QueueSize].Id;
+    VirtioBlkCompleteSegment (Dev, (UINT16)(Dev->Indirect ? DescIdx : DescIdx / 3));
+  }
 
   //
-  // data buffer for read/write in second desc
+  // Keep the ring full, submitting the segments of the requests in order.
   //
-  if (BufferSize > 0) {
-    //
-    // From virtio-0.9.5, 2.3.2 Descriptor Table:
-    // "no descriptor chain may be more than 2^32 bytes long in total".
+  Busy = FALSE;
+  for (Link = GetFirstNode (&Dev->TaskList);
+       !IsNull (&Dev->TaskList, Link) && (Dev->SlotsInUse < Dev->SlotCount);
+       Link = GetNextNode (&Dev->TaskList, Link))
+  {
+    Task = VBLK_TASK_FROM_LINK (Link);
+    if ((Task->Type == VIRTIO_BLK_T_FLUSH) && !Task->Submitted && Busy) {
+      //
+      // The host only makes durable the writes it completed before the
+      // flush. The flush waits for the requests queued before it, and the
+      // requests queued after it wait for the flush.
+      //
+      break;
+    }
+
+    while (!Task->Submitted && (Dev->SlotsInUse < Dev->SlotCount)) {
+      Status = VirtioBlkSubmitSegment (Dev, Task);
+      if (EFI_ERROR (Status)) {
+        Task->Status    = Status;
+        Task->Submitted = TRUE;
+      }
+    }
+
+    if (!Task->Submitted || (Task->Pending > 0)) {
+      Busy = TRUE;
+    }
+  }
+
+  if (Dev->AvailIdx != *Dev->Ring.Avail.Idx) {
     //
-    // The predicate is ensured by the call contract above (for flush), or
-    // VerifyReadWriteRequest() (for read/write). It also implies that
-    // converting BufferSize to UINT32 will not truncate it.
+    // virtio-0.9.5, 2.4.1.3 Updating the Index Field
     //
-    ASSERT (BufferSize <= SIZE_1GB);
+    MemoryFence ();
+    *Dev->Ring.Avail.Idx = Dev->AvailIdx;
 
     //
-    // VRING_DESC_F_WRITE is interpreted from the host's point of view.
+    // virtio-0.9.5, 2.4.1.4 Notifying the Device -- one notification for all
+    // the segments submitted. virtio-blk's only virtqueue is #0, called
+    // "requestq" (see Appendix D).
     //
-    VirtioAppendDesc (
-      &Dev->Ring,
-      BufferDeviceAddress,
-      (UINT32)BufferSize,
-      VRING_DESC_F_NEXT | (RequestIsWrite ? 0 : VRING_DESC_F_WRITE),
-      &Indices
-      );
+    MemoryFence ();
+    Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, 0);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: SetQueueNotify: %r\n", __FUNCTION__, Status));
+    }
+  }
+
+  for (Link = GetFirstNode (&Dev->TaskList);
+       !IsNull (&Dev->TaskList, Link);
+       Link = NextLink)
+  {
+    NextLink = GetNextNode (&Dev->TaskList, Link);
+    Task     = VBLK_TASK_FROM_LINK (Link);
+    if (!Task->Submitted || (Task->Pending > 0)) {
+      continue;
+    }
+
+    RemoveEntryList (&Task->Link);
+    if (Task->Token != NULL) {
+      Task->Token->TransactionStatus = Task->Status;
+      gBS->SignalEvent (Task->Token->Event);
+      FreePool (Task);
+    } else {
+      Task->Done = TRUE;
+    }
   }
 
+  if (Dev->TimerArmed && IsListEmpty (&Dev->TaskList)) {
+    gBS->SetTimer (Dev->Timer, TimerCancel, 0);
+    Dev->TimerArmed = FALSE;
+  }
+}
+
+/**
+
+  Timer notification function polling the requests of a virtio-blk device.
+
+  @param[in] Event    Event whose notification function is being invoked.
+
+  @param[in] Context  Pointer to the VBLK_DEV structure.
+
+**/
+STATIC
+VOID
+EFIAPI
+VirtioBlkPollRequests (
+  IN  EFI_EVENT  Event,
+  IN  VOID       *Context
+  )
+{
+  VirtioBlkProcessRequests (Context);
+}
+
+/**
+
+  Queue a read / write / flush request, and wait for its completion if it is
+  blocking.
+
+  The request is split into segments of at most Dev->SegmentSize bytes, which
+  are in flight at the same time. The function may only be called after the
+  request parameters have been verified by
+  - specific checks in the Block I/O and Block I/O 2 functions, and
+  - VerifyReadWriteRequest() (for read/write only).
+
+  @param[in,out] Dev         The virtio-blk device the request is targeted at.
+
+  @param[in]     Type        VIRTIO_BLK_T_IN, VIRTIO_BLK_T_OUT or
+                             VIRTIO_BLK_T_FLUSH.
+
+  @param[in]     Lba         Logical Block Address: number of logical blocks
+                             to skip from the beginning of the device. Must be
+                             zero for flush.
+
+  @param[in]     BufferSize  Size of buffer to transfer, in bytes. Must be zero
+                             for flush, positive otherwise.
+
+  @param[in,out] Buffer      The guest side area to read data from the device
+                             into, or write data to the device from.
+
+  @param[in,out] Token       If Token and Token->Event are not NULL, the
+                             request is non-blocking: the function returns once
+                             the request is queued, and Token->Event is
+                             signaled when the request completes.
+
+
+  @retval EFI_SUCCESS           Transfer complete, or non-blocking request
+                                queued.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @retval EFI_DEVICE_ERROR      Failed to map a buffer for a bus master
+                                operation, or host response is not
+                                VIRTIO_BLK_S_OK.
+
+  @return                       Error codes from gBS->SetTimer() when arming
+                                the polling timer for a non-blocking request.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+VirtioBlkRequest (
+  IN OUT VBLK_DEV             *Dev,
+  IN     UINT32               Type,
+  IN     EFI_LBA              Lba,
+  IN     UINTN                BufferSize,
+  IN OUT VOID                 *Buffer,
+  IN OUT EFI_BLOCK_IO2_TOKEN  *Token OPTIONAL
+  )
+{
+  VBLK_TASK   BlockingTask;
+  VBLK_TASK   *Task;
+  BOOLEAN     Blocking;
+  BOOLEAN     Done;
+  EFI_TPL     OldTpl;
+  UINTN       PollPeriodUsecs;
+  EFI_STATUS  Status;
+
   //
-  // host status in last (second or third) desc
+  // ensured by contract above, plus VerifyReadWriteRequest()
   //
-  VirtioAppendDesc (
-    &Dev->Ring,
-    HostStatusDeviceAddress,
-    sizeof *HostStatus,
-    VRING_DESC_F_WRITE,
-    &Indices
-    );
+  ASSERT (BufferSize % Dev->BlockIoMedia.BlockSize == 0);
+  ASSERT ((BufferSize == 0) == (Type == VIRTIO_BLK_T_FLUSH));
+
+  Blocking = (BOOLEAN)((Token == NULL) || (Token->Event == NULL));
+  if (Blocking) {
+    Task = &BlockingTask;
+    ZeroMem (Task, sizeof *Task);
+  } else {
+    Task = AllocateZeroPool (sizeof *Task);
+    if (Task == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Task->Token = Token;
+  }
+
+  Task->Signature = VBLK_TASK_SIG;
+  Task->Type      = Type;
+  Task->Lba       = Lba;
+  Task->Buffer    = Buffer;
+  Task->Remaining = BufferSize;
+  Task->Status    = EFI_SUCCESS;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
 
   //
-  // virtio-blk's only virtqueue is #0, called "requestq" (see Appendix D).
+  // Non-blocking requests are completed by polling the used ring from the
+  // timer, which only runs while there are requests.
   //
-  if ((VirtioFlush (
-         Dev->VirtIo,
-         0,
-         &Dev->Ring,
-         &Indices,
-         NULL
-         ) == EFI_SUCCESS) &&
-      (*HostStatus == VIRTIO_BLK_S_OK))
-  {
-    Status = EFI_SUCCESS;
-  } else {
-    Status = EFI_DEVICE_ERROR;
+  if (!Blocking && !Dev->TimerArmed) {
+    Status = gBS->SetTimer (Dev->Timer, TimerPeriodic, VBLK_POLL_PERIOD);
+    if (EFI_ERROR (Status)) {
+      gBS->RestoreTPL (OldTpl);
+      FreePool (Task);
+      return Status;
+    }
+
+    Dev->TimerArmed = TRUE;
   }
 
-  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, StatusMapping);
+  InsertTailList (&Dev->TaskList, &Task->Link);
+  VirtioBlkProcessRequests (Dev);
+  gBS->RestoreTPL (OldTpl);
 
-UnmapDataBuffer:
-  if (BufferSize > 0) {
-    UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, BufferMapping);
-    if (EFI_ERROR (UnmapStatus) && !RequestIsWrite && !EFI_ERROR (Status)) {
-      //
-      // Data from the bus master may not reach the caller; fail the request.
-      //
-      Status = EFI_DEVICE_ERROR;
+  if (!Blocking) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Poll for the completion. Keep slowing down until we reach a poll period of
+  // slightly above 1 ms, like VirtioFlush().
+  //
+  PollPeriodUsecs = 1;
+  for ( ; ;) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    VirtioBlkProcessRequests (Dev);
+    Done = Task->Done;
+    gBS->RestoreTPL (OldTpl);
+    if (Done) {
+      break;
+    }
+
+    gBS->Stall (PollPeriodUsecs);
+    if (PollPeriodUsecs < 1024) {
+      PollPeriodUsecs *= 2;
     }
   }
 
-UnmapRequestBuffer:
-  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, RequestMapping);
+  return Task->Status;
+}
 
-FreeHostStatusBuffer:
-  Dev->VirtIo->FreeSharedPages (
-                 Dev->VirtIo,
-                 EFI_SIZE_TO_PAGES (sizeof *HostStatus),
-                 HostStatusBuffer
-                 );
+/**
 
-  return Status;
+  Wait until all the requests of a virtio-blk device complete.
+
+  @param[in,out] Dev  The virtio-blk device.
+
+**/
+STATIC
+VOID
+EFIAPI
+VirtioBlkDrainRequests (
+  IN OUT VBLK_DEV  *Dev
+  )
+{
+  EFI_TPL  OldTpl;
+  BOOLEAN  Empty;
+
+  for ( ; ;) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    VirtioBlkProcessRequests (Dev);
+    Empty = IsListEmpty (&Dev->TaskList);
+    gBS->RestoreTPL (OldTpl);
+    if (Empty) {
+      break;
+    }
+
+    gBS->Stall (1000);
+  }
+}
+
+/**
+
+  Report the completion of a request without data transfer.
+
+  @param[in,out] Token  The token of a non-blocking request, or NULL.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+VirtioBlkCompleteEmptyRequest (
+  IN OUT EFI_BLOCK_IO2_TOKEN  *Token OPTIONAL
+  )
+{
+  if ((Token != NULL) && (Token->Event != NULL)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return EFI_SUCCESS;
 }
 
 /**
@@ -468,7 +728,7 @@ FreeHostStatusBuffer:
     ReadBlocksEx() Implementation.
 
   Parameter checks and conformant return values are implemented in
-  VerifyReadWriteRequest() and SynchronousRequest().
+  VerifyReadWriteRequest() and VirtioBlkRequest().
 
   A zero BufferSize doesn't seem to be prohibited, so do nothing in that case,
   successfully.
@@ -502,12 +762,13 @@ VirtioBlkReadBlocks (
     return Status;
   }
 
-  return SynchronousRequest (
+  return VirtioBlkRequest (
            Dev,
+           VIRTIO_BLK_T_IN,
            Lba,
            BufferSize,
            Buffer,
-           FALSE       // RequestIsWrite
+           NULL        // Token
            );
 }
 
@@ -522,7 +783,7 @@ VirtioBlkReadBlocks (
     WriteBlockEx() Implementation.
 
   Parameter checks and conformant return values are implemented in
-  VerifyReadWriteRequest() and SynchronousRequest().
+  VerifyReadWriteRequest() and VirtioBlkRequest().
 
   A zero BufferSize doesn't seem to be prohibited, so do nothing in that case,
   successfully.
@@ -556,12 +817,13 @@ VirtioBlkWriteBlocks (
     return Status;
   }
 
-  return SynchronousRequest (
+  return VirtioBlkRequest (
            Dev,
+           VIRTIO_BLK_T_OUT,
            Lba,
            BufferSize,
            Buffer,
-           TRUE        // RequestIsWrite
+           NULL        // Token
            );
 }
 
@@ -591,16 +853,185 @@ VirtioBlkFlushBlocks (
 
   Dev = VIRTIO_BLK_FROM_BLOCK_IO (This);
   return Dev->BlockIoMedia.WriteCaching ?
-         SynchronousRequest (
+         VirtioBlkRequest (
            Dev,
+           VIRTIO_BLK_T_FLUSH,
            0,      // Lba
            0,      // BufferSize
            NULL,   // Buffer
-           TRUE    // RequestIsWrite
+           NULL    // Token
            ) :
          EFI_SUCCESS;
 }
 
+//
+// UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol
+// Driver Writer's Guide for UEFI 2.3.1 v1.01,
+//   24.2 Block I/O Protocol Implementations
+//
+
+/**
+
+  Reset() operation of EFI_BLOCK_IO2_PROTOCOL for virtio-blk.
+
+  The virtio-blk requests cannot be aborted; the function waits until the
+  requests in flight complete, and their events are signaled.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN BOOLEAN                 ExtendedVerification
+  )
+{
+  VirtioBlkDrainRequests (VIRTIO_BLK_FROM_BLOCK_IO2 (This));
+  return EFI_SUCCESS;
+}
+
+/**
+
+  ReadBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.2. ReadBlocks() and
+    ReadBlocksEx() Implementation.
+
+  Parameter checks and conformant return values are implemented in
+  VerifyReadWriteRequest() and VirtioBlkRequest(). The request is blocking if
+  Token or Token->Event is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN     UINT32                  MediaId,
+  IN     EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token,
+  IN     UINTN                   BufferSize,
+  OUT    VOID                    *Buffer
+  )
+{
+  VBLK_DEV    *Dev;
+  EFI_STATUS  Status;
+
+  if (BufferSize == 0) {
+    return VirtioBlkCompleteEmptyRequest (Token);
+  }
+
+  Dev    = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  Status = VerifyReadWriteRequest (
+             &Dev->BlockIoMedia,
+             Lba,
+             BufferSize,
+             FALSE               // RequestIsWrite
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return VirtioBlkRequest (
+           Dev,
+           VIRTIO_BLK_T_IN,
+           Lba,
+           BufferSize,
+           Buffer,
+           Token
+           );
+}
+
+/**
+
+  WriteBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.3 WriteBlocks() and
+    WriteBlockEx() Implementation.
+
+  Parameter checks and conformant return values are implemented in
+  VerifyReadWriteRequest() and VirtioBlkRequest(). The request is blocking if
+  Token or Token->Event is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN     UINT32                  MediaId,
+  IN     EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token,
+  IN     UINTN                   BufferSize,
+  IN     VOID                    *Buffer
+  )
+{
+  VBLK_DEV    *Dev;
+  EFI_STATUS  Status;
+
+  if (BufferSize == 0) {
+    return VirtioBlkCompleteEmptyRequest (Token);
+  }
+
+  Dev    = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  Status = VerifyReadWriteRequest (
+             &Dev->BlockIoMedia,
+             Lba,
+             BufferSize,
+             TRUE                // RequestIsWrite
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return VirtioBlkRequest (
+           Dev,
+           VIRTIO_BLK_T_OUT,
+           Lba,
+           BufferSize,
+           Buffer,
+           Token
+           );
+}
+
+/**
+
+  FlushBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.4 FlushBlocks() and
+    FlushBlocksEx() Implementation.
+
+  As with FlushBlocks(), nothing is sent to a device without write-caching.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token
+  )
+{
+  VBLK_DEV  *Dev;
+
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  return Dev->BlockIoMedia.WriteCaching ?
+         VirtioBlkRequest (
+           Dev,
+           VIRTIO_BLK_T_FLUSH,
+           0,      // Lba
+           0,      // BufferSize
+           NULL,   // Buffer
+           Token
+           ) :
+         VirtioBlkCompleteEmptyRequest (Token);
+}
+
 /**
 
   Device probe function for this driver.
@@ -684,6 +1115,145 @@ VirtioBlkDriverBindingSupported (
   return Status;
 }
 
+/**
+
+  Set up the request slots of a virtio-blk device: the free slot stack, and
+  the request headers, host status bytes and indirect descriptor tables that
+  both the processor and the device access.
+
+  @param[in out] Dev  The driver instance to configure. Dev->Ring must be set
+                      up, and Dev->Indirect must reflect the negotiated
+                      features.
+
+  @retval EFI_SUCCESS           Setup complete.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       Error codes from
+                                VirtIo->AllocateSharedPages() or
+                                VirtioMapAllBytesInSharedBuffer().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+VirtioBlkInitSlots (
+  IN OUT VBLK_DEV  *Dev
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *SharedReqBuffer;
+  UINT16      SlotIdx;
+
+  //
+  // Each request takes one descriptor of the ring with indirect descriptors,
+  // three without.
+  //
+  Dev->SlotCount = (UINT16)MIN (
+                             Dev->Indirect ? Dev->Ring.QueueSize : Dev->Ring.QueueSize / 3,
+                             VBLK_MAX_PENDING
+                             );
+  Dev->SlotsInUse = 0;
+  Dev->FreeSlots  = AllocatePool (Dev->SlotCount * sizeof *Dev->FreeSlots);
+  Dev->Slots      = AllocateZeroPool (Dev->SlotCount * sizeof *Dev->Slots);
+  if ((Dev->FreeSlots == NULL) || (Dev->Slots == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto FreeSlots;
+  }
+
+  Status = Dev->VirtIo->AllocateSharedPages (
+                          Dev->VirtIo,
+                          EFI_SIZE_TO_PAGES (Dev->SlotCount * sizeof *Dev->SharedReq),
+                          &SharedReqBuffer
+                          );
+  if (EFI_ERROR (Status)) {
+    goto FreeSlots;
+  }
+
+  ZeroMem (SharedReqBuffer, Dev->SlotCount * sizeof *Dev->SharedReq);
+
+  Status = VirtioMapAllBytesInSharedBuffer (
+             Dev->VirtIo,
+             VirtioOperationBusMasterCommonBuffer,
+             SharedReqBuffer,
+             Dev->SlotCount * sizeof *Dev->SharedReq,
+             &Dev->SharedReqAddress,
+             &Dev->SharedReqMap
+             );
+  if (EFI_ERROR (Status)) {
+    goto FreeSharedReqBuffer;
+  }
+
+  Dev->SharedReq = SharedReqBuffer;
+
+  for (SlotIdx = 0; SlotIdx < Dev->SlotCount; SlotIdx++) {
+    Dev->FreeSlots[SlotIdx] = SlotIdx;
+  }
+
+  InitializeListHead (&Dev->TaskList);
+
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
+  //
+  MemoryFence ();
+  Dev->AvailIdx = *Dev->Ring.Avail.Idx;
+  Dev->LastUsed = *Dev->Ring.Used.Idx;
+  ASSERT (Dev->LastUsed == 0);
+
+  //
+  // We're going to poll the answers, the host should not send interrupts.
+  //
+  *Dev->Ring.Avail.Flags = (UINT16)VRING_AVAIL_F_NO_INTERRUPT;
+
+  return EFI_SUCCESS;
+
+FreeSharedReqBuffer:
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 EFI_SIZE_TO_PAGES (Dev->SlotCount * sizeof *Dev->SharedReq),
+                 SharedReqBuffer
+                 );
+
+FreeSlots:
+  if (Dev->FreeSlots != NULL) {
+    FreePool (Dev->FreeSlots);
+  }
+
+  if (Dev->Slots != NULL) {
+    FreePool (Dev->Slots);
+  }
+
+  return Status;
+}
+
+/**
+
+  Release the request slots of a virtio-blk device set up with
+  VirtioBlkInitSlots().
+
+  The caller is responsible for stopping the host from using the slots: the
+  device must be reset.
+
+  @param[in out] Dev  The device to clean up.
+
+**/
+STATIC
+VOID
+EFIAPI
+VirtioBlkUninitSlots (
+  IN OUT VBLK_DEV  *Dev
+  )
+{
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->SharedReqMap);
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 EFI_SIZE_TO_PAGES (Dev->SlotCount * sizeof *Dev->SharedReq),
+                 (VOID *)Dev->SharedReq
+                 );
+  FreePool (Dev->FreeSlots);
+  FreePool (Dev->Slots);
+}
+
 /**
 
   Set up all BlockIo and virtio-blk aspects of this driver for the specified
@@ -700,7 +1270,7 @@ VirtioBlkDriverBindingSupported (
 
   @return                  Error codes from VirtioRingInit() or
                            VIRTIO_CFG_READ() / VIRTIO_CFG_WRITE or
-                           VirtioRingMap().
+                           VirtioRingMap() or VirtioBlkInitSlots().
 
 **/
 STATIC
@@ -821,7 +1391,16 @@ VirtioBlkInit (
 
   Features &= VIRTIO_BLK_F_BLK_SIZE | VIRTIO_BLK_F_TOPOLOGY | VIRTIO_BLK_F_RO |
               VIRTIO_BLK_F_FLUSH | VIRTIO_F_VERSION_1 |
-              VIRTIO_F_IOMMU_PLATFORM;
+              VIRTIO_F_IOMMU_PLATFORM | VIRTIO_F_RING_INDIRECT_DESC;
+  Dev->Indirect = (BOOLEAN)((Features & VIRTIO_F_RING_INDIRECT_DESC) != 0);
+
+  //
+  // Split the requests in segments of whole blocks. From virtio-0.9.5, 2.3.2
+  // Descriptor Table: "no descriptor chain may be more than 2^32 bytes long in
+  // total".
+  //
+  Dev->SegmentSize = MAX (VBLK_SEGMENT_SIZE / BlockSize, 1) * BlockSize;
+  ASSERT (Dev->SegmentSize <= SIZE_1GB);
 
   //
   // In virtio-1.0, feature negotiation is expected to complete before queue
@@ -848,7 +1427,7 @@ VirtioBlkInit (
   }
 
   if (QueueSize < 3) {
-    // SynchronousRequest() uses at most three descriptors
+    // a request uses at most three descriptors without indirect descriptors
     Status = EFI_UNSUPPORTED;
     goto Failed;
   }
@@ -897,6 +1476,14 @@ VirtioBlkInit (
     goto UnmapQueue;
   }
 
+  //
+  // If anything fails from here on, we must release the request slots.
+  //
+  Status = VirtioBlkInitSlots (Dev);
+  if (EFI_ERROR (Status)) {
+    goto UnmapQueue;
+  }
+
   //
   // step 5 -- Report understood features.
   //
@@ -904,7 +1491,7 @@ VirtioBlkInit (
     Features &= ~(UINT64)(VIRTIO_F_VERSION_1 | VIRTIO_F_IOMMU_PLATFORM);
     Status    = Dev->VirtIo->SetGuestFeatures (Dev->VirtIo, Features);
     if (EFI_ERROR (Status)) {
-      goto UnmapQueue;
+      goto UninitSlots;
     }
   }
 
@@ -914,7 +1501,7 @@ VirtioBlkInit (
   NextDevStat |= VSTAT_DRIVER_OK;
   Status       = Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, NextDevStat);
   if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
+    goto UninitSlots;
   }
 
   //
@@ -927,6 +1514,11 @@ VirtioBlkInit (
   Dev->BlockIo.ReadBlocks            = &VirtioBlkReadBlocks;
   Dev->BlockIo.WriteBlocks           = &VirtioBlkWriteBlocks;
   Dev->BlockIo.FlushBlocks           = &VirtioBlkFlushBlocks;
+  Dev->BlockIo2.Media                = &Dev->BlockIoMedia;
+  Dev->BlockIo2.Reset                = &VirtioBlkResetEx;
+  Dev->BlockIo2.ReadBlocksEx         = &VirtioBlkReadBlocksEx;
+  Dev->BlockIo2.WriteBlocksEx        = &VirtioBlkWriteBlocksEx;
+  Dev->BlockIo2.FlushBlocksEx        = &VirtioBlkFlushBlocksEx;
   Dev->BlockIoMedia.MediaId          = 0;
   Dev->BlockIoMedia.RemovableMedia   = FALSE;
   Dev->BlockIoMedia.MediaPresent     = TRUE;
@@ -947,6 +1539,14 @@ VirtioBlkInit (
     Dev->BlockIoMedia.BlockSize,
     Dev->BlockIoMedia.LastBlock + 1
     ));
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: Slots=%u Indirect=%d SegmentSize=0x%Lx[B]\n",
+    __FUNCTION__,
+    Dev->SlotCount,
+    Dev->Indirect,
+    (UINT64)Dev->SegmentSize
+    ));
 
   if (Features & VIRTIO_BLK_F_TOPOLOGY) {
     Dev->BlockIo.Revision = EFI_BLOCK_IO_PROTOCOL_REVISION3;
@@ -972,6 +1572,9 @@ VirtioBlkInit (
 
   return EFI_SUCCESS;
 
+UninitSlots:
+  VirtioBlkUninitSlots (Dev);
+
 UnmapQueue:
   Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->RingMap);
 
@@ -1011,10 +1614,12 @@ VirtioBlkUninit (
   //
   Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, 0);
 
+  VirtioBlkUninitSlots (Dev);
   Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->RingMap);
   VirtioRingUninit (Dev->VirtIo, &Dev->Ring);
 
   SetMem (&Dev->BlockIo, sizeof Dev->BlockIo, 0x00);
+  SetMem (&Dev->BlockIo2, sizeof Dev->BlockIo2, 0x00);
   SetMem (&Dev->BlockIoMedia, sizeof Dev->BlockIoMedia, 0x00);
 }
 
@@ -1074,7 +1679,8 @@ VirtioBlkExitBoot (
 
   @return                       Error codes from the OpenProtocol() boot
                                 service, the VirtIo protocol, VirtioBlkInit(),
-                                or the InstallProtocolInterface() boot service.
+                                or the InstallMultipleProtocolInterfaces() boot
+                                service.
 
 **/
 EFI_STATUS
@@ -1125,21 +1731,43 @@ VirtioBlkDriverBindingStart (
   }
 
   //
-  // Setup complete, attempt to export the driver instance's BlockIo interface.
+  // The non-blocking requests are completed by polling the used ring. The
+  // timer is armed by VirtioBlkRequest() when such a request is queued, and
+  // canceled by VirtioBlkProcessRequests() once no request is left.
+  //
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  &VirtioBlkPollRequests,
+                  Dev,
+                  &Dev->Timer
+                  );
+  if (EFI_ERROR (Status)) {
+    goto CloseExitBoot;
+  }
+
+  //
+  // Setup complete, attempt to export the driver instance's BlockIo and
+  // BlockIo2 interfaces.
   //
   Dev->Signature = VBLK_SIG;
-  Status         = gBS->InstallProtocolInterface (
+  Status         = gBS->InstallMultipleProtocolInterfaces (
                           &DeviceHandle,
                           &gEfiBlockIoProtocolGuid,
-                          EFI_NATIVE_INTERFACE,
-                          &Dev->BlockIo
+                          &Dev->BlockIo,
+                          &gEfiBlockIo2ProtocolGuid,
+                          &Dev->BlockIo2,
+                          NULL
                           );
   if (EFI_ERROR (Status)) {
-    goto CloseExitBoot;
+    goto CloseTimer;
   }
 
   return EFI_SUCCESS;
 
+CloseTimer:
+  gBS->CloseEvent (Dev->Timer);
+
 CloseExitBoot:
   gBS->CloseEvent (Dev->ExitBoot);
 
@@ -1162,7 +1790,8 @@ FreeVirtioBlk:
 
 /**
 
-  Stop driving a virtio-blk device and remove its BlockIo interface.
+  Stop driving a virtio-blk device and remove its BlockIo and BlockIo2
+  interfaces.
 
   This function replays the success path of DriverBindingStart() in reverse.
   The host side virtio-blk device is reset, so that the OS boot loader or the
@@ -1212,15 +1841,24 @@ VirtioBlkDriverBindingStop (
   //
   // Handle Stop() requests for in-use driver instances gracefully.
   //
-  Status = gBS->UninstallProtocolInterface (
+  Status = gBS->UninstallMultipleProtocolInterfaces (
                   DeviceHandle,
                   &gEfiBlockIoProtocolGuid,
-                  &Dev->BlockIo
+                  &Dev->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid,
+                  &Dev->BlockIo2,
+                  NULL
                   );
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
+  //
+  // Complete the non-blocking requests still in flight before resetting the
+  // device.
+  //
+  VirtioBlkDrainRequests (Dev);
+  gBS->CloseEvent (Dev->Timer);
   gBS->CloseEvent (Dev->ExitBoot);
 
   VirtioBlkUninit (Dev);
@@ -1,7 +1,7 @@
 /** @file
 
   Internal definitions for the virtio-blk driver, which produces Block I/O
-  Protocol instances for virtio-blk devices.
+  and Block I/O 2 Protocol instances for virtio-blk devices.
 
   Copyright (C) 2012, Red Hat, Inc.
 
@@ -13,13 +13,72 @@
 #define _VIRTIO_BLK_DXE_H_
 
 #include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
 #include <Protocol/ComponentName.h>
 #include <Protocol/DriverBinding.h>
 
 #include <IndustryStandard/Virtio.h>
+#include <IndustryStandard/VirtioBlk.h>
 
 #define VBLK_SIG  SIGNATURE_32 ('V', 'B', 'L', 'K')
 
+//
+// The requests are split into segments of at most VBLK_SEGMENT_SIZE bytes, and
+// at most VBLK_MAX_PENDING segments are in flight.
+//
+#define VBLK_SEGMENT_SIZE  SIZE_1MB
+#define VBLK_MAX_PENDING   32
+
+//
+// Polling period of the non-blocking requests, in 100ns units.
+//
+#define VBLK_POLL_PERIOD  EFI_TIMER_PERIOD_MILLISECONDS (1)
+
+//
+// The part of a request slot that the device accesses: the virtio-blk request
+// header, the host status byte, and the indirect descriptor table carrying the
+// whole descriptor chain when VIRTIO_F_RING_INDIRECT_DESC is negotiated. The
+// size of the structure keeps the indirect tables 16-byte aligned.
+//
+#pragma pack(1)
+typedef struct {
+  VIRTIO_BLK_REQ    Request;
+  UINT8             HostStatus;
+  UINT8             Reserved[15];
+  VRING_DESC        IndirectDesc[3];
+} VBLK_SHARED_REQ;
+#pragma pack()
+
+#define VBLK_TASK_SIG  SIGNATURE_32 ('V', 'B', 'L', 'T')
+
+//
+// A read, write or flush request, in flight or waiting for free slots.
+//
+typedef struct {
+  UINT32                 Signature;
+  LIST_ENTRY             Link;
+  EFI_BLOCK_IO2_TOKEN    *Token;     // NULL for the blocking requests
+  UINT32                 Type;       // VIRTIO_BLK_T_IN, _OUT or _FLUSH
+  EFI_LBA                Lba;        // start of the next segment
+  UINT8                  *Buffer;    // start of the next segment
+  UINTN                  Remaining;  // bytes not submitted yet
+  BOOLEAN                Submitted;  // no more segment to submit
+  UINTN                  Pending;    // segments in flight
+  BOOLEAN                Done;       // blocking request complete
+  EFI_STATUS             Status;
+} VBLK_TASK;
+
+#define VBLK_TASK_FROM_LINK(LinkPointer) \
+        CR (LinkPointer, VBLK_TASK, Link, VBLK_TASK_SIG)
+
+//
+// A segment in flight.
+//
+typedef struct {
+  VBLK_TASK    *Task;
+  VOID         *BufferMapping;        // NULL for flush
+} VBLK_SLOT;
+
 typedef struct {
   //
   // Parts of this structure are initialized / torn down in various functions
@@ -31,15 +90,33 @@ typedef struct {
   UINT32                    Signature;         // DriverBindingStart  0
   VIRTIO_DEVICE_PROTOCOL    *VirtIo;           // DriverBindingStart  0
   EFI_EVENT                 ExitBoot;          // DriverBindingStart  0
+  EFI_EVENT                 Timer;             // DriverBindingStart  0
+  BOOLEAN                   TimerArmed;        // DriverBindingStart  0
   VRING                     Ring;              // VirtioRingInit      2
   EFI_BLOCK_IO_PROTOCOL     BlockIo;           // VirtioBlkInit       1
+  EFI_BLOCK_IO2_PROTOCOL    BlockIo2;          // VirtioBlkInit       1
   EFI_BLOCK_IO_MEDIA        BlockIoMedia;      // VirtioBlkInit       1
   VOID                      *RingMap;          // VirtioRingMap       2
+  BOOLEAN                   Indirect;          // VirtioBlkInit       1
+  UINTN                     SegmentSize;       // VirtioBlkInit       1
+  UINT16                    SlotCount;         // VirtioBlkInitSlots  2
+  UINT16                    SlotsInUse;        // VirtioBlkInitSlots  2
+  UINT16                    *FreeSlots;        // VirtioBlkInitSlots  2
+  VBLK_SLOT                 *Slots;            // VirtioBlkInitSlots  2
+  volatile VBLK_SHARED_REQ  *SharedReq;        // VirtioBlkInitSlots  2
+  EFI_PHYSICAL_ADDRESS      SharedReqAddress;  // VirtioBlkInitSlots  2
+  VOID                      *SharedReqMap;     // VirtioBlkInitSlots  2
+  UINT16                    AvailIdx;          // VirtioBlkInitSlots  2
+  UINT16                    LastUsed;          // VirtioBlkInitSlots  2
+  LIST_ENTRY                TaskList;          // VirtioBlkInitSlots  2
 } VBLK_DEV;
 
 #define VIRTIO_BLK_FROM_BLOCK_IO(BlockIoPointer) \
         CR (BlockIoPointer, VBLK_DEV, BlockIo, VBLK_SIG)
 
+#define VIRTIO_BLK_FROM_BLOCK_IO2(BlockIo2Pointer) \
+        CR (BlockIo2Pointer, VBLK_DEV, BlockIo2, VBLK_SIG)
+
 /**
 
   Device probe function for this driver.
@@ -123,7 +200,8 @@ VirtioBlkDriverBindingStart (
 
 /**
 
-  Stop driving a virtio-blk device and remove its BlockIo interface.
+  Stop driving a virtio-blk device and remove its BlockIo and BlockIo2
+  interfaces.
 
   This function replays the success path of DriverBindingStart() in reverse.
   The host side virtio-blk device is reset, so that the OS boot loader or the
@@ -244,6 +322,103 @@ VirtioBlkFlushBlocks (
   IN EFI_BLOCK_IO_PROTOCOL  *This
   );
 
+//
+// UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol
+// Driver Writer's Guide for UEFI 2.3.1 v1.01,
+//   24.2 Block I/O Protocol Implementations
+//
+
+/**
+
+  Reset() operation of EFI_BLOCK_IO2_PROTOCOL for virtio-blk.
+
+  The virtio-blk requests cannot be aborted; the function waits until the
+  requests in flight complete, and their events are signaled.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN BOOLEAN                 ExtendedVerification
+  );
+
+/**
+
+  ReadBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.2. ReadBlocks() and
+    ReadBlocksEx() Implementation.
+
+  Parameter checks and conformant return values are implemented in
+  VerifyReadWriteRequest() and VirtioBlkRequest(). The request is blocking if
+  Token or Token->Event is NULL.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN     UINT32                  MediaId,
+  IN     EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token,
+  IN     UINTN                   BufferSize,
+  OUT    VOID                    *Buffer
+  );
+
+/**
+
+  WriteBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.3 WriteBlocks() and
+    WriteBlockEx() Implementation.
+
+  Parameter checks and conformant return values are implemented in
+  VerifyReadWriteRequest() and VirtioBlkRequest(). The request is blocking if
+  Token or Token->Event is NULL.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN     UINT32                  MediaId,
+  IN     EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token,
+  IN     UINTN                   BufferSize,
+  IN     VOID                    *Buffer
+  );
+
+/**
+
+  FlushBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.4 FlushBlocks() and
+    FlushBlocksEx() Implementation.
+
+  As with FlushBlocks(), nothing is sent to a device without write-caching.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN     *Token
+  );
+
 //
 // The purpose of the following scaffolding (EFI_COMPONENT_NAME_PROTOCOL and
 // EFI_COMPONENT_NAME2_PROTOCOL implementation) is to format the driver's name
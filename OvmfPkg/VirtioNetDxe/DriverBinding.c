@@ -223,6 +223,8 @@ VirtioNetSnpPopulate (
   Dev->Snm.MacAddressChangeable = FALSE;
   Dev->Snm.MultipleTxSupported  = TRUE;
 
+  VirtioNetResetStatistics (Dev);
+
   ASSERT (SIZE_OF_VNET (Mac) <= sizeof (EFI_MAC_ADDRESS));
 
   Status = VirtioNetGetFeatures (
@@ -134,6 +134,7 @@ VirtioNetGetStatus (
       UsedElemIdx = Dev->TxLastUsed++ % Dev->TxRing.QueueSize;
       DescIdx     = Dev->TxRing.Used.UsedElem[UsedElemIdx].Id;
       ASSERT (DescIdx < (UINT32)(2 * Dev->TxMaxPending - 1));
+      VirtioNetSuppressUsedEvent (Dev, &Dev->TxRing, Dev->TxLastUsed);
 
       //
       // get the device address that has been enqueued for the caller's
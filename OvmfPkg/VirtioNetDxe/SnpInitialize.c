@@ -14,6 +14,7 @@
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
 #include "VirtioNet.h"
@@ -264,6 +265,8 @@ VirtioNetInitTx (
   // want no interrupt when a transmit completes
   //
   *Dev->TxRing.Avail.Flags = (UINT16)VRING_AVAIL_F_NO_INTERRUPT;
+  VirtioNetSuppressUsedEvent (Dev, &Dev->TxRing, Dev->TxLastUsed);
+  Dev->TxKicks = 0;
 
   return EFI_SUCCESS;
 
@@ -343,7 +346,11 @@ VirtioNetInitRx (
   // Limit the number of pending RX packets if the queue is big. The division
   // by two is due to the above "two descriptors per packet" trait.
   //
-  RxAlwaysPending = (UINT16)MIN (Dev->RxRing.QueueSize / 2, VNET_MAX_PENDING);
+  RxAlwaysPending = (UINT16)MIN (
+                              Dev->RxRing.QueueSize / 2,
+                              PcdGet16 (PcdVirtioNetRxMaxPending)
+                              );
+  ASSERT (RxAlwaysPending > 0);
 
   //
   // The RxBuf is shared between guest and hypervisor, use
@@ -391,6 +398,7 @@ VirtioNetInitRx (
   // and VirtioNetIsPacketAvailable().
   //
   *Dev->RxRing.Avail.Flags = (UINT16)VRING_AVAIL_F_NO_INTERRUPT;
+  VirtioNetSuppressUsedEvent (Dev, &Dev->RxRing, Dev->RxLastUsed);
 
   //
   // now set up a separate, two-part descriptor chain for each RX packet, and
@@ -441,6 +449,8 @@ VirtioNetInitRx (
     goto UnmapSharedBuffer;
   }
 
+  Dev->RxKicks = 1;
+
   return Status;
 
 UnmapSharedBuffer:
@@ -558,7 +568,7 @@ VirtioNetInitialize (
     );
 
   Features &= VIRTIO_NET_F_MAC | VIRTIO_NET_F_STATUS | VIRTIO_F_VERSION_1 |
-              VIRTIO_F_IOMMU_PLATFORM;
+              VIRTIO_F_IOMMU_PLATFORM | VIRTIO_F_RING_EVENT_IDX;
 
   //
   // In virtio-1.0, feature negotiation is expected to complete before queue
@@ -571,6 +581,14 @@ VirtioNetInitialize (
     }
   }
 
+  //
+  // With VIRTIO_F_RING_EVENT_IDX, the device tells us in the "avail_event"
+  // field of each used ring whether it needs to be notified about new
+  // available descriptor chains; VirtioNetTransmit() and VirtioNetReceive()
+  // skip the notification while the device is busy processing the queue.
+  //
+  Dev->EventIdx = (BOOLEAN)((Features & VIRTIO_F_RING_EVENT_IDX) != 0);
+
   //
   // step 4b, 4c -- allocate and report virtqueues
   //
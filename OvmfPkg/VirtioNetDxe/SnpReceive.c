@@ -74,6 +74,7 @@ VirtioNetReceive (
   UINTN       OrigBufferSize;
   UINT8       *RxPtr;
   UINT16      AvailIdx;
+  UINT16      OldAvailIdx;
   EFI_STATUS  NotifyStatus;
   UINTN       RxBufOffset;
 
@@ -129,6 +130,8 @@ VirtioNetReceive (
   }
 
   if (RxLen < Dev->Snm.MediaHeaderSize) {
+    ++Dev->Statistics.RxTotalFrames;
+    ++Dev->Statistics.RxUndersizeFrames;
     Status = EFI_DEVICE_ERROR;
     goto RecycleDesc; // drop useless short packet
   }
@@ -141,6 +144,7 @@ VirtioNetReceive (
                         Dev->RxBufDeviceBase);
   RxPtr = Dev->RxBuf + RxBufOffset;
   CopyMem (Buffer, RxPtr, RxLen);
+  VirtioNetCountFrame (Dev, FALSE, RxPtr, RxLen);
 
   if (DestAddr != NULL) {
     CopyMem (DestAddr, RxPtr, SIZE_OF_VNET (Mac));
@@ -164,22 +168,31 @@ VirtioNetReceive (
 
 RecycleDesc:
   ++Dev->RxLastUsed;
+  VirtioNetSuppressUsedEvent (Dev, &Dev->RxRing, Dev->RxLastUsed);
 
   //
   // virtio-0.9.5, 2.4.1 Supplying Buffers to The Device
   //
-  AvailIdx                                                   = *Dev->RxRing.Avail.Idx;
+  OldAvailIdx                                                = *Dev->RxRing.Avail.Idx;
+  AvailIdx                                                   = OldAvailIdx;
   Dev->RxRing.Avail.Ring[AvailIdx++ % Dev->RxRing.QueueSize] =
     (UINT16)DescIdx;
 
   MemoryFence ();
   *Dev->RxRing.Avail.Idx = AvailIdx;
 
+  //
+  // Only a device that has run out of receive buffers needs to learn about
+  // the recycled one; otherwise it will pick it up when it gets there.
+  //
   MemoryFence ();
-  NotifyStatus = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_RX);
-  if (!EFI_ERROR (Status)) {
-    // earlier error takes precedence
-    Status = NotifyStatus;
+  if (VirtioRingNotifyNeeded (&Dev->RxRing, Dev->EventIdx, OldAvailIdx)) {
+    ++Dev->RxKicks;
+    NotifyStatus = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_RX);
+    if (!EFI_ERROR (Status)) {
+      // earlier error takes precedence
+      Status = NotifyStatus;
+    }
   }
 
 Exit:
@@ -103,6 +103,34 @@ VirtioNetUninitRing (
   VirtioRingUninit (Dev->VirtIo, Ring);
 }
 
+/**
+  Keep the device from interrupting the guest when it places new elements on
+  the used ring of a queue.
+
+  With VIRTIO_F_RING_EVENT_IDX negotiated, the device ignores
+  VRING_AVAIL_F_NO_INTERRUPT, and interrupts the guest when its used index
+  steps over the "used_event" field instead. Keeping "used_event" just behind
+  the used index that the guest has consumed most recently means that the
+  device would have to get 64K elements ahead, which is impossible.
+
+  @param[in]     Dev       The VNET_DEV driver instance owning the ring.
+  @param[in,out] Ring      The virtio ring whose used ring elements are polled.
+  @param[in]     LastUsed  The used index that the guest has consumed most
+                           recently on Ring.
+*/
+VOID
+EFIAPI
+VirtioNetSuppressUsedEvent (
+  IN     VNET_DEV  *Dev,
+  IN OUT VRING     *Ring,
+  IN     UINT16    LastUsed
+  )
+{
+  if (Dev->EventIdx) {
+    *Ring->Avail.UsedEvent = (UINT16)(LastUsed - 1);
+  }
+}
+
 /**
   Map Caller-supplied TxBuf buffer to the device-mapped address
 
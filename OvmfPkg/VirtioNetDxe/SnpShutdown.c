@@ -57,6 +57,17 @@ VirtioNetShutdown (
       break;
   }
 
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "%a: Rx: %Lu frames %Lu kicks, Tx: %Lu frames %Lu kicks, EventIdx=%d\n",
+    __FUNCTION__,
+    Dev->Statistics.RxTotalFrames,
+    Dev->RxKicks,
+    Dev->Statistics.TxTotalFrames,
+    Dev->TxKicks,
+    Dev->EventIdx
+    ));
+
   Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, 0);
   VirtioNetShutdownRx (Dev);
   VirtioNetShutdownTx (Dev);
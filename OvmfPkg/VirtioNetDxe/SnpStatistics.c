@@ -0,0 +1,199 @@
+/** @file
+
+  Implementation of the SNP.Statistics() function and its private helpers if
+  any.
+
+  Copyright (C) 2013, Red Hat, Inc.
+  Copyright (c) 2006 - 2010, Intel Corporation. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include "VirtioNet.h"
+
+STATIC CONST UINT8  mBroadcastMac[SIZE_OF_VNET (Mac)] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+/**
+  Reset the statistics of a virtio-net driver instance.
+
+  The UEFI specification mandates that a statistics counter that the network
+  interface doesn't maintain be reported with all bits set. The driver counts
+  the frames and bytes that pass through VirtioNetReceive() and
+  VirtioNetTransmit(); everything else would need device support.
+
+  This function may only be called by VirtioNetSnpPopulate() and
+  VirtioNetStatistics().
+
+  @param[in,out] Dev  The VNET_DEV driver instance whose statistics should be
+                      reset.
+*/
+VOID
+EFIAPI
+VirtioNetResetStatistics (
+  IN OUT VNET_DEV  *Dev
+  )
+{
+  SetMem (&Dev->Statistics, sizeof Dev->Statistics, 0xFF);
+
+  Dev->Statistics.RxTotalFrames     = 0;
+  Dev->Statistics.RxGoodFrames      = 0;
+  Dev->Statistics.RxUndersizeFrames = 0;
+  Dev->Statistics.RxUnicastFrames   = 0;
+  Dev->Statistics.RxBroadcastFrames = 0;
+  Dev->Statistics.RxMulticastFrames = 0;
+  Dev->Statistics.RxTotalBytes      = 0;
+
+  Dev->Statistics.TxTotalFrames     = 0;
+  Dev->Statistics.TxGoodFrames      = 0;
+  Dev->Statistics.TxUnicastFrames   = 0;
+  Dev->Statistics.TxBroadcastFrames = 0;
+  Dev->Statistics.TxMulticastFrames = 0;
+  Dev->Statistics.TxTotalBytes      = 0;
+  Dev->Statistics.TxErrorFrames     = 0;
+}
+
+/**
+  Account for a frame that has been successfully received by, or queued for
+  transmission with, the virtio-net driver instance.
+
+  @param[in,out] Dev        The VNET_DEV driver instance that has handled the
+                            frame.
+  @param[in]     Transmit   TRUE if the frame has been queued for transmission,
+                            FALSE if it has been received.
+  @param[in]     Frame      The frame, starting with the media header.
+  @param[in]     FrameSize  The size of the frame in bytes, including the media
+                            header. The caller is responsible for ensuring that
+                            FrameSize is at least Dev->Snm.MediaHeaderSize.
+*/
+VOID
+EFIAPI
+VirtioNetCountFrame (
+  IN OUT VNET_DEV     *Dev,
+  IN     BOOLEAN      Transmit,
+  IN     CONST UINT8  *Frame,
+  IN     UINTN        FrameSize
+  )
+{
+  UINT64  *CastFrames;
+
+  //
+  // The destination MAC address is the first field of the media header. The
+  // group bit is the least significant bit of its first octet.
+  //
+  if (CompareMem (Frame, mBroadcastMac, sizeof mBroadcastMac) == 0) {
+    CastFrames = Transmit ? &Dev->Statistics.TxBroadcastFrames :
+                 &Dev->Statistics.RxBroadcastFrames;
+  } else if ((Frame[0] & BIT0) != 0) {
+    CastFrames = Transmit ? &Dev->Statistics.TxMulticastFrames :
+                 &Dev->Statistics.RxMulticastFrames;
+  } else {
+    CastFrames = Transmit ? &Dev->Statistics.TxUnicastFrames :
+                 &Dev->Statistics.RxUnicastFrames;
+  }
+
+  ++*CastFrames;
+
+  if (Transmit) {
+    ++Dev->Statistics.TxTotalFrames;
+    ++Dev->Statistics.TxGoodFrames;
+    Dev->Statistics.TxTotalBytes += FrameSize;
+  } else {
+    ++Dev->Statistics.RxTotalFrames;
+    ++Dev->Statistics.RxGoodFrames;
+    Dev->Statistics.RxTotalBytes += FrameSize;
+  }
+}
+
+/**
+  Resets or collects the statistics on a network interface.
+
+  @param  This            Protocol instance pointer.
+  @param  Reset           Set to TRUE to reset the statistics for the network
+                          interface.
+  @param  StatisticsSize  On input the size, in bytes, of StatisticsTable. On
+                          output the size, in bytes, of the resulting table of
+                          statistics.
+  @param  StatisticsTable A pointer to the EFI_NETWORK_STATISTICS structure
+                          that contains the statistics.
+
+  @retval EFI_SUCCESS           The statistics were collected from the network
+                                interface.
+  @retval EFI_NOT_STARTED       The network interface has not been started.
+  @retval EFI_BUFFER_TOO_SMALL  The Statistics buffer was too small. The
+                                current buffer size needed to hold the
+                                statistics is returned in StatisticsSize.
+  @retval EFI_INVALID_PARAMETER One or more of the parameters has an
+                                unsupported value.
+  @retval EFI_DEVICE_ERROR      The command could not be sent to the network
+                                interface.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioNetStatistics (
+  IN EFI_SIMPLE_NETWORK_PROTOCOL  *This,
+  IN BOOLEAN                      Reset,
+  IN OUT UINTN                    *StatisticsSize   OPTIONAL,
+  OUT EFI_NETWORK_STATISTICS      *StatisticsTable  OPTIONAL
+  )
+{
+  VNET_DEV    *Dev;
+  EFI_TPL     OldTpl;
+  EFI_STATUS  Status;
+
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Dev    = VIRTIO_NET_FROM_SNP (This);
+  OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
+  switch (Dev->Snm.State) {
+    case EfiSimpleNetworkStopped:
+      Status = EFI_NOT_STARTED;
+      goto Exit;
+    case EfiSimpleNetworkStarted:
+      Status = EFI_DEVICE_ERROR;
+      goto Exit;
+    default:
+      break;
+  }
+
+  if (StatisticsSize == NULL) {
+    if (StatisticsTable != NULL) {
+      Status = EFI_INVALID_PARAMETER;
+      goto Exit;
+    }
+  } else {
+    if ((StatisticsTable == NULL) ||
+        (*StatisticsSize < sizeof (EFI_NETWORK_STATISTICS)))
+    {
+      *StatisticsSize = sizeof (EFI_NETWORK_STATISTICS);
+      Status          = EFI_BUFFER_TOO_SMALL;
+      goto Exit;
+    }
+
+    CopyMem (
+      StatisticsTable,
+      &Dev->Statistics,
+      sizeof (EFI_NETWORK_STATISTICS)
+      );
+    *StatisticsSize = sizeof (EFI_NETWORK_STATISTICS);
+  }
+
+  if (Reset) {
+    VirtioNetResetStatistics (Dev);
+  }
+
+  Status = EFI_SUCCESS;
+
+Exit:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
@@ -71,6 +71,7 @@ VirtioNetTransmit (
   EFI_STATUS            Status;
   UINT16                DescIdx;
   UINT16                AvailIdx;
+  UINT16                OldAvailIdx;
   EFI_PHYSICAL_ADDRESS  DeviceAddress;
 
   if ((This == NULL) || (BufferSize == 0) || (Buffer == NULL)) {
@@ -152,6 +153,8 @@ VirtioNetTransmit (
              &DeviceAddress
              );
   if (EFI_ERROR (Status)) {
+    ++Dev->Statistics.TxTotalFrames;
+    ++Dev->Statistics.TxErrorFrames;
     Status = EFI_DEVICE_ERROR;
     goto Exit;
   }
@@ -167,14 +170,25 @@ VirtioNetTransmit (
   // the available index is never written by the host, we can read it back
   // without a barrier
   //
-  AvailIdx                                                   = *Dev->TxRing.Avail.Idx;
+  OldAvailIdx                                                = *Dev->TxRing.Avail.Idx;
+  AvailIdx                                                   = OldAvailIdx;
   Dev->TxRing.Avail.Ring[AvailIdx++ % Dev->TxRing.QueueSize] = DescIdx;
 
   MemoryFence ();
   *Dev->TxRing.Avail.Idx = AvailIdx;
 
+  VirtioNetCountFrame (Dev, TRUE, Buffer, BufferSize);
+
+  //
+  // The device needs no notification while it is still working through the
+  // TX queue; it is going to find this packet too. This way, the packets of a
+  // burst are batched behind a single notification.
+  //
   MemoryFence ();
-  Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_TX);
+  if (VirtioRingNotifyNeeded (&Dev->TxRing, Dev->EventIdx, OldAvailIdx)) {
+    ++Dev->TxKicks;
+    Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_TX);
+  }
 
 Exit:
   gBS->RestoreTPL (OldTpl);
@@ -25,7 +25,8 @@
 #define VNET_SIG  SIGNATURE_32 ('V', 'N', 'E', 'T')
 
 //
-// maximum number of pending packets, separately for each direction
+// maximum number of pending TX packets; the number of pending RX packets is
+// limited by PcdVirtioNetRxMaxPending
 //
 #define VNET_MAX_PENDING  64
 
@@ -76,6 +77,8 @@ typedef struct {
   EFI_EVENT                      ExitBoot;       // VirtioNetSnpPopulate
   EFI_DEVICE_PATH_PROTOCOL       *MacDevicePath; // VirtioNetDriverBindingStart
   EFI_HANDLE                     MacHandle;      // VirtioNetDriverBindingStart
+  EFI_NETWORK_STATISTICS         Statistics;     // VirtioNetSnpPopulate
+  BOOLEAN                        EventIdx;       // VirtioNetInitialize
 
   VRING                          RxRing;          // VirtioNetInitRing
   VOID                           *RxRingMap;      // VirtioRingMap and
@@ -85,6 +88,7 @@ typedef struct {
   UINTN                          RxBufNrPages;    // VirtioNetInitRx
   EFI_PHYSICAL_ADDRESS           RxBufDeviceBase; // VirtioNetInitRx
   VOID                           *RxBufMap;       // VirtioNetInitRx
+  UINT64                         RxKicks;         // VirtioNetInitRx
 
   VRING                          TxRing;           // VirtioNetInitRing
   VOID                           *TxRingMap;       // VirtioRingMap and
@@ -96,6 +100,7 @@ typedef struct {
   VOID                           *TxSharedReqMap;  // VirtioNetInitTx
   UINT16                         TxLastUsed;       // VirtioNetInitTx
   ORDERED_COLLECTION             *TxBufCollection; // VirtioNetInitTx
+  UINT64                         TxKicks;          // VirtioNetInitTx
 } VNET_DEV;
 
 //
@@ -275,6 +280,29 @@ VirtioNetUninitRing (
   IN     VOID      *RingMap
   );
 
+VOID
+EFIAPI
+VirtioNetSuppressUsedEvent (
+  IN     VNET_DEV  *Dev,
+  IN OUT VRING     *Ring,
+  IN     UINT16    LastUsed
+  );
+
+VOID
+EFIAPI
+VirtioNetResetStatistics (
+  IN OUT VNET_DEV  *Dev
+  );
+
+VOID
+EFIAPI
+VirtioNetCountFrame (
+  IN OUT VNET_DEV     *Dev,
+  IN     BOOLEAN      Transmit,
+  IN     CONST UINT8  *Frame,
+  IN     UINTN        FrameSize
+  );
+
 //
 // utility functions to map caller-supplied Tx buffer system physical address
 // to a device address and vice versa
@@ -254,7 +254,66 @@ IsAttributesAndMaskValidForNonPresentEntry (
 }
 
 /**
-  Update page table to map [LinearAddress, LinearAddress + Length) with specified attribute in the specified level.
+  Check if the ranges map [RegionStart, RegionStart + RegionLength) as a single range.
+
+  The ranges map the region as a single range when they cover the region, are adjacent to
+  each other, have the same attributes, and are mapped to contiguous physical addresses
+  when the physical address is set.
+
+  @param[in] Map           The ranges that overlap the region.
+  @param[in] MapCount      The number of the ranges.
+  @param[in] Mask          The mask used for attribute. The corresponding field in Attribute is ignored if that in Mask is 0.
+  @param[in] RegionStart   The start of the region.
+  @param[in] RegionLength  The length of the region.
+
+  @retval TRUE   The ranges map the region as a single range.
+  @retval FALSE  The ranges don't map the region as a single range.
+**/
+BOOLEAN
+PageTableLibIsSingleRange (
+  IN IA32_MAP_ENTRY      *Map,
+  IN UINTN               MapCount,
+  IN IA32_MAP_ATTRIBUTE  *Mask,
+  IN UINT64              RegionStart,
+  IN UINT64              RegionLength
+  )
+{
+  UINTN  Index;
+
+  if ((Map[0].LinearAddress > RegionStart) ||
+      (Map[MapCount - 1].LinearAddress + Map[MapCount - 1].Length < RegionStart + RegionLength))
+  {
+    return FALSE;
+  }
+
+  for (Index = 1; Index < MapCount; Index++) {
+    if (Map[Index].LinearAddress != Map[Index - 1].LinearAddress + Map[Index - 1].Length) {
+      return FALSE;
+    }
+
+    if ((IA32_MAP_ATTRIBUTE_ATTRIBUTES (&Map[Index].Attribute) & IA32_MAP_ATTRIBUTE_ATTRIBUTES (Mask))
+        != (IA32_MAP_ATTRIBUTE_ATTRIBUTES (&Map[0].Attribute) & IA32_MAP_ATTRIBUTE_ATTRIBUTES (Mask)))
+    {
+      return FALSE;
+    }
+
+    if (((Mask->Bits.PageTableBaseAddressLow != 0) || (Mask->Bits.PageTableBaseAddressHigh != 0)) &&
+        (IA32_MAP_ATTRIBUTE_PAGE_TABLE_BASE_ADDRESS (&Map[Index].Attribute) !=
+         IA32_MAP_ATTRIBUTE_PAGE_TABLE_BASE_ADDRESS (&Map[Index - 1].Attribute) + Map[Index - 1].Length))
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Update page table to map the linear address ranges with specified attributes in the specified level.
+
+  All the ranges that overlap the region mapped by ParentPagingEntry are handled in one call, so each
+  paging entry is split at most once, and the adjacent ranges with the same attributes can be mapped by
+  a single entry.
 
   @param[in]      ParentPagingEntry The pointer to the page table entry to update.
   @param[in]      ParentAttribute   The accumulated attribute of all parents' attribute.
@@ -266,13 +325,13 @@ IsAttributesAndMaskValidForNonPresentEntry (
                                     Return the remaining buffer size.
   @param[in]      Level             Page table level. Could be 5, 4, 3, 2, or 1.
   @param[in]      MaxLeafLevel      Maximum level that can be a leaf entry. Could be 1, 2 or 3 (if Page 1G is supported).
-  @param[in]      LinearAddress     The start of the linear address range.
-  @param[in]      Length            The length of the linear address range.
-  @param[in]      Offset            The offset within the linear address range.
-  @param[in]      Attribute         The attribute of the linear address range.
+  @param[in]      Map               The linear address ranges and their attributes, sorted by the linear address.
+                                    All of them overlap the region mapped by ParentPagingEntry.
                                     All non-reserved fields in IA32_MAP_ATTRIBUTE are supported to set in the page table.
-                                    Page table entries that map the linear address range are reset to 0 before set to the new attribute
+                                    Page table entries that map the linear address ranges are reset to 0 before set to the new attribute
                                     when a new physical base address is set.
+  @param[in]      MapCount          The number of the ranges in Map.
+  @param[in]      LinearAddress     The start of the linear address range to map in the region mapped by ParentPagingEntry.
   @param[in]      Mask              The mask used for attribute. The corresponding field in Attribute is ignored if that in Mask is 0.
   @param[out]     IsModified        TRUE means page table is modified. FALSE means page table is not modified.
 
@@ -289,10 +348,9 @@ PageTableLibMapInLevel (
   IN OUT INTN                *BufferSize,
   IN     IA32_PAGE_LEVEL     Level,
   IN     IA32_PAGE_LEVEL     MaxLeafLevel,
+  IN     IA32_MAP_ENTRY      *Map,
+  IN     UINTN               MapCount,
   IN     UINT64              LinearAddress,
-  IN     UINT64              Length,
-  IN     UINT64              Offset,
-  IN     IA32_MAP_ATTRIBUTE  *Attribute,
   IN     IA32_MAP_ATTRIBUTE  *Mask,
   OUT    BOOLEAN             *IsModified
   )
@@ -302,13 +360,17 @@ PageTableLibMapInLevel (
   UINTN               Index;
   IA32_PAGING_ENTRY   *PagingEntry;
   UINTN               PagingEntryIndex;
-  UINTN               PagingEntryIndexEnd;
   IA32_PAGING_ENTRY   *CurrentPagingEntry;
   UINT64              RegionLength;
-  UINT64              SubLength;
   UINT64              SubOffset;
   UINT64              RegionMask;
   UINT64              RegionStart;
+  UINT64              End;
+  UINT64              RangeStart;
+  UINT64              RangeEnd;
+  UINTN               MapIndex;
+  UINTN               SubMapCount;
+  IA32_MAP_ATTRIBUTE  *Attribute;
   IA32_MAP_ATTRIBUTE  AllOneMask;
   IA32_MAP_ATTRIBUTE  PleBAttribute;
   IA32_MAP_ATTRIBUTE  NopAttribute;
@@ -324,7 +386,7 @@ PageTableLibMapInLevel (
   IA32_PAGING_ENTRY   OriginalCurrentPagingEntry;
 
   ASSERT (Level != 0);
-  ASSERT ((Attribute != NULL) && (Mask != NULL));
+  ASSERT ((Map != NULL) && (MapCount != 0) && (Mask != NULL));
 
   CreateNew         = FALSE;
   AllOneMask.Uint64 = ~0ull;
@@ -343,10 +405,16 @@ PageTableLibMapInLevel (
   // RegionLength: 256T (1 << 48) 512G (1 << 39), 1G (1 << 30), 2M (1 << 21) or 4K (1 << 12).
   //
   BitStart         = 12 + (Level - 1) * 9;
-  PagingEntryIndex = (UINTN)BitFieldRead64 (LinearAddress + Offset, BitStart, BitStart + 9 - 1);
+  PagingEntryIndex = (UINTN)BitFieldRead64 (LinearAddress, BitStart, BitStart + 9 - 1);
   RegionLength     = REGION_LENGTH (Level);
   RegionMask       = RegionLength - 1;
 
+  //
+  // End: the end of the linear address range to map in the region mapped by ParentPagingEntry.
+  //
+  End = (LinearAddress & ~(REGION_LENGTH (Level + 1) - 1)) + REGION_LENGTH (Level + 1);
+  End = MIN (End, Map[MapCount - 1].LinearAddress + Map[MapCount - 1].Length);
+
   //
   // ParentPagingEntry ONLY is deferenced for checking Present and MustBeOne bits
   // when Modify is FALSE.
@@ -361,11 +429,13 @@ PageTableLibMapInLevel (
     PleBAttribute.Uint64 = PageTableLibGetPleBMapAttribute (&ParentPagingEntry->PleB, ParentAttribute);
     if (ParentPagingEntry->Pce.Present == 0) {
       //
-      // [LinearAddress, LinearAddress + Length] contains non-present range.
+      // The linear address ranges contain non-present range.
       //
-      Status = IsAttributesAndMaskValidForNonPresentEntry (Attribute, Mask);
-      if (RETURN_ERROR (Status)) {
-        return Status;
+      for (MapIndex = 0; MapIndex < MapCount; MapIndex++) {
+        Status = IsAttributesAndMaskValidForNonPresentEntry (&Map[MapIndex].Attribute, Mask);
+        if (RETURN_ERROR (Status)) {
+          return Status;
+        }
       }
 
       OneOfPagingEntry.Pnle.Uint64 = 0;
@@ -375,13 +445,17 @@ PageTableLibMapInLevel (
 
     //
     // Check if the attribute, the physical address calculated by ParentPagingEntry is equal to
-    // the attribute, the physical address calculated by input Attribue and Mask.
+    // the attribute, the physical address calculated by input Attribue and Mask of every range.
     //
-    if ((IA32_MAP_ATTRIBUTE_ATTRIBUTES (&PleBAttribute) & IA32_MAP_ATTRIBUTE_ATTRIBUTES (Mask))
-        == (IA32_MAP_ATTRIBUTE_ATTRIBUTES (Attribute) & IA32_MAP_ATTRIBUTE_ATTRIBUTES (Mask)))
-    {
+    for (MapIndex = 0; MapIndex < MapCount; MapIndex++) {
+      if ((IA32_MAP_ATTRIBUTE_ATTRIBUTES (&PleBAttribute) & IA32_MAP_ATTRIBUTE_ATTRIBUTES (Mask))
+          != (IA32_MAP_ATTRIBUTE_ATTRIBUTES (&Map[MapIndex].Attribute) & IA32_MAP_ATTRIBUTE_ATTRIBUTES (Mask)))
+      {
+        break;
+      }
+
       if ((Mask->Bits.PageTableBaseAddressLow == 0) && (Mask->Bits.PageTableBaseAddressHigh == 0)) {
-        return RETURN_SUCCESS;
+        continue;
       }
 
       //
@@ -390,13 +464,19 @@ PageTableLibMapInLevel (
       // 2.When still map non-present entry to non-present, PageTableBaseAddressLow and High in Mask must be 0.
       //
       ASSERT (ParentPagingEntry->Pce.Present == 1);
-      PhysicalAddrInEntry = IA32_MAP_ATTRIBUTE_PAGE_TABLE_BASE_ADDRESS (&PleBAttribute) + MultU64x32 (RegionLength, (UINT32)PagingEntryIndex);
-      PhysicalAddrInAttr  = (IA32_MAP_ATTRIBUTE_PAGE_TABLE_BASE_ADDRESS (Attribute) + Offset) & (~RegionMask);
-      if (PhysicalAddrInEntry == PhysicalAddrInAttr) {
-        return RETURN_SUCCESS;
+      RangeStart          = MAX (Map[MapIndex].LinearAddress, LinearAddress);
+      PhysicalAddrInEntry = IA32_MAP_ATTRIBUTE_PAGE_TABLE_BASE_ADDRESS (&PleBAttribute) +
+                            MultU64x32 (RegionLength, (UINT32)BitFieldRead64 (RangeStart, BitStart, BitStart + 9 - 1));
+      PhysicalAddrInAttr = (IA32_MAP_ATTRIBUTE_PAGE_TABLE_BASE_ADDRESS (&Map[MapIndex].Attribute) + RangeStart - Map[MapIndex].LinearAddress) & (~RegionMask);
+      if (PhysicalAddrInEntry != PhysicalAddrInAttr) {
+        break;
       }
     }
 
+    if (MapIndex == MapCount) {
+      return RETURN_SUCCESS;
+    }
+
     ASSERT (Buffer == NULL || *BufferSize >= SIZE_4KB);
     CreateNew    = TRUE;
     *BufferSize -= SIZE_4KB;
@@ -427,24 +507,25 @@ PageTableLibMapInLevel (
       ParentPagingEntry->Uint64 = ((UINTN)(VOID *)PagingEntry) | (ParentPagingEntry->Uint64 & (~IA32_PE_BASE_ADDRESS_MASK_40));
     }
   } else {
-    //
-    // If (LinearAddress + Length - 1) is not in the same ParentPagingEntry with (LinearAddress + Offset), then the remaining child PagingEntry
-    // starting from PagingEntryIndex of ParentPagingEntry is all covered by [LinearAddress + Offset, LinearAddress + Length - 1].
-    //
-    PagingEntryIndexEnd = (BitFieldRead64 (LinearAddress + Length - 1, BitStart + 9, 63) != BitFieldRead64 (LinearAddress + Offset, BitStart + 9, 63)) ? 511 :
-                          (UINTN)BitFieldRead64 (LinearAddress + Length - 1, BitStart, BitStart + 9 - 1);
     PagingEntry = (IA32_PAGING_ENTRY *)(UINTN)IA32_PNLE_PAGE_TABLE_BASE_ADDRESS (&ParentPagingEntry->Pnle);
-    for (Index = PagingEntryIndex; Index <= PagingEntryIndexEnd; Index++) {
-      if (PagingEntry[Index].Pce.Present == 0) {
-        //
-        // [LinearAddress, LinearAddress + Length] contains non-present range.
-        //
-        Status = IsAttributesAndMaskValidForNonPresentEntry (Attribute, Mask);
-        if (RETURN_ERROR (Status)) {
-          return Status;
-        }
+    for (MapIndex = 0; MapIndex < MapCount; MapIndex++) {
+      RangeStart = MAX (Map[MapIndex].LinearAddress, LinearAddress);
+      RangeEnd   = MIN (Map[MapIndex].LinearAddress + Map[MapIndex].Length, End);
+      for (Index = (UINTN)BitFieldRead64 (RangeStart, BitStart, BitStart + 9 - 1);
+           Index <= (UINTN)BitFieldRead64 (RangeEnd - 1, BitStart, BitStart + 9 - 1);
+           Index++)
+      {
+        if (PagingEntry[Index].Pce.Present == 0) {
+          //
+          // The linear address range contains non-present range.
+          //
+          Status = IsAttributesAndMaskValidForNonPresentEntry (&Map[MapIndex].Attribute, Mask);
+          if (RETURN_ERROR (Status)) {
+            return Status;
+          }
 
-        break;
+          break;
+        }
       }
     }
 
@@ -462,31 +543,34 @@ PageTableLibMapInLevel (
     //            we need to change PDPTE[0].ReadWrite = 1 and let all PDE[0-255].ReadWrite = 0 in this step.
     //       when PDPTE[0].Nx = 1 but caller wants to map [0-2MB] as Nx = 0 (PDT[0].Nx = 0)
     //            we need to change PDPTE[0].Nx = 0 and let all PDE[0-255].Nx = 1 in this step.
-    if ((ParentPagingEntry->Pnle.Bits.ReadWrite == 0) && (Mask->Bits.ReadWrite == 1) && (Attribute->Bits.ReadWrite == 1)) {
-      if (Modify) {
-        ParentPagingEntry->Pnle.Bits.ReadWrite = 1;
+    for (MapIndex = 0; MapIndex < MapCount; MapIndex++) {
+      Attribute = &Map[MapIndex].Attribute;
+      if ((ParentPagingEntry->Pnle.Bits.ReadWrite == 0) && (Mask->Bits.ReadWrite == 1) && (Attribute->Bits.ReadWrite == 1)) {
+        if (Modify) {
+          ParentPagingEntry->Pnle.Bits.ReadWrite = 1;
+        }
+
+        ChildAttribute.Bits.ReadWrite = 0;
+        ChildMask.Bits.ReadWrite      = 1;
       }
 
-      ChildAttribute.Bits.ReadWrite = 0;
-      ChildMask.Bits.ReadWrite      = 1;
-    }
+      if ((ParentPagingEntry->Pnle.Bits.UserSupervisor == 0) && (Mask->Bits.UserSupervisor == 1) && (Attribute->Bits.UserSupervisor == 1)) {
+        if (Modify) {
+          ParentPagingEntry->Pnle.Bits.UserSupervisor = 1;
+        }
 
-    if ((ParentPagingEntry->Pnle.Bits.UserSupervisor == 0) && (Mask->Bits.UserSupervisor == 1) && (Attribute->Bits.UserSupervisor == 1)) {
-      if (Modify) {
-        ParentPagingEntry->Pnle.Bits.UserSupervisor = 1;
+        ChildAttribute.Bits.UserSupervisor = 0;
+        ChildMask.Bits.UserSupervisor      = 1;
       }
 
-      ChildAttribute.Bits.UserSupervisor = 0;
-      ChildMask.Bits.UserSupervisor      = 1;
-    }
+      if ((ParentPagingEntry->Pnle.Bits.Nx == 1) && (Mask->Bits.Nx == 1) && (Attribute->Bits.Nx == 0)) {
+        if (Modify) {
+          ParentPagingEntry->Pnle.Bits.Nx = 0;
+        }
 
-    if ((ParentPagingEntry->Pnle.Bits.Nx == 1) && (Mask->Bits.Nx == 1) && (Attribute->Bits.Nx == 0)) {
-      if (Modify) {
-        ParentPagingEntry->Pnle.Bits.Nx = 0;
+        ChildAttribute.Bits.Nx = 1;
+        ChildMask.Bits.Nx      = 1;
       }
-
-      ChildAttribute.Bits.Nx = 1;
-      ChildMask.Bits.Nx      = 1;
     }
 
     if (ChildMask.Uint64 != 0) {
@@ -511,23 +595,43 @@ PageTableLibMapInLevel (
   }
 
   //
-  // RegionStart:  points to the linear address that's aligned on RegionLength and lower than (LinearAddress + Offset).
+  // RegionStart:  points to the linear address that's aligned on RegionLength and lower than LinearAddress.
   //
   Index                   = PagingEntryIndex;
-  RegionStart             = (LinearAddress + Offset) & ~RegionMask;
+  RegionStart             = LinearAddress & ~RegionMask;
   ParentAttribute->Uint64 = PageTableLibGetPnleMapAttribute (&ParentPagingEntry->Pnle, ParentAttribute);
 
   //
   // Apply the attribute.
   //
   PagingEntry = (IA32_PAGING_ENTRY *)(UINTN)IA32_PNLE_PAGE_TABLE_BASE_ADDRESS (&ParentPagingEntry->Pnle);
-  while (Offset < Length && Index < 512) {
+  MapIndex    = 0;
+  while (RegionStart < End) {
+    //
+    // Find the ranges that overlap [RegionStart, RegionStart + RegionLength).
+    // Skip the region when it's in the gap between two ranges.
+    //
+    while (Map[MapIndex].LinearAddress + Map[MapIndex].Length <= RegionStart) {
+      MapIndex++;
+    }
+
+    if (Map[MapIndex].LinearAddress >= RegionStart + RegionLength) {
+      RegionStart += RegionLength;
+      Index++;
+      continue;
+    }
+
+    for (SubMapCount = 1; MapIndex + SubMapCount < MapCount; SubMapCount++) {
+      if (Map[MapIndex + SubMapCount].LinearAddress >= RegionStart + RegionLength) {
+        break;
+      }
+    }
+
+    Attribute          = &Map[MapIndex].Attribute;
     CurrentPagingEntry = (!Modify && CreateNew) ? &OneOfPagingEntry : &PagingEntry[Index];
-    SubLength          = MIN (Length - Offset, RegionStart + RegionLength - (LinearAddress + Offset));
     if ((Level <= MaxLeafLevel) &&
-        (((LinearAddress + Offset) & RegionMask) == 0) &&
-        (((IA32_MAP_ATTRIBUTE_PAGE_TABLE_BASE_ADDRESS (Attribute) + Offset) & RegionMask) == 0) &&
-        (SubLength == RegionLength) &&
+        PageTableLibIsSingleRange (&Map[MapIndex], SubMapCount, Mask, RegionStart, RegionLength) &&
+        (((IA32_MAP_ATTRIBUTE_PAGE_TABLE_BASE_ADDRESS (Attribute) + RegionStart - Map[MapIndex].LinearAddress) & RegionMask) == 0) &&
         ((CurrentPagingEntry->Pce.Present == 0) || IsPle (CurrentPagingEntry, Level))
         )
     {
@@ -567,7 +671,7 @@ PageTableLibMapInLevel (
         // Check if any leaf PagingEntry is modified.
         //
         OriginalCurrentPagingEntry.Uint64 = CurrentPagingEntry->Uint64;
-        PageTableLibSetPle (Level, CurrentPagingEntry, Offset, Attribute, &CurrentMask);
+        PageTableLibSetPle (Level, CurrentPagingEntry, RegionStart - Map[MapIndex].LinearAddress, Attribute, &CurrentMask);
 
         if (OriginalCurrentPagingEntry.Uint64 != CurrentPagingEntry->Uint64) {
           *IsModified = TRUE;
@@ -578,9 +682,9 @@ PageTableLibMapInLevel (
       // Recursively call to create page table.
       // There are 3 cases:
       //   a. Level cannot be a leaf entry which points to physical memory.
-      //   a. Level can be a leaf entry but (LinearAddress + Offset) is NOT aligned on the RegionStart.
-      //   b. Level can be a leaf entry and (LinearAddress + Offset) is aligned on RegionStart,
-      //      but the length is SMALLER than the RegionLength.
+      //   a. Level can be a leaf entry but the ranges don't map the entire region as a single range.
+      //   b. Level can be a leaf entry and the ranges map the entire region as a single range,
+      //      but the physical address is NOT aligned on the RegionLength.
       //
       Status = PageTableLibMapInLevel (
                  CurrentPagingEntry,
@@ -590,10 +694,9 @@ PageTableLibMapInLevel (
                  BufferSize,
                  Level - 1,
                  MaxLeafLevel,
-                 LinearAddress,
-                 Length,
-                 Offset,
-                 Attribute,
+                 &Map[MapIndex],
+                 SubMapCount,
+                 MAX (RegionStart, Map[MapIndex].LinearAddress),
                  Mask,
                  IsModified
                  );
@@ -602,7 +705,6 @@ PageTableLibMapInLevel (
       }
     }
 
-    Offset      += SubLength;
     RegionStart += RegionLength;
     Index++;
   }
@@ -619,7 +721,11 @@ PageTableLibMapInLevel (
 }
 
 /**
-  Create or update page table to map [LinearAddress, LinearAddress + Length) with specified attribute.
+  Create or update page table to map the linear address ranges with specified attributes.
+
+  All the ranges are mapped in one pass of the page table, so each paging entry is visited
+  at most once, the required buffer size is calculated for all the ranges at once, and the
+  adjacent ranges with the same attributes are mapped by the largest possible entries.
 
   @param[in, out] PageTable      The pointer to the page table to update, or pointer to NULL if a new page table is to be created.
   @param[in]      PagingMode     The paging mode.
@@ -628,17 +734,18 @@ PageTableLibMapInLevel (
                                  On return, the remaining buffer size.
                                  The free buffer is used from the end so caller can supply the same Buffer pointer with an updated
                                  BufferSize in the second call to this API.
-  @param[in]      LinearAddress  The start of the linear address range.
-  @param[in]      Length         The length of the linear address range.
-  @param[in]      Attribute      The attribute of the linear address range.
+  @param[in]      Map            The linear address ranges and their attributes.
+                                 The ranges should be sorted by the linear address and should not overlap.
                                  All non-reserved fields in IA32_MAP_ATTRIBUTE are supported to set in the page table.
-                                 Page table entries that map the linear address range are reset to 0 before set to the new attribute
+                                 Page table entries that map the linear address ranges are reset to 0 before set to the new attribute
                                  when a new physical base address is set.
-  @param[in]      Mask           The mask used for attribute. The corresponding field in Attribute is ignored if that in Mask is 0.
+  @param[in]      MapCount       The number of the ranges in Map.
+  @param[in]      Mask           The mask used for attribute of all the ranges. The corresponding field in Attribute is ignored if that in Mask is 0.
   @param[out]     IsModified     TRUE means page table is modified. FALSE means page table is not modified.
 
   @retval RETURN_UNSUPPORTED        PagingMode is not supported.
-  @retval RETURN_INVALID_PARAMETER  PageTable, BufferSize, Attribute or Mask is NULL.
+  @retval RETURN_INVALID_PARAMETER  PageTable, BufferSize, Map or Mask is NULL.
+  @retval RETURN_INVALID_PARAMETER  The ranges are not sorted, overlap, or one of them is empty.
   @retval RETURN_INVALID_PARAMETER  For non-present range, Mask->Bits.Present is 0 but some other attributes are provided.
   @retval RETURN_INVALID_PARAMETER  For non-present range, Mask->Bits.Present is 1, Attribute->Bits.Present is 1 but some other attributes are not provided.
   @retval RETURN_INVALID_PARAMETER  For non-present range, Mask->Bits.Present is 1, Attribute->Bits.Present is 0 but some other attributes are provided.
@@ -647,18 +754,17 @@ PageTableLibMapInLevel (
   @retval RETURN_BUFFER_TOO_SMALL   The buffer is too small for page table creation/updating.
                                     BufferSize is updated to indicate the expected buffer size.
                                     Caller may still get RETURN_BUFFER_TOO_SMALL with the new BufferSize.
-  @retval RETURN_SUCCESS            PageTable is created/updated successfully or the input Length is 0.
+  @retval RETURN_SUCCESS            PageTable is created/updated successfully or the input MapCount is 0.
 **/
 RETURN_STATUS
 EFIAPI
-PageTableMap (
+PageTableMapEntries (
   IN OUT UINTN               *PageTable  OPTIONAL,
   IN     PAGING_MODE         PagingMode,
   IN     VOID                *Buffer,
   IN OUT UINTN               *BufferSize,
-  IN     UINT64              LinearAddress,
-  IN     UINT64              Length,
-  IN     IA32_MAP_ATTRIBUTE  *Attribute,
+  IN     IA32_MAP_ENTRY      *Map,
+  IN     UINTN               MapCount,
   IN     IA32_MAP_ATTRIBUTE  *Mask,
   OUT    BOOLEAN             *IsModified   OPTIONAL
   )
@@ -675,7 +781,7 @@ PageTableMap (
   IA32_PAGING_ENTRY   *PagingEntry;
   UINT8               BufferInStack[SIZE_4KB - 1 + MAX_PAE_PDPTE_NUM * sizeof (IA32_PAGING_ENTRY)];
 
-  if (Length == 0) {
+  if (MapCount == 0) {
     return RETURN_SUCCESS;
   }
 
@@ -686,7 +792,7 @@ PageTableMap (
     return RETURN_UNSUPPORTED;
   }
 
-  if ((PageTable == NULL) || (BufferSize == NULL) || (Attribute == NULL) || (Mask == NULL)) {
+  if ((PageTable == NULL) || (BufferSize == NULL) || (Map == NULL) || (Mask == NULL)) {
     return RETURN_INVALID_PARAMETER;
   }
 
@@ -697,33 +803,46 @@ PageTableMap (
     return RETURN_INVALID_PARAMETER;
   }
 
-  if (((UINTN)LinearAddress % SIZE_4KB != 0) || ((UINTN)Length % SIZE_4KB != 0)) {
-    //
-    // LinearAddress and Length should be multiple of 4K.
-    //
-    return RETURN_INVALID_PARAMETER;
-  }
-
-  if ((*BufferSize != 0) && (Buffer == NULL)) {
-    return RETURN_INVALID_PARAMETER;
-  }
-
-  //
-  // If to map [LinearAddress, LinearAddress + Length] as non-present,
-  // all attributes except Present should not be provided.
-  //
-  if ((Attribute->Bits.Present == 0) && (Mask->Bits.Present == 1) && (Mask->Uint64 > 1)) {
-    return RETURN_INVALID_PARAMETER;
-  }
-
   MaxLeafLevel     = (IA32_PAGE_LEVEL)(UINT8)PagingMode;
   MaxLevel         = (IA32_PAGE_LEVEL)(UINT8)(PagingMode >> 8);
   MaxLinearAddress = (PagingMode == PagingPae) ? LShiftU64 (1, 32) : LShiftU64 (1, 12 + MaxLevel * 9);
 
-  if ((LinearAddress > MaxLinearAddress) || (Length > MaxLinearAddress - LinearAddress)) {
+  for (Index = 0; Index < MapCount; Index++) {
+    if (Map[Index].Length == 0) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    if (((UINTN)Map[Index].LinearAddress % SIZE_4KB != 0) || ((UINTN)Map[Index].Length % SIZE_4KB != 0)) {
+      //
+      // LinearAddress and Length should be multiple of 4K.
+      //
+      return RETURN_INVALID_PARAMETER;
+    }
+
     //
-    // Maximum linear address is (1 << 32), (1 << 48) or (1 << 57)
+    // If to map [LinearAddress, LinearAddress + Length] as non-present,
+    // all attributes except Present should not be provided.
     //
+    if ((Map[Index].Attribute.Bits.Present == 0) && (Mask->Bits.Present == 1) && (Mask->Uint64 > 1)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    if ((Map[Index].LinearAddress > MaxLinearAddress) || (Map[Index].Length > MaxLinearAddress - Map[Index].LinearAddress)) {
+      //
+      // Maximum linear address is (1 << 32), (1 << 48) or (1 << 57)
+      //
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    if ((Index != 0) && (Map[Index].LinearAddress < Map[Index - 1].LinearAddress + Map[Index - 1].Length)) {
+      //
+      // The ranges should be sorted and should not overlap.
+      //
+      return RETURN_INVALID_PARAMETER;
+    }
+  }
+
+  if ((*BufferSize != 0) && (Buffer == NULL)) {
     return RETURN_INVALID_PARAMETER;
   }
 
@@ -775,10 +894,9 @@ PageTableMap (
                    &RequiredSize,
                    MaxLevel,
                    MaxLeafLevel,
-                   LinearAddress,
-                   Length,
-                   0,
-                   Attribute,
+                   Map,
+                   MapCount,
+                   Map[0].LinearAddress,
                    Mask,
                    IsModified
                    );
@@ -809,10 +927,9 @@ PageTableMap (
              (INTN *)BufferSize,
              MaxLevel,
              MaxLeafLevel,
-             LinearAddress,
-             Length,
-             0,
-             Attribute,
+             Map,
+             MapCount,
+             Map[0].LinearAddress,
              Mask,
              IsModified
              );
@@ -849,3 +966,72 @@ PageTableMap (
 
   return Status;
 }
+
+/**
+  Create or update page table to map [LinearAddress, LinearAddress + Length) with specified attribute.
+
+  @param[in, out] PageTable      The pointer to the page table to update, or pointer to NULL if a new page table is to be created.
+  @param[in]      PagingMode     The paging mode.
+  @param[in]      Buffer         The free buffer to be used for page table creation/updating.
+  @param[in, out] BufferSize     The buffer size.
+                                 On return, the remaining buffer size.
+                                 The free buffer is used from the end so caller can supply the same Buffer pointer with an updated
+                                 BufferSize in the second call to this API.
+  @param[in]      LinearAddress  The start of the linear address range.
+  @param[in]      Length         The length of the linear address range.
+  @param[in]      Attribute      The attribute of the linear address range.
+                                 All non-reserved fields in IA32_MAP_ATTRIBUTE are supported to set in the page table.
+                                 Page table entries that map the linear address range are reset to 0 before set to the new attribute
+                                 when a new physical base address is set.
+  @param[in]      Mask           The mask used for attribute. The corresponding field in Attribute is ignored if that in Mask is 0.
+  @param[out]     IsModified     TRUE means page table is modified. FALSE means page table is not modified.
+
+  @retval RETURN_UNSUPPORTED        PagingMode is not supported.
+  @retval RETURN_INVALID_PARAMETER  PageTable, BufferSize, Attribute or Mask is NULL.
+  @retval RETURN_INVALID_PARAMETER  For non-present range, Mask->Bits.Present is 0 but some other attributes are provided.
+  @retval RETURN_INVALID_PARAMETER  For non-present range, Mask->Bits.Present is 1, Attribute->Bits.Present is 1 but some other attributes are not provided.
+  @retval RETURN_INVALID_PARAMETER  For non-present range, Mask->Bits.Present is 1, Attribute->Bits.Present is 0 but some other attributes are provided.
+  @retval RETURN_INVALID_PARAMETER  For present range, Mask->Bits.Present is 1, Attribute->Bits.Present is 0 but some other attributes are provided.
+  @retval RETURN_INVALID_PARAMETER  *BufferSize is not multiple of 4KB.
+  @retval RETURN_BUFFER_TOO_SMALL   The buffer is too small for page table creation/updating.
+                                    BufferSize is updated to indicate the expected buffer size.
+                                    Caller may still get RETURN_BUFFER_TOO_SMALL with the new BufferSize.
+  @retval RETURN_SUCCESS            PageTable is created/updated successfully or the input Length is 0.
+**/
+RETURN_STATUS
+EFIAPI
+PageTableMap (
+  IN OUT UINTN               *PageTable  OPTIONAL,
+  IN     PAGING_MODE         PagingMode,
+  IN     VOID                *Buffer,
+  IN OUT UINTN               *BufferSize,
+  IN     UINT64              LinearAddress,
+  IN     UINT64              Length,
+  IN     IA32_MAP_ATTRIBUTE  *Attribute,
+  IN     IA32_MAP_ATTRIBUTE  *Mask,
+  OUT    BOOLEAN             *IsModified   OPTIONAL
+  )
+{
+  IA32_MAP_ENTRY  Map;
+
+  if (Length == 0) {
+    return RETURN_SUCCESS;
+  }
+
+  Map.LinearAddress = LinearAddress;
+  Map.Length        = Length;
+  if (Attribute != NULL) {
+    Map.Attribute.Uint64 = Attribute->Uint64;
+  }
+
+  return PageTableMapEntries (
+           PageTable,
+           PagingMode,
+           Buffer,
+           BufferSize,
+           (Attribute == NULL) ? NULL : &Map,
+           1,
+           Mask,
+           IsModified
+           );
+}
@@ -78,6 +78,27 @@ TestCaseforRandomTest (
   IN UNIT_TEST_CONTEXT  Context
   );
 
+/**
+  Random Test for PageTableMapEntries
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+TestCaseforMapEntriesRandomTest (
+  IN UNIT_TEST_CONTEXT  Context
+  );
+
 /**
   Init global data
 
@@ -886,6 +886,11 @@ UefiTestMain (
   AddTestCase (RandomTestCase, "Random Test for Paging5Level", "Random Test Case3", TestCaseforRandomTest, NULL, NULL, &mTestContextPaging5Level);
   AddTestCase (RandomTestCase, "Random Test for Paging5Level1G", "Random Test Case4", TestCaseforRandomTest, NULL, NULL, &mTestContextPaging5Level1GB);
   AddTestCase (RandomTestCase, "Random Test for PagingPae", "Random Test Case5", TestCaseforRandomTest, NULL, NULL, &mTestContextPagingPae);
+  AddTestCase (RandomTestCase, "Random Test of PageTableMapEntries for Paging4Level", "Random Test Case6", TestCaseforMapEntriesRandomTest, NULL, NULL, &mTestContextPaging4Level);
+  AddTestCase (RandomTestCase, "Random Test of PageTableMapEntries for Paging4Level1G", "Random Test Case7", TestCaseforMapEntriesRandomTest, NULL, NULL, &mTestContextPaging4Level1GB);
+  AddTestCase (RandomTestCase, "Random Test of PageTableMapEntries for Paging5Level", "Random Test Case8", TestCaseforMapEntriesRandomTest, NULL, NULL, &mTestContextPaging5Level);
+  AddTestCase (RandomTestCase, "Random Test of PageTableMapEntries for Paging5Level1G", "Random Test Case9", TestCaseforMapEntriesRandomTest, NULL, NULL, &mTestContextPaging5Level1GB);
+  AddTestCase (RandomTestCase, "Random Test of PageTableMapEntries for PagingPae", "Random Test Case10", TestCaseforMapEntriesRandomTest, NULL, NULL, &mTestContextPagingPae);
 
   //
   // Execute the tests.
@@ -999,6 +999,33 @@ MultipleMapEntryTest (
   return UNIT_TEST_PASSED;
 }
 
+/**
+  Init the global data used by the random tests.
+
+  @param[in]  Context    Pointer to CPU_PAGE_TABLE_LIB_RANDOM_TEST_CONTEXT.
+**/
+VOID
+InitRandomTestGlobalData (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mSupportedBit.Uint64              = 0;
+  mSupportedBit.Bits.Present        = 1;
+  mSupportedBit.Bits.ReadWrite      = 1;
+  mSupportedBit.Bits.UserSupervisor = 1;
+  mSupportedBit.Bits.WriteThrough   = 1;
+  mSupportedBit.Bits.CacheDisabled  = 1;
+  mSupportedBit.Bits.Accessed       = 1;
+  mSupportedBit.Bits.Dirty          = 1;
+  mSupportedBit.Bits.Pat            = 1;
+  mSupportedBit.Bits.Global         = 1;
+  mSupportedBit.Bits.ProtectionKey  = 0xF;
+  mSupportedBit.Bits.Nx             = 1;
+
+  mRandomOption = ((CPU_PAGE_TABLE_LIB_RANDOM_TEST_CONTEXT *)Context)->RandomOption;
+  mNumberIndex  = 0;
+}
+
 /**
   Random Test
 
@@ -1028,21 +1055,7 @@ TestCaseforRandomTest (
   UT_ASSERT_EQUAL (Random64 (100, 100), 100);
   UT_ASSERT_TRUE ((Random32 (9, 10) >= 9) & (Random32 (9, 10) <= 10));
   UT_ASSERT_TRUE ((Random64 (9, 10) >= 9) & (Random64 (9, 10) <= 10));
-  mSupportedBit.Uint64              = 0;
-  mSupportedBit.Bits.Present        = 1;
-  mSupportedBit.Bits.ReadWrite      = 1;
-  mSupportedBit.Bits.UserSupervisor = 1;
-  mSupportedBit.Bits.WriteThrough   = 1;
-  mSupportedBit.Bits.CacheDisabled  = 1;
-  mSupportedBit.Bits.Accessed       = 1;
-  mSupportedBit.Bits.Dirty          = 1;
-  mSupportedBit.Bits.Pat            = 1;
-  mSupportedBit.Bits.Global         = 1;
-  mSupportedBit.Bits.ProtectionKey  = 0xF;
-  mSupportedBit.Bits.Nx             = 1;
-
-  mRandomOption = ((CPU_PAGE_TABLE_LIB_RANDOM_TEST_CONTEXT *)Context)->RandomOption;
-  mNumberIndex  = 0;
+  InitRandomTestGlobalData (Context);
 
   for (Index = 0; Index < ((CPU_PAGE_TABLE_LIB_RANDOM_TEST_CONTEXT *)Context)->TestCount; Index++) {
     Status = MultipleMapEntryTest (
@@ -1060,3 +1073,365 @@ TestCaseforRandomTest (
 
   return UNIT_TEST_PASSED;
 }
+
+/**
+  Map the ranges into a page table, either one by one by PageTableMap, or all at once by PageTableMapEntries.
+
+  @param[in]      PagingMode  The paging mode.
+  @param[in]      Map         The sorted and non-overlapping ranges to map.
+  @param[in]      MapCount    The number of the ranges.
+  @param[in]      Mask        The mask used for attribute of all the ranges.
+  @param[in]      OneByOne    TRUE to map the ranges one by one by PageTableMap.
+  @param[in, out] PageTable   The page table to map the ranges into, 0 to create a new page table.
+  @param[in, out] TotalSize   Increased by the buffer size used by the mapping.
+  @param[in, out] Buffers     The buffers used by the page table, the buffers used by the mapping are appended.
+  @param[in, out] BufferCount The number of the buffers.
+
+  @retval  UNIT_TEST_PASSED        The ranges are mapped successfully.
+**/
+UNIT_TEST_STATUS
+MapEntriesToPageTable (
+  IN     PAGING_MODE           PagingMode,
+  IN     IA32_MAP_ENTRY        *Map,
+  IN     UINTN                 MapCount,
+  IN     IA32_MAP_ATTRIBUTE    *Mask,
+  IN     BOOLEAN               OneByOne,
+  IN OUT UINTN                 *PageTable,
+  IN OUT UINTN                 *TotalSize,
+  IN OUT ALLOCATE_PAGE_RECORD  *Buffers,
+  IN OUT UINTN                 *BufferCount
+  )
+{
+  RETURN_STATUS  Status;
+  UINTN          Index;
+  UINTN          Count;
+  UINTN          BufferSize;
+  VOID           *Buffer;
+
+  Count = OneByOne ? MapCount : 1;
+  for (Index = 0; Index < Count; Index++) {
+    BufferSize = 0;
+    if (OneByOne) {
+      Status = PageTableMap (PageTable, PagingMode, NULL, &BufferSize, Map[Index].LinearAddress, Map[Index].Length, &Map[Index].Attribute, Mask, NULL);
+    } else {
+      Status = PageTableMapEntries (PageTable, PagingMode, NULL, &BufferSize, Map, MapCount, Mask, NULL);
+    }
+
+    if (BufferSize != 0) {
+      UT_ASSERT_EQUAL (Status, RETURN_BUFFER_TOO_SMALL);
+      Buffer = AllocatePages (EFI_SIZE_TO_PAGES (BufferSize));
+      UT_ASSERT_NOT_EQUAL (Buffer, NULL);
+      Buffers[*BufferCount].Buffer = Buffer;
+      Buffers[*BufferCount].Pages  = EFI_SIZE_TO_PAGES (BufferSize);
+      *BufferCount                += 1;
+      *TotalSize                  += BufferSize;
+      if (OneByOne) {
+        Status = PageTableMap (PageTable, PagingMode, Buffer, &BufferSize, Map[Index].LinearAddress, Map[Index].Length, &Map[Index].Attribute, Mask, NULL);
+      } else {
+        Status = PageTableMapEntries (PageTable, PagingMode, Buffer, &BufferSize, Map, MapCount, Mask, NULL);
+      }
+
+      //
+      // The required buffer size should be exact.
+      //
+      UT_ASSERT_EQUAL (BufferSize, 0);
+    }
+
+    UT_ASSERT_EQUAL (Status, RETURN_SUCCESS);
+  }
+
+  return IsPageTableValid (*PageTable, PagingMode);
+}
+
+/**
+  Parse the page table to a newly allocated map.
+
+  @param[in]  PageTable   The page table.
+  @param[in]  PagingMode  The paging mode.
+  @param[out] Map         Return the newly allocated map.
+  @param[out] MapCount    Return the number of entries in Map.
+
+  @retval  UNIT_TEST_PASSED        The page table is parsed successfully.
+**/
+UNIT_TEST_STATUS
+ParsePageTableToNewMap (
+  IN  UINTN           PageTable,
+  IN  PAGING_MODE     PagingMode,
+  OUT IA32_MAP_ENTRY  **Map,
+  OUT UINTN           *MapCount
+  )
+{
+  RETURN_STATUS  Status;
+
+  *Map      = NULL;
+  *MapCount = 0;
+  Status    = PageTableParse (PageTable, PagingMode, NULL, MapCount);
+  if (*MapCount != 0) {
+    UT_ASSERT_EQUAL (Status, RETURN_BUFFER_TOO_SMALL);
+    *Map = AllocatePages (EFI_SIZE_TO_PAGES (*MapCount * sizeof (IA32_MAP_ENTRY)));
+    UT_ASSERT_NOT_EQUAL (*Map, NULL);
+    Status = PageTableParse (PageTable, PagingMode, *Map, MapCount);
+  }
+
+  UT_ASSERT_EQUAL (Status, RETURN_SUCCESS);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Generate random sorted and non-overlapping ranges.
+  Half of the ranges are adjacent to the former one so that they can be merged to bigger pages.
+
+  When the ranges already mapped in the page table are given, some of the new ranges keep the mapping of the
+  existing range they start in or continue, so that they can be merged with their existing neighbours.
+
+  @param[in]  PagingMode     The paging mode.
+  @param[in]  RangeCount     The maximum count of ranges.
+  @param[in]  Existing       The sorted ranges already mapped in the page table, or NULL.
+  @param[in]  ExistingCount  The count of the ranges already mapped.
+  @param[out] Map            Return the ranges.
+
+  @return The count of the ranges generated.
+**/
+UINTN
+GenerateRandomMapEntries (
+  IN  PAGING_MODE     PagingMode,
+  IN  UINTN           RangeCount,
+  IN  IA32_MAP_ENTRY  *Existing     OPTIONAL,
+  IN  UINTN           ExistingCount,
+  OUT IA32_MAP_ENTRY  *Map
+  )
+{
+  UINT64  MaxAddress;
+  UINT64  Address;
+  UINT64  Length;
+  UINTN   MapCount;
+  UINTN   Index;
+
+  MaxAddress = GetMaxAddress (PagingMode);
+  Address    = 0;
+  for (MapCount = 0; MapCount < RangeCount; MapCount++) {
+    if ((MapCount == 0) || RandomBoolean (50)) {
+      Address += Random64 (0, 4 * (UINT64)SIZE_1GB) & AlignedTable[Random32 (0, ARRAY_SIZE (AlignedTable) - 1)];
+    }
+
+    Length = Random64 (0, 2 * (UINT64)SIZE_1GB) & AlignedTable[Random32 (0, ARRAY_SIZE (AlignedTable) - 1)];
+    Length = MAX (Length, SIZE_4KB);
+    if ((Address >= MaxAddress) || (Length > MaxAddress - Address)) {
+      break;
+    }
+
+    //
+    // Find the existing range the new range starts in or continues.
+    //
+    for (Index = 0; Index < ExistingCount; Index++) {
+      if ((Existing[Index].LinearAddress <= Address) && (Address <= Existing[Index].LinearAddress + Existing[Index].Length)) {
+        break;
+      }
+    }
+
+    Map[MapCount].LinearAddress = Address;
+    Map[MapCount].Length        = Length;
+    if ((MapCount != 0) && (Map[MapCount - 1].LinearAddress + Map[MapCount - 1].Length == Address) && RandomBoolean (50)) {
+      //
+      // Continue the former range with the same attribute and the contiguous physical address.
+      //
+      Map[MapCount].Attribute.Uint64 = Map[MapCount - 1].Attribute.Uint64 + Map[MapCount - 1].Length;
+    } else if ((Index < ExistingCount) && RandomBoolean (50)) {
+      //
+      // Keep the attribute and the contiguous physical address of the existing range.
+      //
+      Map[MapCount].Attribute.Uint64 = Existing[Index].Attribute.Uint64 + (Address - Existing[Index].LinearAddress);
+    } else {
+      Map[MapCount].Attribute.Uint64 = Random64 (0, MAX_UINT64) & mSupportedBit.Uint64;
+      if (mRandomOption & ONLY_ONE_ONE_MAPPING) {
+        Map[MapCount].Attribute.Uint64 |= Address;
+      } else {
+        Map[MapCount].Attribute.Uint64 |= Random64 (0, (((UINT64)1)<<51) - 1) & AlignedTable[Random32 (0, ARRAY_SIZE (AlignedTable) - 1)];
+      }
+    }
+
+    //
+    // Mapping a non-present range with all attributes provided is not permitted.
+    //
+    Map[MapCount].Attribute.Bits.Present = 1;
+    Address                             += Length;
+  }
+
+  return MapCount;
+}
+
+/**
+  Generate random sorted and non-overlapping ranges, map them by PageTableMap one by one and by
+  PageTableMapEntries all at once, and check that the two page tables map the same ranges.
+
+  When the page tables are pre-populated, the same random ranges are first mapped into both of them, so that
+  the new ranges split large pages, change the attribute and the physical address across existing entries, and
+  merge with existing neighbours. Otherwise the ranges are mapped into new page tables, and PageTableMapEntries
+  shouldn't use more buffer.
+
+  @param[in]  RangeCount   The count of random ranges.
+  @param[in]  PagingMode   The paging mode.
+  @param[in]  Prepopulate  TRUE to map the ranges into pre-populated page tables.
+
+  @retval  UNIT_TEST_PASSED        The test is successful.
+**/
+UNIT_TEST_STATUS
+MapEntriesTest (
+  IN UINTN        RangeCount,
+  IN PAGING_MODE  PagingMode,
+  IN BOOLEAN      Prepopulate
+  )
+{
+  UNIT_TEST_STATUS      TestStatus;
+  RETURN_STATUS         Status;
+  IA32_MAP_ENTRY        *BaseMap;
+  UINTN                 BaseMapCount;
+  IA32_MAP_ENTRY        *Map;
+  UINTN                 MapCount;
+  IA32_MAP_ATTRIBUTE    Mask;
+  IA32_MAP_ENTRY        Swap;
+  UINTN                 PageTable[2];
+  UINTN                 TotalSize[2];
+  ALLOCATE_PAGE_RECORD  *Buffers[2];
+  UINTN                 BufferCount[2];
+  UINTN                 BufferRecordCount;
+  IA32_MAP_ENTRY        *ParsedMap[2];
+  UINTN                 ParsedMapCount[2];
+  UINTN                 BufferSize;
+  UINTN                 Index;
+  UINTN                 Index2;
+
+  Map = AllocatePages (EFI_SIZE_TO_PAGES (RangeCount * sizeof (IA32_MAP_ENTRY)));
+  ASSERT (Map != NULL);
+  Mask.Uint64 = MAX_UINT64;
+
+  BaseMap      = NULL;
+  BaseMapCount = 0;
+  if (Prepopulate) {
+    BaseMap = AllocatePages (EFI_SIZE_TO_PAGES (RangeCount * sizeof (IA32_MAP_ENTRY)));
+    ASSERT (BaseMap != NULL);
+    BaseMapCount = GenerateRandomMapEntries (PagingMode, RangeCount, NULL, 0, BaseMap);
+  }
+
+  MapCount          = GenerateRandomMapEntries (PagingMode, RangeCount, BaseMap, BaseMapCount, Map);
+  BufferRecordCount = BaseMapCount + MAX (MapCount, 1);
+
+  for (Index = 0; Index < 2; Index++) {
+    Buffers[Index] = AllocatePages (EFI_SIZE_TO_PAGES (BufferRecordCount * sizeof (ALLOCATE_PAGE_RECORD)));
+    ASSERT (Buffers[Index] != NULL);
+    PageTable[Index]   = 0;
+    TotalSize[Index]   = 0;
+    BufferCount[Index] = 0;
+    if (BaseMapCount != 0) {
+      TestStatus = MapEntriesToPageTable (PagingMode, BaseMap, BaseMapCount, &Mask, TRUE, &PageTable[Index], &TotalSize[Index], Buffers[Index], &BufferCount[Index]);
+      if (TestStatus != UNIT_TEST_PASSED) {
+        return TestStatus;
+      }
+    }
+
+    TestStatus = MapEntriesToPageTable (PagingMode, Map, MapCount, &Mask, (BOOLEAN)(Index == 0), &PageTable[Index], &TotalSize[Index], Buffers[Index], &BufferCount[Index]);
+    if (TestStatus != UNIT_TEST_PASSED) {
+      return TestStatus;
+    }
+
+    TestStatus = ParsePageTableToNewMap (PageTable[Index], PagingMode, &ParsedMap[Index], &ParsedMapCount[Index]);
+    if (TestStatus != UNIT_TEST_PASSED) {
+      return TestStatus;
+    }
+  }
+
+  //
+  // Both page tables should map the same ranges, and mapping all ranges at once into a new page table shouldn't
+  // use more buffer.
+  //
+  UT_ASSERT_EQUAL (ParsedMapCount[0], ParsedMapCount[1]);
+  UT_ASSERT_MEM_EQUAL (ParsedMap[0], ParsedMap[1], ParsedMapCount[0] * sizeof (IA32_MAP_ENTRY));
+  if (!Prepopulate) {
+    UT_ASSERT_TRUE (TotalSize[1] <= TotalSize[0]);
+  }
+
+  //
+  // The ranges should be sorted and should not overlap.
+  //
+  if (MapCount > 1) {
+    BufferSize = 0;
+    CopyMem (&Swap, &Map[0], sizeof (IA32_MAP_ENTRY));
+    CopyMem (&Map[0], &Map[1], sizeof (IA32_MAP_ENTRY));
+    CopyMem (&Map[1], &Swap, sizeof (IA32_MAP_ENTRY));
+    Status = PageTableMapEntries (&PageTable[1], PagingMode, NULL, &BufferSize, Map, MapCount, &Mask, NULL);
+    UT_ASSERT_EQUAL (Status, RETURN_INVALID_PARAMETER);
+  }
+
+  for (Index = 0; Index < 2; Index++) {
+    for (Index2 = 0; Index2 < BufferCount[Index]; Index2++) {
+      FreePages (Buffers[Index][Index2].Buffer, Buffers[Index][Index2].Pages);
+    }
+
+    FreePages (Buffers[Index], EFI_SIZE_TO_PAGES (BufferRecordCount * sizeof (ALLOCATE_PAGE_RECORD)));
+    if (ParsedMapCount[Index] != 0) {
+      FreePages (ParsedMap[Index], EFI_SIZE_TO_PAGES (ParsedMapCount[Index] * sizeof (IA32_MAP_ENTRY)));
+    }
+  }
+
+  if (BaseMap != NULL) {
+    FreePages (BaseMap, EFI_SIZE_TO_PAGES (RangeCount * sizeof (IA32_MAP_ENTRY)));
+  }
+
+  FreePages (Map, EFI_SIZE_TO_PAGES (RangeCount * sizeof (IA32_MAP_ENTRY)));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Random Test for PageTableMapEntries. Each round maps random ranges into new page tables, and then into
+  pre-populated page tables.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+TestCaseforMapEntriesRandomTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+  UINTN             Index;
+
+  UT_ASSERT_EQUAL (RandomSeed (NULL, 0), TRUE);
+  InitRandomTestGlobalData (Context);
+
+  for (Index = 0; Index < ((CPU_PAGE_TABLE_LIB_RANDOM_TEST_CONTEXT *)Context)->TestCount; Index++) {
+    Status = MapEntriesTest (
+               ((CPU_PAGE_TABLE_LIB_RANDOM_TEST_CONTEXT *)Context)->TestRangeCount,
+               ((CPU_PAGE_TABLE_LIB_RANDOM_TEST_CONTEXT *)Context)->PagingMode,
+               FALSE
+               );
+    if (Status != UNIT_TEST_PASSED) {
+      return Status;
+    }
+
+    Status = MapEntriesTest (
+               ((CPU_PAGE_TABLE_LIB_RANDOM_TEST_CONTEXT *)Context)->TestRangeCount,
+               ((CPU_PAGE_TABLE_LIB_RANDOM_TEST_CONTEXT *)Context)->PagingMode,
+               TRUE
+               );
+    if (Status != UNIT_TEST_PASSED) {
+      return Status;
+    }
+
+    DEBUG ((DEBUG_INFO, "."));
+  }
+
+  DEBUG ((DEBUG_INFO, "\n"));
+
+  return UNIT_TEST_PASSED;
+}
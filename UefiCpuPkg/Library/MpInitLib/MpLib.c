@@ -309,6 +309,7 @@ GetApLoopMode (
 {
   UINT8                    ApLoopMode;
   CPUID_MONITOR_MWAIT_EBX  MonitorMwaitEbx;
+  CPUID_VERSION_INFO_EBX   VersionInfoEbx;
 
   ASSERT (MonitorFilterSize != NULL);
 
@@ -334,7 +335,15 @@ GetApLoopMode (
     }
   }
 
-  if (ApLoopMode != ApInMwaitLoop) {
+  if (ApLoopMode == ApInRunLoop) {
+    //
+    // APs in Run-loop keep polling their start-up signal, so give each signal
+    // its own cache line to keep the BSP from bouncing a line shared by APs.
+    // CPUID.[EAX=01H]:EBX.BIT8-15: CLFLUSH line size in quadwords
+    //
+    AsmCpuid (CPUID_VERSION_INFO, NULL, &VersionInfoEbx.Uint32, NULL, NULL);
+    *MonitorFilterSize = MAX (sizeof (UINT32), VersionInfoEbx.Bits.CacheLineSize * 8);
+  } else if (ApLoopMode != ApInMwaitLoop) {
     *MonitorFilterSize = sizeof (UINT32);
   } else {
     //
@@ -418,6 +427,66 @@ SortApicId (
   }
 }
 
+/**
+  Group the APs by package for the hierarchical wakeup of the APs. The first AP
+  of each package leads the package: the BSP only wakes up the leaders, and
+  each leader wakes up the other APs of its package in parallel with the other
+  leaders.
+
+  @param[in] CpuMpData        Pointer to CPU MP Data
+**/
+VOID
+InitializePackageLeaders (
+  IN CPU_MP_DATA  *CpuMpData
+  )
+{
+  CPU_INFO_IN_HOB  *CpuInfoInHob;
+  CPU_AP_DATA      *CpuData;
+  UINT32           Index;
+  UINT32           Leader;
+  UINT32           LastLeader;
+
+  CpuMpData->FirstPackageLeader = MAX_UINT32;
+  for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
+    CpuData                    = &CpuMpData->CpuData[Index];
+    CpuData->NextPackageLeader = MAX_UINT32;
+    CpuData->NextInPackage     = MAX_UINT32;
+    CpuData->WakeUpPackage     = FALSE;
+  }
+
+  if (!PcdGetBool (PcdCpuApHierarchicalWakeup)) {
+    return;
+  }
+
+  CpuInfoInHob = (CPU_INFO_IN_HOB *)(UINTN)CpuMpData->CpuInfoInHob;
+  LastLeader   = MAX_UINT32;
+  for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
+    if (Index == CpuMpData->BspNumber) {
+      continue;
+    }
+
+    CpuData = &CpuMpData->CpuData[Index];
+
+    GetProcessorLocationByApicId (CpuInfoInHob[Index].InitialApicId, &CpuData->PackageId, NULL, NULL);
+    for (Leader = CpuMpData->FirstPackageLeader; Leader != MAX_UINT32; Leader = CpuMpData->CpuData[Leader].NextPackageLeader) {
+      if (CpuMpData->CpuData[Leader].PackageId == CpuData->PackageId) {
+        break;
+      }
+    }
+
+    if (Leader != MAX_UINT32) {
+      CpuData->NextInPackage                   = CpuMpData->CpuData[Leader].NextInPackage;
+      CpuMpData->CpuData[Leader].NextInPackage = Index;
+    } else if (LastLeader == MAX_UINT32) {
+      CpuMpData->FirstPackageLeader = Index;
+      LastLeader                    = Index;
+    } else {
+      CpuMpData->CpuData[LastLeader].NextPackageLeader = Index;
+      LastLeader                                       = Index;
+    }
+  }
+}
+
 /**
   Enable x2APIC mode on APs.
 
@@ -613,8 +682,9 @@ InitializeApData (
   ApStackData         = (AP_STACK_DATA *)((UINTN)ApTopOfStack - sizeof (AP_STACK_DATA));
   ApStackData->MpData = CpuMpData;
 
-  CpuMpData->CpuData[ProcessorNumber].Waiting    = FALSE;
-  CpuMpData->CpuData[ProcessorNumber].CpuHealthy = (BistData == 0) ? TRUE : FALSE;
+  CpuMpData->CpuData[ProcessorNumber].Waiting       = FALSE;
+  CpuMpData->CpuData[ProcessorNumber].WakeUpPackage = FALSE;
+  CpuMpData->CpuData[ProcessorNumber].CpuHealthy    = (BistData == 0) ? TRUE : FALSE;
 
   //
   // NOTE: PlatformId is not relevant on AMD platforms.
@@ -636,6 +706,73 @@ InitializeApData (
   SetApState (&CpuMpData->CpuData[ProcessorNumber], CpuStateIdle);
 }
 
+/**
+  Wait for AP wakeup and write AP start-up signal till AP is waken up.
+
+  @param[in] ApStartupSignalBuffer  Pointer to AP wakeup signal
+**/
+VOID
+WaitApWakeup (
+  IN volatile UINT32  *ApStartupSignalBuffer
+  )
+{
+  //
+  // If AP is waken up, StartupApSignal should be cleared.
+  // Otherwise, write StartupApSignal again till AP waken up.
+  //
+  while (InterlockedCompareExchange32 (
+           (UINT32 *)ApStartupSignalBuffer,
+           WAKEUP_AP_SIGNAL,
+           WAKEUP_AP_SIGNAL
+           ) != 0)
+  {
+    CpuPause ();
+  }
+}
+
+/**
+  Wake up a list of APs linked by CPU_AP_DATA.NextInPackage, and wait for all
+  of them to be waken up.
+
+  This is called by a package leader for the other APs of its package, or by
+  the BSP for the APs of a package whose leader is disabled.
+
+  @param[in] CpuMpData          Pointer to CPU MP Data
+  @param[in] ProcessorNumber    The handle number of the first AP, or MAX_UINT32
+  @param[in] Procedure          The function to be invoked by AP
+  @param[in] ProcedureArgument  The argument to be passed into AP function
+**/
+VOID
+WakeUpApList (
+  IN CPU_MP_DATA       *CpuMpData,
+  IN UINT32            ProcessorNumber,
+  IN EFI_AP_PROCEDURE  Procedure               OPTIONAL,
+  IN VOID              *ProcedureArgument      OPTIONAL
+  )
+{
+  UINT32       Index;
+  CPU_AP_DATA  *CpuData;
+
+  for (Index = ProcessorNumber; Index != MAX_UINT32; Index = CpuData->NextInPackage) {
+    CpuData = &CpuMpData->CpuData[Index];
+    if ((GetApState (CpuData) == CpuStateDisabled) && !CpuMpData->WakeUpDisabledAps) {
+      continue;
+    }
+
+    CpuData->ApFunction         = (UINTN)Procedure;
+    CpuData->ApFunctionArgument = (UINTN)ProcedureArgument;
+    SetApState (CpuData, CpuStateReady);
+    *(UINT32 *)CpuData->StartupApSignal = WAKEUP_AP_SIGNAL;
+  }
+
+  for (Index = ProcessorNumber; Index != MAX_UINT32; Index = CpuData->NextInPackage) {
+    CpuData = &CpuMpData->CpuData[Index];
+    if (GetApState (CpuData) != CpuStateDisabled) {
+      WaitApWakeup (CpuData->StartupApSignal);
+    }
+  }
+}
+
 /**
   This function will be called from AP reset code if BSP uses WakeUpAP.
 
@@ -736,6 +873,20 @@ ApWakeupFunction (
         }
       }
 
+      //
+      // A package leader wakes up the other APs of its package before it runs
+      // the procedure.
+      //
+      if (CpuMpData->CpuData[ProcessorNumber].WakeUpPackage) {
+        CpuMpData->CpuData[ProcessorNumber].WakeUpPackage = FALSE;
+        WakeUpApList (
+          CpuMpData,
+          CpuMpData->CpuData[ProcessorNumber].NextInPackage,
+          (EFI_AP_PROCEDURE)CpuMpData->CpuData[ProcessorNumber].ApFunction,
+          (VOID *)CpuMpData->CpuData[ProcessorNumber].ApFunctionArgument
+          );
+      }
+
       if (GetApState (&CpuMpData->CpuData[ProcessorNumber]) == CpuStateReady) {
         Procedure = (EFI_AP_PROCEDURE)CpuMpData->CpuData[ProcessorNumber].ApFunction;
         Parameter = (VOID *)CpuMpData->CpuData[ProcessorNumber].ApFunctionArgument;
@@ -862,30 +1013,6 @@ ApWakeupFunction (
   }
 }
 
-/**
-  Wait for AP wakeup and write AP start-up signal till AP is waken up.
-
-  @param[in] ApStartupSignalBuffer  Pointer to AP wakeup signal
-**/
-VOID
-WaitApWakeup (
-  IN volatile UINT32  *ApStartupSignalBuffer
-  )
-{
-  //
-  // If AP is waken up, StartupApSignal should be cleared.
-  // Otherwise, write StartupApSignal again till AP waken up.
-  //
-  while (InterlockedCompareExchange32 (
-           (UINT32 *)ApStartupSignalBuffer,
-           WAKEUP_AP_SIGNAL,
-           WAKEUP_AP_SIGNAL
-           ) != 0)
-  {
-    CpuPause ();
-  }
-}
-
 /**
   Calculate the size of the reset vector.
 
@@ -1193,7 +1320,36 @@ WakeUpAP (
 
   ExchangeInfo = CpuMpData->MpCpuExchangeInfo;
 
-  if (Broadcast) {
+  if (Broadcast && !ResetVectorRequired && (CpuMpData->FirstPackageLeader != MAX_UINT32)) {
+    //
+    // Only wake up the package leaders. Each leader wakes up the other APs of
+    // its package, so the packages are waken up in parallel.
+    //
+    CpuMpData->WakeUpDisabledAps = WakeUpDisabledAps;
+    for (Index = CpuMpData->FirstPackageLeader; Index != MAX_UINT32; Index = CpuData->NextPackageLeader) {
+      CpuData = &CpuMpData->CpuData[Index];
+      if ((GetApState (CpuData) == CpuStateDisabled) && !WakeUpDisabledAps) {
+        //
+        // A disabled leader is not waken up, wake up its package from the BSP.
+        //
+        WakeUpApList (CpuMpData, CpuData->NextInPackage, Procedure, ProcedureArgument);
+        continue;
+      }
+
+      CpuData->ApFunction         = (UINTN)Procedure;
+      CpuData->ApFunctionArgument = (UINTN)ProcedureArgument;
+      CpuData->WakeUpPackage      = TRUE;
+      SetApState (CpuData, CpuStateReady);
+      *(UINT32 *)CpuData->StartupApSignal = WAKEUP_AP_SIGNAL;
+    }
+
+    for (Index = CpuMpData->FirstPackageLeader; Index != MAX_UINT32; Index = CpuData->NextPackageLeader) {
+      CpuData = &CpuMpData->CpuData[Index];
+      if (GetApState (CpuData) != CpuStateDisabled) {
+        WaitApWakeup (CpuData->StartupApSignal);
+      }
+    }
+  } else if (Broadcast) {
     for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
       if (Index != CpuMpData->BspNumber) {
         CpuData = &CpuMpData->CpuData[Index];
@@ -1686,45 +1842,56 @@ CheckAllAPs (
   EFI_STATUS   Status;
   CPU_MP_DATA  *CpuMpData;
   CPU_AP_DATA  *CpuData;
+  UINT32       FinishedCount;
 
   CpuMpData = GetCpuMpData ();
 
   NextProcessorNumber = 0;
 
   //
-  // Go through all APs that are responsible for the StartupAllAPs().
+  // The APs increment FinishedCount after they set their state to finished,
+  // so the states of the APs only need to be checked again when FinishedCount
+  // changes. In single thread mode, WakeUpAP() resets FinishedCount for each AP.
   //
-  for (ProcessorNumber = 0; ProcessorNumber < CpuMpData->CpuCount; ProcessorNumber++) {
-    if (!CpuMpData->CpuData[ProcessorNumber].Waiting) {
-      continue;
-    }
+  FinishedCount = CpuMpData->FinishedCount;
+  if (CpuMpData->SingleThread || (FinishedCount != CpuMpData->CheckedFinishedCount)) {
+    CpuMpData->CheckedFinishedCount = FinishedCount;
 
-    CpuData = &CpuMpData->CpuData[ProcessorNumber];
     //
-    // Check the CPU state of AP. If it is CpuStateIdle, then the AP has finished its task.
-    // Only BSP and corresponding AP access this unit of CPU Data. This means the AP will not modify the
-    // value of state after setting the it to CpuStateIdle, so BSP can safely make use of its value.
+    // Go through all APs that are responsible for the StartupAllAPs().
     //
-    if (GetApState (CpuData) == CpuStateFinished) {
-      CpuMpData->RunningCount--;
-      CpuMpData->CpuData[ProcessorNumber].Waiting = FALSE;
-      SetApState (CpuData, CpuStateIdle);
+    for (ProcessorNumber = 0; ProcessorNumber < CpuMpData->CpuCount; ProcessorNumber++) {
+      if (!CpuMpData->CpuData[ProcessorNumber].Waiting) {
+        continue;
+      }
 
+      CpuData = &CpuMpData->CpuData[ProcessorNumber];
       //
-      // If in Single Thread mode, then search for the next waiting AP for execution.
+      // Check the CPU state of AP. If it is CpuStateIdle, then the AP has finished its task.
+      // Only BSP and corresponding AP access this unit of CPU Data. This means the AP will not modify the
+      // value of state after setting the it to CpuStateIdle, so BSP can safely make use of its value.
       //
-      if (CpuMpData->SingleThread) {
-        Status = GetNextWaitingProcessorNumber (&NextProcessorNumber);
-
-        if (!EFI_ERROR (Status)) {
-          WakeUpAP (
-            CpuMpData,
-            FALSE,
-            (UINT32)NextProcessorNumber,
-            CpuMpData->Procedure,
-            CpuMpData->ProcArguments,
-            TRUE
-            );
+      if (GetApState (CpuData) == CpuStateFinished) {
+        CpuMpData->RunningCount--;
+        CpuMpData->CpuData[ProcessorNumber].Waiting = FALSE;
+        SetApState (CpuData, CpuStateIdle);
+
+        //
+        // If in Single Thread mode, then search for the next waiting AP for execution.
+        //
+        if (CpuMpData->SingleThread) {
+          Status = GetNextWaitingProcessorNumber (&NextProcessorNumber);
+
+          if (!EFI_ERROR (Status)) {
+            WakeUpAP (
+              CpuMpData,
+              FALSE,
+              (UINT32)NextProcessorNumber,
+              CpuMpData->Procedure,
+              CpuMpData->ProcArguments,
+              TRUE
+              );
+          }
         }
       }
     }
@@ -1943,6 +2110,7 @@ MpInitLibInitialize (
   DEBUG ((DEBUG_INFO, "AP Loop Mode is %d\n", CpuMpData->ApLoopMode));
 
   CpuMpData->WakeUpByInitSipiSipi = (CpuMpData->ApLoopMode == ApInHltLoop);
+  CpuMpData->FirstPackageLeader   = MAX_UINT32;
 
   //
   // Set up APs wakeup signal buffer
@@ -1989,8 +2157,9 @@ MpInitLibInitialize (
     CpuInfoInHob               = (CPU_INFO_IN_HOB *)(UINTN)CpuMpData->CpuInfoInHob;
     for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
       InitializeSpinLock (&CpuMpData->CpuData[Index].ApLock);
-      CpuMpData->CpuData[Index].CpuHealthy = (CpuInfoInHob[Index].Health == 0) ? TRUE : FALSE;
-      CpuMpData->CpuData[Index].ApFunction = 0;
+      CpuMpData->CpuData[Index].CpuHealthy    = (CpuInfoInHob[Index].Health == 0) ? TRUE : FALSE;
+      CpuMpData->CpuData[Index].ApFunction    = 0;
+      CpuMpData->CpuData[Index].WakeUpPackage = FALSE;
     }
   }
 
@@ -2019,6 +2188,8 @@ MpInitLibInitialize (
   // Wakeup APs to do some AP initialize sync (Microcode & MTRR)
   //
   if (CpuMpData->CpuCount > 1) {
+    InitializePackageLeaders (CpuMpData);
+
     if (OldCpuMpData != NULL) {
       //
       // Only needs to use this flag for DXE phase to update the wake up
@@ -2317,6 +2488,11 @@ SwitchBSPWorker (
   //
   CpuMpData->BspNumber = (UINT32)ProcessorNumber;
 
+  //
+  // The new BSP may be a package leader.
+  //
+  InitializePackageLeaders (CpuMpData);
+
   //
   // Restore interrupt state.
   //
@@ -2607,15 +2783,16 @@ StartupAllCPUsWorker (
     }
   }
 
-  CpuMpData->Procedure     = Procedure;
-  CpuMpData->ProcArguments = ProcedureArgument;
-  CpuMpData->SingleThread  = SingleThread;
-  CpuMpData->FinishedCount = 0;
-  CpuMpData->FailedCpuList = FailedCpuList;
-  CpuMpData->ExpectedTime  = CalculateTimeout (
-                               TimeoutInMicroseconds,
-                               &CpuMpData->CurrentTime
-                               );
+  CpuMpData->Procedure            = Procedure;
+  CpuMpData->ProcArguments        = ProcedureArgument;
+  CpuMpData->SingleThread         = SingleThread;
+  CpuMpData->FinishedCount        = 0;
+  CpuMpData->CheckedFinishedCount = 0;
+  CpuMpData->FailedCpuList        = FailedCpuList;
+  CpuMpData->ExpectedTime         = CalculateTimeout (
+                                      TimeoutInMicroseconds,
+                                      &CpuMpData->CurrentTime
+                                      );
   CpuMpData->TotalTime = 0;
   CpuMpData->WaitEvent = WaitEvent;
 
@@ -150,6 +150,15 @@ typedef struct {
   UINT64                    MicrocodeEntryAddr;
   UINT32                    MicrocodeRevision;
   SEV_ES_SAVE_AREA          *SevEsSaveArea;
+  //
+  // The APs of a package form a list, headed by the package leader. The
+  // leaders form another list, headed by CPU_MP_DATA.FirstPackageLeader.
+  // MAX_UINT32 ends both lists.
+  //
+  UINT32                    PackageId;
+  UINT32                    NextPackageLeader;
+  UINT32                    NextInPackage;
+  volatile BOOLEAN          WakeUpPackage;
 } CPU_AP_DATA;
 
 //
@@ -261,6 +270,7 @@ struct _CPU_MP_DATA {
   UINT64                           TotalTime;
   EFI_EVENT                        WaitEvent;
   UINTN                            **FailedCpuList;
+  UINT32                           CheckedFinishedCount;
 
   AP_INIT_STATE                    InitFlag;
   BOOLEAN                          SwitchBspFlag;
@@ -300,6 +310,13 @@ struct _CPU_MP_DATA {
   CPU_MP_DATA    *NewCpuMpData;
 
   UINT64         GhcbBase;
+
+  //
+  // The first package leader for the hierarchical wakeup of the APs, or
+  // MAX_UINT32 if the APs are woken up by the BSP.
+  //
+  UINT32         FirstPackageLeader;
+  BOOLEAN        WakeUpDisabledAps;
 };
 
 //
@@ -0,0 +1,1167 @@
+/** @file
+  Host based unit test and simulation of the AP wakeup of the MP Initialize
+  Library.
+
+  Each AP of a simulated platform is a host thread that runs the AP wakeup
+  loop of MpLib.c in Run-loop mode, and the BSP is the main thread. The BSP
+  broadcasts procedures through StartupAllCPUsWorker (), with the APs woken up
+  by the BSP and through a leader per package, and the time from the broadcast
+  to the APs starting the procedure is reported for several CPU and package
+  counts. The host threads are oversubscribed when the host has fewer CPUs
+  than the simulated platform, so the reported times only compare the two
+  wakeup methods on the same host.
+
+  Copyright (c) 2026, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#if defined (_MSC_VER)
+  #include <process.h>
+#define SIM_THREAD_LOCAL  __declspec(thread)
+#else
+  #include <pthread.h>
+#define SIM_THREAD_LOCAL  __thread
+#endif
+
+#include "MpLib.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "MP Initialize Library AP Wakeup Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define SIM_MAX_CPUS         64
+#define SIM_DISPATCH_ROUNDS  8
+
+//
+// The start-up signals of the APs are one cache line apart, as they are in
+// the MWAIT monitor buffer.
+//
+#define SIM_SIGNAL_STRIDE  (64 / sizeof (UINT32))
+
+//
+// The simulated APIC ID holds the package number above the CPU number in the
+// package.
+//
+#define SIM_PACKAGE_SHIFT  4
+
+///
+/// A simulated platform.
+///
+typedef struct {
+  UINT32    CpuCount;
+  UINT32    PackageCount;
+} SIM_TOPOLOGY;
+
+///
+/// A simulated AP.
+///
+typedef struct {
+  UINT32     ApicId;
+  UINTN      ProcessorNumber;
+  jmp_buf    Exit;
+} SIM_AP;
+
+///
+/// The dispatch times of a number of broadcasts, in nanoseconds.
+///
+typedef struct {
+  UINT64    AverageNs;
+  UINT64    WorstNs;
+  UINT64    CompletionNs;
+  UINT32    BspWakeups;
+} SIM_DISPATCH_STATS;
+
+GLOBAL_REMOVE_IF_UNREFERENCED SIM_TOPOLOGY  mSimTopologies[] = {
+  { 2,  1 },
+  { 4,  1 },
+  { 8,  2 },
+  { 16, 2 },
+  { 16, 4 },
+  { 32, 4 },
+  { 64, 8 }
+};
+
+CPU_MP_DATA           *mSimCpuMpData;
+CPU_INFO_IN_HOB       *mSimCpuInfoInHob;
+MP_CPU_EXCHANGE_INFO  mSimExchangeInfo;
+UINT32                *mSimSignals;
+SIM_AP                *mSimAps;
+SIM_TOPOLOGY          mSimTopology;
+volatile UINT32       mSimExitedCount;
+volatile UINT32       mSimRunCount[SIM_MAX_CPUS];
+volatile UINT64       mSimEntryNs[SIM_MAX_CPUS];
+
+//
+// The APIC ID and the AP of the current thread.
+//
+SIM_THREAD_LOCAL UINT32  mSimApicId;
+SIM_THREAD_LOCAL SIM_AP  *mSimAp;
+
+/**
+  Get the package of a simulated CPU.
+
+  @param[in]  ProcessorNumber  The handle number of the CPU.
+
+  @return The package of the CPU.
+**/
+UINT32
+SimPackageOf (
+  IN UINTN  ProcessorNumber
+  )
+{
+  return (UINT32)ProcessorNumber / (mSimTopology.CpuCount / mSimTopology.PackageCount);
+}
+
+//
+// Local APIC Library services, backed by the APIC ID of the current thread.
+//
+
+UINT32
+EFIAPI
+GetApicId (
+  VOID
+  )
+{
+  return mSimApicId;
+}
+
+UINT32
+EFIAPI
+GetInitialApicId (
+  VOID
+  )
+{
+  return mSimApicId;
+}
+
+UINTN
+EFIAPI
+GetApicMode (
+  VOID
+  )
+{
+  return LOCAL_APIC_MODE_XAPIC;
+}
+
+VOID
+EFIAPI
+SetApicMode (
+  IN UINTN  ApicMode
+  )
+{
+}
+
+VOID
+EFIAPI
+ProgramVirtualWireMode (
+  VOID
+  )
+{
+}
+
+VOID
+EFIAPI
+DisableLvtInterrupts (
+  VOID
+  )
+{
+}
+
+VOID
+EFIAPI
+GetApicTimerState (
+  OUT UINTN    *DivideValue  OPTIONAL,
+  OUT BOOLEAN  *PeriodicMode  OPTIONAL,
+  OUT UINT8    *Vector  OPTIONAL
+  )
+{
+  if (DivideValue != NULL) {
+    *DivideValue = 1;
+  }
+
+  if (PeriodicMode != NULL) {
+    *PeriodicMode = FALSE;
+  }
+
+  if (Vector != NULL) {
+    *Vector = 0;
+  }
+}
+
+VOID
+EFIAPI
+InitializeApicTimer (
+  IN UINTN    DivideValue,
+  IN UINT32   InitCount,
+  IN BOOLEAN  PeriodicMode,
+  IN UINT8    Vector
+  )
+{
+}
+
+UINT32
+EFIAPI
+GetApicTimerCurrentCount (
+  VOID
+  )
+{
+  return 0;
+}
+
+BOOLEAN
+EFIAPI
+GetApicTimerInterruptState (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+VOID
+EFIAPI
+EnableApicTimerInterrupt (
+  VOID
+  )
+{
+}
+
+VOID
+EFIAPI
+DisableApicTimerInterrupt (
+  VOID
+  )
+{
+}
+
+VOID
+EFIAPI
+GetProcessorLocationByApicId (
+  IN  UINT32  InitialApicId,
+  OUT UINT32  *Package  OPTIONAL,
+  OUT UINT32  *Core    OPTIONAL,
+  OUT UINT32  *Thread  OPTIONAL
+  )
+{
+  if (Package != NULL) {
+    *Package = InitialApicId >> SIM_PACKAGE_SHIFT;
+  }
+
+  if (Core != NULL) {
+    *Core = InitialApicId & ((BIT0 << SIM_PACKAGE_SHIFT) - 1);
+  }
+
+  if (Thread != NULL) {
+    *Thread = 0;
+  }
+}
+
+//
+// The services below are only used when the APs are started with
+// INIT-SIPI-SIPI or during the MP initialization, which the tests do not do.
+//
+
+VOID
+EFIAPI
+SendInitSipiSipi (
+  IN UINT32  ApicId,
+  IN UINT32  StartupRoutine
+  )
+{
+  ASSERT (FALSE);
+}
+
+VOID
+EFIAPI
+SendInitSipiSipiAllExcludingSelf (
+  IN UINT32  StartupRoutine
+  )
+{
+  ASSERT (FALSE);
+}
+
+VOID
+EFIAPI
+GetProcessorLocation2ByApicId (
+  IN  UINT32  InitialApicId,
+  OUT UINT32  *Package  OPTIONAL,
+  OUT UINT32  *Die      OPTIONAL,
+  OUT UINT32  *Tile     OPTIONAL,
+  OUT UINT32  *Module   OPTIONAL,
+  OUT UINT32  *Core     OPTIONAL,
+  OUT UINT32  *Thread   OPTIONAL
+  )
+{
+  ASSERT (FALSE);
+}
+
+VOID *
+EFIAPI
+GetFirstGuidHob (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  return NULL;
+}
+
+BOOLEAN
+EFIAPI
+StandardSignatureIsAuthenticAMD (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+VOID
+EFIAPI
+InitializeFloatingPointUnits (
+  VOID
+  )
+{
+}
+
+VOID
+EFIAPI
+AsmGetAddressMap (
+  OUT MP_ASSEMBLY_ADDRESS_MAP  *AddressMap
+  )
+{
+  ASSERT (FALSE);
+}
+
+VOID
+EFIAPI
+AsmExchangeRole (
+  IN CPU_EXCHANGE_ROLE_INFO  *MyInfo,
+  IN CPU_EXCHANGE_ROLE_INFO  *OthersInfo
+  )
+{
+  ASSERT (FALSE);
+}
+
+UINTN
+GetWakeupBuffer (
+  IN UINTN  WakeupBufferSize
+  )
+{
+  ASSERT (FALSE);
+  return 0;
+}
+
+UINTN
+AllocateCodeBuffer (
+  IN UINTN  BufferSize
+  )
+{
+  ASSERT (FALSE);
+  return 0;
+}
+
+VOID
+InitMpGlobalData (
+  IN CPU_MP_DATA  *CpuMpData
+  )
+{
+  ASSERT (FALSE);
+}
+
+VOID
+AllocateSevEsAPMemory (
+  IN OUT CPU_MP_DATA  *CpuMpData
+  )
+{
+  ASSERT (FALSE);
+}
+
+VOID
+FillExchangeInfoDataSevEs (
+  IN volatile MP_CPU_EXCHANGE_INFO  *ExchangeInfo
+  )
+{
+  ASSERT (FALSE);
+}
+
+VOID
+SetSevEsJumpTable (
+  IN UINTN  SipiVector
+  )
+{
+  ASSERT (FALSE);
+}
+
+VOID
+SevEsPlaceApHlt (
+  CPU_MP_DATA  *CpuMpData
+  )
+{
+  ASSERT (FALSE);
+}
+
+VOID
+SevSnpCreateAP (
+  IN CPU_MP_DATA  *CpuMpData,
+  IN INTN         ProcessorNumber
+  )
+{
+  ASSERT (FALSE);
+}
+
+VOID
+MicrocodeDetect (
+  IN CPU_MP_DATA  *CpuMpData,
+  IN UINTN        ProcessorNumber
+  )
+{
+  ASSERT (FALSE);
+}
+
+VOID
+ShadowMicrocodeUpdatePatch (
+  IN OUT CPU_MP_DATA  *CpuMpData
+  )
+{
+  ASSERT (FALSE);
+}
+
+BOOLEAN
+GetMicrocodePatchInfoFromHob (
+  UINT64  *Address,
+  UINT64  *RegionSize
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+//
+// The MP Initialize Library services of the PEI and DXE instances.
+//
+
+CPU_MP_DATA *
+GetCpuMpData (
+  VOID
+  )
+{
+  return mSimCpuMpData;
+}
+
+VOID
+CheckAndUpdateApsStatus (
+  VOID
+  )
+{
+}
+
+VOID
+EnableDebugAgent (
+  VOID
+  )
+{
+}
+
+/**
+  Create the CPU MP data of a simulated platform, with the APs idle in
+  Run-loop mode, and group the APs by package.
+
+  @param[in]  Topology      The simulated platform.
+  @param[in]  BspNumber     The handle number of the BSP.
+  @param[in]  Hierarchical  Whether the APs are woken up through a leader per
+                            package.
+**/
+VOID
+SimCreateCpuMpData (
+  IN SIM_TOPOLOGY  *Topology,
+  IN UINT32        BspNumber,
+  IN BOOLEAN       Hierarchical
+  )
+{
+  CPU_MP_DATA  *CpuMpData;
+  UINT32       CpusPerPackage;
+  UINTN        Index;
+
+  PatchPcdSetBool (PcdCpuApHierarchicalWakeup, Hierarchical);
+
+  CopyMem (&mSimTopology, Topology, sizeof (mSimTopology));
+  CpusPerPackage = Topology->CpuCount / Topology->PackageCount;
+
+  CpuMpData        = AllocateZeroPool (sizeof (CPU_MP_DATA));
+  mSimCpuInfoInHob = AllocateZeroPool (Topology->CpuCount * sizeof (CPU_INFO_IN_HOB));
+  mSimSignals      = AllocateZeroPool (Topology->CpuCount * SIM_SIGNAL_STRIDE * sizeof (UINT32));
+  ASSERT (CpuMpData != NULL && mSimCpuInfoInHob != NULL && mSimSignals != NULL);
+
+  CpuMpData->CpuData = AllocateZeroPool (Topology->CpuCount * sizeof (CPU_AP_DATA));
+  ASSERT (CpuMpData->CpuData != NULL);
+
+  CpuMpData->CpuCount             = Topology->CpuCount;
+  CpuMpData->BspNumber            = BspNumber;
+  CpuMpData->CpuInfoInHob         = (UINT64)(UINTN)mSimCpuInfoInHob;
+  CpuMpData->ApLoopMode           = ApInRunLoop;
+  CpuMpData->InitFlag             = ApInitDone;
+  CpuMpData->WakeUpByInitSipiSipi = FALSE;
+  CpuMpData->MpCpuExchangeInfo    = &mSimExchangeInfo;
+  InitializeSpinLock (&CpuMpData->MpLock);
+
+  ZeroMem (&mSimExchangeInfo, sizeof (mSimExchangeInfo));
+  mSimExchangeInfo.CpuMpData = CpuMpData;
+
+  for (Index = 0; Index < Topology->CpuCount; Index++) {
+    mSimCpuInfoInHob[Index].ApicId = (SimPackageOf (Index) << SIM_PACKAGE_SHIFT) |
+                                     (UINT32)(Index % CpusPerPackage);
+    mSimCpuInfoInHob[Index].InitialApicId = mSimCpuInfoInHob[Index].ApicId;
+    mSimCpuInfoInHob[Index].Health        = 0;
+
+    InitializeSpinLock (&CpuMpData->CpuData[Index].ApLock);
+    CpuMpData->CpuData[Index].StartupApSignal = &mSimSignals[Index * SIM_SIGNAL_STRIDE];
+    CpuMpData->CpuData[Index].CpuHealthy      = TRUE;
+    CpuMpData->CpuData[Index].State           = CpuStateIdle;
+  }
+
+  InitializePackageLeaders (CpuMpData);
+
+  mSimCpuMpData = CpuMpData;
+  mSimApicId    = mSimCpuInfoInHob[BspNumber].ApicId;
+}
+
+/**
+  Free the CPU MP data of the simulated platform.
+**/
+VOID
+SimFreeCpuMpData (
+  VOID
+  )
+{
+  FreePool (mSimCpuMpData->CpuData);
+  FreePool (mSimCpuMpData);
+  FreePool (mSimCpuInfoInHob);
+  FreePool (mSimSignals);
+  mSimCpuMpData = NULL;
+}
+
+/**
+  The body of an AP thread: run the AP wakeup loop until the AP is asked to
+  exit.
+
+  @param[in]  Ap  The simulated AP.
+**/
+VOID
+SimApThread (
+  IN SIM_AP  *Ap
+  )
+{
+  mSimApicId = Ap->ApicId;
+  mSimAp     = Ap;
+  if (setjmp (Ap->Exit) == 0) {
+    ApWakeupFunction (&mSimExchangeInfo, Ap->ProcessorNumber);
+  }
+
+  InterlockedIncrement (&mSimExitedCount);
+}
+
+#if defined (_MSC_VER)
+VOID
+__cdecl
+SimApThreadEntry (
+  IN VOID  *Ap
+  )
+{
+  SimApThread ((SIM_AP *)Ap);
+}
+
+#else
+VOID *
+SimApThreadEntry (
+  IN VOID  *Ap
+  )
+{
+  SimApThread ((SIM_AP *)Ap);
+  return NULL;
+}
+
+#endif
+
+/**
+  Start a host thread for a simulated AP.
+
+  @param[in]  Ap  The simulated AP.
+
+  @retval TRUE   The thread is started.
+  @retval FALSE  The thread could not be started.
+**/
+BOOLEAN
+SimStartThread (
+  IN SIM_AP  *Ap
+  )
+{
+ #if defined (_MSC_VER)
+  return (BOOLEAN)(_beginthread (SimApThreadEntry, 0, Ap) != (uintptr_t)-1);
+ #else
+  pthread_t  Thread;
+
+  if (pthread_create (&Thread, NULL, SimApThreadEntry, Ap) != 0) {
+    return FALSE;
+  }
+
+  pthread_detach (Thread);
+  return TRUE;
+ #endif
+}
+
+/**
+  Start the APs of the simulated platform and wait for all of them to enter
+  the Run-loop.
+
+  @retval TRUE   The APs are started.
+  @retval FALSE  The APs could not be started.
+**/
+BOOLEAN
+SimStartAps (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  mSimAps = AllocateZeroPool (mSimCpuMpData->CpuCount * sizeof (SIM_AP));
+  if (mSimAps == NULL) {
+    return FALSE;
+  }
+
+  mSimExitedCount              = 0;
+  mSimCpuMpData->FinishedCount = 0;
+  for (Index = 0; Index < mSimCpuMpData->CpuCount; Index++) {
+    if (Index == mSimCpuMpData->BspNumber) {
+      continue;
+    }
+
+    mSimAps[Index].ApicId          = mSimCpuInfoInHob[Index].ApicId;
+    mSimAps[Index].ProcessorNumber = Index;
+    if (!SimStartThread (&mSimAps[Index])) {
+      return FALSE;
+    }
+  }
+
+  //
+  // Each AP counts itself as finished once before it enters the Run-loop.
+  //
+  while (mSimCpuMpData->FinishedCount != mSimCpuMpData->CpuCount - 1) {
+    CpuPause ();
+  }
+
+  return TRUE;
+}
+
+/**
+  The procedure that makes an AP leave the AP wakeup loop.
+
+  @param[in]  Buffer  Unused.
+**/
+VOID
+EFIAPI
+SimApExit (
+  IN VOID  *Buffer
+  )
+{
+  longjmp (mSimAp->Exit, 1);
+}
+
+/**
+  Make all the APs of the simulated platform leave the AP wakeup loop and wait
+  for their threads to exit.
+**/
+VOID
+SimStopAps (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < mSimCpuMpData->CpuCount; Index++) {
+    if (Index != mSimCpuMpData->BspNumber) {
+      mSimCpuMpData->CpuData[Index].State = CpuStateIdle;
+    }
+  }
+
+  WakeUpAP (mSimCpuMpData, TRUE, 0, SimApExit, NULL, FALSE);
+  while (mSimExitedCount != mSimCpuMpData->CpuCount - 1) {
+    CpuPause ();
+  }
+
+  FreePool (mSimAps);
+  mSimAps = NULL;
+}
+
+/**
+  The procedure broadcast to the APs: record when and how often each AP runs
+  it.
+
+  @param[in]  Buffer  Unused.
+**/
+VOID
+EFIAPI
+SimApProcedure (
+  IN VOID  *Buffer
+  )
+{
+  mSimEntryNs[mSimAp->ProcessorNumber] = GetTimeInNanoSecond (GetPerformanceCounter ());
+  mSimRunCount[mSimAp->ProcessorNumber]++;
+}
+
+/**
+  Check that the package lists of the simulated platform hold every AP once,
+  that the APs of a list are in the same package and that the leader of a
+  package is its first AP.
+
+  @retval  UNIT_TEST_PASSED             The package lists are correct.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The package lists are not correct.
+**/
+UNIT_TEST_STATUS
+SimCheckPackageLeaders (
+  VOID
+  )
+{
+  CPU_MP_DATA  *CpuMpData;
+  BOOLEAN      Listed[SIM_MAX_CPUS];
+  UINT32       Leader;
+  UINT32       Member;
+  UINT32       Package;
+  UINT32       Index;
+
+  CpuMpData = mSimCpuMpData;
+  ZeroMem (Listed, sizeof (Listed));
+  for (Leader = CpuMpData->FirstPackageLeader; Leader != MAX_UINT32; Leader = CpuMpData->CpuData[Leader].NextPackageLeader) {
+    UT_ASSERT_NOT_EQUAL (Leader, CpuMpData->BspNumber);
+    Package = SimPackageOf (Leader);
+    for (Index = 0; Index < Leader; Index++) {
+      if (Index != CpuMpData->BspNumber) {
+        UT_ASSERT_NOT_EQUAL (SimPackageOf (Index), Package);
+      }
+    }
+
+    for (Member = Leader; Member != MAX_UINT32; Member = CpuMpData->CpuData[Member].NextInPackage) {
+      UT_ASSERT_FALSE (Listed[Member]);
+      UT_ASSERT_EQUAL (SimPackageOf (Member), Package);
+      UT_ASSERT_EQUAL (CpuMpData->CpuData[Member].PackageId, Package);
+      Listed[Member] = TRUE;
+    }
+  }
+
+  for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
+    UT_ASSERT_EQUAL (Listed[Index], Index != CpuMpData->BspNumber);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check the package lists for several platforms and BSPs, and that there are
+  none when the hierarchical wakeup is disabled.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SimPackageLeaders (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  SIM_TOPOLOGY  *Topology;
+  UINT32        BspNumbers[3];
+  UINTN         Index;
+  UINTN         BspIndex;
+  UINTN         Cpu;
+
+  for (Index = 0; Index < ARRAY_SIZE (mSimTopologies); Index++) {
+    Topology = &mSimTopologies[Index];
+
+    //
+    // The BSP is the first CPU, the last CPU, or the first CPU of the last
+    // package.
+    //
+    BspNumbers[0] = 0;
+    BspNumbers[1] = Topology->CpuCount - 1;
+    BspNumbers[2] = Topology->CpuCount - Topology->CpuCount / Topology->PackageCount;
+    for (BspIndex = 0; BspIndex < ARRAY_SIZE (BspNumbers); BspIndex++) {
+      SimCreateCpuMpData (Topology, BspNumbers[BspIndex], TRUE);
+      UT_ASSERT_NOT_EQUAL (mSimCpuMpData->FirstPackageLeader, MAX_UINT32);
+      UT_ASSERT_EQUAL (SimCheckPackageLeaders (), UNIT_TEST_PASSED);
+      SimFreeCpuMpData ();
+    }
+
+    SimCreateCpuMpData (Topology, 0, FALSE);
+    UT_ASSERT_EQUAL (mSimCpuMpData->FirstPackageLeader, MAX_UINT32);
+    for (Cpu = 0; Cpu < Topology->CpuCount; Cpu++) {
+      UT_ASSERT_EQUAL (mSimCpuMpData->CpuData[Cpu].NextPackageLeader, MAX_UINT32);
+      UT_ASSERT_EQUAL (mSimCpuMpData->CpuData[Cpu].NextInPackage, MAX_UINT32);
+    }
+
+    SimFreeCpuMpData ();
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check that CheckAllAPs () only scans the AP states again when an AP has
+  finished since the last scan, except in single thread mode.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SimCheckAllApsSkip (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CPU_MP_DATA  *CpuMpData;
+  UINTN        Index;
+
+  SimCreateCpuMpData (&mSimTopologies[1], 0, FALSE);
+  CpuMpData = mSimCpuMpData;
+
+  for (Index = 1; Index < CpuMpData->CpuCount; Index++) {
+    CpuMpData->CpuData[Index].Waiting = TRUE;
+  }
+
+  CpuMpData->RunningCount         = CpuMpData->CpuCount - 1;
+  CpuMpData->SingleThread         = FALSE;
+  CpuMpData->FinishedCount        = 0;
+  CpuMpData->CheckedFinishedCount = 0;
+  CpuMpData->ExpectedTime         = 0;
+
+  //
+  // An AP state that changes without FinishedCount is not seen.
+  //
+  CpuMpData->CpuData[1].State = CpuStateFinished;
+  UT_ASSERT_EQUAL (CheckAllAPs (), EFI_NOT_READY);
+  UT_ASSERT_EQUAL (CpuMpData->RunningCount, CpuMpData->CpuCount - 1);
+  UT_ASSERT_TRUE (CpuMpData->CpuData[1].Waiting);
+
+  //
+  // It is seen once FinishedCount changes, and only once.
+  //
+  CpuMpData->FinishedCount = 1;
+  UT_ASSERT_EQUAL (CheckAllAPs (), EFI_NOT_READY);
+  UT_ASSERT_EQUAL (CpuMpData->RunningCount, CpuMpData->CpuCount - 2);
+  UT_ASSERT_FALSE (CpuMpData->CpuData[1].Waiting);
+  UT_ASSERT_EQUAL (CpuMpData->CpuData[1].State, CpuStateIdle);
+  UT_ASSERT_EQUAL (CpuMpData->CheckedFinishedCount, 1);
+
+  UT_ASSERT_EQUAL (CheckAllAPs (), EFI_NOT_READY);
+  UT_ASSERT_EQUAL (CpuMpData->RunningCount, CpuMpData->CpuCount - 2);
+
+  for (Index = 2; Index < CpuMpData->CpuCount; Index++) {
+    CpuMpData->CpuData[Index].State = CpuStateFinished;
+  }
+
+  CpuMpData->FinishedCount = CpuMpData->CpuCount - 1;
+  UT_ASSERT_EQUAL (CheckAllAPs (), EFI_SUCCESS);
+  UT_ASSERT_EQUAL (CpuMpData->RunningCount, 0);
+
+  //
+  // In single thread mode, WakeUpAP () resets FinishedCount for each AP, so
+  // the AP states are always scanned.
+  //
+  CpuMpData->SingleThread         = TRUE;
+  CpuMpData->RunningCount         = 1;
+  CpuMpData->CpuData[1].Waiting   = TRUE;
+  CpuMpData->CpuData[1].State     = CpuStateFinished;
+  CpuMpData->FinishedCount        = 0;
+  CpuMpData->CheckedFinishedCount = 0;
+  UT_ASSERT_EQUAL (CheckAllAPs (), EFI_SUCCESS);
+  UT_ASSERT_EQUAL (CpuMpData->RunningCount, 0);
+  UT_ASSERT_FALSE (CpuMpData->CpuData[1].Waiting);
+
+  SimFreeCpuMpData ();
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Broadcast the procedure to the APs a number of times, check that every
+  enabled AP runs it once per broadcast, and measure how long the APs take to
+  start it.
+
+  @param[in]  DisabledAp  The handle number of an AP that is disabled during
+                          the broadcasts, or MAX_UINTN.
+  @param[out] Stats       The dispatch times of the broadcasts.
+
+  @retval  UNIT_TEST_PASSED             The broadcasts are correct.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The broadcasts are not correct.
+**/
+UNIT_TEST_STATUS
+SimBroadcast (
+  IN  UINTN               DisabledAp,
+  OUT SIM_DISPATCH_STATS  *Stats
+  )
+{
+  CPU_MP_DATA  *CpuMpData;
+  UINT64       StartNs;
+  UINT64       EndNs;
+  UINT64       WorstNs;
+  UINT64       TotalNs;
+  UINTN        Round;
+  UINTN        Index;
+  UINT32       Leader;
+
+  CpuMpData = mSimCpuMpData;
+  ZeroMem (Stats, sizeof (*Stats));
+  ZeroMem ((VOID *)mSimRunCount, sizeof (mSimRunCount));
+
+  if (DisabledAp != MAX_UINTN) {
+    CpuMpData->CpuData[DisabledAp].State = CpuStateDisabled;
+  }
+
+  //
+  // The BSP wakes up every AP, or every package leader and the APs of the
+  // packages whose leader is disabled.
+  //
+  if (CpuMpData->FirstPackageLeader == MAX_UINT32) {
+    Stats->BspWakeups = CpuMpData->CpuCount - 1 - (DisabledAp != MAX_UINTN ? 1 : 0);
+  } else {
+    for (Leader = CpuMpData->FirstPackageLeader; Leader != MAX_UINT32; Leader = CpuMpData->CpuData[Leader].NextPackageLeader) {
+      if (Leader != DisabledAp) {
+        Stats->BspWakeups++;
+      } else {
+        for (Index = CpuMpData->CpuData[Leader].NextInPackage; Index != MAX_UINT32; Index = CpuMpData->CpuData[Index].NextInPackage) {
+          Stats->BspWakeups++;
+        }
+      }
+    }
+  }
+
+  for (Round = 0; Round < SIM_DISPATCH_ROUNDS; Round++) {
+    StartNs = GetTimeInNanoSecond (GetPerformanceCounter ());
+    UT_ASSERT_NOT_EFI_ERROR (StartupAllCPUsWorker (SimApProcedure, FALSE, TRUE, NULL, 0, NULL, NULL));
+    EndNs = GetTimeInNanoSecond (GetPerformanceCounter ());
+
+    WorstNs = 0;
+    TotalNs = 0;
+    for (Index = 0; Index < CpuMpData->CpuCount; Index++) {
+      if ((Index == CpuMpData->BspNumber) || (Index == DisabledAp)) {
+        UT_ASSERT_EQUAL (mSimRunCount[Index], 0);
+        continue;
+      }
+
+      UT_ASSERT_EQUAL (mSimRunCount[Index], Round + 1);
+      UT_ASSERT_TRUE (mSimEntryNs[Index] >= StartNs);
+      WorstNs  = MAX (WorstNs, mSimEntryNs[Index] - StartNs);
+      TotalNs += mSimEntryNs[Index] - StartNs;
+    }
+
+    Stats->WorstNs       = MAX (Stats->WorstNs, WorstNs);
+    Stats->AverageNs    += TotalNs / (CpuMpData->CpuCount - 1 - (DisabledAp != MAX_UINTN ? 1 : 0));
+    Stats->CompletionNs += EndNs - StartNs;
+  }
+
+  Stats->AverageNs    /= SIM_DISPATCH_ROUNDS;
+  Stats->CompletionNs /= SIM_DISPATCH_ROUNDS;
+
+  if (DisabledAp != MAX_UINTN) {
+    CpuMpData->CpuData[DisabledAp].State = CpuStateIdle;
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Run the broadcasts on a simulated platform.
+
+  @param[in]  Topology      The simulated platform.
+  @param[in]  Hierarchical  Whether the APs are woken up through a leader per
+                            package.
+  @param[in]  DisableLeader Whether the first package leader is disabled.
+  @param[out] Stats         The dispatch times of the broadcasts.
+
+  @retval  UNIT_TEST_PASSED             The broadcasts are correct.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The broadcasts are not correct.
+**/
+UNIT_TEST_STATUS
+SimRunPlatform (
+  IN  SIM_TOPOLOGY        *Topology,
+  IN  BOOLEAN             Hierarchical,
+  IN  BOOLEAN             DisableLeader,
+  OUT SIM_DISPATCH_STATS  *Stats
+  )
+{
+  UNIT_TEST_STATUS  Status;
+  UINTN             DisabledAp;
+
+  SimCreateCpuMpData (Topology, 0, Hierarchical);
+  UT_ASSERT_TRUE (SimStartAps ());
+
+  DisabledAp = MAX_UINTN;
+  if (DisableLeader) {
+    DisabledAp = (mSimCpuMpData->FirstPackageLeader != MAX_UINT32) ? mSimCpuMpData->FirstPackageLeader : 1;
+  }
+
+  Status = SimBroadcast (DisabledAp, Stats);
+
+  SimStopAps ();
+  SimFreeCpuMpData ();
+  return Status;
+}
+
+/**
+  Broadcast procedures with the APs woken up by the BSP and through a leader
+  per package, and report the dispatch times for each simulated platform.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SimDispatchLatency (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  SIM_TOPOLOGY        *Topology;
+  SIM_DISPATCH_STATS  Flat;
+  SIM_DISPATCH_STATS  Leaders;
+  UINTN               Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (mSimTopologies); Index++) {
+    Topology = &mSimTopologies[Index];
+    UT_ASSERT_EQUAL (SimRunPlatform (Topology, FALSE, FALSE, &Flat), UNIT_TEST_PASSED);
+    UT_ASSERT_EQUAL (SimRunPlatform (Topology, TRUE, FALSE, &Leaders), UNIT_TEST_PASSED);
+
+    UT_LOG_INFO (
+      "%d CPUs, %d packages: BSP wakeup: %d BSP wakeups, average %ld us, worst %ld us, done %ld us; "
+      "package leaders: %d BSP wakeups, average %ld us, worst %ld us, done %ld us\n",
+      Topology->CpuCount,
+      Topology->PackageCount,
+      Flat.BspWakeups,
+      Flat.AverageNs / 1000,
+      Flat.WorstNs / 1000,
+      Flat.CompletionNs / 1000,
+      Leaders.BspWakeups,
+      Leaders.AverageNs / 1000,
+      Leaders.WorstNs / 1000,
+      Leaders.CompletionNs / 1000
+      );
+
+    UT_ASSERT_EQUAL (Flat.BspWakeups, Topology->CpuCount - 1);
+    UT_ASSERT_TRUE (Leaders.BspWakeups <= Topology->PackageCount);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Broadcast procedures with a disabled AP, which is a package leader when the
+  APs are woken up through a leader per package: the BSP then wakes up the
+  other APs of the package itself.
+
+  @param[in]  Context  Unused.
+
+  @retval  UNIT_TEST_PASSED             The test passed.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SimDisabledLeader (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  SIM_DISPATCH_STATS  Stats;
+  UINTN               Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (mSimTopologies); Index++) {
+    if (mSimTopologies[Index].CpuCount < 3) {
+      continue;
+    }
+
+    UT_ASSERT_EQUAL (SimRunPlatform (&mSimTopologies[Index], FALSE, TRUE, &Stats), UNIT_TEST_PASSED);
+    UT_ASSERT_EQUAL (SimRunPlatform (&mSimTopologies[Index], TRUE, TRUE, &Stats), UNIT_TEST_PASSED);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the AP
+  wakeup and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      WakeupTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&WakeupTests, Framework, "AP Wakeup Tests", "MpInitLib.Wakeup", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for AP Wakeup Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (WakeupTests, "The APs are grouped by package", "PackageLeaders", SimPackageLeaders, NULL, NULL, NULL);
+  AddTestCase (WakeupTests, "CheckAllAPs only scans the APs when one has finished", "CheckAllAPs", SimCheckAllApsSkip, NULL, NULL, NULL);
+  AddTestCase (WakeupTests, "Dispatch latency of the BSP and package leader wakeups", "Dispatch", SimDispatchLatency, NULL, NULL, NULL);
+  AddTestCase (WakeupTests, "The BSP wakes up the package of a disabled leader", "DisabledLeader", SimDisabledLeader, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+///
+/// Avoid ECC error for function name that starts with lower case letter
+///
+#define MpInitLibUnitTestMain  main
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  @param[in] Argc  Number of arguments
+  @param[in] Argv  Array of pointers to arguments
+
+  @retval 0      Success
+  @retval other  Error
+**/
+INT32
+MpInitLibUnitTestMain (
+  IN INT32  Argc,
+  IN CHAR8  *Argv[]
+  )
+{
+  UnitTestingEntry ();
+  return 0;
+}
@@ -21,6 +21,7 @@ SMM_CPU_SEMAPHORES           mSmmCpuSemaphores;
 UINTN                        mSemaphoreSize;
 SPIN_LOCK                    *mPFLock = NULL;
 SMM_CPU_SYNC_MODE            mCpuSmmSyncMode;
+SMM_CPU_SYNC_ALGORITHM       mCpuSmmSyncAlgorithm;
 BOOLEAN                      mMachineCheckSupported = FALSE;
 MM_COMPLETION                mSmmStartupThisApToken;
 
@@ -134,11 +135,40 @@ WaitForAllAPs (
   IN      UINTN  NumberOfAPs
   )
 {
-  UINTN  BspIndex;
+  UINTN            BspIndex;
+  UINT32           Index;
+  volatile UINT32  *Sem;
+  UINT32           Value;
+  UINT32           Count;
 
   BspIndex = mSmmMpSyncData->BspIndex;
-  while (NumberOfAPs-- > 0) {
-    WaitForSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+  if (mCpuSmmSyncAlgorithm == SmmCpuSyncAlgorithmCentral) {
+    while (NumberOfAPs-- > 0) {
+      WaitForSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    }
+
+    return;
+  }
+
+  //
+  // The APs release the semaphore of their package. Collect the releases
+  // from the semaphores of all the packages.
+  //
+  while (NumberOfAPs > 0) {
+    for (Index = mSmmMpSyncData->FirstPackage; Index != MAX_UINT32; Index = mSmmMpSyncData->CpuData[Index].NextPackage) {
+      Sem   = mSmmMpSyncData->CpuData[Index].PackageRun;
+      Value = *Sem;
+      if (Value == 0) {
+        continue;
+      }
+
+      Count = (UINT32)MIN (Value, NumberOfAPs);
+      if (InterlockedCompareExchange32 ((UINT32 *)Sem, Value, Value - Count) == Value) {
+        NumberOfAPs -= Count;
+      }
+    }
+
+    CpuPause ();
   }
 }
 
@@ -146,6 +176,10 @@ WaitForAllAPs (
   Performs an atomic compare exchange operation to release semaphore
   for each AP.
 
+  When the APs synchronize through the per package semaphores, only the
+  first present AP of each package is released, and it releases the other
+  present APs of its package in WaitForBsp().
+
 **/
 VOID
 ReleaseAllAPs (
@@ -153,10 +187,72 @@ ReleaseAllAPs (
   )
 {
   UINTN  Index;
+  UINTN  ApIndex;
 
-  for (Index = 0; Index < mMaxNumberOfCpus; Index++) {
-    if (IsPresentAp (Index)) {
-      ReleaseSemaphore (mSmmMpSyncData->CpuData[Index].Run);
+  if (mCpuSmmSyncAlgorithm == SmmCpuSyncAlgorithmCentral) {
+    for (Index = 0; Index < mMaxNumberOfCpus; Index++) {
+      if (IsPresentAp (Index)) {
+        ReleaseSemaphore (mSmmMpSyncData->CpuData[Index].Run);
+      }
+    }
+
+    return;
+  }
+
+  for (Index = mSmmMpSyncData->FirstPackage; Index != MAX_UINT32; Index = mSmmMpSyncData->CpuData[Index].NextPackage) {
+    for (ApIndex = Index; ApIndex != MAX_UINT32; ApIndex = mSmmMpSyncData->CpuData[ApIndex].NextInPackage) {
+      if (IsPresentAp (ApIndex)) {
+        mSmmMpSyncData->CpuData[ApIndex].ReleasePackage = TRUE;
+        ReleaseSemaphore (mSmmMpSyncData->CpuData[ApIndex].Run);
+        break;
+      }
+    }
+  }
+}
+
+/**
+  Performs an atomic compare exchange operation to release the semaphore
+  of BSP for an AP.
+
+  @param   CpuIndex         AP processor Index.
+
+**/
+VOID
+ReleaseBsp (
+  IN      UINTN  CpuIndex
+  )
+{
+  if (mCpuSmmSyncAlgorithm == SmmCpuSyncAlgorithmCentral) {
+    ReleaseSemaphore (mSmmMpSyncData->CpuData[mSmmMpSyncData->BspIndex].Run);
+  } else {
+    ReleaseSemaphore (mSmmMpSyncData->CpuData[CpuIndex].PackageRun);
+  }
+}
+
+/**
+  Wait for the semaphore of an AP to be released by BSP.
+
+  If BSP released the AP on behalf of its package, the AP releases the other
+  present APs of its package.
+
+  @param   CpuIndex         AP processor Index.
+
+**/
+VOID
+WaitForBsp (
+  IN      UINTN  CpuIndex
+  )
+{
+  UINTN  Index;
+
+  WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+
+  if (mSmmMpSyncData->CpuData[CpuIndex].ReleasePackage) {
+    mSmmMpSyncData->CpuData[CpuIndex].ReleasePackage = FALSE;
+    for (Index = mSmmMpSyncData->CpuData[CpuIndex].NextInPackage; Index != MAX_UINT32; Index = mSmmMpSyncData->CpuData[Index].NextInPackage) {
+      if (IsPresentAp (Index)) {
+        ReleaseSemaphore (mSmmMpSyncData->CpuData[Index].Run);
+      }
     }
   }
 }
@@ -573,9 +669,13 @@ BSPHandler (
   UINTN          ApCount;
   BOOLEAN        ClearTopLevelSmiResult;
   UINTN          PresentCount;
+  UINT64         Timer;
 
   ASSERT (CpuIndex == mSmmMpSyncData->BspIndex);
   ApCount = 0;
+  Timer   = StartSyncTimer ();
+
+  mSmmMpSyncData->ArrivalLatency = 0;
 
   //
   // Flag BSP's presence
@@ -624,6 +724,7 @@ BSPHandler (
     // Wait for all APs to get ready for programming MTRRs
     //
     WaitForAllAPs (ApCount);
+    mSmmMpSyncData->ArrivalLatency = GetSyncTimerElapsed (Timer, StartSyncTimer ());
 
     if (SmmCpuFeaturesNeedConfigureMtrrs ()) {
       //
@@ -721,6 +822,7 @@ BSPHandler (
   //
   // Notify all APs to exit
   //
+  Timer                      = StartSyncTimer ();
   *mSmmMpSyncData->InsideSmm = FALSE;
   ReleaseAllAPs ();
 
@@ -773,6 +875,14 @@ BSPHandler (
   // WaitForAllAps does not depend on the Present flag.
   //
   WaitForAllAPs (ApCount);
+  mSmmMpSyncData->ExitLatency = GetSyncTimerElapsed (Timer, StartSyncTimer ());
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "SMI: %ld APs, arrival %ld ns, exit %ld ns\n",
+    (UINT64)ApCount,
+    GetTimeInNanoSecond (mSmmMpSyncData->ArrivalLatency),
+    GetTimeInNanoSecond (mSmmMpSyncData->ExitLatency)
+    ));
 
   //
   // Reset the tokens buffer.
@@ -887,14 +997,14 @@ APHandler (
     //
     // Notify BSP of arrival at this point
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    ReleaseBsp (CpuIndex);
   }
 
   if (SmmCpuFeaturesNeedConfigureMtrrs ()) {
     //
     // Wait for the signal from BSP to backup MTRRs
     //
-    WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+    WaitForBsp (CpuIndex);
 
     //
     // Backup OS MTRRs
@@ -904,12 +1014,12 @@ APHandler (
     //
     // Signal BSP the completion of this AP
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    ReleaseBsp (CpuIndex);
 
     //
     // Wait for BSP's signal to program MTRRs
     //
-    WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+    WaitForBsp (CpuIndex);
 
     //
     // Replace OS MTRRs with SMI MTRRs
@@ -919,14 +1029,14 @@ APHandler (
     //
     // Signal BSP the completion of this AP
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    ReleaseBsp (CpuIndex);
   }
 
   while (TRUE) {
     //
     // Wait for something to happen
     //
-    WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+    WaitForBsp (CpuIndex);
 
     //
     // Check if BSP wants to exit SMM
@@ -966,12 +1076,12 @@ APHandler (
     //
     // Notify BSP the readiness of this AP to program MTRRs
     //
-    ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+    ReleaseBsp (CpuIndex);
 
     //
     // Wait for the signal from BSP to program MTRRs
     //
-    WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+    WaitForBsp (CpuIndex);
 
     //
     // Restore OS MTRRs
@@ -983,12 +1093,12 @@ APHandler (
   //
   // Notify BSP the readiness of this AP to Reset states/semaphore for this processor
   //
-  ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+  ReleaseBsp (CpuIndex);
 
   //
   // Wait for the signal from BSP to Reset states/semaphore for this processor
   //
-  WaitForSemaphore (mSmmMpSyncData->CpuData[CpuIndex].Run);
+  WaitForBsp (CpuIndex);
 
   //
   // Reset states/semaphore for this processor
@@ -998,7 +1108,7 @@ APHandler (
   //
   // Notify BSP the readiness of this AP to exit SMM
   //
-  ReleaseSemaphore (mSmmMpSyncData->CpuData[BspIndex].Run);
+  ReleaseBsp (CpuIndex);
 }
 
 /**
@@ -2007,12 +2117,14 @@ InitializeSmmCpuSemaphores (
                  = (SPIN_LOCK *)SemaphoreAddr;
   SemaphoreAddr += SemaphoreSize;
 
-  SemaphoreAddr                          = (UINTN)SemaphoreBlock + GlobalSemaphoresSize;
-  mSmmCpuSemaphores.SemaphoreCpu.Busy    = (SPIN_LOCK *)SemaphoreAddr;
-  SemaphoreAddr                         += ProcessorCount * SemaphoreSize;
-  mSmmCpuSemaphores.SemaphoreCpu.Run     = (UINT32 *)SemaphoreAddr;
-  SemaphoreAddr                         += ProcessorCount * SemaphoreSize;
-  mSmmCpuSemaphores.SemaphoreCpu.Present = (BOOLEAN *)SemaphoreAddr;
+  SemaphoreAddr                             = (UINTN)SemaphoreBlock + GlobalSemaphoresSize;
+  mSmmCpuSemaphores.SemaphoreCpu.Busy       = (SPIN_LOCK *)SemaphoreAddr;
+  SemaphoreAddr                            += ProcessorCount * SemaphoreSize;
+  mSmmCpuSemaphores.SemaphoreCpu.Run        = (UINT32 *)SemaphoreAddr;
+  SemaphoreAddr                            += ProcessorCount * SemaphoreSize;
+  mSmmCpuSemaphores.SemaphoreCpu.Present    = (BOOLEAN *)SemaphoreAddr;
+  SemaphoreAddr                            += ProcessorCount * SemaphoreSize;
+  mSmmCpuSemaphores.SemaphoreCpu.PackageRun = (UINT32 *)SemaphoreAddr;
 
   mPFLock                       = mSmmCpuSemaphores.SemaphoreGlobal.PFLock;
   mConfigSmmCodeAccessCheckLock = mSmmCpuSemaphores.SemaphoreGlobal.CodeAccessCheckLock;
@@ -2020,6 +2132,66 @@ InitializeSmmCpuSemaphores (
   mSemaphoreSize = SemaphoreSize;
 }
 
+/**
+  Link the processors of each package for the per package semaphores.
+
+  The first processor of each package owns the semaphore of the package. The
+  PackageRun of every processor points to the semaphore of its package.
+
+**/
+VOID
+InitializePackageSyncData (
+  VOID
+  )
+{
+  UINT32              CpuIndex;
+  UINT32              Index;
+  UINT32              LastPackage;
+  SMM_CPU_DATA_BLOCK  *CpuData;
+
+  CpuData                      = mSmmMpSyncData->CpuData;
+  mSmmMpSyncData->FirstPackage = MAX_UINT32;
+  LastPackage                  = MAX_UINT32;
+  for (CpuIndex = 0; CpuIndex < mMaxNumberOfCpus; CpuIndex++) {
+    CpuData[CpuIndex].NextPackage    = MAX_UINT32;
+    CpuData[CpuIndex].NextInPackage  = MAX_UINT32;
+    CpuData[CpuIndex].ReleasePackage = FALSE;
+  }
+
+  if (mCpuSmmSyncAlgorithm != SmmCpuSyncAlgorithmPackage) {
+    return;
+  }
+
+  for (CpuIndex = 0; CpuIndex < mMaxNumberOfCpus; CpuIndex++) {
+    if (gSmmCpuPrivate->ProcessorInfo[CpuIndex].ProcessorId == INVALID_APIC_ID) {
+      continue;
+    }
+
+    for (Index = mSmmMpSyncData->FirstPackage; Index != MAX_UINT32; Index = CpuData[Index].NextPackage) {
+      if (gSmmCpuPrivate->ProcessorInfo[Index].Location.Package == gSmmCpuPrivate->ProcessorInfo[CpuIndex].Location.Package) {
+        break;
+      }
+    }
+
+    if (Index == MAX_UINT32) {
+      //
+      // The first processor of a new package.
+      //
+      if (LastPackage == MAX_UINT32) {
+        mSmmMpSyncData->FirstPackage = CpuIndex;
+      } else {
+        CpuData[LastPackage].NextPackage = CpuIndex;
+      }
+
+      LastPackage = CpuIndex;
+    } else {
+      CpuData[CpuIndex].PackageRun    = CpuData[Index].PackageRun;
+      CpuData[CpuIndex].NextInPackage = CpuData[Index].NextInPackage;
+      CpuData[Index].NextInPackage    = CpuIndex;
+    }
+  }
+}
+
 /**
   Initialize un-cacheable data.
 
@@ -2069,10 +2241,15 @@ InitializeMpSyncData (
         (UINT32 *)((UINTN)mSmmCpuSemaphores.SemaphoreCpu.Run + mSemaphoreSize * CpuIndex);
       mSmmMpSyncData->CpuData[CpuIndex].Present =
         (BOOLEAN *)((UINTN)mSmmCpuSemaphores.SemaphoreCpu.Present + mSemaphoreSize * CpuIndex);
-      *(mSmmMpSyncData->CpuData[CpuIndex].Busy)    = 0;
-      *(mSmmMpSyncData->CpuData[CpuIndex].Run)     = 0;
-      *(mSmmMpSyncData->CpuData[CpuIndex].Present) = FALSE;
+      mSmmMpSyncData->CpuData[CpuIndex].PackageRun =
+        (UINT32 *)((UINTN)mSmmCpuSemaphores.SemaphoreCpu.PackageRun + mSemaphoreSize * CpuIndex);
+      *(mSmmMpSyncData->CpuData[CpuIndex].Busy)       = 0;
+      *(mSmmMpSyncData->CpuData[CpuIndex].Run)        = 0;
+      *(mSmmMpSyncData->CpuData[CpuIndex].Present)    = FALSE;
+      *(mSmmMpSyncData->CpuData[CpuIndex].PackageRun) = 0;
     }
+
+    InitializePackageSyncData ();
   }
 }
 
@@ -2118,6 +2295,16 @@ InitializeMpServiceData (
   mSmmMpSyncData = (SMM_DISPATCHER_MP_SYNC_DATA *)AllocatePages (EFI_SIZE_TO_PAGES (mSmmMpSyncDataSize));
   ASSERT (mSmmMpSyncData != NULL);
   mCpuSmmSyncMode = (SMM_CPU_SYNC_MODE)PcdGet8 (PcdCpuSmmSyncMode);
+
+  //
+  // The packages are linked once, so the per package semaphores are not
+  // used when processors may be hot added or removed.
+  //
+  mCpuSmmSyncAlgorithm = (SMM_CPU_SYNC_ALGORITHM)PcdGet8 (PcdCpuSmmSyncAlgorithm);
+  if ((mCpuSmmSyncAlgorithm != SmmCpuSyncAlgorithmPackage) || FeaturePcdGet (PcdCpuHotPlugSupport)) {
+    mCpuSmmSyncAlgorithm = SmmCpuSyncAlgorithmCentral;
+  }
+
   InitializeMpSyncData ();
 
   //
@@ -456,6 +456,17 @@ typedef struct {
   volatile BOOLEAN              *Present;
   PROCEDURE_TOKEN               *Token;
   EFI_STATUS                    *Status;
+  //
+  // Used when the APs synchronize with the BSP through the per package
+  // semaphores. PackageRun points to the semaphore of the package, which
+  // is owned by its first processor. The first processors of the packages
+  // are linked by NextPackage, and the processors of a package by
+  // NextInPackage.
+  //
+  volatile UINT32               *PackageRun;
+  UINT32                        NextPackage;
+  UINT32                        NextInPackage;
+  volatile BOOLEAN              ReleasePackage;
 } SMM_CPU_DATA_BLOCK;
 
 typedef enum {
@@ -464,6 +475,12 @@ typedef enum {
   SmmCpuSyncModeMax
 } SMM_CPU_SYNC_MODE;
 
+typedef enum {
+  SmmCpuSyncAlgorithmCentral,
+  SmmCpuSyncAlgorithmPackage,
+  SmmCpuSyncAlgorithmMax
+} SMM_CPU_SYNC_ALGORITHM;
+
 typedef struct {
   //
   // Pointer to an array. The array should be located immediately after this structure
@@ -480,6 +497,15 @@ typedef struct {
   volatile BOOLEAN              AllApArrivedWithException;
   EFI_AP_PROCEDURE              StartupProcedure;
   VOID                          *StartupProcArgs;
+  UINT32                        FirstPackage;
+  //
+  // Latency of the last SMI, in ticks of the performance counter: from the
+  // entry of the BSP until all the APs have checked in, and from the release
+  // of the APs until all of them are ready to exit SMM. ArrivalLatency is 0
+  // when the APs are not gathered before the SMI handlers run.
+  //
+  UINT64                        ArrivalLatency;
+  UINT64                        ExitLatency;
 } SMM_DISPATCHER_MP_SYNC_DATA;
 
 #define SMM_PSD_OFFSET  0xfb00
@@ -503,6 +529,7 @@ typedef struct {
   volatile UINT32     *Run;
   volatile BOOLEAN    *Present;
   SPIN_LOCK           *Token;
+  volatile UINT32     *PackageRun;
 } SMM_CPU_SEMAPHORE_CPU;
 
 ///
@@ -596,6 +623,21 @@ IsSyncTimerTimeout (
   IN      UINT64  Timer
   );
 
+/**
+  Get the number of ticks of the SMM AP Sync timer between two of its values.
+
+  @param Start  The value of the timer at the beginning.
+  @param End    The value of the timer at the end.
+
+  @return The number of ticks elapsed from Start to End.
+
+**/
+UINT64
+GetSyncTimerElapsed (
+  IN      UINT64  Start,
+  IN      UINT64  End
+  );
+
 /**
   Initialize IDT for SMM Stack Guard.
 
@@ -59,23 +59,22 @@ StartSyncTimer (
 }
 
 /**
-  Check if the SMM AP Sync timer is timeout.
+  Get the number of ticks of the SMM AP Sync timer between two of its values.
 
-  @param Timer  The start timer from the begin.
+  @param Start  The value of the timer at the beginning.
+  @param End    The value of the timer at the end.
+
+  @return The number of ticks elapsed from Start to End.
 
 **/
-BOOLEAN
-EFIAPI
-IsSyncTimerTimeout (
-  IN      UINT64  Timer
+UINT64
+GetSyncTimerElapsed (
+  IN      UINT64  Start,
+  IN      UINT64  End
   )
 {
-  UINT64  CurrentTimer;
-  UINT64  Delta;
-
-  CurrentTimer = GetPerformanceCounter ();
   //
-  // We need to consider the case that CurrentTimer is equal to Timer
+  // We need to consider the case that End is equal to Start
   // when some timer runs too slow and CPU runs fast. We think roll over
   // condition does not happen on this case.
   //
@@ -83,27 +82,40 @@ IsSyncTimerTimeout (
     //
     // The performance counter counts down.  Check for roll over condition.
     //
-    if (CurrentTimer <= Timer) {
-      Delta = Timer - CurrentTimer;
-    } else {
-      //
-      // Handle one roll-over.
-      //
-      Delta = mCycle - (CurrentTimer - Timer) + 1;
+    if (End <= Start) {
+      return Start - End;
     }
-  } else {
+
     //
-    // The performance counter counts up.  Check for roll over condition.
+    // Handle one roll-over.
     //
-    if (CurrentTimer >= Timer) {
-      Delta = CurrentTimer - Timer;
-    } else {
-      //
-      // Handle one roll-over.
-      //
-      Delta = mCycle - (Timer - CurrentTimer) + 1;
-    }
+    return mCycle - (End - Start) + 1;
+  }
+
+  //
+  // The performance counter counts up.  Check for roll over condition.
+  //
+  if (End >= Start) {
+    return End - Start;
   }
 
-  return (BOOLEAN)(Delta >= mTimeoutTicker);
+  //
+  // Handle one roll-over.
+  //
+  return mCycle - (Start - End) + 1;
+}
+
+/**
+  Check if the SMM AP Sync timer is timeout.
+
+  @param Timer  The start timer from the begin.
+
+**/
+BOOLEAN
+EFIAPI
+IsSyncTimerTimeout (
+  IN      UINT64  Timer
+  )
+{
+  return (BOOLEAN)(GetSyncTimerElapsed (Timer, GetPerformanceCounter ()) >= mTimeoutTicker);
 }